@@ -35,6 +35,8 @@
 #include "aistatemachine.h"
 #include "aicondition.h"
 #include "lltimer.h"
+#include "llformat.h"
+#include <algorithm>
 
 //==================================================================
 // Overview
@@ -282,11 +284,84 @@ char const* HelloWorld::state_str_impl(state_type run_state) const
 // is ok, rather marks the need to continue running which should be picked up upon return from
 // whatever the running thread is calling.
 
+AIEngine::AIEngine(char const* name) : mName(name)
+{
+  // Engines are global objects, so this is done before any other thread exists.
+  engines().push_back(this);
+}
+
+AIEngine::~AIEngine()
+{
+  std::vector<AIEngine*>& list(engines());
+  list.erase(std::remove(list.begin(), list.end(), this), list.end());
+}
+
+//static
+std::vector<AIEngine*>& AIEngine::engines(void)
+{
+  static std::vector<AIEngine*> sEngines;
+  return sEngines;
+}
+
+void AIEngine::stats_type::ran(U64 add_time, U64 now)
+{
+  ++runs;
+  if (add_time)		// Only the first run after add() counts towards the latency.
+  {
+	U64 latency = now > add_time ? now - add_time : 0;
+	++latency_count;
+	latency_total += latency;
+	if (latency > latency_max)
+	{
+	  latency_max = latency;
+	}
+  }
+}
+
+//static
+void AIEngine::dump_stats(std::ostringstream& msg)
+{
+  std::vector<AIEngine*>& list(engines());
+  for (std::vector<AIEngine*>::iterator iter = list.begin(); iter != list.end(); ++iter)
+  {
+	(*iter)->dump_stats_impl(msg);
+  }
+}
+
+void AIEngine::dump_stats_impl(std::ostringstream& msg)
+{
+  size_t depth;
+  stats_type stats;
+  {
+	engine_state_type_wat engine_state_w(mEngineState);
+	depth = engine_state_w->list.size();
+	stats = engine_state_w->stats;
+	engine_state_w->stats = stats_type();
+	engine_state_w->stats.max_depth = depth;
+  }
+  print_stats(msg, depth, stats);
+}
+
+void AIEngine::print_stats(std::ostringstream& msg, size_t depth, stats_type const& stats) const
+{
+  F64 const tfactor = 1000 / calc_clock_frequency();
+  msg << mName << ": " << depth << " queued (max " << stats.max_depth << "), " << stats.runs << " runs";
+  if (stats.latency_count)
+  {
+	msg << ", latency " << (stats.latency_total * tfactor / stats.latency_count) << " ms average, " << (stats.latency_max * tfactor) << " ms max";
+  }
+  msg << ".\n";
+}
+
 void AIEngine::add(AIStateMachine* state_machine)
 {
   Dout(dc::statemachine(state_machine->mSMDebug), "Adding state machine [" << (void*)state_machine << "] to " << mName);
   engine_state_type_wat engine_state_w(mEngineState);
   engine_state_w->list.push_back(QueueElement(state_machine));
+  if (engine_state_w->list.size() > engine_state_w->stats.max_depth)
+  {
+	engine_state_w->stats.max_depth = engine_state_w->list.size();
+  }
   if (engine_state_w->waiting)
   {
 	engine_state_w.signal();
@@ -319,6 +394,7 @@ void print_statemachine_diagnostics(U64 total_clocks, AIStateMachine::StateTimer
 	msg << ".\n";
 
 	AIStateMachine::StateTimerBase::DumpTimers(msg);
+	AIEngine::dump_stats(msg);
 
 	LL_WARNS() << msg.str() << LL_ENDL;
 }
@@ -335,6 +411,7 @@ void AIEngine::mainloop(void)
   }
   U64 total_clocks = 0;
 #if STATE_MACHINE_PROFILING
+  bool over_budget = false;
   queued_type::value_type slowest_element(NULL);
   AIStateMachine::StateTimerRoot::TimeData slowest_timer;
 #endif
@@ -342,7 +419,9 @@ void AIEngine::mainloop(void)
   {
 	AIStateMachine& state_machine(queued_element->statemachine());
 	AIStateMachine::StateTimerBase::TimeData time_data;
-	if (!state_machine.sleep(get_clock_count()))
+	U64 const start = get_clock_count();
+	bool const ran = !state_machine.sleep(start);
+	if (ran)
 	{
 		AIStateMachine::StateTimerRoot timer(state_machine.getName());
 		state_machine.multiplex(AIStateMachine::normal_run);
@@ -363,6 +442,10 @@ void AIEngine::mainloop(void)
 
 	bool active = state_machine.active(this);		// This locks mState shortly, so it must be called before locking mEngineState because add() locks mEngineState while holding mState.
 	engine_state_type_wat engine_state_w(mEngineState);
+	if (ran)
+	{
+	  engine_state_w->stats.ran(queued_element->take_add_time(), start);
+	}
 	if (!active)
 	{
 	  Dout(dc::statemachine(state_machine.mSMDebug), "Erasing state machine [" << (void*)&state_machine << "] from " << mName);
@@ -374,14 +457,21 @@ void AIEngine::mainloop(void)
 	}
 	if (total_clocks >= sMaxCount)
 	{
-#if STATE_MACHINE_PROFILING
-		print_statemachine_diagnostics(total_clocks, slowest_timer, slowest_element);
-#endif
 	  Dout(dc::statemachine, "Sorting " << engine_state_w->list.size() << " state machines.");
 	  engine_state_w->list.sort(QueueElementComp());
+#if STATE_MACHINE_PROFILING
+	  over_budget = true;
+#endif
 	  break;
 	}
   }
+#if STATE_MACHINE_PROFILING
+  // Called without mEngineState locked, because this collects the statistics of all engines.
+  if (over_budget)
+  {
+	print_statemachine_diagnostics(total_clocks, slowest_timer, slowest_element);
+  }
+#endif
 }
 
 void AIEngine::flush(void)
@@ -1386,9 +1476,11 @@ void AIEngine::threadloop(void)
   do
   {
 	AIStateMachine& state_machine(queued_element->statemachine());
+	U64 const start = get_clock_count();
 	state_machine.multiplex(AIStateMachine::normal_run);
 	bool active = state_machine.active(this);		// This locks mState shortly, so it must be called before locking mEngineState because add() locks mEngineState while holding mState.
 	engine_state_type_wat engine_state_w(mEngineState);
+	engine_state_w->stats.ran(queued_element->take_add_time(), start);
 	if (!active)
 	{
 	  Dout(dc::statemachine(state_machine.mSMDebug), "Erasing state machine [" << (void*)&state_machine << "] from " << mName);
@@ -1466,3 +1558,318 @@ void stopEngineThread(void)
   LL_INFOS() << "State machine thread" << (!AIEngineThread::sInstance->isStopped() ? " not" : "") << " stopped after " << ((400 - count) * 10) << "ms." << LL_ENDL;
 }
 
+
+//-----------------------------------------------------------------------------
+// AIThreadPoolEngine
+
+class AIThreadPoolEngine::Worker : public LLThread
+{
+  public:
+	Worker(AIThreadPoolEngine& engine, S32 index);
+
+	AIThreadSafeSimpleDC<worker_queue_type> mQueue;
+	S32 const mIndex;
+	bool mServeSerial;					// Only used by the first worker: take from mSerialQueue first on the next pop().
+
+  protected:
+	/*virtual*/ void run(void);
+
+  private:
+	AIThreadPoolEngine& mEngine;
+};
+
+AIThreadPoolEngine::Worker::Worker(AIThreadPoolEngine& engine, S32 index) :
+	LLThread(llformat("%s #%d", engine.name(), index)), mIndex(index), mServeSerial(true), mEngine(engine)
+{
+}
+
+void AIThreadPoolEngine::Worker::run(void)
+{
+  QueueElement element(NULL);
+  while (!isQuitting())
+  {
+	if (mEngine.pop(this, element))
+	{
+	  mEngine.run(this, element);
+	  element = QueueElement(NULL);		// Don't keep the last state machine alive while sleeping.
+	}
+	else
+	{
+	  mEngine.sleep(this);
+	}
+  }
+}
+
+AIThreadPoolEngine gStateMachineThreadPool("gStateMachineThreadPool");
+
+AIThreadPoolEngine::AIThreadPoolEngine(char const* name) :
+	AIEngine(name), mNextWorker(0), mPending(0), mSerialPending(0), mSleeping(0), mStartedWorkers(0), mStopping(false)
+{
+}
+
+void AIThreadPoolEngine::add(AIStateMachine* state_machine)
+{
+  Dout(dc::statemachine(state_machine->mSMDebug), "Adding state machine [" << (void*)state_machine << "] to " << name());
+  // Until start() is called everything goes to the serial queue.
+  Worker* worker = NULL;
+  if (!mWorkers.empty() && state_machine->thread_safe())
+  {
+	worker = mWorkers[mNextWorker++ % mWorkers.size()];
+  }
+  push(QueueElement(state_machine), worker);
+  if (!mWorkers.empty())
+  {
+	start_workers(worker ? (S32)mWorkers.size() : 1);
+  }
+  S32 depth = mPending + mSerialPending;
+  AIAccess<stats_type> stats_w(mStats);
+  if ((size_t)depth > stats_w->max_depth)
+  {
+	stats_w->max_depth = depth;
+  }
+}
+
+// Add element to the queue of worker, or to mSerialQueue if worker is NULL, and wake up a sleeping worker.
+void AIThreadPoolEngine::push(QueueElement const& element, Worker* worker)
+{
+  // Count first, so that the count is never less than the number of queued elements.
+  if (worker)
+  {
+	mPending++;
+	worker_queue_wat(worker->mQueue)->push_back(element);
+  }
+  else
+  {
+	mSerialPending++;
+	worker_queue_wat(mSerialQueue)->push_back(element);
+  }
+  // Either we see the increment of mSleeping here, or a worker that is about to sleep sees our increment of the pending count.
+  if (mSleeping)
+  {
+	mSleepCondition.lock();
+	if (worker)
+	{
+	  mSleepCondition.signal();
+	}
+	else
+	{
+	  mSleepCondition.broadcast();		// Only the first worker can run this one.
+	}
+	mSleepCondition.unlock();
+  }
+}
+
+bool AIThreadPoolEngine::pop_serial(QueueElement& element)
+{
+  worker_queue_wat serial_queue_w(mSerialQueue);
+  if (serial_queue_w->empty())
+  {
+	return false;
+  }
+  element = serial_queue_w->front();
+  serial_queue_w->pop_front();
+  --mSerialPending;
+  return true;
+}
+
+bool AIThreadPoolEngine::pop(Worker* worker, QueueElement& element)
+{
+  // The first worker alternates between the serial queue and the worker queues while both have work,
+  // so that neither starves the other when it is the only worker.
+  if (worker->mIndex == 0)
+  {
+	if (worker->mServeSerial && pop_serial(element))
+	{
+	  worker->mServeSerial = false;
+	  return true;
+	}
+	worker->mServeSerial = true;
+  }
+  if (pop_parallel(worker, element))
+  {
+	return true;
+  }
+  return worker->mIndex == 0 && pop_serial(element);
+}
+
+bool AIThreadPoolEngine::pop_parallel(Worker* worker, QueueElement& element)
+{
+  S32 const num_workers = mWorkers.size();
+  for (S32 i = 0; i < num_workers; ++i)
+  {
+	Worker* victim = mWorkers[(worker->mIndex + i) % num_workers];
+	worker_queue_wat queue_w(victim->mQueue);
+	if (!queue_w->empty())
+	{
+	  if (victim == worker)
+	  {
+		element = queue_w->front();
+		queue_w->pop_front();
+	  }
+	  else
+	  {
+		// Steal from the other end, that is what the owner will run last.
+		element = queue_w->back();
+		queue_w->pop_back();
+	  }
+	  --mPending;
+	  return true;
+	}
+  }
+  return false;
+}
+
+void AIThreadPoolEngine::run(Worker* worker, QueueElement& element)
+{
+  AIStateMachine& state_machine(element.statemachine());
+  U64 const start = get_clock_count();
+  state_machine.multiplex(AIStateMachine::normal_run);
+  bool active = state_machine.active(this);
+  AIAccess<stats_type>(mStats)->ran(element.take_add_time(), start);
+  if (!active)
+  {
+	Dout(dc::statemachine(state_machine.mSMDebug), "Erasing state machine [" << (void*)&state_machine << "] from " << name());
+	return;
+  }
+  // Still running in this engine: queue it again, after everything that this worker already had queued.
+  push(element, state_machine.thread_safe() ? worker : NULL);
+}
+
+void AIThreadPoolEngine::sleep(Worker* worker)
+{
+  mSleepCondition.lock();
+  mSleeping++;
+  while (!worker->isQuitting() && !mPending && !(worker->mIndex == 0 && mSerialPending))
+  {
+	mSleepCondition.wait();
+  }
+  --mSleeping;
+  mSleepCondition.unlock();
+}
+
+// MAIN-THREAD
+void AIThreadPoolEngine::start(S32 num_threads)
+{
+  llassert(AIThreadID::in_main_thread() && mWorkers.empty());
+  num_threads = llmax(num_threads, 1);
+  bool any_thread_safe = false;
+  // All workers must exist before the first one starts, because they steal from each other.
+  for (S32 i = 0; i < num_threads; ++i)
+  {
+	mWorkers.push_back(new Worker(*this, i));
+  }
+  // Move thread-safe state machines that were added before we had workers to their own queue.
+  {
+	worker_queue_type queued;
+	{
+	  worker_queue_wat serial_queue_w(mSerialQueue);
+	  queued.swap(*serial_queue_w);
+	  mSerialPending = 0;
+	}
+	for (worker_queue_type::iterator iter = queued.begin(); iter != queued.end(); ++iter)
+	{
+	  bool thread_safe = iter->statemachine().thread_safe();
+	  any_thread_safe = any_thread_safe || thread_safe;
+	  push(*iter, thread_safe ? mWorkers[mNextWorker++ % num_threads] : NULL);
+	}
+	if (!queued.empty())
+	{
+	  start_workers(any_thread_safe ? num_threads : 1);
+	}
+  }
+  LL_INFOS() << "Created " << num_threads << " threads for " << name() << ", they start when there is work for them." << LL_ENDL;
+}
+
+// Threads are started when the first state machine that can use them is added:
+// the first worker for any state machine, the others for thread-safe ones.
+void AIThreadPoolEngine::start_workers(S32 count)
+{
+  if (mStartedWorkers >= count)
+  {
+	return;
+  }
+  LLMutexLock lock(&mStartMutex);
+  if (mStopping)
+  {
+	return;
+  }
+  for (S32 i = mStartedWorkers; i < count; ++i)
+  {
+	mWorkers[i]->start();
+  }
+  mStartedWorkers = llmax((S32)mStartedWorkers, count);
+}
+
+// MAIN-THREAD
+void AIThreadPoolEngine::stop(void)
+{
+  llassert(AIThreadID::in_main_thread());
+  if (mWorkers.empty())
+  {
+	return;
+  }
+  {
+	// No more threads are started after this.
+	LLMutexLock lock(&mStartMutex);
+	mStopping = true;
+  }
+  for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+  {
+	(*iter)->setQuitting();
+  }
+  mSleepCondition.lock();
+  mSleepCondition.broadcast();
+  mSleepCondition.unlock();
+  int count = 401;
+  bool stopped = false;
+  while (--count && !stopped)
+  {
+	stopped = true;
+	for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+	{
+	  stopped = stopped && (*iter)->isStopped();
+	}
+	if (!stopped)
+	{
+	  ms_sleep(10);
+	}
+  }
+  // The workers are not deleted: they would be waited for once more, and pop() might still be using mWorkers.
+  LL_INFOS() << name() << (stopped ? "" : " not") << " stopped after " << ((400 - count) * 10) << "ms." << LL_ENDL;
+}
+
+void AIThreadPoolEngine::flush(void)
+{
+  DoutEntering(dc::statemachine, "AIThreadPoolEngine::flush [" << name() << "]");
+  std::vector<AIThreadSafeSimpleDC<worker_queue_type>*> queues;
+  queues.push_back(&mSerialQueue);
+  for (std::vector<Worker*>::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+  {
+	queues.push_back(&(*iter)->mQueue);
+  }
+  for (std::vector<AIThreadSafeSimpleDC<worker_queue_type>*>::iterator queue = queues.begin(); queue != queues.end(); ++queue)
+  {
+	worker_queue_wat queue_w(**queue);
+	for (worker_queue_type::iterator iter = queue_w->begin(); iter != queue_w->end(); ++iter)
+	{
+	  // To avoid an assertion in ~AIStateMachine.
+	  iter->statemachine().force_killed();
+	}
+	queue_w->clear();
+  }
+  mPending = 0;
+  mSerialPending = 0;
+}
+
+void AIThreadPoolEngine::dump_stats_impl(std::ostringstream& msg)
+{
+  size_t depth = mPending + mSerialPending;
+  stats_type stats;
+  {
+	AIAccess<stats_type> stats_w(mStats);
+	stats = *stats_w;
+	*stats_w = stats_type();
+	stats_w->max_depth = depth;
+  }
+  print_stats(msg, depth, stats);
+}
@@ -37,7 +37,10 @@
 #include "aithreadsafe.h"
 #include <llpointer.h>
 #include "lltimer.h"
+#include "llatomic.h"
+#include <deque>
 #include <list>
+#include <vector>
 #include <boost/signals2.hpp>
 
 class AIConditionBase;
@@ -45,30 +48,44 @@ class AIStateMachine;
 
 class AIEngine
 {
-  private:
+  protected:
 	struct QueueElementComp;
 	class QueueElement {
 	  private:
 		LLPointer<AIStateMachine> mStateMachine;
+		U64 mAddTime;							// When it was added to the engine; zero once it ran.
 
 	  public:
-		QueueElement(AIStateMachine* statemachine) : mStateMachine(statemachine) { }
+		QueueElement(AIStateMachine* statemachine) : mStateMachine(statemachine), mAddTime(get_clock_count()) { }
 		friend bool operator==(QueueElement const& e1, QueueElement const& e2) { return e1.mStateMachine == e2.mStateMachine; }
 		friend bool operator!=(QueueElement const& e1, QueueElement const& e2) { return e1.mStateMachine != e2.mStateMachine; }
 		friend struct QueueElementComp;
 
 		AIStateMachine const& statemachine(void) const { return *mStateMachine; }
 		AIStateMachine& statemachine(void) { return *mStateMachine; }
+		U64 take_add_time(void) { U64 add_time = mAddTime; mAddTime = 0; return add_time; }
 	};
 	struct QueueElementComp {
 	  inline bool operator()(QueueElement const& e1, QueueElement const& e2) const;
 	};
 
   public:
+	// Queue depth and latency (from add() until the first run) since the last dump.
+	struct stats_type {
+	  size_t max_depth;
+	  U32 runs;
+	  U32 latency_count;
+	  U64 latency_total;
+	  U64 latency_max;
+	  stats_type(void) : max_depth(0), runs(0), latency_count(0), latency_total(0), latency_max(0) { }
+	  void ran(U64 add_time, U64 now);
+	};
+
 	typedef std::list<QueueElement> queued_type;
 	struct engine_state_type {
 	  queued_type list;
 	  bool waiting;
+	  stats_type stats;
 	  engine_state_type(void) : waiting(false) { }
 	};
 
@@ -82,22 +99,89 @@ class AIEngine
 	static U64 sMaxCount;
 
   public:
-	AIEngine(char const* name) : mName(name) { }
+	AIEngine(char const* name);
+	virtual ~AIEngine();
 
-	void add(AIStateMachine* state_machine);
+	virtual void add(AIStateMachine* state_machine);
 
 	void mainloop(void);
 	void threadloop(void);
 	void wake_up(void);
-	void flush(void);
+	virtual void flush(void);
 
 	char const* name(void) const { return mName; }
 
 	static void setMaxCount(F32 StateMachineMaxTime);
+
+	// Append queue depth and latency of every engine to msg, and start counting anew.
+	static void dump_stats(std::ostringstream& msg);
+
+  protected:
+	virtual void dump_stats_impl(std::ostringstream& msg);
+	void print_stats(std::ostringstream& msg, size_t depth, stats_type const& stats) const;
+
+  private:
+	static std::vector<AIEngine*>& engines(void);
+};
+
+// An engine that runs its state machines on a pool of worker threads.
+//
+// Every worker has its own queue: it runs state machines from the front of
+// it and puts those that stay active back at the end. A worker that runs out
+// of work steals from the back of the queue of another worker before going to
+// sleep. State machines whose thread_safe() returns true can therefore run
+// concurrently with each other; all others are only run by the first worker
+// from a queue that is never stolen from, so that those never run concurrently
+// with each other, like on gStateMachineThreadEngine. The first worker
+// alternates between the two kinds while both have work. Worker threads
+// are only started once there is work for them.
+class AIThreadPoolEngine : public AIEngine
+{
+  public:
+	AIThreadPoolEngine(char const* name);
+
+	/*virtual*/ void add(AIStateMachine* state_machine);
+	/*virtual*/ void flush(void);
+
+	// MAIN-THREAD
+	void start(S32 num_threads);
+	void stop(void);
+
+	S32 num_threads(void) const { return (S32)mWorkers.size(); }
+
+  protected:
+	/*virtual*/ void dump_stats_impl(std::ostringstream& msg);
+
+  private:
+	class Worker;
+	friend class Worker;
+	typedef std::deque<QueueElement> worker_queue_type;
+	typedef AIAccess<worker_queue_type> worker_queue_wat;
+
+	void push(QueueElement const& element, Worker* worker);
+	bool pop(Worker* worker, QueueElement& element);
+	bool pop_serial(QueueElement& element);
+	bool pop_parallel(Worker* worker, QueueElement& element);
+	void start_workers(S32 count);
+	void run(Worker* worker, QueueElement& element);
+	void sleep(Worker* worker);
+
+	std::vector<Worker*> mWorkers;
+	AIThreadSafeSimpleDC<worker_queue_type> mSerialQueue;		// State machines that are not thread_safe(); only run by mWorkers[0].
+	LLAtomicU32 mNextWorker;									// Round robin distribution of add().
+	LLAtomicS32 mPending;										// Number of state machines in the worker queues (an upper bound).
+	LLAtomicS32 mSerialPending;									// Number of state machines in mSerialQueue (an upper bound).
+	LLAtomicS32 mSleeping;										// Number of workers waiting for mSleepCondition.
+	LLCondition mSleepCondition;
+	LLAtomicS32 mStartedWorkers;								// Number of mWorkers that were started.
+	LLMutex mStartMutex;										// Protects starting workers, and mStopping.
+	bool mStopping;
+	AIThreadSafeSimpleDC<stats_type> mStats;
 };
 
 extern AIEngine gMainThreadEngine;
 extern AIEngine gStateMachineThreadEngine;
+extern AIThreadPoolEngine gStateMachineThreadPool;
 
 #ifndef STATE_MACHINE_PROFILING
 #ifndef LL_RELEASE_FOR_DOWNLOAD
@@ -438,6 +522,11 @@ public:
 	// For diagnostics. Every derived class must override this.
 	virtual const char* getName() const = 0;
 
+	// Return true if multiplex_impl() and the other *_impl() functions only touch data that is
+	// owned by this state machine or that is otherwise thread-safe, so that AIThreadPoolEngine
+	// may run it concurrently with other state machines.
+	virtual bool thread_safe(void) const { return false; }
+
   protected:
 	virtual void initialize_impl(void) = 0;
 	virtual void multiplex_impl(state_type run_state) = 0;
@@ -463,6 +552,7 @@ public:
 	}
 
 	friend class AIEngine;						// Calls multiplex() and force_killed().
+	friend class AIThreadPoolEngine;			// Idem.
 };
 
 bool AIEngine::QueueElementComp::operator()(QueueElement const& e1, QueueElement const& e2) const
@@ -59,6 +59,37 @@ MACRO(ADD_VIEWER_BUILD_TEST name parent)
 ENDMACRO(ADD_VIEWER_BUILD_TEST name parent)
 
 
+MACRO(ADD_BUILD_BENCHMARK name)
+    # optional extra parameter: list of additional source files
+    SET(more_source_files "${ARGN}")
+
+    # Like ADD_BUILD_TEST, but from tests/${name}_benchmark.cpp, and the
+    # resulting ${name}_benchmark is only built: run it by hand to get numbers.
+    IF (EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/tests/${name}_benchmark.cpp")
+        INCLUDE_DIRECTORIES("${LIBS_OPEN_DIR}/test")
+        ADD_EXECUTABLE(${name}_benchmark
+            ${name}.cpp
+            tests/${name}_benchmark.cpp
+            ${CMAKE_SOURCE_DIR}/test/test.cpp
+            ${CMAKE_SOURCE_DIR}/test/lltut.cpp
+            ${more_source_files}
+            )
+        TARGET_LINK_LIBRARIES(${name}_benchmark
+            ${LLCOMMON_LIBRARIES}
+            ${APRUTIL_LIBRARIES}
+            ${APR_LIBRARIES}
+            ${PTHREAD_LIBRARY}
+            ${WINDOWS_LIBRARIES}
+            )
+    ENDIF (EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/tests/${name}_benchmark.cpp")
+ENDMACRO(ADD_BUILD_BENCHMARK name)
+
+
+MACRO(ADD_VIEWER_BUILD_BENCHMARK name)
+    ADD_BUILD_BENCHMARK("${name}" llviewerprecompiledheaders.cpp ${ARGN})
+ENDMACRO(ADD_VIEWER_BUILD_BENCHMARK name)
+
+
 MACRO(ADD_SIMULATOR_BUILD_TEST name parent)
     ADD_BUILD_TEST("${name}" "${parent}" llsimprecompiledheaders.cpp)
 
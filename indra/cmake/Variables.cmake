@@ -25,6 +25,7 @@ set(SCRIPTS_PREFIX ../scripts)
 set(VIEWER_PREFIX)
 set(INTEGRATION_TESTS_PREFIX)
 set(LL_TESTS OFF CACHE BOOL "Build and run unit and integration tests (disable for build timing runs to reduce variation)")
+set(LL_BENCHMARKS OFF CACHE BOOL "Build the benchmark executables; they are run by hand, never as part of the build")
 
 # Compiler and toolchain options
 set(DISABLE_TCMALLOC OFF CACHE BOOL "Disable linkage of TCMalloc. (64bit builds automatically disable TCMalloc)")
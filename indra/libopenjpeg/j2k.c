@@ -1845,6 +1845,7 @@ void j2k_setup_decoder(opj_j2k_t *j2k, opj_dparameters_t *parameters) {
 		cp->reduce = parameters->cp_reduce;	
 		cp->layer = parameters->cp_layer;
 		cp->limit_decoding = parameters->cp_limit_decoding;
+		cp->resume = parameters->resume;
 
 #ifdef USE_JPWL
 		cp->correct = parameters->jpwl_correct;
@@ -1876,7 +1877,15 @@ opj_image_t* j2k_decode(opj_j2k_t *j2k, opj_cio_t *cio, opj_codestream_info_t *c
 
 	for (;;) {
 		opj_dec_mstabent_t *e;
-		int id = cio_read(cio, 2);
+		int id;
+
+		/* A codestream truncated right at the end of a tile-part is as good as */
+		/* one truncated within it: decode what there is */
+		if (j2k->state == J2K_STATE_TPHSOT && cio_numbytesleft(cio) < 2) {
+			j2k->state = J2K_STATE_NEOC;
+			break;
+		}
+		id = cio_read(cio, 2);
 
 #ifdef USE_JPWL
 		/* we try to honor JPWL correction power */
@@ -228,6 +228,8 @@ typedef struct opj_cp {
 	int layer;
 	/** if == NO_LIMITATION, decode entire codestream; if == LIMIT_TO_MAIN_HEADER then only decode the main header */
 	OPJ_LIMIT_DECODING limit_decoding;
+	/** if != NULL, resolution levels held from a previous decode; see opj_resume_t */
+	opj_resume_t *resume;
 	/** XTOsiz */
 	int tx0;
 	/** YTOsiz */
@@ -174,6 +174,24 @@ opj_image_t* OPJ_CALLCONV opj_decode_with_info(opj_dinfo_t *dinfo, opj_cio_t *ci
 	return NULL;
 }
 
+opj_resume_t* OPJ_CALLCONV opj_resume_create(void) {
+	opj_resume_t *resume = (opj_resume_t*)opj_calloc(1, sizeof(opj_resume_t));
+	if(resume) {
+		resume->resno = -1;
+	}
+	return resume;
+}
+
+void OPJ_CALLCONV opj_resume_destroy(opj_resume_t *resume) {
+	if(resume) {
+		int compno;
+		for (compno = 0; compno < OPJ_RESUME_MAXCOMPS; compno++) {
+			opj_aligned_free(resume->data[compno]);
+		}
+		opj_free(resume);
+	}
+}
+
 opj_cinfo_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT format) {
 	opj_cinfo_t *cinfo = (opj_cinfo_t*)opj_calloc(1, sizeof(opj_cinfo_t));
 	if(!cinfo) return NULL;
@@ -360,6 +360,30 @@ typedef struct opj_cparameters {
 /**
 Decompression parameters
 */
+/** Maximum number of components an opj_resume_t holds */
+#define OPJ_RESUME_MAXCOMPS 5
+
+/**
+Resolution levels carried over from one decode of a codestream to the next.
+When more of a resolution progressive codestream (RPCL, RLCP, or a single layer) has
+arrived, the resolution levels that were already complete do not change: a decode that
+is given their reconstruction only runs tier-1 and the inverse DWT for the new levels,
+and stores the highest level it decoded back. Single tile codestreams only.
+Whether the held levels are complete is for the caller to know: set resno to -1 when not.
+*/
+typedef struct opj_resume {
+	/** highest resolution level held (0 is the lowest), -1 when nothing is held */
+	int resno;
+	/** number of components held */
+	int numcomps;
+	/** width of the held resolution level, per component */
+	int w[OPJ_RESUME_MAXCOMPS];
+	/** height of the held resolution level, per component */
+	int h[OPJ_RESUME_MAXCOMPS];
+	/** reconstructed samples before DC shift and MCT (floats with the 9-7 wavelet), per component */
+	int *data[OPJ_RESUME_MAXCOMPS];
+} opj_resume_t;
+
 typedef struct opj_dparameters {
 	/** 
 	Set the number of highest resolution levels to be discarded. 
@@ -410,6 +434,13 @@ typedef struct opj_dparameters {
 	OPJ_LIMIT_DECODING cp_limit_decoding;
 
 	unsigned int flags;
+
+	/**
+	Resolution levels held from a previous decode of the same codestream (see opj_resume_t).
+	if != NULL, they are reused when possible and the decoded levels are stored back;
+	if == NULL, every level is decoded
+	*/
+	opj_resume_t *resume;
 } opj_dparameters_t;
 
 /** Common fields between JPEG-2000 compression and decompression master structs. */
@@ -843,6 +874,16 @@ Decode an image from a JPEG-2000 codestream and extract the codestream informati
 */
 OPJ_API opj_image_t* OPJ_CALLCONV opj_decode_with_info(opj_dinfo_t *dinfo, opj_cio_t *cio, opj_codestream_info_t *cstr_info);
 /**
+Create an empty resume state (see opj_resume_t)
+@return Returns a new resume state if successful, returns NULL otherwise
+*/
+OPJ_API opj_resume_t* OPJ_CALLCONV opj_resume_create(void);
+/**
+Destroy a resume state and the levels it holds
+@param resume Resume state to destroy
+*/
+OPJ_API void OPJ_CALLCONV opj_resume_destroy(opj_resume_t *resume);
+/**
 Creates a J2K/JP2 compression structure
 @param format Coder to select
 @return Returns a handle to a compressor if successful, returns NULL otherwise
@@ -1507,7 +1507,9 @@ void t1_encode_cblks(
 void t1_decode_cblks(
 		opj_t1_t* t1,
 		opj_tcd_tilecomp_t* tilec,
-		opj_tccp_t* tccp)
+		opj_tccp_t* tccp,
+		int resno_start,
+		int resno_end)
 {
 	int resno, bandno, precno, cblkno;
 
@@ -1529,6 +1531,13 @@ void t1_decode_cblks(
 					int x, y;
 					int i, j;
 
+					if (resno < resno_start || resno >= resno_end) {
+						/* Either held from a previous decode or discarded by cp_reduce */
+						opj_free(cblk->data);
+						opj_free(cblk->segs);
+						continue;
+					}
+
 					t1_decode_cblk(
 							t1,
 							cblk,
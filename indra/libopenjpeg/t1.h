@@ -137,8 +137,10 @@ Decode the code-blocks of a tile
 @param t1 T1 handle
 @param tilec The tile to decode
 @param tccp Tile coding parameters
+@param resno_start First resolution level to decode
+@param resno_end One past the last resolution level to decode
 */
-void t1_decode_cblks(opj_t1_t* t1, opj_tcd_tilecomp_t* tilec, opj_tccp_t* tccp);
+void t1_decode_cblks(opj_t1_t* t1, opj_tcd_tilecomp_t* tilec, opj_tccp_t* tccp, int resno_start, int resno_end);
 /* ----------------------------------------------------------------------- */
 /*@}*/
 
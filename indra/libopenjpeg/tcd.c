@@ -1333,6 +1333,8 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 	int eof = 0;
 	double tile_time, t1_time, dwt_time;
 	opj_tcd_tile_t *tile = NULL;
+	opj_resume_t *resume = NULL;
+	int resno_held = -1;	/* resolution level reused from resume, -1 if none */
 
 	opj_t1_t *t1 = NULL;		/* T1 component */
 	opj_t2_t *t2 = NULL;		/* T2 component */
@@ -1383,6 +1385,30 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 		opj_event_msg(tcd->cinfo, EVT_ERROR, "tcd_decode: incomplete bistream\n");
 	}
 	
+	/*------------------RESUME----------------*/
+
+	/* Levels held from a previous decode of the same codestream can stand in for */
+	/* their code-blocks, as long as this decode needs more of them. */
+	if (tcd->cp->resume && tcd->cp->tw * tcd->cp->th == 1 && tile->numcomps <= OPJ_RESUME_MAXCOMPS) {
+		resume = tcd->cp->resume;
+		if (resume->resno >= 0 && resume->numcomps == tile->numcomps) {
+			resno_held = resume->resno;
+			for (compno = 0; compno < tile->numcomps; compno++) {
+				opj_tcd_tilecomp_t *tilec = &tile->comps[compno];
+				opj_tcd_resolution_t *res;
+				if (resno_held >= tilec->numresolutions - tcd->cp->reduce - 1) {
+					resno_held = -1;
+					break;
+				}
+				res = &tilec->resolutions[resno_held];
+				if (!resume->data[compno] || resume->w[compno] != res->x1 - res->x0 || resume->h[compno] != res->y1 - res->y0) {
+					resno_held = -1;
+					break;
+				}
+			}
+		}
+	}
+
 	/*------------------TIER1-----------------*/
 	
 	t1_time = opj_clock();	/* time needed to decode a tile */
@@ -1404,7 +1430,15 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
             return OPJ_FALSE;
         }
 
-		t1_decode_cblks(t1, tilec, &tcd->tcp->tccps[compno]);
+		t1_decode_cblks(t1, tilec, &tcd->tcp->tccps[compno], resno_held + 1, tilec->numresolutions - tcd->cp->reduce);
+
+		if (resno_held >= 0) {
+			int tw = tilec->x1 - tilec->x0;
+			int j;
+			for (j = 0; j < resume->h[compno]; j++) {
+				memcpy(&tilec->data[j * tw], &resume->data[compno][j * resume->w[compno]], resume->w[compno] * sizeof(int));
+			}
+		}
 	}
 	t1_destroy(t1);
 	t1_time = opj_clock() - t1_time;
@@ -1436,12 +1470,43 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 
 		numres2decode = tcd->image->comps[compno].resno_decoded + 1;
 		if(numres2decode > 0){
+			/* Start from the held level: the transform only needs the resolutions above it */
+			opj_tcd_tilecomp_t dwt_tilec = *tilec;
+			if (resno_held > 0) {
+				dwt_tilec.resolutions += resno_held;
+				numres2decode -= resno_held;
+			}
 			if (tcd->tcp->tccps[compno].qmfbid == 1) {
-				dwt_decode(tilec, numres2decode);
+				dwt_decode(&dwt_tilec, numres2decode);
 			} else {
-				dwt_decode_real(tilec, numres2decode);
+				dwt_decode_real(&dwt_tilec, numres2decode);
 			}
 		}
+
+		/* Keep the reconstruction of the decoded level for the next, larger, decode */
+		if (resume && tcd->image->comps[compno].resno_decoded >= 0) {
+			opj_tcd_resolution_t *res = &tilec->resolutions[tcd->image->comps[compno].resno_decoded];
+			int tw = tilec->x1 - tilec->x0;
+			int rw = res->x1 - res->x0;
+			int rh = res->y1 - res->y0;
+			int j;
+			opj_aligned_free(resume->data[compno]);
+			resume->data[compno] = (int*) opj_aligned_malloc(rw * rh * sizeof(int));
+			if (!resume->data[compno]) {
+				resume = NULL;
+				tcd->cp->resume->resno = -1;
+			} else {
+				for (j = 0; j < rh; j++) {
+					memcpy(&resume->data[compno][j * rw], &tilec->data[j * tw], rw * sizeof(int));
+				}
+				resume->w[compno] = rw;
+				resume->h[compno] = rh;
+			}
+		}
+	}
+	if (resume) {
+		resume->numcomps = tile->numcomps;
+		resume->resno = tcd->image->comps[0].resno_decoded;
 	}
 	dwt_time = opj_clock() - dwt_time;
 	opj_event_msg(tcd->cinfo, EVT_INFO, "- dwt took %f s\n", dwt_time);
@@ -41,6 +41,7 @@
 #include "llendianswizzle.h"
 #include "llassetstorage.h"
 #include "llrefcount.h"
+#include "llthreadpool.h"
 
 #include "llvorbisencode.h"
 
@@ -48,6 +49,9 @@
 #include "vorbis/vorbisfile.h"
 #include <iterator>
 #include <deque>
+#include <list>
+#include <map>
+#include <set>
 
 extern LLAudioEngine *gAudiop;
 
@@ -59,22 +63,12 @@ static const S32 WAV_HEADER_SIZE = 44;
 //////////////////////////////////////////////////////////////////////////////
 
 
-class LLVorbisDecodeState : public LLRefCount
+// Decodes one sound. Created by the main thread, but initDecode(), decodeSection()
+// and finishDecode() are called by a decode thread.
+class LLVorbisDecodeState : public LLThreadSafeRefCount
 {
 public:
-	class WriteResponder : public LLLFSThread::Responder
-	{
-	public:
-		WriteResponder(LLVorbisDecodeState* decoder) : mDecoder(decoder) {}
-		~WriteResponder() {}
-		void completed(S32 bytes)
-		{
-			mDecoder->ioComplete(bytes);
-		}
-		LLPointer<LLVorbisDecodeState> mDecoder;
-	};
-	
-	LLVorbisDecodeState(const LLUUID &uuid, const std::string &out_filename);
+	LLVorbisDecodeState(const LLUUID &uuid);
 
 	BOOL initDecode();
 	BOOL decodeSection(); // Return TRUE if done.
@@ -82,30 +76,53 @@ public:
 
 	void flushBadFile();
 
-	void ioComplete(S32 bytes)			{ mBytesRead = bytes; }
 	BOOL isValid() const				{ return mValid; }
 	BOOL isDone() const					{ return mDone; }
 	const LLUUID &getUUID() const		{ return mUUID; }
+	std::vector<U8>& getWAVBuffer()		{ return mWAVBuffer; }
 
 protected:
 	virtual ~LLVorbisDecodeState();
 
 	BOOL mValid;
 	BOOL mDone;
-	LLAtomicS32 mBytesRead;
 	LLUUID mUUID;
 
 	std::vector<U8> mWAVBuffer;
-#if !defined(USE_WAV_VFILE)
-	std::string mOutFilename;
-	LLLFSThread::handle_t mFileHandle;
-#endif
 	
 	LLVFile *mInFilep;
+	bool mOpen;							// mVF is open; ov_clear() deletes mInFilep.
 	OggVorbis_File mVF;
 	S32 mCurrentSection;
 };
 
+// A decoded sound in WAV format, shared by the PCM cache and a pending write to the disk cache.
+class LLDecodedAudio : public LLThreadSafeRefCount
+{
+public:
+	LLDecodedAudio() : mWriting(0) { }
+
+	std::vector<U8> mWAVBuffer;
+	LLAtomicU32 mWriting;		// Set while the .dsf file is being written; the PCM cache keeps it until then.
+};
+
+class LLDecodedAudioWriteResponder : public LLLFSThread::Responder
+{
+public:
+	LLDecodedAudioWriteResponder(LLDecodedAudio* data, const LLUUID& uuid) : mData(data), mUUID(uuid) {}
+	/*virtual*/ void completed(S32 bytes)
+	{
+		if (bytes == 0)
+		{
+			LL_WARNS("AudioEngine") << "Unable to write decoded file for " << mUUID << LL_ENDL;
+		}
+		mData->mWriting = 0;
+	}
+private:
+	LLPointer<LLDecodedAudio> mData;	// Keeps the buffer alive until it was written.
+	LLUUID mUUID;
+};
+
 size_t vfs_read(void *ptr, size_t size, size_t nmemb, void *datasource)
 {
 	LLVFile *file = (LLVFile *)datasource;
@@ -170,22 +187,23 @@ long vfs_tell (void *datasource)
 	return file->tell();
 }
 
-LLVorbisDecodeState::LLVorbisDecodeState(const LLUUID &uuid, const std::string &out_filename) :
-	mValid(FALSE), mDone(FALSE), mBytesRead(-1), mUUID(uuid),
-#if !defined(USE_WAV_VFILE)
-	mOutFilename(out_filename), mFileHandle(LLLFSThread::nullHandle()),
-#endif
-	mInFilep(NULL), mCurrentSection(0)
+LLVorbisDecodeState::LLVorbisDecodeState(const LLUUID &uuid) :
+	mValid(FALSE), mDone(FALSE), mUUID(uuid),
+	mInFilep(NULL), mOpen(false), mCurrentSection(0)
 {
 }
 
 LLVorbisDecodeState::~LLVorbisDecodeState()
 {
-	if (!mDone)
+	if (mOpen)
+	{
+		ov_clear(&mVF);
+	}
+	else
 	{
 		delete mInFilep;
-		mInFilep = NULL;
 	}
+	mInFilep = NULL;
 }
 
 
@@ -214,6 +232,7 @@ BOOL LLVorbisDecodeState::initDecode()
 		LL_WARNS("AudioEngine") << r << " Input to vorbis decode does not appear to be an Ogg bitstream: " << mUUID << LL_ENDL;
 		return(FALSE);
 	}
+	mOpen = true;
 	
 	S32 sample_count = (S32)ov_pcm_total(&mVF, -1);
 	size_t size_guess = (size_t)sample_count;
@@ -273,8 +292,6 @@ BOOL LLVorbisDecodeState::initDecode()
 		{
 			LL_WARNS("AudioEngine") << "Bad asset encoded by: " << comment->vendor << LL_ENDL;
 		}
-		delete mInFilep;
-		mInFilep = NULL;
 		return FALSE;
 	}
 	
@@ -289,11 +306,6 @@ BOOL LLVorbisDecodeState::initDecode()
 	catch(std::bad_alloc)
 	{
 		LL_WARNS() << "bad_alloc" << LL_ENDL;
-		if(mInFilep)
-		{
-			delete mInFilep;
-			mInFilep = NULL;
-		}
 		return FALSE;
 	}
 	// </edit>
@@ -439,11 +451,10 @@ BOOL LLVorbisDecodeState::finishDecode()
 		return TRUE; // We've finished
 	}
 
-#if !defined(USE_WAV_VFILE)	
-	if (mFileHandle == LLLFSThread::nullHandle())
-#endif
 	{
 		ov_clear(&mVF);
+		mOpen = false;
+		mInFilep = NULL;
   
 		// write "data" chunk length, in little-endian format
 		S32 data_length = mWAVBuffer.size() - WAV_HEADER_SIZE;
@@ -520,37 +531,10 @@ BOOL LLVorbisDecodeState::finishDecode()
 			mValid = FALSE;
 			return TRUE; // we've finished
 		}
-#if !defined(USE_WAV_VFILE)
-		mBytesRead = -1;
-		mFileHandle = LLLFSThread::sLocal->write(mOutFilename, &mWAVBuffer[0], 0, mWAVBuffer.size(),
-							 new WriteResponder(this));
-#endif
-	}
-
-	if (mFileHandle != LLLFSThread::nullHandle())
-	{
-		if (mBytesRead >= 0)
-		{
-			if (mBytesRead == 0)
-			{
-				LL_WARNS("AudioEngine") << "Unable to write file in LLVorbisDecodeState::finishDecode" << LL_ENDL;
-				mValid = FALSE;
-				return TRUE; // we've finished
-			}
-		}
-		else
-		{
-			return FALSE; // not done
-		}
 	}
 	
 	mDone = TRUE;
 
-#if defined(USE_WAV_VFILE)
-	// write the data.
-	LLVFile output(gVFS, mUUID, LLAssetType::AT_SOUND_WAV);
-	output.write(&mWAVBuffer[0], mWAVBuffer.size());
-#endif
 	LL_DEBUGS("AudioEngine") << "Finished decode for " << getUUID() << LL_ENDL;
 
 	return TRUE;
@@ -567,141 +551,381 @@ void LLVorbisDecodeState::flushBadFile()
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Sounds are decoded by a few decode threads, nearest and loudest first.
+// Decoded sounds are kept in memory, up to mPCMCacheSize bytes, so that they can be
+// handed to the audio engine without reading the WAV file back from the disk cache.
 class LLAudioDecodeMgr::Impl
 {
 	friend class LLAudioDecodeMgr;
 public:
-	Impl() {};
-	~Impl() {};
+	Impl();
+	~Impl();
 
 	void processQueue(const F32 num_secs = 0.005);
 
+	// Called by the decode threads.
+	bool hasRequests();
+	bool decodeNext();
+
+	const std::vector<U8>* getDecodedData(const LLUUID &uuid);
+	void setPCMCacheSize(size_t bytes);
+
 protected:
-	std::deque<LLUUID> mDecodeQueue;
-	LLPointer<LLVorbisDecodeState> mCurrentDecodep;
-};
+	class DecodeThread;
 
+	struct Request
+	{
+		LLUUID mUUID;
+		F32 mPriority;
+		U32 mOrder;			// First come, first served between sounds of the same priority.
+	};
 
-void LLAudioDecodeMgr::Impl::processQueue(const F32 num_secs)
-{
-	LLUUID uuid;
+	struct CacheEntry
+	{
+		LLPointer<LLDecodedAudio> mData;
+		std::list<LLUUID>::iterator mLRU;
+	};
+	typedef std::map<LLUUID, CacheEntry> cache_map_t;
+
+	typedef std::map<LLUUID, F32> priority_map_t;
+	static void getPriorities(priority_map_t& priorities);
+	void finishDecode(LLVorbisDecodeState* decodep);
+	void addToCache(const LLUUID &uuid, LLDecodedAudio* data);
+	void trimCache();
+
+	// MAIN THREAD
+	std::deque<LLUUID> mDecodeQueue;	// New requests.
+	std::set<LLUUID> mInProgress;		// Requests that were passed on to the decode threads.
+	U32 mNextOrder;
+	cache_map_t mPCMCache;
+	std::list<LLUUID> mPCMCacheLRU;		// Least recently used first.
+	size_t mPCMCacheBytes;
+	size_t mPCMCacheSize;
+
+	std::vector<DecodeThread*> mThreads;
+	LLAtomicU32 mQuitting;
+
+	LLMutex mQueueMutex;				// Protects the two members below.
+	std::vector<Request> mRequests;
+	std::vector<LLPointer<LLVorbisDecodeState> > mFinished;
+};
 
-	LLTimer decode_timer;
+class LLAudioDecodeMgr::Impl::DecodeThread : public LLThread
+{
+public:
+	DecodeThread(const std::string& name, Impl* impl) : LLThread(name), mImpl(impl) { }
 
-	BOOL done = FALSE;
-	while (!done)
+protected:
+	/*virtual*/ void run(void)
 	{
-		if (mCurrentDecodep)
+		while (true)
 		{
-			// <edit> rawrning
-			//BOOL res;
-			BOOL res = false;
-			// </edit>
-
-			// Decode in a loop until we're done or have run out of time.
-			/* <edit> */ try{ /* </edit> */
-			while(!(res = mCurrentDecodep->decodeSection()) && (decode_timer.getElapsedTimeF32() < num_secs))
+			// Sleeps until runCondition() returns true or we are asked to quit.
+			checkPause();
+			if (isQuitting())
 			{
-				// decodeSection does all of the work above
+				break;
 			}
-			/* <edit> */ }catch(std::bad_alloc){LL_ERRS() << "bad_alloc whilst decoding" << LL_ENDL;} /* </edit> */
-
-			if (mCurrentDecodep->isDone() && !mCurrentDecodep->isValid())
+			while (!isQuitting() && mImpl->decodeNext())
 			{
-				// We had an error when decoding, abort.
-				LL_WARNS("AudioEngine") << mCurrentDecodep->getUUID() << " has invalid vorbis data, aborting decode" << LL_ENDL;
-				mCurrentDecodep->flushBadFile();
-
-				if (gAudiop)
-				{
-					LLAudioData *adp = gAudiop->getAudioData(mCurrentDecodep->getUUID());
-					if(adp)
-					{
-						adp->setLoadState(LLAudioData::STATE_LOAD_ERROR);
-					}
-				}
-				mCurrentDecodep = NULL;
-				done = TRUE;
 			}
+		}
+	}
+
+	/*virtual*/ bool runCondition(void)
+	{
+		return mImpl->hasRequests();
+	}
 
-			if (!res)
+private:
+	Impl* mImpl;
+};
+
+static const S32 MAX_DECODE_THREADS = 2;
+static const size_t DEFAULT_PCM_CACHE_SIZE = 32 * 1024 * 1024;
+
+LLAudioDecodeMgr::Impl::Impl() :
+	mNextOrder(0),
+	mPCMCacheBytes(0),
+	mPCMCacheSize(DEFAULT_PCM_CACHE_SIZE),
+	mQuitting(0)
+{
+	// Decoding is never done on the main thread, so there is always at least one.
+	S32 num_threads = llmax(1, LLThreadPool::getDefaultThreadCount(MAX_DECODE_THREADS));
+	for (S32 i = 0; i < num_threads; ++i)
+	{
+		DecodeThread* thread = new DecodeThread(llformat("Audio decode %d", i), this);
+		mThreads.push_back(thread);
+		thread->start();
+	}
+}
+
+LLAudioDecodeMgr::Impl::~Impl()
+{
+	// Makes decodeNext() abandon the sound it is decoding.
+	mQuitting = 1;
+	for (std::vector<DecodeThread*>::iterator iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+	{
+		(*iter)->setQuitting();
+	}
+	for (std::vector<DecodeThread*>::iterator iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+	{
+		delete *iter;
+	}
+	mThreads.clear();
+}
+
+bool LLAudioDecodeMgr::Impl::hasRequests()
+{
+	LLMutexLock lock(mQueueMutex);
+	return !mRequests.empty();
+}
+
+// Called by a decode thread. Decodes the request with the highest priority.
+// Returns false if there was nothing to do.
+bool LLAudioDecodeMgr::Impl::decodeNext()
+{
+	LLUUID uuid;
+	{
+		LLMutexLock lock(mQueueMutex);
+		if (mRequests.empty())
+		{
+			return false;
+		}
+		std::vector<Request>::iterator best = mRequests.begin();
+		for (std::vector<Request>::iterator iter = best + 1; iter != mRequests.end(); ++iter)
+		{
+			if (iter->mPriority > best->mPriority || (iter->mPriority == best->mPriority && iter->mOrder < best->mOrder))
 			{
-				// We've used up out time slice, bail...
-				done = TRUE;
+				best = iter;
 			}
-			else if (mCurrentDecodep)
+		}
+		uuid = best->mUUID;
+		*best = mRequests.back();
+		mRequests.pop_back();
+	}
+
+	LL_DEBUGS("AudioEngine") << "Decoding " << uuid << " from audio queue!" << LL_ENDL;
+
+	LLPointer<LLVorbisDecodeState> decodep = new LLVorbisDecodeState(uuid);
+	bool ok = false;
+	try
+	{
+		if (decodep->initDecode())
+		{
+			while (!decodep->decodeSection())
 			{
-				if (gAudiop && mCurrentDecodep->finishDecode())
+				if (mQuitting)
 				{
-					// We finished!
-					LLAudioData *adp = gAudiop->getAudioData(mCurrentDecodep->getUUID());
-					if (!adp)
-					{
-						LL_WARNS("AudioEngine") << "Missing LLAudioData for decode of " << mCurrentDecodep->getUUID() << LL_ENDL;
-					}
-					else if (mCurrentDecodep->isValid() && mCurrentDecodep->isDone())
-					{
-						adp->setLoadState(LLAudioData::STATE_LOAD_READY);
-						// At this point, we could see if anyone needs this sound immediately, but
-						// I'm not sure that there's a reason to - we need to poll all of the playing
-						// sounds anyway.
-						//LL_INFOS() << "Finished the vorbis decode, now what?" << LL_ENDL;
-					}
-					else
-					{
-						adp->setLoadState(LLAudioData::STATE_LOAD_ERROR);
-						LL_INFOS("AudioEngine") << "Vorbis decode failed for " << mCurrentDecodep->getUUID() << LL_ENDL;
-					}
-					mCurrentDecodep = NULL;
+					return true;
 				}
-				done = TRUE; // done for now
 			}
+			decodep->finishDecode();
+			ok = true;
 		}
+	}
+	catch (std::bad_alloc&)
+	{
+		LL_WARNS("AudioEngine") << "bad_alloc whilst decoding " << uuid << LL_ENDL;
+	}
+	if (!ok)
+	{
+		// The main thread tells this apart from a bad asset by isDone() being false.
+		decodep = new LLVorbisDecodeState(uuid);
+	}
+
+	LLMutexLock lock(mQueueMutex);
+	mFinished.push_back(decodep);
+	return true;
+}
 
-		if (!done)
+// The priority of a sound is that of the loudest and nearest source that wants to play it.
+//static
+void LLAudioDecodeMgr::Impl::getPriorities(priority_map_t& priorities)
+{
+	if (!gAudiop)
+	{
+		return;
+	}
+	for (LLAudioEngine::source_map::iterator iter = gAudiop->mAllSources.begin(); iter != gAudiop->mAllSources.end(); ++iter)
+	{
+		LLAudioSource* sourcep = iter->second;
+		LLAudioData* datap[2] = { sourcep->getCurrentData(), sourcep->getQueuedData() };
+		for (S32 i = 0; i < 2; ++i)
 		{
-			if (mDecodeQueue.empty())
+			if (datap[i] && datap[i]->getLoadState() == LLAudioData::STATE_LOAD_DECODING)
 			{
-				// Nothing else on the queue.
-				done = TRUE;
+				F32& priority = priorities[datap[i]->getID()];
+				priority = llmax(priority, sourcep->getPriority());
 			}
-			else
-			{
-				LLUUID uuid;
-				uuid = mDecodeQueue.front();
-				mDecodeQueue.pop_front();
-				if (!gAudiop || gAudiop->hasDecodedFile(uuid))
-				{
-					// This file has already been decoded, don't decode it again.
-					continue;
-				}
+		}
+	}
+}
+
+void LLAudioDecodeMgr::Impl::processQueue(const F32 num_secs)
+{
+	// Hand new requests to the decode threads.
+	std::vector<Request> new_requests;
+	while (!mDecodeQueue.empty())
+	{
+		LLUUID uuid = mDecodeQueue.front();
+		mDecodeQueue.pop_front();
+		if (!gAudiop || gAudiop->hasDecodedFile(uuid) || !mInProgress.insert(uuid).second)
+		{
+			// This file has already been decoded, or is being decoded; don't decode it again.
+			continue;
+		}
+		Request request;
+		request.mUUID = uuid;
+		request.mPriority = 0.f;
+		request.mOrder = mNextOrder++;
+		new_requests.push_back(request);
+	}
+	if (mInProgress.size() > mThreads.size())
+	{
+		// Listener and sources moved since last frame, so rank everything that is still waiting again.
+		priority_map_t priorities;
+		getPriorities(priorities);
+		LLMutexLock lock(mQueueMutex);
+		mRequests.insert(mRequests.end(), new_requests.begin(), new_requests.end());
+		for (std::vector<Request>::iterator iter = mRequests.begin(); iter != mRequests.end(); ++iter)
+		{
+			priority_map_t::const_iterator found = priorities.find(iter->mUUID);
+			iter->mPriority = found == priorities.end() ? 0.f : found->second;	// Preloads last.
+		}
+	}
+	else if (!new_requests.empty())
+	{
+		// No need to rank anything when every request gets a decode thread right away.
+		LLMutexLock lock(mQueueMutex);
+		mRequests.insert(mRequests.end(), new_requests.begin(), new_requests.end());
+	}
+	if (!new_requests.empty())
+	{
+		for (std::vector<DecodeThread*>::iterator iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+		{
+			(*iter)->wake();
+		}
+	}
+
+	// Collect the decoded sounds.
+	std::vector<LLPointer<LLVorbisDecodeState> > finished;
+	{
+		LLMutexLock lock(mQueueMutex);
+		finished.swap(mFinished);
+	}
+	for (std::vector<LLPointer<LLVorbisDecodeState> >::iterator iter = finished.begin(); iter != finished.end(); ++iter)
+	{
+		finishDecode(*iter);
+	}
+	if (mPCMCacheBytes > mPCMCacheSize)
+	{
+		// Evict what could not be evicted while it was being written.
+		trimCache();
+	}
+}
 
-				LL_DEBUGS() << "Decoding " << uuid << " from audio queue!" << LL_ENDL;
+void LLAudioDecodeMgr::Impl::finishDecode(LLVorbisDecodeState* decodep)
+{
+	const LLUUID& uuid = decodep->getUUID();
+	mInProgress.erase(uuid);
+	LLAudioData *adp = gAudiop ? gAudiop->getAudioData(uuid) : NULL;
 
-				std::string uuid_str;
-				std::string d_path;
+	if (decodep->isDone() && !decodep->isValid())
+	{
+		// We had an error when decoding, abort.
+		LL_WARNS("AudioEngine") << uuid << " has invalid vorbis data, aborting decode" << LL_ENDL;
+		decodep->flushBadFile();
+	}
+	if (!decodep->isValid())
+	{
+		if (adp)
+		{
+			adp->setLoadState(LLAudioData::STATE_LOAD_ERROR);
+		}
+		return;
+	}
 
-				LLTimer timer;
-				timer.reset();
+	LLPointer<LLDecodedAudio> data = new LLDecodedAudio;
+	data->mWAVBuffer.swap(decodep->getWAVBuffer());
+	addToCache(uuid, data);
 
-				uuid.toString(uuid_str);
-				d_path = gDirUtilp->getExpandedFilename(LL_PATH_CACHE,uuid_str) + ".dsf";
+	// Also keep it in the disk cache for the next session; this does not hold up playing it.
+#if defined(USE_WAV_VFILE)
+	LLVFile output(gVFS, uuid, LLAssetType::AT_SOUND_WAV);
+	output.write(&data->mWAVBuffer[0], data->mWAVBuffer.size());
+#else
+	std::string uuid_str;
+	uuid.toString(uuid_str);
+	std::string d_path = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, uuid_str) + ".dsf";
+	// Until the write completed the file may exist but be incomplete, so the sound must stay
+	// in the PCM cache: hasDecodedFile() would otherwise send the audio engine to a partial file.
+	data->mWriting = 1;
+	LLLFSThread::sLocal->write(d_path, &data->mWAVBuffer[0], 0, data->mWAVBuffer.size(),
+							   new LLDecodedAudioWriteResponder(data, uuid));
+#endif
 
-				mCurrentDecodep = new LLVorbisDecodeState(uuid, d_path);
-				if (!mCurrentDecodep->initDecode())
-				{
-					LLAudioData *adp = gAudiop->getAudioData(uuid);
-					if(adp)
-					{
-						adp->setLoadState(LLAudioData::STATE_LOAD_ERROR);
-					}
-					mCurrentDecodep = NULL;
-				}
-			}
+	if (!adp)
+	{
+		LL_WARNS("AudioEngine") << "Missing LLAudioData for decode of " << uuid << LL_ENDL;
+	}
+	else
+	{
+		adp->setLoadState(LLAudioData::STATE_LOAD_READY);
+	}
+}
+
+void LLAudioDecodeMgr::Impl::addToCache(const LLUUID &uuid, LLDecodedAudio* data)
+{
+	CacheEntry& entry = mPCMCache[uuid];
+	if (entry.mData)
+	{
+		mPCMCacheBytes -= entry.mData->mWAVBuffer.size();
+		mPCMCacheLRU.erase(entry.mLRU);
+	}
+	entry.mData = data;
+	entry.mLRU = mPCMCacheLRU.insert(mPCMCacheLRU.end(), uuid);
+	mPCMCacheBytes += data->mWAVBuffer.size();
+	trimCache();
+}
+
+void LLAudioDecodeMgr::Impl::trimCache()
+{
+	// Sounds that are still being written to the disk cache are skipped; they are
+	// evicted by a later call, see processQueue().
+	std::list<LLUUID>::iterator lru = mPCMCacheLRU.begin();
+	while (mPCMCacheBytes > mPCMCacheSize && lru != mPCMCacheLRU.end())
+	{
+		cache_map_t::iterator iter = mPCMCache.find(*lru);
+		if (iter->second.mData->mWriting)
+		{
+			++lru;
+			continue;
 		}
+		mPCMCacheBytes -= iter->second.mData->mWAVBuffer.size();
+		mPCMCache.erase(iter);
+		lru = mPCMCacheLRU.erase(lru);
 	}
 }
 
+const std::vector<U8>* LLAudioDecodeMgr::Impl::getDecodedData(const LLUUID &uuid)
+{
+	cache_map_t::iterator iter = mPCMCache.find(uuid);
+	if (iter == mPCMCache.end())
+	{
+		return NULL;
+	}
+	// Mark as most recently used.
+	mPCMCacheLRU.splice(mPCMCacheLRU.end(), mPCMCacheLRU, iter->second.mLRU);
+	return &iter->second.mData->mWAVBuffer;
+}
+
+void LLAudioDecodeMgr::Impl::setPCMCacheSize(size_t bytes)
+{
+	mPCMCacheSize = bytes;
+	trimCache();
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 LLAudioDecodeMgr::LLAudioDecodeMgr()
@@ -744,3 +968,18 @@ bool LLAudioDecodeMgr::addDecodeRequest(const LLUUID &uuid)
 	LL_DEBUGS("AudioEngine") << "addDecodeRequest for " << uuid << " no file available" << LL_ENDL;
 	return false;
 }
+
+bool LLAudioDecodeMgr::hasDecodedData(const LLUUID &uuid) const
+{
+	return mImpl->mPCMCache.find(uuid) != mImpl->mPCMCache.end();
+}
+
+const std::vector<U8>* LLAudioDecodeMgr::getDecodedData(const LLUUID &uuid)
+{
+	return mImpl->getDecodedData(uuid);
+}
+
+void LLAudioDecodeMgr::setPCMCacheSize(size_t bytes)
+{
+	mImpl->setPCMCacheSize(bytes);
+}
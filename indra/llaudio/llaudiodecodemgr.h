@@ -33,6 +33,8 @@
 #include "llassettype.h"
 #include "llframetimer.h"
 
+#include <vector>
+
 class LLVFS;
 class LLVorbisDecodeState;
 
@@ -42,9 +44,17 @@ public:
 	LLAudioDecodeMgr();
 	~LLAudioDecodeMgr();
 
+	// Hands new requests to the decode threads and collects the decoded sounds.
+	// Decoding itself no longer happens here, so num_secs is not used.
 	void processQueue(const F32 num_secs = 0.005);
 	bool addDecodeRequest(const LLUUID &uuid);
 	void addAudioRequest(const LLUUID &uuid);
+
+	// The in-memory cache of recently decoded sounds, in WAV format.
+	bool hasDecodedData(const LLUUID &uuid) const;
+	// Returns NULL if uuid isn't cached. The returned data is only valid until the next call to processQueue().
+	const std::vector<U8>* getDecodedData(const LLUUID &uuid);
+	void setPCMCacheSize(size_t bytes);
 	
 protected:
 	class Impl;
@@ -1057,6 +1057,11 @@ void LLAudioEngine::cleanupAudioSource(LLAudioSource *asp)
 
 bool LLAudioEngine::hasDecodedFile(const LLUUID &uuid)
 {
+	if (gAudioDecodeMgrp && gAudioDecodeMgrp->hasDecodedData(uuid))
+	{
+		return true;
+	}
+
 	std::string uuid_str;
 	uuid.toString(uuid_str);
 
@@ -1806,6 +1811,14 @@ bool LLAudioData::load()
 		return false;
 	}
 
+	// Recently decoded sounds are still in memory; use those rather than reading the WAV file back.
+	const std::vector<U8>* decoded = gAudioDecodeMgrp ? gAudioDecodeMgrp->getDecodedData(mID) : NULL;
+	if (decoded && mBufferp->loadWAVMemory(&(*decoded)[0], (U32)decoded->size()))
+	{
+		mBufferp->mAudioDatap = this;
+		return true;
+	}
+
 	std::string uuid_str;
 	std::string wav_path;
 	mID.toString(uuid_str);
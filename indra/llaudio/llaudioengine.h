@@ -480,6 +480,8 @@ public:
 	LLAudioBuffer() : mInUse(true), mAudioDatap(NULL) { mLastUseTimer.reset(); }
 	virtual ~LLAudioBuffer() {};
 	virtual bool loadWAV(const std::string& filename) = 0;
+	// Load a WAV file image from memory. Returns false if not supported by this engine, or on failure.
+	virtual bool loadWAVMemory(const U8* data, U32 size) { return false; }
 	virtual U32 getLength() = 0;
 
 	friend class LLAudioEngine;
@@ -928,6 +928,35 @@ bool LLAudioBufferFMODSTUDIO::loadWAV(const std::string& filename)
 }
 
 
+bool LLAudioBufferFMODSTUDIO::loadWAVMemory(const U8* data, U32 size)
+{
+	if (mSoundp)
+	{
+		gSoundCheck.removeSound(mSoundp);
+		// If there's already something loaded in this buffer, clean it up.
+		Check_FMOD_Error(mSoundp->release(),"FMOD::Sound::release");
+		mSoundp = NULL;
+	}
+
+	FMOD_MODE base_mode = FMOD_LOOP_NORMAL | FMOD_OPENMEMORY;	// FMOD makes its own copy of the data.
+	FMOD_CREATESOUNDEXINFO exinfo = {0};
+	exinfo.cbsize = sizeof(exinfo);
+	exinfo.length = size;
+	exinfo.suggestedsoundtype = FMOD_SOUND_TYPE_WAV;
+	FMOD_RESULT result = getSystem()->createSound((const char*)data, base_mode, &exinfo, &mSoundp);
+	if (result != FMOD_OK)
+	{
+		LL_WARNS("AudioImpl") << "Could not load decoded sound: " << FMOD_ErrorString(result) << LL_ENDL;
+		mSoundp = NULL;
+		return false;
+	}
+
+	gSoundCheck.addNewSound(mSoundp);
+
+	return true;
+}
+
+
 U32 LLAudioBufferFMODSTUDIO::getLength()
 {
 	if (!mSoundp)
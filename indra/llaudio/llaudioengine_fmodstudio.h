@@ -126,6 +126,7 @@ public:
 	virtual ~LLAudioBufferFMODSTUDIO();
 
 	/*virtual*/ bool loadWAV(const std::string& filename);
+	/*virtual*/ bool loadWAVMemory(const U8* data, U32 size);
 	/*virtual*/ U32 getLength();
 	friend class LLAudioChannelFMODSTUDIO;
 protected:
@@ -370,6 +370,20 @@ bool LLAudioBufferOpenAL::loadWAV(const std::string& filename)
 	return true;
 }
 
+bool LLAudioBufferOpenAL::loadWAVMemory(const U8* data, U32 size)
+{
+	cleanup();
+	mALBuffer = alutCreateBufferFromFileImage(data, size);
+	if(mALBuffer == AL_NONE)
+	{
+		ALenum error = alutGetError();
+		LL_WARNS() << "LLAudioBufferOpenAL::loadWAVMemory() Error loading decoded sound: " << alutGetErrorString(error) << LL_ENDL;
+		return false;
+	}
+
+	return true;
+}
+
 U32 LLAudioBufferOpenAL::getLength()
 {
 	if(mALBuffer == AL_NONE)
@@ -454,6 +454,9 @@ public:
 	// Only for use by AITHREADSAFESIMPLE, see below.
 	AIThreadSafeSimple(T* object) { llassert(object == AIThreadSafeBits<T>::ptr()); }
 
+	// Returns true if the calling thread has this object locked.
+	bool isSelfLocked() const { return mMutex.isSelfLocked(); }
+
 #if LL_DEBUG
 	// Can only be locked when there still exists an AIAccess object that
 	// references this object and will access it upon destruction.
@@ -47,11 +47,11 @@ LLCoros::LLCoros():
     mStackSize(256*1024)
 {
     // Register our cleanup() method for "mainloop" ticks
-    LLEventPumps::instance().obtain("mainloop").listen(
+    mMainloopConnection = LLMainloopEvent::channel().listen(
         "LLCoros", boost::bind(&LLCoros::cleanup, this, _1));
 }
 
-bool LLCoros::cleanup(const LLSD&)
+bool LLCoros::cleanup(const LLMainloopEvent&)
 {
     // Walk the mCoros map, checking and removing completed coroutines.
     for (CoroMap::iterator mi(mCoros.begin()), mend(mCoros.end()); mi != mend; )
@@ -31,6 +31,7 @@
 
 #include <boost/dcoroutine/coroutine.hpp>
 #include "llsingleton.h"
+#include "lleventchannel.h"
 #include <boost/ptr_container/ptr_map.hpp>
 #include <string>
 #include <boost/preprocessor/repetition/enum_params.hpp>
@@ -160,9 +161,10 @@ private:
     LLCoros();
     std::string launchImpl(const std::string& prefix, coro* newCoro);
     std::string generateDistinctName(const std::string& prefix) const;
-    bool cleanup(const LLSD&);
+    bool cleanup(const LLMainloopEvent&);
 
     S32 mStackSize;
+    LLEventChannel<LLMainloopEvent>::ScopedConnection mMainloopConnection;
     typedef boost::ptr_map<std::string, coro> CoroMap;
     CoroMap mCoros;
 };
@@ -30,6 +30,7 @@
 #include "llerror.h"
 #include "llerrorcontrol.h"
 
+#include <atomic>
 #include <cctype>
 #ifdef __GNUC__
 # include <cxxabi.h>
@@ -48,6 +49,7 @@
 #include "llsd.h"
 #include "llsdserialize.h"
 #include "llstl.h"
+#include "llthread.h"
 #include "lltimer.h"
 
 #include "aithreadsafe.h"
@@ -133,7 +135,12 @@ namespace {
 		virtual void recordMessage(LLError::ELevel level,
 									const std::string& message)
 		{
-			mFile << message << std::endl;
+			mFile << message << '\n';
+		}
+
+		virtual void flush()
+		{
+			mFile.flush();
 		}
 	
 	private:
@@ -366,10 +373,6 @@ namespace
 	class Globals
 	{
 	public:
-
-		std::ostringstream messageStream;
-		bool messageStreamInUse;
-
 		void addCallSite(LLError::CallSite&);
 		void invalidateCallSites();
 
@@ -386,9 +389,7 @@ namespace
 	};
 
 	Globals::Globals()
-		: messageStream(),
-		messageStreamInUse(false),
-		callSites()
+		: callSites()
 	{
 	}
 
@@ -457,6 +458,9 @@ namespace LLError
 
 	typedef LLPointer<SettingsConfig> SettingsConfigPtr;
 
+	// Copy of the current mTimeFunction, for stamping queued messages without the Settings lock.
+	std::atomic<LLError::TimeFunction> sTimeFunction(NULL);
+
 	class Settings
 	{
 	public:
@@ -520,6 +524,7 @@ namespace LLError
 	{
 		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		mSettingsConfig = new SettingsConfig();
+		sTimeFunction = NULL;
 	}
 	
 	SettingsStoragePtr Settings::saveAndReset()
@@ -534,6 +539,7 @@ namespace LLError
 		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		SettingsConfigPtr newSettingsConfig(dynamic_cast<SettingsConfig *>(pSettingsStorage.get()));
 		mSettingsConfig = newSettingsConfig;
+		sTimeFunction = mSettingsConfig->mTimeFunction;
 	}
 }
 
@@ -712,7 +718,9 @@ namespace LLError
 
 	void setTimeFunction(TimeFunction f)
 	{
-		AIAccess<Settings>(Settings::get())->getSettingsConfig()->mTimeFunction = f;
+		AIAccess<Settings> settings_w(Settings::get());
+		settings_w->getSettingsConfig()->mTimeFunction = f;
+		sTimeFunction = f;
 	}
 
 	void setDefaultLevel(AIAccess<Settings> const& settings_w, ELevel level)
@@ -865,6 +873,11 @@ namespace LLError
 		return mWantsFunctionName;
 	}
 
+	// virtual
+	void Recorder::flush()
+	{
+	}
+
 	void addRecorder(AIAccess<Settings> const& settings_w, RecorderPtr recorder)
 	{
 		if (!recorder)
@@ -950,7 +963,8 @@ namespace LLError
 
 namespace
 {
-	void writeToRecorders(AIAccess<LLError::Settings>& settings_w, const LLError::CallSite& site, const std::string& message, bool show_location = true, bool show_time = true, bool show_tags = true, bool show_level = true, bool show_function = true)
+	// time is the time stamp taken when the message was queued, or NULL to take it now.
+	void writeToRecorders(AIAccess<LLError::Settings>& settings_w, const LLError::CallSite& site, const std::string& message, bool show_location = true, bool show_time = true, bool show_tags = true, bool show_level = true, bool show_function = true, char const* time = NULL)
 	{
 		LLError::ELevel level = site.mLevel;
 		LLError::SettingsConfigPtr s = settings_w->getSettingsConfig();
@@ -968,9 +982,19 @@ namespace
 				message_stream << site.mLocationString << " ";
 			}
 
-			if (show_time && r->wantsTime() && s->mTimeFunction != NULL)
+			if (show_time && r->wantsTime())
 			{
-				message_stream << s->mTimeFunction() << " ";
+				if (time)
+				{
+					if (*time)
+					{
+						message_stream << time << " ";
+					}
+				}
+				else if (s->mTimeFunction != NULL)
+				{
+					message_stream << s->mTimeFunction() << " ";
+				}
 			}
 
 			if (show_level && r->wantsLevel())
@@ -999,6 +1023,65 @@ namespace
 			r->recordMessage(level, message_stream.str());
 		}
 	}
+
+	void flushRecorders(AIAccess<LLError::Settings>& settings_w)
+	{
+		LLError::SettingsConfigPtr s = settings_w->getSettingsConfig();
+		for (Recorders::const_iterator i = s->mRecorders.begin(); i != s->mRecorders.end(); ++i)
+		{
+			(*i)->flush();
+		}
+	}
+
+	// Everything Log::flush() does for a message that is not an error: handle
+	// print once and hand it to the recorders.
+	void writeMessage(AIAccess<LLError::Settings>& settings_w, const LLError::CallSite& site, const std::string& message, char const* time = NULL)
+	{
+		LLError::SettingsConfigPtr s = settings_w->getSettingsConfig();
+		std::ostringstream message_stream;
+
+		bool need_function = site.mFunction;
+		if (need_function && !site.mTagString.empty())
+		{
+#if LL_DEBUG
+			// Suppress printing mFunction if mBroadTag is set, starts with
+			// "Plugin " and ends with "child": a debug message from a plugin.
+			size_t taglen = site.mTagString.length();
+			if (taglen >= 12 && strncmp(site.mTagString.c_str(), "Plugin ", 7) == 0 &&
+				strcmp(site.mTagString.c_str() + taglen - 5, "child") == 0)
+			{
+				need_function = false;
+			}
+#endif
+		}
+
+		if (site.mPrintOnce)
+		{
+			std::map<std::string, unsigned int>::iterator messageIter = s->mUniqueLogMessages.find(message);
+			if (messageIter != s->mUniqueLogMessages.end())
+			{
+				messageIter->second++;
+				unsigned int num_messages = messageIter->second;
+				if (num_messages == 10 || num_messages == 50 || (num_messages % 100) == 0)
+				{
+					message_stream << "ONCE (" << num_messages << "th time seen): ";
+				} 
+				else
+				{
+					return;
+				}
+			}
+			else 
+			{
+				message_stream << "ONCE: ";
+				s->mUniqueLogMessages[message] = 1;
+			}
+		}
+		
+		message_stream << message;
+		
+		writeToRecorders(settings_w, site, message_stream.str(), true, true, true, true, need_function, time);
+	}
 }
 
 
@@ -1096,6 +1179,241 @@ namespace {
 	}
 }
 
+namespace
+{
+	// Growable put area that can be read in place and rewound, so that a
+	// thread's message stream keeps its memory from one message to the next.
+	class LogStreamBuf : public std::streambuf
+	{
+	public:
+		LogStreamBuf() : mBuffer(256) { rewind(); }
+
+		void rewind() { setp(&mBuffer[0], &mBuffer[0] + mBuffer.size()); }
+		char const* data() const { return pbase(); }
+		size_t size() const { return pptr() - pbase(); }
+
+	protected:
+		/*virtual*/ int_type overflow(int_type c)
+		{
+			size_t used = size();
+			mBuffer.resize(mBuffer.size() * 2);
+			setp(&mBuffer[0], &mBuffer[0] + mBuffer.size());
+			pbump((int)used);
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+			{
+				*pptr() = traits_type::to_char_type(c);
+				pbump(1);
+			}
+			return traits_type::not_eof(c);
+		}
+
+	private:
+		std::vector<char> mBuffer;
+	};
+
+	// Set once the calling thread's stream was destroyed, when logging from
+	// destructors that run at thread or program exit.
+	ll_thread_local bool tMessageStreamGone;
+
+	// Every thread composes its messages in its own stream, so Log::out() needs no lock.
+	struct ThreadMessageStream
+	{
+		ThreadMessageStream() : mInUse(false) { mStream.std::ios::rdbuf(&mBuffer); }
+		~ThreadMessageStream() { tMessageStreamGone = true; }
+
+		LogStreamBuf mBuffer;
+		std::ostringstream mStream;			// Writes to mBuffer, str() is not used.
+		bool mInUse;
+	};
+
+	thread_local ThreadMessageStream tMessageStream;
+
+	bool isThreadMessageStream(std::ostringstream* out)
+	{
+		return !tMessageStreamGone && out == &tMessageStream.mStream;
+	}
+
+	void getMessageText(std::ostringstream* out, char const*& text, size_t& length, std::string& str)
+	{
+		if (isThreadMessageStream(out))
+		{
+			text = tMessageStream.mBuffer.data();
+			length = tMessageStream.mBuffer.size();
+		}
+		else
+		{
+			str = out->str();
+			text = str.data();
+			length = str.size();
+		}
+	}
+
+	void releaseMessageStream(std::ostringstream* out)
+	{
+		if (isThreadMessageStream(out))
+		{
+			tMessageStream.mBuffer.rewind();
+			tMessageStream.mStream.clear();
+			tMessageStream.mInUse = false;
+		}
+		else
+		{
+			delete out;
+		}
+	}
+
+	const U32 LOG_QUEUE_SIZE = 1024;		// Must be a power of two.
+	const U32 LOG_RECORD_TEXT = 240;
+	const U32 LOG_RECORD_TIME = 48;
+	const U32 LOG_BATCH_SIZE = 64;			// Messages written per Settings lock and recorder flush.
+	const U32 LOG_THREAD_SLEEP_MS = 5;
+
+	struct LogRecord
+	{
+		std::atomic<U32> mSequence;
+		LLError::CallSite const* mSite;
+		char mTime[LOG_RECORD_TIME];		// Taken when queued, empty without a time function.
+		U32 mLength;
+		char mText[LOG_RECORD_TEXT];
+		std::string mLongText;				// Only for messages that don't fit in mText.
+	};
+
+	// Bounded multiple producer, single consumer queue of preallocated records.
+	// Producers claim a slot with a compare and swap on the push position and
+	// publish it through the slot's sequence number; the logger thread is the
+	// only consumer.
+	class LogQueue
+	{
+	public:
+		LogQueue() : mPushPos(0), mPopPos(0), mWritten(0)
+		{
+			for (U32 i = 0; i < LOG_QUEUE_SIZE; ++i)
+			{
+				mRecords[i].mSequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// Any thread. Returns false when the queue is full.
+		bool push(LLError::CallSite const& site, char const* time, char const* text, size_t length)
+		{
+			U32 pos = mPushPos.load(std::memory_order_relaxed);
+			LogRecord* record;
+			for (;;)
+			{
+				record = &mRecords[pos & (LOG_QUEUE_SIZE - 1)];
+				S32 diff = (S32)(record->mSequence.load(std::memory_order_acquire) - pos);
+				if (diff == 0)
+				{
+					if (mPushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = mPushPos.load(std::memory_order_relaxed);
+				}
+			}
+			record->mSite = &site;
+			strncpy(record->mTime, time, LOG_RECORD_TIME - 1);
+			record->mTime[LOG_RECORD_TIME - 1] = '\0';
+			record->mLength = (U32)length;
+			if (length <= LOG_RECORD_TEXT)
+			{
+				memcpy(record->mText, text, length);
+			}
+			else
+			{
+				record->mLongText.assign(text, length);
+			}
+			record->mSequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Logger thread only. Returns NULL when empty.
+		LogRecord* front()
+		{
+			LogRecord* record = &mRecords[mPopPos & (LOG_QUEUE_SIZE - 1)];
+			return record->mSequence.load(std::memory_order_acquire) == mPopPos + 1 ? record : NULL;
+		}
+
+		void pop()
+		{
+			mRecords[mPopPos & (LOG_QUEUE_SIZE - 1)].mSequence.store(mPopPos + LOG_QUEUE_SIZE, std::memory_order_release);
+			++mPopPos;
+		}
+
+		void addWritten(U32 count) { mWritten.fetch_add(count, std::memory_order_release); }
+		U32 getPushed() const { return mPushPos.load(std::memory_order_relaxed); }
+		U32 getWritten() const { return mWritten.load(std::memory_order_acquire); }
+
+	private:
+		LogRecord mRecords[LOG_QUEUE_SIZE];
+		std::atomic<U32> mPushPos;
+		U32 mPopPos;
+		std::atomic<U32> mWritten;			// Records handed to the recorders and flushed.
+	};
+
+	LogQueue sLogQueue;
+	std::atomic<bool> sAsyncLogging(false);
+	ll_thread_local bool tIsLogThread;
+
+	// Writes up to a batch of queued messages. Returns false if there was nothing to write.
+	bool writeQueued()
+	{
+		LogRecord* record = sLogQueue.front();
+		if (!record)
+		{
+			return false;
+		}
+		U32 count = 0;
+		{
+			AIAccess<LLError::Settings> settings_w(LLError::Settings::get());
+			do
+			{
+				std::string message = record->mLength <= LOG_RECORD_TEXT ?
+					std::string(record->mText, record->mLength) : record->mLongText;
+				writeMessage(settings_w, *record->mSite, message, record->mTime);
+				sLogQueue.pop();
+				++count;
+			}
+			while (count < LOG_BATCH_SIZE && (record = sLogQueue.front()));
+			flushRecorders(settings_w);
+		}
+		sLogQueue.addWritten(count);
+		return true;
+	}
+
+	class LogThread : public LLThread
+	{
+	public:
+		LogThread() : LLThread("Logger") { }
+
+		/*virtual*/ void run()
+		{
+			tIsLogThread = true;
+			while (!isQuitting())
+			{
+				if (!writeQueued())
+				{
+					ms_sleep(LOG_THREAD_SLEEP_MS);
+				}
+			}
+			while (writeQueued())
+			{
+			}
+		}
+	};
+
+	LogThread* sLogThread;
+	// A logger thread that didn't stop when asked, see setAsyncLogging().
+	LogThread* sStuckLogThread;
+}
+
 namespace LLError
 {
 	bool Log::shouldLog(CallSite& site)
@@ -1148,75 +1466,75 @@ namespace LLError
 
 	std::ostringstream* Log::out()
 	{
-		LogLock lock;
-		if (lock.ok())
+		if (!tMessageStreamGone && !tMessageStream.mInUse)
 		{
-			AIAccess<Globals> g(Globals::get());
-
-			if (!g->messageStreamInUse)
-			{
-				g->messageStreamInUse = true;
-				return &g->messageStream;
-			}
+			tMessageStream.mInUse = true;
+			return &tMessageStream.mStream;
 		}
-		
+		// Logging while composing a message on the same thread, or at exit.
 		return new std::ostringstream;
 	}
 	
 	void Log::flush(std::ostringstream* out, char* message)
-    {
-       LogLock lock;
-       if (!lock.ok())
-       {
-           return;
-       }
-       
-	   if(strlen(out->str().c_str()) < 128)
-	   {
-		   strcpy(message, out->str().c_str());
-	   }
-	   else
-	   {
-		   strncpy(message, out->str().c_str(), 127);
-		   message[127] = '\0' ;
-	   }
-	   
-	   AIAccess<Globals> g(Globals::get());
-       if (out == &g->messageStream)
-       {
-           g->messageStream.clear();
-           g->messageStream.str("");
-           g->messageStreamInUse = false;
-       }
-       else
-       {
-           delete out;
-       }
-	   return ;
-    }
+	{
+		char const* text;
+		size_t length;
+		std::string str;
+		getMessageText(out, text, length, str);
+		length = llmin(length, (size_t)127);
+		memcpy(message, text, length);
+		message[length] = '\0';
+		releaseMessageStream(out);
+	}
 
 	void Log::flush(std::ostringstream* out, const CallSite& site)
 	{
-		LogLock lock;
-		if (!lock.ok())
-		{
-			return;
-		}
-		
-		std::string message = out->str();
+		char const* text;
+		size_t length;
+		std::string str;
+		getMessageText(out, text, length, str);
+
+		if (site.mLevel != LEVEL_ERROR)
 		{
-			AIAccess<Globals> g(Globals::get());
-			if (out == &g->messageStream)
+			// Stamp the message now, not when the logger thread gets to it.
+			std::string time;
+			LLError::TimeFunction time_function = sTimeFunction;
+			if (sAsyncLogging && time_function)
 			{
-				g->messageStream.clear();
-				g->messageStream.str("");
-				g->messageStreamInUse = false;
+				time = time_function();
 			}
-			else
+			// Wait for room rather than reorder or lose messages. The logger
+			// thread itself drops what doesn't fit, it would wait on itself.
+			while (sAsyncLogging)
 			{
-				delete out;
+				if (sLogQueue.push(site, time.c_str(), text, length))
+				{
+					releaseMessageStream(out);
+					return;
+				}
+				if (tIsLogThread)
+				{
+					releaseMessageStream(out);
+					return;
+				}
+				ms_sleep(0);
 			}
 		}
+		else
+		{
+			// Whatever was logged before the error must make it to disk before we crash.
+			flushLog();
+		}
+
+		LogLock lock;
+		if (!lock.ok())
+		{
+			releaseMessageStream(out);
+			return;
+		}
+
+		std::string message(text, length);
+		releaseMessageStream(out);
 
 		AIAccess<Settings> settings_w(Settings::get());
 		SettingsConfigPtr s = settings_w->getSettingsConfig();
@@ -1225,54 +1543,86 @@ namespace LLError
 		{
 			writeToRecorders(settings_w, site, "error", true, true, true, false, false);
 		}
-		
-		std::ostringstream message_stream;
 
-		bool need_function = site.mFunction;
-		if (need_function && !site.mTagString.empty())
+		writeMessage(settings_w, site, message);
+		flushRecorders(settings_w);
+		
+		if (site.mLevel == LEVEL_ERROR  &&  s->mCrashFunction)
 		{
-#if LL_DEBUG
-			// Suppress printing mFunction if mBroadTag is set, starts with
-			// "Plugin " and ends with "child": a debug message from a plugin.
-			size_t taglen = site.mTagString.length();
-			if (taglen >= 12 && strncmp(site.mTagString.c_str(), "Plugin ", 7) == 0 &&
-				strcmp(site.mTagString.c_str() + taglen - 5, "child") == 0)
-			{
-				need_function = false;
-			}
-#endif
+			s->mCrashFunction(message);
 		}
+	}
 
-		if (site.mPrintOnce)
+	void setAsyncLogging(bool async)
+	{
+		if (async == sAsyncLogging)
 		{
-			std::map<std::string, unsigned int>::iterator messageIter = s->mUniqueLogMessages.find(message);
-			if (messageIter != s->mUniqueLogMessages.end())
+			return;
+		}
+		if (async)
+		{
+			if (sStuckLogThread)
 			{
-				messageIter->second++;
-				unsigned int num_messages = messageIter->second;
-				if (num_messages == 10 || num_messages == 50 || (num_messages % 100) == 0)
-				{
-					message_stream << "ONCE (" << num_messages << "th time seen): ";
-				} 
-				else
+				if (!sStuckLogThread->isStopped())
 				{
+					// It may still read from the queue and a queue has one reader. Stay synchronous.
 					return;
 				}
+				delete sStuckLogThread;
+				sStuckLogThread = NULL;
+				while (writeQueued())
+				{
+				}
 			}
-			else 
+			if (!sLogThread)
 			{
-				message_stream << "ONCE: ";
-				s->mUniqueLogMessages[message] = 1;
+				sLogThread = new LogThread;
+				sLogThread->start();
 			}
+			sAsyncLogging = true;
+			return;
 		}
-		
-		message_stream << message;
-		
-		writeToRecorders(settings_w, site, message_stream.str(), true, true, true, true, need_function);
-		
-		if (site.mLevel == LEVEL_ERROR  &&  s->mCrashFunction)
+
+		sAsyncLogging = false;
+		sLogThread->setQuitting();
+		// Don't hang on a logger thread that is stuck in a recorder (we might be crashing).
+		for (S32 waited = 0; !sLogThread->isStopped() && waited < 2000; ++waited)
+		{
+			ms_sleep(1);
+		}
+		if (sLogThread->isStopped())
+		{
+			delete sLogThread;
+			sLogThread = NULL;
+			// Messages that were queued while the thread was stopping.
+			while (writeQueued())
+			{
+			}
+		}
+		else
 		{
-			s->mCrashFunction(message_stream.str());
+			// It is quitting and must not be started again; it's deleted once it stopped.
+			sStuckLogThread = sLogThread;
+			sLogThread = NULL;
+		}
+	}
+
+	bool getAsyncLogging()
+	{
+		return sAsyncLogging;
+	}
+
+	void flushLog()
+	{
+		// The logger thread needs the Settings lock to write anything.
+		if (!sAsyncLogging || tIsLogThread || Settings::get().isSelfLocked())
+		{
+			return;
+		}
+		U32 pushed = sLogQueue.getPushed();
+		while (sAsyncLogging && (S32)(sLogQueue.getWritten() - pushed) < 0)
+		{
+			ms_sleep(1);
 		}
 	}
 }
@@ -1370,9 +1720,16 @@ namespace LLError
 		const size_t BUF_SIZE = 64;
 		char time_str[BUF_SIZE];	/* Flawfinder: ignore */
 		
+		// Called by every thread that queues a message, see Log::flush().
+		struct tm utc;
+#if LL_WINDOWS
+		gmtime_s(&utc, &now);
+#else
+		gmtime_r(&now, &utc);
+#endif
 		int chars = strftime(time_str, BUF_SIZE, 
 								  "%Y-%m-%dT%H:%M:%SZ",
-								  gmtime(&now));
+								  &utc);
 
 		return chars ? time_str : "time error";
 	}
@@ -145,6 +145,10 @@ namespace LLError
 		virtual void recordMessage(LLError::ELevel, const std::string& message) = 0;
 			// use the level for better display, not for filtering
 
+		virtual void flush();
+			// called after one or more messages were recorded; recorders that
+			// buffer their output should write it out here
+
 		bool wantsTime();
 		bool wantsTags();
 		bool wantsLevel();
@@ -178,6 +182,19 @@ namespace LLError
 	LL_COMMON_API std::string logFileName();
 		// returns name of current logging file, empty string if none
 
+	LL_COMMON_API void setAsyncLogging(bool async);
+		// When enabled, messages are queued and a logger thread hands them to
+		// the recorders in batches, so the logging thread doesn't wait for file
+		// writes. Errors first wait for the queue to drain and are then recorded
+		// synchronously, before the fatal function is called. Time stamps are
+		// taken when the logger thread writes the message. Main thread only,
+		// needs APR to be initialized.
+		// Disabling waits up to two seconds for the logger thread. If it is
+		// stuck in a recorder, enabling again does nothing until it stopped.
+	LL_COMMON_API bool getAsyncLogging();
+	LL_COMMON_API void flushLog();
+		// waits until every message queued so far has been recorded
+
 
 	/*
 		Utilities for use by the unit tests of LLError itself.
@@ -0,0 +1,300 @@
+/** 
+ * @file lleventchannel.h
+ * @brief Typed event channels for events posted at a high rate.
+ *
+ * $LicenseInfo:firstyear=2004&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLEVENTCHANNEL_H
+#define LL_LLEVENTCHANNEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+// LLEventChannel<EVENT> is a typed counterpart of LLEventStream for events that
+// are posted very often (every frame and the like). Posting passes the event by
+// reference straight to the listeners: nothing is boxed into an LLSD, nothing
+// is allocated and no lock is taken.
+//
+// The listener list is copy-on-write. listen() and disconnect() build a new
+// list under a mutex and publish it; post() walks whatever list was current
+// when it started. Lists and listeners that were replaced are freed by a later
+// listen() or disconnect() once no post() is running. Any thread may post and
+// any thread may connect or disconnect, also from inside a listener.
+//
+// As with LLEventPump, a listener returns true to stop the event from reaching
+// the listeners after it. Listeners are called in the order they connected.
+//
+// Example Usage:
+//  struct LLFooEvent { S32 mCount; };
+//  LLEventChannel<LLFooEvent> gFooChannel;
+//  LLEventChannel<LLFooEvent>::ScopedConnection c(gFooChannel.listen("bar", boost::bind(&Bar::onFoo, this, _1)));
+//  gFooChannel.post(LLFooEvent{ 1 });
+
+template<typename EVENT>
+class LLEventChannel : boost::noncopyable
+{
+public:
+	typedef EVENT event_type;
+	typedef boost::function<bool(const EVENT&)> listener_t;
+
+private:
+	struct Slot
+	{
+		Slot(const std::string& name, const listener_t& listener, U32 id) :
+			mName(name), mListener(listener), mID(id), mConnected(true) { }
+
+		std::string mName;
+		listener_t mListener;
+		U32 mID;
+		std::atomic<bool> mConnected;	// Cleared by disconnect(), so a post() in progress skips it.
+	};
+	typedef std::vector<Slot*> slot_list_t;
+
+	struct Impl
+	{
+		Impl() : mListeners(new slot_list_t), mActivePosts(0), mNextID(1) { }
+		~Impl()
+		{
+			reclaim();
+			slot_list_t* listeners = mListeners.load();
+			for (typename slot_list_t::iterator it = listeners->begin(); it != listeners->end(); ++it)
+			{
+				delete *it;
+			}
+			delete listeners;
+		}
+
+		bool post(const EVENT& event)
+		{
+			// Announce the post before loading the list: a writer that sees
+			// mActivePosts == 0 after publishing a new list knows nobody can
+			// still be looking at the old one.
+			mActivePosts.fetch_add(1);
+			const slot_list_t* listeners = mListeners.load();
+			bool handled = false;
+			for (typename slot_list_t::const_iterator it = listeners->begin(); it != listeners->end(); ++it)
+			{
+				Slot* slot = *it;
+				if (slot->mConnected.load(std::memory_order_acquire) && slot->mListener(event))
+				{
+					handled = true;
+					break;
+				}
+			}
+			mActivePosts.fetch_sub(1);
+			return handled;
+		}
+
+		U32 listen(const std::string& name, const listener_t& listener)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			slot_list_t* old_listeners = mListeners.load();
+			slot_list_t* listeners = new slot_list_t;
+			listeners->reserve(old_listeners->size() + 1);
+			*listeners = *old_listeners;
+			U32 id = mNextID++;
+			listeners->push_back(new Slot(name, listener, id));
+			publish(listeners);
+			return id;
+		}
+
+		bool disconnect(U32 id)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			slot_list_t* old_listeners = mListeners.load();
+			for (typename slot_list_t::iterator it = old_listeners->begin(); it != old_listeners->end(); ++it)
+			{
+				if ((*it)->mID == id)
+				{
+					remove(it);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool disconnect(const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			slot_list_t* old_listeners = mListeners.load();
+			for (typename slot_list_t::iterator it = old_listeners->begin(); it != old_listeners->end(); ++it)
+			{
+				if ((*it)->mName == name)
+				{
+					remove(it);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool connected(U32 id) const
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			const slot_list_t* listeners = mListeners.load();
+			for (typename slot_list_t::const_iterator it = listeners->begin(); it != listeners->end(); ++it)
+			{
+				if ((*it)->mID == id)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		size_t size() const
+		{
+			return mListeners.load()->size();
+		}
+
+	private:
+		// Called with mMutex locked.
+		void remove(typename slot_list_t::iterator it)
+		{
+			Slot* slot = *it;
+			slot->mConnected.store(false, std::memory_order_release);
+			slot_list_t* old_listeners = mListeners.load();
+			slot_list_t* listeners = new slot_list_t;
+			listeners->reserve(old_listeners->size() - 1);
+			listeners->insert(listeners->end(), old_listeners->begin(), it);
+			listeners->insert(listeners->end(), it + 1, old_listeners->end());
+			mRetiredSlots.push_back(slot);
+			publish(listeners);
+		}
+
+		// Called with mMutex locked.
+		void publish(slot_list_t* listeners)
+		{
+			mRetiredLists.push_back(mListeners.exchange(listeners));
+			if (mActivePosts.load() == 0)
+			{
+				reclaim();
+			}
+		}
+
+		void reclaim()
+		{
+			for (typename slot_list_t::iterator it = mRetiredSlots.begin(); it != mRetiredSlots.end(); ++it)
+			{
+				delete *it;
+			}
+			mRetiredSlots.clear();
+			for (typename std::vector<slot_list_t*>::iterator it = mRetiredLists.begin(); it != mRetiredLists.end(); ++it)
+			{
+				delete *it;
+			}
+			mRetiredLists.clear();
+		}
+
+		std::atomic<slot_list_t*> mListeners;
+		std::atomic<S32> mActivePosts;
+		mutable std::mutex mMutex;			// Serializes writers.
+		U32 mNextID;
+		slot_list_t mRetiredSlots;
+		std::vector<slot_list_t*> mRetiredLists;
+	};
+
+public:
+	// A handle to one listener. Copyable; it does not disconnect by itself and
+	// it is safe to use after the channel was destroyed.
+	class Connection
+	{
+	public:
+		Connection() : mID(0) { }
+		Connection(const boost::shared_ptr<Impl>& impl, U32 id) : mImpl(impl), mID(id) { }
+
+		bool connected() const
+		{
+			boost::shared_ptr<Impl> impl = mImpl.lock();
+			return impl && impl->connected(mID);
+		}
+
+		void disconnect()
+		{
+			boost::shared_ptr<Impl> impl = mImpl.lock();
+			if (impl)
+			{
+				impl->disconnect(mID);
+			}
+			mImpl.reset();
+		}
+
+	private:
+		boost::weak_ptr<Impl> mImpl;
+		U32 mID;
+	};
+
+	// Disconnects when it goes out of scope, like LLTempBoundListener.
+	class ScopedConnection : public Connection, boost::noncopyable
+	{
+	public:
+		ScopedConnection() { }
+		ScopedConnection(const Connection& connection) : Connection(connection) { }
+		~ScopedConnection() { this->disconnect(); }
+
+		ScopedConnection& operator=(const Connection& connection)
+		{
+			this->disconnect();
+			Connection::operator=(connection);
+			return *this;
+		}
+	};
+
+	LLEventChannel() : mImpl(new Impl) { }
+
+	// Returns true if a listener handled the event.
+	bool post(const EVENT& event) { return mImpl->post(event); }
+
+	// name is only used by stopListening(); it need not be unique.
+	Connection listen(const std::string& name, const listener_t& listener)
+	{
+		return Connection(mImpl, mImpl->listen(name, listener));
+	}
+
+	// Disconnects the first listener called name. Returns false if there is none.
+	bool stopListening(const std::string& name) { return mImpl->disconnect(name); }
+
+	size_t getListenerCount() const { return mImpl->size(); }
+
+private:
+	boost::shared_ptr<Impl> mImpl;
+};
+
+// Posted by the viewer main loop once per frame, right before the LLSD
+// "mainloop" LLEventPump. Listeners that only need the tick should use this.
+struct LL_COMMON_API LLMainloopEvent
+{
+	U32 mFrameCount;
+
+	static LLEventChannel<LLMainloopEvent>& channel();
+};
+
+#endif // LL_LLEVENTCHANNEL_H
@@ -79,8 +79,7 @@ void LLEventTimeoutBase::actionAfter(F32 seconds, const Action& action)
     mAction = action;
     if (! mMainloop.connected())
     {
-        LLEventPump& mainloop(LLEventPumps::instance().obtain("mainloop"));
-        mMainloop = mainloop.listen(getName(), boost::bind(&LLEventTimeoutBase::tick, this, _1));
+        mMainloop = LLMainloopEvent::channel().listen(getName(), boost::bind(&LLEventTimeoutBase::tick, this, _1));
     }
 }
 
@@ -137,7 +136,7 @@ void LLEventTimeoutBase::cancel()
     mMainloop.disconnect();
 }
 
-bool LLEventTimeoutBase::tick(const LLSD&)
+bool LLEventTimeoutBase::tick(const LLMainloopEvent&)
 {
     if (countdownElapsed())
     {
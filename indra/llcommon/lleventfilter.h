@@ -30,6 +30,7 @@
 #define LL_LLEVENTFILTER_H
 
 #include "llevents.h"
+#include "lleventchannel.h"
 #include "stdtypes.h"
 #include "lltimer.h"
 
@@ -115,8 +116,8 @@ public:
      * @endcode
      *
      * @NOTE
-     * The implementation relies on frequent events on the LLEventPump named
-     * "mainloop".
+     * The implementation relies on frequent events on
+     * LLMainloopEvent::channel().
      */
     void actionAfter(F32 seconds, const Action& action);
 
@@ -181,9 +182,9 @@ protected:
     virtual bool countdownElapsed() const = 0;
 
 private:
-    bool tick(const LLSD&);
+    bool tick(const LLMainloopEvent&);
 
-    LLBoundListener mMainloop;
+    LLEventChannel<LLMainloopEvent>::ScopedConnection mMainloop;
     Action mAction;
 };
 
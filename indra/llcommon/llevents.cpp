@@ -35,6 +35,7 @@
 
 // associated header
 #include "llevents.h"
+#include "lleventchannel.h"
 // STL headers
 #include <set>
 #include <sstream>
@@ -77,25 +78,23 @@ const char* queue_names[] =
 };
 
 /*****************************************************************************
-*   If there's a "mainloop" pump, listen on that to flush all LLEventQueues
+*   Listen on the mainloop channel to flush all LLEventQueues
 *****************************************************************************/
-struct RegisterFlush : public LLEventTrackable
+struct RegisterFlush
 {
     RegisterFlush():
-        pumps(LLEventPumps::instance())
+        pumps(LLEventPumps::instance()),
+        connection(LLMainloopEvent::channel().listen("flushLLEventQueues", boost::bind(&RegisterFlush::flush, this, _1)))
     {
-        pumps.obtain("mainloop").listen("flushLLEventQueues", boost::bind(&RegisterFlush::flush, this, _1));
     }
-    bool flush(const LLSD&)
+    bool flush(const LLMainloopEvent&)
     {
         pumps.flush();
         return false;
     }
-    ~RegisterFlush()
-    {
-        // LLEventTrackable handles stopListening for us.
-    }
     LLEventPumps& pumps;
+    // Disconnects when registerFlush is destroyed.
+    LLEventChannel<LLMainloopEvent>::ScopedConnection connection;
 };
 static RegisterFlush registerFlush;
 
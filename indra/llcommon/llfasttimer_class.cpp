@@ -38,7 +38,8 @@
 //
 // First of all, absolutely nothing in this code is even remotely thread-safe:
 // FastTimers should only be used from the main thread and never from another
-// thread.
+// thread. (Since LLFastTimerTrace, an LLFastTimer constructed on another thread
+// skips everything below and only records a trace event, if tracing).
 //
 // NamedTimerFactory is a singleton, accessed through NamedTimerFactory::instance().
 //
@@ -396,6 +397,21 @@ std::string LLFastTimer::sClockType = "QueryPerformanceCounter";
 #error "Platform not supported"
 #endif
 
+bool LLFastTimer::startTrace(DeclareTimer& timer)
+{
+	if (LLFastTimerTrace::isTracing())
+	{
+		mTraceName = timer.mTimer.getName().c_str();
+		mTraceStart = get_clock_count();
+	}
+	if (!AIThreadID::in_main_thread())
+	{
+		mFrameState = NULL;
+		return false;
+	}
+	return true;
+}
+
 //static
 U64 LLFastTimer::countsPerSecond() // counts per second for the *32-bit* timer
 {
@@ -927,7 +943,9 @@ const LLFastTimer::NamedTimer* LLFastTimer::getTimerByName(const std::string& na
 }
 
 LLFastTimer::LLFastTimer(LLFastTimer::FrameState* state)
-:	mFrameState(state)
+:	mFrameState(state),
+	mTraceName(NULL),
+	mTraceStart(0)
 {
 	// Only called for mAppTimer with mRootFrameState, which never invalidates.
 	llassert(state == &NamedTimerFactory::instance().getRootFrameState());
@@ -28,6 +28,8 @@
 #define LL_FASTTIMER_CLASS_H
 
 #include "llinstancetracker.h"
+#include "llfasttimertrace.h"
+#include "aithreadid.h"
 
 #define FAST_TIMER_ON 1
 #define TIME_FAST_TIMERS 0
@@ -155,8 +157,17 @@ public:
 	LLFastTimer(LLFastTimer::FrameState* state);
 
 	LL_FORCE_INLINE LLFastTimer(LLFastTimer::DeclareTimer& timer)
-	:	mFrameState(timer.mFrameState)
+	:	mFrameState(timer.mFrameState),
+		mTraceName(NULL),
+		mTraceStart(0)
 	{
+		if (LL_UNLIKELY(LLFastTimerTrace::isTracing() || !AIThreadID::in_main_thread()))
+		{
+			if (!startTrace(timer))
+			{
+				return;
+			}
+		}
 #if TIME_FAST_TIMERS
 		U64 timer_start = getCPUClockCount64();
 #endif
@@ -179,16 +190,19 @@ public:
 #if TIME_FAST_TIMERS
 		U64 timer_end = getCPUClockCount64();
 		sTimerCycles += timer_end - timer_start;
-#endif
-#if DEBUG_FAST_TIMER_THREADS
-#if !LL_RELEASE
-		assert_main_thread();
-#endif
 #endif
 	}
 
 	LL_FORCE_INLINE ~LLFastTimer()
 	{
+		if (LL_UNLIKELY(mTraceName != NULL))
+		{
+			LLFastTimerTrace::record(mTraceName, mTraceStart, get_clock_count());
+		}
+		if (LL_UNLIKELY(mFrameState == NULL))
+		{
+			return;	// Traced on another thread.
+		}
 #if TIME_FAST_TIMERS
 		U64 timer_start = getCPUClockCount64();
 #endif
@@ -261,6 +275,11 @@ public:
 	static std::string sClockType;
 
 private:
+	// Starts the trace event for this scope, if tracing. Returns false when called
+	// off the main thread: other threads are only traced, the frame statistics
+	// belong to the main thread.
+	bool startTrace(DeclareTimer& timer);
+
 	static U32 getCPUClockCount32();
 	static U64 getCPUClockCount64();
 
@@ -272,6 +291,8 @@ private:
 	U32							mStartTime;
 	LLFastTimer::FrameState*	mFrameState;
 	LLFastTimer::CurTimerData	mLastTimerData;
+	char const*					mTraceName;
+	U64							mTraceStart;
 
 };
 
@@ -0,0 +1,363 @@
+/**
+ * @file llfasttimertrace.cpp
+ * @brief Per-thread fast timer event buffers with Chrome trace export.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llfasttimertrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+
+#include "llfile.h"
+#include "llthread.h"
+
+namespace
+{
+
+// Per-thread ring size; must be a power of two. At ~24 bytes per event this is
+// 384 kB per recording thread and several frames worth of main thread timers.
+const U32 RING_SIZE = 16384;
+const U32 RING_MASK = RING_SIZE - 1;
+const U32 WRITER_SLEEP_MS = 20;
+const S32 MAX_THREAD_NAME = 64;
+
+struct TraceEvent
+{
+	char const* mName;
+	U64 mStart;
+	U64 mEnd;
+};
+
+// Single producer (the owning thread), single consumer (the writer thread).
+struct TraceRing
+{
+	TraceRing(U32 thread_id, char const* name) : mHead(0), mTail(0), mExited(false), mThreadID(thread_id), mNameWritten(false)
+	{
+		strncpy(mName, name, MAX_THREAD_NAME - 1);
+		mName[MAX_THREAD_NAME - 1] = '\0';
+	}
+
+	TraceEvent mEvents[RING_SIZE];
+	std::atomic<U32> mHead;			// Next slot the owning thread writes.
+	std::atomic<U32> mTail;			// Next slot the writer reads.
+	std::atomic<bool> mExited;		// Owning thread is gone; free once drained.
+	U32 mThreadID;
+	char mName[MAX_THREAD_NAME];
+	bool mNameWritten;				// Writer thread only.
+};
+
+typedef std::vector<TraceRing*> ring_list_t;
+
+ll_thread_local TraceRing* tRing;
+ll_thread_local char tThreadName[MAX_THREAD_NAME];
+
+LLMutex* sRingsMutex;				// Protects sRings. Created by the first start().
+ring_list_t sRings;
+ring_list_t sDrainRings;			// Writer thread only.
+ring_list_t sDrainedExitedRings;	// Writer thread only.
+std::atomic<U32> sNextThreadID(1);
+std::atomic<U32> sDroppedEvents(0);
+
+// Only touched by the main thread while the writer is not running, or by the writer.
+llofstream sFile;
+bool sFirstEvent;
+U64 sBaseCount;
+F64 sMicrosPerCount;
+
+void write_json_string(std::ostream& os, char const* str)
+{
+	os << '"';
+	for (char const* p = str; *p; ++p)
+	{
+		char c = *p;
+		if (c == '"' || c == '\\')
+		{
+			os << '\\' << c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (S32)c << std::dec << std::setfill(' ');
+		}
+		else
+		{
+			os << c;
+		}
+	}
+	os << '"';
+}
+
+void begin_event()
+{
+	if (!sFirstEvent)
+	{
+		sFile << ",\n";
+	}
+	sFirstEvent = false;
+}
+
+F64 to_micros(U64 count)
+{
+	return count > sBaseCount ? (F64)(count - sBaseCount) * sMicrosPerCount : 0.0;
+}
+
+// Writes everything currently buffered and frees the rings of exited threads.
+// The file is written without holding sRingsMutex, so threads that start or exit
+// meanwhile don't wait for it. That is safe because rings are only freed here
+// while the writer runs.
+void drain_rings()
+{
+	{
+		LLMutexLock lock(sRingsMutex);
+		sDrainRings = sRings;
+	}
+	for (ring_list_t::iterator iter = sDrainRings.begin(); iter != sDrainRings.end(); ++iter)
+	{
+		TraceRing* ring = *iter;
+		// Read the flag before the head, so that all events of an exited thread are seen.
+		bool exited = ring->mExited.load(std::memory_order_acquire);
+		U32 tail = ring->mTail.load(std::memory_order_relaxed);
+		U32 head = ring->mHead.load(std::memory_order_acquire);
+		if (!ring->mNameWritten && (head != tail || !exited))
+		{
+			begin_event();
+			sFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->mThreadID << ",\"args\":{\"name\":";
+			write_json_string(sFile, ring->mName);
+			sFile << "}}";
+			ring->mNameWritten = true;
+		}
+		for (; tail != head; ++tail)
+		{
+			TraceEvent const& event = ring->mEvents[tail & RING_MASK];
+			F64 start = to_micros(event.mStart);
+			F64 end = to_micros(event.mEnd);
+			begin_event();
+			sFile << "{\"name\":";
+			write_json_string(sFile, event.mName);
+			sFile << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->mThreadID
+				  << ",\"ts\":" << start << ",\"dur\":" << (end > start ? end - start : 0.0) << "}";
+		}
+		ring->mTail.store(tail, std::memory_order_release);
+		if (exited)
+		{
+			sDrainedExitedRings.push_back(ring);
+		}
+	}
+	if (!sDrainedExitedRings.empty())
+	{
+		LLMutexLock lock(sRingsMutex);
+		for (ring_list_t::iterator iter = sDrainedExitedRings.begin(); iter != sDrainedExitedRings.end(); ++iter)
+		{
+			sRings.erase(std::find(sRings.begin(), sRings.end(), *iter));
+			delete *iter;
+		}
+		sDrainedExitedRings.clear();
+	}
+}
+
+class LLFastTimerTraceWriter : public LLThread
+{
+public:
+	LLFastTimerTraceWriter() : LLThread("Fast timer trace writer") { }
+
+	/*virtual*/ void run()
+	{
+		while (!isQuitting())
+		{
+			ms_sleep(WRITER_SLEEP_MS);
+			drain_rings();
+			sFile.flush();
+		}
+		drain_rings();
+	}
+};
+
+LLFastTimerTraceWriter* sWriter;
+
+TraceRing* create_ring()
+{
+	if (!tThreadName[0])
+	{
+		strcpy(tThreadName, AIThreadID::in_main_thread() ? "main" : "thread");
+	}
+	TraceRing* ring = new TraceRing(sNextThreadID++, tThreadName);
+	// Publish before locking: contention on the mutex from the main thread runs a
+	// fast timer of its own, which must find this ring rather than create another.
+	tRing = ring;
+	LLMutexLock lock(sRingsMutex);
+	sRings.push_back(ring);
+	return ring;
+}
+
+} // namespace
+
+std::atomic<bool> LLFastTimerTrace::sEnabled(false);
+
+//static
+bool LLFastTimerTrace::start(std::string const& filename)
+{
+	assert_main_thread();
+	if (sEnabled)
+	{
+		return true;
+	}
+
+	sFile.open(filename.c_str(), std::ios::out | std::ios::trunc);
+	if (!sFile.is_open())
+	{
+		LL_WARNS() << "Unable to open fast timer trace file " << filename << LL_ENDL;
+		return false;
+	}
+	sFile << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+	sFirstEvent = true;
+
+	if (!sRingsMutex)
+	{
+		sRingsMutex = new LLMutex;
+	}
+	{
+		// Forget anything recorded after the previous stop().
+		LLMutexLock lock(sRingsMutex);
+		for (ring_list_t::iterator iter = sRings.begin(); iter != sRings.end(); ++iter)
+		{
+			(*iter)->mTail.store((*iter)->mHead.load(std::memory_order_acquire), std::memory_order_release);
+			(*iter)->mNameWritten = false;
+		}
+	}
+	sDroppedEvents = 0;
+	sBaseCount = get_clock_count();
+	sMicrosPerCount = 1000000.0 / calc_clock_frequency();
+
+	{
+		LLMutexLock lock(sRingsMutex);
+		sWriter = new LLFastTimerTraceWriter;
+	}
+	sWriter->start();
+	sEnabled = true;
+
+	LL_INFOS() << "Fast timer trace started: " << filename << LL_ENDL;
+	return true;
+}
+
+//static
+void LLFastTimerTrace::stop()
+{
+	assert_main_thread();
+	if (!sEnabled)
+	{
+		return;
+	}
+	sEnabled = false;
+
+	sWriter->setQuitting();
+	while (!sWriter->isStopped())
+	{
+		ms_sleep(1);
+	}
+	{
+		LLMutexLock lock(sRingsMutex);
+		delete sWriter;
+		sWriter = NULL;
+		// Threads that exited after the last drain.
+		for (ring_list_t::iterator iter = sRings.begin(); iter != sRings.end();)
+		{
+			if ((*iter)->mExited.load(std::memory_order_acquire))
+			{
+				delete *iter;
+				iter = sRings.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+	}
+
+	sFile << "\n]}\n";
+	sFile.close();
+
+	LL_INFOS() << "Fast timer trace stopped, " << sDroppedEvents << " events dropped." << LL_ENDL;
+}
+
+//static
+void LLFastTimerTrace::record(char const* name, U64 start, U64 end)
+{
+	if (!sEnabled)
+	{
+		return;
+	}
+	TraceRing* ring = tRing;
+	if (!ring)
+	{
+		ring = create_ring();
+	}
+	U32 head = ring->mHead.load(std::memory_order_relaxed);
+	if (head - ring->mTail.load(std::memory_order_acquire) >= RING_SIZE)
+	{
+		++sDroppedEvents;
+		return;
+	}
+	TraceEvent& event = ring->mEvents[head & RING_MASK];
+	event.mName = name;
+	event.mStart = start;
+	event.mEnd = end;
+	ring->mHead.store(head + 1, std::memory_order_release);
+}
+
+//static
+void LLFastTimerTrace::setThreadName(std::string const& name)
+{
+	strncpy(tThreadName, name.c_str(), MAX_THREAD_NAME - 1);
+	tThreadName[MAX_THREAD_NAME - 1] = '\0';
+}
+
+//static
+void LLFastTimerTrace::threadExit()
+{
+	TraceRing* ring = tRing;
+	if (!ring)
+	{
+		return;
+	}
+	tRing = NULL;
+	LLMutexLock lock(sRingsMutex);
+	if (sWriter)
+	{
+		// The writer frees it once everything is written.
+		ring->mExited.store(true, std::memory_order_release);
+	}
+	else
+	{
+		sRings.erase(std::find(sRings.begin(), sRings.end(), ring));
+		delete ring;
+	}
+}
+
+//static
+U32 LLFastTimerTrace::getDroppedEvents()
+{
+	return sDroppedEvents;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file llfasttimertrace.h
+ * @brief Per-thread fast timer event buffers with Chrome trace export.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFASTTIMERTRACE_H
+#define LL_LLFASTTIMERTRACE_H
+
+#include <atomic>
+#include <string>
+#include "stdtypes.h"
+#include "llpreprocessor.h"
+#include "lltimer.h"
+
+// Records fast timer scopes from any thread into per-thread ring buffers and
+// streams them to a Chrome trace (chrome://tracing, Perfetto) JSON file.
+//
+// Every thread that records gets its own single producer, single consumer ring,
+// so recording never takes a lock. A background writer thread drains the rings
+// and appends complete ("X") events to the file. When a ring is full the event
+// is dropped and counted rather than blocking the recording thread.
+class LL_COMMON_API LLFastTimerTrace
+{
+public:
+	// Checked inline by LLFastTimer, through isTracing(); only written by start() and stop().
+	static std::atomic<bool> sEnabled;
+
+	// Opens 'filename' and starts the writer thread. Main thread only.
+	static bool start(std::string const& filename);
+	// Flushes all buffered events, closes the file and stops the writer. Main thread only.
+	static void stop();
+	static bool isTracing() { return sEnabled.load(std::memory_order_relaxed); }
+
+	// Records one scope on the calling thread. 'name' must stay valid for the
+	// lifetime of the trace (timer names and string literals do).
+	// 'start' and 'end' are get_clock_count() values.
+	static void record(char const* name, U64 start, U64 end);
+
+	// Name shown for the calling thread in the trace; called by LLThread.
+	static void setThreadName(std::string const& name);
+	// Releases the calling thread's ring; called by LLThread when run() returns.
+	static void threadExit();
+
+	// Number of events dropped because a ring was full, since start().
+	static U32 getDroppedEvents();
+};
+
+// Traces the enclosing scope on any thread while tracing is enabled.
+// 'name' must be a string literal.
+class LLTraceScope
+{
+public:
+	LLTraceScope(char const* name) : mName(NULL)
+	{
+		if (LL_UNLIKELY(LLFastTimerTrace::isTracing()))
+		{
+			mName = name;
+			mStart = get_clock_count();
+		}
+	}
+	~LLTraceScope()
+	{
+		if (LL_UNLIKELY(mName != NULL))
+		{
+			LLFastTimerTrace::record(mName, mStart, get_clock_count());
+		}
+	}
+
+private:
+	char const* mName;
+	U64 mStart;
+};
+
+#define LL_TRACE_SCOPE(name) LLTraceScope LL_GLUE_TOKENS(trace_scope, __LINE__)(name)
+
+#endif // LL_LLFASTTIMERTRACE_H
@@ -262,6 +262,7 @@ namespace
 	{
 	public:
 		ImplString(const LLSD::String& v) : Base(v) { }
+		ImplString(LLSD::String&& v) : Base(LLSD::String()) { mValue.swap(v); }
 				
 		virtual LLSD::Boolean	asBoolean() const	{ return !mValue.empty(); }
 		virtual LLSD::Integer	asInteger() const;
@@ -349,6 +350,7 @@ namespace
 	{
 	public:
 		ImplBinary(const LLSD::Binary& v) : Base(v) { }
+		ImplBinary(LLSD::Binary&& v) : Base(LLSD::Binary()) { mValue.swap(v); }
 				
 		virtual const LLSD::Binary&	asBinary() const{ return mValue; }
 	};
@@ -818,6 +820,8 @@ LLSD::LLSD(const String& v) : impl(0)	{ ALLOC_LLSD_OBJECT;	assign(v); }
 LLSD::LLSD(const Date& v) : impl(0)		{ ALLOC_LLSD_OBJECT;	assign(v); }
 LLSD::LLSD(const URI& v) : impl(0)		{ ALLOC_LLSD_OBJECT;	assign(v); }
 LLSD::LLSD(const Binary& v) : impl(0)	{ ALLOC_LLSD_OBJECT;	assign(v); }
+LLSD::LLSD(String&& v) : impl(0)		{ ALLOC_LLSD_OBJECT;	Impl::reset(impl, new ImplString(std::move(v))); }
+LLSD::LLSD(Binary&& v) : impl(0)		{ ALLOC_LLSD_OBJECT;	Impl::reset(impl, new ImplBinary(std::move(v))); }
 
 // Convenience Constructors
 LLSD::LLSD(F32 v) : impl(0)				{ ALLOC_LLSD_OBJECT;	assign((Real)v); }
@@ -189,6 +189,9 @@ public:
 		LLSD(const Date&);
 		LLSD(const URI&);
 		LLSD(const Binary&);
+		// These take over the contents of v instead of copying it.
+		LLSD(String&& v);
+		LLSD(Binary&& v);
 	//@}
 
 	/** @name Convenience Constructors */
@@ -30,6 +30,8 @@
 #define LL_LLSDSERIALIZE_H
 
 #include <iosfwd>
+#include <utility>
+#include <vector>
 #include "llpointer.h"
 #include "llrefcount.h"
 #include "llsd.h"
@@ -812,6 +814,33 @@ public:
 		(void)p->parse(str, sd, max_bytes);
 		return sd;
 	}
+
+	/*
+	 * In-memory parsing (see llsdserialize_span.cpp)
+	 *
+	 * These parse binary, notation or XML LLSD straight out of memory, without
+	 * an istream in between, so every byte isn't a virtual streambuf call and
+	 * strings and blobs are copied once, into the resulting LLSD. The data may
+	 * be split over several segments, like the segments of an LLBufferArray
+	 * channel (see LLBufferArray::getChannelSegments). Length fields can't ask
+	 * for more than what is left of the data, so no max_bytes is needed.
+	 * Binary and notation nested more than 128 deep fail to parse.
+	 *
+	 * XML goes through a pull parser that knows only the LLSD schema; a
+	 * document it can't handle is passed on to LLSDXMLParser, so the result
+	 * is always the same as fromXML() on a stream.
+	 *
+	 * They return the number of LLSD objects parsed, or
+	 * LLSDParser::PARSE_FAILURE. If consumed is not NULL it is set to the
+	 * number of bytes parsed.
+	 */
+	typedef std::vector<std::pair<const U8*, size_t> > segments_t;
+	static S32 fromBinary(LLSD& sd, const U8* data, size_t size, size_t* consumed = NULL);
+	static S32 fromBinary(LLSD& sd, const segments_t& segments, size_t* consumed = NULL);
+	static S32 fromNotation(LLSD& sd, const U8* data, size_t size, size_t* consumed = NULL);
+	static S32 fromNotation(LLSD& sd, const segments_t& segments, size_t* consumed = NULL);
+	static S32 fromXML(LLSD& sd, const U8* data, size_t size, size_t* consumed = NULL, bool emit_errors = true);
+	static S32 fromXML(LLSD& sd, const segments_t& segments, size_t* consumed = NULL, bool emit_errors = true);
 };
 
 //dirty little zip functions -- yell at davep
@@ -0,0 +1,1891 @@
+/** 
+ * @file llsdserialize_span.cpp
+ * @brief Binary, notation and XML LLSD parsers that read straight from memory.
+ *
+ * $LicenseInfo:firstyear=2004&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llsdserialize.h"
+
+#if !LL_WINDOWS
+#include <netinet/in.h> // ntohl
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+#include <boost/regex.hpp>
+
+#include "llbase64.h"
+#include "lldate.h"
+#include "llstring.h"
+#include "lluri.h"
+
+F64 ll_ntohd(F64 netdouble);	// In llsdserialize.cpp.
+
+namespace
+{
+
+// Maps and arrays nested deeper than this aren't parsed, so that a document
+// can't run the recursive parsers out of stack.
+const S32 MAX_NESTING = 128;
+
+// Reads a sequence of memory segments as one string of bytes.
+class LLSDSpanReader
+{
+public:
+	LLSDSpanReader(const LLSDSerialize::segments_t& segments)
+	:	mSegments(segments), mNext(0), mPos(NULL), mEnd(NULL), mRemaining(0), mConsumed(0)
+	{
+		for (size_t i = 0; i < segments.size(); ++i)
+		{
+			mRemaining += segments[i].second;
+		}
+		nextSegment();
+	}
+
+	bool eof() const { return mPos == mEnd; }
+	size_t remaining() const { return mRemaining; }
+	size_t consumed() const { return mConsumed; }
+
+	// Returns -1 at the end of the data.
+	int peek() const { return mPos != mEnd ? *mPos : -1; }
+	int get()
+	{
+		if (mPos == mEnd)
+		{
+			return -1;
+		}
+		int c = *mPos;
+		advance(1);
+		return c;
+	}
+
+	// The contiguous bytes at the read position.
+	const U8* data() const { return mPos; }
+	size_t available() const { return mEnd - mPos; }
+
+	// Skips n <= available() bytes.
+	void advance(size_t n)
+	{
+		mPos += n;
+		mRemaining -= n;
+		mConsumed += n;
+		if (mPos == mEnd)
+		{
+			nextSegment();
+		}
+	}
+
+	bool read(void* dest, size_t n)
+	{
+		if (n > mRemaining)
+		{
+			return false;
+		}
+		U8* out = (U8*)dest;
+		while (n)
+		{
+			size_t chunk = llmin(n, available());
+			memcpy(out, mPos, chunk);
+			out += chunk;
+			n -= chunk;
+			advance(chunk);
+		}
+		return true;
+	}
+
+	// Appends the next n bytes to a std::string or LLSD::Binary.
+	template <typename CONTAINER>
+	bool append(CONTAINER& out, size_t n)
+	{
+		if (n > mRemaining)
+		{
+			return false;
+		}
+		out.reserve(out.size() + n);
+		while (n)
+		{
+			size_t chunk = llmin(n, available());
+			out.insert(out.end(), mPos, mPos + chunk);
+			n -= chunk;
+			advance(chunk);
+		}
+		return true;
+	}
+
+private:
+	void nextSegment()
+	{
+		while (mPos == mEnd && mNext < mSegments.size())
+		{
+			mPos = mSegments[mNext].first;
+			mEnd = mPos + mSegments[mNext].second;
+			++mNext;
+		}
+	}
+
+	const LLSDSerialize::segments_t& mSegments;
+	size_t mNext;
+	const U8* mPos;
+	const U8* mEnd;
+	size_t mRemaining;
+	size_t mConsumed;
+};
+
+// Same as deserialize_string_delim() in llsdserialize.cpp: reads up to and including delim,
+// handling backslash escapes. Runs without escapes are appended in one go.
+bool read_delimited(LLSDSpanReader& reader, std::string& value, char delim)
+{
+	while (true)
+	{
+		const U8* start = reader.data();
+		size_t available = reader.available();
+		size_t run = 0;
+		while (run < available && start[run] != (U8)delim && start[run] != '\\')
+		{
+			++run;
+		}
+		value.append((const char*)start, run);
+		reader.advance(run);
+		if (run == available && !reader.eof())
+		{
+			// The run continues in the next segment.
+			continue;
+		}
+
+		int c = reader.get();
+		if (c < 0)
+		{
+			return false;
+		}
+		if (c == delim)
+		{
+			return true;
+		}
+		if (c == '\\' && !reader.eof())
+		{
+			c = reader.get();
+			switch (c)
+			{
+				case 'a': value += '\a'; break;
+				case 'b': value += '\b'; break;
+				case 'f': value += '\f'; break;
+				case 'n': value += '\n'; break;
+				case 'r': value += '\r'; break;
+				case 't': value += '\t'; break;
+				case 'v': value += '\v'; break;
+				case 'x':
+				{
+					int high = reader.get();
+					int low = reader.get();
+					if (low < 0)
+					{
+						return false;
+					}
+					value += (char)((hex_as_nybble((char)high) << 4) | hex_as_nybble((char)low));
+					break;
+				}
+				default: value += (char)c; break;
+			}
+		}
+	}
+}
+
+// Converts [+-]digits[.digits][e[+-]digits] with at least one mantissa digit,
+// to the same value as std::istream, without the decimal separator of the C
+// locale that strtod() follows. Returns false for anything else.
+bool text_to_real(const char* text, size_t len, F64& value)
+{
+	// Up to 15 significant digits and a power of ten up to 22 are exact
+	// doubles, so a single multiplication or division rounds correctly.
+	static const F64 powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+								  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	size_t i = 0;
+	bool negative = i < len && text[i] == '-';
+	if (i < len && (text[i] == '-' || text[i] == '+'))
+	{
+		++i;
+	}
+	U64 mantissa = 0;
+	S32 digits = 0;			// significant ones, in mantissa
+	S32 scale = 0;
+	bool any_digit = false;
+	bool fraction = false;
+	for ( ; i < len; ++i)
+	{
+		if (text[i] == '.' && !fraction)
+		{
+			fraction = true;
+			continue;
+		}
+		if (!isdigit((U8)text[i]))
+		{
+			break;
+		}
+		any_digit = true;
+		if (mantissa || text[i] != '0')
+		{
+			if (++digits <= 15)
+			{
+				mantissa = mantissa * 10 + (text[i] - '0');
+			}
+		}
+		if (fraction)
+		{
+			--scale;
+		}
+	}
+	if (any_digit && i < len && (text[i] == 'e' || text[i] == 'E'))
+	{
+		++i;
+		bool negative_exponent = i < len && text[i] == '-';
+		if (i < len && (text[i] == '-' || text[i] == '+'))
+		{
+			++i;
+		}
+		S32 exponent = 0;
+		size_t start = i;
+		for ( ; i < len && isdigit((U8)text[i]); ++i)
+		{
+			exponent = llmin(exponent * 10 + (text[i] - '0'), 100000);
+		}
+		any_digit = i > start;
+		scale += negative_exponent ? -exponent : exponent;
+	}
+	if (!any_digit || i != len)
+	{
+		return false;
+	}
+	if (digits > 15 || scale < -22 || scale > 22)
+	{
+		std::istringstream str(std::string(text, len));
+		str.imbue(std::locale::classic());
+		str >> value;
+		return !str.fail();
+	}
+	value = scale < 0 ? (F64)mantissa / powers[-scale] : (F64)mantissa * powers[scale];
+	if (negative)
+	{
+		value = -value;
+	}
+	return true;
+}
+
+// Reads up to, not including, delim or at most max_len bytes.
+std::string read_until(LLSDSpanReader& reader, char delim, size_t max_len)
+{
+	std::string token;
+	while (token.size() < max_len && !reader.eof() && reader.peek() != delim)
+	{
+		token += (char)reader.get();
+	}
+	return token;
+}
+
+class LLSDBinarySpanParser
+{
+public:
+	LLSDBinarySpanParser(LLSDSpanReader& reader) : mReader(reader), mDepth(0) { }
+
+	S32 parse(LLSD& data)
+	{
+		int c = mReader.get();
+		if (c < 0)
+		{
+			return 0;
+		}
+		S32 parse_count = 1;
+		switch (c)
+		{
+			case '{':
+			case '[':
+			{
+				S32 child_count = LLSDParser::PARSE_FAILURE;
+				if (mDepth < MAX_NESTING)
+				{
+					++mDepth;
+					child_count = (c == '{') ? parseMap(data) : parseArray(data);
+					--mDepth;
+				}
+				else
+				{
+					LL_INFOS() << "STREAM FAILURE: nested too deeply." << LL_ENDL;
+				}
+				parse_count = (child_count == LLSDParser::PARSE_FAILURE) ? LLSDParser::PARSE_FAILURE : parse_count + child_count;
+				break;
+			}
+			case '!':
+				data.clear();
+				break;
+			case '0':
+				data = false;
+				break;
+			case '1':
+				data = true;
+				break;
+			case 'i':
+			{
+				U32 value_nbo = 0;
+				if (!mReader.read(&value_nbo, sizeof(value_nbo)))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = (S32)ntohl(value_nbo);
+				break;
+			}
+			case 'r':
+			{
+				F64 real_nbo = 0.0;
+				if (!mReader.read(&real_nbo, sizeof(real_nbo)))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = ll_ntohd(real_nbo);
+				break;
+			}
+			case 'u':
+			{
+				LLUUID id;
+				if (!mReader.read(id.mData, UUID_BYTES))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = id;
+				break;
+			}
+			case '\'':
+			case '"':
+			{
+				std::string value;
+				if (!read_delimited(mReader, value, (char)c))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = LLSD(std::move(value));
+				break;
+			}
+			case 's':
+			{
+				std::string value;
+				if (!parseString(value))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = LLSD(std::move(value));
+				break;
+			}
+			case 'l':
+			{
+				std::string value;
+				if (!parseString(value))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = LLURI(value);
+				break;
+			}
+			case 'd':
+			{
+				// Dates are not byte swapped, see LLSDBinaryParser.
+				F64 real = 0.0;
+				if (!mReader.read(&real, sizeof(real)))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = LLDate(real);
+				break;
+			}
+			case 'b':
+			{
+				U32 size = 0;
+				LLSD::Binary value;
+				if (!readSize(size) || !mReader.append(value, size))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = LLSD(std::move(value));
+				break;
+			}
+			default:
+				parse_count = LLSDParser::PARSE_FAILURE;
+				LL_INFOS() << "Unrecognized character while parsing: int(" << c << ")" << LL_ENDL;
+				break;
+		}
+		if (parse_count == LLSDParser::PARSE_FAILURE)
+		{
+			data.clear();
+		}
+		return parse_count;
+	}
+
+private:
+	bool readSize(U32& size)
+	{
+		U32 size_nbo = 0;
+		if (!mReader.read(&size_nbo, sizeof(size_nbo)))
+		{
+			return false;
+		}
+		size = ntohl(size_nbo);
+		// A negative size as S32 (which is how LLSDBinaryParser reads it) means garbage.
+		return (S32)size >= 0;
+	}
+
+	bool parseString(std::string& value)
+	{
+		U32 size = 0;
+		return readSize(size) && mReader.append(value, size);
+	}
+
+	S32 parseMap(LLSD& map)
+	{
+		map = LLSD::emptyMap();
+		U32 size = 0;
+		if (!readSize(size))
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		S32 parse_count = 0;
+		U32 count = 0;
+		int c = mReader.get();
+		while (c != '}' && count < size && c >= 0)
+		{
+			std::string name;
+			switch (c)
+			{
+				case 'k':
+					if (!parseString(name))
+					{
+						return LLSDParser::PARSE_FAILURE;
+					}
+					break;
+				case '\'':
+				case '"':
+					if (!read_delimited(mReader, name, (char)c))
+					{
+						return LLSDParser::PARSE_FAILURE;
+					}
+					break;
+			}
+			LLSD child;
+			S32 child_count = parse(child);
+			if (child_count <= 0)
+			{
+				// There must be a value for every key.
+				return LLSDParser::PARSE_FAILURE;
+			}
+			parse_count += child_count;
+			map.insert(name, child);
+			++count;
+			c = mReader.get();
+		}
+		if (c != '}' || count < size)
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		return parse_count;
+	}
+
+	S32 parseArray(LLSD& array)
+	{
+		array = LLSD::emptyArray();
+		U32 size = 0;
+		if (!readSize(size))
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		S32 parse_count = 0;
+		U32 count = 0;
+		while (mReader.peek() != ']' && count < size && !mReader.eof())
+		{
+			LLSD child;
+			S32 child_count = parse(child);
+			if (child_count == LLSDParser::PARSE_FAILURE)
+			{
+				return LLSDParser::PARSE_FAILURE;
+			}
+			if (child_count)
+			{
+				parse_count += child_count;
+				array.append(child);
+			}
+			++count;
+		}
+		if (mReader.get() != ']' || count < size)
+		{
+			return LLSDParser::PARSE_FAILURE;
+		}
+		return parse_count;
+	}
+
+	LLSDSpanReader& mReader;
+	S32 mDepth;				// maps and arrays being parsed
+};
+
+class LLSDNotationSpanParser
+{
+public:
+	LLSDNotationSpanParser(LLSDSpanReader& reader) : mReader(reader), mDepth(0) { }
+
+	S32 parse(LLSD& data)
+	{
+		skipSpace();
+		int c = mReader.peek();
+		if (c < 0)
+		{
+			return 0;
+		}
+		S32 parse_count = 1;
+		switch (c)
+		{
+			case '{':
+			case '[':
+			{
+				S32 child_count = LLSDParser::PARSE_FAILURE;
+				if (mDepth < MAX_NESTING)
+				{
+					++mDepth;
+					child_count = (c == '{') ? parseMap(data) : parseArray(data);
+					--mDepth;
+				}
+				else
+				{
+					LL_INFOS() << "STREAM FAILURE: nested too deeply." << LL_ENDL;
+				}
+				parse_count = (child_count == LLSDParser::PARSE_FAILURE) ? LLSDParser::PARSE_FAILURE : parse_count + child_count;
+				break;
+			}
+			case '!':
+				mReader.get();
+				data.clear();
+				break;
+			case '0':
+				mReader.get();
+				data = false;
+				break;
+			case '1':
+				mReader.get();
+				data = true;
+				break;
+			case 'F':
+			case 'f':
+				mReader.get();
+				if (!parseBoolean("false"))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+				}
+				data = false;
+				break;
+			case 'T':
+			case 't':
+				mReader.get();
+				if (!parseBoolean("true"))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+				}
+				data = true;
+				break;
+			case 'i':
+			{
+				mReader.get();
+				skipSpace();
+				std::string token = readToken("+-0123456789");
+				char* end = NULL;
+				errno = 0;
+				long value = strtol(token.c_str(), &end, 10);
+				if (token.empty() || *end || errno == ERANGE || value < S32_MIN || value > S32_MAX)
+				{
+					LL_INFOS() << "STREAM FAILURE reading integer." << LL_ENDL;
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = (S32)value;
+				break;
+			}
+			case 'r':
+			{
+				mReader.get();
+				skipSpace();
+				std::string token = readToken("+-.0123456789eE");
+				F64 value;
+				if (!text_to_real(token.data(), token.size(), value))
+				{
+					LL_INFOS() << "STREAM FAILURE reading real." << LL_ENDL;
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = value;
+				break;
+			}
+			case 'u':
+			{
+				mReader.get();
+				skipSpace();
+				char uuid[UUID_STR_LENGTH - 1];
+				LLUUID id;
+				if (!mReader.read(uuid, sizeof(uuid)) || !id.set(std::string(uuid, sizeof(uuid))))
+				{
+					LL_INFOS() << "STREAM FAILURE reading uuid." << LL_ENDL;
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = id;
+				break;
+			}
+			case '"':
+			case '\'':
+			case 's':
+			{
+				std::string value;
+				if (!parseString(value))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				data = LLSD(std::move(value));
+				break;
+			}
+			case 'l':
+			case 'd':
+			{
+				mReader.get();
+				int delim = mReader.get();
+				std::string value;
+				if (delim < 0 || !read_delimited(mReader, value, (char)delim))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+					break;
+				}
+				if (c == 'l')
+				{
+					data = LLURI(value);
+				}
+				else
+				{
+					data = LLDate(value);
+				}
+				break;
+			}
+			case 'b':
+				if (!parseBinary(data))
+				{
+					parse_count = LLSDParser::PARSE_FAILURE;
+				}
+				break;
+			default:
+				parse_count = LLSDParser::PARSE_FAILURE;
+				LL_INFOS() << "Unrecognized character while parsing: int(" << c << ")" << LL_ENDL;
+				break;
+		}
+		if (parse_count == LLSDParser::PARSE_FAILURE)
+		{
+			data.clear();
+		}
+		return parse_count;
+	}
+
+private:
+	void skipSpace()
+	{
+		while (!mReader.eof() && isspace(mReader.peek()))
+		{
+			mReader.get();
+		}
+	}
+
+	std::string readToken(const char* allowed)
+	{
+		std::string token;
+		while (!mReader.eof() && strchr(allowed, mReader.peek()) && token.size() < 64)
+		{
+			token += (char)mReader.get();
+		}
+		return token;
+	}
+
+	// The first letter was consumed; a lone t, f, T or F is fine too.
+	bool parseBoolean(const char* word)
+	{
+		if (!isalpha(mReader.peek()))
+		{
+			return true;
+		}
+		for (const char* p = word + 1; *p; ++p)
+		{
+			if (tolower(mReader.peek()) != *p)
+			{
+				return false;
+			}
+			mReader.get();
+		}
+		return true;
+	}
+
+	// "quoted", 'quoted' or s(size)"raw".
+	bool parseString(std::string& value)
+	{
+		int c = mReader.get();
+		if (c == '"' || c == '\'')
+		{
+			return read_delimited(mReader, value, (char)c);
+		}
+		if (c != 's' || mReader.get() != '(')
+		{
+			return false;
+		}
+		std::string size_str = read_until(mReader, ')', 20);
+		if (mReader.get() != ')')
+		{
+			return false;
+		}
+		c = mReader.get();
+		if (c != '"' && c != '\'')
+		{
+			return false;
+		}
+		long size = strtol(size_str.c_str(), NULL, 0);
+		if (size < 0 || !mReader.append(value, size))
+		{
+			return false;
+		}
+		c = mReader.get();
+		return c == '"' || c == '\'';
+	}
+
+	// b(size)"raw", b64"base 64" or b16"hex".
+	bool parseBinary(LLSD& data)
+	{
+		std::string header = read_until(mReader, '"', 255);
+		if (mReader.get() != '"')
+		{
+			return false;
+		}
+		LLSD::Binary value;
+		if (header.compare(0, 2, "b(") == 0)
+		{
+			long size = strtol(header.c_str() + 2, NULL, 0);
+			if (size < 0 || !mReader.append(value, size))
+			{
+				return false;
+			}
+			mReader.get();	// The closing quote.
+		}
+		else if (header.compare(0, 3, "b64") == 0)
+		{
+			std::string encoded;
+			if (!read_delimited(mReader, encoded, '"'))
+			{
+				return false;
+			}
+			size_t len = LLBase64::requiredDecryptionSpace(encoded);
+			if (len)
+			{
+				value.resize(len);
+				value.resize(LLBase64::decode(encoded, &value[0], len));
+			}
+		}
+		else if (header.compare(0, 3, "b16") == 0)
+		{
+			std::string encoded;
+			if (!read_delimited(mReader, encoded, '"'))
+			{
+				return false;
+			}
+			value.reserve(encoded.size() / 2);
+			for (size_t i = 0; i + 1 < encoded.size(); i += 2)
+			{
+				value.push_back((hex_as_nybble(encoded[i]) << 4) | hex_as_nybble(encoded[i + 1]));
+			}
+		}
+		else
+		{
+			return false;
+		}
+		data = LLSD(std::move(value));
+		return true;
+	}
+
+	S32 parseMap(LLSD& map)
+	{
+		// map: { string:object, string:object }
+		map = LLSD::emptyMap();
+		mReader.get();	// '{'
+		S32 parse_count = 0;
+		while (true)
+		{
+			int c = mReader.peek();
+			if (c < 0)
+			{
+				map.clear();
+				return LLSDParser::PARSE_FAILURE;
+			}
+			if (c == '}')
+			{
+				mReader.get();
+				return parse_count;
+			}
+			if (c != '"' && c != '\'' && c != 's')
+			{
+				// Whitespace, commas (and, like LLSDNotationParser, anything else) between entries.
+				mReader.get();
+				continue;
+			}
+			std::string name;
+			if (!parseString(name))
+			{
+				return LLSDParser::PARSE_FAILURE;
+			}
+			while (!mReader.eof() && (isspace(mReader.peek()) || mReader.peek() == ':'))
+			{
+				mReader.get();
+			}
+			LLSD child;
+			S32 child_count = parse(child);
+			if (child_count <= 0)
+			{
+				// There must be a value for every key.
+				return LLSDParser::PARSE_FAILURE;
+			}
+			parse_count += child_count;
+			map.insert(name, child);
+		}
+	}
+
+	S32 parseArray(LLSD& array)
+	{
+		// array: [ object, object, object ]
+		array = LLSD::emptyArray();
+		mReader.get();	// '['
+		S32 parse_count = 0;
+		while (true)
+		{
+			int c = mReader.peek();
+			if (c < 0)
+			{
+				return LLSDParser::PARSE_FAILURE;
+			}
+			if (c == ']')
+			{
+				mReader.get();
+				return parse_count;
+			}
+			if (isspace(c) || c == ',')
+			{
+				mReader.get();
+				continue;
+			}
+			LLSD child;
+			S32 child_count = parse(child);
+			if (child_count == LLSDParser::PARSE_FAILURE)
+			{
+				return LLSDParser::PARSE_FAILURE;
+			}
+			parse_count += child_count;
+			array.append(child);
+		}
+	}
+
+	LLSDSpanReader& mReader;
+	S32 mDepth;				// maps and arrays being parsed
+};
+
+bool is_xml_space(int c)
+{
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+// Length of the UTF-8 sequence at data if it is well formed and complete
+// within len bytes, else 0. Same rules as expat: no overlong forms, no
+// surrogates, nothing past U+10FFFF.
+size_t utf8_sequence_length(const U8* data, size_t len)
+{
+	U8 c = data[0];
+	size_t n;
+	U8 low = 0x80;
+	U8 high = 0xbf;
+	if (c >= 0xc2 && c <= 0xdf)
+	{
+		n = 2;
+	}
+	else if (c >= 0xe0 && c <= 0xef)
+	{
+		n = 3;
+		if (c == 0xe0) low = 0xa0;
+		else if (c == 0xed) high = 0x9f;
+	}
+	else if (c >= 0xf0 && c <= 0xf4)
+	{
+		n = 4;
+		if (c == 0xf0) low = 0x90;
+		else if (c == 0xf4) high = 0x8f;
+	}
+	else
+	{
+		return 0;
+	}
+	if (len < n || data[1] < low || data[1] > high)
+	{
+		return 0;
+	}
+	for (size_t i = 2; i < n; ++i)
+	{
+		if ((data[i] & 0xc0) != 0x80)
+		{
+			return 0;
+		}
+	}
+	return n;
+}
+
+void append_utf8(std::string& out, U32 code)
+{
+	if (code < 0x80)
+	{
+		out += (char)code;
+	}
+	else if (code < 0x800)
+	{
+		out += (char)(0xc0 | (code >> 6));
+		out += (char)(0x80 | (code & 0x3f));
+	}
+	else if (code < 0x10000)
+	{
+		out += (char)(0xe0 | (code >> 12));
+		out += (char)(0x80 | ((code >> 6) & 0x3f));
+		out += (char)(0x80 | (code & 0x3f));
+	}
+	else
+	{
+		out += (char)(0xf0 | (code >> 18));
+		out += (char)(0x80 | ((code >> 12) & 0x3f));
+		out += (char)(0x80 | ((code >> 6) & 0x3f));
+		out += (char)(0x80 | (code & 0x3f));
+	}
+}
+
+S32 hex_value(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+// The element contents below are decoded the way LLSDXMLParser does it, for
+// the usual spellings; anything else goes the same way LLSDXMLParser goes,
+// through a string and LLSD's own conversions.
+
+S32 xml_to_integer(const char* text, size_t len)
+{
+	size_t i = 0;
+	while (i < len && isspace((U8)text[i]))
+	{
+		++i;
+	}
+	bool negative = false;
+	if (i < len && (text[i] == '-' || text[i] == '+'))
+	{
+		negative = (text[i++] == '-');
+	}
+	S32 value = 0;
+	size_t digits = 0;
+	// Nine digits can't overflow.
+	for ( ; i < len && digits < 9 && isdigit((U8)text[i]); ++i, ++digits)
+	{
+		value = value * 10 + (text[i] - '0');
+	}
+	if (digits && (i == len || !isdigit((U8)text[i])))
+	{
+		return negative ? -value : value;
+	}
+	std::string str(text, len);
+	S32 parsed;
+	if (sscanf(str.c_str(), "%d", &parsed) == 1)
+	{
+		return parsed;
+	}
+	return LLSD(str).asInteger();
+}
+
+F64 xml_to_real(const char* text, size_t len)
+{
+	F64 value;
+	if (!text_to_real(text, len, value))
+	{
+		value = LLSD(std::string(text, len)).asReal();
+	}
+	return value;
+}
+
+LLUUID xml_to_uuid(const char* text, size_t len)
+{
+	LLUUID id;
+	if (!len)
+	{
+		return id;
+	}
+	if (len == UUID_STR_LENGTH - 1)
+	{
+		size_t byte = 0;
+		for (size_t i = 0; i < len && byte < UUID_BYTES; )
+		{
+			if (i == 8 || i == 13 || i == 18 || i == 23)
+			{
+				if (text[i++] != '-')
+				{
+					break;
+				}
+				continue;
+			}
+			S32 high = hex_value(text[i]);
+			S32 low = hex_value(text[i + 1]);
+			if (high < 0 || low < 0)
+			{
+				break;
+			}
+			id.mData[byte++] = (U8)((high << 4) | low);
+			i += 2;
+		}
+		if (byte == UUID_BYTES)
+		{
+			return id;
+		}
+	}
+	return LLSD(std::string(text, len)).asUUID();
+}
+
+// Days from 1970-01-01 to the given proleptic Gregorian date; like timegm(),
+// out of range days simply carry over into the next month.
+S64 days_from_civil(S64 year, S64 month, S64 day)
+{
+	year -= month <= 2;
+	S64 era = (year >= 0 ? year : year - 399) / 400;
+	S64 year_of_era = year - era * 400;
+	S64 day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	S64 day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	return era * 146097 + day_of_era - 719468;
+}
+
+LLDate xml_to_date(const char* text, size_t len)
+{
+	// YYYY-MM-DDTHH:MM:SS[.fraction]Z; LLDate drops the fraction too.
+	static const char layout[] = "dddd-dd-ddTdd:dd:dd";
+	const size_t layout_len = sizeof(layout) - 1;
+	S32 fields[6] = { 0 };
+	bool valid = len > layout_len;
+	for (size_t i = 0, field = 0; valid && i < layout_len; ++i)
+	{
+		if (layout[i] == 'd')
+		{
+			valid = isdigit((U8)text[i]) != 0;
+			fields[field] = fields[field] * 10 + (text[i] - '0');
+		}
+		else
+		{
+			valid = text[i] == layout[i];
+			++field;
+		}
+	}
+	size_t i = layout_len;
+	if (valid && text[i] == '.')
+	{
+		size_t digits = 0;
+		for (++i; i < len && isdigit((U8)text[i]); ++i, ++digits) ;
+		valid = digits > 0;
+	}
+	if (valid && i < len && text[i] == 'Z' &&
+		fields[1] >= 1 && fields[1] <= 12 && fields[2] >= 1 && fields[2] <= 31 &&
+		fields[3] <= 23 && fields[4] <= 59 && fields[5] <= 60)
+	{
+		S64 seconds = days_from_civil(fields[0], fields[1], fields[2]) * 86400 +
+					  fields[3] * 3600 + fields[4] * 60 + fields[5];
+		// timegm() returns -1 for failure, and LLDate gives up on it.
+		if (seconds != -1)
+		{
+			return LLDate((F64)seconds);
+		}
+	}
+	return LLSD(std::string(text, len)).asDate();
+}
+
+S32 base64_value(U8 c)
+{
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+// Well formed, padded base 64 with any white space in between.
+bool xml_base64_to_binary(const char* text, size_t len, LLSD::Binary& value)
+{
+	value.reserve(len / 4 * 3);
+	U32 quad = 0;
+	S32 count = 0;
+	S32 padding = 0;
+	for (size_t i = 0; i < len; ++i)
+	{
+		U8 c = text[i];
+		if (isspace(c))
+		{
+			continue;
+		}
+		if (c == '=')
+		{
+			if (count < 2)
+			{
+				return false;
+			}
+			++padding;
+			quad <<= 6;
+		}
+		else
+		{
+			S32 bits = base64_value(c);
+			if (bits < 0 || padding)
+			{
+				return false;
+			}
+			quad = (quad << 6) | bits;
+		}
+		if (++count == 4)
+		{
+			value.push_back((U8)(quad >> 16));
+			if (padding < 2) value.push_back((U8)(quad >> 8));
+			if (padding < 1) value.push_back((U8)quad);
+			quad = 0;
+			count = 0;
+			if (padding)
+			{
+				for (++i; i < len; ++i)
+				{
+					if (!isspace((U8)text[i]))
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return count == 0;
+}
+
+LLSD::Binary xml_to_binary(const char* text, size_t len)
+{
+	LLSD::Binary value;
+	if (len && !xml_base64_to_binary(text, len, value))
+	{
+		// What LLSDXMLParser does, for whatever it is that was sent.
+		boost::regex r;
+		r.assign("\\s");
+		std::string stripped = boost::regex_replace(std::string(text, len), r, "");
+		value.clear();
+		size_t size = LLBase64::requiredDecryptionSpace(stripped);
+		value.resize(size);
+		if (size)
+		{
+			value.resize(LLBase64::decode(stripped, &value[0], size));
+		}
+	}
+	return value;
+}
+
+// Pull parser for XML LLSD. It walks the tags itself instead of going
+// through expat callbacks, and decodes each value straight from the text
+// instead of collecting it in a string first. It covers the XML that
+// LLSDXMLFormatter and the grid services write. For anything else (a DTD
+// subset, CDATA, an element that isn't LLSD, a binary encoding other than
+// base 64, malformed or truncated XML) it gives up, and the caller hands the
+// document to LLSDXMLParser so the outcome stays expat's.
+class LLSDXMLSpanParser
+{
+public:
+	LLSDXMLSpanParser(LLSDSpanReader& reader) : mReader(reader), mDocumentStart(0), mParseCount(0), mDepth(0) { }
+
+	// Returns false if the document needs LLSDXMLParser.
+	bool parse(LLSD& data, S32& parse_count)
+	{
+		if (mReader.peek() == 0xef && !expect("\xef\xbb\xbf"))
+		{
+			return false;
+		}
+		mDocumentStart = mReader.consumed();
+		Tag tag;
+		if (!readMarkup(tag, true) || tag.mClosing || tag.mElement != ELEMENT_LLSD)
+		{
+			return false;
+		}
+		data.clear();
+		if (!tag.mEmpty)
+		{
+			while (true)
+			{
+				if (!readMarkup(tag, false))
+				{
+					return false;
+				}
+				if (tag.mClosing)
+				{
+					if (tag.mElement != ELEMENT_LLSD)
+					{
+						return false;
+					}
+					break;
+				}
+				// Like LLSDXMLParser, a second value replaces the first.
+				if (!parseValue(tag, data))
+				{
+					return false;
+				}
+			}
+		}
+		// LLSDXMLParser also eats the end of the line after the document.
+		while (mReader.peek() == '\n' || mReader.peek() == '\r')
+		{
+			mReader.get();
+		}
+		parse_count = mParseCount;
+		return true;
+	}
+
+private:
+	enum Element {
+		ELEMENT_LLSD,
+		ELEMENT_UNDEF,
+		ELEMENT_BOOL,
+		ELEMENT_INTEGER,
+		ELEMENT_REAL,
+		ELEMENT_STRING,
+		ELEMENT_UUID,
+		ELEMENT_DATE,
+		ELEMENT_URI,
+		ELEMENT_BINARY,
+		ELEMENT_MAP,
+		ELEMENT_ARRAY,
+		ELEMENT_KEY,
+		ELEMENT_UNKNOWN
+	};
+
+	struct Tag
+	{
+		Element mElement;
+		bool mClosing;		// </element>
+		bool mEmpty;		// <element/>
+	};
+
+	static Element readElement(const char* name, size_t len)
+	{
+		static const struct { const char* mName; Element mElement; } elements[] = {
+			{ "key", ELEMENT_KEY }, { "real", ELEMENT_REAL }, { "integer", ELEMENT_INTEGER },
+			{ "array", ELEMENT_ARRAY }, { "map", ELEMENT_MAP }, { "uuid", ELEMENT_UUID },
+			{ "undef", ELEMENT_UNDEF }, { "uri", ELEMENT_URI }, { "binary", ELEMENT_BINARY },
+			{ "boolean", ELEMENT_BOOL }, { "string", ELEMENT_STRING }, { "llsd", ELEMENT_LLSD },
+			{ "date", ELEMENT_DATE }
+		};
+		for (size_t i = 0; i < LL_ARRAY_SIZE(elements); ++i)
+		{
+			if (!strncmp(name, elements[i].mName, len) && !elements[i].mName[len])
+			{
+				return elements[i].mElement;
+			}
+		}
+		return ELEMENT_UNKNOWN;
+	}
+
+	bool expect(const char* str)
+	{
+		for ( ; *str; ++str)
+		{
+			if (mReader.get() != (U8)*str)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool skipSpace()
+	{
+		bool skipped = false;
+		while (is_xml_space(mReader.peek()))
+		{
+			mReader.get();
+			skipped = true;
+		}
+		return skipped;
+	}
+
+	// Skips white space, comments and processing instructions, then reads
+	// the next tag. A DOCTYPE without an internal subset is fine in the
+	// prolog.
+	bool readMarkup(Tag& tag, bool prolog)
+	{
+		while (true)
+		{
+			skipSpace();
+			size_t start = mReader.consumed();
+			if (mReader.get() != '<')
+			{
+				return false;
+			}
+			int c = mReader.peek();
+			if (c == '?')
+			{
+				// Only the XML declaration may be called xml, and it must
+				// come first.
+				mReader.get();
+				std::string target;
+				while (isNameChar(mReader.peek()))
+				{
+					target += (char)tolower(mReader.get());
+				}
+				if (target.empty() || (target == "xml" && start != mDocumentStart))
+				{
+					return false;
+				}
+				int last = 0;
+				while ((c = mReader.get()) >= 0 && !(last == '?' && c == '>'))
+				{
+					last = c;
+				}
+				if (c < 0)
+				{
+					return false;
+				}
+			}
+			else if (c == '!')
+			{
+				mReader.get();
+				if (mReader.peek() == '-' ? !skipComment() : !(prolog && skipDoctype()))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				return readTag(tag);
+			}
+		}
+	}
+
+	// After "<!".
+	bool skipComment()
+	{
+		if (!expect("--"))
+		{
+			return false;
+		}
+		while (true)
+		{
+			int c = mReader.get();
+			if (c < 0)
+			{
+				return false;
+			}
+			if (c == '-' && mReader.peek() == '-')
+			{
+				// "--" may only end the comment.
+				mReader.get();
+				return mReader.get() == '>';
+			}
+		}
+	}
+
+	// After "<!".
+	bool skipDoctype()
+	{
+		if (!expect("DOCTYPE"))
+		{
+			return false;
+		}
+		int quote = 0;
+		while (true)
+		{
+			int c = mReader.get();
+			if (c < 0 || (c == '[' && !quote))
+			{
+				return false;
+			}
+			if (quote)
+			{
+				if (c == quote)
+				{
+					quote = 0;
+				}
+			}
+			else if (c == '"' || c == '\'')
+			{
+				quote = c;
+			}
+			else if (c == '>')
+			{
+				return true;
+			}
+		}
+	}
+
+	static bool isNameChar(int c)
+	{
+		return isalnum(c) || c == '_' || c == ':' || c == '-' || c == '.';
+	}
+
+	// After "<". Attributes are checked for well-formedness and dropped,
+	// except the encoding of a binary value.
+	bool readTag(Tag& tag)
+	{
+		tag.mClosing = (mReader.peek() == '/');
+		if (tag.mClosing)
+		{
+			mReader.get();
+		}
+		char name[8];
+		size_t len = 0;
+		while (isNameChar(mReader.peek()))
+		{
+			if (len == sizeof(name))
+			{
+				return false;
+			}
+			name[len++] = (char)mReader.get();
+		}
+		tag.mElement = readElement(name, len);
+		if (tag.mElement == ELEMENT_UNKNOWN)
+		{
+			return false;
+		}
+		tag.mEmpty = false;
+		while (true)
+		{
+			bool space = skipSpace();
+			int c = mReader.get();
+			if (c == '>')
+			{
+				return true;
+			}
+			if (c == '/' && !tag.mClosing)
+			{
+				tag.mEmpty = true;
+				return mReader.get() == '>';
+			}
+			if (tag.mClosing || !space || !isalpha(c))
+			{
+				return false;
+			}
+			std::string attribute(1, (char)c);
+			while (isNameChar(mReader.peek()))
+			{
+				attribute += (char)mReader.get();
+			}
+			skipSpace();
+			if (mReader.get() != '=')
+			{
+				return false;
+			}
+			skipSpace();
+			int quote = mReader.get();
+			if (quote != '"' && quote != '\'')
+			{
+				return false;
+			}
+			std::string value;
+			while ((c = mReader.get()) != quote)
+			{
+				if (c < 0 || c == '<' || c == '&')
+				{
+					return false;
+				}
+				value += (char)c;
+			}
+			if (tag.mElement == ELEMENT_BINARY && attribute == "encoding" && value != "base64")
+			{
+				return false;
+			}
+		}
+	}
+
+	bool readEnd(Element element)
+	{
+		Tag tag;
+		return mReader.get() == '<' && readTag(tag) && tag.mClosing && tag.mElement == element;
+	}
+
+	// Reads the character data up to the next tag. Text that sits in one
+	// segment and has nothing to decode is returned where it is, anything
+	// else is decoded into mScratch.
+	bool readText(const char*& text, size_t& len)
+	{
+		const U8* start = mReader.data();
+		size_t available = mReader.available();
+		size_t run = 0;
+		while (run < available)
+		{
+			U8 c = start[run];
+			if (c >= 0x80)
+			{
+				size_t n = utf8_sequence_length(start + run, available - run);
+				if (!n)
+				{
+					break;
+				}
+				run += n;
+			}
+			else if (c >= 0x20 ? (c != '<' && c != '&') : (c == '\t' || c == '\n'))
+			{
+				++run;
+			}
+			else
+			{
+				break;
+			}
+		}
+		if (run < available && start[run] == '<')
+		{
+			text = (const char*)start;
+			len = run;
+			mReader.advance(run);
+			return true;
+		}
+
+		mScratch.assign((const char*)start, run);
+		mReader.advance(run);
+		while (true)
+		{
+			int c = mReader.peek();
+			if (c < 0)
+			{
+				return false;
+			}
+			if (c == '<')
+			{
+				break;
+			}
+			mReader.get();
+			if (c == '&')
+			{
+				if (!readReference())
+				{
+					return false;
+				}
+			}
+			else if (c == '\r')
+			{
+				// XML line ends are "\n".
+				mScratch += '\n';
+				if (mReader.peek() == '\n')
+				{
+					mReader.get();
+				}
+			}
+			else if (c >= 0x80)
+			{
+				U8 sequence[4] = { (U8)c };
+				size_t n = 1;
+				while (n < 4 && (mReader.peek() & 0xc0) == 0x80)
+				{
+					sequence[n++] = (U8)mReader.get();
+				}
+				if (utf8_sequence_length(sequence, n) != n)
+				{
+					return false;
+				}
+				mScratch.append((const char*)sequence, n);
+			}
+			else if (c < 0x20 && c != '\t' && c != '\n')
+			{
+				return false;
+			}
+			else
+			{
+				mScratch += (char)c;
+			}
+		}
+		text = mScratch.data();
+		len = mScratch.size();
+		return true;
+	}
+
+	// After "&".
+	bool readReference()
+	{
+		char name[12];
+		size_t len = 0;
+		int c;
+		while ((c = mReader.get()) != ';')
+		{
+			if (c < 0 || len == sizeof(name) - 1)
+			{
+				return false;
+			}
+			name[len++] = (char)c;
+		}
+		name[len] = '\0';
+		if (name[0] != '#')
+		{
+			static const char* names[] = { "lt", "gt", "amp", "quot", "apos" };
+			static const char chars[] = "<>&\"'";
+			for (size_t i = 0; i < LL_ARRAY_SIZE(names); ++i)
+			{
+				if (!strcmp(name, names[i]))
+				{
+					mScratch += chars[i];
+					return true;
+				}
+			}
+			return false;
+		}
+		bool hex = name[1] == 'x';
+		const char* digits = name + (hex ? 2 : 1);
+		char* end = NULL;
+		unsigned long code = strtoul(digits, &end, hex ? 16 : 10);
+		if (!*digits || *end || !isalnum((U8)*digits) ||
+			!(code == 0x9 || code == 0xa || code == 0xd || (code >= 0x20 && code <= 0xd7ff) ||
+			  (code >= 0xe000 && code <= 0xfffd) || (code >= 0x10000 && code <= 0x10ffff)))
+		{
+			return false;
+		}
+		append_utf8(mScratch, (U32)code);
+		return true;
+	}
+
+	bool parseValue(const Tag& tag, LLSD& value)
+	{
+		++mParseCount;
+		switch (tag.mElement)
+		{
+			case ELEMENT_MAP:
+			case ELEMENT_ARRAY:
+			{
+				bool is_map = tag.mElement == ELEMENT_MAP;
+				value = is_map ? LLSD::emptyMap() : LLSD::emptyArray();
+				if (tag.mEmpty)
+				{
+					return true;
+				}
+				// Documents nested deeper than this go to LLSDXMLParser,
+				// which keeps its stack on the heap.
+				if (mDepth >= MAX_NESTING)
+				{
+					return false;
+				}
+				++mDepth;
+				bool parsed = is_map ? parseMap(value) : parseArray(value);
+				--mDepth;
+				return parsed;
+			}
+			case ELEMENT_LLSD:
+			case ELEMENT_KEY:
+			case ELEMENT_UNKNOWN:
+				return false;
+			default:
+				break;
+		}
+
+		const char* text = "";
+		size_t len = 0;
+		if (!tag.mEmpty && (!readText(text, len) || !readEnd(tag.mElement)))
+		{
+			return false;
+		}
+		switch (tag.mElement)
+		{
+			case ELEMENT_BOOL:
+				value = (len == 4 && !memcmp(text, "true", 4)) || (len == 1 && *text == '1');
+				break;
+			case ELEMENT_INTEGER:
+				value = xml_to_integer(text, len);
+				break;
+			case ELEMENT_REAL:
+				value = xml_to_real(text, len);
+				break;
+			case ELEMENT_STRING:
+				value = LLSD(std::string(text, len));
+				break;
+			case ELEMENT_UUID:
+				value = xml_to_uuid(text, len);
+				break;
+			case ELEMENT_DATE:
+				value = xml_to_date(text, len);
+				break;
+			case ELEMENT_URI:
+				value = LLURI(std::string(text, len));
+				break;
+			case ELEMENT_BINARY:
+				value = LLSD(xml_to_binary(text, len));
+				break;
+			default:
+				value.clear();
+				break;
+		}
+		return true;
+	}
+
+	// Children are parsed in place, into the entry they belong to.
+	bool parseMap(LLSD& map)
+	{
+		Tag tag;
+		while (true)
+		{
+			if (!readMarkup(tag, false))
+			{
+				return false;
+			}
+			if (tag.mClosing)
+			{
+				return tag.mElement == ELEMENT_MAP;
+			}
+			const char* text;
+			size_t len;
+			// LLSDXMLParser drops values with an empty key.
+			if (tag.mElement != ELEMENT_KEY || tag.mEmpty ||
+				!readText(text, len) || !len || !readEnd(ELEMENT_KEY))
+			{
+				return false;
+			}
+			LLSD& child = map[std::string(text, len)];
+			if (!readMarkup(tag, false) || tag.mClosing || !parseValue(tag, child))
+			{
+				return false;
+			}
+		}
+	}
+
+	bool parseArray(LLSD& array)
+	{
+		Tag tag;
+		while (true)
+		{
+			if (!readMarkup(tag, false))
+			{
+				return false;
+			}
+			if (tag.mClosing)
+			{
+				return tag.mElement == ELEMENT_ARRAY;
+			}
+			array.append(LLSD());
+			if (!parseValue(tag, array[array.size() - 1]))
+			{
+				return false;
+			}
+		}
+	}
+
+	LLSDSpanReader& mReader;
+	size_t mDocumentStart;
+	S32 mParseCount;
+	S32 mDepth;				// maps and arrays being parsed
+	std::string mScratch;
+};
+
+} // anonymous namespace
+
+// static
+S32 LLSDSerialize::fromBinary(LLSD& sd, const U8* data, size_t size, size_t* consumed)
+{
+	segments_t segments(1, std::make_pair(data, size));
+	return fromBinary(sd, segments, consumed);
+}
+
+// static
+S32 LLSDSerialize::fromBinary(LLSD& sd, const segments_t& segments, size_t* consumed)
+{
+	LLSDSpanReader reader(segments);
+	S32 count = LLSDBinarySpanParser(reader).parse(sd);
+	if (consumed)
+	{
+		*consumed = reader.consumed();
+	}
+	return count;
+}
+
+// static
+S32 LLSDSerialize::fromNotation(LLSD& sd, const U8* data, size_t size, size_t* consumed)
+{
+	segments_t segments(1, std::make_pair(data, size));
+	return fromNotation(sd, segments, consumed);
+}
+
+// static
+S32 LLSDSerialize::fromNotation(LLSD& sd, const segments_t& segments, size_t* consumed)
+{
+	LLSDSpanReader reader(segments);
+	S32 count = LLSDNotationSpanParser(reader).parse(sd);
+	if (consumed)
+	{
+		*consumed = reader.consumed();
+	}
+	return count;
+}
+
+// static
+S32 LLSDSerialize::fromXML(LLSD& sd, const U8* data, size_t size, size_t* consumed, bool emit_errors)
+{
+	segments_t segments(1, std::make_pair(data, size));
+	return fromXML(sd, segments, consumed, emit_errors);
+}
+
+// static
+S32 LLSDSerialize::fromXML(LLSD& sd, const segments_t& segments, size_t* consumed, bool emit_errors)
+{
+	LLSDSpanReader reader(segments);
+	S32 count = 0;
+	if (LLSDXMLSpanParser(reader).parse(sd, count))
+	{
+		if (consumed)
+		{
+			*consumed = reader.consumed();
+		}
+		return count;
+	}
+
+	// Not for the pull parser: let expat have its say.
+	std::string text;
+	text.reserve(reader.consumed() + reader.remaining());
+	for (size_t i = 0; i < segments.size(); ++i)
+	{
+		text.append((const char*)segments[i].first, segments[i].second);
+	}
+	std::istringstream istr(text);
+	count = fromXMLEmbedded(sd, istr, emit_errors);
+	if (consumed)
+	{
+		// LLSDXMLParser reads ahead, so this is where it stopped reading
+		// rather than where the document ends.
+		istr.clear();
+		std::streamoff pos = istr.tellg();
+		*consumed = pos < 0 ? text.size() : (size_t)pos;
+	}
+	return count;
+}
@@ -36,102 +36,133 @@
 #include "llstringtable.h"
 #include "llstl.h"
 
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <vector>
+
 LLStringTable gStringTable(32768);
 
-LLStringTableEntry::LLStringTableEntry(const char *str)
-: mString(NULL), mCount(1)
+static const U32 STRING_TABLE_SHARD_BITS = 4;
+static const U32 STRING_TABLE_SHARDS = 1 << STRING_TABLE_SHARD_BITS;
+
+struct LLStringTable::Shard
 {
-	// Copy string
-	U32 length = (U32)strlen(str) + 1;	 /*Flawfinder: ignore*/
-	length = llmin(length, MAX_STRINGS_LENGTH);
-	mString = new char[length];
-	strncpy(mString, str, length);	 /*Flawfinder: ignore*/
-	mString[length - 1] = 0;
-}
+	Shard() : mBuckets(NULL), mNumBuckets(0) { }
+	~Shard()
+	{
+		for (U32 i = 0; i < mNumBuckets; i++)
+		{
+			LLStringTableEntry* entry = mBuckets[i];
+			while (entry)
+			{
+				LLStringTableEntry* next = entry->mNext;
+				destroy(entry);
+				entry = next;
+			}
+		}
+		delete [] mBuckets;
+	}
 
-LLStringTableEntry::~LLStringTableEntry()
+	// An entry and its characters are one allocation.
+	static LLStringTableEntry* create(const char* str, U32 length, U32 hash, LLStringTableEntry* next)
+	{
+		char* mem = new char[sizeof(LLStringTableEntry) + length + 1];
+		char* string = mem + sizeof(LLStringTableEntry);
+		memcpy(string, str, length);
+		string[length] = 0;
+		return new (mem) LLStringTableEntry(string, length, hash, next);
+	}
+
+	static void destroy(LLStringTableEntry* entry)
+	{
+		entry->~LLStringTableEntry();
+		delete [] (char*)entry;
+	}
+
+	LLStringTableEntry** mBuckets;
+	U32 mNumBuckets;
+	mutable std::shared_timed_mutex mMutex;	// Shared by lookups, exclusive for adding and removing.
+};
+
+// FNV-1a over at most MAX_STRINGS_LENGTH - 1 characters; also returns that length.
+static U32 hash_my_string(const char *str, U32& length)
 {
-	delete [] mString;
-	mCount = 0;
+	U32 hash = 2166136261U;
+	const char* p = str;
+	const char* end = str + MAX_STRINGS_LENGTH - 1;
+	while (p < end && *p)
+	{
+		hash = (hash ^ (U8)*p++) * 16777619U;
+	}
+	length = (U32)(p - str);
+	return hash;
 }
 
 LLStringTable::LLStringTable(int tablesize)
-: mUniqueEntries(0)
+:	mUniqueEntries(0)
 {
-	S32 i;
 	if (!tablesize)
 		tablesize = 4096; // some arbitrary default
-	// Make sure tablesize is power of 2
-	for (i = 31; i>0; i--)
+	// Round the buckets per shard up to a power of 2
+	U32 buckets = 16;
+	while (buckets * STRING_TABLE_SHARDS < (U32)tablesize)
 	{
-		if (tablesize & (1<<i))
-		{
-			if (tablesize >= (3<<(i-1)))
-				tablesize = (1<<(i+1));
-			else
-				tablesize = (1<<i);
-			break;
-		}
+		buckets <<= 1;
 	}
-	mMaxEntries = tablesize;
+	mBucketMask = buckets - 1;
 
-#if !STRING_TABLE_HASH_MAP
-	// ALlocate strings
-	mStringList = new string_list_ptr_t[mMaxEntries];
-	// Clear strings
-	for (i = 0; i < mMaxEntries; i++)
+	mShards = new Shard[STRING_TABLE_SHARDS];
+	for (U32 i = 0; i < STRING_TABLE_SHARDS; i++)
 	{
-		mStringList[i] = NULL;
+		mShards[i].mBuckets = new LLStringTableEntry*[buckets];
+		mShards[i].mNumBuckets = buckets;
+		for (U32 j = 0; j < buckets; j++)
+		{
+			mShards[i].mBuckets[j] = NULL;
+		}
 	}
-#endif
 }
 
 LLStringTable::~LLStringTable()
 {
-#if !STRING_TABLE_HASH_MAP
-	if (mStringList)
+	delete [] mShards;
+	mShards = NULL;
+}
+
+LLStringTable::Shard& LLStringTable::getShard(U32 hash) const
+{
+	return mShards[hash >> (32 - STRING_TABLE_SHARD_BITS)];
+}
+
+// Called with the lock of shard held.
+LLStringTableEntry* LLStringTable::find(const Shard& shard, const char* str, U32 length, U32 hash) const
+{
+	LLStringTableEntry* entry = shard.mBuckets[hash & mBucketMask];
+	while (entry)
 	{
-		for (S32 i = 0; i < mMaxEntries; i++)
+		if (entry->mHash == hash && entry->mLength == length && !memcmp(entry->mString, str, length))
 		{
-			if (mStringList[i])
-			{
-				string_list_t::iterator iter;
-				for (iter = mStringList[i]->begin(); iter != mStringList[i]->end(); iter++)
-					delete *iter; // *iter = (LLStringTableEntry*)
-			}
-			delete mStringList[i];
+			return entry;
 		}
-		delete [] mStringList;
-		mStringList = NULL;
+		entry = entry->mNext;
 	}
-#else
-	// Need to clean up the string hash
-	for_each(mStringHash.begin(), mStringHash.end(), DeletePairedPointer());
-	mStringHash.clear();
-#endif
+	return NULL;
 }
 
-
-static U32 hash_my_string(const char *str, int max_entries)
+void LLStringTable::getStrings(std::vector<const char*>& strings) const
 {
-	U32 retval = 0;
-#if 0
-	while (*str)
+	for (U32 i = 0; i < STRING_TABLE_SHARDS; i++)
 	{
-		retval <<= 1;
-		retval += *str++;
-	}
-#else
-	while (*str)
-	{
-		retval = (retval<<4) + *str;
-		U32 x = (retval & 0xf0000000);
-		if (x) retval = retval ^ (x>>24);
-		retval = retval & (~x);
-		str++;
+		std::shared_lock<std::shared_timed_mutex> lock(mShards[i].mMutex);
+		for (U32 j = 0; j <= mBucketMask; j++)
+		{
+			for (LLStringTableEntry* entry = mShards[i].mBuckets[j]; entry; entry = entry->mNext)
+			{
+				strings.push_back(entry->mString);
+			}
+		}
 	}
-#endif
-	return (retval & (max_entries-1)); // max_entries is gauranteed to be power of 2
 }
 
 char* LLStringTable::checkString(const std::string& str)
@@ -141,65 +172,26 @@ char* LLStringTable::checkString(const std::string& str)
 
 char* LLStringTable::checkString(const char *str)
 {
-    LLStringTableEntry* entry = checkStringEntry(str);
-    if (entry)
-    {
-	return entry->mString;
-    }
-    else
-    {
-	return NULL;
-    }
+	LLStringTableEntry* entry = checkStringEntry(str);
+	return entry ? entry->mString : NULL;
 }
 
 LLStringTableEntry* LLStringTable::checkStringEntry(const std::string& str)
 {
-    return checkStringEntry(str.c_str());
+	return checkStringEntry(str.c_str());
 }
 
 LLStringTableEntry* LLStringTable::checkStringEntry(const char *str)
 {
-	if (str)
+	if (!str)
 	{
-		char *ret_val;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-#if 1 // Microsoft
-		string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-		string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-		std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-		string_hash_t::iterator lower = P.first;
-		string_hash_t::iterator upper = P.second;
-#endif
-		for (string_hash_t::iterator iter = lower; iter != upper; iter++)
-		{
-			entry = iter->second;
-			ret_val = entry->mString;
-			if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-			{
-				return entry;
-			}
-		}
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-		if (strlist)
-		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); iter++)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					return entry;
-				}
-			}
-		}
-#endif
+		return NULL;
 	}
-	return NULL;
+	U32 length;
+	U32 hash = hash_my_string(str, length);
+	Shard& shard = getShard(hash);
+	std::shared_lock<std::shared_timed_mutex> lock(shard.mMutex);
+	return find(shard, str, length, hash);
 }
 
 char* LLStringTable::addString(const std::string& str)
@@ -210,155 +202,64 @@ char* LLStringTable::addString(const std::string& str)
 
 char* LLStringTable::addString(const char *str)
 {
-
-    LLStringTableEntry* entry = addStringEntry(str);
-    if (entry)
-    {
-	return entry->mString;
-    }
-    else
-    {
-	return NULL;
-    }
+	LLStringTableEntry* entry = addStringEntry(str);
+	return entry ? entry->mString : NULL;
 }
 
 LLStringTableEntry* LLStringTable::addStringEntry(const std::string& str)
 {
-    return addStringEntry(str.c_str());
+	return addStringEntry(str.c_str());
 }
 
 LLStringTableEntry* LLStringTable::addStringEntry(const char *str)
 {
-	if (str)
+	if (!str)
 	{
-		char *ret_val = NULL;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-#if 1 // Microsoft
-		string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-		string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-		std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-		string_hash_t::iterator lower = P.first;
-		string_hash_t::iterator upper = P.second;
-#endif
-		for (string_hash_t::iterator iter = lower; iter != upper; iter++)
-		{
-			entry = iter->second;
-			ret_val = entry->mString;
-			if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-			{
-				entry->incCount();
-				return entry;
-			}
-		}
-
-		// not found, so add!
-		LLStringTableEntry* newentry = new LLStringTableEntry(str);
-		ret_val = newentry->mString;
-		mStringHash.insert(string_hash_t::value_type(hash_value, newentry));
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-
-		if (strlist)
-		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); ++iter)
-			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					entry->incCount();
-					return entry;
-				}
-			}
-		}
-		else
-		{
-			mStringList[hash_value] = new string_list_t;
-			strlist = mStringList[hash_value];
-		}
-
-		// not found, so add!
-		LLStringTableEntry *newentry = new LLStringTableEntry(str);
-		//ret_val = newentry->mString;
-		strlist->push_front(newentry);
-#endif
-		mUniqueEntries++;
-		return newentry;
+		return NULL;
+	}
+	U32 length;
+	U32 hash = hash_my_string(str, length);
+	Shard& shard = getShard(hash);
+	std::lock_guard<std::shared_timed_mutex> lock(shard.mMutex);
+	LLStringTableEntry* entry = find(shard, str, length, hash);
+	if (entry)
+	{
+		entry->incCount();
 	}
 	else
 	{
-		return NULL;
+		LLStringTableEntry*& bucket = shard.mBuckets[hash & mBucketMask];
+		entry = bucket = Shard::create(str, length, hash, bucket);
+		mUniqueEntries++;
 	}
+	return entry;
 }
 
 void LLStringTable::removeString(const char *str)
 {
-	if (str)
+	if (!str)
 	{
-		char *ret_val;
-		LLStringTableEntry	*entry;
-		U32					hash_value = hash_my_string(str, mMaxEntries);
-#if STRING_TABLE_HASH_MAP
-		{
-#if 1 // Microsoft
-			string_hash_t::iterator lower = mStringHash.lower_bound(hash_value);
-			string_hash_t::iterator upper = mStringHash.upper_bound(hash_value);
-#else // stlport
-			std::pair<string_hash_t::iterator, string_hash_t::iterator> P = mStringHash.equal_range(hash_value);
-			string_hash_t::iterator lower = P.first;
-			string_hash_t::iterator upper = P.second;
-#endif
-			for (string_hash_t::iterator iter = lower; iter != upper; iter++)
-			{
-				entry = iter->second;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
-				{
-					if (!entry->decCount())
-					{
-						mUniqueEntries--;
-						if (mUniqueEntries < 0)
-						{
-							LL_ERRS() << "LLStringTable:removeString trying to remove too many strings!" << LL_ENDL;
-						}
-						delete iter->second;
-						mStringHash.erase(iter);
-					}
-					return;
-				}
-			}
-		}
-#else
-		string_list_t		*strlist = mStringList[hash_value];
-
-		if (strlist)
+		return;
+	}
+	U32 length;
+	U32 hash = hash_my_string(str, length);
+	Shard& shard = getShard(hash);
+	std::lock_guard<std::shared_timed_mutex> lock(shard.mMutex);
+	LLStringTableEntry** link = &shard.mBuckets[hash & mBucketMask];
+	for (LLStringTableEntry* entry = *link; entry; link = &entry->mNext, entry = *link)
+	{
+		if (entry->mHash == hash && entry->mLength == length && !memcmp(entry->mString, str, length))
 		{
-			string_list_t::iterator iter;
-			for (iter = strlist->begin(); iter != strlist->end(); ++iter)
+			if (!entry->decCount())
 			{
-				entry = *iter;
-				ret_val = entry->mString;
-				if (!strncmp(ret_val, str, MAX_STRINGS_LENGTH))
+				*link = entry->mNext;
+				Shard::destroy(entry);
+				if (--mUniqueEntries < 0)
 				{
-					if (!entry->decCount())
-					{
-						mUniqueEntries--;
-						if (mUniqueEntries < 0)
-						{
-							LL_ERRS() << "LLStringTable:removeString trying to remove too many strings!" << LL_ENDL;
-						}
-						strlist->remove(entry);
-						delete entry;
-					}
-					return;
+					LL_ERRS() << "LLStringTable:removeString trying to remove too many strings!" << LL_ENDL;
 				}
 			}
+			return;
 		}
-#endif
 	}
 }
-
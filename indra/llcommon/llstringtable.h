@@ -37,40 +37,40 @@
 #include "lldefs.h"
 #include "llformat.h"
 #include "llstl.h"
+#include <atomic>
 #include <list>
 #include <set>
+#include <vector>
 
-#if LL_WINDOWS
-# if (_MSC_VER >= 1300 && _MSC_VER < 1400)
-#  define STRING_TABLE_HASH_MAP 1
-# endif
-#else
-//# define STRING_TABLE_HASH_MAP 1
-#endif
-
-#if STRING_TABLE_HASH_MAP
-# if LL_WINDOWS
-#  include <hash_map>
-# else
-#  include <ext/hash_map>
-# endif
-#endif
-
+// Strings are truncated to MAX_STRINGS_LENGTH - 1 characters.
 const U32 MAX_STRINGS_LENGTH = 256;
 
+// An interned string. An entry lives until its count drops to zero and mString
+// never changes, so two names interned in the same table at the same time are
+// equal if and only if their entries (or mString) are.
 class LL_COMMON_API LLStringTableEntry
 {
 public:
-	LLStringTableEntry(const char *str);
-	~LLStringTableEntry();
-
 	void incCount()		{ mCount++; }
 	BOOL decCount()		{ return --mCount; }
 
 	char *mString;
-	S32  mCount;
+	std::atomic<S32> mCount;	// addString() minus removeString() calls.
+
+private:
+	friend class LLStringTable;
+	LLStringTableEntry(char* str, U32 length, U32 hash, LLStringTableEntry* next)
+	:	mString(str), mCount(1), mLength(length), mHash(hash), mNext(next) { }
+
+	U32 mLength;
+	U32 mHash;
+	LLStringTableEntry* mNext;	// Next in the bucket.
 };
 
+// Thread-safe string interning. The table is split into several shards, picked
+// by hash, each with its own reader/writer lock: lookups only share the lock,
+// and threads adding or removing different names rarely contend. As before,
+// removeString() frees the entry when the last reference is removed.
 class LL_COMMON_API LLStringTable
 {
 public:
@@ -88,21 +88,20 @@ public:
 	LLStringTableEntry *addStringEntry(const std::string& str);
 	void  removeString(const char *str);
 
-	S32 mMaxEntries;
-	S32 mUniqueEntries;
-	
-#if STRING_TABLE_HASH_MAP
-#if LL_WINDOWS
-	typedef std::hash_multimap<U32, LLStringTableEntry *> string_hash_t;
-#else
-	typedef __gnu_cxx::hash_multimap<U32, LLStringTableEntry *> string_hash_t;
-#endif
-	string_hash_t mStringHash;
-#else
-	typedef std::list<LLStringTableEntry *> string_list_t;
-	typedef string_list_t * string_list_ptr_t;
-	string_list_ptr_t	*mStringList;
-#endif	
+	// Appends every string in the table, in no particular order.
+	void getStrings(std::vector<const char*>& strings) const;
+
+	S32 getUniqueEntries() const	{ return mUniqueEntries; }
+
+private:
+	struct Shard;
+
+	Shard& getShard(U32 hash) const;
+	LLStringTableEntry* find(const Shard& shard, const char* str, U32 length, U32 hash) const;
+
+	Shard* mShards;
+	U32 mBucketMask;			// Per shard.
+	std::atomic<S32> mUniqueEntries;
 };
 
 extern LL_COMMON_API LLStringTable gStringTable;
@@ -41,6 +41,7 @@
 
 #include "llprocessor.h"
 #include "llerrorcontrol.h"
+#include "lleventchannel.h"
 #include "llevents.h"
 #include "llformat.h"
 #include "lltimer.h"
@@ -1162,9 +1163,8 @@ class FrameWatcher
 {
 public:
     FrameWatcher():
-        // Hooking onto the "mainloop" event pump gets us one call per frame.
-        mConnection(LLEventPumps::instance()
-                    .obtain("mainloop")
+        // Hooking onto the mainloop channel gets us one call per frame.
+        mConnection(LLMainloopEvent::channel()
 					.listen("FrameWatcher", std::bind(&FrameWatcher::tick, this, std::placeholders::_1))),
 
         // Initializing mSampleStart to an invalid timestamp alerts us to skip
@@ -1183,7 +1183,7 @@ public:
         mSlowest(F32_MAX)
     {}
 
-    bool tick(const LLSD&)
+    bool tick(const LLMainloopEvent&)
     {
         F32 timestamp(mTimer.getElapsedTimeF32());
 
@@ -1281,7 +1281,7 @@ public:
 private:
     // Storing the connection in an LLTempBoundListener ensures it will be
     // disconnected when we're destroyed.
-    LLTempBoundListener mConnection;
+    LLEventChannel<LLMainloopEvent>::ScopedConnection mConnection;
     // Track elapsed time
     LLTimer mTimer;
     // Some of what you see here is in fact redundant with functionality you
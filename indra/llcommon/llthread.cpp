@@ -89,9 +89,13 @@ void *APR_THREAD_FUNC LLThread::staticRun(apr_thread_t *apr_threadp, void *datap
 	// Create a thread local data.
 	LLThreadLocalData::create(threadp);
 
+	LLFastTimerTrace::setThreadName(threadp->mName);
+
 	// Run the user supplied function
 	threadp->run();
 
+	LLFastTimerTrace::threadExit();
+
 	// Setting mStatus to STOPPED is done non-thread-safe, so it's
 	// possible that the thread is deleted by another thread at
 	// the moment it happens... therefore make a copy here.
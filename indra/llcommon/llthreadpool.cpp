@@ -0,0 +1,182 @@
+/** 
+ * @file llthreadpool.cpp
+ * @brief Fixed set of threads that split a loop over a range of items between them.
+ *
+ * $LicenseInfo:firstyear=2004&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llthreadpool.h"
+
+#include <boost/thread/thread.hpp>
+
+//============================================================================
+
+class LLThreadPool::WorkerThread : public LLThread
+{
+public:
+	WorkerThread(std::string const& name, LLThreadPool* pool) : LLThread(name), mPool(pool) { }
+
+protected:
+	/*virtual*/ void run(void)
+	{
+		while (true)
+		{
+			// Sleeps until runCondition() returns true or we are asked to quit.
+			checkPause();
+			if (isQuitting())
+			{
+				break;
+			}
+			while (mPool->runChunk())
+			{
+			}
+		}
+	}
+
+	/*virtual*/ bool runCondition(void)
+	{
+		return mPool->hasWork();
+	}
+
+private:
+	LLThreadPool* mPool;
+};
+
+//============================================================================
+
+LLThreadPool::LLThreadPool(std::string const& name, S32 num_threads) :
+	mJob(NULL),
+	mCount(0),
+	mChunkSize(0),
+	mNumChunks(0),
+	mNextChunk(0),
+	mPendingChunks(0)
+{
+	for (S32 i = 0; i < num_threads; ++i)
+	{
+		WorkerThread* thread = new WorkerThread(llformat("%s %d", name.c_str(), i), this);
+		mThreads.push_back(thread);
+		thread->start();
+	}
+}
+
+LLThreadPool::~LLThreadPool()
+{
+	// Ask all threads to quit first so they wind down together, the destructor waits for each.
+	for (std::vector<WorkerThread*>::iterator iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+	{
+		(*iter)->setQuitting();
+	}
+	for (std::vector<WorkerThread*>::iterator iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+	{
+		delete *iter;
+	}
+	mThreads.clear();
+}
+
+//static
+S32 LLThreadPool::getDefaultThreadCount(S32 max_threads)
+{
+	S32 cores = (S32)boost::thread::hardware_concurrency();
+	return llclamp(cores - 1, 0, max_threads);
+}
+
+void LLThreadPool::parallelFor(Job& job, S32 count, S32 chunk_size)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	chunk_size = llmax(chunk_size, 1);
+	if (mThreads.empty() || count <= chunk_size)
+	{
+		job.run(0, count);
+		return;
+	}
+
+	S32 num_chunks = (count + chunk_size - 1) / chunk_size;
+	mDoneCondition.lock();
+	mPendingChunks = num_chunks;
+	mDoneCondition.unlock();
+
+	mChunkMutex.lock();
+	mJob = &job;
+	mCount = count;
+	mChunkSize = chunk_size;
+	mNumChunks = num_chunks;
+	mNextChunk = 0;
+	mChunkMutex.unlock();
+
+	for (std::vector<WorkerThread*>::iterator iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+	{
+		(*iter)->wake();
+	}
+
+	// Help out rather than sit idle.
+	while (runChunk())
+	{
+	}
+
+	mDoneCondition.lock();
+	while (mPendingChunks > 0)
+	{
+		mDoneCondition.wait();
+	}
+	mDoneCondition.unlock();
+}
+
+bool LLThreadPool::hasWork()
+{
+	LLMutexLock lock(mChunkMutex);
+	return mNextChunk < mNumChunks;
+}
+
+bool LLThreadPool::runChunk()
+{
+	Job* job;
+	S32 begin;
+	S32 end;
+	mChunkMutex.lock();
+	if (mNextChunk >= mNumChunks)
+	{
+		mChunkMutex.unlock();
+		return false;
+	}
+	// A chunk that was handed out keeps mPendingChunks above zero,
+	// so the job can not change under us until we are done with it.
+	job = mJob;
+	begin = mNextChunk++ * mChunkSize;
+	end = llmin(begin + mChunkSize, mCount);
+	mChunkMutex.unlock();
+
+	job->run(begin, end);
+
+	mDoneCondition.lock();
+	if (--mPendingChunks == 0)
+	{
+		mDoneCondition.signal();
+	}
+	mDoneCondition.unlock();
+	return true;
+}
@@ -0,0 +1,89 @@
+/** 
+ * @file llthreadpool.h
+ * @brief Fixed set of threads that split a loop over a range of items between them.
+ *
+ * $LicenseInfo:firstyear=2004&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTHREADPOOL_H
+#define LL_LLTHREADPOOL_H
+
+#include <string>
+#include <vector>
+
+#include "llthread.h"
+
+// Fork/join helper: parallelFor() cuts [0, count) into chunks and runs them on
+// the pool threads and on the calling thread, then waits until all are done.
+// The threads sleep on their run condition between calls.
+//
+// Example Usage:
+//  struct MyJob : public LLThreadPool::Job
+//  {
+//     void run(S32 begin, S32 end) { for (S32 i = begin; i < end; ++i) work(i); }
+//  } job;
+//  pool.parallelFor(job, items.size(), 64);
+
+class LL_COMMON_API LLThreadPool
+{
+public:
+	class Job
+	{
+	public:
+		virtual ~Job() { }
+		// Process items [begin, end). Called concurrently for different chunks.
+		virtual void run(S32 begin, S32 end) = 0;
+	};
+
+	// num_threads may be 0, in which case parallelFor() simply runs the job inline.
+	LLThreadPool(std::string const& name, S32 num_threads);
+	~LLThreadPool();
+
+	// One thread less than the number of cores, so the caller has a core too, and at most max_threads.
+	static S32 getDefaultThreadCount(S32 max_threads);
+
+	S32 getNumThreads() const { return (S32)mThreads.size(); }
+
+	// Only one thread at a time may call this; the job must outlive the call.
+	void parallelFor(Job& job, S32 count, S32 chunk_size);
+
+private:
+	class WorkerThread;
+	friend class WorkerThread;
+
+	bool hasWork();
+	bool runChunk();	// Runs one chunk of the current job, false when there is none left.
+
+	std::vector<WorkerThread*> mThreads;
+
+	LLMutex mChunkMutex;		// Protects the current job.
+	Job* mJob;
+	S32 mCount;
+	S32 mChunkSize;
+	S32 mNumChunks;
+	S32 mNextChunk;
+
+	LLCondition mDoneCondition;	// Signalled when mPendingChunks drops to zero.
+	S32 mPendingChunks;
+};
+
+#endif // LL_LLTHREADPOOL_H
@@ -41,6 +41,11 @@
 #include "lltimer.h"
 #include "llthread.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LL_UUID_SSE2 1
+#endif
+
 const LLUUID LLUUID::null;
 const LLTransactionID LLTransactionID::tnull;
 
@@ -146,27 +151,135 @@ U32 janky_fast_random_seeded_bytes(U32 seed, U32 val)
 }
 #endif
 
+// Gathers the 32 hex digits of a 36 character UUID string; the dashes are skipped, not checked.
+static inline void gather_uuid_hex(const char* in, char* hex)
+{
+	memcpy(hex, in, 8);
+	memcpy(hex + 8, in + 9, 4);
+	memcpy(hex + 12, in + 14, 4);
+	memcpy(hex + 16, in + 19, 4);
+	memcpy(hex + 20, in + 24, 12);
+}
+
+// Inverse of gather_uuid_hex.
+static inline void scatter_uuid_hex(const char* hex, char* out)
+{
+	memcpy(out, hex, 8);
+	out[8] = '-';
+	memcpy(out + 9, hex + 8, 4);
+	out[13] = '-';
+	memcpy(out + 14, hex + 12, 4);
+	out[18] = '-';
+	memcpy(out + 19, hex + 16, 4);
+	out[23] = '-';
+	memcpy(out + 24, hex + 20, 12);
+}
+
+#if LL_UUID_SSE2
+// Converts 16 hex digits to nibble values. Returns false if any of them isn't a hex digit.
+static inline bool hex_to_nibbles(__m128i chars, __m128i& nibbles)
+{
+	const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+	// Bytes >= 0x80 are negative as signed chars and fail both range tests.
+	const __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+	const __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+	if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff)
+	{
+		return false;
+	}
+	const __m128i digits = _mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0')));
+	const __m128i alphas = _mm_andnot_si128(is_digit, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)));
+	nibbles = _mm_or_si128(digits, alphas);
+	return true;
+}
+
+// Packs 16 nibbles, high nibble first, into 8 bytes in the low half of each 16 bit lane.
+static inline __m128i nibbles_to_bytes(__m128i nibbles)
+{
+	const __m128i high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4);
+	const __m128i low = _mm_srli_epi16(nibbles, 8);
+	return _mm_or_si128(high, low);
+}
+
+// Converts 16 nibble values to lower case hex digits.
+static inline __m128i nibbles_to_hex(__m128i nibbles)
+{
+	const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+	return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letter);
+}
+#else
+static inline S32 hex_value(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+#endif
+
+// Parses the 32 hex digits of a canonical UUID string into bytes. Returns false, leaving
+// bytes undefined, if any of them isn't a hex digit.
+static bool parse_uuid_hex(const char* in, U8* bytes)
+{
+	char hex[32];
+	gather_uuid_hex(in, hex);
+#if LL_UUID_SSE2
+	__m128i first, second;
+	if (!hex_to_nibbles(_mm_loadu_si128((const __m128i*)hex), first) ||
+		!hex_to_nibbles(_mm_loadu_si128((const __m128i*)(hex + 16)), second))
+	{
+		return false;
+	}
+	_mm_storeu_si128((__m128i*)bytes, _mm_packus_epi16(nibbles_to_bytes(first), nibbles_to_bytes(second)));
+#else
+	for (S32 i = 0; i < UUID_BYTES; ++i)
+	{
+		S32 high = hex_value(hex[2 * i]);
+		S32 low = hex_value(hex[2 * i + 1]);
+		if (high < 0 || low < 0)
+		{
+			return false;
+		}
+		bytes[i] = (U8)((high << 4) | low);
+	}
+#endif
+	return true;
+}
+
+// Writes the canonical, lower case, 36 character form of bytes to out (not NUL terminated).
+static void format_uuid_hex(const U8* bytes, char* out)
+{
+	char hex[32];
+#if LL_UUID_SSE2
+	const __m128i data = _mm_loadu_si128((const __m128i*)bytes);
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	const __m128i high = _mm_and_si128(_mm_srli_epi16(data, 4), mask);
+	const __m128i low = _mm_and_si128(data, mask);
+	_mm_storeu_si128((__m128i*)hex, nibbles_to_hex(_mm_unpacklo_epi8(high, low)));
+	_mm_storeu_si128((__m128i*)(hex + 16), nibbles_to_hex(_mm_unpackhi_epi8(high, low)));
+#else
+	static const char digits[] = "0123456789abcdef";
+	for (S32 i = 0; i < UUID_BYTES; ++i)
+	{
+		hex[2 * i] = digits[bytes[i] >> 4];
+		hex[2 * i + 1] = digits[bytes[i] & 0x0f];
+	}
+#endif
+	scatter_uuid_hex(hex, out);
+}
+
 // Common to all UUID implementations
 void LLUUID::toString(std::string& out) const
 {
-	out = llformat(
-		"%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-		(U8)(mData[0]),
-		(U8)(mData[1]),
-		(U8)(mData[2]),
-		(U8)(mData[3]),
-		(U8)(mData[4]),
-		(U8)(mData[5]),
-		(U8)(mData[6]),
-		(U8)(mData[7]),
-		(U8)(mData[8]),
-		(U8)(mData[9]),
-		(U8)(mData[10]),
-		(U8)(mData[11]),
-		(U8)(mData[12]),
-		(U8)(mData[13]),
-		(U8)(mData[14]),
-		(U8)(mData[15]));
+	char buffer[UUID_STR_LENGTH - 1];
+	format_uuid_hex(mData, buffer);
+	out.assign(buffer, sizeof(buffer));
+}
+
+void LLUUID::toString(char* out) const
+{
+	format_uuid_hex(mData, out);
+	out[UUID_STR_LENGTH - 1] = '\0';
 }
 
 void LLUUID::toCompressedString(std::string& out) const
@@ -230,6 +343,20 @@ BOOL LLUUID::set(const std::string& in_string, BOOL emit)
 		}
 	}
 
+	if (!broken_format)
+	{
+		if (parse_uuid_hex(in_string.data(), mData))
+		{
+			return TRUE;
+		}
+		if(emit)
+		{
+			LL_WARNS() << "Invalid UUID string character" << LL_ENDL;
+		}
+		setNull();
+		return FALSE;
+	}
+
 	U8 cur_pos = 0;
 	S32 i;
 	for (i = 0; i < UUID_BYTES; i++)
@@ -301,7 +428,12 @@ BOOL LLUUID::set(const std::string& in_string, BOOL emit)
 BOOL LLUUID::validate(const std::string& in_string)
 {
 	BOOL broken_format = FALSE;
-	if (in_string.length() != (UUID_STR_LENGTH - 1))		/* Flawfinder: ignore */
+	if (in_string.length() == (UUID_STR_LENGTH - 1))		/* Flawfinder: ignore */
+	{
+		U8 bytes[UUID_BYTES];
+		return parse_uuid_hex(in_string.data(), bytes);
+	}
+	else
 	{
 		// I'm a moron.  First implementation didn't have the right UUID format.
 		if (in_string.length() == (UUID_STR_LENGTH - 2))		/* Flawfinder: ignore */
@@ -110,6 +110,7 @@ public:
 	friend LL_COMMON_API std::istream&	 operator>>(std::istream& s, LLUUID &uuid);
 
 	void toString(std::string& out) const;
+	void toString(char* out) const;		// out must hold UUID_STR_SIZE chars.
 	void toCompressedString(std::string& out) const;
 
 	std::string asString() const;
@@ -0,0 +1,270 @@
+/** 
+ * @file lluuidflatmap.h
+ * @brief Open addressing hash map keyed by LLUUID.
+ *
+ * $LicenseInfo:firstyear=2004&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUUIDFLATMAP_H
+#define LL_LLUUIDFLATMAP_H
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "lluuid.h"
+
+// Hash map from LLUUID to T for large, hot registries such as the object list.
+//
+// All entries live in one array, probed linearly, so a lookup normally touches a
+// single cache line instead of following a bucket chain. UUIDs are (nearly) random,
+// so hashing is a multiply of their two halves. Erasing shifts later entries back
+// rather than leaving tombstones, so lookups never slow down as objects come and go.
+//
+// Differences with boost::unordered_map: T must be default constructible (an erased
+// slot is reset to T(), which releases LLPointers), inserting or erasing invalidates
+// all iterators, and the key of an entry must not be changed through an iterator.
+template <typename T>
+class LLUUIDFlatMap
+{
+public:
+	typedef LLUUID key_type;
+	typedef T mapped_type;
+	typedef std::pair<LLUUID, T> value_type;
+	typedef size_t size_type;
+
+private:
+	template <typename V, typename MAP>
+	class iterator_base
+	{
+	public:
+		iterator_base() : mMap(NULL), mIndex(0) { }
+		iterator_base(MAP* map, size_t index) : mMap(map), mIndex(index) { skipUnused(); }
+		// Allows conversion from iterator to const_iterator.
+		template <typename V2, typename MAP2>
+		iterator_base(const iterator_base<V2, MAP2>& other) : mMap(other.mMap), mIndex(other.mIndex) { }
+
+		V& operator*() const { return mMap->mSlots[mIndex]; }
+		V* operator->() const { return &mMap->mSlots[mIndex]; }
+		iterator_base& operator++() { ++mIndex; skipUnused(); return *this; }
+		iterator_base operator++(int) { iterator_base tmp(*this); ++*this; return tmp; }
+		template <typename V2, typename MAP2>
+		bool operator==(const iterator_base<V2, MAP2>& other) const { return mIndex == other.mIndex; }
+		template <typename V2, typename MAP2>
+		bool operator!=(const iterator_base<V2, MAP2>& other) const { return mIndex != other.mIndex; }
+
+	private:
+		template <typename V2, typename MAP2> friend class iterator_base;
+		friend class LLUUIDFlatMap;
+
+		void skipUnused()
+		{
+			while (mIndex < mMap->mUsed.size() && !mMap->mUsed[mIndex])
+			{
+				++mIndex;
+			}
+		}
+
+		MAP* mMap;
+		size_t mIndex;
+	};
+
+public:
+	typedef iterator_base<value_type, LLUUIDFlatMap> iterator;
+	typedef iterator_base<const value_type, const LLUUIDFlatMap> const_iterator;
+
+	LLUUIDFlatMap() : mSize(0), mShift(64) { }
+
+	size_type size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+	size_type capacity() const { return mSlots.size(); }
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, mSlots.size()); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, mSlots.size()); }
+
+	iterator find(const LLUUID& key)
+	{
+		size_t index = findIndex(key);
+		return iterator(this, index);
+	}
+
+	const_iterator find(const LLUUID& key) const
+	{
+		size_t index = findIndex(key);
+		return const_iterator(this, index);
+	}
+
+	size_type count(const LLUUID& key) const { return findIndex(key) != mSlots.size() ? 1 : 0; }
+
+	T& operator[](const LLUUID& key)
+	{
+		return insert(value_type(key, T())).first->second;
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		if (mSlots.empty() || (mSize + 1) * 4 > mSlots.size() * 3)
+		{
+			rehash(mSlots.empty() ? MIN_CAPACITY : mSlots.size() * 2);
+		}
+		size_t const mask = mSlots.size() - 1;
+		for (size_t index = bucket(value.first);; index = (index + 1) & mask)
+		{
+			if (!mUsed[index])
+			{
+				mUsed[index] = 1;
+				mSlots[index] = value;
+				++mSize;
+				return std::make_pair(iterator(this, index), true);
+			}
+			if (mSlots[index].first == value.first)
+			{
+				return std::make_pair(iterator(this, index), false);
+			}
+		}
+	}
+
+	size_type erase(const LLUUID& key)
+	{
+		size_t index = findIndex(key);
+		if (index == mSlots.size())
+		{
+			return 0;
+		}
+		eraseIndex(index);
+		return 1;
+	}
+
+	void erase(iterator iter)
+	{
+		eraseIndex(iter.mIndex);
+	}
+
+	void clear()
+	{
+		mSlots.clear();
+		mUsed.clear();
+		mSize = 0;
+		mShift = 64;
+	}
+
+	// Makes room for count entries without rehashing.
+	void reserve(size_type count)
+	{
+		size_t capacity = MIN_CAPACITY;
+		while (capacity * 3 < count * 4)
+		{
+			capacity *= 2;
+		}
+		if (capacity > mSlots.size())
+		{
+			rehash(capacity);
+		}
+	}
+
+private:
+	enum { MIN_CAPACITY = 16 };
+
+	size_t bucket(const LLUUID& key) const
+	{
+		U64 words[2];
+		memcpy(words, key.mData, sizeof(words));
+		// Fibonacci hashing: the top bits of the product depend on all the bits of the key.
+		return (size_t)(((words[0] ^ (words[1] * 0x9e3779b97f4a7c15ULL)) * 0x9e3779b97f4a7c15ULL) >> mShift);
+	}
+
+	size_t findIndex(const LLUUID& key) const
+	{
+		if (mSize == 0)
+		{
+			return mSlots.size();
+		}
+		size_t const mask = mSlots.size() - 1;
+		for (size_t index = bucket(key);; index = (index + 1) & mask)
+		{
+			if (!mUsed[index])
+			{
+				return mSlots.size();
+			}
+			if (mSlots[index].first == key)
+			{
+				return index;
+			}
+		}
+	}
+
+	void eraseIndex(size_t index)
+	{
+		size_t const mask = mSlots.size() - 1;
+		for (size_t next = (index + 1) & mask; mUsed[next]; next = (next + 1) & mask)
+		{
+			// Move the entry at next back into the hole if the hole lies between its bucket and next.
+			size_t home = bucket(mSlots[next].first);
+			if (((next - home) & mask) >= ((next - index) & mask))
+			{
+				std::swap(mSlots[index], mSlots[next]);
+				index = next;
+			}
+		}
+		mUsed[index] = 0;
+		mSlots[index] = value_type();
+		--mSize;
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<value_type> slots(capacity);
+		std::vector<U8> used(capacity, 0);
+		slots.swap(mSlots);
+		used.swap(mUsed);
+		mSize = 0;
+		mShift = 64;
+		for (size_t size = capacity; size > 1; size >>= 1)
+		{
+			--mShift;
+		}
+		size_t const mask = capacity - 1;
+		for (size_t i = 0; i < used.size(); ++i)
+		{
+			if (used[i])
+			{
+				size_t index = bucket(slots[i].first);
+				while (mUsed[index])
+				{
+					index = (index + 1) & mask;
+				}
+				mUsed[index] = 1;
+				std::swap(mSlots[index], slots[i]);
+				++mSize;
+			}
+		}
+	}
+
+	std::vector<value_type> mSlots;
+	std::vector<U8> mUsed;
+	size_t mSize;
+	S32 mShift;		// 64 - log2(capacity)
+};
+
+#endif
@@ -40,6 +40,11 @@
 #include "llimageworker.h"
 #include "llmemory.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LL_IMAGE_SSE2 1
+#endif
+
 //---------------------------------------------------------------------------
 // LLImage
 //---------------------------------------------------------------------------
@@ -284,6 +289,7 @@ U8* LLImageBase::allocateDataSize(S32 width, S32 height, S32 ncomponents, S32 si
 AIThreadSafeSimpleDC<S64> LLImageRaw::sGlobalRawMemory;
 S32 LLImageRaw::sRawImageCount = 0;
 S32 LLImageRaw::sRawImageCachedCount = 0;
+bool LLImageRaw::sUseSIMD = true;
 
 LLImageRaw::LLImageRaw()
 	: LLImageBase(), mCacheEntries(0)
@@ -497,22 +503,25 @@ void LLImageRaw::verticalFlip()
 {
 	S32 row_bytes = getWidth() * getComponents();
 	llassert(row_bytes > 0);
-	try
-	{
-	std::vector<U8> line_buffer(row_bytes);
-	S32 mid_row = getHeight() / 2;
-	for( S32 row = 0; row < mid_row; row++ )
-	{
-		U8* row_a_data = getData() + row * row_bytes;
-		U8* row_b_data = getData() + (getHeight() - 1 - row) * row_bytes;
-		memcpy( &line_buffer[0], row_a_data,  row_bytes );
-		memcpy( row_a_data,  row_b_data,  row_bytes );
-		memcpy( row_b_data,  &line_buffer[0], row_bytes );
-	}
-	}
-	catch(std::bad_alloc)
-	{
-		LL_ERRS() << "Out of memory in LLImageRaw::verticalFlip()" << LL_ENDL;
+	// Swap the rows in place, rather than through a line buffer.
+	U8* row_a_data = getData();
+	U8* row_b_data = getData() + (getHeight() - 1) * row_bytes;
+	for( ; row_a_data < row_b_data; row_a_data += row_bytes, row_b_data -= row_bytes )
+	{
+		S32 i = 0;
+#if LL_IMAGE_SSE2
+		for( ; i + 16 <= row_bytes; i += 16 )
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(row_a_data + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(row_b_data + i));
+			_mm_storeu_si128((__m128i*)(row_a_data + i), b);
+			_mm_storeu_si128((__m128i*)(row_b_data + i), a);
+		}
+#endif
+		for( ; i < row_bytes; i++ )
+		{
+			std::swap(row_a_data[i], row_b_data[i]);
+		}
 	}
 }
 
@@ -588,6 +597,394 @@ void LLImageRaw::biasedScaleToPowerOfTwo(S32 target_width, S32 target_height, S3
 
 
 
+//----------------------------------------------------------------------------
+// Resampling and compositing kernels
+//
+// The box filter of copyLineScaled() averages, for each output pixel, the
+// input pixels index0 to index1, weighting the first by fract0 and the last
+// by fract1. The kernels below do the same arithmetic in the same order and
+// in single precision, so whichever of them runs, the output is bit for bit
+// what the scalar code produces.
+
+struct box_span_t
+{
+	S32 index0;
+	S32 index1;
+	F32 fract0;
+	F32 fract1;
+};
+
+// Avoid floating point accumulation error... don't just add ratio each time.  JC
+inline static void get_box_span(S32 x, F32 ratio, box_span_t& span)
+{
+	const F32 sample0 = x * ratio;
+	const F32 sample1 = (x + 1) * ratio;
+	span.index0 = llfloor(sample0);
+	span.index1 = llfloor(sample1);
+	span.fract0 = 1.f - (sample0 - F32(span.index0));
+	span.fract1 = sample1 - F32(span.index1);
+}
+
+// Returns n when in_len is exactly 2^n times out_len, with 1 <= n <= 8, else 0.
+// The box filter then has no fractional weights and its float result is the
+// rounded integer average, which is cheaper to compute as such.
+static S32 get_box_shift(S32 in_len, S32 out_len)
+{
+	if (out_len <= 0 || in_len % out_len)
+	{
+		return 0;
+	}
+	S32 ratio = in_len / out_len;
+	S32 shift = 0;
+	while ((1 << shift) < ratio && shift < 8)
+	{
+		shift++;
+	}
+	return (1 << shift) == ratio ? shift : 0;
+}
+
+// Resizes an image vertically. Rows are resampled as a whole, which keeps
+// the reads sequential, unlike calling copyLineScaled() for every column.
+// Every byte is filtered independently, so the number of components does
+// not matter.
+static void copy_rows_scaled(const U8* in, U8* out, S32 row_bytes, S32 in_rows, S32 out_rows)
+{
+	const S32 shift = get_box_shift(in_rows, out_rows);
+	if (shift)
+	{
+		const S32 ratio = 1 << shift;
+		for (S32 y = 0; y < out_rows; y++, out += row_bytes)
+		{
+			const U8* first = in + (size_t)y * ratio * row_bytes;
+			S32 i = 0;
+#if LL_IMAGE_SSE2
+			if (LLImageRaw::sUseSIMD)
+			{
+				if (shift == 1)
+				{
+					// _mm_avg_epu8 rounds exactly like the filter does.
+					for ( ; i + 16 <= row_bytes; i += 16)
+					{
+						__m128i a = _mm_loadu_si128((const __m128i*)(first + i));
+						__m128i b = _mm_loadu_si128((const __m128i*)(first + row_bytes + i));
+						_mm_storeu_si128((__m128i*)(out + i), _mm_avg_epu8(a, b));
+					}
+				}
+				else
+				{
+					const __m128i zero = _mm_setzero_si128();
+					const __m128i round = _mm_set1_epi16(ratio >> 1);
+					const __m128i count = _mm_cvtsi32_si128(shift);
+					for ( ; i + 16 <= row_bytes; i += 16)
+					{
+						// At most 256 * 255 + 128, which fits in 16 bits.
+						__m128i lo = round;
+						__m128i hi = round;
+						for (S32 k = 0; k < ratio; k++)
+						{
+							__m128i b = _mm_loadu_si128((const __m128i*)(first + k * row_bytes + i));
+							lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(b, zero));
+							hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(b, zero));
+						}
+						lo = _mm_srl_epi16(lo, count);
+						hi = _mm_srl_epi16(hi, count);
+						_mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+					}
+				}
+			}
+#endif
+			for ( ; i < row_bytes; i++)
+			{
+				U32 sum = ratio >> 1;
+				for (S32 k = 0; k < ratio; k++)
+				{
+					sum += first[k * row_bytes + i];
+				}
+				out[i] = U8(sum >> shift);
+			}
+		}
+		return;
+	}
+
+	const F32 ratio = F32(in_rows) / out_rows; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+	box_span_t span;
+	for (S32 y = 0; y < out_rows; y++, out += row_bytes)
+	{
+		get_box_span(y, ratio, span);
+		const U8* row0 = in + (size_t)span.index0 * row_bytes;
+		if (span.index0 == span.index1)
+		{
+			// Interval is embedded in one input row
+			memcpy(out, row0, row_bytes);	/* Flawfinder: ignore */
+			continue;
+		}
+		// Watch out for reading off of end of input array.
+		const U8* row1 = (span.fract1 && span.index1 < in_rows) ? in + (size_t)span.index1 * row_bytes : NULL;
+		S32 i = 0;
+#if LL_IMAGE_SSE2
+		if (LLImageRaw::sUseSIMD)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 fract0 = _mm_set1_ps(span.fract0);
+			const __m128 fract1 = _mm_set1_ps(span.fract1);
+			const __m128 norm = _mm_set1_ps(norm_factor);
+			const __m128 half = _mm_set1_ps(.5f);
+			for ( ; i + 16 <= row_bytes; i += 16)
+			{
+				__m128 sum[4];
+				__m128i b = _mm_loadu_si128((const __m128i*)(row0 + i));
+				__m128i lo = _mm_unpacklo_epi8(b, zero);
+				__m128i hi = _mm_unpackhi_epi8(b, zero);
+				sum[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), fract0);
+				sum[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), fract0);
+				sum[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), fract0);
+				sum[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), fract0);
+				for (S32 u = span.index0 + 1; u < span.index1; u++)
+				{
+					b = _mm_loadu_si128((const __m128i*)(in + (size_t)u * row_bytes + i));
+					lo = _mm_unpacklo_epi8(b, zero);
+					hi = _mm_unpackhi_epi8(b, zero);
+					sum[0] = _mm_add_ps(sum[0], _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+					sum[1] = _mm_add_ps(sum[1], _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+					sum[2] = _mm_add_ps(sum[2], _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+					sum[3] = _mm_add_ps(sum[3], _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+				}
+				if (row1)
+				{
+					b = _mm_loadu_si128((const __m128i*)(row1 + i));
+					lo = _mm_unpacklo_epi8(b, zero);
+					hi = _mm_unpackhi_epi8(b, zero);
+					sum[0] = _mm_add_ps(sum[0], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), fract1));
+					sum[1] = _mm_add_ps(sum[1], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), fract1));
+					sum[2] = _mm_add_ps(sum[2], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), fract1));
+					sum[3] = _mm_add_ps(sum[3], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), fract1));
+				}
+				// ll_pos_round()
+				__m128i v0 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum[0], norm), half));
+				__m128i v1 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum[1], norm), half));
+				__m128i v2 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum[2], norm), half));
+				__m128i v3 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum[3], norm), half));
+				_mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3)));
+			}
+		}
+#endif
+		for ( ; i < row_bytes; i++)
+		{
+			F32 sum = row0[i] * span.fract0;
+			for (S32 u = span.index0 + 1; u < span.index1; u++)
+			{
+				sum += in[(size_t)u * row_bytes + i];
+			}
+			if (row1)
+			{
+				sum += row1[i] * span.fract1;
+			}
+			out[i] = U8(ll_pos_round(sum * norm_factor));
+		}
+	}
+}
+
+#if LL_IMAGE_SSE2
+// One pixel of up to four components in the low 16 bit lanes. The bytes are
+// assembled in a register: going through memory would stall on the partial
+// store when C is 3.
+template<S32 C>
+inline static __m128i load_pixel_epi16(const U8* p)
+{
+	U32 bytes = 0;
+	if (C == 4)
+	{
+		memcpy(&bytes, p, 4);	/* Flawfinder: ignore */
+	}
+	else for (S32 i = 0; i < C; i++)
+	{
+		bytes |= (U32)p[i] << (8 * i);
+	}
+	return _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), _mm_setzero_si128());
+}
+
+template<S32 C>
+inline static __m128 load_pixel_ps(const U8* p)
+{
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(load_pixel_epi16<C>(p), _mm_setzero_si128()));
+}
+
+// Stores the low C 16 bit lanes as bytes.
+template<S32 C>
+inline static void store_pixel_epi16(U8* p, __m128i v)
+{
+	U32 bytes = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+	if (C == 4)
+	{
+		memcpy(p, &bytes, 4);	/* Flawfinder: ignore */
+	}
+	else for (S32 i = 0; i < C; i++)
+	{
+		p[i] = U8(bytes >> (8 * i));
+	}
+}
+
+// The box filter for one output pixel, with the channels in the four lanes.
+template<S32 C>
+inline static __m128 box_filter_pixel(const U8* in, S32 in_pixel_len, const box_span_t& span)
+{
+	__m128 sum = _mm_mul_ps(load_pixel_ps<C>(in + span.index0 * C), _mm_set1_ps(span.fract0));
+	for (S32 u = span.index0 + 1; u < span.index1; u++)
+	{
+		sum = _mm_add_ps(sum, load_pixel_ps<C>(in + u * C));
+	}
+	// Watch out for reading off of end of input array.
+	if (span.fract1 && span.index1 < in_pixel_len)
+	{
+		sum = _mm_add_ps(sum, _mm_mul_ps(load_pixel_ps<C>(in + span.index1 * C), _mm_set1_ps(span.fract1)));
+	}
+	return sum;
+}
+
+// copyLineScaled() for contiguous pixels.
+template<S32 C>
+static void copy_line_scaled(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len)
+{
+	const S32 shift = get_box_shift(in_pixel_len, out_pixel_len);
+	if (shift)
+	{
+		const S32 ratio = 1 << shift;
+		S32 x = 0;
+		if (C == 4 && shift == 1)
+		{
+			// Pairs of pixels: average the even ones with the odd ones.
+			for ( ; x + 4 <= out_pixel_len; x += 4)
+			{
+				__m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(in + x * 8)));
+				__m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(in + x * 8 + 16)));
+				__m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+				__m128i odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+				_mm_storeu_si128((__m128i*)(out + x * 4), _mm_avg_epu8(even, odd));
+			}
+		}
+		const __m128i round = _mm_set1_epi16(ratio >> 1);
+		const __m128i count = _mm_cvtsi32_si128(shift);
+		for ( ; x < out_pixel_len; x++)
+		{
+			const U8* p = in + x * ratio * C;
+			__m128i sum = round;
+			for (S32 k = 0; k < ratio; k++)
+			{
+				sum = _mm_add_epi16(sum, load_pixel_epi16<C>(p + k * C));
+			}
+			store_pixel_epi16<C>(out + x * C, _mm_srl_epi16(sum, count));
+		}
+		return;
+	}
+
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const __m128 norm = _mm_set1_ps(1.f / ratio);
+	const __m128 half = _mm_set1_ps(.5f);
+	box_span_t span;
+	for (S32 x = 0; x < out_pixel_len; x++)
+	{
+		get_box_span(x, ratio, span);
+		if (span.index0 == span.index1)
+		{
+			// Interval is embedded in one input pixel
+			memcpy(out + x * C, in + span.index0 * C, C);	/* Flawfinder: ignore */
+			continue;
+		}
+		__m128 sum = box_filter_pixel<C>(in, in_pixel_len, span);
+		__m128i v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum, norm), half));
+		store_pixel_epi16<C>(out + x * C, _mm_packs_epi32(v, v));
+	}
+}
+
+// fastFractionalMult() of eight 16 bit lanes.
+inline static __m128i fractional_mult(__m128i a, __m128i b)
+{
+	__m128i i = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(i, _mm_srli_epi16(i, 8)), 8);
+}
+
+// Blends two RGBA pixels in 16 bit lanes onto two RGB(x) pixels. Unlike the
+// scalar code this does not test for alpha 0 and 255, where the formula
+// gives back dst and src exactly.
+inline static __m128i blend_over(__m128i dst, __m128i src)
+{
+	__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0xff), 0xff);
+	__m128i transparency = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+	return _mm_add_epi16(fractional_mult(dst, transparency), fractional_mult(src, alpha));
+}
+
+// compositeRowScaled4onto3().
+static void composite_row_scaled_4onto3(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len)
+{
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const __m128 norm = _mm_set1_ps(1.f / ratio);
+	const __m128 half = _mm_set1_ps(.5f);
+	box_span_t span;
+	for (S32 x = 0; x < out_pixel_len; x++, out += 3)
+	{
+		get_box_span(x, ratio, span);
+		__m128i src;
+		if (span.index0 == span.index1)
+		{
+			src = load_pixel_epi16<4>(in + span.index0 * 4);
+		}
+		else
+		{
+			__m128 sum = box_filter_pixel<4>(in, in_pixel_len, span);
+			__m128i v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum, norm), half));
+			src = _mm_packs_epi32(v, v);
+		}
+		store_pixel_epi16<3>(out, blend_over(load_pixel_epi16<3>(out), src));
+	}
+}
+
+// compositeUnscaled4onto3() of four pixels at a time. Returns the number of
+// pixels done; the last few are left to the caller, because each step loads
+// 16 bytes of the destination.
+static S32 composite_unscaled_4onto3(const U8* src, U8* dst, S32 pixels)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+	const __m128i rgb_mask0 = _mm_setr_epi32(0x00ffffff, 0, 0, 0);
+	const __m128i rgb_mask1 = _mm_setr_epi32(0, 0x00ffffff, 0, 0);
+	const __m128i rgb_mask2 = _mm_setr_epi32(0, 0, 0x00ffffff, 0);
+	const __m128i rgb_mask3 = _mm_setr_epi32(0, 0, 0, 0x00ffffff);
+	S32 i = 0;
+	for ( ; i + 6 <= pixels; i += 4, src += 16, dst += 12)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)src);
+		__m128i alpha = _mm_and_si128(s, alpha_mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xffff)
+		{
+			// All transparent: nothing to do.
+			continue;
+		}
+		__m128i result = s;
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask)) != 0xffff)
+		{
+			// Spread the destination pixels to one per 32 bit lane.
+			__m128i d = _mm_loadu_si128((const __m128i*)dst);
+			d = _mm_unpacklo_epi64(_mm_unpacklo_epi32(d, _mm_srli_si128(d, 3)),
+								   _mm_unpacklo_epi32(_mm_srli_si128(d, 6), _mm_srli_si128(d, 9)));
+			__m128i lo = blend_over(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+			__m128i hi = blend_over(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+			result = _mm_packus_epi16(lo, hi);
+		}
+		// And pack them back into 12 bytes.
+		__m128i packed = _mm_and_si128(result, rgb_mask0);
+		packed = _mm_or_si128(packed, _mm_srli_si128(_mm_and_si128(result, rgb_mask1), 1));
+		packed = _mm_or_si128(packed, _mm_srli_si128(_mm_and_si128(result, rgb_mask2), 2));
+		packed = _mm_or_si128(packed, _mm_srli_si128(_mm_and_si128(result, rgb_mask3), 3));
+		_mm_storel_epi64((__m128i*)dst, packed);
+		U32 last = _mm_cvtsi128_si32(_mm_srli_si128(packed, 8));
+		memcpy(dst + 8, &last, 4);	/* Flawfinder: ignore */
+	}
+	return i;
+}
+#endif // LL_IMAGE_SSE2
+
+
 // Calculates (U8)(255*(a/255.f)*(b/255.f) + 0.5f).  Thanks, Jim Blinn!
 inline U8 LLImageRaw::fastFractionalMult( U8 a, U8 b )
 {
@@ -647,10 +1044,7 @@ void LLImageRaw::compositeScaled4onto3(LLImageRaw* src)
 	std::vector<U8> temp_buffer(temp_data_size);
 
 	// Vertical: scale but no composite
-	for( S32 col = 0; col < src->getWidth(); col++ )
-	{
-		copyLineScaled( src->getData() + (src->getComponents() * col), &temp_buffer[0] + (src->getComponents() * col), src->getHeight(), dst->getHeight(), src->getWidth(), src->getWidth() );
-	}
+	copy_rows_scaled( src->getData(), &temp_buffer[0], src->getComponents() * src->getWidth(), src->getHeight(), dst->getHeight() );
 
 	// Horizontal: scale and composite
 	for( S32 row = 0; row < dst->getHeight(); row++ )
@@ -692,6 +1086,15 @@ void LLImageRaw::compositeUnscaled4onto3( LLImageRaw* src )
 	U8* src_data = src->getData();
 	U8* dst_data = dst->getData();
 	S32 pixels = getWidth() * getHeight();
+#if LL_IMAGE_SSE2
+	if( sUseSIMD )
+	{
+		S32 done = composite_unscaled_4onto3( src_data, dst_data, pixels );
+		src_data += 4 * done;
+		dst_data += 3 * done;
+		pixels -= done;
+	}
+#endif
 	while( pixels-- )
 	{
 		U8 alpha = src_data[3];
@@ -880,14 +1283,18 @@ void LLImageRaw::copyUnscaled4onto3( LLImageRaw* src )
 	S32 pixels = getWidth() * getHeight();
 	U8* src_data = src->getData();
 	U8* dst_data = dst->getData();
-	for( S32 i=0; i<pixels; i++ )
+	// Copy whole pixels. The fourth byte lands on the next destination pixel,
+	// which is written over right after; the last pixel is copied alone.
+	for( S32 i=1; i<pixels; i++ )
 	{
-		dst_data[0] = src_data[0];
-		dst_data[1] = src_data[1];
-		dst_data[2] = src_data[2];
+		memcpy( dst_data, src_data, 4 );	/* Flawfinder: ignore */
 		src_data += 4;
 		dst_data += 3;
 	}
+	if( pixels > 0 )
+	{
+		memcpy( dst_data, src_data, 3 );	/* Flawfinder: ignore */
+	}
 }
 
 
@@ -902,15 +1309,20 @@ void LLImageRaw::copyUnscaled3onto4( LLImageRaw* src )
 	S32 pixels = getWidth() * getHeight();
 	U8* src_data = src->getData();
 	U8* dst_data = dst->getData();
-	for( S32 i=0; i<pixels; i++ )
+	// Copy four bytes, the last of which belongs to the next source pixel,
+	// except for the last pixel.
+	for( S32 i=1; i<pixels; i++ )
 	{
-		dst_data[0] = src_data[0];
-		dst_data[1] = src_data[1];
-		dst_data[2] = src_data[2];
+		memcpy( dst_data, src_data, 4 );	/* Flawfinder: ignore */
 		dst_data[3] = 255;
 		src_data += 3;
 		dst_data += 4;
 	}
+	if( pixels > 0 )
+	{
+		memcpy( dst_data, src_data, 3 );	/* Flawfinder: ignore */
+		dst_data[3] = 255;
+	}
 }
 
 
@@ -935,10 +1347,7 @@ void LLImageRaw::copyScaled( LLImageRaw* src )
 	std::vector<U8> temp_buffer(temp_data_size);
 
 	// Vertical
-	for( S32 col = 0; col < src->getWidth(); col++ )
-	{
-		copyLineScaled( src->getData() + (getComponents() * col), &temp_buffer[0] + (getComponents() * col), src->getHeight(), dst->getHeight(), src->getWidth(), src->getWidth() );
-	}
+	copy_rows_scaled( src->getData(), &temp_buffer[0], getComponents() * src->getWidth(), src->getHeight(), dst->getHeight() );
 
 	// Horizontal
 	for( S32 row = 0; row < dst->getHeight(); row++ )
@@ -1025,10 +1434,7 @@ BOOL LLImageRaw::scale( S32 new_width, S32 new_height, BOOL scale_image_data )
 			// Resize vertically.
 			old_buffer = LLImageBase::release();
 			new_buffer = allocateDataSize(old_width, new_height, getComponents());
-			for (S32 col = 0; col < old_width; ++col)
-			{
-				copyLineScaled(old_buffer + getComponents() * col, new_buffer + getComponents() * col, old_height, new_height, old_width, old_width);
-			}
+			copy_rows_scaled(old_buffer, new_buffer, old_width_bytes, old_height, new_height);
 			LLImageBase::deleteData(old_buffer);
 		}
 		if (new_width != old_width)
@@ -1079,6 +1485,19 @@ void LLImageRaw::copyLineScaled( U8* in, U8* out, S32 in_pixel_len, S32 out_pixe
 	const S32 components = getComponents();
 	llassert( components >= 1 && components <= 4 );
 
+#if LL_IMAGE_SSE2
+	if( sUseSIMD && in_pixel_step == 1 && out_pixel_step == 1 )
+	{
+		switch( components )
+		{
+		case 1: copy_line_scaled<1>( in, out, in_pixel_len, out_pixel_len ); return;
+		case 2: copy_line_scaled<2>( in, out, in_pixel_len, out_pixel_len ); return;
+		case 3: copy_line_scaled<3>( in, out, in_pixel_len, out_pixel_len ); return;
+		case 4: copy_line_scaled<4>( in, out, in_pixel_len, out_pixel_len ); return;
+		}
+	}
+#endif
+
 	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
 	const F32 norm_factor = 1.f / ratio;
 
@@ -1193,6 +1612,14 @@ void LLImageRaw::compositeRowScaled4onto3( U8* in, U8* out, S32 in_pixel_len, S3
 	const S32 IN_COMPONENTS = 4;
 	const S32 OUT_COMPONENTS = 3;
 
+#if LL_IMAGE_SSE2
+	if( sUseSIMD )
+	{
+		composite_row_scaled_4onto3( in, out, in_pixel_len, out_pixel_len );
+		return;
+	}
+#endif
+
 	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
 	const F32 norm_factor = 1.f / ratio;
 
@@ -1217,9 +1644,9 @@ void LLImageRaw::compositeRowScaled4onto3( U8* in, U8* out, S32 in_pixel_len, S3
 			// Interval is embedded in one input pixel
 			S32 t1 = index0 * IN_COMPONENTS;
 			in_scaled_r = in[t1 + 0];
-			in_scaled_g = in[t1 + 0];
-			in_scaled_b = in[t1 + 0];
-			in_scaled_a = in[t1 + 0];
+			in_scaled_g = in[t1 + 1];
+			in_scaled_b = in[t1 + 2];
+			in_scaled_a = in[t1 + 3];
 		}
 		else
 		{
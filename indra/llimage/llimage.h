@@ -262,6 +262,10 @@ protected:
 public:
 	static AIThreadSafeSimpleDC<S64> sGlobalRawMemory;
 	static S32 sRawImageCount;
+	// Use the SSE2 scaling and compositing kernels where they are compiled
+	// in. Their output is the same as that of the scalar code, which remains
+	// for comparison.
+	static bool sUseSIMD;
 
 	static S32 sRawImageCachedCount;
 	S32 mCacheEntries;
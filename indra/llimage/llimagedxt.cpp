@@ -28,6 +28,342 @@
 #include "llimagedxt.h"
 #include "llmemory.h"
 
+//============================================================================
+// CPU block codec for DXT1 (DXR1) and DXT5 (DXR5). The encoder fits the
+// colour endpoints along the principal axis of the block and refines them
+// once by least squares; good enough for a cache of already lossy textures,
+// and a few milliseconds per megapixel.
+
+namespace
+{
+	inline U16 pack_565(const F32* color)
+	{
+		S32 r = llclamp((S32)(color[0] * (31.f / 255.f) + .5f), 0, 31);
+		S32 g = llclamp((S32)(color[1] * (63.f / 255.f) + .5f), 0, 63);
+		S32 b = llclamp((S32)(color[2] * (31.f / 255.f) + .5f), 0, 31);
+		return (U16)((r << 11) | (g << 5) | b);
+	}
+
+	inline void unpack_565(U16 packed, S32* color)
+	{
+		S32 r = (packed >> 11) & 0x1f;
+		S32 g = (packed >> 5) & 0x3f;
+		S32 b = packed & 0x1f;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// The four colours of a block; palette[3] is black in the three colour
+	// mode DXT1 uses when c0 <= c1.
+	void make_palette(U16 c0, U16 c1, bool four_colors, S32 palette[4][3])
+	{
+		unpack_565(c0, palette[0]);
+		unpack_565(c1, palette[1]);
+		for (S32 i = 0; i < 3; ++i)
+		{
+			if (four_colors)
+			{
+				palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+				palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+			}
+			else
+			{
+				palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+				palette[3][i] = 0;
+			}
+		}
+	}
+
+	// Picks the palette entry for each pixel by projecting it on the line
+	// between the endpoints (4 colour mode, palette[0] != palette[1]);
+	// returns the packed indices and the squared error in error.
+	U32 match_colors(const U8* block, const S32 palette[4][3], S32& error)
+	{
+		// Position along the line, 0 at palette[1] to 3 at palette[0], to index.
+		static const U32 order[4] = { 1, 3, 2, 0 };
+		S32 dir[3] = { palette[0][0] - palette[1][0], palette[0][1] - palette[1][1], palette[0][2] - palette[1][2] };
+		S32 len2 = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2];
+		U32 indices = 0;
+		error = 0;
+		for (S32 i = 0; i < 16; ++i)
+		{
+			const U8* px = block + i * 4;
+			S32 t = (px[0] - palette[1][0]) * dir[0] + (px[1] - palette[1][1]) * dir[1] + (px[2] - palette[1][2]) * dir[2];
+			S32 scaled = t * 6 + len2;
+			S32 step = (scaled >= 2 * len2) + (scaled >= 4 * len2) + (scaled >= 6 * len2);
+			U32 index = order[step];
+			S32 dr = px[0] - palette[index][0];
+			S32 dg = px[1] - palette[index][1];
+			S32 db = px[2] - palette[index][2];
+			error += dr * dr + dg * dg + db * db;
+			indices |= index << (i * 2);
+		}
+		return indices;
+	}
+
+	// Least squares endpoints for the given indices (4 colour mode).
+	bool refine_endpoints(const U8* block, U32 indices, F32* c0, F32* c1)
+	{
+		static const F32 weights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+		F32 aa = 0.f, ab = 0.f, bb = 0.f;
+		F32 ax[3] = { 0.f, 0.f, 0.f };
+		F32 bx[3] = { 0.f, 0.f, 0.f };
+		for (S32 i = 0; i < 16; ++i)
+		{
+			F32 a = weights[(indices >> (i * 2)) & 3];
+			F32 b = 1.f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (S32 k = 0; k < 3; ++k)
+			{
+				ax[k] += a * block[i * 4 + k];
+				bx[k] += b * block[i * 4 + k];
+			}
+		}
+		F32 det = aa * bb - ab * ab;
+		if (fabsf(det) < 1e-6f)
+		{
+			return false;
+		}
+		F32 inv = 1.f / det;
+		for (S32 k = 0; k < 3; ++k)
+		{
+			c0[k] = llclamp((ax[k] * bb - bx[k] * ab) * inv, 0.f, 255.f);
+			c1[k] = llclamp((bx[k] * aa - ax[k] * ab) * inv, 0.f, 255.f);
+		}
+		return true;
+	}
+
+	// Builds the block with c0 > c1 so that it decodes in four colour mode
+	// both as DXT1 and as the colour half of DXT5.
+	void emit_color_block(U16 c0, U16 c1, U32 indices, U8* out)
+	{
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+			indices ^= 0x55555555;	// 0 <-> 1, 2 <-> 3
+		}
+		else if (c0 == c1)
+		{
+			indices = 0;
+		}
+		out[0] = (U8)c0;
+		out[1] = (U8)(c0 >> 8);
+		out[2] = (U8)c1;
+		out[3] = (U8)(c1 >> 8);
+		out[4] = (U8)indices;
+		out[5] = (U8)(indices >> 8);
+		out[6] = (U8)(indices >> 16);
+		out[7] = (U8)(indices >> 24);
+	}
+
+	// block: 16 RGBA pixels, row major.
+	void encode_color_block(const U8* block, U8* out)
+	{
+		F32 mean[3] = { 0.f, 0.f, 0.f };
+		for (S32 i = 0; i < 16; ++i)
+		{
+			for (S32 k = 0; k < 3; ++k)
+			{
+				mean[k] += block[i * 4 + k];
+			}
+		}
+		for (S32 k = 0; k < 3; ++k)
+		{
+			mean[k] *= 1.f / 16.f;
+		}
+		F32 cov[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+		for (S32 i = 0; i < 16; ++i)
+		{
+			F32 r = block[i * 4] - mean[0];
+			F32 g = block[i * 4 + 1] - mean[1];
+			F32 b = block[i * 4 + 2] - mean[2];
+			cov[0] += r * r;
+			cov[1] += r * g;
+			cov[2] += r * b;
+			cov[3] += g * g;
+			cov[4] += g * b;
+			cov[5] += b * b;
+		}
+		// Principal axis by power iteration, starting from the luminance axis.
+		F32 axis[3] = { .299f, .587f, .114f };
+		for (S32 iter = 0; iter < 4; ++iter)
+		{
+			F32 x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			F32 y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			F32 z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+			F32 norm = llmax(fabsf(x), llmax(fabsf(y), fabsf(z)));
+			if (norm < 1e-3f)
+			{
+				break;	// flat block, keep the previous axis
+			}
+			F32 inv = 1.f / norm;
+			axis[0] = x * inv;
+			axis[1] = y * inv;
+			axis[2] = z * inv;
+		}
+		S32 min_i = 0, max_i = 0;
+		F32 min_t = F32_MAX, max_t = -F32_MAX;
+		for (S32 i = 0; i < 16; ++i)
+		{
+			F32 t = block[i * 4] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+			if (t < min_t)
+			{
+				min_t = t;
+				min_i = i;
+			}
+			if (t > max_t)
+			{
+				max_t = t;
+				max_i = i;
+			}
+		}
+		F32 c0f[3], c1f[3];
+		for (S32 k = 0; k < 3; ++k)
+		{
+			c0f[k] = block[max_i * 4 + k];
+			c1f[k] = block[min_i * 4 + k];
+		}
+		U16 c0 = pack_565(c0f);
+		U16 c1 = pack_565(c1f);
+		if (c0 == c1)
+		{
+			emit_color_block(c0, c1, 0, out);
+			return;
+		}
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+		}
+		S32 palette[4][3];
+		make_palette(c0, c1, true, palette);
+		S32 error;
+		U32 indices = match_colors(block, palette, error);
+
+		if (refine_endpoints(block, indices, c0f, c1f))
+		{
+			U16 r0 = pack_565(c0f);
+			U16 r1 = pack_565(c1f);
+			if (r0 != r1)
+			{
+				make_palette(llmax(r0, r1), llmin(r0, r1), true, palette);
+				S32 refined_error;
+				U32 refined = match_colors(block, palette, refined_error);
+				if (refined_error < error)
+				{
+					c0 = llmax(r0, r1);
+					c1 = llmin(r0, r1);
+					indices = refined;
+				}
+			}
+		}
+		emit_color_block(c0, c1, indices, out);
+	}
+
+	void encode_alpha_block(const U8* block, U8* out)
+	{
+		S32 a0 = 0, a1 = 255;
+		for (S32 i = 0; i < 16; ++i)
+		{
+			a0 = llmax(a0, (S32)block[i * 4 + 3]);
+			a1 = llmin(a1, (S32)block[i * 4 + 3]);
+		}
+		out[0] = (U8)a0;
+		out[1] = (U8)a1;
+		U64 bits = 0;
+		if (a0 > a1)
+		{
+			S32 values[8];
+			values[0] = a0;
+			values[1] = a1;
+			for (S32 j = 1; j < 7; ++j)
+			{
+				values[j + 1] = ((7 - j) * a0 + j * a1) / 7;
+			}
+			for (S32 i = 0; i < 16; ++i)
+			{
+				S32 a = block[i * 4 + 3];
+				S32 best = 0;
+				S32 best_error = 256;
+				for (S32 j = 0; j < 8; ++j)
+				{
+					S32 e = llabs(a - values[j]);
+					if (e < best_error)
+					{
+						best_error = e;
+						best = j;
+					}
+				}
+				bits |= (U64)best << (i * 3);
+			}
+		}
+		for (S32 i = 0; i < 6; ++i)
+		{
+			out[2 + i] = (U8)(bits >> (i * 8));
+		}
+	}
+
+	void decode_color_block(const U8* in, bool dxt1, U8* block)
+	{
+		U16 c0 = in[0] | (in[1] << 8);
+		U16 c1 = in[2] | (in[3] << 8);
+		U32 indices = in[4] | (in[5] << 8) | (in[6] << 16) | ((U32)in[7] << 24);
+		bool four_colors = !dxt1 || c0 > c1;
+		S32 palette[4][3];
+		make_palette(c0, c1, four_colors, palette);
+		for (S32 i = 0; i < 16; ++i)
+		{
+			S32 j = (indices >> (i * 2)) & 3;
+			U8* px = block + i * 4;
+			px[0] = (U8)palette[j][0];
+			px[1] = (U8)palette[j][1];
+			px[2] = (U8)palette[j][2];
+			px[3] = (!four_colors && j == 3) ? 0 : 255;
+		}
+	}
+
+	void decode_alpha_block(const U8* in, U8* block)
+	{
+		S32 a0 = in[0];
+		S32 a1 = in[1];
+		S32 values[8];
+		values[0] = a0;
+		values[1] = a1;
+		if (a0 > a1)
+		{
+			for (S32 j = 1; j < 7; ++j)
+			{
+				values[j + 1] = ((7 - j) * a0 + j * a1) / 7;
+			}
+		}
+		else
+		{
+			for (S32 j = 1; j < 5; ++j)
+			{
+				values[j + 1] = ((5 - j) * a0 + j * a1) / 5;
+			}
+			values[6] = 0;
+			values[7] = 255;
+		}
+		U64 bits = 0;
+		for (S32 i = 0; i < 6; ++i)
+		{
+			bits |= (U64)in[2 + i] << (i * 8);
+		}
+		for (S32 i = 0; i < 16; ++i)
+		{
+			block[i * 4 + 3] = (U8)values[(bits >> (i * 3)) & 7];
+		}
+	}
+
+	inline bool is_power_of_two(S32 n)
+	{
+		return n > 0 && !(n & (n - 1));
+	}
+}
+
 //static
 void LLImageDXT::checkMinWidthHeight(EFileFormat format, S32& width, S32& height)
 {
@@ -263,6 +599,10 @@ BOOL LLImageDXT::decode(LLImageRaw* raw_image, F32 time)
 	//  but we don't use it any more!
 	llassert_always(raw_image);
 	
+	if (mFileFormat == FORMAT_DXR1 || mFileFormat == FORMAT_DXR5)
+	{
+		return decompress(raw_image, llmax(mDiscardLevel, (S8)0));
+	}
 	if (mFileFormat >= FORMAT_DXT1 && mFileFormat <= FORMAT_DXR5)
 	{
 		LL_WARNS() << "Attempt to decode compressed LLImageDXT to Raw (unsupported)" << LL_ENDL;
@@ -404,6 +744,150 @@ BOOL LLImageDXT::encode(const LLImageRaw* raw_image, F32 time)
 	return encodeDXT(raw_image, time, false);
 }
 
+BOOL LLImageDXT::compress(const LLImageRaw* raw_image)
+{
+	llassert_always(raw_image);
+
+	S32 ncomponents = raw_image->getComponents();
+	S32 width = raw_image->getWidth();
+	S32 height = raw_image->getHeight();
+	EFileFormat format = ncomponents == 3 ? FORMAT_DXR1 : (ncomponents == 4 ? FORMAT_DXR5 : FORMAT_UNKNOWN);
+	if (format == FORMAT_UNKNOWN || !is_power_of_two(width) || !is_power_of_two(height))
+	{
+		setLastError("LLImageDXT can only compress RGB(A) images with power of two sides");
+		return FALSE;
+	}
+
+	setSize(width, height, ncomponents);
+	mHeaderSize = sizeof(dxtfile_header_t);
+	mFileFormat = format;
+
+	S32 nmips = calcNumMips(width, height);
+	S32 totbytes = mHeaderSize;
+	for (S32 mip = 0, w = width, h = height; mip < nmips; mip++, w >>= 1, h >>= 1)
+	{
+		totbytes += formatBytes(format, w, h);
+	}
+	U8* data = allocateData(totbytes);
+	if (!data)
+	{
+		setLastError("LLImageDXT out of memory");
+		return FALSE;
+	}
+
+	dxtfile_header_t* header = (dxtfile_header_t*)data;
+	memset(header, 0, mHeaderSize);
+	header->fourcc = 0x20534444;
+	header->pixel_fmt.fourcc = getFourCC(format);
+	header->num_mips = nmips;
+	header->maxwidth = width;
+	header->maxheight = height;
+
+	// Each mip is built from the previous raw mip, not from compressed data.
+	std::vector<U8> mip_buffers[2];
+	const U8* mip_data = raw_image->getData();
+	U8 block[64];
+	for (S32 mip = 0, w = width, h = height; mip < nmips; mip++, w >>= 1, h >>= 1)
+	{
+		U8* out = data + getMipOffset(mip);
+		for (S32 by = 0; by < h; by += 4)
+		{
+			for (S32 bx = 0; bx < w; bx += 4)
+			{
+				// Blocks of mips smaller than 4x4 repeat the edge pixels.
+				for (S32 y = 0; y < 4; ++y)
+				{
+					const U8* row = mip_data + llmin(by + y, h - 1) * w * ncomponents;
+					for (S32 x = 0; x < 4; ++x)
+					{
+						const U8* px = row + llmin(bx + x, w - 1) * ncomponents;
+						U8* dst = block + (y * 4 + x) * 4;
+						dst[0] = px[0];
+						dst[1] = px[1];
+						dst[2] = px[2];
+						dst[3] = ncomponents == 4 ? px[3] : 255;
+					}
+				}
+				if (format == FORMAT_DXR5)
+				{
+					encode_alpha_block(block, out);
+					out += 8;
+				}
+				encode_color_block(block, out);
+				out += 8;
+			}
+		}
+		if (mip + 1 < nmips)
+		{
+			std::vector<U8>& next = mip_buffers[mip & 1];
+			next.resize((w >> 1) * (h >> 1) * ncomponents);
+			generateMip(mip_data, &next[0], w >> 1, h >> 1, ncomponents);
+			mip_data = &next[0];
+		}
+	}
+	setDiscardLevel(0);
+
+	return TRUE;
+}
+
+BOOL LLImageDXT::decompress(LLImageRaw* raw_image, S32 discard)
+{
+	S32 width = getWidth() >> discard;
+	S32 height = getHeight() >> discard;
+	S32 ncomponents = getComponents();
+	if (width <= 0 || height <= 0 || !getData() ||
+		getMipOffset(discard) + formatBytes(mFileFormat, width, height) > getDataSize())
+	{
+		setLastError("LLImageDXT trying to decode an image with not enough data!");
+		return FALSE;
+	}
+	if (!raw_image->resize(width, height, ncomponents))
+	{
+		setLastError("LLImageDXT out of memory");
+		return FALSE;
+	}
+
+	const U8* in = getData() + getMipOffset(discard);
+	U8* out = raw_image->getData();
+	U8 block[64];
+	for (S32 by = 0; by < height; by += 4)
+	{
+		for (S32 bx = 0; bx < width; bx += 4)
+		{
+			if (mFileFormat == FORMAT_DXR5)
+			{
+				decode_color_block(in + 8, false, block);
+				decode_alpha_block(in, block);
+				in += 16;
+			}
+			else
+			{
+				decode_color_block(in, true, block);
+				in += 8;
+			}
+			S32 rows = llmin(4, height - by);
+			S32 cols = llmin(4, width - bx);
+			for (S32 y = 0; y < rows; ++y)
+			{
+				U8* dst = out + ((by + y) * width + bx) * ncomponents;
+				const U8* src = block + y * 16;
+				for (S32 x = 0; x < cols; ++x, dst += ncomponents, src += 4)
+				{
+					dst[0] = src[0];
+					dst[1] = src[1];
+					dst[2] = src[2];
+					if (ncomponents == 4)
+					{
+						dst[3] = src[3];
+					}
+				}
+			}
+		}
+	}
+
+	return TRUE;
+}
+
 // virtual
 bool LLImageDXT::convertToDXR()
 {
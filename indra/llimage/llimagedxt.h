@@ -100,6 +100,7 @@ protected:
 
 private:
 	BOOL encodeDXT(const LLImageRaw* raw_image, F32 decode_time, bool explicit_mips);
+	BOOL decompress(LLImageRaw* raw_image, S32 discard);
 	
 public:
 	LLImageDXT();
@@ -114,6 +115,12 @@ public:
 	/*virtual*/ S32 calcDataSize(S32 discard_level = 0);
 
 	BOOL getMipData(LLPointer<LLImageRaw>& raw, S32 discard=-1);
+
+	// Compresses raw_image (RGB or RGBA, power of two sides) into a complete
+	// DXR1 or DXR5 mip chain with the CPU block encoder. decode() expands
+	// these two formats back to raw, smallest mips first in the data, so a
+	// truncated file still decodes at a higher discard level.
+	BOOL compress(const LLImageRaw* raw_image);
 	
 	void setFormat();
 	S32 getMipOffset(S32 discard);
@@ -180,7 +180,9 @@ LLImageJ2C::LLImageJ2C() : 	LLImageFormatted(IMG_CODEC_J2C),
 							mRawDiscardLevel(-1),
 							mRate(0.0f),
 							mReversible(FALSE),
-							mAreaUsedForDataSizeCalcs(0)
+							mAreaUsedForDataSizeCalcs(0),
+							mIndexedData(NULL),
+							mIndexedDataSize(0)
 {
 	//We assume here that if we wanted to create via
 	//a dynamic library that the approriate open calls were made
@@ -267,6 +269,8 @@ BOOL LLImageJ2C::updateData()
 
 	if (res)
 	{
+		// The data may have been replaced by a buffer of the same size and address.
+		mIndexedData = NULL;
 		// SJB: override discard based on mMaxBytes elsewhere
 		S32 max_bytes = getDataSize(); // mMaxBytes ? mMaxBytes : getDataSize();
 		S32 discard = calcDiscardLevelBytes(max_bytes);
@@ -340,6 +344,7 @@ BOOL LLImageJ2C::encode(const LLImageRaw *raw_imagep, const char* comment_text,
 {
 	resetLastError();
 	BOOL res = mImpl->encodeImpl(*this, *raw_imagep, comment_text, encode_time, mReversible);
+	mIndexedData = NULL;
 	if (!mLastError.empty())
 	{
 		LLImage::setLastError(mLastError);
@@ -347,6 +352,17 @@ BOOL LLImageJ2C::encode(const LLImageRaw *raw_imagep, const char* comment_text,
 	return res;
 }
 
+const LLImageJ2CIndex& LLImageJ2C::getIndex()
+{
+	if (mIndexedData != getData() || mIndexedDataSize != getDataSize())
+	{
+		mIndexedData = getData();
+		mIndexedDataSize = getDataSize();
+		mIndex.parse(mIndexedData, mIndexedDataSize);
+	}
+	return mIndex;
+}
+
 //static
 S32 LLImageJ2C::calcHeaderSizeJ2C()
 {
@@ -390,6 +406,14 @@ S32 LLImageJ2C::calcDataSize(S32 discard_level)
 
 	discard_level = llclamp(discard_level, 0, MAX_DISCARD_LEVEL);
 
+	// Use the real size whenever the codestream markers give it away.
+	const LLImageJ2CIndex& index = getIndex();
+	S32 exact_size = index.getDataSize(discard_level);
+	if (exact_size > 0)
+	{
+		return exact_size;
+	}
+
 	if ( mAreaUsedForDataSizeCalcs != (getHeight() * getWidth()) 
 		|| mDataSizes[0] == 0)
 	{
@@ -422,6 +446,11 @@ S32 LLImageJ2C::calcDataSize(S32 discard_level)
 		}
 		*/
 	}
+	// No point asking for more than there is.
+	if (index.getCodestreamSize() > 0)
+	{
+		return llmin(mDataSizes[discard_level], index.getCodestreamSize());
+	}
 	return mDataSizes[discard_level];
 }
 
@@ -436,7 +465,15 @@ S32 LLImageJ2C::calcDiscardLevelBytes(S32 bytes)
 	while (1)
 	{
 		S32 bytes_needed = calcDataSize(discard_level); // virtual
-		if (bytes >= bytes_needed - (bytes_needed>>2)) // For J2c, up the res at 75% of the optimal number of bytes
+		if (bytes_needed == getIndex().getDataSize(discard_level))
+		{
+			// Exact size: anything less would decode this level partially.
+			if (bytes >= bytes_needed)
+			{
+				break;
+			}
+		}
+		else if (bytes >= bytes_needed - (bytes_needed>>2)) // For J2c, up the res at 75% of the optimal number of bytes
 		{
 			break;
 		}
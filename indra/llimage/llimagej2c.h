@@ -28,6 +28,7 @@
 #define LL_LLIMAGEJ2C_H
 
 #include "llimage.h"
+#include "llimagej2cindex.h"
 #include "llassettype.h"
 
 class LLImageJ2CImpl;
@@ -66,6 +67,9 @@ public:
 	void setMaxBytes(S32 max_bytes);
 	S32 getMaxBytes() const { return mMaxBytes; }
 
+	// Codestream index of the data currently held, re-read whenever the data changes.
+	const LLImageJ2CIndex& getIndex();
+
 	static S32 calcHeaderSizeJ2C();
 	static S32 calcDataSizeJ2C(S32 w, S32 h, S32 comp, S32 discard_level, F32 rate = 0.f);
 
@@ -83,6 +87,9 @@ protected:
 	S32 mMaxBytes; // Maximum number of bytes of data to use...
 	S32 mDataSizes[MAX_DISCARD_LEVEL+1];		// Size of data required to reach a given level
 	U32 mAreaUsedForDataSizeCalcs;				// Height * width used to calculate mDataSizes
+	LLImageJ2CIndex mIndex;						// Exact level sizes, when the codestream tells
+	const U8* mIndexedData;						// Data and size mIndex was built from
+	S32 mIndexedDataSize;
 	S8  mRawDiscardLevel;
 	F32 mRate;
 	BOOL mReversible;
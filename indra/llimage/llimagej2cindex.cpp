@@ -0,0 +1,594 @@
+/** 
+ * @file llimagej2cindex.cpp
+ * @brief Byte index of the resolution levels of a JPEG 2000 codestream.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagej2cindex.h"
+
+namespace
+{
+	// Marker codes, ITU-T T.800 Annex A.
+	const U16 J2C_SOC = 0xff4f;
+	const U16 J2C_SIZ = 0xff51;
+	const U16 J2C_COD = 0xff52;
+	const U16 J2C_COC = 0xff53;
+	const U16 J2C_TLM = 0xff55;
+	const U16 J2C_PLM = 0xff57;
+	const U16 J2C_PLT = 0xff58;
+	const U16 J2C_POC = 0xff5f;
+	const U16 J2C_PPM = 0xff60;
+	const U16 J2C_PPT = 0xff61;
+	const U16 J2C_SOT = 0xff90;
+	const U16 J2C_SOD = 0xff93;
+	const U16 J2C_EOC = 0xffd9;
+
+	const S32 SOT_SEGMENT_SIZE = 12;
+	const U8 DEFAULT_PRECINCT_EXP = 15;
+
+	inline U16 read16(const U8* p)
+	{
+		return (U16)((p[0] << 8) | p[1]);
+	}
+
+	inline U32 read32(const U8* p)
+	{
+		return ((U32)p[0] << 24) | ((U32)p[1] << 16) | ((U32)p[2] << 8) | (U32)p[3];
+	}
+
+	inline U64 ceil_div_pow2(U64 value, U32 exp)
+	{
+		return (value + ((U64)1 << exp) - 1) >> exp;
+	}
+
+	inline U64 ceil_div(U64 value, U64 divisor)
+	{
+		return (value + divisor - 1) / divisor;
+	}
+
+	// Decodes the packet lengths of a PLM or PLT segment: 7 bits per byte,
+	// most significant first, high bit set on all but the last byte.
+	bool read_packet_lengths(const U8* p, S32 size, std::vector<U32>& lengths)
+	{
+		U32 length = 0;
+		bool pending = false;
+		for (const U8* end = p + size; p < end; ++p)
+		{
+			if (length > (0xffffffffU >> 7))
+			{
+				return false;
+			}
+			length = (length << 7) | (*p & 0x7f);
+			pending = (*p & 0x80) != 0;
+			if (!pending)
+			{
+				lengths.push_back(length);
+				length = 0;
+			}
+		}
+		return !pending;
+	}
+}
+
+LLImageJ2CIndex::LLImageJ2CIndex()
+{
+	clear();
+}
+
+void LLImageJ2CIndex::clear()
+{
+	mValid = false;
+	mResolutionMajor = true;
+	mWidth = mHeight = mComponents = 0;
+	mLevels = 0;
+	mLayers = 1;
+	mProgressionOrder = LRCP;
+	mHeaderSize = 0;
+	mCodestreamSize = 0;
+	mTiles = 0;
+	mTilePartCount = 0;
+	mImageX0 = mImageY0 = mImageX1 = mImageY1 = 0;
+	mSubsamplingX.clear();
+	mSubsamplingY.clear();
+	for (S32 i = 0; i < MAX_RESOLUTIONS; ++i)
+	{
+		mPrecinctExpX[i] = mPrecinctExpY[i] = DEFAULT_PRECINCT_EXP;
+		mResolutionEnd[i] = 0;
+	}
+	mTLMLengths.clear();
+	mPLMLengths.clear();
+	mTileParts.clear();
+}
+
+bool LLImageJ2CIndex::parse(const U8* data, S32 data_size)
+{
+	clear();
+	if (!data || data_size < 4 || read16(data) != J2C_SOC)
+	{
+		return false;
+	}
+
+	// Main header: marker segments up to the first SOT.
+	bool have_siz = false;
+	bool have_cod = false;
+	S32 pos = 2;
+	while (true)
+	{
+		if (pos + 2 > data_size)
+		{
+			return false;
+		}
+		U16 marker = read16(data + pos);
+		if (marker == J2C_SOT)
+		{
+			break;
+		}
+		if ((marker & 0xff00) != 0xff00 || pos + 4 > data_size)
+		{
+			return false;
+		}
+		S32 length = read16(data + pos + 2);
+		if (length < 2 || pos + 2 + length > data_size)
+		{
+			return false;
+		}
+		if (!parseMainSegment(marker, data + pos + 4, length - 2))
+		{
+			return false;
+		}
+		have_siz |= (marker == J2C_SIZ);
+		have_cod |= (marker == J2C_COD);
+		pos += 2 + length;
+	}
+	if (!have_siz || !have_cod)
+	{
+		return false;
+	}
+	mHeaderSize = pos;
+	mValid = true;
+
+	if (mTiles == 1)
+	{
+		parseTileParts(data, data_size);
+	}
+	computeResolutionEnds();
+	return true;
+}
+
+bool LLImageJ2CIndex::parseMainSegment(U16 marker, const U8* seg, S32 seg_len)
+{
+	switch (marker)
+	{
+	case J2C_SIZ:
+	{
+		if (seg_len < 36)
+		{
+			return false;
+		}
+		U32 x1 = read32(seg + 2);
+		U32 y1 = read32(seg + 6);
+		U32 x0 = read32(seg + 10);
+		U32 y0 = read32(seg + 14);
+		U32 tile_w = read32(seg + 18);
+		U32 tile_h = read32(seg + 22);
+		U32 tile_x0 = read32(seg + 26);
+		U32 tile_y0 = read32(seg + 30);
+		S32 components = read16(seg + 34);
+		if (x1 <= x0 || y1 <= y0 || !tile_w || !tile_h || tile_x0 > x0 || tile_y0 > y0
+			|| (x1 - x0) > 0x7fffffff || (y1 - y0) > 0x7fffffff
+			|| components < 1 || seg_len < 36 + 3 * components)
+		{
+			return false;
+		}
+		mImageX0 = x0;
+		mImageY0 = y0;
+		mImageX1 = x1;
+		mImageY1 = y1;
+		mWidth = (S32)(x1 - x0);
+		mHeight = (S32)(y1 - y0);
+		mComponents = components;
+		U64 tiles_x = ceil_div(x1 - tile_x0, tile_w);
+		U64 tiles_y = ceil_div(y1 - tile_y0, tile_h);
+		mTiles = (tiles_x * tiles_y > 0x7fffffff) ? 0x7fffffff : (S32)(tiles_x * tiles_y);
+		mSubsamplingX.resize(components);
+		mSubsamplingY.resize(components);
+		for (S32 c = 0; c < components; ++c)
+		{
+			mSubsamplingX[c] = seg[36 + 3 * c + 1];
+			mSubsamplingY[c] = seg[36 + 3 * c + 2];
+			if (!mSubsamplingX[c] || !mSubsamplingY[c])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	case J2C_COD:
+		return parseCodingStyle(seg, seg_len);
+	case J2C_COC:
+		checkComponentCodingStyle(seg, seg_len);
+		return true;
+	case J2C_TLM:
+	{
+		if (seg_len < 2)
+		{
+			return false;
+		}
+		U8 stlm = seg[1];
+		S32 tile_bytes = (stlm >> 4) & 3;
+		S32 length_bytes = (stlm & 0x40) ? 4 : 2;
+		if (tile_bytes == 3)
+		{
+			return false;
+		}
+		S32 entry_size = tile_bytes + length_bytes;
+		for (const U8* p = seg + 2; p + entry_size <= seg + seg_len; p += entry_size)
+		{
+			U32 tile = (tile_bytes == 0) ? (U32)mTLMLengths.size()
+					 : (tile_bytes == 1) ? p[0] : read16(p);
+			if (tile == 0)
+			{
+				mTLMLengths.push_back(length_bytes == 4 ? read32(p + tile_bytes) : read16(p + tile_bytes));
+			}
+		}
+		return true;
+	}
+	case J2C_PLM:
+	{
+		const U8* end = seg + seg_len;
+		for (const U8* p = seg + 1; p < end; )
+		{
+			S32 count = *p++;
+			mPLMLengths.push_back(std::vector<U32>());
+			if (p + count > end || !read_packet_lengths(p, count, mPLMLengths.back()))
+			{
+				// Not worth failing the header over; just don't use PLM.
+				mPLMLengths.clear();
+				break;
+			}
+			p += count;
+		}
+		return true;
+	}
+	case J2C_POC:
+	case J2C_PPM:
+		// Progression changes and packed packet headers both break the
+		// one-resolution-after-the-other layout.
+		mResolutionMajor = false;
+		return true;
+	default:
+		return true;
+	}
+}
+
+bool LLImageJ2CIndex::parseCodingStyle(const U8* seg, S32 seg_len)
+{
+	if (seg_len < 10)
+	{
+		return false;
+	}
+	U8 scod = seg[0];
+	S32 levels = seg[5];
+	if (levels >= MAX_RESOLUTIONS || seg[1] > CPRL)
+	{
+		return false;
+	}
+	mProgressionOrder = seg[1];
+	mLayers = read16(seg + 2);
+	mLevels = levels;
+	for (S32 r = 0; r < MAX_RESOLUTIONS; ++r)
+	{
+		mPrecinctExpX[r] = mPrecinctExpY[r] = DEFAULT_PRECINCT_EXP;
+	}
+	if (scod & 1)
+	{
+		// User defined precincts, lowest resolution first.
+		if (seg_len < 10 + levels + 1)
+		{
+			return false;
+		}
+		for (S32 r = 0; r <= levels; ++r)
+		{
+			mPrecinctExpX[r] = seg[10 + r] & 0x0f;
+			mPrecinctExpY[r] = seg[10 + r] >> 4;
+		}
+	}
+	return mLayers > 0;
+}
+
+// A component coding style (COC) is harmless as long as it keeps the levels
+// and precincts of the default one; OpenJPEG writes one per component anyway.
+void LLImageJ2CIndex::checkComponentCodingStyle(const U8* seg, S32 seg_len)
+{
+	S32 offset = (mComponents < 257) ? 1 : 2;
+	if (seg_len < offset + 6)
+	{
+		mResolutionMajor = false;
+		return;
+	}
+	U8 scoc = seg[offset];
+	S32 levels = seg[offset + 1];
+	if (levels != mLevels)
+	{
+		mResolutionMajor = false;
+		return;
+	}
+	for (S32 r = 0; r <= levels; ++r)
+	{
+		U8 exp_x = DEFAULT_PRECINCT_EXP;
+		U8 exp_y = DEFAULT_PRECINCT_EXP;
+		if (scoc & 1)
+		{
+			if (seg_len < offset + 6 + r + 1)
+			{
+				mResolutionMajor = false;
+				return;
+			}
+			exp_x = seg[offset + 6 + r] & 0x0f;
+			exp_y = seg[offset + 6 + r] >> 4;
+		}
+		if (exp_x != mPrecinctExpX[r] || exp_y != mPrecinctExpY[r])
+		{
+			mResolutionMajor = false;
+			return;
+		}
+	}
+}
+
+bool LLImageJ2CIndex::parseTileParts(const U8* data, S32 data_size)
+{
+	S32 pos = mHeaderSize;
+	while (pos + SOT_SEGMENT_SIZE <= data_size && read16(data + pos) == J2C_SOT)
+	{
+		const U8* sot = data + pos;
+		U32 psot = read32(sot + 6);
+		if (read16(sot + 2) != 10 || read16(sot + 4) != 0 || sot[10] != mTileParts.size()
+			|| psot > (U32)(0x7fffffff - pos) || (psot && psot < SOT_SEGMENT_SIZE + 2))
+		{
+			return false;
+		}
+		if (mTileParts.empty())
+		{
+			mTilePartCount = sot[11];
+		}
+
+		TilePart part;
+		part.mStart = pos;
+		part.mBodyStart = 0;
+		part.mEnd = psot ? pos + (S32)psot : 0;
+		bool lengths_ok = true;
+		for (S32 p = pos + SOT_SEGMENT_SIZE; p + 2 <= data_size; )
+		{
+			U16 marker = read16(data + p);
+			if (marker == J2C_SOD)
+			{
+				part.mBodyStart = p + 2;
+				break;
+			}
+			if (p + 4 > data_size)
+			{
+				break;
+			}
+			S32 length = read16(data + p + 2);
+			if (length < 2 || p + 2 + length > data_size)
+			{
+				break;
+			}
+			const U8* seg = data + p + 4;
+			S32 seg_len = length - 2;
+			switch (marker)
+			{
+			case J2C_PLT:
+				lengths_ok &= seg_len >= 1 && read_packet_lengths(seg + 1, seg_len - 1, part.mPacketLengths);
+				break;
+			case J2C_COD:
+				// With a single tile, the tile coding style is the coding style.
+				mResolutionMajor &= parseCodingStyle(seg, seg_len);
+				break;
+			case J2C_COC:
+				checkComponentCodingStyle(seg, seg_len);
+				break;
+			case J2C_POC:
+			case J2C_PPT:
+				mResolutionMajor = false;
+				break;
+			default:
+				break;
+			}
+			p += 2 + length;
+		}
+		if (!part.mBodyStart || (part.mEnd && part.mEnd < part.mBodyStart))
+		{
+			// Tile-part header not all there yet.
+			break;
+		}
+		if (!lengths_ok)
+		{
+			part.mPacketLengths.clear();
+		}
+		mTileParts.push_back(part);
+		if (!part.mEnd)
+		{
+			break;
+		}
+		pos = part.mEnd;
+	}
+
+	if (!mTileParts.empty() && mTileParts.back().mEnd == pos
+		&& pos + 2 <= data_size && read16(data + pos) == J2C_EOC)
+	{
+		mCodestreamSize = pos + 2;
+	}
+	return true;
+}
+
+// Number of packets resolution r contributes to the (single) tile, per layer.
+U32 LLImageJ2CIndex::countPrecincts(S32 resolution) const
+{
+	U32 shift = mLevels - resolution;
+	U32 exp_x = mPrecinctExpX[resolution];
+	U32 exp_y = mPrecinctExpY[resolution];
+	U64 count = 0;
+	for (S32 c = 0; c < mComponents; ++c)
+	{
+		U64 tcx0 = ceil_div(mImageX0, mSubsamplingX[c]);
+		U64 tcy0 = ceil_div(mImageY0, mSubsamplingY[c]);
+		U64 tcx1 = ceil_div(mImageX1, mSubsamplingX[c]);
+		U64 tcy1 = ceil_div(mImageY1, mSubsamplingY[c]);
+		U64 trx0 = ceil_div_pow2(tcx0, shift);
+		U64 try0 = ceil_div_pow2(tcy0, shift);
+		U64 trx1 = ceil_div_pow2(tcx1, shift);
+		U64 try1 = ceil_div_pow2(tcy1, shift);
+		if (trx1 > trx0 && try1 > try0)
+		{
+			U64 precincts_x = ceil_div_pow2(trx1, exp_x) - (trx0 >> exp_x);
+			U64 precincts_y = ceil_div_pow2(try1, exp_y) - (try0 >> exp_y);
+			count += precincts_x * precincts_y;
+		}
+	}
+	return count > 0xffffffU ? 0xffffffU : (U32)count;
+}
+
+bool LLImageJ2CIndex::isResolutionProgressive() const
+{
+	return mValid && mResolutionMajor && mTiles == 1
+		&& (mProgressionOrder == RLCP || mProgressionOrder == RPCL
+			|| (mProgressionOrder == LRCP && mLayers == 1));
+}
+
+void LLImageJ2CIndex::computeResolutionEnds()
+{
+
+	if (mCodestreamSize == 0 && mTiles == 1 && !mTLMLengths.empty()
+		&& (mTilePartCount == 0 || mTilePartCount == (S32)mTLMLengths.size()))
+	{
+		U64 size = mHeaderSize + 2;
+		for (std::vector<U32>::const_iterator it = mTLMLengths.begin(); it != mTLMLengths.end(); ++it)
+		{
+			size += *it;
+		}
+		if (size <= 0x7fffffff)
+		{
+			mCodestreamSize = (S32)size;
+		}
+	}
+	if (mCodestreamSize == 0 && mTilePartCount > 0 && mTilePartCount == (S32)mTileParts.size()
+		&& mTileParts.back().mEnd)
+	{
+		// All tile-parts seen, the last one followed by EOC.
+		mCodestreamSize = mTileParts.back().mEnd + 2;
+	}
+
+	if (isResolutionProgressive())
+	{
+		// Walk the packet lengths, tile-part by tile-part, noting where the last
+		// packet of each resolution ends.
+		std::vector<U64> last_packet(mLevels + 1);
+		U64 packets = 0;
+		for (S32 r = 0; r <= mLevels; ++r)
+		{
+			packets += (U64)mLayers * countPrecincts(r);
+			last_packet[r] = packets;
+		}
+		S32 resolution = 0;
+		U64 packet = 0;
+		for (U32 i = 0; i < mTileParts.size() && resolution <= mLevels; ++i)
+		{
+			const TilePart& part = mTileParts[i];
+			const std::vector<U32>* lengths = !part.mPacketLengths.empty() ? &part.mPacketLengths
+				: (i < mPLMLengths.size() ? &mPLMLengths[i] : NULL);
+			if (!lengths || lengths->empty())
+			{
+				break;
+			}
+			U64 offset = part.mBodyStart;
+			for (std::vector<U32>::const_iterator it = lengths->begin(); it != lengths->end(); ++it)
+			{
+				offset += *it;
+				++packet;
+				while (resolution <= mLevels && packet >= last_packet[resolution])
+				{
+					mResolutionEnd[resolution++] = (offset > 0x7fffffff) ? 0 : (S32)offset;
+				}
+			}
+			if (part.mEnd && offset != (U64)part.mEnd)
+			{
+				// The lengths do not add up: trust none of them.
+				for (S32 r = 0; r < MAX_RESOLUTIONS; ++r)
+				{
+					mResolutionEnd[r] = 0;
+				}
+				break;
+			}
+		}
+
+		// Kakadu's ORGtparts=R writes one tile-part per resolution, so the
+		// tile-part lengths alone give the resolution boundaries.
+		S32 tile_parts = mTilePartCount ? mTilePartCount : (S32)mTLMLengths.size();
+		if (mLevels > 0 && tile_parts == mLevels + 1)
+		{
+			std::vector<S32> ends;
+			if (!mTLMLengths.empty())
+			{
+				U64 offset = mHeaderSize;
+				for (std::vector<U32>::const_iterator it = mTLMLengths.begin(); it != mTLMLengths.end() && offset <= 0x7fffffff; ++it)
+				{
+					offset += *it;
+					ends.push_back((S32)llmin(offset, (U64)0x7fffffff));
+				}
+			}
+			else
+			{
+				for (std::vector<TilePart>::const_iterator it = mTileParts.begin(); it != mTileParts.end() && it->mEnd; ++it)
+				{
+					ends.push_back(it->mEnd);
+				}
+			}
+			for (S32 r = 0; r < (S32)ends.size() && r <= mLevels; ++r)
+			{
+				if (!mResolutionEnd[r])
+				{
+					mResolutionEnd[r] = ends[r];
+				}
+			}
+		}
+	}
+
+	// Whatever the layout, the full resolution needs the whole codestream.
+	if (mCodestreamSize)
+	{
+		mResolutionEnd[mLevels] = mCodestreamSize;
+	}
+}
+
+S32 LLImageJ2CIndex::getDataSize(S32 discard_level) const
+{
+	if (!mValid)
+	{
+		return 0;
+	}
+	S32 resolution = llmax(mLevels - llmax(discard_level, 0), 0);
+	return mResolutionEnd[resolution];
+}
@@ -0,0 +1,130 @@
+/** 
+ * @file llimagej2cindex.h
+ * @brief Byte index of the resolution levels of a JPEG 2000 codestream.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEJ2CINDEX_H
+#define LL_LLIMAGEJ2CINDEX_H
+
+#include <vector>
+
+// Reads the marker segments of a (possibly truncated) J2C codestream and works
+// out how many bytes are needed to decode each resolution level, without
+// decoding anything.
+//
+// The main header gives the geometry (SIZ), the coding style (COD) and, when
+// the encoder wrote them, tile-part lengths (TLM) and packet lengths (PLM).
+// The tile-part headers in the data add the tile-part lengths (SOT) and packet
+// lengths (PLT). When the packets are laid out resolution by resolution (RLCP,
+// RPCL, or any order with a single quality layer), the end of the last packet
+// of resolution r is exactly the number of bytes needed to decode the image at
+// discard level (levels - r). Everything else falls back on estimates, which
+// is what getDataSize() returning 0 means.
+class LLImageJ2CIndex
+{
+public:
+	enum EProgressionOrder
+	{
+		LRCP = 0,
+		RLCP = 1,
+		RPCL = 2,
+		PCRL = 3,
+		CPRL = 4
+	};
+
+	// A J2C codestream has at most 32 decomposition levels.
+	static const S32 MAX_RESOLUTIONS = 33;
+
+	LLImageJ2CIndex();
+
+	void clear();
+
+	// Indexes whatever part of the codestream data_size covers. Returns false
+	// when the data does not hold a complete main header.
+	bool parse(const U8* data, S32 data_size);
+
+	bool isValid() const						{ return mValid; }
+	S32 getWidth() const						{ return mWidth; }
+	S32 getHeight() const						{ return mHeight; }
+	S32 getComponents() const					{ return mComponents; }
+	S32 getLevels() const						{ return mLevels; }
+	S32 getLayers() const						{ return mLayers; }
+	S32 getProgressionOrder() const				{ return mProgressionOrder; }
+	S32 getHeaderSize() const					{ return mHeaderSize; }
+
+	// True when the packets of each resolution level all come before those of
+	// the next: decoding a level then never needs data past its end.
+	bool isResolutionProgressive() const;
+
+	// Total size of the codestream (EOC included), or 0 when unknown.
+	S32 getCodestreamSize() const				{ return mCodestreamSize; }
+
+	// Exact number of bytes (header included) needed to decode discard_level,
+	// or 0 when the codestream does not tell.
+	S32 getDataSize(S32 discard_level) const;
+
+private:
+	struct TilePart
+	{
+		S32 mStart;								// Offset of the SOT marker
+		S32 mBodyStart;							// Offset of the first packet
+		S32 mEnd;								// Offset past the last packet, 0 when unknown
+		std::vector<U32> mPacketLengths;		// From PLT
+	};
+
+	bool parseMainSegment(U16 marker, const U8* seg, S32 seg_len);
+	bool parseCodingStyle(const U8* seg, S32 seg_len);
+	void checkComponentCodingStyle(const U8* seg, S32 seg_len);
+	bool parseTileParts(const U8* data, S32 data_size);
+	void computeResolutionEnds();
+	U32 countPrecincts(S32 resolution) const;
+
+private:
+	bool mValid;
+	bool mResolutionMajor;						// False when COC/POC/PPM/PPT make the layout unpredictable
+	S32 mWidth;
+	S32 mHeight;
+	S32 mComponents;
+	S32 mLevels;
+	S32 mLayers;
+	S32 mProgressionOrder;
+	S32 mHeaderSize;
+	S32 mCodestreamSize;
+	S32 mTiles;
+	S32 mTilePartCount;							// TNsot of the first tile-part, 0 when unknown
+
+	U32 mImageX0, mImageY0, mImageX1, mImageY1;
+	std::vector<U8> mSubsamplingX;
+	std::vector<U8> mSubsamplingY;
+	U8 mPrecinctExpX[MAX_RESOLUTIONS];
+	U8 mPrecinctExpY[MAX_RESOLUTIONS];
+
+	std::vector<U32> mTLMLengths;				// Tile-part lengths of tile 0
+	std::vector<std::vector<U32> > mPLMLengths;	// Packet lengths, one list per tile-part
+	std::vector<TilePart> mTileParts;
+
+	S32 mResolutionEnd[MAX_RESOLUTIONS];		// 0 when unknown
+};
+
+#endif // LL_LLIMAGEJ2CINDEX_H
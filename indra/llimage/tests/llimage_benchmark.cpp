@@ -0,0 +1,140 @@
+/**
+ * @file llimage_benchmark.cpp
+ * @brief Scalar and SIMD times of the LLImageRaw scaling and compositing.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+
+#include <iostream>
+
+// Class to benchmark
+#include "../llimage.h"
+#include "../llcommon/lltimer.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include "llimageformats_stub.cpp"
+
+namespace
+{
+	// Noise, with alpha (if any) mostly 0 or 255 in runs, like a texture
+	// layer mask.
+	LLPointer<LLImageRaw> make_image(S32 width, S32 height, S32 components, U32 seed)
+	{
+		LLPointer<LLImageRaw> raw = new LLImageRaw(width, height, components);
+		U8* data = raw->getData();
+		for (S32 i = 0; i < width * height; ++i)
+		{
+			for (S32 c = 0; c < components; ++c)
+			{
+				seed = seed * 1103515245 + 12345;
+				data[i * components + c] = (U8)(seed >> 16);
+			}
+			if (components == 4)
+			{
+				S32 run = (i / 7) % 3;
+				data[i * 4 + 3] = run == 0 ? 0 : run == 1 ? 255 : data[i * 4 + 3];
+			}
+		}
+		return raw;
+	}
+
+	LLPointer<LLImageRaw> copy_image(const LLImageRaw* src)
+	{
+		return new LLImageRaw(const_cast<U8*>(src->getData()), src->getWidth(), src->getHeight(), src->getComponents());
+	}
+
+	// Average time of a few runs of op on fresh copies of source.
+	template<class T>
+	F64 time_ms(const LLImageRaw* source, T op)
+	{
+		const S32 runs = 4;
+		F64 total = 0.0;
+		for (S32 i = 0; i < runs; ++i)
+		{
+			LLPointer<LLImageRaw> image = copy_image(source);
+			LLTimer timer;
+			op(image);
+			total += timer.getElapsedTimeF64();
+		}
+		return total * 1000.0 / runs;
+	}
+
+	struct halve_t
+	{
+		void operator()(LLImageRaw* image) const { image->scale(image->getWidth() / 2, image->getHeight() / 2); }
+	};
+	struct shrink_t
+	{
+		void operator()(LLImageRaw* image) const { image->scale(image->getWidth() * 3 / 4, image->getHeight() * 3 / 4); }
+	};
+	struct composite_t
+	{
+		LLPointer<LLImageRaw> mLayer;
+		void operator()(LLImageRaw* image) const { image->compositeUnscaled4onto3(mLayer); }
+	};
+}
+
+namespace tut
+{
+	struct image_benchmark
+	{
+	};
+	typedef test_group<image_benchmark> image_benchmark_t;
+	typedef image_benchmark_t::object image_benchmark_object_t;
+	tut::image_benchmark_t tut_image_benchmark("LLImageRaw_benchmark");
+
+	template<> template<>
+	void image_benchmark_object_t::test<1>()
+	{
+		// Scalar and SIMD times of the common operations.
+		static const S32 sizes[] = { 256, 512, 1024, 2048 };
+		std::cout << "\nLLImageRaw, ms scalar / SIMD:" << std::endl;
+		for (U32 s = 0; s < LL_ARRAY_SIZE(sizes); ++s)
+		{
+			for (S32 components = 3; components <= 4; ++components)
+			{
+				LLPointer<LLImageRaw> source = make_image(sizes[s], sizes[s], components, s);
+				composite_t composite;
+				composite.mLayer = make_image(sizes[s], sizes[s], 4, s + 1);
+				F64 times[2][3];
+				for (S32 simd = 0; simd < 2; ++simd)
+				{
+					LLImageRaw::sUseSIMD = simd != 0;
+					times[simd][0] = time_ms(source, halve_t());
+					times[simd][1] = time_ms(source, shrink_t());
+					times[simd][2] = components == 3 ? time_ms(source, composite) : 0.0;
+				}
+				std::cout << "  " << sizes[s] << "x" << sizes[s] << "x" << components
+						  << ": halve " << times[0][0] << " / " << times[1][0]
+						  << ", scale 3/4 " << times[0][1] << " / " << times[1][1];
+				if (components == 3)
+				{
+					std::cout << ", composite " << times[0][2] << " / " << times[1][2];
+				}
+				std::cout << std::endl;
+			}
+		}
+	}
+}
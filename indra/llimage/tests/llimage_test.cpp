@@ -0,0 +1,215 @@
+/**
+ * @file llimage_test.cpp
+ * @brief Tests of the LLImageRaw scaling and compositing code.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+
+// Class to test
+#include "../llimage.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include "llimageformats_stub.cpp"
+
+namespace
+{
+	// Noise, with alpha (if any) mostly 0 or 255 in runs, like a texture
+	// layer mask.
+	LLPointer<LLImageRaw> make_image(S32 width, S32 height, S32 components, U32 seed)
+	{
+		LLPointer<LLImageRaw> raw = new LLImageRaw(width, height, components);
+		U8* data = raw->getData();
+		for (S32 i = 0; i < width * height; ++i)
+		{
+			for (S32 c = 0; c < components; ++c)
+			{
+				seed = seed * 1103515245 + 12345;
+				data[i * components + c] = (U8)(seed >> 16);
+			}
+			if (components == 4)
+			{
+				S32 run = (i / 7) % 3;
+				data[i * 4 + 3] = run == 0 ? 0 : run == 1 ? 255 : data[i * 4 + 3];
+			}
+		}
+		return raw;
+	}
+
+	LLPointer<LLImageRaw> copy_image(const LLImageRaw* src)
+	{
+		return new LLImageRaw(const_cast<U8*>(src->getData()), src->getWidth(), src->getHeight(), src->getComponents());
+	}
+
+	bool same_data(const LLImageRaw* a, const LLImageRaw* b)
+	{
+		return a->getWidth() == b->getWidth() && a->getHeight() == b->getHeight() &&
+			   a->getComponents() == b->getComponents() &&
+			   !memcmp(a->getData(), b->getData(), a->getDataSize());
+	}
+
+	// scale() with and without the SIMD kernels.
+	bool scale_matches(S32 width, S32 height, S32 components, S32 new_width, S32 new_height)
+	{
+		LLPointer<LLImageRaw> source = make_image(width, height, components, width * 31 + height);
+		LLPointer<LLImageRaw> scalar = copy_image(source);
+		LLPointer<LLImageRaw> simd = copy_image(source);
+		LLImageRaw::sUseSIMD = false;
+		scalar->scale(new_width, new_height);
+		LLImageRaw::sUseSIMD = true;
+		simd->scale(new_width, new_height);
+		return same_data(scalar, simd);
+	}
+}
+
+namespace tut
+{
+	struct image_test
+	{
+		~image_test()
+		{
+			LLImageRaw::sUseSIMD = true;
+		}
+	};
+	typedef test_group<image_test> image_t;
+	typedef image_t::object image_object_t;
+	tut::image_t tut_image("LLImageRaw");
+
+	template<> template<>
+	void image_object_t::test<1>()
+	{
+		// The SIMD box filter gives exactly what the scalar one does.
+		for (S32 components = 1; components <= 4; ++components)
+		{
+			ensure("halve", scale_matches(256, 256, components, 128, 128));
+			ensure("reduce 8x", scale_matches(512, 256, components, 64, 32));
+			ensure("reduce 256x", scale_matches(512, 512, components, 2, 2));
+			ensure("arbitrary reduction", scale_matches(300, 210, components, 128, 64));
+			ensure("enlarge", scale_matches(100, 64, components, 256, 128));
+			ensure("mixed", scale_matches(256, 40, components, 77, 512));
+			ensure("odd row length", scale_matches(13, 256, components, 13, 100));
+		}
+	}
+
+	template<> template<>
+	void image_object_t::test<2>()
+	{
+		// A 2:1 reduction is the rounded average of each 2x2 block.
+		LLPointer<LLImageRaw> source = make_image(64, 32, 3, 7);
+		LLPointer<LLImageRaw> half = copy_image(source);
+		half->scale(32, 16);
+		const U8* in = source->getData();
+		for (S32 y = 0; y < 16; ++y)
+		{
+			for (S32 x = 0; x < 32; ++x)
+			{
+				for (S32 c = 0; c < 3; ++c)
+				{
+					S32 top = (in[((y * 2) * 64 + x * 2) * 3 + c] + in[((y * 2 + 1) * 64 + x * 2) * 3 + c] + 1) / 2;
+					S32 bottom = (in[((y * 2) * 64 + x * 2 + 1) * 3 + c] + in[((y * 2 + 1) * 64 + x * 2 + 1) * 3 + c] + 1) / 2;
+					ensure_equals("box filter", half->getData()[(y * 32 + x) * 3 + c], (top + bottom + 1) / 2);
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void image_object_t::test<3>()
+	{
+		// Compositing, flipping and format conversion.
+		LLPointer<LLImageRaw> layer = make_image(123, 45, 4, 1);
+		LLPointer<LLImageRaw> base = make_image(123, 45, 3, 2);
+		LLPointer<LLImageRaw> scalar = copy_image(base);
+		LLPointer<LLImageRaw> simd = copy_image(base);
+		LLImageRaw::sUseSIMD = false;
+		scalar->compositeUnscaled4onto3(layer);
+		LLImageRaw::sUseSIMD = true;
+		simd->compositeUnscaled4onto3(layer);
+		ensure("composite", same_data(scalar, simd));
+
+		LLPointer<LLImageRaw> small_layer = make_image(50, 30, 4, 3);
+		scalar = copy_image(base);
+		simd = copy_image(base);
+		LLImageRaw::sUseSIMD = false;
+		scalar->compositeScaled4onto3(small_layer);
+		LLImageRaw::sUseSIMD = true;
+		simd->compositeScaled4onto3(small_layer);
+		ensure("scaled composite", same_data(scalar, simd));
+
+		LLPointer<LLImageRaw> flipped = copy_image(layer);
+		flipped->verticalFlip();
+		ensure("flipped", !memcmp(flipped->getData(), layer->getData() + 44 * 123 * 4, 123 * 4));
+		flipped->verticalFlip();
+		ensure("flipped back", same_data(flipped, layer));
+
+		LLPointer<LLImageRaw> rgb = new LLImageRaw(123, 45, 3);
+		rgb->copyUnscaled4onto3(layer);
+		LLPointer<LLImageRaw> rgba = new LLImageRaw(123, 45, 4);
+		rgba->copyUnscaled3onto4(rgb);
+		for (S32 i = 0; i < 123 * 45; ++i)
+		{
+			ensure("rgb", !memcmp(rgba->getData() + i * 4, layer->getData() + i * 4, 3));
+			ensure_equals("opaque", rgba->getData()[i * 4 + 3], 255);
+		}
+	}
+
+	template<> template<>
+	void image_object_t::test<4>()
+	{
+		// Scaled compositing keeps the channels of an opaque layer apart:
+		// enlarging used to copy red into all of them, and shrinking
+		// vertically stepped through the layer three bytes per pixel.
+		LLPointer<LLImageRaw> layer = new LLImageRaw(4, 4, 4);
+		for (S32 y = 0; y < 4; ++y)
+		{
+			for (S32 x = 0; x < 4; ++x)
+			{
+				U8* px = layer->getData() + (y * 4 + x) * 4;
+				px[0] = 10 + x * 60;
+				px[1] = 20 + x * 60;
+				px[2] = 30 + x * 60;
+				px[3] = 255;
+			}
+		}
+		for (S32 simd = 0; simd < 2; ++simd)
+		{
+			LLImageRaw::sUseSIMD = simd != 0;
+			LLPointer<LLImageRaw> larger = make_image(8, 8, 3, 4);
+			larger->compositeScaled4onto3(layer);
+			LLPointer<LLImageRaw> shorter = make_image(4, 2, 3, 5);
+			shorter->compositeScaled4onto3(layer);
+			for (S32 c = 0; c < 3; ++c)
+			{
+				for (S32 i = 0; i < 8 * 8; ++i)
+				{
+					ensure_equals("enlarged", larger->getData()[i * 3 + c], layer->getData()[(i % 8 / 2) * 4 + c]);
+				}
+				for (S32 i = 0; i < 4 * 2; ++i)
+				{
+					ensure_equals("shrunk", shorter->getData()[i * 3 + c], layer->getData()[(i % 4) * 4 + c]);
+				}
+			}
+		}
+	}
+}
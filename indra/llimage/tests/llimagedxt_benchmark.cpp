@@ -0,0 +1,104 @@
+/**
+ * @file llimagedxt_benchmark.cpp
+ * @brief DXT compress and reload times of the decoded texture cache format.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+
+#include <iostream>
+
+// Class to benchmark
+#include "../llimagedxt.h"
+#include "../llcommon/lltimer.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include "llimageformats_stub.cpp"
+
+namespace
+{
+	// Smooth gradients with a little noise and a few hard edges, roughly
+	// what a photographic texture looks like to a block coder.
+	LLPointer<LLImageRaw> make_texture(S32 width, S32 height, S32 components)
+	{
+		LLPointer<LLImageRaw> raw = new LLImageRaw(width, height, components);
+		U8* data = raw->getData();
+		U32 seed = 12345;
+		for (S32 y = 0; y < height; ++y)
+		{
+			for (S32 x = 0; x < width; ++x)
+			{
+				seed = seed * 1103515245 + 12345;
+				S32 noise = (S32)((seed >> 16) & 7) - 4;
+				U8* px = data + (y * width + x) * components;
+				px[0] = (U8)llclamp(x * 255 / width + noise, 0, 255);
+				px[1] = (U8)llclamp(y * 255 / height + noise, 0, 255);
+				px[2] = (U8)(((x / 32) + (y / 32)) & 1 ? 200 : 40);
+				if (components == 4)
+				{
+					px[3] = (x < width / 2) ? 255 : 0;
+				}
+			}
+		}
+		return raw;
+	}
+}
+
+namespace tut
+{
+	struct imagedxt_benchmark
+	{
+	};
+	typedef test_group<imagedxt_benchmark> imagedxt_benchmark_t;
+	typedef imagedxt_benchmark_t::object imagedxt_benchmark_object_t;
+	tut::imagedxt_benchmark_t tut_imagedxt_benchmark("LLImageDXT_benchmark");
+
+	template<> template<>
+	void imagedxt_benchmark_object_t::test<1>()
+	{
+		// Reload cost from the compressed mip chain, per texture size. Compare
+		// with the J2C decode times of the same sizes; the viewer reports both
+		// in the texture statistics.
+		static const S32 sizes[] = { 128, 256, 512, 1024 };
+		std::cout << "\nDXR5 compress / reload, RGBA:" << std::endl;
+		for (U32 s = 0; s < LL_ARRAY_SIZE(sizes); ++s)
+		{
+			LLPointer<LLImageRaw> source = make_texture(sizes[s], sizes[s], 4);
+			LLPointer<LLImageDXT> dxt = new LLImageDXT();
+			LLTimer timer;
+			ensure("compress", dxt->compress(source));
+			F64 compress_ms = timer.getElapsedTimeF64() * 1000.0;
+			LLPointer<LLImageRaw> decoded = new LLImageRaw();
+			const S32 runs = 8;
+			timer.reset();
+			for (S32 i = 0; i < runs; ++i)
+			{
+				ensure("decode", dxt->decode(decoded, 0.f));
+			}
+			F64 reload_ms = timer.getElapsedTimeF64() * 1000.0 / runs;
+			std::cout << "  " << sizes[s] << "x" << sizes[s] << ": " << dxt->getDataSize() << " bytes, compress "
+					  << compress_ms << " ms, reload " << reload_ms << " ms" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,227 @@
+/**
+ * @file llimagedxt_test.cpp
+ * @brief Tests of the DXR1/DXR5 block codec used by the decoded texture cache.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+
+#include <cmath>
+
+// Class to test
+#include "../llimagedxt.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include "llimageformats_stub.cpp"
+
+namespace
+{
+	// Smooth gradients with a little noise and a few hard edges, roughly
+	// what a photographic texture looks like to a block coder.
+	LLPointer<LLImageRaw> make_texture(S32 width, S32 height, S32 components)
+	{
+		LLPointer<LLImageRaw> raw = new LLImageRaw(width, height, components);
+		U8* data = raw->getData();
+		U32 seed = 12345;
+		for (S32 y = 0; y < height; ++y)
+		{
+			for (S32 x = 0; x < width; ++x)
+			{
+				seed = seed * 1103515245 + 12345;
+				S32 noise = (S32)((seed >> 16) & 7) - 4;
+				U8* px = data + (y * width + x) * components;
+				px[0] = (U8)llclamp(x * 255 / width + noise, 0, 255);
+				px[1] = (U8)llclamp(y * 255 / height + noise, 0, 255);
+				px[2] = (U8)(((x / 32) + (y / 32)) & 1 ? 200 : 40);
+				if (components == 4)
+				{
+					px[3] = (x < width / 2) ? 255 : 0;
+				}
+			}
+		}
+		return raw;
+	}
+
+	F64 psnr(const LLImageRaw* a, const LLImageRaw* b, S32 channels)
+	{
+		F64 sum = 0.0;
+		S32 count = 0;
+		S32 components = a->getComponents();
+		for (S32 i = 0; i < a->getWidth() * a->getHeight(); ++i)
+		{
+			for (S32 c = 0; c < channels; ++c)
+			{
+				F64 d = (F64)a->getData()[i * components + c] - (F64)b->getData()[i * components + c];
+				sum += d * d;
+				++count;
+			}
+		}
+		F64 mse = sum / count;
+		return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 100.0;
+	}
+}
+
+namespace tut
+{
+	struct imagedxt_test
+	{
+	};
+	typedef test_group<imagedxt_test> imagedxt_t;
+	typedef imagedxt_t::object imagedxt_object_t;
+	tut::imagedxt_t tut_imagedxt("LLImageDXT");
+
+	template<> template<>
+	void imagedxt_object_t::test<1>()
+	{
+		// RGB round trip through DXR1, full size and a lower mip.
+		LLPointer<LLImageRaw> source = make_texture(256, 128, 3);
+		LLPointer<LLImageDXT> dxt = new LLImageDXT();
+		ensure("compress", dxt->compress(source));
+		ensure_equals("format", dxt->getFileFormat(), LLImageDXT::FORMAT_DXR1);
+		ensure_equals("4 bits per pixel", dxt->calcDataSize(0) - dxt->getMipOffset(0), 256 * 128 / 2);
+
+		LLPointer<LLImageRaw> decoded = new LLImageRaw();
+		ensure("decode", dxt->decode(decoded, 0.f));
+		ensure_equals("width", decoded->getWidth(), 256);
+		ensure_equals("height", decoded->getHeight(), 128);
+		ensure_equals("components", decoded->getComponents(), 3);
+		ensure("quality", psnr(source, decoded, 3) > 32.0);
+
+		// Mips are box filtered: discard 2 averages 4x4 pixels.
+		LLPointer<LLImageRaw> mip = new LLImageRaw(64, 32, 3);
+		for (S32 y = 0; y < 32; ++y)
+		{
+			for (S32 x = 0; x < 64; ++x)
+			{
+				for (S32 c = 0; c < 3; ++c)
+				{
+					S32 sum = 0;
+					for (S32 i = 0; i < 16; ++i)
+					{
+						sum += source->getData()[((y * 4 + i / 4) * 256 + x * 4 + i % 4) * 3 + c];
+					}
+					mip->getData()[(y * 64 + x) * 3 + c] = (U8)(sum / 16);
+				}
+			}
+		}
+		dxt->setDiscardLevel(2);
+		ensure("decode mip", dxt->decode(decoded, 0.f));
+		ensure_equals("mip width", decoded->getWidth(), 64);
+		ensure_equals("mip height", decoded->getHeight(), 32);
+		ensure("mip quality", psnr(mip, decoded, 3) > 26.0);
+	}
+
+	template<> template<>
+	void imagedxt_object_t::test<2>()
+	{
+		// RGBA through DXR5: binary alpha and flat, exactly representable
+		// colours survive unchanged.
+		LLPointer<LLImageRaw> source = make_texture(64, 64, 4);
+		U8* data = source->getData();
+		for (S32 i = 0; i < 16 * 64; ++i)
+		{
+			data[i * 4] = 255;
+			data[i * 4 + 1] = 0;
+			data[i * 4 + 2] = 0;
+		}
+		LLPointer<LLImageDXT> dxt = new LLImageDXT();
+		ensure("compress", dxt->compress(source));
+		ensure_equals("format", dxt->getFileFormat(), LLImageDXT::FORMAT_DXR5);
+
+		LLPointer<LLImageRaw> decoded = new LLImageRaw();
+		ensure("decode", dxt->decode(decoded, 0.f));
+		ensure_equals("components", decoded->getComponents(), 4);
+		for (S32 i = 0; i < 64 * 64; ++i)
+		{
+			ensure_equals("alpha", decoded->getData()[i * 4 + 3], data[i * 4 + 3]);
+		}
+		for (S32 i = 0; i < 16 * 64; ++i)
+		{
+			ensure_equals("flat red", decoded->getData()[i * 4], 255);
+			ensure_equals("flat green", decoded->getData()[i * 4 + 1], 0);
+		}
+
+		// Neither one and two channel images nor odd sizes are compressed.
+		LLPointer<LLImageDXT> other = new LLImageDXT();
+		LLPointer<LLImageRaw> grey = new LLImageRaw(64, 64, 1);
+		ensure("grey", !other->compress(grey));
+		LLPointer<LLImageRaw> odd = new LLImageRaw(60, 64, 3);
+		ensure("not a power of two", !other->compress(odd));
+	}
+
+	template<> template<>
+	void imagedxt_object_t::test<3>()
+	{
+		// A file cut short after some mip keeps the smaller mips readable.
+		LLPointer<LLImageRaw> source = make_texture(128, 128, 4);
+		LLPointer<LLImageDXT> dxt = new LLImageDXT();
+		ensure("compress", dxt->compress(source));
+
+		S32 prefix = dxt->calcDataSize(3);
+		LLPointer<LLImageDXT> partial = new LLImageDXT();
+		U8* data = partial->allocateData(prefix);
+		memcpy(data, dxt->getData(), prefix);
+		ensure("update", partial->updateData());
+		ensure_equals("full size", partial->getWidth(), 128);
+		ensure_equals("discard", (S32)partial->getDiscardLevel(), 3);
+		LLPointer<LLImageRaw> decoded = new LLImageRaw();
+		ensure("decode", partial->decode(decoded, 0.f));
+		ensure_equals("mip width", decoded->getWidth(), 16);
+		partial->setDiscardLevel(2);
+		ensure("not enough data", !partial->decode(decoded, 0.f));
+	}
+
+	template<> template<>
+	void imagedxt_object_t::test<4>()
+	{
+		// Every size the decoded texture cache takes decodes at every level
+		// from the prefix of the file that holds it.
+		static const S32 sizes[] = { 64, 128, 256, 512 };
+		for (U32 s = 0; s < LL_ARRAY_SIZE(sizes); ++s)
+		{
+			S32 size = sizes[s];
+			LLPointer<LLImageRaw> source = make_texture(size, size / 2, 4);
+			LLPointer<LLImageDXT> dxt = new LLImageDXT();
+			ensure("compress", dxt->compress(source));
+			ensure_equals("whole file", dxt->calcDataSize(0), dxt->getDataSize());
+			for (S32 discard = 0; (size >> discard) >= 4; ++discard)
+			{
+				S32 prefix = dxt->calcDataSize(discard);
+				ensure("smaller mips first", discard == 0 || prefix < dxt->calcDataSize(discard - 1));
+				LLPointer<LLImageDXT> partial = new LLImageDXT();
+				memcpy(partial->allocateData(prefix), dxt->getData(), prefix);
+				ensure("update", partial->updateData());
+				ensure_equals("discard", (S32)partial->getDiscardLevel(), discard);
+				LLPointer<LLImageRaw> decoded = new LLImageRaw();
+				ensure("decode", partial->decode(decoded, 0.f));
+				ensure_equals("width", decoded->getWidth(), size >> discard);
+				ensure_equals("height", decoded->getHeight(), size >> (discard + 1));
+				if (discard == 0)
+				{
+					ensure("quality", psnr(source, decoded, 4) > 30.0);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/**
+ * @file llimageformats_stub.cpp
+ * @brief Stubs of the image formats llimage.cpp creates, to allow unit testing
+ * of llimage.cpp without the codec libraries and the J2C DSO.
+ *
+ * $LicenseInfo:firstyear=2008&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llimagebmp.h"
+#include "../llimagej2c.h"
+#include "../llimagejpeg.h"
+#include "../llimagepng.h"
+#include "../llimagetga.h"
+
+LLImageBMP::LLImageBMP() : LLImageFormatted(IMG_CODEC_BMP) { }
+LLImageBMP::~LLImageBMP() { }
+BOOL LLImageBMP::updateData() { return FALSE; }
+BOOL LLImageBMP::decode(LLImageRaw* raw_image, F32 decode_time) { return FALSE; }
+BOOL LLImageBMP::encode(const LLImageRaw* raw_image, F32 encode_time) { return FALSE; }
+
+LLImageTGA::LLImageTGA() : LLImageFormatted(IMG_CODEC_TGA) { }
+LLImageTGA::~LLImageTGA() { }
+BOOL LLImageTGA::updateData() { return FALSE; }
+BOOL LLImageTGA::decode(LLImageRaw* raw_image, F32 decode_time) { return FALSE; }
+BOOL LLImageTGA::encode(const LLImageRaw* raw_image, F32 encode_time) { return FALSE; }
+
+LLImageJPEG::LLImageJPEG(S32 quality) : LLImageFormatted(IMG_CODEC_JPEG) { }
+LLImageJPEG::~LLImageJPEG() { }
+BOOL LLImageJPEG::updateData() { return FALSE; }
+BOOL LLImageJPEG::decode(LLImageRaw* raw_image, F32 decode_time) { return FALSE; }
+BOOL LLImageJPEG::encode(const LLImageRaw* raw_image, F32 encode_time) { return FALSE; }
+
+LLImagePNG::LLImagePNG() : LLImageFormatted(IMG_CODEC_PNG) { }
+LLImagePNG::~LLImagePNG() { }
+BOOL LLImagePNG::updateData() { return FALSE; }
+BOOL LLImagePNG::decode(LLImageRaw* raw_image, F32 decode_time) { return FALSE; }
+BOOL LLImagePNG::encode(const LLImageRaw* raw_image, F32 encode_time) { return FALSE; }
+
+LLImageJ2C::LLImageJ2C() : LLImageFormatted(IMG_CODEC_J2C), mImpl(NULL) { }
+LLImageJ2C::~LLImageJ2C() { }
+BOOL LLImageJ2C::updateData() { return FALSE; }
+BOOL LLImageJ2C::decode(LLImageRaw* raw_imagep, F32 decode_time) { return FALSE; }
+BOOL LLImageJ2C::decodeChannels(LLImageRaw* raw_imagep, F32 decode_time, S32 first_channel, S32 max_channel_count) { return FALSE; }
+BOOL LLImageJ2C::encode(const LLImageRaw* raw_imagep, F32 encode_time) { return FALSE; }
+S32 LLImageJ2C::calcHeaderSize() { return 0; }
+S32 LLImageJ2C::calcDataSize(S32 discard_level) { return 0; }
+S32 LLImageJ2C::calcDiscardLevelBytes(S32 bytes) { return 0; }
+S8 LLImageJ2C::getRawDiscardLevel() { return 0; }
+void LLImageJ2C::resetLastError() { }
+void LLImageJ2C::setLastError(const std::string& message, const std::string& filename) { }
+void LLImageJ2C::openDSO() { }
+void LLImageJ2C::closeDSO() { }
@@ -0,0 +1,104 @@
+/** 
+ * @file llimagej2cindex_benchmark.cpp
+ * @brief Bytes fetched per discard level with and without the J2C codestream index.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+
+#include <iostream>
+#include <vector>
+
+// Class to benchmark
+#include "../llimagej2cindex.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include "llimagej2cindex_codestream.h"
+
+namespace
+{
+	// What the fetcher asked for before it could read the sizes: the
+	// LLImageJ2C::calcDataSizeJ2C() estimate at its default rate.
+	S32 estimated_size(S32 w, S32 h, S32 comps, S32 discard)
+	{
+		w >>= discard;
+		h >>= discard;
+		return llmax((S32)(w * h * comps * .125f), 600);
+	}
+}
+
+namespace tut
+{
+	struct j2cindex_benchmark
+	{
+	};
+	typedef test_group<j2cindex_benchmark> j2cindex_benchmark_t;
+	typedef j2cindex_benchmark_t::object j2cindex_benchmark_object_t;
+	tut::j2cindex_benchmark_t tut_j2cindex_benchmark("LLImageJ2CIndex_benchmark");
+
+	template<> template<>
+	void j2cindex_benchmark_object_t::test<1>()
+	{
+		// Bytes requested per discard level, estimated vs exact, over a synthetic
+		// corpus of texture sizes and compressibility.
+		static const S32 sizes[] = { 64, 128, 256, 512, 1024 };
+		static const F32 rates[] = { 0.02f, 0.05f, 0.1f, 0.2f, 0.3f };
+		U64 estimated[6] = { 0 }, exact[6] = { 0 }, over[6] = { 0 }, under[6] = { 0 };
+		S32 images = 0;
+		std::vector<U8> stream;
+		std::vector<S32> res_ends;
+		LLImageJ2CIndex index;
+		for (U32 s = 0; s < LL_ARRAY_SIZE(sizes); ++s)
+		{
+			for (U32 t = 0; t < LL_ARRAY_SIZE(rates); ++t)
+			{
+				for (S32 comps = 3; comps <= 4; ++comps)
+				{
+					CodestreamSpec spec = make_spec(sizes[s], sizes[(s + t) % LL_ARRAY_SIZE(sizes)], comps, LLImageJ2CIndex::RPCL, 1);
+					spec.mBytesPerSample = rates[t];
+					build_codestream(spec, stream, res_ends);
+					ensure("corpus parse", index.parse(&stream[0], llmin((S32)stream.size(), 600)));
+					++images;
+					for (S32 discard = 1; discard <= 5; ++discard)
+					{
+						S32 guess = llmin(estimated_size(spec.mWidth, spec.mHeight, comps, discard), (S32)stream.size());
+						S32 need = index.getDataSize(discard);
+						ensure("corpus exact", need > 0);
+						estimated[discard] += guess;
+						exact[discard] += need;
+						over[discard] += llmax(guess - need, 0);
+						under[discard] += llmax(need - guess, 0);
+					}
+				}
+			}
+		}
+		std::cout << "\nJ2C bytes per discard level over " << images << " synthetic textures:" << std::endl;
+		for (S32 discard = 1; discard <= 5; ++discard)
+		{
+			std::cout << "  discard " << discard << ": estimated " << estimated[discard]
+					  << ", exact " << exact[discard] << ", overfetch saved " << over[discard]
+					  << ", underfetch avoided " << under[discard] << std::endl;
+		}
+	}
+}
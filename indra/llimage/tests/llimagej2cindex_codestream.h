@@ -0,0 +1,239 @@
+/** 
+ * @file llimagej2cindex_codestream.h
+ * @brief Synthetic J2C codestreams for the J2C index test and benchmark.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEJ2CINDEX_CODESTREAM_H
+#define LL_LLIMAGEJ2CINDEX_CODESTREAM_H
+
+#include <vector>
+
+namespace
+{
+	// Writes a minimal codestream: SIZ, COD, QCD, optionally TLM, then one
+	// tile-part (or one per resolution) with optional PLT, packets of made up
+	// lengths and EOC. The packet bodies are zeroes; the index never looks
+	// into them. res_ends receives where each resolution really ends.
+	struct CodestreamSpec
+	{
+		S32 mWidth;
+		S32 mHeight;
+		S32 mComponents;
+		S32 mLevels;
+		S32 mLayers;
+		U8 mOrder;
+		bool mPLT;
+		bool mTLM;
+		bool mTilePartPerResolution;
+		F32 mBytesPerSample;
+	};
+
+	void put16(std::vector<U8>& out, U32 value)
+	{
+		out.push_back((U8)(value >> 8));
+		out.push_back((U8)value);
+	}
+
+	void put32(std::vector<U8>& out, U32 value)
+	{
+		put16(out, value >> 16);
+		put16(out, value);
+	}
+
+	void put_length(std::vector<U8>& out, U32 length)
+	{
+		U8 bytes[5];
+		S32 count = 0;
+		do
+		{
+			bytes[count++] = length & 0x7f;
+			length >>= 7;
+		}
+		while (length);
+		while (count-- > 0)
+		{
+			out.push_back(bytes[count] | (count ? 0x80 : 0));
+		}
+	}
+
+	void build_codestream(const CodestreamSpec& spec, std::vector<U8>& out, std::vector<S32>& res_ends)
+	{
+		// Packet lengths, resolution by resolution: one precinct per resolution,
+		// so layers * components packets each.
+		std::vector<std::vector<U32> > packets(spec.mLevels + 1);
+		for (S32 r = 0; r <= spec.mLevels; ++r)
+		{
+			S32 shift = spec.mLevels - r;
+			S32 w = (spec.mWidth + (1 << shift) - 1) >> shift;
+			S32 h = (spec.mHeight + (1 << shift) - 1) >> shift;
+			// Resolution r only adds the detail bands: 3/4 of its samples.
+			F32 samples = r ? w * h * 0.75f : (F32)(w * h);
+			for (S32 i = 0; i < spec.mLayers * spec.mComponents; ++i)
+			{
+				U32 length = (U32)(samples * spec.mBytesPerSample / spec.mLayers) + 1 + (i % 3);
+				packets[r].push_back(length);
+			}
+		}
+
+		std::vector<std::vector<U8> > tile_parts;
+		std::vector<std::vector<U32> > part_packets;
+		if (spec.mTilePartPerResolution)
+		{
+			part_packets = packets;
+		}
+		else
+		{
+			part_packets.resize(1);
+			for (S32 r = 0; r <= spec.mLevels; ++r)
+			{
+				part_packets[0].insert(part_packets[0].end(), packets[r].begin(), packets[r].end());
+			}
+		}
+		for (U32 i = 0; i < part_packets.size(); ++i)
+		{
+			std::vector<U8> plt;
+			for (U32 p = 0; p < part_packets[i].size(); ++p)
+			{
+				put_length(plt, part_packets[i][p]);
+			}
+			U32 body = 0;
+			for (U32 p = 0; p < part_packets[i].size(); ++p)
+			{
+				body += part_packets[i][p];
+			}
+			std::vector<U8> part;
+			U32 header = 12 + (spec.mPLT ? 5 + plt.size() : 0) + 2;
+			put16(part, 0xff90);
+			put16(part, 10);
+			put16(part, 0);
+			put32(part, header + body);
+			part.push_back((U8)i);
+			part.push_back((U8)part_packets.size());
+			if (spec.mPLT)
+			{
+				put16(part, 0xff58);
+				put16(part, 3 + plt.size());
+				part.push_back(0);
+				part.insert(part.end(), plt.begin(), plt.end());
+			}
+			put16(part, 0xff93);
+			part.resize(part.size() + body, 0);
+			tile_parts.push_back(part);
+		}
+
+		out.clear();
+		put16(out, 0xff4f);
+		put16(out, 0xff51);
+		put16(out, 38 + 3 * spec.mComponents);
+		put16(out, 0);
+		put32(out, spec.mWidth);
+		put32(out, spec.mHeight);
+		put32(out, 0);
+		put32(out, 0);
+		put32(out, spec.mWidth);
+		put32(out, spec.mHeight);
+		put32(out, 0);
+		put32(out, 0);
+		put16(out, spec.mComponents);
+		for (S32 c = 0; c < spec.mComponents; ++c)
+		{
+			out.push_back(7);
+			out.push_back(1);
+			out.push_back(1);
+		}
+		put16(out, 0xff52);
+		put16(out, 12);
+		out.push_back(0);
+		out.push_back(spec.mOrder);
+		put16(out, spec.mLayers);
+		out.push_back(spec.mComponents >= 3 ? 1 : 0);
+		out.push_back((U8)spec.mLevels);
+		out.push_back(4);
+		out.push_back(4);
+		out.push_back(0);
+		out.push_back(0);
+		put16(out, 0xff5c);
+		put16(out, 4);
+		out.push_back(0x40);
+		out.push_back(0x48);
+		if (spec.mTLM)
+		{
+			put16(out, 0xff55);
+			put16(out, 4 + 5 * tile_parts.size());
+			out.push_back(0);
+			out.push_back(0x50);
+			for (U32 i = 0; i < tile_parts.size(); ++i)
+			{
+				out.push_back(0);
+				put32(out, tile_parts[i].size());
+			}
+		}
+
+		res_ends.assign(spec.mLevels + 1, 0);
+		U32 offset = out.size();
+		for (U32 i = 0; i < tile_parts.size(); ++i)
+		{
+			U32 body_start = offset + tile_parts[i].size();
+			for (U32 p = 0; p < part_packets[i].size(); ++p)
+			{
+				body_start -= part_packets[i][p];
+			}
+			U32 end = body_start;
+			for (S32 r = 0, p = 0; r <= spec.mLevels; ++r)
+			{
+				if (spec.mTilePartPerResolution && r != (S32)i)
+				{
+					continue;
+				}
+				for (U32 k = 0; k < packets[r].size(); ++k)
+				{
+					end += part_packets[i][p++];
+				}
+				res_ends[r] = end;
+			}
+			out.insert(out.end(), tile_parts[i].begin(), tile_parts[i].end());
+			offset = out.size();
+		}
+		put16(out, 0xffd9);
+		res_ends[spec.mLevels] = out.size();
+	}
+
+	CodestreamSpec make_spec(S32 w, S32 h, S32 comps, U8 order, S32 layers)
+	{
+		CodestreamSpec spec;
+		spec.mWidth = w;
+		spec.mHeight = h;
+		spec.mComponents = comps;
+		spec.mLevels = 5;
+		spec.mLayers = layers;
+		spec.mOrder = order;
+		spec.mPLT = true;
+		spec.mTLM = false;
+		spec.mTilePartPerResolution = false;
+		spec.mBytesPerSample = 0.1f;
+		return spec;
+	}
+}
+
+#endif // LL_LLIMAGEJ2CINDEX_CODESTREAM_H
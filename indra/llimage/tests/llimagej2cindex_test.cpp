@@ -0,0 +1,178 @@
+/** 
+ * @file llimagej2cindex_test.cpp
+ * @brief Tests of the J2C codestream index on synthetic codestreams.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+
+#include <vector>
+
+// Class to test
+#include "../llimagej2cindex.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include "llimagej2cindex_codestream.h"
+
+namespace tut
+{
+	struct j2cindex_test
+	{
+	};
+	typedef test_group<j2cindex_test> j2cindex_t;
+	typedef j2cindex_t::object j2cindex_object_t;
+	tut::j2cindex_t tut_j2cindex("LLImageJ2CIndex");
+
+	template<> template<>
+	void j2cindex_object_t::test<1>()
+	{
+		// RPCL with packet lengths in the tile-part header: every level is exact,
+		// and already known from the first few hundred bytes.
+		CodestreamSpec spec = make_spec(512, 256, 4, LLImageJ2CIndex::RPCL, 3);
+		std::vector<U8> stream;
+		std::vector<S32> res_ends;
+		build_codestream(spec, stream, res_ends);
+
+		LLImageJ2CIndex index;
+		ensure("parse", index.parse(&stream[0], stream.size()));
+		ensure_equals("width", index.getWidth(), 512);
+		ensure_equals("height", index.getHeight(), 256);
+		ensure_equals("components", index.getComponents(), 4);
+		ensure_equals("levels", index.getLevels(), 5);
+		ensure_equals("codestream size", index.getCodestreamSize(), (S32)stream.size());
+		for (S32 discard = 0; discard <= 5; ++discard)
+		{
+			ensure_equals("discard size", index.getDataSize(discard), res_ends[5 - discard]);
+		}
+		ensure_equals("discard past the levels", index.getDataSize(7), res_ends[0]);
+
+		S32 header_only = index.getDataSize(5) - 1;
+		ensure("header only parse", index.parse(&stream[0], header_only));
+		for (S32 discard = 1; discard <= 5; ++discard)
+		{
+			ensure_equals("discard size from the header", index.getDataSize(discard), res_ends[5 - discard]);
+		}
+
+		// One quality layer makes LRCP resolution major too.
+		spec = make_spec(128, 128, 3, LLImageJ2CIndex::LRCP, 1);
+		build_codestream(spec, stream, res_ends);
+		ensure("LRCP parse", index.parse(&stream[0], stream.size()));
+		ensure_equals("LRCP single layer", index.getDataSize(2), res_ends[3]);
+	}
+
+	template<> template<>
+	void j2cindex_object_t::test<2>()
+	{
+		// One tile-part per resolution with TLM, no packet lengths at all.
+		CodestreamSpec spec = make_spec(1024, 1024, 3, LLImageJ2CIndex::RPCL, 1);
+		spec.mPLT = false;
+		spec.mTLM = true;
+		spec.mTilePartPerResolution = true;
+		std::vector<U8> stream;
+		std::vector<S32> res_ends;
+		build_codestream(spec, stream, res_ends);
+
+		LLImageJ2CIndex index;
+		ensure("parse", index.parse(&stream[0], 200));
+		ensure_equals("codestream size", index.getCodestreamSize(), (S32)stream.size());
+		for (S32 discard = 0; discard <= 5; ++discard)
+		{
+			ensure_equals("discard size", index.getDataSize(discard), res_ends[5 - discard]);
+		}
+	}
+
+	template<> template<>
+	void j2cindex_object_t::test<3>()
+	{
+		LLImageJ2CIndex index;
+		std::vector<U8> stream;
+		std::vector<S32> res_ends;
+
+		// Layers outermost: only the full resolution has a known size.
+		CodestreamSpec spec = make_spec(256, 256, 3, LLImageJ2CIndex::LRCP, 4);
+		build_codestream(spec, stream, res_ends);
+		ensure("LRCP parse", index.parse(&stream[0], stream.size()));
+		ensure_equals("LRCP discard 0", index.getDataSize(0), (S32)stream.size());
+		ensure_equals("LRCP discard 1", index.getDataSize(1), 0);
+
+		// No PLT, no TLM: the tile-part length still gives the total size.
+		spec = make_spec(256, 256, 3, LLImageJ2CIndex::RPCL, 1);
+		spec.mPLT = false;
+		build_codestream(spec, stream, res_ends);
+		ensure("no PLT parse", index.parse(&stream[0], 150));
+		ensure_equals("no PLT discard 0", index.getDataSize(0), (S32)stream.size());
+		ensure_equals("no PLT discard 2", index.getDataSize(2), 0);
+
+		// Truncated main header, or not a codestream at all.
+		ensure("truncated header", !index.parse(&stream[0], 40));
+		ensure("truncated header is invalid", !index.isValid());
+		ensure_equals("invalid size", index.getDataSize(0), 0);
+		U8 garbage[64] = { 0x89, 'P', 'N', 'G' };
+		ensure("not J2C", !index.parse(garbage, sizeof(garbage)));
+
+		// Packet lengths that do not add up to the tile-part length are ignored.
+		spec = make_spec(256, 256, 3, LLImageJ2CIndex::RPCL, 1);
+		build_codestream(spec, stream, res_ends);
+		std::vector<U8> bad(stream);
+		for (U32 i = 0; i + 1 < bad.size(); ++i)
+		{
+			if (bad[i] == 0xff && bad[i + 1] == 0x58)
+			{
+				bad[i + 5] ^= 0x01;		// first packet length, last 7 bits
+				break;
+			}
+		}
+		ensure("bad PLT parse", index.parse(&bad[0], bad.size()));
+		ensure_equals("bad PLT discard 1", index.getDataSize(1), 0);
+	}
+
+	template<> template<>
+	void j2cindex_object_t::test<4>()
+	{
+		// A corpus of texture sizes and compressibility, parsed from the first
+		// 600 bytes as the fetcher does: every level is known and exact.
+		static const S32 sizes[] = { 64, 128, 256, 512, 1024 };
+		static const F32 rates[] = { 0.02f, 0.05f, 0.1f, 0.2f, 0.3f };
+		std::vector<U8> stream;
+		std::vector<S32> res_ends;
+		LLImageJ2CIndex index;
+		for (U32 s = 0; s < LL_ARRAY_SIZE(sizes); ++s)
+		{
+			for (U32 t = 0; t < LL_ARRAY_SIZE(rates); ++t)
+			{
+				for (S32 comps = 3; comps <= 4; ++comps)
+				{
+					CodestreamSpec spec = make_spec(sizes[s], sizes[(s + t) % LL_ARRAY_SIZE(sizes)], comps, LLImageJ2CIndex::RPCL, 1);
+					spec.mBytesPerSample = rates[t];
+					build_codestream(spec, stream, res_ends);
+					ensure("corpus parse", index.parse(&stream[0], llmin((S32)stream.size(), 600)));
+					for (S32 discard = 0; discard <= 5; ++discard)
+					{
+						ensure_equals("corpus exact", index.getDataSize(discard), res_ends[5 - discard]);
+					}
+				}
+			}
+		}
+	}
+}
@@ -33,6 +33,9 @@
 #include "lltimer.h"
 //#include "llmemory.h"
 
+#include <list>
+#include <mutex>
+
 // Factory function: see declaration in llimagej2c.cpp
 LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl()
 {
@@ -96,6 +99,122 @@ int ceildivpow2(int a, int b)
 	return (a + (1 << b) - 1) >> b;
 }
 
+namespace
+{
+	// Decoded lower resolution levels of recently decoded codestreams, so that
+	// raising a texture from one discard level to the next only decodes the
+	// levels that are new. An entry is only stored once the codestream index
+	// says the levels it holds were complete, and it is keyed on a hash of
+	// exactly the bytes those levels were decoded from: any codestream that
+	// starts with the same bytes reconstructs to the same levels.
+	class LLJ2CResumeCache
+	{
+	public:
+		static const size_t MAX_BYTES = 32 * 1024 * 1024;
+		static const S32 KEY_BYTES = 512;
+
+		// Returns the state held for this codestream, if it holds less than
+		// resno, or a new empty one. The caller owns it until put() or destroy.
+		static opj_resume_t* take(const U8* data, S32 data_size, S32 resno);
+		// Keeps resume for codestreams starting with the first covered bytes of data.
+		static void put(opj_resume_t* resume, const U8* data, S32 covered);
+
+	private:
+		struct Entry
+		{
+			opj_resume_t* mResume;
+			U64 mKeyHash;			// Hash of the first KEY_BYTES (or covered) bytes
+			U64 mHash;				// Hash of the first mCovered bytes
+			S32 mCovered;
+			size_t mBytes;
+		};
+		typedef std::list<Entry> entries_t;
+
+		static U64 hash(const U8* data, S32 size);
+		static size_t bytesHeld(const opj_resume_t* resume);
+
+		static std::mutex sMutex;
+		static entries_t sEntries;		// Most recently used first
+		static size_t sBytes;
+	};
+
+	std::mutex LLJ2CResumeCache::sMutex;
+	LLJ2CResumeCache::entries_t LLJ2CResumeCache::sEntries;
+	size_t LLJ2CResumeCache::sBytes = 0;
+
+	//static
+	U64 LLJ2CResumeCache::hash(const U8* data, S32 size)
+	{
+		// FNV-1a
+		U64 h = 14695981039346656037ULL;
+		for (const U8* end = data + size; data < end; ++data)
+		{
+			h = (h ^ *data) * 1099511628211ULL;
+		}
+		return h;
+	}
+
+	//static
+	size_t LLJ2CResumeCache::bytesHeld(const opj_resume_t* resume)
+	{
+		size_t bytes = 0;
+		for (S32 c = 0; c < resume->numcomps; ++c)
+		{
+			bytes += (size_t)resume->w[c] * resume->h[c] * sizeof(int);
+		}
+		return bytes;
+	}
+
+	//static
+	opj_resume_t* LLJ2CResumeCache::take(const U8* data, S32 data_size, S32 resno)
+	{
+		U64 key_hash = hash(data, llmin(data_size, KEY_BYTES));
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+			for (entries_t::iterator it = sEntries.begin(); it != sEntries.end(); ++it)
+			{
+				if (it->mCovered > data_size || it->mResume->resno >= resno
+					|| it->mKeyHash != (it->mCovered < KEY_BYTES ? hash(data, it->mCovered) : key_hash)
+					|| it->mHash != hash(data, it->mCovered))
+				{
+					continue;
+				}
+				opj_resume_t* resume = it->mResume;
+				sBytes -= it->mBytes;
+				sEntries.erase(it);
+				return resume;
+			}
+		}
+		return opj_resume_create();
+	}
+
+	//static
+	void LLJ2CResumeCache::put(opj_resume_t* resume, const U8* data, S32 covered)
+	{
+		Entry entry;
+		entry.mResume = resume;
+		entry.mKeyHash = hash(data, llmin(covered, KEY_BYTES));
+		entry.mHash = hash(data, covered);
+		entry.mCovered = covered;
+		entry.mBytes = bytesHeld(resume);
+		if (entry.mBytes > MAX_BYTES / 4)
+		{
+			opj_resume_destroy(resume);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(sMutex);
+		sEntries.push_front(entry);
+		sBytes += entry.mBytes;
+		while (sBytes > MAX_BYTES)
+		{
+			sBytes -= sEntries.back().mBytes;
+			opj_resume_destroy(sEntries.back().mResume);
+			sEntries.pop_back();
+		}
+	}
+}
+
 
 LLImageJ2COJ::LLImageJ2COJ()
 	: LLImageJ2CImpl()
@@ -190,6 +309,16 @@ BOOL LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	}
 
 
+	// Resolution progressive codestreams are decoded incrementally: the levels
+	// decoded on the way to this discard level are picked up where they were.
+	opj_resume_t* resume = NULL;
+	const LLImageJ2CIndex& index = base.getIndex();
+	if (index.isResolutionProgressive() && index.getComponents() <= OPJ_RESUME_MAXCOMPS)
+	{
+		resume = LLJ2CResumeCache::take(base.getData(), base.getDataSize(), index.getLevels() - parameters.cp_reduce);
+		parameters.resume = resume;
+	}
+
 	/* decode the code-stream */
 	/* ---------------------- */
 
@@ -219,6 +348,21 @@ BOOL LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 		opj_destroy_decompress(dinfo);
 	}
 
+	if (resume)
+	{
+		// Keep the decoded levels if they were complete and there are more to come.
+		S32 level_size = index.getDataSize(parameters.cp_reduce);
+		if (image && parameters.cp_reduce > 0 && resume->resno == index.getLevels() - parameters.cp_reduce
+			&& level_size > 0 && level_size <= base.getDataSize())
+		{
+			LLJ2CResumeCache::put(resume, base.getData(), level_size);
+		}
+		else
+		{
+			opj_resume_destroy(resume);
+		}
+	}
+
 	// The image decode failed if the return was NULL or the component
 	// count was zero.  The latter is just a sanity check before we
 	// dereference the array.
@@ -0,0 +1,223 @@
+/**
+ * @file llimagej2coj_test.cpp
+ * @brief Tests that resumed OpenJPEG decodes match full decodes.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "../llcommon/linden_common.h"
+
+#include <vector>
+
+// Class to test
+#include "../llimagej2coj.h"
+#include "openjpeg.h"
+#include "llimagej2cindex.h"
+// Tut header
+#include "../test/lltut.h"
+
+// -------------------------------------------------------------------------------------------
+// Stubbing: Declarations required to link and run the class being tested
+// Notes:
+// * Add here stubbed implementation of the few classes and methods used in the class to be tested
+// * Add as little as possible (let the link errors guide you)
+// * Do not make any assumption as to how those classes or methods work (i.e. don't copy/paste code)
+// * A simulator for a class can be implemented here. Please comment and document thoroughly.
+
+LLImageJ2CImpl::~LLImageJ2CImpl() { }
+const U8* LLImageBase::getData() const { return NULL; }
+U8* LLImageBase::getData() { return NULL; }
+void LLImageBase::setSize(S32 width, S32 height, S32 ncomponents) { }
+BOOL LLImageRaw::resize(U16 width, U16 height, S8 components) { return FALSE; }
+BOOL LLImageFormatted::copyData(U8 *data, S32 size) { return FALSE; }
+void LLImageJ2C::decodeFailed() { }
+void LLImageJ2C::updateRawDiscardLevel() { }
+const LLImageJ2CIndex& LLImageJ2C::getIndex() { return mIndex; }
+
+// End Stubbing
+// -------------------------------------------------------------------------------------------
+
+namespace
+{
+	const S32 WIDTH = 157;		// Odd sizes, so that the lower levels round
+	const S32 HEIGHT = 93;
+	const S32 COMPONENTS = 3;
+	const S32 LEVELS = 5;
+
+	// Encodes a single tile image with the given wavelet and layers, in RPCL
+	// order so that the resolution levels come one after the other, with a
+	// tile-part per level so that the index knows where each one ends.
+	std::vector<U8> encode(bool reversible, S32 layers)
+	{
+		opj_cparameters_t parameters;
+		opj_set_default_encoder_parameters(&parameters);
+		parameters.cod_format = 0;
+		parameters.cp_disto_alloc = 1;
+		parameters.numresolution = LEVELS + 1;
+		parameters.prog_order = RPCL;
+		parameters.tcp_numlayers = layers;
+		for (S32 i = 0; i < layers; ++i)
+		{
+			// From most to least compressed; the last layer of a reversible encode is lossless.
+			parameters.tcp_rates[i] = (reversible && i == layers - 1) ? 0.f : (F32)(40 >> (2 * i));
+		}
+		parameters.irreversible = reversible ? 0 : 1;
+		parameters.tcp_mct = 1;
+		parameters.cp_comment = (char*)"";
+		parameters.tp_on = 1;
+		parameters.tp_flag = 'R';
+
+		opj_image_cmptparm_t cmptparm[COMPONENTS];
+		memset(cmptparm, 0, sizeof(cmptparm));
+		for (S32 c = 0; c < COMPONENTS; ++c)
+		{
+			cmptparm[c].prec = 8;
+			cmptparm[c].bpp = 8;
+			cmptparm[c].dx = 1;
+			cmptparm[c].dy = 1;
+			cmptparm[c].w = WIDTH;
+			cmptparm[c].h = HEIGHT;
+		}
+		opj_image_t* image = opj_image_create(COMPONENTS, cmptparm, CLRSPC_SRGB);
+		image->x1 = WIDTH;
+		image->y1 = HEIGHT;
+		// Gradients with some texture on top, so that every level has detail.
+		for (S32 y = 0; y < HEIGHT; ++y)
+		{
+			for (S32 x = 0; x < WIDTH; ++x)
+			{
+				S32 i = y * WIDTH + x;
+				image->comps[0].data[i] = (x * 255) / WIDTH;
+				image->comps[1].data[i] = (y * 255) / HEIGHT;
+				image->comps[2].data[i] = ((x * 7) ^ (y * 13)) & 0xff;
+			}
+		}
+
+		opj_cinfo_t* cinfo = opj_create_compress(CODEC_J2K);
+		opj_setup_encoder(cinfo, &parameters, image);
+		opj_cio_t* cio = opj_cio_open((opj_common_ptr)cinfo, NULL, 0);
+		std::vector<U8> codestream;
+		if (opj_encode(cinfo, cio, image, NULL))
+		{
+			codestream.assign(cio->buffer, cio->buffer + cio_tell(cio));
+		}
+		opj_cio_close(cio);
+		opj_destroy_compress(cinfo);
+		opj_image_destroy(image);
+		return codestream;
+	}
+
+	opj_image_t* decode(std::vector<U8>& codestream, S32 size, S32 reduce, opj_resume_t* resume)
+	{
+		opj_dparameters_t parameters;
+		opj_set_default_decoder_parameters(&parameters);
+		parameters.cp_reduce = reduce;
+		parameters.resume = resume;
+		opj_dinfo_t* dinfo = opj_create_decompress(CODEC_J2K);
+		opj_setup_decoder(dinfo, &parameters);
+		opj_cio_t* cio = opj_cio_open((opj_common_ptr)dinfo, &codestream[0], size);
+		opj_image_t* image = opj_decode(dinfo, cio);
+		opj_cio_close(cio);
+		opj_destroy_decompress(dinfo);
+		return image;
+	}
+
+	// True when both decodes reconstructed the same samples.
+	bool same_image(const opj_image_t* full, const opj_image_t* resumed)
+	{
+		if (!full || !resumed || full->numcomps != resumed->numcomps)
+		{
+			return false;
+		}
+		for (S32 c = 0; c < full->numcomps; ++c)
+		{
+			const opj_image_comp_t& a = full->comps[c];
+			const opj_image_comp_t& b = resumed->comps[c];
+			if (a.w != b.w || a.h != b.h || a.factor != b.factor || !a.data || !b.data
+				|| memcmp(a.data, b.data, a.w * a.h * sizeof(int)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+namespace tut
+{
+	struct j2coj_resume_test
+	{
+		// Decodes from the lowest to the highest level, each time with the data
+		// the viewer would have fetched for that level, carrying one resume
+		// state along, and checks every decode against one that starts over.
+		void check_levels(const char* name, bool reversible, S32 layers, S32 step)
+		{
+			std::vector<U8> codestream = encode(reversible, layers);
+			ensure(name, !codestream.empty());
+
+			LLImageJ2CIndex index;
+			ensure(name, index.parse(&codestream[0], codestream.size()));
+			ensure(name, index.isResolutionProgressive());
+			ensure_equals(name, index.getLevels(), LEVELS);
+
+			opj_resume_t* resume = opj_resume_create();
+			for (S32 reduce = LEVELS; reduce >= 0; reduce -= step)
+			{
+				S32 size = index.getDataSize(reduce);
+				ensure(name, size > 0);
+				opj_image_t* full = decode(codestream, size, reduce, NULL);
+				opj_image_t* resumed = decode(codestream, size, reduce, resume);
+				ensure(name, full != NULL);
+				ensure_equals(name, resume->resno, LEVELS - reduce);
+				ensure(name, same_image(full, resumed));
+				opj_image_destroy(full);
+				opj_image_destroy(resumed);
+			}
+			opj_resume_destroy(resume);
+		}
+	};
+	typedef test_group<j2coj_resume_test> j2coj_resume_t;
+	typedef j2coj_resume_t::object j2coj_resume_object_t;
+	tut::j2coj_resume_t tut_j2coj_resume("LLImageJ2COJ");
+
+	// Reversible 5-3 wavelet, one layer: integer samples carried over.
+	template<> template<>
+	void j2coj_resume_object_t::test<1>()
+	{
+		check_levels("5-3, one layer", true, 1, 1);
+	}
+
+	// Irreversible 9-7 wavelet, several layers: float samples carried over.
+	template<> template<>
+	void j2coj_resume_object_t::test<2>()
+	{
+		check_levels("9-7, three layers", false, 3, 1);
+	}
+
+	// Resuming several levels up at once, as when the fetch skips discard levels.
+	template<> template<>
+	void j2coj_resume_object_t::test<3>()
+	{
+		check_levels("9-7, skipping levels", false, 3, 2);
+		check_levels("5-3, skipping levels", true, 2, 3);
+	}
+}
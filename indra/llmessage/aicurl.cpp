@@ -430,6 +430,7 @@ void cleanupCurl(void)
 	LL_WARNS() << "Not all CurlMultiHandle objects were destroyed!" << LL_ENDL;
   gMainThreadEngine.flush();			// Not really related to curl, but why not.
   gStateMachineThreadEngine.flush();
+  gStateMachineThreadPool.flush();
   clearCommandQueue();
   Stats::print();
   ssl_cleanup();
@@ -932,6 +932,7 @@ P2(BGFolderHttpHandler, transfer_300s);
 P(BGItemHttpHandler);
 P(lcl_responder);
 P(mapLayerResponder);
+P2(mapTileResponder,							reply_15s);
 P(materialsResponder);
 P2(maturityPreferences,							transfer_30s_connect_10s);
 P(mediaDataClientResponder);
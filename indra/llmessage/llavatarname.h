@@ -45,6 +45,12 @@ public:
 	LLSD asLLSD() const;
 	void fromLLSD(const LLSD& sd);
 
+	// Conversion to and from the binary cache file: appendBinary() adds this
+	// name to buffer, fromBinary() reads one from data and advances it past
+	// the name. Returns false if the name does not fit before end.
+	void appendBinary(std::string& buffer) const;
+	bool fromBinary(const char*& data, const char* end);
+
 	// Used only in legacy mode when the display name capability is not provided server side
 	// or to otherwise create a temporary valid item.
 	void fromString(const std::string& full_name);
@@ -28,8 +28,10 @@
 
 #include "llavatarnamecache.h"
 
+#include "llatomic.h"
 #include "llcachename.h"		// we wrap this system
 #include "llcontrol.h"		// For LLCachedControl
+#include "llfile.h"
 #include "llframetimer.h"
 #include "llhttpclient.h"
 #include "llsd.h"
@@ -87,6 +89,21 @@ namespace LLAvatarNameCache
 	// Only need per-frame timing resolution.
 	LLFrameTimer sRequestTimer;
 
+	// Number of capability requests sent and not answered yet. Responders
+	// can be destroyed on the curl thread, so this is atomic.
+	LLAtomicS32 sRequestsInFlight(0);
+
+	// Lookups answered from the cache, and lookups that had to be queued.
+	U32 sCacheHits = 0;
+	U32 sCacheMisses = 0;
+
+	// Binary cache file header: "ANC1", then version, entry count and the
+	// size of the entries that follow.
+	const U32 BINARY_CACHE_MAGIC = 0x31434e41;
+	const U32 BINARY_CACHE_VERSION = 1;
+	// Smallest entry: id, expiry and update times, flag, four empty names.
+	const U32 BINARY_CACHE_MIN_ENTRY = UUID_BYTES + 8 + 8 + 1 + 4 * 2;
+
     // Maximum time an unrefreshed cache entry is allowed.
     const F64 MAX_UNREFRESHED_TIME = 20.0 * 60.0;
 
@@ -183,12 +200,32 @@ private:
 
 public:
 	LLAvatarNameResponder(const std::vector<LLUUID>& agent_ids)
-	:	mAgentIDs(agent_ids)
-	{ }
+	:	mAgentIDs(agent_ids),
+		mDone(false)
+	{
+		LLAvatarNameCache::sRequestsInFlight++;
+	}
+
+	// A request that never got a reply still frees its slot.
+	/*virtual*/ ~LLAvatarNameResponder()
+	{
+		requestDone();
+	}
 
 protected:
+	// Frees the request slot; failureResult() can get here twice.
+	void requestDone()
+	{
+		if (!mDone)
+		{
+			mDone = true;
+			--LLAvatarNameCache::sRequestsInFlight;
+		}
+	}
+
 	/*virtual*/ void httpSuccess()
 	{
+		requestDone();
 		const LLSD& content = getContent();
 		if (!content.isMap())
 		{
@@ -250,6 +287,7 @@ protected:
 		// or when loading textures on startup and using a very slow 
 		// network, this query may time out.
 		// What we should do depends on whether or not we have a cached name
+		requestDone();
 		LL_WARNS("AvNameCache") << dumpResponse() << LL_ENDL;
 
 		// Add dummy records for any agent IDs in this request that we do not have cached already
@@ -260,6 +298,9 @@ protected:
 			LLAvatarNameCache::handleAgentError(agent_id);
 		}
 	}
+
+private:
+	bool mDone;
 };
 
 // Provide some fallback for agents that return errors
@@ -323,6 +364,8 @@ void LLAvatarNameCache::requestNamesViaCapability()
 	// Apache can handle URLs of 4096 chars, but let's be conservative
 	static const U32 NAME_URL_MAX = 4096;
 	static const U32 NAME_URL_SEND_THRESHOLD = 3500;
+	static const LLCachedControl<U32> batch_size("AvatarNameRequestBatchSize", 100);
+	U32 max_ids = llmax((U32)batch_size, (U32)1);
 
 	std::string url;
 	url.reserve(NAME_URL_MAX);
@@ -357,7 +400,7 @@ void LLAvatarNameCache::requestNamesViaCapability()
 		// mark request as pending
 		sPendingQueue[agent_id] = now;
 
-		if (url.size() > NAME_URL_SEND_THRESHOLD)
+		if (url.size() > NAME_URL_SEND_THRESHOLD || ids >= max_ids)
 		{
 			break;
 		}
@@ -489,6 +532,110 @@ void LLAvatarNameCache::exportFile(std::ostream& ostr)
 	LLSDSerialize::toPrettyXML(data, ostr);
 }
 
+bool LLAvatarNameCache::importBinaryFile(const std::string& filename)
+{
+	llifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	U32 header[4];
+	if (!file.read((char*)header, sizeof(header)) ||
+		header[0] != BINARY_CACHE_MAGIC || header[1] != BINARY_CACHE_VERSION)
+	{
+		LL_WARNS("AvNameCache") << filename << " is not an avatar name cache file" << LL_ENDL;
+		return false;
+	}
+	// Check the sizes before allocating anything: a damaged header must not
+	// make us reserve gigabytes.
+	U32 count = header[2];
+	if ((std::streamsize)header[3] != llifstream_size(file) - (std::streamsize)sizeof(header) ||
+		count > header[3] / BINARY_CACHE_MIN_ENTRY)
+	{
+		LL_WARNS("AvNameCache") << "Avatar name cache file " << filename << " is truncated or corrupt" << LL_ENDL;
+		return false;
+	}
+	std::string buffer(header[3], '\0');
+	if (!buffer.empty() && !file.read(&buffer[0], buffer.size()))
+	{
+		LL_WARNS("AvNameCache") << "Avatar name cache file " << filename << " is truncated" << LL_ENDL;
+		return false;
+	}
+
+	// Decode everything before touching the cache, so that a damaged file
+	// leaves it as it was.
+	std::vector<std::pair<LLUUID, LLAvatarName> > entries(count);
+	const char* data = buffer.data();
+	const char* end = data + buffer.size();
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (end - data < UUID_BYTES)
+		{
+			LL_WARNS("AvNameCache") << "Avatar name cache file " << filename << " is corrupt" << LL_ENDL;
+			return false;
+		}
+		memcpy(entries[i].first.mData, data, UUID_BYTES);
+		data += UUID_BYTES;
+		if (!entries[i].second.fromBinary(data, end))
+		{
+			LL_WARNS("AvNameCache") << "Avatar name cache file " << filename << " is corrupt" << LL_ENDL;
+			return false;
+		}
+	}
+	for (U32 i = 0; i < count; ++i)
+	{
+		sCache[entries[i].first] = entries[i].second;
+	}
+	LL_INFOS("AvNameCache") << "LLAvatarNameCache loaded " << sCache.size() << LL_ENDL;
+	return true;
+}
+
+bool LLAvatarNameCache::exportBinaryFile(const std::string& filename)
+{
+	F64 max_unrefreshed = LLFrameTimer::getTotalSeconds() - MAX_UNREFRESHED_TIME;
+	LL_INFOS("AvNameCache") << "LLAvatarNameCache at exit cache has " << sCache.size()
+							<< ", hit ratio " << getHitRatio() << LL_ENDL;
+	std::string buffer;
+	buffer.reserve(sCache.size() * 64);
+	U32 count = 0;
+	for (cache_t::const_iterator it = sCache.begin(); it != sCache.end(); ++it)
+	{
+		// Do not write temporary or expired entries to the stored cache
+		if (it->second.isValidName(max_unrefreshed))
+		{
+			buffer.append((const char*)it->first.mData, UUID_BYTES);
+			it->second.appendBinary(buffer);
+			++count;
+		}
+	}
+	LL_INFOS("AvNameCache") << "LLAvatarNameCache returning " << count << LL_ENDL;
+
+	// Write next to the old file and swap it in, so that a crash halfway
+	// through does not lose the cache.
+	std::string temp_name = filename + ".tmp";
+	U32 header[4] = { BINARY_CACHE_MAGIC, BINARY_CACHE_VERSION, count, (U32)buffer.size() };
+	{
+		llofstream file(temp_name, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open() ||
+			!file.write((const char*)header, sizeof(header)) ||
+			!file.write(buffer.data(), buffer.size()))
+		{
+			LL_WARNS("AvNameCache") << "Unable to write avatar name cache to " << temp_name << LL_ENDL;
+			file.close();
+			LLFile::remove(temp_name);
+			return false;
+		}
+	}
+	LLFile::remove(filename);
+	return LLFile::rename(temp_name, filename) == 0;
+}
+
+F32 LLAvatarNameCache::getHitRatio()
+{
+	U32 lookups = sCacheHits + sCacheMisses;
+	return lookups ? (F32)sCacheHits / (F32)lookups : 0.f;
+}
+
 void LLAvatarNameCache::setNameLookupURL(const std::string& name_lookup_url)
 {
 	sNameLookupURL = name_lookup_url;
@@ -522,7 +669,13 @@ void LLAvatarNameCache::idle()
 	{
         if (usePeopleAPI())
         {
-            requestNamesViaCapability();
+			// Drain the queue in batches, with a bounded number of requests
+			// outstanding; the rest waits for replies to come in.
+			static const LLCachedControl<U32> max_requests("AvatarNameMaxConcurrentRequests", 4);
+			while (!sAskQueue.empty() && sRequestsInFlight < (S32)llmax((U32)max_requests, (U32)1))
+			{
+				requestNamesViaCapability();
+			}
         }
         else
         {
@@ -583,7 +736,8 @@ void LLAvatarNameCache::eraseUnrefreshed()
 			}
         }
         LL_INFOS("AvNameCache") << "LLAvatarNameCache expired " << expired << " cached avatar names, "
-                                << sCache.size() << " remaining" << LL_ENDL;
+                                << sCache.size() << " remaining, hit ratio " << getHitRatio()
+                                << " (" << sCacheHits << " hits, " << sCacheMisses << " misses)" << LL_ENDL;
 	}
 }
 
@@ -610,6 +764,7 @@ bool LLAvatarNameCache::get(const LLUUID& agent_id, LLAvatarName *av_name)
 				}
 			}
 			
+			++sCacheHits;
 			return true;
 		}
 		else if (!usePeopleAPI())
@@ -619,11 +774,13 @@ bool LLAvatarNameCache::get(const LLUUID& agent_id, LLAvatarName *av_name)
 			{
 				av_name->fromString(full_name);
 				sCache[agent_id] = *av_name;
+				++sCacheHits;
 				return true;
 			}
 		}
 	}
 
+	++sCacheMisses;
 	if (!isRequestPending(agent_id))
 	{
 		LL_DEBUGS("AvNameCache") << "LLAvatarNameCache queue request for agent " << agent_id << LL_ENDL;
@@ -673,11 +830,13 @@ LLAvatarNameCache::callback_connection_t LLAvatarNameCache::get(const LLUUID& ag
 			if (av_name.mExpires > LLFrameTimer::getTotalSeconds())
 			{
 				// ...name already exists in cache, fire callback now
+				++sCacheHits;
 				fireSignal(agent_id, slot, av_name);
 				return connection;
 			}
 		}
 	}
+	++sCacheMisses;
 
 	// schedule a request
 	if (!isRequestPending(agent_id))
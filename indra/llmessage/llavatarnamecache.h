@@ -49,6 +49,15 @@ namespace LLAvatarNameCache
 	bool importFile(std::istream& istr);
 	void exportFile(std::ostream& ostr);
 
+	// Same, in a compact binary form read in one pass at startup. The export
+	// replaces the file only once it is completely written; the import leaves
+	// the cache untouched and returns false if the file is damaged.
+	bool importBinaryFile(const std::string& filename);
+	bool exportBinaryFile(const std::string& filename);
+
+	// Fraction of get() calls answered from the cache since startup.
+	F32 getHitRatio();
+
 	// On the viewer, usually a simulator capabilitity.
 	// If empty, name cache will fall back to using legacy name lookup system.
 	void setNameLookupURL(const std::string& name_lookup_url);
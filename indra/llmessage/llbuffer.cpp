@@ -569,6 +569,21 @@ S32 LLBufferArray::countAfter(S32 channel, U8* start) const
 	return count;
 }
 
+void LLBufferArray::getChannelSegments(
+	S32 channel,
+	std::vector<std::pair<const U8*, size_t> >& segments) const
+{
+	LLMutexLock lock(mMutexp) ;
+	const_segment_iterator_t end = mSegments.end();
+	for(const_segment_iterator_t it = mSegments.begin(); it != end; ++it)
+	{
+		if((*it).isOnChannel(channel) && (*it).size())
+		{
+			segments.push_back(std::make_pair((const U8*)(*it).data(), (size_t)(*it).size()));
+		}
+	}
+}
+
 U8* LLBufferArray::readAfter(
 	S32 channel,
 	U8* start,
@@ -437,6 +437,20 @@ public:
 	 * @return Returns the address of the last read byte.
 	 */
 	U8* readAfter(S32 channel, U8* start, U8* dest, S32& len) const;
+
+	/** 
+	 * @brief Collect the segments on a channel without copying them
+	 *
+	 * Appends the address and size of every non-empty segment on
+	 * channel, in order, so the data can be parsed in place (see
+	 * LLSDSerialize::fromNotation()). The pointers stay valid until
+	 * the buffer array is modified.
+	 * @param channel The channel to collect.
+	 * @param segments[out] Receives the (address, size) pairs.
+	 */
+	void getChannelSegments(
+		S32 channel,
+		std::vector<std::pair<const U8*, size_t> >& segments) const;
  
 	/** 
 	 * @brief Find an address in a buffer array
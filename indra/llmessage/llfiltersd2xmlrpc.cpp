@@ -83,6 +83,7 @@
 #include "llmemorystream.h"
 #include "llsd.h"
 #include "llsdserialize.h"
+#include "llthread.h"
 #include "lluuid.h"
 
 // spammy mode
@@ -112,6 +113,34 @@ static const char LLSDRPC_FAULT_HADER_2[] = ", 'description':";
 static const char LLSDRPC_FAULT_FOOTER[] = "} }";
 static const S32 DEFAULT_PRECISION = 20;
 
+// Parses the structure data on channels.in() where it sits in the buffer,
+// then drops that data the same way reading it through an LLBufferStream
+// would have.
+static S32 parse_channel_notation(
+	LLSD& sd,
+	const LLChannelDescriptors& channels,
+	LLBufferArray* buffer)
+{
+	LLSDSerialize::segments_t segments;
+	buffer->getChannelSegments(channels.in(), segments);
+	S32 count = LLSDSerialize::fromNotation(sd, segments);
+
+	LLMutexLock lock(buffer->getMutex());
+	LLBufferArray::segment_iterator_t it = buffer->beginSegment();
+	while(it != buffer->endSegment())
+	{
+		if((*it).isOnChannel(channels.in()))
+		{
+			buffer->eraseSegment(it++);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	return count;
+}
+
 /**
  * LLFilterSD2XMLRPC
  */
@@ -332,9 +361,9 @@ LLIOPipe::EStatus LLFilterSD2XMLRPCResponse::process_impl(
 	// we have everyting in the buffer, so turn the structure data rpc
 	// response into an xml rpc response.
 	LLBufferStream stream(channels, buffer.get());
-	stream << XML_HEADER << XMLRPC_METHOD_RESPONSE_HEADER << std::flush;	// Flush, or buffer->count() returns too much!
+	stream << XML_HEADER << XMLRPC_METHOD_RESPONSE_HEADER << std::flush;
 	LLSD sd;
-	LLSDSerialize::fromNotation(sd, stream, buffer->count(channels.in()));
+	parse_channel_notation(sd, channels, buffer.get());
 
 	PUMP_DEBUG;
 	LLIOPipe::EStatus rv = STATUS_ERROR;
@@ -407,10 +436,8 @@ LLIOPipe::EStatus LLFilterSD2XMLRPCRequest::process_impl(
 	}
 
 	// See if we can parse it
-	LLBufferStream stream(channels, buffer.get());
 	LLSD sd;
-	LLSDSerialize::fromNotation(sd, stream, buffer->count(channels.in()));
-	if(stream.fail())
+	if(parse_channel_notation(sd, channels, buffer.get()) == LLSDParser::PARSE_FAILURE)
 	{
 		LL_INFOS() << "STREAM FAILURE reading structure data." << LL_ENDL;
 	}
@@ -484,7 +511,7 @@ LLIOPipe::EStatus LLFilterSD2XMLRPCRequest::process_impl(
 		break;
 	}
 
-	stream << XMLRPC_REQUEST_FOOTER << std::flush;
+	ostream << XMLRPC_REQUEST_FOOTER << std::flush;
 	return STATUS_DONE;
 }
 
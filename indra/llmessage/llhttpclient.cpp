@@ -326,16 +326,16 @@ void LLHTTPClient::ResponderBase::decode_llsd_body(LLChannelDescriptors const& c
 	bool const should_be_llsd = isGoodStatus(mStatus);
 	if (should_be_llsd)
 	{
-		LLBufferStream istr(channels, buffer.get());
-		if (LLSDSerialize::fromXML(mContent, istr) == LLSDParser::PARSE_FAILURE)
+		// Parse the body where it sits in the buffer.
+		LLSDSerialize::segments_t segments;
+		buffer->getChannelSegments(channels.in(), segments);
+		if (LLSDSerialize::fromXML(mContent, segments) == LLSDParser::PARSE_FAILURE)
 		{
-			// Unfortunately we can't show the body of the message... I think this is a pretty serious error
-			// though, so if this ever happens it has to be investigated by making a copy of the buffer
-			// before serializing it, as is done below.
+			// I think this is a pretty serious error, so if this ever happens it has to be investigated
+			// by making a copy of the buffer before serializing it, as is done below.
 			LL_WARNS() << "Failed to deserialize LLSD. " << mURL << " [" << mStatus << "]: " << mReason << LL_ENDL;
 			AICurlInterface::Stats::llsd_body_parse_error++;
 		}
-		// LLSDSerialize::fromXML destructed buffer, we can't initialize mContent now.
 		return;
 	}
 	// Put the body in mContent as-is.
@@ -0,0 +1,256 @@
+/**
+ * @file llpacketcapture.cpp
+ * @brief Recording of raw UDP traffic to disk and reading it back for replay.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpacketcapture.h"
+
+#include "lltimer.h"
+
+static const U32 CAPTURE_MAGIC = 0x4350534c;	// "LSPC"
+static const U32 CAPTURE_VERSION = 1;
+static const S32 CAPTURE_HEADER_SIZE = 16;
+static const S32 RECORD_HEADER_SIZE = 17;
+// Write and read in chunks of about this size.
+static const size_t CAPTURE_CHUNK_SIZE = 64 * 1024;
+
+namespace
+{
+	void put_u16(std::vector<U8>& buffer, U32 value)
+	{
+		buffer.push_back(value & 0xff);
+		buffer.push_back((value >> 8) & 0xff);
+	}
+
+	void put_u32(std::vector<U8>& buffer, U32 value)
+	{
+		put_u16(buffer, value & 0xffff);
+		put_u16(buffer, value >> 16);
+	}
+
+	U32 get_u16(const U8* data)
+	{
+		return data[0] | (data[1] << 8);
+	}
+
+	U32 get_u32(const U8* data)
+	{
+		return get_u16(data) | (get_u16(data + 2) << 16);
+	}
+}
+
+U64 packet_capture_clock()
+{
+	return totalTime();
+}
+
+///////////////////////////////////////////////////////////
+LLPacketCaptureWriter::LLPacketCaptureWriter()
+:	mFile(NULL),
+	mClock(packet_capture_clock),
+	mStartTime(0),
+	mLastTime(0),
+	mPacketCount(0)
+{
+}
+
+LLPacketCaptureWriter::~LLPacketCaptureWriter()
+{
+	close();
+}
+
+bool LLPacketCaptureWriter::open(const std::string& filename)
+{
+	close();
+	mFile = LLFile::fopen(filename, "wb");
+	if (!mFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet capture file " << filename << LL_ENDL;
+		return false;
+	}
+	mFilename = filename;
+	mStartTime = mLastTime = mClock();
+	mPacketCount = 0;
+	mBuffer.clear();
+	mBuffer.reserve(CAPTURE_CHUNK_SIZE + RECORD_HEADER_SIZE + NET_BUFFER_SIZE);
+	put_u32(mBuffer, CAPTURE_MAGIC);
+	put_u32(mBuffer, CAPTURE_VERSION);
+	put_u32(mBuffer, (U32)(mStartTime & 0xffffffff));
+	put_u32(mBuffer, (U32)(mStartTime >> 32));
+	LL_INFOS("Messaging") << "Capturing packets to " << filename << LL_ENDL;
+	return true;
+}
+
+void LLPacketCaptureWriter::close()
+{
+	if (mFile)
+	{
+		flush();
+		LLFile::close(mFile);
+		mFile = NULL;
+		LL_INFOS("Messaging") << "Captured " << mPacketCount << " packets to " << mFilename << LL_ENDL;
+	}
+}
+
+void LLPacketCaptureWriter::record(bool outgoing, const LLHost& remote_host, const LLHost& receiving_if,
+								   const char* data, S32 size)
+{
+	if (!mFile || size <= 0 || size > NET_BUFFER_SIZE)
+	{
+		return;
+	}
+	U64 now = mClock();
+	// Deltas over an hour only happen with a stopped clock or a paused process.
+	U32 delta = (U32)llclamp(now - mLastTime, (U64)0, (U64)U32_MAX);
+	mLastTime = now;
+
+	put_u32(mBuffer, delta);
+	mBuffer.push_back(outgoing ? LLPacketCaptureRecord::OUTGOING : 0);
+	put_u32(mBuffer, remote_host.getAddress());
+	put_u16(mBuffer, remote_host.getPort());
+	put_u32(mBuffer, receiving_if.getAddress());
+	put_u16(mBuffer, size);
+	mBuffer.insert(mBuffer.end(), (const U8*)data, (const U8*)data + size);
+	++mPacketCount;
+
+	if (mBuffer.size() >= CAPTURE_CHUNK_SIZE)
+	{
+		flush();
+	}
+}
+
+void LLPacketCaptureWriter::flush()
+{
+	if (mBuffer.empty())
+	{
+		return;
+	}
+	if (fwrite(&mBuffer[0], 1, mBuffer.size(), mFile) != mBuffer.size())
+	{
+		LL_WARNS("Messaging") << "Short write to packet capture file " << mFilename << ", stopping capture" << LL_ENDL;
+		mBuffer.clear();
+		LLFile::close(mFile);
+		mFile = NULL;
+		return;
+	}
+	mBuffer.clear();
+}
+
+///////////////////////////////////////////////////////////
+LLPacketCaptureReader::LLPacketCaptureReader()
+:	mFile(NULL),
+	mBufferPos(0),
+	mStartTime(0),
+	mTime(0)
+{
+}
+
+LLPacketCaptureReader::~LLPacketCaptureReader()
+{
+	close();
+}
+
+bool LLPacketCaptureReader::open(const std::string& filename)
+{
+	close();
+	mFile = LLFile::fopen(filename, "rb");
+	if (!mFile)
+	{
+		LL_WARNS("Messaging") << "Unable to open packet capture file " << filename << LL_ENDL;
+		return false;
+	}
+	mBuffer.clear();
+	mBufferPos = 0;
+	mTime = 0;
+	if (!fill(CAPTURE_HEADER_SIZE) ||
+		get_u32(&mBuffer[0]) != CAPTURE_MAGIC || get_u32(&mBuffer[4]) != CAPTURE_VERSION)
+	{
+		LL_WARNS("Messaging") << filename << " is not a packet capture file" << LL_ENDL;
+		close();
+		return false;
+	}
+	mStartTime = (U64)get_u32(&mBuffer[8]) | ((U64)get_u32(&mBuffer[12]) << 32);
+	mBufferPos = CAPTURE_HEADER_SIZE;
+	return true;
+}
+
+void LLPacketCaptureReader::close()
+{
+	if (mFile)
+	{
+		LLFile::close(mFile);
+		mFile = NULL;
+	}
+	mBuffer.clear();
+	mBufferPos = 0;
+}
+
+bool LLPacketCaptureReader::fill(S32 wanted)
+{
+	S32 available = (S32)mBuffer.size() - mBufferPos;
+	if (available >= wanted)
+	{
+		return true;
+	}
+	// Move what is left to the front and read the next chunk after it.
+	mBuffer.erase(mBuffer.begin(), mBuffer.begin() + mBufferPos);
+	mBufferPos = 0;
+	size_t read_size = llmax(CAPTURE_CHUNK_SIZE, (size_t)wanted);
+	mBuffer.resize(available + read_size);
+	size_t got = fread(&mBuffer[available], 1, read_size, mFile);
+	mBuffer.resize(available + got);
+	return (S32)mBuffer.size() >= wanted;
+}
+
+bool LLPacketCaptureReader::next(LLPacketCaptureRecord& record)
+{
+	if (!mFile || !fill(RECORD_HEADER_SIZE))
+	{
+		return false;
+	}
+	const U8* header = &mBuffer[mBufferPos];
+	S32 size = get_u16(header + 15);
+	if (size <= 0 || size > NET_BUFFER_SIZE)
+	{
+		LL_WARNS("Messaging") << "Corrupt packet capture record of size " << size << LL_ENDL;
+		return false;
+	}
+	if (!fill(RECORD_HEADER_SIZE + size))
+	{
+		// Capture cut short, e.g. by a crash.
+		return false;
+	}
+	header = &mBuffer[mBufferPos];
+	mTime += get_u32(header);
+	record.mTime = mTime;
+	record.mFlags = header[4];
+	record.mRemoteHost = LLHost(get_u32(header + 5), get_u16(header + 9));
+	record.mReceivingIF = LLHost(get_u32(header + 11), 0);
+	record.mSize = size;
+	memcpy(record.mData, header + RECORD_HEADER_SIZE, size);
+	mBufferPos += RECORD_HEADER_SIZE + size;
+	return true;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file llpacketcapture.h
+ * @brief Recording of raw UDP traffic to disk and reading it back for replay.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKETCAPTURE_H
+#define LL_LLPACKETCAPTURE_H
+
+#include <string>
+#include <vector>
+
+#include "llfile.h"
+#include "llhost.h"
+#include "net.h"
+
+// A capture file is a small header followed by one record per packet, as it
+// was on the wire (before zero code expansion and with the appended acks):
+//
+//   header:  U32 magic, U32 version, U64 start time (microseconds since epoch)
+//   record:  U32 microseconds since the previous record, U8 flags,
+//            U32 remote address, U16 remote port, U32 receiving interface,
+//            U16 size, then size bytes of packet data
+//
+// All integers are little endian. The remote host is the sender of an
+// incoming packet and the destination of an outgoing one.
+// Source of the microsecond times captures are recorded and replayed with.
+// The default is totalTime(); tests substitute their own.
+typedef U64 (*LLPacketCaptureClock)();
+U64 packet_capture_clock();
+
+struct LLPacketCaptureRecord
+{
+	enum
+	{
+		OUTGOING = 0x01
+	};
+
+	LLPacketCaptureRecord() : mTime(0), mFlags(0), mSize(0) {}
+
+	bool isOutgoing() const						{ return mFlags & OUTGOING; }
+
+	U64 mTime;				// microseconds since the start of the capture
+	U8 mFlags;
+	LLHost mRemoteHost;
+	LLHost mReceivingIF;
+	S32 mSize;
+	U8 mData[NET_BUFFER_SIZE];
+};
+
+class LLPacketCaptureWriter
+{
+public:
+	LLPacketCaptureWriter();
+	~LLPacketCaptureWriter();
+
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const							{ return mFile != NULL; }
+
+	// Set before open().
+	void setClock(LLPacketCaptureClock clock)	{ mClock = clock; }
+
+	// Appends a record. Records are buffered and written in large chunks, so
+	// this is cheap enough to call for every packet.
+	void record(bool outgoing, const LLHost& remote_host, const LLHost& receiving_if,
+				const char* data, S32 size);
+
+	U32 getPacketCount() const					{ return mPacketCount; }
+
+private:
+	void flush();
+
+private:
+	LLFILE* mFile;
+	std::string mFilename;
+	std::vector<U8> mBuffer;
+	LLPacketCaptureClock mClock;
+	U64 mStartTime;
+	U64 mLastTime;
+	U32 mPacketCount;
+};
+
+class LLPacketCaptureReader
+{
+public:
+	LLPacketCaptureReader();
+	~LLPacketCaptureReader();
+
+	// Fails when the file is missing or is not a capture.
+	bool open(const std::string& filename);
+	void close();
+	bool isOpen() const							{ return mFile != NULL; }
+
+	// Reads the next record into record. Returns false at the end of the
+	// file or on a truncated or corrupt record.
+	bool next(LLPacketCaptureRecord& record);
+
+	// Wall clock time the capture was started at, in microseconds.
+	U64 getStartTime() const					{ return mStartTime; }
+
+private:
+	bool fill(S32 wanted);
+
+private:
+	LLFILE* mFile;
+	std::vector<U8> mBuffer;
+	S32 mBufferPos;
+	U64 mStartTime;
+	U64 mTime;
+};
+
+#endif // LL_LLPACKETCAPTURE_H
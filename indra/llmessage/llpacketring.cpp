@@ -37,6 +37,7 @@
 
 // linden library includes
 #include "llerror.h"
+#include "llpacketcapture.h"
 #include "lltimer.h"
 #include "llproxy.h"
 #include "llrand.h"
@@ -59,7 +60,15 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	mCapture(NULL),
+	mReplay(NULL),
+	mReplayRecord(NULL),
+	mReplayRealtime(false),
+	mReplayPending(false),
+	mReplayClock(packet_capture_clock),
+	mReplayStartTime(0),
+	mReplayedPackets(0)
 {
 }
 
@@ -67,6 +76,8 @@ LLPacketRing::LLPacketRing () :
 LLPacketRing::~LLPacketRing ()
 {
 	cleanup();
+	stopCapture();
+	stopReplay();
 }
 	
 ///////////////////////////////////////////////////////////
@@ -162,6 +173,11 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 {
 	S32 packet_size = 0;
 
+	if (mReplay)
+	{
+		return receiveFromReplay(datap);
+	}
+
 	// If using the throttle, simulate a limited size input buffer.
 	if (mUseInThrottle)
 	{
@@ -271,11 +287,106 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 		}
 	}
 
+	if (mCapture && packet_size > 0)
+	{
+		mCapture->record(false, mLastSender, mLastReceivingIF, datap, packet_size);
+	}
+
 	return packet_size;
 }
 
+///////////////////////////////////////////////////////////
+S32 LLPacketRing::receiveFromReplay(char *datap)
+{
+	while (true)
+	{
+		if (!mReplayPending)
+		{
+			if (!mReplay->next(*mReplayRecord))
+			{
+				LL_INFOS("Messaging") << "Packet replay finished after " << mReplayedPackets << " packets" << LL_ENDL;
+				stopReplay();
+				return 0;
+			}
+			if (mReplayRecord->isOutgoing())
+			{
+				continue;
+			}
+			mReplayPending = true;
+		}
+		if (mReplayRealtime && mReplayClock() - mReplayStartTime < mReplayRecord->mTime)
+		{
+			// Not due yet.
+			return 0;
+		}
+		mReplayPending = false;
+		break;
+	}
+
+	memcpy(datap, mReplayRecord->mData, mReplayRecord->mSize);	/*Flawfinder: ignore*/
+	mLastSender = mReplayRecord->mRemoteHost;
+	mLastReceivingIF = mReplayRecord->mReceivingIF;
+	++mReplayedPackets;
+	return mReplayRecord->mSize;
+}
+
+bool LLPacketRing::startCapture(const std::string& filename)
+{
+	stopCapture();
+	mCapture = new LLPacketCaptureWriter;
+	if (!mCapture->open(filename))
+	{
+		stopCapture();
+		return false;
+	}
+	return true;
+}
+
+void LLPacketRing::stopCapture()
+{
+	delete mCapture;
+	mCapture = NULL;
+}
+
+bool LLPacketRing::startReplay(const std::string& filename, bool realtime)
+{
+	stopReplay();
+	mReplay = new LLPacketCaptureReader;
+	if (!mReplay->open(filename))
+	{
+		stopReplay();
+		return false;
+	}
+	mReplayRecord = new LLPacketCaptureRecord;
+	mReplayRealtime = realtime;
+	mReplayPending = false;
+	mReplayStartTime = mReplayClock();
+	mReplayedPackets = 0;
+	LL_INFOS("Messaging") << "Replaying packets from " << filename << (realtime ? " at recorded speed" : "") << LL_ENDL;
+	return true;
+}
+
+void LLPacketRing::stopReplay()
+{
+	delete mReplay;
+	mReplay = NULL;
+	delete mReplayRecord;
+	mReplayRecord = NULL;
+	mReplayPending = false;
+}
+
 BOOL LLPacketRing::sendPacket(int h_socket, char * send_buffer, S32 buf_size, LLHost host)
 {	
+	if (mReplay)
+	{
+		// There is no one to talk to.
+		return TRUE;
+	}
+	if (mCapture)
+	{
+		mCapture->record(true, host, LLHost(), send_buffer, buf_size);
+	}
+
 	//<edit>
 	LLMessageLog::log(LLHost(16777343, gMessageSystem->getListenPort()), host, (U8*)send_buffer, buf_size);
 	//</edit>
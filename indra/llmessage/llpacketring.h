@@ -32,6 +32,7 @@
 
 #include "llhost.h"
 #include "llpacketbuffer.h"
+#include "llpacketcapture.h"
 //#include "llproxy.h"
 #include "llthrottle.h"
 #include "net.h"
@@ -60,6 +61,23 @@ public:
 
 	S32 getAndResetActualInBits()				{ S32 bits = mActualBitsIn; mActualBitsIn = 0; return bits;}
 	S32 getAndResetActualOutBits()				{ S32 bits = mActualBitsOut; mActualBitsOut = 0; return bits;}
+
+	// Records every packet sent and received to filename, see llpacketcapture.h.
+	bool startCapture(const std::string& filename);
+	void stopCapture();
+	bool isCapturing() const					{ return mCapture != NULL; }
+
+	// Makes receivePacket() return the incoming packets of a capture instead
+	// of reading the socket, either at the pace they were recorded at or as
+	// fast as they are asked for. Nothing is sent while replaying. Replay
+	// stops by itself at the end of the capture.
+	bool startReplay(const std::string& filename, bool realtime);
+	void stopReplay();
+	bool isReplaying() const					{ return mReplay != NULL; }
+	// Clock a replay at recorded speed is paced by, set before startReplay().
+	void setReplayClock(LLPacketCaptureClock clock)	{ mReplayClock = clock; }
+	U32 getReplayedPacketCount() const			{ return mReplayedPackets; }
+
 protected:
 	BOOL mUseInThrottle;
 	BOOL mUseOutThrottle;
@@ -83,7 +101,17 @@ protected:
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
 
+	LLPacketCaptureWriter* mCapture;
+	LLPacketCaptureReader* mReplay;
+	LLPacketCaptureRecord* mReplayRecord;
+	bool mReplayRealtime;
+	bool mReplayPending;		// mReplayRecord was read but is not due yet
+	LLPacketCaptureClock mReplayClock;
+	U64 mReplayStartTime;
+	U32 mReplayedPackets;
+
 private:
+	S32 receiveFromReplay(char* datap);
 	BOOL sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
 };
 
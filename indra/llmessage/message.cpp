@@ -563,6 +563,13 @@ BOOL LLMessageSystem::checkMessages( S64 frame_count )
 		receive_size = mTrueReceiveSize;
 		mLastSender = mPacketRing->getLastSender();
 		mLastReceivingIF = mPacketRing->getLastReceivingInterface();
+
+		if (receive_size > 0 && mPacketRing->isReplaying() && !mCircuitInfo.findCircuit(mLastSender))
+		{
+			// The handshakes that set up the circuits of a replayed session
+			// happened before the capture started, or are not answered.
+			enableCircuit(mLastSender, TRUE);
+		}
 		
 		if (receive_size < (S32) LL_MINIMUM_VALID_PACKET_SIZE)
 		{
@@ -2419,6 +2426,8 @@ void process_deny_trusted_circuit(LLMessageSystem *msg, void **)
 
 void dump_prehash_files()
 {
+	std::vector<const char*> names;
+	LLMessageStringTable::getInstance()->getStrings(names);
 	U32 i;
 	std::string filename("../../indra/llmessage/message_prehash.h");
 	LLFILE* fp = LLFile::fopen(filename, "w");	/* Flawfinder: ignore */
@@ -2441,11 +2450,11 @@ void dump_prehash_files()
 			" */\n",
 			gMessageSystem->mMessageFileVersionNumber);
 		fprintf(fp, "\n\nextern F32 const gPrehashVersionNumber;\n\n");
-		for (i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
+		for (i = 0; i < names.size(); i++)
 		{
-			if (!LLMessageStringTable::getInstance()->mEmpty[i] && LLMessageStringTable::getInstance()->mString[i][0] != '.')
+			if (names[i][0] != '.')
 			{
-				fprintf(fp, "extern char const* const _PREHASH_%s;\n", LLMessageStringTable::getInstance()->mString[i]);
+				fprintf(fp, "extern char const* const _PREHASH_%s;\n", names[i]);
 			}
 		}
 		fprintf(fp, "\n\n#endif\n");
@@ -2471,11 +2480,11 @@ void dump_prehash_files()
 		fprintf(fp, "#include \"linden_common.h\"\n");
 		fprintf(fp, "#include \"message.h\"\n\n");
 		fprintf(fp, "\n\nF32 const gPrehashVersionNumber = %.3ff;\n\n", gMessageSystem->mMessageFileVersionNumber);
-		for (i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
+		for (i = 0; i < names.size(); i++)
 		{
-			if (!LLMessageStringTable::getInstance()->mEmpty[i] && LLMessageStringTable::getInstance()->mString[i][0] != '.')
+			if (names[i][0] != '.')
 			{
-				fprintf(fp, "char const* const _PREHASH_%s = LLMessageStringTable::getInstance()->getString(\"%s\");\n", LLMessageStringTable::getInstance()->mString[i], LLMessageStringTable::getInstance()->mString[i]);
+				fprintf(fp, "char const* const _PREHASH_%s = LLMessageStringTable::getInstance()->getString(\"%s\");\n", names[i], names[i]);
 			}
 		}
 		fclose(fp);
@@ -3374,6 +3383,43 @@ void LLMessageSystem::establishBidirectionalTrust(const LLHost &host, S64 frame_
 }
 
 
+S32 LLMessageSystem::replayPacketCapture(const std::string& filename, F64& seconds)
+{
+	seconds = 0.0;
+	// Nothing is sent while replaying, so open circuits would time out, and
+	// the replayed packets would go through their state.
+	if (!mCircuitInfo.getCircuitDataList().empty())
+	{
+		LL_WARNS("Messaging") << "Not replaying " << filename << " with circuits open" << LL_ENDL;
+		return -1;
+	}
+	if (!mPacketRing->startReplay(filename, false))
+	{
+		return -1;
+	}
+	LLTimer timer;
+	S64 frame_count = 0;
+	while (mPacketRing->isReplaying())
+	{
+		while (checkMessages(frame_count))
+		{
+			// Handlers were called by checkMessages().
+		}
+		processAcks();
+		++frame_count;
+	}
+	seconds = timer.getElapsedTimeF64();
+	// Forget the circuits of the captured hosts again.
+	std::vector<LLCircuitData*> circuits = mCircuitInfo.getCircuitDataList();
+	for (std::vector<LLCircuitData*>::iterator iter = circuits.begin(); iter != circuits.end(); ++iter)
+	{
+		mCircuitInfo.removeCircuitData((*iter)->getHost());
+	}
+	S32 packets = (S32)mPacketRing->getReplayedPacketCount();
+	LL_INFOS("Messaging") << "Replayed " << packets << " packets from " << filename << " in " << seconds << " seconds" << LL_ENDL;
+	return packets;
+}
+
 void LLMessageSystem::dumpPacketToLog()
 {
 	LL_WARNS("Messaging") << "Packet Dump from:" << mPacketRing->getLastSender() << LL_ENDL;
@@ -67,11 +67,11 @@ namespace
 	class LLFnPtrResponder;
 }
 
-const U32 MESSAGE_MAX_STRINGS_LENGTH = 64;
 const U32 MESSAGE_NUMBER_OF_HASH_BUCKETS = 8192;
 
 const S32 MESSAGE_MAX_PER_FRAME = 400;
 
+// Interned message, block and variable names. Thread-safe.
 class LLMessageStringTable : public LLSingleton<LLMessageStringTable>
 {
 public:
@@ -80,9 +80,11 @@ public:
 
 	char *getString(const char *str);
 
-	U32	 mUsed;
-	BOOL mEmpty[MESSAGE_NUMBER_OF_HASH_BUCKETS];
-	char mString[MESSAGE_NUMBER_OF_HASH_BUCKETS][MESSAGE_MAX_STRINGS_LENGTH];	/* Flawfinder: ignore */
+	// Every name interned so far, sorted.
+	void getStrings(std::vector<const char*>& strings) const;
+
+private:
+	LLStringTable mTable;
 };
 
 
@@ -343,6 +345,15 @@ public:
 	BOOL	checkMessages(S64 frame_count = 0);
 	void	processAcks(F32 collect_time = 0.f);
 
+	// Feeds the incoming packets of a capture made with
+	// LLPacketRing::startCapture() through checkMessages() and the registered
+	// handlers as fast as they are decoded, without a network. Only runs
+	// while no circuit is open, and removes the circuits of the replayed
+	// hosts again. Returns the number of packets replayed and their
+	// processing time in seconds, or -1 if filename is not a capture or a
+	// circuit is open.
+	S32		replayPacketCapture(const std::string& filename, F64& seconds);
+
 	BOOL	isMessageFast(const char *msg);
 	BOOL	isMessage(const char *msg)
 	{
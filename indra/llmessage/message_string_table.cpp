@@ -29,27 +29,17 @@
 #include "llerror.h"
 #include "message.h"
 
-inline U32	message_hash_my_string(const char *str)
+#include <algorithm>
+
+static bool string_less(const char* a, const char* b)
 {
-	U32 retval = 0;
-	while (*str++)
-	{
-		retval += *str;
-		retval <<= 1;
-	}
-	return (retval % MESSAGE_NUMBER_OF_HASH_BUCKETS);
+	return strcmp(a, b) < 0;
 }
 
 
-
 LLMessageStringTable::LLMessageStringTable()
-:	mUsed(0)
+:	mTable(MESSAGE_NUMBER_OF_HASH_BUCKETS)
 {
-	for (U32 i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
-	{
-		mEmpty[i] = TRUE;
-		mString[i][0] = 0;
-	}
 }
 
 
@@ -59,33 +49,15 @@ LLMessageStringTable::~LLMessageStringTable()
 
 char* LLMessageStringTable::getString(const char *str)
 {
-	U32 hash_value = message_hash_my_string(str);
-	while (!mEmpty[hash_value])
-	{
-		if (!strncmp(str, mString[hash_value], MESSAGE_MAX_STRINGS_LENGTH))
-		{
-			return mString[hash_value];
-		}
-		else
-		{
-			hash_value++;
-			hash_value %= MESSAGE_NUMBER_OF_HASH_BUCKETS;
-		}
-	}
-	// not found, so add!
-	strncpy(mString[hash_value], str, MESSAGE_MAX_STRINGS_LENGTH);	/* Flawfinder: ignore */
-	mString[hash_value][MESSAGE_MAX_STRINGS_LENGTH - 1] = 0;
-	mEmpty[hash_value] = FALSE;
-	mUsed++;
-	if (mUsed >= MESSAGE_NUMBER_OF_HASH_BUCKETS - 1)
-	{
-		U32 i;
-		LL_INFOS() << "Dumping string table before crashing on HashTable full!" << LL_ENDL;
-		for (i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
-		{
-			LL_INFOS() << "Entry #" << i << ": " << mString[i] << LL_ENDL;
-		}
-	}
-	return mString[hash_value];
+	// Names are looked up far more often than they are added; checkString()
+	// only shares the lock and leaves the reference count alone.
+	char* ret = mTable.checkString(str);
+	return ret ? ret : mTable.addString(str);
 }
 
+
+void LLMessageStringTable::getStrings(std::vector<const char*>& strings) const
+{
+	mTable.getStrings(strings);
+	std::sort(strings.begin(), strings.end(), string_less);
+}
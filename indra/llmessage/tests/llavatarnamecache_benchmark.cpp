@@ -0,0 +1,118 @@
+/**
+ * @file llavatarnamecache_benchmark.cpp
+ * @brief Loading a well filled avatar name cache, XML against binary.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llavatarnamecache.h"
+
+#include <iostream>
+#include <sstream>
+
+#include "llframetimer.h"
+#include "llsd.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	LLUUID test_id(S32 i)
+	{
+		LLUUID id;
+		memcpy(id.mData, &i, sizeof(i));
+		id.mData[UUID_BYTES - 1] = 0x5a;
+		return id;
+	}
+
+	// Fills the cache with count names that expire an hour from now.
+	void fill_cache(S32 count)
+	{
+		LLDate expires(LLFrameTimer::getTotalSeconds() + 3600.0);
+		for (S32 i = 0; i < count; ++i)
+		{
+			LLSD sd;
+			sd["username"] = llformat("resident%d.linden", i);
+			sd["display_name"] = llformat("R\xc3\xa9sident %d", i);
+			sd["legacy_first_name"] = llformat("Resident%d", i);
+			sd["legacy_last_name"] = "Linden";
+			sd["is_display_name_default"] = (i % 2 == 0);
+			sd["display_name_expires"] = expires;
+			sd["display_name_next_update"] = expires;
+			LLAvatarName av_name;
+			av_name.fromLLSD(sd);
+			LLAvatarNameCache::insert(test_id(i), av_name);
+		}
+	}
+}
+
+namespace tut
+{
+	struct avatarnamecache_benchmark_data
+	{
+		avatarnamecache_benchmark_data()
+		:	mFilename(std::string(LLFile::tmpdir()) + "llavatarnamecache_benchmark.bin")
+		{
+			LLAvatarNameCache::initClass(true, true);
+			LLAvatarNameCache::setNameLookupURL("http://localhost/agents/");
+		}
+		~avatarnamecache_benchmark_data()
+		{
+			LLAvatarNameCache::cleanupClass();
+			LLFile::remove(mFilename);
+		}
+		std::string mFilename;
+	};
+	typedef test_group<avatarnamecache_benchmark_data> avatarnamecache_benchmark;
+	typedef avatarnamecache_benchmark::object avatarnamecache_benchmark_object;
+	tut::avatarnamecache_benchmark avatarnamecache_benchmark_testcase("LLAvatarNameCache_benchmark");
+
+	template<> template<>
+	void avatarnamecache_benchmark_object::test<1>()
+	{
+		// Startup cost of loading a well filled cache, XML against binary.
+		const S32 count = 20000;
+		fill_cache(count);
+		std::ostringstream xml;
+		LLAvatarNameCache::exportFile(xml);
+		ensure("exported", LLAvatarNameCache::exportBinaryFile(mFilename));
+		LLAvatarNameCache::cleanupClass();
+
+		LLTimer timer;
+		std::istringstream istr(xml.str());
+		ensure("xml", LLAvatarNameCache::importFile(istr));
+		F64 xml_ms = timer.getElapsedTimeF64() * 1000.0;
+		LLAvatarNameCache::cleanupClass();
+
+		timer.reset();
+		ensure("binary", LLAvatarNameCache::importBinaryFile(mFilename));
+		F64 binary_ms = timer.getElapsedTimeF64() * 1000.0;
+		LLAvatarName av_name;
+		ensure("last", LLAvatarNameCache::get(test_id(count - 1), &av_name));
+
+		std::cout << "\nLoading " << count << " avatar names: " << xml_ms << " ms from XML ("
+				  << xml.str().size() / 1024 << " KB), " << binary_ms << " ms binary" << std::endl;
+	}
+}
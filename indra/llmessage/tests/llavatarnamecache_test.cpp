@@ -29,12 +29,61 @@
 
 #include "../llavatarnamecache.h"
 
+#include <sstream>
+
+#include "llframetimer.h"
+#include "llsd.h"
+
 #include "../test/lltut.h"
 
+namespace
+{
+	LLUUID test_id(S32 i)
+	{
+		LLUUID id;
+		memcpy(id.mData, &i, sizeof(i));
+		id.mData[UUID_BYTES - 1] = 0x5a;
+		return id;
+	}
+
+	// Fills the cache with count names that expire an hour from now.
+	void fill_cache(S32 count)
+	{
+		LLDate expires(LLFrameTimer::getTotalSeconds() + 3600.0);
+		for (S32 i = 0; i < count; ++i)
+		{
+			LLSD sd;
+			sd["username"] = llformat("resident%d.linden", i);
+			sd["display_name"] = llformat("R\xc3\xa9sident %d", i);
+			sd["legacy_first_name"] = llformat("Resident%d", i);
+			sd["legacy_last_name"] = "Linden";
+			sd["is_display_name_default"] = (i % 2 == 0);
+			sd["display_name_expires"] = expires;
+			sd["display_name_next_update"] = expires;
+			LLAvatarName av_name;
+			av_name.fromLLSD(sd);
+			LLAvatarNameCache::insert(test_id(i), av_name);
+		}
+	}
+}
+
 namespace tut
 {
 	struct avatarnamecache_data
 	{
+		avatarnamecache_data()
+		:	mFilename(std::string(LLFile::tmpdir()) + "llavatarnamecache_test.bin")
+		{
+			// With a lookup URL, misses are only queued.
+			LLAvatarNameCache::initClass(true, true);
+			LLAvatarNameCache::setNameLookupURL("http://localhost/agents/");
+		}
+		~avatarnamecache_data()
+		{
+			LLAvatarNameCache::cleanupClass();
+			LLFile::remove(mFilename);
+		}
+		std::string mFilename;
 	};
 	typedef test_group<avatarnamecache_data> avatarnamecache_test;
 	typedef avatarnamecache_test::object avatarnamecache_object;
@@ -99,4 +148,88 @@ namespace tut
 		valid = max_age_from_cache_control("max-age=-123", &max_age);
 		ensure("less than zero max-age is invalid", !valid);
 	}
+
+	template<> template<>
+	void avatarnamecache_object::test<3>()
+	{
+		// Binary cache round trip.
+		const S32 count = 500;
+		fill_cache(count);
+		LLAvatarName expected;
+		ensure("filled", LLAvatarNameCache::get(test_id(7), &expected));
+		ensure("exported", LLAvatarNameCache::exportBinaryFile(mFilename));
+		LLAvatarNameCache::cleanupClass();
+
+		ensure("imported", LLAvatarNameCache::importBinaryFile(mFilename));
+		for (S32 i = 0; i < count; ++i)
+		{
+			LLAvatarName av_name;
+			ensure("present", LLAvatarNameCache::get(test_id(i), &av_name));
+			ensure_equals("user name", av_name.getAccountName(), llformat("resident%d.linden", i));
+			ensure_equals("default", av_name.isDisplayNameDefault(), i % 2 == 0);
+		}
+		LLAvatarName av_name;
+		LLAvatarNameCache::get(test_id(7), &av_name);
+		LLSD sd = av_name.asLLSD();
+		LLSD expected_sd = expected.asLLSD();
+		ensure_equals("display name", sd["display_name"].asString(), expected_sd["display_name"].asString());
+		ensure_equals("legacy first name", sd["legacy_first_name"].asString(), expected_sd["legacy_first_name"].asString());
+		ensure_equals("legacy last name", sd["legacy_last_name"].asString(), expected_sd["legacy_last_name"].asString());
+		ensure_equals("expires", av_name.mExpires, expected.mExpires);
+		ensure_equals("next update", av_name.mNextUpdate, expected.mNextUpdate);
+		ensure("hit ratio", LLAvatarNameCache::getHitRatio() > 0.f);
+
+		// A file cut short is refused and leaves the cache alone.
+		std::string data;
+		{
+			llifstream file(mFilename, std::ios::in | std::ios::binary);
+			std::ostringstream ostr;
+			ostr << file.rdbuf();
+			data = ostr.str();
+		}
+		{
+			llofstream file(mFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+			file.write(data.data(), data.size() - 10);
+		}
+		LLAvatarNameCache::cleanupClass();
+		ensure("truncated", !LLAvatarNameCache::importBinaryFile(mFilename));
+		ensure("untouched", !LLAvatarNameCache::get(test_id(0), &av_name));
+		ensure("missing", !LLAvatarNameCache::importBinaryFile(mFilename + ".missing"));
+	}
+
+	template<> template<>
+	void avatarnamecache_object::test<4>()
+	{
+		// Headers claiming more than the file holds are refused before
+		// anything is allocated for them.
+		fill_cache(10);
+		ensure("exported", LLAvatarNameCache::exportBinaryFile(mFilename));
+		LLAvatarNameCache::cleanupClass();
+		std::string data;
+		{
+			llifstream file(mFilename, std::ios::in | std::ios::binary);
+			std::ostringstream ostr;
+			ostr << file.rdbuf();
+			data = ostr.str();
+		}
+		U32 header[4];
+		memcpy(header, data.data(), sizeof(header));
+		ensure_equals("count", header[2], (U32)10);
+
+		// Entries size, then entry count, far beyond the file.
+		const U32 bad_sizes[][2] = { { 10, 0xffffff00 }, { 10, header[3] + 1 }, { 10, header[3] - 1 },
+											{ 0x7fffffff, header[3] }, { header[3], header[3] } };
+		for (U32 i = 0; i < LL_ARRAY_SIZE(bad_sizes); ++i)
+		{
+			U32 bad_header[4] = { header[0], header[1], bad_sizes[i][0], bad_sizes[i][1] };
+			{
+				llofstream file(mFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+				file.write((const char*)bad_header, sizeof(bad_header));
+				file.write(data.data() + sizeof(header), data.size() - sizeof(header));
+			}
+			ensure(llformat("refused %d", i), !LLAvatarNameCache::importBinaryFile(mFilename));
+		}
+		LLAvatarName av_name;
+		ensure("untouched", !LLAvatarNameCache::get(test_id(0), &av_name));
+	}
 }
@@ -0,0 +1,109 @@
+/**
+ * @file llpacketcapture_benchmark.cpp
+ * @brief Capture and replay cost per packet of packet capture files.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include <iostream>
+
+#include "../llpacketcapture.h"
+#include "../llpacketring.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	// Packet i is i % 200 + 10 bytes of (i + offset) & 0xff.
+	void fill_packet(char* data, S32 i, S32& size)
+	{
+		size = i % 200 + 10;
+		for (S32 j = 0; j < size; ++j)
+		{
+			data[j] = (char)((i + j) & 0xff);
+		}
+	}
+
+	// Writes count packets, every third one outgoing, from two hosts.
+	void write_capture(const std::string& filename, S32 count)
+	{
+		LLPacketCaptureWriter writer;
+		tut::ensure("open for writing", writer.open(filename));
+		char data[NET_BUFFER_SIZE];
+		for (S32 i = 0; i < count; ++i)
+		{
+			S32 size;
+			fill_packet(data, i, size);
+			LLHost remote(0x0100007f + (i & 1), 13000 + (i & 1));
+			writer.record(i % 3 == 0, remote, LLHost(0x0200000a, 0), data, size);
+		}
+		tut::ensure_equals("packet count", writer.getPacketCount(), (U32)count);
+	}
+}
+
+namespace tut
+{
+	struct packetcapture_benchmark_data
+	{
+		packetcapture_benchmark_data()
+		:	mFilename(std::string(LLFile::tmpdir()) + "llpacketcapture_benchmark.capture")
+		{
+		}
+		~packetcapture_benchmark_data()
+		{
+			LLFile::remove(mFilename);
+		}
+		std::string mFilename;
+	};
+	typedef test_group<packetcapture_benchmark_data> packetcapture_benchmark;
+	typedef packetcapture_benchmark::object packetcapture_benchmark_object;
+	tut::packetcapture_benchmark packetcapture_benchmark_group("LLPacketCapture_benchmark");
+
+	template<> template<>
+	void packetcapture_benchmark_object::test<1>()
+	{
+		// Capture and replay cost per packet, the floor under the decode
+		// time LLMessageSystem::replayPacketCapture() reports.
+		const S32 count = 200000;
+		LLTimer timer;
+		write_capture(mFilename, count);
+		F64 write_seconds = timer.getElapsedTimeF64();
+
+		LLPacketRing ring;
+		ensure("replay", ring.startReplay(mFilename, false));
+		char data[NET_BUFFER_SIZE];
+		timer.reset();
+		S32 bytes = 0;
+		S32 size;
+		while ((size = ring.receivePacket(-1, data)) > 0)
+		{
+			bytes += size;
+		}
+		F64 read_seconds = timer.getElapsedTimeF64();
+		ensure_equals("replayed", ring.getReplayedPacketCount(), (U32)(count - (count + 2) / 3));
+		std::cout << "\nPacket capture of " << count << " packets: write " << write_seconds * 1000.0
+				  << " ms, replay " << read_seconds * 1000.0 << " ms (" << bytes / 1024 << " KB)" << std::endl;
+	}
+}
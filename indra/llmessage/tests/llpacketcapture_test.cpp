@@ -0,0 +1,260 @@
+/**
+ * @file llpacketcapture_test.cpp
+ * @brief Tests of packet capture files and their replay through LLPacketRing
+ * and LLMessageSystem.
+ *
+ * $LicenseInfo:firstyear=2001&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketcapture.h"
+#include "../llpacketring.h"
+#include "../message.h"
+#include "../message_prehash.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	// Packet i is i % 200 + 10 bytes of (i + offset) & 0xff.
+	void fill_packet(char* data, S32 i, S32& size)
+	{
+		size = i % 200 + 10;
+		for (S32 j = 0; j < size; ++j)
+		{
+			data[j] = (char)((i + j) & 0xff);
+		}
+	}
+
+	// Writes count packets, every third one outgoing, from two hosts.
+	void write_capture(const std::string& filename, S32 count)
+	{
+		LLPacketCaptureWriter writer;
+		tut::ensure("open for writing", writer.open(filename));
+		char data[NET_BUFFER_SIZE];
+		for (S32 i = 0; i < count; ++i)
+		{
+			S32 size;
+			fill_packet(data, i, size);
+			LLHost remote(0x0100007f + (i & 1), 13000 + (i & 1));
+			writer.record(i % 3 == 0, remote, LLHost(0x0200000a, 0), data, size);
+		}
+		tut::ensure_equals("packet count", writer.getPacketCount(), (U32)count);
+	}
+
+	// The Test1 values of the TestMessages handled, in order.
+	std::vector<U32> sTestValues;
+
+	void handle_test_message(LLMessageSystem* msg, void**)
+	{
+		U32 value;
+		msg->getU32Fast(_PREHASH_TestBlock1, _PREHASH_Test1, value);
+		sTestValues.push_back(value);
+	}
+
+	// Microseconds, moved by hand.
+	U64 sClockTime = 0;
+
+	U64 test_clock()
+	{
+		return sClockTime;
+	}
+}
+
+namespace tut
+{
+	struct packetcapture_data
+	{
+		packetcapture_data()
+		:	mFilename(std::string(LLFile::tmpdir()) + "llpacketcapture_test.capture")
+		{
+		}
+		~packetcapture_data()
+		{
+			LLFile::remove(mFilename);
+		}
+		std::string mFilename;
+	};
+	typedef test_group<packetcapture_data> packetcapture_test;
+	typedef packetcapture_test::object packetcapture_object;
+	tut::packetcapture_test packetcapture("LLPacketCapture");
+
+	template<> template<>
+	void packetcapture_object::test<1>()
+	{
+		// Round trip through the file, including a record cut short.
+		const S32 count = 1000;
+		write_capture(mFilename, count);
+		{
+			LLFILE* file = LLFile::fopen(mFilename, "ab");
+			fwrite("\x01\x00\x00\x00\x00", 1, 5, file);
+			LLFile::close(file);
+		}
+
+		LLPacketCaptureReader reader;
+		ensure("open for reading", reader.open(mFilename));
+		ensure("start time", reader.getStartTime() > 0);
+		LLPacketCaptureRecord record;
+		char expected[NET_BUFFER_SIZE];
+		U64 last_time = 0;
+		S32 i = 0;
+		for (; reader.next(record); ++i)
+		{
+			S32 size;
+			fill_packet(expected, i, size);
+			ensure_equals("size", record.mSize, size);
+			ensure("data", !memcmp(record.mData, expected, size));
+			ensure_equals("direction", record.isOutgoing(), i % 3 == 0);
+			ensure_equals("remote address", record.mRemoteHost.getAddress(), (U32)(0x0100007f + (i & 1)));
+			ensure_equals("remote port", record.mRemoteHost.getPort(), (U32)(13000 + (i & 1)));
+			ensure_equals("receiving interface", record.mReceivingIF.getAddress(), (U32)0x0200000a);
+			ensure("time", record.mTime >= last_time);
+			last_time = record.mTime;
+		}
+		ensure_equals("records", i, count);
+
+		LLPacketCaptureReader other;
+		LLFILE* file = LLFile::fopen(mFilename, "wb");
+		fwrite("not a capture file", 1, 18, file);
+		LLFile::close(file);
+		ensure("not a capture", !other.open(mFilename));
+	}
+
+	template<> template<>
+	void packetcapture_object::test<2>()
+	{
+		// The ring hands out the incoming packets in order and stops at the end.
+		const S32 count = 300;
+		write_capture(mFilename, count);
+
+		LLPacketRing ring;
+		ensure("replay", ring.startReplay(mFilename, false));
+		char data[NET_BUFFER_SIZE];
+		char expected[NET_BUFFER_SIZE];
+		for (S32 i = 0; i < count; ++i)
+		{
+			if (i % 3 == 0)
+			{
+				continue;
+			}
+			S32 size;
+			fill_packet(expected, i, size);
+			ensure_equals("size", ring.receivePacket(-1, data), size);
+			ensure("data", !memcmp(data, expected, size));
+			ensure_equals("sender", ring.getLastSender().getPort(), (U32)(13000 + (i & 1)));
+		}
+		ensure("still replaying", ring.isReplaying());
+		ensure_equals("end", ring.receivePacket(-1, data), 0);
+		ensure("stopped", !ring.isReplaying());
+		ensure_equals("replayed", ring.getReplayedPacketCount(), (U32)(count - count / 3));
+	}
+
+	template<> template<>
+	void packetcapture_object::test<3>()
+	{
+		// At recorded speed, packets are held back until they are due.
+		sClockTime = 1000000;
+		{
+			LLPacketCaptureWriter writer;
+			writer.setClock(test_clock);
+			ensure("open for writing", writer.open(mFilename));
+			char data[16] = { 0 };
+			writer.record(false, LLHost(0x0100007f, 13000), LLHost(), data, sizeof(data));
+			sClockTime += 200000;
+			writer.record(false, LLHost(0x0100007f, 13000), LLHost(), data, sizeof(data));
+		}
+		sClockTime = 5000000;
+		LLPacketRing ring;
+		ring.setReplayClock(test_clock);
+		ensure("replay", ring.startReplay(mFilename, true));
+		char data[NET_BUFFER_SIZE];
+		ensure_equals("first", ring.receivePacket(-1, data), 16);
+		ensure_equals("second is not due", ring.receivePacket(-1, data), 0);
+		sClockTime += 199999;
+		ensure_equals("second is still not due", ring.receivePacket(-1, data), 0);
+		ensure("waiting", ring.isReplaying());
+		sClockTime += 1;
+		ensure_equals("second", ring.receivePacket(-1, data), 16);
+		ensure_equals("end", ring.receivePacket(-1, data), 0);
+		ensure("stopped", !ring.isReplaying());
+	}
+
+	template<> template<>
+	void packetcapture_object::test<4>()
+	{
+		// A replay goes through checkMessages() into the registered handler,
+		// without the outgoing packets, and leaves no circuits behind. It is
+		// refused while a circuit is open.
+		std::string template_file(std::string(LLFile::tmpdir()) + "llpacketcapture_test.msg");
+		{
+			llofstream file(template_file);
+			file << "version 2.0\n"
+				 << "{\n"
+				 << "	TestMessage Low 1 NotTrusted Unencoded\n"
+				 << "	{\n"
+				 << "		TestBlock1 Single\n"
+				 << "		{	Test1	U32	}\n"
+				 << "	}\n"
+				 << "}\n";
+		}
+		LLMessageSystem* msg = new LLMessageSystem(template_file, 0, 1, 0, 0, false, 5.f, 100.f);
+		LLFile::remove(template_file);
+		LLMessageSystem* prior = gMessageSystem;
+		gMessageSystem = msg;
+		msg->setHandlerFuncFast(_PREHASH_TestMessage, handle_test_message);
+		sTestValues.clear();
+
+		{
+			// Header (flags, packet id, extra header size), low frequency
+			// message number 1 and the U32.
+			LLPacketCaptureWriter writer;
+			ensure("open for writing", writer.open(mFilename));
+			for (U32 i = 0; i < 6; ++i)
+			{
+				U8 data[14] = { 0, 0, 0, 0, (U8)(i + 1), 0, 0xff, 0xff, 0, 1, (U8)(i * 10), 0, 0, 0 };
+				writer.record(i == 3, LLHost(0x0100007f, 13000 + (i & 1)), LLHost(), (char*)data, sizeof(data));
+			}
+		}
+		F64 seconds;
+		LLHost open_host(0x0100007f, 14000);
+		msg->mCircuitInfo.addCircuitData(open_host, 0);
+		S32 refused = msg->replayPacketCapture(mFilename, seconds);
+		msg->mCircuitInfo.removeCircuitData(open_host);
+		S32 packets = msg->replayPacketCapture(mFilename, seconds);
+		bool no_circuits = msg->mCircuitInfo.getCircuitDataList().empty();
+
+		// The circuits use gMessageSystem on the way out.
+		delete msg;
+		gMessageSystem = prior;
+
+		ensure_equals("refused with a circuit open", refused, -1);
+		ensure("circuits removed", no_circuits);
+		ensure_equals("replayed", packets, 5);
+		ensure_equals("handled", sTestValues.size(), (size_t)5);
+		const U32 expected[] = { 0, 10, 20, 40, 50 };
+		for (S32 i = 0; i < 5; ++i)
+		{
+			ensure_equals("value", sTestValues[i], expected[i]);
+		}
+	}
+}
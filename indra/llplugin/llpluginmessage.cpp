@@ -371,6 +371,20 @@ std::string LLPluginMessage::generate(void) const
 	return result.str();
 }
 
+/**
+ * Generates binary LLSD from the message, which is a lot cheaper to generate and parse than XML.
+ *
+ * @return Binary serialized message.
+ */
+std::string LLPluginMessage::generateBinary(void) const
+{
+	std::ostringstream result;
+
+	LLSDSerialize::toBinary(mMessage, result);
+
+	return result.str();
+}
+
 /**
  *	Parse an incoming message into component parts. Clears all existing state before starting the parse.
  *
@@ -383,7 +397,15 @@ int LLPluginMessage::parse(const std::string &message)
 
 	std::istringstream input(message);
 	
-	S32 parse_result = LLSDSerialize::fromXML(mMessage, input);
+	S32 parse_result;
+	if (isBinary(message))
+	{
+		parse_result = LLSDSerialize::fromBinary(mMessage, input, (S32)message.size());
+	}
+	else
+	{
+		parse_result = LLSDSerialize::fromXML(mMessage, input);
+	}
 	
 	return (int)parse_result;
 }
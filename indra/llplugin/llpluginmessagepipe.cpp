@@ -32,12 +32,23 @@
 #include "llbufferstream.h"
 
 #include "llapr.h"
+#define APR_WANT_IOVEC		// struct iovec, for apr_socket_sendv.
+#include "apr_want.h"
 
 static const char MESSAGE_DELIMITER = '\0';
 
+// A framed message is FRAME_MARKER, followed by the length of the message as 32-bit big endian, followed by the message.
+// Null delimited messages are XML and therefore never start with FRAME_MARKER.
+static const char FRAME_MARKER = '\1';
+static const size_t FRAME_HEADER_SIZE = 5;
+
+// Maximum number of pieces of mOutput passed to a single apr_socket_sendv.
+static const int MAX_SEND_PIECES = 64;
+
 LLPluginMessagePipeOwner::LLPluginMessagePipeOwner() :
 	mMessagePipe(NULL),
-	mSocketError(APR_SUCCESS)
+	mSocketError(APR_SUCCESS),
+	mBinaryMessages(false)
 {
 }
 
@@ -71,11 +82,11 @@ bool LLPluginMessagePipeOwner::writeMessageRaw(const std::string &message)
 	bool result = true;
 	if(mMessagePipe != NULL)
 	{
-		result = mMessagePipe->addMessage(message);
+		result = mMessagePipe->addMessage(message, mBinaryMessages);
 	}
 	else
 	{
-		LL_WARNS("Plugin") << "dropping message: " << message << LL_ENDL;
+		LL_WARNS("Plugin") << "dropping message: " << (LLPluginMessage::isBinary(message) ? "(binary)" : message) << LL_ENDL;
 		result = false;
 	}
 	
@@ -102,6 +113,8 @@ void LLPluginMessagePipeOwner::killMessagePipe(void)
 }
 
 LLPluginMessagePipe::LLPluginMessagePipe(LLPluginMessagePipeOwner *owner, LLSocket::ptr_t socket):
+	mInputOffset(0),
+	mOutputOffset(0),
 	mOwner(owner),
 	mSocket(socket)
 {
@@ -117,14 +130,22 @@ LLPluginMessagePipe::~LLPluginMessagePipe()
 	}
 }
 
-bool LLPluginMessagePipe::addMessage(const std::string &message)
+bool LLPluginMessagePipe::addMessage(const std::string &message, bool framed)
 {
 	// queue the message for later output
-	//LLMutexLock lock(&mOutputMutex);
-	mOutputMutex.lock();
-	mOutput += message;
-	mOutput += MESSAGE_DELIMITER;	// message separator
-	mOutputMutex.unlock();
+	LLMutexLock lock(&mOutputMutex);
+	if (framed)
+	{
+		U32 size = (U32)message.size();
+		char header[FRAME_HEADER_SIZE] = { FRAME_MARKER, (char)(size >> 24), (char)(size >> 16), (char)(size >> 8), (char)size };
+		mOutput.push_back(std::string(header, FRAME_HEADER_SIZE));
+		mOutput.push_back(message);
+	}
+	else
+	{
+		mOutput.push_back(message);
+		mOutput.push_back(std::string(1, MESSAGE_DELIMITER));	// message separator
+	}
 	return true;
 }
 
@@ -185,31 +206,37 @@ bool LLPluginMessagePipe::pumpOutput(bool flush)
 		LLMutexLock lock(&mOutputMutex);
 		while(result && !mOutput.empty())
 		{
-			// write any outgoing messages
-			apr_size_t size = (apr_size_t)mOutput.size();
+			// write any outgoing messages, gathering as many queued pieces as possible into one send.
+			struct iovec vec[MAX_SEND_PIECES];
+			int nvec = 0;
+			for (std::deque<std::string>::iterator piece = mOutput.begin(); piece != mOutput.end() && nvec < MAX_SEND_PIECES; ++piece, ++nvec)
+			{
+				size_t offset = nvec ? 0 : mOutputOffset;
+				vec[nvec].iov_base = const_cast<char*>(piece->data() + offset);
+				vec[nvec].iov_len = piece->size() - offset;
+			}
+			apr_size_t size = 0;
 			
 			setSocketTimeout(timeout_usec);
 			
-//			LL_INFOS("Plugin") << "before apr_socket_send, size = " << size << LL_ENDL;
-
-			apr_status_t status = apr_socket_send(
+			apr_status_t status = apr_socket_sendv(
 					mSocket->getSocket(),
-					(const char*)mOutput.data(),
+					vec,
+					nvec,
 					&size);
 
-//			LL_INFOS("Plugin") << "after apr_socket_send, size = " << size << LL_ENDL;
+			// remove the written part from the queue.
+			consumeOutput(size);
 			
 			if(status == APR_SUCCESS)
 			{
-				// success
-				mOutput = mOutput.substr(size);
-				break;
+				// success; try again if there is more, until the socket buffer is full.
+				continue;
 			}
 			else if(APR_STATUS_IS_EAGAIN(status) || APR_STATUS_IS_TIMEUP(status))
 			{
 				// Socket buffer is full... 
-				// remove the written part from the buffer and try again later.
-				mOutput = mOutput.substr(size);
+				// try again later.
 				if (!flush)
 					break;
 				flush_time_left_usec -= timeout_usec;
@@ -383,30 +410,74 @@ bool LLPluginMessagePipe::pumpInput(F64 timeout)
 	return result;	
 }
 
+// Called with mOutputMutex locked.
+void LLPluginMessagePipe::consumeOutput(size_t size)
+{
+	while (size > 0)
+	{
+		size_t left = mOutput.front().size() - mOutputOffset;
+		if (size < left)
+		{
+			mOutputOffset += size;
+			break;
+		}
+		size -= left;
+		mOutput.pop_front();
+		mOutputOffset = 0;
+	}
+}
+
 void LLPluginMessagePipe::processInput(void)
 {
-	// Look for input delimiter(s) in the input buffer.
-	int delim;
+	// Look for complete messages in the input buffer; these are either null delimited or framed.
+	std::string message;
 	mInputMutex.lock();
-	while((delim = mInput.find(MESSAGE_DELIMITER)) != std::string::npos)
-	{	
+	while(mInputOffset < mInput.size())
+	{
+		if (mInput[mInputOffset] == FRAME_MARKER)
+		{
+			if (mInput.size() - mInputOffset < FRAME_HEADER_SIZE)
+			{
+				break;
+			}
+			unsigned char const* header = (unsigned char const*)mInput.data() + mInputOffset;
+			size_t size = ((size_t)header[1] << 24) | ((size_t)header[2] << 16) | ((size_t)header[3] << 8) | (size_t)header[4];
+			if (mInput.size() - mInputOffset - FRAME_HEADER_SIZE < size)
+			{
+				break;
+			}
+			message.assign(mInput, mInputOffset + FRAME_HEADER_SIZE, size);
+			mInputOffset += FRAME_HEADER_SIZE + size;
+		}
+		else
+		{
+			size_t delim = mInput.find(MESSAGE_DELIMITER, mInputOffset);
+			if (delim == std::string::npos)
+			{
+				break;
+			}
+			message.assign(mInput, mInputOffset, delim - mInputOffset);
+			mInputOffset = delim + 1;
+		}
+
 		// Let the owner process this message
 		if (mOwner)
 		{
-			// Pull the message out of the input buffer before calling receiveMessageRaw.
+			// The message was pulled out of the input buffer before calling receiveMessageRaw.
 			// It's now possible for this function to get called recursively (in the case where the plugin makes a blocking request)
 			// and this guarantees that the messages will get dequeued correctly.
-			std::string message(mInput, 0, delim);
-			mInput.erase(0, delim + 1);
 			mInputMutex.unlock();
 			mOwner->receiveMessageRaw(message);
 			mInputMutex.lock();
 		}
 		else
 		{
-			LL_WARNS("Plugin") << "!mOwner" << LL_ENDL;
+			LL_WARNS("Plugin") << "!mOwner, dropping message" << LL_ENDL;
 		}
 	}
+	// Remove everything that was processed at once, rather than once per message.
+	mInput.erase(0, mInputOffset);
+	mInputOffset = 0;
 	mInputMutex.unlock();
 }
 
@@ -31,6 +31,8 @@
 
 #include "lliosocket.h"
 #include "llthread.h"
+#include "llpluginmessage.h"
+#include <deque>
 
 class LLPluginMessagePipe;
 
@@ -53,6 +55,11 @@ public:
 protected:
 	// returns false if writeMessageRaw() would drop the message
 	bool canSendMessage(void);
+	// call this once the other side announced that it understands binary messages (its "binary_messages" value)
+	void setBinaryMessages(bool binary_messages) { mBinaryMessages = binary_messages; }
+	bool getBinaryMessages(void) const { return mBinaryMessages; }
+	// serialize message in the encoding negotiated with the other side
+	std::string generateMessage(const LLPluginMessage &message) const { return mBinaryMessages ? message.generateBinary() : message.generate(); }
 	// call this to send a message over the pipe
 	bool writeMessageRaw(const std::string &message);
 	// call this to attempt to flush all messages for 10 seconds long.
@@ -62,6 +69,7 @@ protected:
 	
 	LLPluginMessagePipe *mMessagePipe;
 	apr_status_t mSocketError;
+	bool mBinaryMessages;
 };
 
 class LLPluginMessagePipe
@@ -71,7 +79,10 @@ public:
 	LLPluginMessagePipe(LLPluginMessagePipeOwner *owner, LLSocket::ptr_t socket);
 	virtual ~LLPluginMessagePipe();
 	
-	bool addMessage(const std::string &message);
+	// Queue a message for output. When framed is set the message is sent with a length prefix instead of
+	// a null delimiter; only do that when the other side announced "binary_messages". Incoming messages
+	// may use either framing.
+	bool addMessage(const std::string &message, bool framed = false);
 	void clearOwner(void);
 	
 	bool pump(F64 timeout = 0.0f);
@@ -82,14 +93,17 @@ public:
 		
 protected:	
 	void processInput(void);
+	void consumeOutput(size_t size);
 
 	// used internally by pump()
 	void setSocketTimeout(apr_interval_time_t timeout_usec);
 	
 	LLMutex mInputMutex;
 	std::string mInput;
+	size_t mInputOffset;				// Start of the first unprocessed message in mInput.
 	LLMutex mOutputMutex;
-	std::string mOutput;
+	std::deque<std::string> mOutput;	// Pieces to send: frame headers, messages and delimiters.
+	size_t mOutputOffset;				// Number of bytes of mOutput.front() that were already sent.
 
 	LLPluginMessagePipeOwner *mOwner;
 	LLSocket::ptr_t mSocket;
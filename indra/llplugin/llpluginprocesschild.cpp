@@ -131,7 +131,12 @@ void LLPluginProcessChild::idle(void)
 			break;
 			
 			case STATE_CONNECTED:
-				sendMessageToParent(LLPluginMessage(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "hello"));
+				{
+					LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "hello");
+					// Let the viewer know it may send binary messages to us.
+					message.setValueBoolean("binary_messages", true);
+					sendMessageToParent(message);
+				}
 				setState(STATE_PLUGIN_LOADING);
 			break;
 						
@@ -310,9 +315,9 @@ void LLPluginProcessChild::sendMessageToPlugin(const LLPluginMessage &message)
 // This function is called by SLPlugin to send 'message' to the viewer (the parent process).
 void LLPluginProcessChild::sendMessageToParent(const LLPluginMessage &message)
 {
-	std::string buffer = message.generate();
+	std::string buffer = generateMessage(message);
 
-	LL_DEBUGS("Plugin") << "Sending to parent: " << buffer << LL_ENDL;
+	LL_DEBUGS("Plugin") << "Sending to parent: " << message << LL_ENDL;
 
 	// Write the serialized message to the pipe.
 	writeMessageRaw(buffer);
@@ -328,12 +333,12 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
 {
 	// Incoming message from the TCP Socket
 
-	LL_DEBUGS("Plugin") << "Received from parent: " << message << LL_ENDL;
-
 	// Decode this message
 	LLPluginMessage parsed;
 	parsed.parse(message);
 
+	LL_DEBUGS("Plugin") << "Received from parent: " << parsed << LL_ENDL;
+
 	if(mBlockingRequest)
 	{
 		// We're blocking the plugin waiting for a response.
@@ -366,6 +371,8 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
 			{
 				mPluginFile = parsed.getValue("file");
 				mPluginDir = parsed.getValue("dir");
+				// Older viewers only understand XML.
+				setBinaryMessages(parsed.getValueBoolean("binary_messages"));
 			}
 			else if(message_name == "shm_add")
 			{
@@ -454,7 +461,8 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
 	{
 		LLTimer elapsed;
 
-		mInstance->sendMessage(message);
+		// The plugin itself always gets XML.
+		mInstance->sendMessage(LLPluginMessage::isBinary(message) ? parsed.generate() : message);
 
 		mCPUElapsed += elapsed.getElapsedTimeF64();
 	}
@@ -483,6 +491,7 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 	
 	// Incoming message from the plugin instance
 	bool passMessage = true;
+	std::string binary_message;
 
 	// FIXME: how should we handle queueing here?
 	
@@ -490,7 +499,11 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 	{
 		// Decode this message
 		LLPluginMessage parsed;
-		parsed.parse(message);
+		if (parsed.parse(message) != -1 && getBinaryMessages())
+		{
+			// Pass it on in the encoding that was negotiated with the viewer.
+			binary_message = parsed.generateBinary();
+		}
 		
 		if(parsed.hasValue("blocking_request"))
 		{
@@ -573,7 +586,7 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 	if(passMessage)
 	{
 		LL_DEBUGS("Plugin") << "Passing through to parent: " << message << LL_ENDL;
-		writeMessageRaw(message);
+		writeMessageRaw(binary_message.empty() ? message : binary_message);
 	}
 	
 	while(mBlockingRequest)
@@ -45,6 +45,7 @@ LLPluginProcessParentOwner::~LLPluginProcessParentOwner()
 }
 
 bool LLPluginProcessParent::sUseReadThread = false;
+bool LLPluginProcessParent::sUseBinaryMessages = true;
 apr_pollset_t *LLPluginProcessParent::sPollSet = NULL;
 LLAPRPool LLPluginProcessParent::sPollSetPool;
 bool LLPluginProcessParent::sPollsetNeedsRebuild = false;
@@ -495,6 +496,11 @@ void LLPluginProcessParent::idle(void)
 					LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "load_plugin");
 					message.setValue("file", mPluginFile);
 					message.setValue("dir", mPluginDir);
+					if (sUseBinaryMessages)
+					{
+						// Let the plugin know it may send binary messages to us.
+						message.setValueBoolean("binary_messages", true);
+					}
 					sendMessage(message);
 				}
 
@@ -629,15 +635,15 @@ void LLPluginProcessParent::sendMessage(const LLPluginMessage &message)
 		mBlocked = true;
 	}
 	
-	std::string buffer = message.generate();
+	std::string buffer = generateMessage(message);
 #if LL_DEBUG
 	if (message.getName() == "mouse_event")
 	{
-		LL_DEBUGS("PluginMouseEvent") << "Sending: " << buffer << LL_ENDL;
+		LL_DEBUGS("PluginMouseEvent") << "Sending: " << message << LL_ENDL;
 	}
 	else
 	{
-		LL_DEBUGS("Plugin") << "Sending: " << buffer << LL_ENDL;
+		LL_DEBUGS("Plugin") << "Sending: " << message << LL_ENDL;
 	}
 #endif
 	writeMessageRaw(buffer);
@@ -917,11 +923,11 @@ void LLPluginProcessParent::servicePoll()
 // It parses the message and passes it on to LLPluginProcessParent::receiveMessage.
 void LLPluginProcessParent::receiveMessageRaw(const std::string &message)
 {
-	LL_DEBUGS("PluginRaw") << "Received: " << message << LL_ENDL;
-	
 	LLPluginMessage parsed;
 	if(parsed.parse(message) != -1)
 	{
+		LL_DEBUGS("PluginRaw") << "Received: " << parsed << LL_ENDL;
+
 		if(parsed.hasValue("blocking_request"))
 		{
 			mBlocked = true;
@@ -992,6 +998,8 @@ void LLPluginProcessParent::receiveMessage(const LLPluginMessage &message)
 		{
 			if(mState == STATE_CONNECTED)
 			{
+				// Older plugin hosts only understand XML.
+				setBinaryMessages(sUseBinaryMessages && message.getValueBoolean("binary_messages"));
 				// Plugin host has launched.  Tell it which plugin to load.
 				setState(STATE_HELLO);
 			}
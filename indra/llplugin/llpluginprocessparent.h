@@ -125,6 +125,8 @@ public:
 	static bool canPollThreadRun() { return (sPollSet || sPollsetNeedsRebuild || sUseReadThread); };
 	static void setUseReadThread(bool use_read_thread);
 	static bool getUseReadThread() { return sUseReadThread; };
+	// Use binary, length prefixed messages with plugins that support it (takes effect for newly launched plugins).
+	static void setUseBinaryMessages(bool use_binary_messages) { sUseBinaryMessages = use_binary_messages; }
 private:
 
 	enum EState
@@ -186,6 +188,7 @@ private:
 	F32 mPluginLockupTimeout;		// If we don't receive a heartbeat in this many seconds, we declare the plugin locked up.
 
 	static bool sUseReadThread;
+	static bool sUseBinaryMessages;
 	apr_pollfd_t mPollFD;
 	LLAPRPool mPollFDPool;
 	static apr_pollset_t *sPollSet;
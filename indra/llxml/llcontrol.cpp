@@ -172,12 +172,13 @@ LLControlVariable::LLControlVariable(const std::string& name, eControlType type,
 	  mHideFromSettingsEditor(hidefromsettingseditor),
 	  mCommitSignal(new commit_signal_t),
 	  mValidateSignal(new validate_signal_t),
-#ifdef PROF_CTRL_CALLS
-	  mLookupCount(0),
-#endif //PROF_CTRL_CALLS
 	  mIsCOA(IsCOA),
 	  mIsCOAParent(false),
-	  mCOAConnectedVar(NULL)
+	  mCOAConnectedVar(NULL),
+	  mScalarValue(0)
+#ifdef PROF_CTRL_CALLS
+	  , mLookupCount(0)
+#endif //PROF_CTRL_CALLS
 {
 	if (mPersist && mComment.empty())
 	{
@@ -185,6 +186,7 @@ LLControlVariable::LLControlVariable(const std::string& name, eControlType type,
 	}
 	//Push back versus setValue'ing here, since we don't want to call a signal yet
 	mValues.push_back(initial);
+	updateScalarValue();
 }
 
 
@@ -193,6 +195,32 @@ LLControlVariable::~LLControlVariable()
 {
 }
 
+// Must be called whenever mValues.back() changes.
+void LLControlVariable::updateScalarValue()
+{
+	const LLSD& value = mValues.back();
+	switch (mType)
+	{
+		case TYPE_U32:
+		case TYPE_S32:
+			mScalarValue = (U32)value.asInteger();
+			break;
+		case TYPE_F32:
+		{
+			F32 real = (F32)value.asReal();
+			U32 bits;
+			memcpy(&bits, &real, sizeof(bits));
+			mScalarValue = bits;
+			break;
+		}
+		case TYPE_BOOLEAN:
+			mScalarValue = value.asBoolean() ? 1 : 0;
+			break;
+		default:
+			break;
+	}
+}
+
 LLSD LLControlVariable::getComparableValue(const LLSD& value)
 {
 	// *FIX:MEP - The following is needed to make the LLSD::ImplString 
@@ -274,6 +302,7 @@ void LLControlVariable::setValue(const LLSD& new_value, bool saved_value)
             mValues.push_back(storable_value);
 	    }
     }
+	updateScalarValue();
 
 
     if(value_changed)
@@ -294,6 +323,7 @@ void LLControlVariable::setDefaultValue(const LLSD& value)
 	bool value_changed = (llsd_compare(getValue(), comparable_value) == FALSE);
 	resetToDefault(false);
 	mValues[0] = comparable_value;
+	updateScalarValue();
 	if(value_changed)
 	{
 		if(getCOAActive() == this)
@@ -324,6 +354,7 @@ void LLControlVariable::resetToDefault(bool fire_signal)
 	{
 		mValues.pop_back();
 	}
+	updateScalarValue();
 	
 	if(fire_signal) 
 	{
@@ -346,24 +377,16 @@ LLSD LLControlVariable::getSaveValue() const
 	return mValues[0];
 }
 
-#ifdef PROF_CTRL_CALLS
-void LLControlGroup::updateLookupMap(ctrl_name_table_t::const_iterator iter) const
-{
-	if(iter != mNameTable.end() && iter->second.notNull())
-	{
-		iter->second.get()->mLookupCount++;
-	}
-}
-#endif //PROF_CTRL_CALLS
-
 LLControlVariable* LLControlGroup::getControl(std::string const& name)
 {
 	ctrl_name_table_t::iterator iter = mNameTable.find(name);
+	if(iter != mNameTable.end())
+	{
 #ifdef PROF_CTRL_CALLS
-	updateLookupMap(iter);
+		iter->second->mLookupCount++;
 #endif //PROF_CTRL_CALLS
-	if(iter != mNameTable.end())
 		return iter->second->getCOAActive();
+	}
 	else
 		return NULL;
 }
@@ -371,15 +394,62 @@ LLControlVariable* LLControlGroup::getControl(std::string const& name)
 LLControlVariable const* LLControlGroup::getControl(std::string const& name) const
 {
 	ctrl_name_table_t::const_iterator iter = mNameTable.find(name);
+	if(iter != mNameTable.end())
+	{
 #ifdef PROF_CTRL_CALLS
-	updateLookupMap(iter);
+		iter->second->mLookupCount++;
 #endif //PROF_CTRL_CALLS
-	if(iter != mNameTable.end())
 		return iter->second->getCOAActive();
+	}
 	else
 		return NULL;
 }
 
+LLControlVariable* LLControlGroup::getHandleControl(const std::string& name, eControlType type)
+{
+	ctrl_name_table_t::iterator iter = mNameTable.find(name);
+	if (iter == mNameTable.end())
+	{
+		LL_WARNS() << "Control " << name << " not found." << LL_ENDL;
+		return NULL;
+	}
+	if (!iter->second->isType(type))
+	{
+		LL_WARNS() << "Control " << name << " is a " << typeEnumToString(iter->second->type()) << ", not a " << typeEnumToString(type) << "." << LL_ENDL;
+		return NULL;
+	}
+	return iter->second;
+}
+
+#ifdef PROF_CTRL_CALLS
+static bool sort_lookup_counts(const std::pair<std::string, U32>& left, const std::pair<std::string, U32>& right)
+{
+	return left.second > right.second;
+}
+
+void LLControlGroup::getLookupCounts(lookup_counts_t& counts) const
+{
+	counts.clear();
+	for (ctrl_name_table_t::const_iterator iter = mNameTable.begin(); iter != mNameTable.end(); ++iter)
+	{
+		U32 count = iter->second->getLookupCount();
+		if (count)
+		{
+			counts.push_back(std::make_pair(iter->first, count));
+		}
+	}
+	std::sort(counts.begin(), counts.end(), sort_lookup_counts);
+}
+
+void LLControlGroup::resetLookupCounts()
+{
+	for (ctrl_name_table_t::iterator iter = mNameTable.begin(); iter != mNameTable.end(); ++iter)
+	{
+		iter->second->mLookupCount = 0;
+	}
+}
+#endif //PROF_CTRL_CALLS
+
 ////////////////////////////////////////////////////////////////////////////
 
 LLControlGroup::LLControlGroup(const std::string& name)
@@ -37,6 +37,7 @@
 #include "v4coloru.h"
 #include "llinstancetracker.h"
 #include "llrefcount.h"
+#include "llatomic.h"
 
 #include "llcontrolgroupreader.h"
 
@@ -52,6 +53,7 @@
 #endif
 
 #include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
 
 #if LL_WINDOWS
 	#pragma warning (push)
@@ -126,6 +128,11 @@ private:
 	bool			mIsCOA;				//To have COA connection set.
 	bool			mIsCOAParent;		//if true, use if settingsperaccount is false.
 	LLControlVariable *mCOAConnectedVar;//Because the two vars refer to eachother, LLPointer would be a circular refrence..
+
+	LLAtomicU32		mScalarValue;		// Bits of the current value of U32, S32, F32 and Boolean controls; see LLControlHandle.
+#ifdef PROF_CTRL_CALLS
+	mutable LLAtomicU32 mLookupCount;	// Number of times this control was looked up by name.
+#endif //PROF_CTRL_CALLS
 public:
 	LLControlVariable(const std::string& name, eControlType type,
 					  LLSD initial, const std::string& comment,
@@ -153,6 +160,10 @@ public:
 	LLSD getValue()		const	{ return mValues.back(); }
 	LLSD getDefault()	const	{ return mValues.front(); }
 	LLSD getSaveValue() const;
+	U32 getScalarBits() const	{ return mScalarValue; }
+#ifdef PROF_CTRL_CALLS
+	U32 getLookupCount() const	{ return mLookupCount; }
+#endif //PROF_CTRL_CALLS
 
 	void set(const LLSD& val)	{ setValue(val); }
 	void setValue(const LLSD& value, bool saved_value = TRUE);
@@ -183,11 +194,8 @@ public:
 			mValidateSignal = pConnect->mValidateSignal;
 		}
 	}
-#ifdef PROF_CTRL_CALLS
-public:
-	U32 mLookupCount;
-#endif //PROF_CTRL_CALLS
 private:
+	void updateScalarValue();
 	LLSD getComparableValue(const LLSD& value);
 	bool llsd_compare(const LLSD& a, const LLSD & b);
 };
@@ -215,12 +223,14 @@ T convert_from_llsd(const LLSD& sd, eControlType type, const std::string& contro
 	// needs specialization
 	return T(sd);
 }
+template <typename T> class LLControlHandle;
+
 //const U32 STRING_CACHE_SIZE = 10000;
 class LLControlGroup : public LLInstanceTracker<LLControlGroup, std::string>
 {
 	LOG_CLASS(LLControlGroup);
 protected:
-	typedef std::map<std::string, LLControlVariablePtr > ctrl_name_table_t;
+	typedef boost::unordered_map<std::string, LLControlVariablePtr> ctrl_name_table_t;
 	ctrl_name_table_t mNameTable;
 	std::set<std::string> mWarnings;
 	std::string mTypeString[TYPE_COUNT];
@@ -237,6 +247,18 @@ public:
 	LLControlVariable* getControl(std::string const& name);
 	LLControlVariable const* getControl(std::string const& name) const;
 
+	// Resolve name once; reading the returned handle costs no lookup. T must be U32, S32, F32 or bool.
+	template<typename T> LLControlHandle<T> getHandle(const std::string& name) { return LLControlHandle<T>(*this, name); }
+	// Used by LLControlHandle. Returns the declared (not the COA active) control, or NULL if it doesn't exist or has another type.
+	LLControlVariable* getHandleControl(const std::string& name, eControlType type);
+
+#ifdef PROF_CTRL_CALLS
+	// Controls that were looked up by name at least once, most looked up first.
+	typedef std::vector<std::pair<std::string, U32> > lookup_counts_t;
+	void getLookupCounts(lookup_counts_t& counts) const;
+	void resetLookupCounts();
+#endif //PROF_CTRL_CALLS
+
 	struct ApplyFunctor
 	{
 		virtual ~ApplyFunctor() {};
@@ -355,10 +377,47 @@ public:
 	void connectCOAVars(LLControlGroup &OtherGroup);
 	void updateCOASetting(bool coa_enabled);
 	bool handleCOASettingChange(const LLSD& newvalue);
+};
 
-#ifdef PROF_CTRL_CALLS
-	void updateLookupMap(ctrl_name_table_t::const_iterator iter) const;
-#endif //PROF_CTRL_CALLS
+template <typename T> T control_from_bits(U32 bits);	// Only U32, S32, F32 and bool are supported.
+template <> inline U32 control_from_bits<U32>(U32 bits) { return bits; }
+template <> inline S32 control_from_bits<S32>(U32 bits) { return (S32)bits; }
+template <> inline bool control_from_bits<bool>(U32 bits) { return bits != 0; }
+template <> inline F32 control_from_bits<F32>(U32 bits) { F32 value; memcpy(&value, &bits, sizeof(value)); return value; }
+
+//! Interned handle to a U32, S32, F32 or bool control.
+
+//! Resolve the name once (typically into a static) and read it as often as needed: a read
+//! doesn't look anything up, doesn't touch LLSD and is safe from any thread. Setting goes
+//! through the control, so validation and commit signals work as with LLControlGroup::set().
+//! Use LLCachedControl for the other control types.
+template <typename T>
+class LLControlHandle
+{
+public:
+	LLControlHandle() { }
+	LLControlHandle(LLControlGroup& group, const std::string& name)
+	:	mControl(group.getHandleControl(name, get_control_type<T>()))
+	{
+	}
+
+	bool isValid() const { return mControl.notNull(); }
+	T get() const { return mControl.notNull() ? control_from_bits<T>(mControl->getCOAActive()->getScalarBits()) : T(); }
+	operator T() const { return get(); }
+	T operator()() const { return get(); }
+
+	// Main thread only.
+	void set(const T& value)
+	{
+		if (mControl.notNull())
+		{
+			mControl->getCOAActive()->set(convert_to_llsd(value));
+		}
+	}
+	LLControlVariable* getControl() const { return mControl.notNull() ? mControl->getCOAActive() : NULL; }
+
+private:
+	LLControlVariablePtr mControl;
 };
 
 
@@ -40,6 +40,7 @@
 #include "llagent.h"
 #include "llagentcamera.h"
 #include "llagentui.h"
+#include "llappviewer.h"
 #include "llavataractions.h"
 #include "llnotificationsutil.h"
 #include "llsdserialize.h"
@@ -216,23 +217,27 @@ void resync_anims()
 }
 
 #ifdef PROF_CTRL_CALLS
-bool sort_calls(const std::pair<std::string, U32>& left, const std::pair<std::string, U32>& right)
+// Logs the controls that are looked up by name most often; those are the ones worth moving to an LLControlHandle.
+void dump_control_lookups()
 {
-	return left.second > right.second;
-}
-//Structure to be passed into LLControlGroup::applyToAll.
-// Doesn't actually modify control group, but rather uses the 'apply'
-// vfn to add each variable in the group to a list. This essentially
-// allows us to copy the private variable list without touching the controlgroup
-// class.
-struct ProfCtrlListAccum : public LLControlGroup::ApplyFunctor
-{
-	virtual void apply(const std::string& name, LLControlVariable* control)
+	static U32 sLastFrameCount = 0;
+	F32 frames = (F32)llmax(gFrameCount - sLastFrameCount, (U32)1);
+	LLControlGroup::key_iter it = LLControlGroup::beginKeys();
+	LLControlGroup::key_iter end = LLControlGroup::endKeys();
+	for(;it!=end;++it)
 	{
-		mVariableList.push_back(std::make_pair(name,control->mLookupCount));
+		LLControlGroup* group = LLControlGroup::getInstance(*it);
+		LLControlGroup::lookup_counts_t counts;
+		group->getLookupCounts(counts);
+		LL_INFOS() << *it << ": lookup count (" << (U32)frames << " frames)" << LL_ENDL;
+		for (U32 i = 0; i < counts.size() && i < 50; ++i)
+		{
+			LL_INFOS() << "  " << counts[i].first << ": " << counts[i].second << " lookups, " << (counts[i].second / frames) << " l/f" << LL_ENDL;
+		}
+		group->resetLookupCounts();
 	}
-	std::vector<std::pair<std::string, U32> > mVariableList;
-};
+	sLastFrameCount = gFrameCount;
+}
 #endif //PROF_CTRL_CALLS
 void spew_key_to_name(const LLUUID& targetKey, const LLAvatarName& av_name)
 {
@@ -606,20 +611,8 @@ bool cmd_line_chat(std::string data, EChatType type)
 #ifdef PROF_CTRL_CALLS
 		else if (cmd == "dumpcalls")
 		{
-			LLControlGroup::key_iter it = LLControlGroup::beginKeys();
-			LLControlGroup::key_iter end = LLControlGroup::endKeys();
-			for(;it!=end;++it)
-			{
-				ProfCtrlListAccum list;
-				LLControlGroup::getInstance(*it)->applyToAll(&list);
-				std::sort(list.mVariableList.begin(),list.mVariableList.end(),sort_calls);
-				LL_INFOS() << *it << ": lookup count (" << gFrameCount << "frames)" << LL_ENDL;
-				for(U32 i = 0;i<list.mVariableList.size();i++)
-				{
-					if (list.mVariableList[i].second)
-						LL_INFOS() << "  " << list.mVariableList[i].first << ":  " << list.mVariableList[i].second << " lookups, " << ((float)list.mVariableList[i].second / (float)gFrameCount) << "l/f\n" << LL_ENDL;
-				}
-			}
+			dump_control_lookups();
+			cmdline_printchat("Most looked up settings written to the log.");
 			return false;
 		}
 #endif //PROF_CTRL_CALLS
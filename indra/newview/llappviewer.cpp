@@ -49,6 +49,7 @@
 #include "llagentwearables.h"
 #include "llwindow.h"
 #include "llviewerstats.h"
+#include "lllogchat.h"
 #include "llmarketplacefunctions.h"
 #include "llmarketplacenotifications.h"
 #include "llmd5.h"
@@ -198,6 +199,7 @@
 #include "llparcel.h"
 #include "llviewerassetstats.h"
 
+#include "lleventchannel.h"
 #include "llmainlooprepeater.h"
 
 // [RLVa:KB]
@@ -1169,6 +1171,19 @@ bool LLAppViewer::mainLoop()
 		{
 			LLFastTimer::nextFrame(); // Should be outside of any timer instances
 
+			static const LLCachedControl<bool> fast_timer_trace("FastTimerTrace", false);
+			if (fast_timer_trace != LLFastTimerTrace::isTracing())
+			{
+				if (!fast_timer_trace)
+				{
+					LLFastTimerTrace::stop();
+				}
+				else if (!LLFastTimerTrace::start(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "fast_timer_trace.json")))
+				{
+					gSavedSettings.setBOOL("FastTimerTrace", FALSE);
+				}
+			}
+
 			//clear call stack records
 			LL_CLEAR_CALLSTACKS();
 
@@ -1232,7 +1247,9 @@ bool LLAppViewer::mainLoop()
 				mem_leak_instance->idle();
 			}
 
-			// canonical per-frame event
+			// canonical per-frame event: typed listeners first, then the LLSD pump
+			LLMainloopEvent frame_event = { LLFrameTimer::getFrameCount() };
+			LLMainloopEvent::channel().post(frame_event);
 			mainloop.post(newFrame);
 
 			if (!LLApp::isExiting())
@@ -1493,6 +1510,8 @@ bool LLAppViewer::cleanup()
 
 	LLError::logToFixedBuffer(NULL);
 
+	LLFastTimerTrace::stop();
+
 	LL_INFOS() << "Cleaning Up" << LL_ENDL;
 
 	// shut down mesh streamer
@@ -1534,6 +1553,8 @@ bool LLAppViewer::cleanup()
 
 	LLCalc::cleanUp();
 
+	LLLogChat::cleanupClass();
+
 	LL_INFOS() << "Global stuff deleted" << LL_ENDL;
 
 	// Note: this is where LLFeatureManager::getInstance()-> used to be deleted.
@@ -1819,6 +1840,7 @@ bool LLAppViewer::cleanup()
 
 	LLApp::stopErrorThread();			// The following call is not thread-safe. Have to stop all threads.
 	stopEngineThread();
+	gStateMachineThreadPool.stop();
 	AICurlInterface::cleanupCurl();
 
 	// Cleanup settings last in case other classes reference them.
@@ -1857,6 +1879,8 @@ bool LLAppViewer::cleanup()
 
 	MEM_TRACK_RELEASE
 
+	LLError::setAsyncLogging(false);
+
 	LL_INFOS() << "Goodbye!" << LL_ENDL;
 
 	// return 0;
@@ -1898,8 +1922,12 @@ bool LLAppViewer::initThreads()
 		LLWatchdog::getInstance()->init(watchdog_killer_callback);
 	}
 
-	// State machine thread.
+	// Logger thread.
+	LLError::setAsyncLogging(gSavedSettings.getBOOL("AsyncLogging"));
+
+	// State machine threads.
 	startEngineThread();
+	gStateMachineThreadPool.start(gSavedSettings.getU32("StateMachineThreadPoolSize"));
 
 	AICurlInterface::startCurlThread(&gSavedSettings);
 
@@ -2872,6 +2900,8 @@ void LLAppViewer::handleViewerCrash()
 	// Close the debug file
 	pApp->writeDebugInfo(false);  //false answers the isStatic question with the least overhead.
 
+	// Write out what is still queued for the log file.
+	LLError::setAsyncLogging(false);
 	LLError::logToFile("");
 
 	// Remove the marker file, since otherwise we'll spawn a process that'll keep it locked
@@ -3263,7 +3293,7 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
 	// Viewer object cache version, change if object update
 	// format changes. JC
-	const U32 INDRA_OBJECT_CACHE_VERSION = 14;
+	const U32 INDRA_OBJECT_CACHE_VERSION = 15;
 
 	return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -3354,6 +3384,10 @@ bool LLAppViewer::initCache()
 
 	U64 extra = LLAppViewer::getTextureCache()->initCache(LL_PATH_CACHE, texture_cache_size, texture_cache_mismatch);
 	texture_cache_size -= extra;
+	if (gSavedSettings.getBOOL("TextureDecodedCache"))
+	{
+		LLAppViewer::getTextureCache()->initDecodedCache((U64)gSavedSettings.getU32("TextureDecodedCacheSize") * MB);
+	}
 
 	LLVOCache::getInstance()->initCache(LL_PATH_CACHE, gSavedSettings.getU32("CacheNumberOfRegionsForObjects"), getObjectCacheVersion()) ;
 
@@ -3648,13 +3682,18 @@ void LLAppViewer::saveFinalSnapshot()
 void LLAppViewer::loadNameCache()
 {
 	// Phoenix: Wolfspirit: Loads the Display Name Cache. And set if we are using Display Names.
+	// The binary cache is preferred; the XML one is what older viewers left behind.
 	std::string filename =
-		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
+		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.bin");
 	LL_INFOS("AvNameCache") << filename << LL_ENDL;
-	llifstream name_cache_stream(filename);
-	if(name_cache_stream.is_open())
+	if (!LLAvatarNameCache::importBinaryFile(filename))
 	{
-		LLAvatarNameCache::importFile(name_cache_stream);
+		filename = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
+		llifstream name_cache_stream(filename);
+		if(name_cache_stream.is_open())
+		{
+			LLAvatarNameCache::importFile(name_cache_stream);
+		}
 	}
 
 	if (!gCacheName) return;
@@ -3672,12 +3711,8 @@ void LLAppViewer::saveNameCache()
 {
 	// Phoenix: Wolfspirit: Saves the Display Name Cache.
 	std::string filename =
-		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.xml");
-	llofstream name_cache_stream(filename);
-	if(name_cache_stream.is_open())
-	{
-		LLAvatarNameCache::exportFile(name_cache_stream);
-	}
+		gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "avatar_name_cache.bin");
+	LLAvatarNameCache::exportBinaryFile(filename);
 
 	if (!gCacheName) return;
 
@@ -4463,6 +4498,7 @@ void LLAppViewer::idleNetwork()
 	}
 
 	LLViewerStats::getInstance()->mNumNewObjectsStat.addValue(gObjectList.mNumNewObjects);
+	gObjectList.updateObjectUpdateStats();
 
 	// Retransmit unacknowledged packets.
 	gXferManager->retransmitUnackedPackets();
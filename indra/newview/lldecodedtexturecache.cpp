@@ -0,0 +1,323 @@
+/**
+ * @file lldecodedtexturecache.cpp
+ * @brief Second tier texture cache holding decoded textures as DXT mip chains.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lldecodedtexturecache.h"
+
+#include "llapr.h"
+#include "lldir.h"
+#include "lldiriterator.h"
+#include "llfile.h"
+#include "llimagedxt.h"
+
+// Smaller textures decode from J2C quickly enough.
+static const S32 MIN_DECODED_PIXELS = 64 * 64;
+// Evict down to this fraction of the maximum size once it is exceeded.
+static const F32 DECODED_CACHE_PURGE_TO = .9f;
+
+static const char* decoded_extension = ".dxr";
+
+namespace
+{
+	// Precedes the LLImageDXT data in each file.
+	struct entry_header_t
+	{
+		U32 mMagic;
+		S32 mDiscard;			// discard level of the largest mip
+		S32 mCodestreamSize;	// size of the J2C it was decoded from
+		S32 mReserved;
+	};
+	const U32 ENTRY_MAGIC = 0x31584444;	// "DDX1"
+}
+
+LLDecodedTextureCache::LLDecodedTextureCache()
+:	mUsage(0),
+	mMaxSize(0),
+	mReadOnly(true),
+	mHits(0),
+	mMisses(0),
+	mBytesSaved(0)
+{
+}
+
+void LLDecodedTextureCache::initCache(const std::string& dirname, U64 max_size, bool read_only)
+{
+	LLMutexLock lock(&mMutex);
+	mDirName = dirname;
+	mMaxSize = max_size;
+	mReadOnly = read_only;
+	mEntries.clear();
+	mUsage = 0;
+	if (!mMaxSize)
+	{
+		return;
+	}
+	if (!mReadOnly)
+	{
+		LLFile::mkdir(mDirName);
+	}
+
+	// File names are <id>_<discard>.dxr, so the scan does not open any file.
+	U32 now = time(NULL);
+	std::string filename;
+	LLDirIterator iter(mDirName, std::string("*") + decoded_extension);
+	while (iter.next(filename))
+	{
+		LLUUID id;
+		S32 discard = -1;
+		size_t sep = filename.find('_');
+		if (sep == std::string::npos || !id.set(filename.substr(0, sep), FALSE) ||
+			sscanf(filename.c_str() + sep + 1, "%d", &discard) != 1 || discard < 0 || discard > MAX_DISCARD_LEVEL)
+		{
+			continue;
+		}
+		std::string path = mDirName + gDirUtilp->getDirDelimiter() + filename;
+		llstat stat_data;
+		if (LLFile::stat(path, &stat_data))
+		{
+			continue;
+		}
+		entry_map_t::iterator found = mEntries.find(id);
+		if (found != mEntries.end())
+		{
+			// Left over from an interrupted write; keep the better one.
+			if (found->second.mDiscard <= discard)
+			{
+				if (!mReadOnly)
+				{
+					LLFile::remove(path);
+				}
+				continue;
+			}
+			removeEntry(found);
+		}
+		Entry entry;
+		entry.mDiscard = discard;
+		entry.mSize = (S32)stat_data.st_size;
+		entry.mTime = llmin((U32)stat_data.st_mtime, now);
+		mEntries[id] = entry;
+		mUsage += entry.mSize;
+	}
+	LL_INFOS("TextureCache") << "Decoded texture cache: " << mEntries.size() << " entries, "
+							 << mUsage / (1024 * 1024) << " of " << mMaxSize / (1024 * 1024) << " MB" << LL_ENDL;
+	evict();
+}
+
+void LLDecodedTextureCache::purge()
+{
+	LLMutexLock lock(&mMutex);
+	if (!mReadOnly && !mDirName.empty())
+	{
+		gDirUtilp->deleteFilesInDir(mDirName, std::string("*") + decoded_extension);
+	}
+	mEntries.clear();
+	mUsage = 0;
+}
+
+std::string LLDecodedTextureCache::getFileName(const LLUUID& id, S32 discard) const
+{
+	return mDirName + gDirUtilp->getDirDelimiter() + id.asString() + llformat("_%d", discard) + decoded_extension;
+}
+
+bool LLDecodedTextureCache::read(const LLUUID& id, S32 discard, LLPointer<LLImageRaw>& raw, S32& codestream_size)
+{
+	if (!isEnabled())
+	{
+		return false;
+	}
+	S32 stored_discard;
+	{
+		LLMutexLock lock(&mMutex);
+		entry_map_t::iterator iter = mEntries.find(id);
+		if (iter == mEntries.end() || iter->second.mDiscard > discard)
+		{
+			++mMisses;
+			return false;
+		}
+		stored_discard = iter->second.mDiscard;
+		iter->second.mTime = time(NULL);
+	}
+
+	// The mips are stored smallest first: read only as far as the one wanted.
+	bool success = false;
+	std::string filename = getFileName(id, stored_discard);
+	S32 file_size = 0;
+	LLAPRFile infile(filename, LL_APR_RB, &file_size);
+	entry_header_t header;
+	if (infile.getFileHandle() && infile.read(&header, sizeof(header)) == sizeof(header) &&
+		header.mMagic == ENTRY_MAGIC && header.mDiscard == stored_discard)
+	{
+		LLPointer<LLImageDXT> dxt = new LLImageDXT();
+		S32 header_size = dxt->calcHeaderSize();
+		U8* data = dxt->allocateData(header_size);
+		if (data && infile.read(data, header_size) == header_size && dxt->updateData() &&
+			(dxt->getFileFormat() == LLImageDXT::FORMAT_DXR1 || dxt->getFileFormat() == LLImageDXT::FORMAT_DXR5))
+		{
+			S32 level = discard - stored_discard;
+			S32 data_size = dxt->calcDataSize(level);
+			if (data_size <= file_size - (S32)sizeof(header) &&
+				(data = dxt->reallocateData(data_size)) &&
+				infile.read(data + header_size, data_size - header_size) == data_size - header_size)
+			{
+				dxt->updateData();
+				dxt->setDiscardLevel(level);
+				raw = new LLImageRaw();
+				success = dxt->decode(raw, 0.f);
+			}
+		}
+	}
+	infile.close();
+
+	LLMutexLock lock(&mMutex);
+	if (success)
+	{
+		++mHits;
+		mBytesSaved += header.mCodestreamSize;
+		codestream_size = header.mCodestreamSize;
+	}
+	else
+	{
+		LL_WARNS("TextureCache") << "Removing unreadable decoded texture " << filename << LL_ENDL;
+		raw = NULL;
+		++mMisses;
+		entry_map_t::iterator iter = mEntries.find(id);
+		if (iter != mEntries.end() && iter->second.mDiscard == stored_discard)
+		{
+			removeEntry(iter);
+		}
+	}
+	return success;
+}
+
+bool LLDecodedTextureCache::wantsWrite(const LLUUID& id, S32 discard, const LLImageRaw* raw)
+{
+	if (!isEnabled() || mReadOnly || !raw)
+	{
+		return false;
+	}
+	S32 width = raw->getWidth();
+	S32 height = raw->getHeight();
+	S32 components = raw->getComponents();
+	if ((components != 3 && components != 4) || width * height < MIN_DECODED_PIXELS ||
+		(width & (width - 1)) || (height & (height - 1)))
+	{
+		return false;
+	}
+	LLMutexLock lock(&mMutex);
+	entry_map_t::iterator iter = mEntries.find(id);
+	return iter == mEntries.end() || iter->second.mDiscard > discard;
+}
+
+void LLDecodedTextureCache::write(const LLUUID& id, const LLImageRaw* raw, S32 discard, S32 codestream_size)
+{
+	LLPointer<LLImageDXT> dxt = new LLImageDXT();
+	if (!dxt->compress(raw))
+	{
+		return;
+	}
+
+	entry_header_t header;
+	header.mMagic = ENTRY_MAGIC;
+	header.mDiscard = discard;
+	header.mCodestreamSize = codestream_size;
+	header.mReserved = 0;
+	std::string filename = getFileName(id, discard);
+	bool success = false;
+	{
+		LLAPRFile outfile(filename, LL_APR_WB);
+		success = outfile.getFileHandle() &&
+				  outfile.write(&header, sizeof(header)) == sizeof(header) &&
+				  outfile.write(dxt->getData(), dxt->getDataSize()) == dxt->getDataSize();
+	}
+	if (!success)
+	{
+		LLFile::remove_nowarn(filename);
+		return;
+	}
+
+	LLMutexLock lock(&mMutex);
+	entry_map_t::iterator iter = mEntries.find(id);
+	if (iter != mEntries.end())
+	{
+		if (iter->second.mDiscard == discard)
+		{
+			mUsage -= iter->second.mSize;
+			mEntries.erase(iter);
+		}
+		else
+		{
+			removeEntry(iter);
+		}
+	}
+	Entry entry;
+	entry.mDiscard = discard;
+	entry.mSize = (S32)sizeof(header) + dxt->getDataSize();
+	entry.mTime = time(NULL);
+	mEntries[id] = entry;
+	mUsage += entry.mSize;
+	evict();
+}
+
+void LLDecodedTextureCache::remove(const LLUUID& id)
+{
+	LLMutexLock lock(&mMutex);
+	entry_map_t::iterator iter = mEntries.find(id);
+	if (iter != mEntries.end())
+	{
+		removeEntry(iter);
+	}
+}
+
+void LLDecodedTextureCache::removeEntry(entry_map_t::iterator iter)
+{
+	if (!mReadOnly)
+	{
+		LLFile::remove(getFileName(iter->first, iter->second.mDiscard));
+	}
+	mUsage -= iter->second.mSize;
+	mEntries.erase(iter);
+}
+
+void LLDecodedTextureCache::evict()
+{
+	if (mUsage <= mMaxSize)
+	{
+		return;
+	}
+	// Least recently used first.
+	typedef std::multimap<U32, LLUUID> time_map_t;
+	time_map_t by_time;
+	for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		by_time.insert(std::make_pair(iter->second.mTime, iter->first));
+	}
+	U64 target = (U64)(mMaxSize * DECODED_CACHE_PURGE_TO);
+	for (time_map_t::iterator iter = by_time.begin(); iter != by_time.end() && mUsage > target; ++iter)
+	{
+		removeEntry(mEntries.find(iter->second));
+	}
+}
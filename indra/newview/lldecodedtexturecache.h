@@ -0,0 +1,101 @@
+/**
+ * @file lldecodedtexturecache.h
+ * @brief Second tier texture cache holding decoded textures as DXT mip chains.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDECODEDTEXTURECACHE_H
+#define LL_LLDECODEDTEXTURECACHE_H
+
+#include <map>
+
+#include "llpointer.h"
+#include "llthread.h"
+#include "lluuid.h"
+
+class LLImageRaw;
+
+// Textures that were decoded once are kept on disk as DXR1 (RGB) or DXR5
+// (RGBA) mip chains, one file per texture. When such a texture is needed
+// again the fetcher reads the mips it wants from here instead of reading
+// and decoding the J2C, which is by far the most expensive step of a
+// reload. The entries are lossy, so the cache is optional.
+//
+// Owned by LLTextureCache; read from the texture fetch thread and written
+// from the texture cache thread.
+class LLDecodedTextureCache
+{
+public:
+	LLDecodedTextureCache();
+
+	// Scans dirname for existing entries. A max_size of 0 disables the cache.
+	void initCache(const std::string& dirname, U64 max_size, bool read_only);
+	// Deletes all entries.
+	void purge();
+
+	bool isEnabled() const { return mMaxSize > 0; }
+
+	// Returns true and the texture at discard level discard in raw if an
+	// entry at that level or better exists. codestream_size receives the size
+	// of the J2C the entry was made from.
+	bool read(const LLUUID& id, S32 discard, LLPointer<LLImageRaw>& raw, S32& codestream_size);
+	// Whether write() would store raw: it can be compressed and has more
+	// detail than the current entry.
+	bool wantsWrite(const LLUUID& id, S32 discard, const LLImageRaw* raw);
+	void write(const LLUUID& id, const LLImageRaw* raw, S32 discard, S32 codestream_size);
+	void remove(const LLUUID& id);
+
+	// Statistics
+	U32 getHits() const { return mHits; }
+	U32 getMisses() const { return mMisses; }
+	U64 getBytesSaved() const { return mBytesSaved; }	// J2C bytes not read and decoded
+	U64 getUsage() const { return mUsage; }
+
+private:
+	struct Entry
+	{
+		S32 mDiscard;
+		S32 mSize;
+		U32 mTime;
+	};
+	typedef std::map<LLUUID, Entry> entry_map_t;
+
+	std::string getFileName(const LLUUID& id, S32 discard) const;
+	// Called with mMutex locked.
+	void removeEntry(entry_map_t::iterator iter);
+	void evict();
+
+private:
+	LLMutex mMutex;
+	std::string mDirName;
+	entry_map_t mEntries;
+	U64 mUsage;
+	U64 mMaxSize;
+	bool mReadOnly;
+
+	U32 mHits;
+	U32 mMisses;
+	U64 mBytesSaved;
+};
+
+#endif // LL_LLDECODEDTEXTURECACHE_H
@@ -45,7 +45,10 @@
 #include "pipeline.h"
 #include "llviewerobjectlist.h"
 #include "llviewertexturelist.h"
+#include "llappviewer.h"
+#include "lltexturecache.h"
 #include "lltexturefetch.h"
+#include "llworldmipmap.h"
 #include "sgmemstat.h"
 
 const S32 LL_SCROLL_BORDER = 1;
@@ -167,6 +170,22 @@ void LLFloaterStats::buildStats()
 	stat_barp->mLabelSpacing = 500.f;
 	stat_barp->mPerSec = TRUE;
 
+	stat_barp = render_statviewp->addStat("Object Updates", &(LLViewerObjectList::sObjectUpdateRate));
+	stat_barp->setUnitLabel("/sec");
+	stat_barp->mMinBar = 0.f;
+	stat_barp->mMaxBar = 10000.f;
+	stat_barp->mTickSpacing = 1000.f;
+	stat_barp->mLabelSpacing = 5000.f;
+	stat_barp->mPerSec = TRUE;
+
+	stat_barp = render_statviewp->addStat("Deferred Drawables", &(LLViewerObjectList::sDeferredDrawableRate));
+	stat_barp->setUnitLabel("/sec");
+	stat_barp->mMinBar = 0.f;
+	stat_barp->mMaxBar = 1000.f;
+	stat_barp->mTickSpacing = 100.f;
+	stat_barp->mLabelSpacing = 500.f;
+	stat_barp->mPerSec = TRUE;
+
 	stat_barp = render_statviewp->addStat("Object Cache Hit Rate", &(LLViewerStats::getInstance()->mNumNewObjectsStat), std::string(), false, true);
 	stat_barp->setUnitLabel("%");
 	stat_barp->mMinBar = 0.f;
@@ -191,6 +210,14 @@ void LLFloaterStats::buildStats()
 	stat_barp->mLabelSpacing = 20.f;
 	stat_barp->mPerSec = FALSE;	
 
+	stat_barp = texture_statviewp->addStat("Map Tile Hit Rate", &(LLWorldMipmap::sTileHitRate), std::string(), false, true);
+	stat_barp->setUnitLabel("%");
+	stat_barp->mMinBar = 0.f;
+	stat_barp->mMaxBar = 100.f;
+	stat_barp->mTickSpacing = 20.f;
+	stat_barp->mLabelSpacing = 20.f;
+	stat_barp->mPerSec = FALSE;	
+
 	stat_barp = texture_statviewp->addStat("Cache Read Latency", &(LLTextureFetch::sCacheReadLatency), std::string(), false, true);
 	stat_barp->setUnitLabel("msec");
 	stat_barp->mMinBar = 0.f;
@@ -200,6 +227,35 @@ void LLFloaterStats::buildStats()
 	stat_barp->mPerSec = FALSE;
 	stat_barp->mDisplayMean = FALSE;
 
+	if (LLAppViewer::getTextureCache()->getDecodedCache().isEnabled())
+	{
+		stat_barp = texture_statviewp->addStat("Decoded Cache Hit Rate", &(LLTextureFetch::sDecodedCacheHitRate), std::string(), false, true);
+		stat_barp->setUnitLabel("%");
+		stat_barp->mMinBar = 0.f;
+		stat_barp->mMaxBar = 100.f;
+		stat_barp->mTickSpacing = 20.f;
+		stat_barp->mLabelSpacing = 20.f;
+		stat_barp->mPerSec = FALSE;
+
+		// Compare with Cache Read Latency, which includes the J2C decode.
+		stat_barp = texture_statviewp->addStat("Decoded Cache Latency", &(LLTextureFetch::sDecodedCacheLatency), std::string(), false, true);
+		stat_barp->setUnitLabel("msec");
+		stat_barp->mMinBar = 0.f;
+		stat_barp->mMaxBar = 1000.f;
+		stat_barp->mTickSpacing = 100.f;
+		stat_barp->mLabelSpacing = 200.f;
+		stat_barp->mPerSec = FALSE;
+		stat_barp->mDisplayMean = FALSE;
+
+		stat_barp = texture_statviewp->addStat("Decoded Cache Saved", &(LLTextureFetch::sDecodedCacheSaved), std::string(), false, true);
+		stat_barp->setUnitLabel("KB");
+		stat_barp->mMinBar = 0.f;
+		stat_barp->mMaxBar = 1024.f;
+		stat_barp->mTickSpacing = 256.f;
+		stat_barp->mLabelSpacing = 512.f;
+		stat_barp->mPerSec = FALSE;
+	}
+
 	stat_barp = texture_statviewp->addStat("Count", &(LLViewerStats::getInstance()->mNumImagesStat), "DebugStatModeTextureCount");
 	stat_barp->setUnitLabel("");
 	stat_barp->mMinBar = 0.f;
@@ -255,6 +255,10 @@ void LLFolderViewItem::refreshFromListener()
 		{
 			mLabelStyle = mListener->getLabelStyle();
 			mLabelSuffix = mListener->getLabelSuffix();
+			if (!mLabelSuffix.empty())
+			{
+				LLInventoryFilter::addLabelSuffix(mLabelSuffix);
+			}
 		}
 		
 		updateExtraSearchCriteria();
@@ -1465,6 +1469,14 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 		LLInventoryModelBackgroundFetch::instance().start(mListener->getUUID());
 	}
 
+	// nothing below this folder has the filter string: skip the children,
+	// which are left unfiltered and so hidden
+	if (mListener && filter.isExcludedBySubString(mListener->getUUID(), getRoot()->getSearchType()))
+	{
+		setCompletedFilterGeneration(filter_generation, FALSE/*dont recurse up to root*/);
+		return;
+	}
+
 	// now query children
 	for (folders_t::iterator iter = mFolders.begin();
 		 iter != mFolders.end();
@@ -1152,6 +1152,7 @@ void LLFloaterIMPanel::onFlyoutCommit(LLComboBox* flyout, const LLSD& value)
 void show_log_browser(const std::string& name, const std::string& id)
 {
 	const std::string file(LLLogChat::makeLogFileName(name));
+	LLLogChat::flushHistory();
 	if (gSavedSettings.getBOOL("LiruLegacyLogLaunch"))
 	{
 #if LL_WINDOWS || LL_DARWIN
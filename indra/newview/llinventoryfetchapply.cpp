@@ -0,0 +1,72 @@
+/**
+ * @file llinventoryfetchapply.cpp
+ * @brief Adds fetched inventory folders to the model over several frames.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventoryfetchapply.h"
+
+#include "lltimer.h"
+
+LLInventoryFetchApply::LLInventoryFetchApply()
+:	mNextFolder(0),
+	mNextItem(0),
+	mFolderStarted(false)
+{
+}
+
+bool LLInventoryFetchApply::apply(const LLTimer& frame_timer, F32 budget)
+{
+	bool progress = false;
+	for (; mNextFolder < getFolderCount(); ++mNextFolder, mNextItem = 0, mFolderStarted = false)
+	{
+		if (!mFolderStarted)
+		{
+			if (progress && frame_timer.getElapsedTimeF32() > budget)
+			{
+				return false;
+			}
+			if (!startFolder(mNextFolder))
+			{
+				continue;
+			}
+			mFolderStarted = true;
+			progress = true;
+		}
+
+		const size_t item_count = getItemCount(mNextFolder);
+		for (; mNextItem < item_count; ++mNextItem)
+		{
+			if (progress && !(mNextItem & 15) && frame_timer.getElapsedTimeF32() > budget)
+			{
+				return false;
+			}
+			applyItem(mNextFolder, mNextItem);
+			progress = true;
+		}
+		endFolder(mNextFolder);
+	}
+	return true;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file llinventoryfetchapply.h
+ * @brief Adds fetched inventory folders to the model over several frames.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYFETCHAPPLY_H
+#define LL_LLINVENTORYFETCHAPPLY_H
+
+#include "stdtypes.h"
+
+class LLTimer;
+
+// Walks the folders and items of a parsed inventory fetch reply, continuing
+// where the previous frame stopped. The derived class does the actual work
+// on the model.
+class LLInventoryFetchApply
+{
+public:
+	LLInventoryFetchApply();
+	virtual ~LLInventoryFetchApply() { }
+
+	// Starts, fills and ends every folder not handled yet, until the time of
+	// frame_timer passes budget. The first folder start or item of each call
+	// is handled whatever the time, so that every call makes progress; after
+	// that the time is checked before each folder and every 16 items.
+	// Returns true when all of the reply was handled.
+	bool apply(const LLTimer& frame_timer, F32 budget);
+
+protected:
+	virtual size_t getFolderCount() const = 0;
+	virtual size_t getItemCount(size_t folder) const = 0;
+	// Adds the categories of the folder. Returns false to skip the folder.
+	virtual bool startFolder(size_t folder) = 0;
+	virtual void applyItem(size_t folder, size_t item) = 0;
+	// Called once all items of a started folder were added.
+	virtual void endFolder(size_t folder) = 0;
+
+private:
+	size_t mNextFolder;
+	size_t mNextItem;
+	bool mFolderStarted;		// startFolder() was called for mNextFolder
+};
+
+#endif // LL_LLINVENTORYFETCHAPPLY_H
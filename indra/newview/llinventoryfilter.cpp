@@ -49,6 +49,8 @@
 #include "llinventoryclipboard.h"
 #include "lltrans.h"
 
+std::set<std::string> LLInventoryFilter::sLabelSuffixes;
+
 LLInventoryFilter::FilterOps::FilterOps(const Params& p)
 :	mFilterTypes(p.types),
 	mFilterObjectTypes(p.object_types),
@@ -77,7 +79,10 @@ LLInventoryFilter::LLInventoryFilter(const Params& p)
 	mEmptyLookupMessage("InventoryNoMatchingItems"),
 	mCurrentGeneration(0),
 	mFirstRequiredGeneration(0),
-	mFirstSuccessGeneration(0)
+	mFirstSuccessGeneration(0),
+	mSubStringFoldersVersion(0),
+	mSubStringFoldersSuffixes(0),
+	mSubStringIndexed(false)
 {
 	mOrder = SO_FOLDERS_BY_NAME; // This gets overridden by a pref immediately
 
@@ -139,6 +144,100 @@ bool LLInventoryFilter::checkFolder(const LLFolderViewFolder* folder) const
 	return checkFolder(folder_id);
 }
 
+bool LLInventoryFilter::isExcludedBySubString(const LLUUID& folder_id, U32 search_type)
+{
+	if (mFilterSubString.empty() || folder_id.isNull()
+		|| mFilterOps.mShowFolderState == LLInventoryFilter::SHOW_ALL_FOLDERS)
+	{
+		return false;
+	}
+	// Creators are not indexed, and a match could span the name and the
+	// description, which the folder views join with a space.
+	if ((search_type & 4) || ((search_type & 2) && mFilterSubString.find(' ') != std::string::npos))
+	{
+		return false;
+	}
+	// Only the agent's inventory and the library are indexed, not the
+	// contents of objects.
+	if (!gInventory.getCategory(folder_id))
+	{
+		return false;
+	}
+	updateSubStringFolders();
+	return mSubStringIndexed && mSubStringFolders.find(folder_id) == mSubStringFolders.end();
+}
+
+// static
+void LLInventoryFilter::addLabelSuffix(const std::string& suffix)
+{
+	std::string upper_suffix(suffix);
+	LLStringUtil::toUpper(upper_suffix);
+	sLabelSuffixes.insert(upper_suffix);
+}
+
+void LLInventoryFilter::updateSubStringFolders()
+{
+	// While the inventory is fetched every folder that arrives changes the
+	// index: rather than searching it again each time, walk everything until
+	// the fetch is done.
+	if (LLInventoryModelBackgroundFetch::instance().folderFetchActive())
+	{
+		mSubStringFoldersQuery.clear();
+		mSubStringIndexed = false;
+		return;
+	}
+
+	const LLInventorySearchIndex& index = gInventory.getSearchIndex();
+	if (mSubStringFoldersQuery == mFilterSubString
+		&& mSubStringFoldersVersion == index.getVersion()
+		&& mSubStringFoldersSuffixes == sLabelSuffixes.size())
+	{
+		return;
+	}
+	mSubStringFoldersQuery = mFilterSubString;
+	mSubStringFoldersVersion = index.getVersion();
+	mSubStringFoldersSuffixes = sLabelSuffixes.size();
+	mSubStringFolders.clear();
+
+	// The labels end in suffixes the index knows nothing about: a query that
+	// could match across the end of a name and into a suffix is not indexed.
+	const std::string& query = mFilterSubString;
+	mSubStringIndexed = true;
+	for (std::set<std::string>::const_iterator it = sLabelSuffixes.begin(); it != sLabelSuffixes.end() && mSubStringIndexed; ++it)
+	{
+		const std::string& suffix = *it;
+		if (suffix.find(query) != std::string::npos)
+		{
+			mSubStringIndexed = false;
+		}
+		for (size_t i = 1; i < query.size() && mSubStringIndexed; ++i)
+		{
+			if (!suffix.compare(0, query.size() - i, query, i, std::string::npos))
+			{
+				mSubStringIndexed = false;
+			}
+		}
+	}
+	if (!mSubStringIndexed)
+	{
+		return;
+	}
+
+	// Keep the ancestors of every match: only their subtrees get walked.
+	uuid_vec_t matches;
+	index.find(query, matches);
+	for (uuid_vec_t::const_iterator it = matches.begin(); it != matches.end(); ++it)
+	{
+		const LLInventoryObject* obj = gInventory.getObject(*it);
+		LLUUID parent_id = obj ? obj->getParentUUID() : LLUUID::null;
+		while (parent_id.notNull() && mSubStringFolders.insert(parent_id).second)
+		{
+			const LLViewerInventoryCategory* cat = gInventory.getCategory(parent_id);
+			parent_id = cat ? cat->getParentUUID() : LLUUID::null;
+		}
+	}
+}
+
 bool LLInventoryFilter::checkFolder(const LLUUID& folder_id) const
 {
 	// Always check against the clipboard
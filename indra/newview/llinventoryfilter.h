@@ -27,6 +27,9 @@
 #ifndef LLINVENTORYFILTER_H
 #define LLINVENTORYFILTER_H
 
+#include <set>
+#include <boost/unordered_set.hpp>
+
 #include "llinventorytype.h"
 #include "llpermissionsflags.h"
 
@@ -229,9 +232,16 @@ public:
 	bool				check(const LLInventoryItem* item);
 	bool				checkFolder(const LLFolderViewFolder* folder) const;
 	bool				checkFolder(const LLUUID& folder_id) const;
+	// Whether nothing below the folder can match the filter string, going by
+	// the inventory search index. search_type is that of the folder view.
+	bool				isExcludedBySubString(const LLUUID& folder_id, U32 search_type);
 
 	bool				showAllResults() const;
 
+	// Folder view items report the label suffixes they show, " (worn)" and
+	// the like: those are searched too, but are not in the index.
+	static void			addLabelSuffix(const std::string& suffix);
+
 	std::string::size_type getStringMatchOffset() const;
 	std::string::size_type getFilterStringSize() const;
 	// +-------------------------------------------------------------------+
@@ -297,6 +307,7 @@ private:
 	bool 				checkAgainstPermissions(const LLInventoryItem* item) const;
 	bool 				checkAgainstFilterLinks(const LLFolderViewItem* item) const;
 	bool				checkAgainstClipboard(const LLUUID& object_id) const;
+	void				updateSubStringFolders();
 
 	U32						mOrder;
 
@@ -308,6 +319,16 @@ private:
 	std::string				mFilterSubStringOrig;
 	const std::string		mName;
 
+	// Folders with an object matching the filter string below them, and what
+	// they were found for.
+	boost::unordered_set<LLUUID> mSubStringFolders;
+	std::string				mSubStringFoldersQuery;
+	U32						mSubStringFoldersVersion;
+	U32						mSubStringFoldersSuffixes;
+	bool					mSubStringIndexed;		// false when a label suffix could match, or while fetching
+
+	static std::set<std::string> sLabelSuffixes;
+
 	S32						mCurrentGeneration;
     // The following makes checking for pass/no pass possible even if the item is not checked against the current generation
     // Any item that *did not pass* the "required generation" will *not pass* the current one
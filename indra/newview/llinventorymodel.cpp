@@ -863,6 +863,37 @@ void LLInventoryModel::collectDescendentsIf(const LLUUID& id,
 // [/RLVa:KB]
 }
 
+void LLInventoryModel::updateSearchIndex(const LLUUID& id)
+{
+	if (const LLViewerInventoryItem* item = getItem(id))
+	{
+		mSearchIndex.update(id, item->getName(), item->getDescription());
+		if (!item->getIsLinkType())
+		{
+			updateSearchIndexForLinks(id);
+		}
+	}
+	else if (const LLViewerInventoryCategory* cat = getCategory(id))
+	{
+		mSearchIndex.update(id, cat->getName(), LLStringUtil::null);
+		updateSearchIndexForLinks(id);
+	}
+}
+
+// Links show the name of what they point to, which may arrive after them.
+void LLInventoryModel::updateSearchIndexForLinks(const LLUUID& target_id)
+{
+	if (mBacklinkMMap.find(target_id) == mBacklinkMMap.end())
+	{
+		return;
+	}
+	item_array_t links = collectLinksTo(target_id);
+	for (item_array_t::iterator iter = links.begin(); iter != links.end(); ++iter)
+	{
+		mSearchIndex.update((*iter)->getUUID(), (*iter)->getName(), (*iter)->getDescription());
+	}
+}
+
 void LLInventoryModel::addChangedMaskForLinks(const LLUUID& object_id, U32 mask)
 {
 	const LLInventoryObject *obj = getObject(object_id);
@@ -1509,6 +1540,7 @@ void LLInventoryModel::deleteObject(const LLUUID& id, bool fix_broken_links, boo
 	mCategoryMap.erase(id);
 	mItemMap.erase(id);
 	//mInventory.erase(id);
+	mSearchIndex.remove(id);
 	item_array_t* item_list = getUnlockedItemArray(parent_id);
 	if(item_list)
 	{
@@ -1671,6 +1703,11 @@ void LLInventoryModel::addChangedMask(U32 mask, const LLUUID& referent)
 	}
 	
 	mModifyMask |= mask; 
+	// Renames often reach the model only this way.
+	if (referent.notNull() && (mask & (LLInventoryObserver::LABEL | LLInventoryObserver::DESCRIPTION)))
+	{
+		updateSearchIndex(referent);
+	}
 	if (referent.notNull() && (mChangedItemIDs.find(referent) == mChangedItemIDs.end()))
 	{
 		mChangedItemIDs.insert(referent);
@@ -1775,6 +1812,8 @@ void LLInventoryModel::addCategory(LLViewerInventoryCategory* category)
 		// Insert category uniquely into the map
 		mCategoryMap[category->getUUID()] = category; // LLPointer will deref and delete the old one
 		//mInventory[category->getUUID()] = category;
+		mSearchIndex.update(category->getUUID(), category->getName(), LLStringUtil::null);
+		updateSearchIndexForLinks(category->getUUID());
 	}
 }
 
@@ -1852,6 +1891,11 @@ void LLInventoryModel::addItem(LLViewerInventoryItem* item)
 			addBacklinkInfo(link_id, target_id);
 		}
 		mItemMap[item->getUUID()] = item;
+		mSearchIndex.update(item->getUUID(), item->getName(), item->getDescription());
+		if (!item->getIsLinkType())
+		{
+			updateSearchIndexForLinks(item->getUUID());
+		}
 	}
 }
 
@@ -1872,6 +1916,7 @@ void LLInventoryModel::empty()
 	mBacklinkMMap.clear(); // forget all backlink information.
 	mCategoryMap.clear(); // remove all references (should delete entries)
 	mItemMap.clear(); // remove all references (should delete entries)
+	mSearchIndex.clear();
 	mLastItem = NULL;
 	//mInventory.clear();
 }
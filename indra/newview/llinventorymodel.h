@@ -38,6 +38,7 @@
 #include "llhttpclient.h"
 #include "lluuid.h"
 #include "llpermissionsflags.h"
+#include "llinventorysearchindex.h"
 #include "llviewerinventory.h"
 #include "llstring.h"
 #include "llmd5.h"
@@ -172,6 +173,13 @@ private:
 	bool hasBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id) const;
 	void addBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id);
 	void removeBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id);
+
+	// Names and descriptions of all objects, for the inventory filter.
+	LLInventorySearchIndex mSearchIndex;
+	void updateSearchIndex(const LLUUID& id);
+	void updateSearchIndexForLinks(const LLUUID& target_id);
+public:
+	const LLInventorySearchIndex& getSearchIndex() const { return mSearchIndex; }
 	
 	//--------------------------------------------------------------------
 	// Login
@@ -30,8 +30,10 @@
 #include "llagent.h"
 #include "llappviewer.h"
 #include "llcallbacklist.h"
+#include "llinventoryfetchapply.h"
 #include "llinventorypanel.h"
 #include "llinventorymodel.h"
+#include "llsdserialize.h"
 #include "llviewercontrol.h"
 #include "llviewerinventory.h"
 #include "llviewermessage.h"
@@ -98,15 +100,21 @@ protected:
 // Handler for FetchInventoryDescendents2 and FetchLibDescendents2
 // caps requests for folders.
 //
-class BGFolderHttpHandler : public LLHTTPClient::ResponderWithResult
+// A successful reply is not decoded here: the body is handed to the parse
+// thread, which turns it into categories and items, and the main thread then
+// adds those to the inventory a few at a time. The handler stays alive, and
+// counted as an outstanding fetch, until all of it was added.
+//
+class BGFolderHttpHandler : public LLHTTPClient::ResponderWithCompleted, public LLInventoryFetchApply
 {
 	LOG_CLASS(BGFolderHttpHandler);
 	
 public:
 	BGFolderHttpHandler(const LLSD & request_sd, const uuid_vec_t & recursive_cats)
-		: LLHTTPClient::ResponderWithResult(),
+		: LLHTTPClient::ResponderWithCompleted(),
 		  mRequestSD(request_sd),
-		  mRecursiveCatUUIDs(recursive_cats)
+		  mRecursiveCatUUIDs(recursive_cats),
+		  mParsed(false)
 		{
 			LLInventoryModelBackgroundFetch::instance().incrFetchCount(1);
 		}
@@ -120,15 +128,73 @@ public:
 	/*virtual*/ AIHTTPTimeoutPolicy const& getHTTPTimeoutPolicy(void) const { return BGFolderHttpHandler_timeout; }
 	/*virtual*/ char const* getName(void) const { return "BGFolderHttpHandler"; }
 
+	// Called by the parse thread. LLInventoryFetchApply::apply() then adds
+	// the reply to the inventory.
+	void parse();
+
+	bool mParsed;		// Protected by the parse mutex of LLInventoryModelBackgroundFetch.
+
 protected:
 	BGFolderHttpHandler(const BGFolderHttpHandler &);			// Not defined
 	void operator=(const BGFolderHttpHandler &);				// Not defined
 	BOOL getIsRecursive(const LLUUID& cat_id) const;
 private:
-	/*virtual*/ void httpSuccess(void);
-	/*virtual*/ void httpFailure(void);
+	/*virtual*/ void completedRaw(LLChannelDescriptors const& channels, buffer_ptr_t const& buffer);
+	void handleFailure();
+
+	/*virtual*/ size_t getFolderCount() const { return mFolders.size(); }
+	/*virtual*/ size_t getItemCount(size_t folder) const { return mFolders[folder].mItems.size(); }
+	/*virtual*/ bool startFolder(size_t folder);
+	/*virtual*/ void applyItem(size_t folder, size_t item);
+	/*virtual*/ void endFolder(size_t folder);
+
 	LLSD mRequestSD;
 	uuid_vec_t mRecursiveCatUUIDs; // hack for storing away which cat fetches are recursive
+
+	// One folder of the reply, built by the parse thread.
+	struct FetchedFolder
+	{
+		LLUUID mFolderID;
+		S32 mVersion;
+		S32 mDescendents;
+		std::vector<LLPointer<LLViewerInventoryCategory> > mCategories;
+		std::vector<LLPointer<LLViewerInventoryItem> > mItems;
+	};
+	std::string mBody;
+	std::vector<FetchedFolder> mFolders;
+	LLUUID mLostAndFoundID;		// where the items of the started folder go, if it has no id
+};
+
+// Parses folder fetch replies, in the order they arrived.
+class LLInventoryModelBackgroundFetch::ParseThread : public LLThread
+{
+public:
+	ParseThread(LLInventoryModelBackgroundFetch* fetcher) : LLThread("Inventory parse"), mFetcher(fetcher) { }
+
+protected:
+	/*virtual*/ void run(void)
+	{
+		while (true)
+		{
+			// Sleeps until runCondition() returns true or we are asked to quit.
+			checkPause();
+			if (isQuitting())
+			{
+				break;
+			}
+			while (!isQuitting() && mFetcher->parseNextResponse())
+			{
+			}
+		}
+	}
+
+	/*virtual*/ bool runCondition(void)
+	{
+		return mFetcher->hasResponsesToParse();
+	}
+
+private:
+	LLInventoryModelBackgroundFetch* mFetcher;
 };
 
 
@@ -145,12 +211,20 @@ LLInventoryModelBackgroundFetch::LLInventoryModelBackgroundFetch() :
 	mNumFetchRetries(0),
 	mMinTimeBetweenFetches(0.3f),
 	mMaxTimeBetweenFetches(10.f),
-	mTimelyFetchPending(FALSE)
+	mTimelyFetchPending(FALSE),
+	mParseThread(NULL)
 {
 }
 
 LLInventoryModelBackgroundFetch::~LLInventoryModelBackgroundFetch()
 {
+	if (mParseThread)
+	{
+		mParseThread->setQuitting();
+		delete mParseThread;
+		mParseThread = NULL;
+	}
+	gIdleCallbacks.deleteFunction(&LLInventoryModelBackgroundFetch::applyFolderResponsesCB, NULL);
 }
 
 bool LLInventoryModelBackgroundFetch::isBulkFetchProcessingComplete() const
@@ -488,6 +562,98 @@ void LLInventoryModelBackgroundFetch::backgroundFetch()
 	}
 }
 
+void LLInventoryModelBackgroundFetch::queueFolderResponse(BGFolderHttpHandler* handler)
+{
+	if (!mParseThread)
+	{
+		// Unpacking uses the localized names dictionary, which is read-only by
+		// now: the skeleton categories created it before any fetch.
+		mParseThread = new ParseThread(this);
+		mParseThread->start();
+	}
+	if (mFolderResponses.empty())
+	{
+		gIdleCallbacks.addFunction(&LLInventoryModelBackgroundFetch::applyFolderResponsesCB, NULL);
+	}
+	mFolderResponses.push_back(handler);
+	{
+		LLMutexLock lock(mParseMutex);
+		mParseQueue.push_back(handler);
+	}
+	mParseThread->wake();
+}
+
+bool LLInventoryModelBackgroundFetch::hasResponsesToParse()
+{
+	LLMutexLock lock(mParseMutex);
+	return !mParseQueue.empty();
+}
+
+// Called by the parse thread. Returns false if there was nothing to do.
+bool LLInventoryModelBackgroundFetch::parseNextResponse()
+{
+	BGFolderHttpHandler* handler;
+	{
+		LLMutexLock lock(mParseMutex);
+		if (mParseQueue.empty())
+		{
+			return false;
+		}
+		handler = mParseQueue.front();
+	}
+	handler->parse();
+
+	LLMutexLock lock(mParseMutex);
+	mParseQueue.pop_front();
+	handler->mParsed = true;
+	return true;
+}
+
+void LLInventoryModelBackgroundFetch::applyFolderResponsesCB(void *)
+{
+	LLInventoryModelBackgroundFetch::instance().applyFolderResponses();
+}
+
+// Adds parsed replies to the inventory, in the order they arrived, and tells
+// the observers once for all of them.
+void LLInventoryModelBackgroundFetch::applyFolderResponses()
+{
+	static LLCachedControl<F32> apply_budget(gSavedSettings, "InventoryFetchApplyBudget");
+	LLTimer frame_timer;
+	bool changed = false;
+	while (!mFolderResponses.empty())
+	{
+		BGFolderHttpHandler* handler = static_cast<BGFolderHttpHandler*>(mFolderResponses.front().get());
+		{
+			LLMutexLock lock(mParseMutex);
+			if (!handler->mParsed)
+			{
+				break;
+			}
+		}
+		changed = true;
+		if (!handler->apply(frame_timer, apply_budget))
+		{
+			break;
+		}
+		// Releases the handler, which takes it off the fetch count.
+		mFolderResponses.pop_front();
+	}
+	if (mFolderResponses.empty())
+	{
+		gIdleCallbacks.deleteFunction(&LLInventoryModelBackgroundFetch::applyFolderResponsesCB, NULL);
+		if (changed && isBulkFetchProcessingComplete())
+		{
+			LL_INFOS() << "Inventory fetch completed" << LL_ENDL;
+			setAllFoldersFetched();
+		}
+	}
+	if (changed)
+	{
+		gInventory.notifyObservers();
+	}
+}
+
 void LLInventoryModelBackgroundFetch::incrFetchCount(S32 fetching) 
 {  
 	mFetchCount += fetching; 
@@ -730,144 +896,153 @@ bool LLInventoryModelBackgroundFetch::fetchQueueContainsNoDescendentsOf(const LL
 	}
 	return true;
 }
-// If we get back a normal response, handle it here.
-void BGFolderHttpHandler::httpSuccess(void)
+void BGFolderHttpHandler::completedRaw(LLChannelDescriptors const& channels, buffer_ptr_t const& buffer)
 {
-	LLInventoryModelBackgroundFetch *fetcher = LLInventoryModelBackgroundFetch::getInstance();
-	const LLSD& content = mContent;
-	// in response as an application-level error.
-
-	// Instead, we assume success and attempt to extract information.
-	if (content.has("folders"))	
+	if (!isGoodStatus(mStatus))
 	{
-		LLSD folders(content["folders"]);
-		
-		for (LLSD::array_const_iterator folder_it = folders.beginArray();
-			folder_it != folders.endArray();
-			++folder_it)
-		{	
-			LLSD folder_sd(*folder_it);
-
-			//LLUUID agent_id = folder_sd["agent_id"];
-
-			//if(agent_id != gAgent.getID())	//This should never happen.
-			//{
-			//	LL_WARNS(LOG_INV) << "Got a UpdateInventoryItem for the wrong agent."
-			//			<< LL_ENDL;
-			//	break;
-			//}
+		decode_llsd_body(channels, buffer);
+		handleFailure();
+		return;
+	}
+	// If we get back a normal response, the parse thread handles it.
+	decode_raw_body(channels, buffer, mBody);
+	LLInventoryModelBackgroundFetch::instance().queueFolderResponse(this);
+}
 
-			LLUUID parent_id(folder_sd["folder_id"].asUUID());
-			LLUUID owner_id(folder_sd["owner_id"].asUUID());
-			S32    version(folder_sd["version"].asInteger());
-			S32    descendents(folder_sd["descendents"].asInteger());
+// Called by the parse thread: only builds the categories and items, the
+// inventory model is not touched.
+void BGFolderHttpHandler::parse()
+{
+	LLSD content;
+	{
+		std::istringstream istr(mBody);
+		if (LLSDSerialize::fromXML(content, istr) == LLSDParser::PARSE_FAILURE)
+		{
+			LL_WARNS(LOG_INV) << "Failed to deserialize LLSD. " << mURL << " [" << mStatus << "]: " << mReason << LL_ENDL;
+		}
+	}
+	std::string().swap(mBody);
+
+	// We assume success and attempt to extract information.
+	const LLSD& folders = content["folders"];
+	mFolders.resize(folders.size());
+	std::vector<FetchedFolder>::iterator fetched = mFolders.begin();
+	for (LLSD::array_const_iterator folder_it = folders.beginArray();
+		 folder_it != folders.endArray();
+		 ++folder_it, ++fetched)
+	{
+		const LLSD& folder_sd(*folder_it);
+
+		fetched->mFolderID = folder_sd["folder_id"].asUUID();
+		fetched->mVersion = folder_sd["version"].asInteger();
+		fetched->mDescendents = folder_sd["descendents"].asInteger();
+		const LLUUID owner_id(folder_sd["owner_id"].asUUID());
+
+		const LLSD& categories(folder_sd["categories"]);
+		fetched->mCategories.reserve(categories.size());
+		for (LLSD::array_const_iterator category_it = categories.beginArray();
+			 category_it != categories.endArray();
+			 ++category_it)
+		{
 			LLPointer<LLViewerInventoryCategory> tcategory = new LLViewerInventoryCategory(owner_id);
+			tcategory->fromLLSD(*category_it);
+			fetched->mCategories.push_back(tcategory);
+		}
 
-            if (parent_id.isNull())
-            {
-				LLSD items(folder_sd["items"]);
-			    LLPointer<LLViewerInventoryItem> titem = new LLViewerInventoryItem;
-				
-			    for (LLSD::array_const_iterator item_it = items.beginArray();
-				    item_it != items.endArray();
-				    ++item_it)
-			    {	
-                    const LLUUID lost_uuid(gInventory.findCategoryUUIDForType(LLFolderType::FT_LOST_AND_FOUND));
-
-                    if (lost_uuid.notNull())
-                    {
-				        LLSD item(*item_it);
-
-				        titem->unpackMessage(item);
-				
-                        LLInventoryModel::update_list_t update;
-                        LLInventoryModel::LLCategoryUpdate new_folder(lost_uuid, 1);
-                        update.push_back(new_folder);
-                        gInventory.accountForUpdate(update);
-
-                        titem->setParent(lost_uuid);
-                        titem->updateParentOnServer(FALSE);
-                        gInventory.updateItem(titem);
-                        gInventory.notifyObservers();
-                    }
-                }
-            }
-
-	        LLViewerInventoryCategory * pcat(gInventory.getCategory(parent_id));
-			if (! pcat)
-			{
-				continue;
-			}
+		const LLSD& items(folder_sd["items"]);
+		fetched->mItems.reserve(items.size());
+		for (LLSD::array_const_iterator item_it = items.beginArray();
+			 item_it != items.endArray();
+			 ++item_it)
+		{
+			LLPointer<LLViewerInventoryItem> titem = new LLViewerInventoryItem;
+			titem->unpackMessage(*item_it);
+			fetched->mItems.push_back(titem);
+		}
+	}
 
-			LLSD categories(folder_sd["categories"]);
-			for (LLSD::array_const_iterator category_it = categories.beginArray();
-				category_it != categories.endArray();
-				++category_it)
-			{	
-				LLSD category(*category_it);
-				tcategory->fromLLSD(category); 
-				
-				const bool recursive(getIsRecursive(tcategory->getUUID()));
-				if (recursive)
-				{
-					fetcher->addRequestAtBack(tcategory->getUUID(), recursive, true);
-				}
-				else if (! gInventory.isCategoryComplete(tcategory->getUUID()))
-				{
-					gInventory.updateCategory(tcategory);
-				}
-			}
+	const LLSD& bad_folders(content["bad_folders"]);
+	for (LLSD::array_const_iterator folder_it = bad_folders.beginArray();
+		 folder_it != bad_folders.endArray();
+		 ++folder_it)
+	{
+		const LLSD& folder_sd(*folder_it);
+			
+		// These folders failed on the dataserver.  We probably don't want to retry them.
+		LL_WARNS(LOG_INV) << "Folder " << folder_sd["folder_id"].asString() 
+						  << "Error: " << folder_sd["error"].asString() << LL_ENDL;
+	}
+}
 
-			LLSD items(folder_sd["items"]);
-			LLPointer<LLViewerInventoryItem> titem = new LLViewerInventoryItem;
-			for (LLSD::array_const_iterator item_it = items.beginArray();
-				 item_it != items.endArray();
-				 ++item_it)
-			{	
-				LLSD item(*item_it);
-				titem->unpackMessage(item);
-				
-				gInventory.updateItem(titem);
-			}
+bool BGFolderHttpHandler::startFolder(size_t folder)
+{
+	const LLUUID& parent_id = mFolders[folder].mFolderID;
+	if (parent_id.isNull())
+	{
+		// Items without a folder go to the lost and found.
+		mLostAndFoundID = gInventory.findCategoryUUIDForType(LLFolderType::FT_LOST_AND_FOUND);
+		return mLostAndFoundID.notNull();
+	}
 
-			// Set version and descendentcount according to message.
-			LLViewerInventoryCategory * cat(gInventory.getCategory(parent_id));
-			if (cat)
-			{
-				cat->setVersion(version);
-				cat->setDescendentCount(descendents);
-				cat->determineFolderType();
-			}
-		}
+	if (!gInventory.getCategory(parent_id))
+	{
+		return false;
 	}
-		
-	if (content.has("bad_folders"))
+
+	LLInventoryModelBackgroundFetch *fetcher = LLInventoryModelBackgroundFetch::getInstance();
+	std::vector<LLPointer<LLViewerInventoryCategory> >& categories = mFolders[folder].mCategories;
+	for (std::vector<LLPointer<LLViewerInventoryCategory> >::iterator category_it = categories.begin();
+		 category_it != categories.end();
+		 ++category_it)
 	{
-		LLSD bad_folders(content["bad_folders"]);
-		for (LLSD::array_const_iterator folder_it = bad_folders.beginArray();
-			 folder_it != bad_folders.endArray();
-			 ++folder_it)
+		LLViewerInventoryCategory* tcategory = *category_it;
+		const bool recursive(getIsRecursive(tcategory->getUUID()));
+		if (recursive)
 		{
-			// *TODO: Stop copying data [ed:  this isn't copying data]
-			LLSD folder_sd(*folder_it);
-			
-			// These folders failed on the dataserver.  We probably don't want to retry them.
-			LL_WARNS(LOG_INV) << "Folder " << folder_sd["folder_id"].asString() 
-							  << "Error: " << folder_sd["error"].asString() << LL_ENDL;
+			fetcher->addRequestAtBack(tcategory->getUUID(), recursive, true);
+		}
+		else if (! gInventory.isCategoryComplete(tcategory->getUUID()))
+		{
+			gInventory.updateCategory(tcategory);
 		}
 	}
-	
-	if (fetcher->isBulkFetchProcessingComplete())
+	return true;
+}
+
+void BGFolderHttpHandler::applyItem(size_t folder, size_t item)
+{
+	LLViewerInventoryItem* titem = mFolders[folder].mItems[item];
+	if (mFolders[folder].mFolderID.isNull())
 	{
-		LL_INFOS() << "Inventory fetch completed" << LL_ENDL;
-		fetcher->setAllFoldersFetched();
+		LLInventoryModel::update_list_t update;
+		LLInventoryModel::LLCategoryUpdate new_folder(mLostAndFoundID, 1);
+		update.push_back(new_folder);
+		gInventory.accountForUpdate(update);
+
+		titem->setParent(mLostAndFoundID);
+		titem->updateParentOnServer(FALSE);
 	}
-	
-	gInventory.notifyObservers();
+	gInventory.updateItem(titem);
+}
+
+void BGFolderHttpHandler::endFolder(size_t folder)
+{
+	FetchedFolder& fetched = mFolders[folder];
+	// Set version and descendentcount according to message, now that the
+	// folder has all its children.
+	LLViewerInventoryCategory * cat(fetched.mFolderID.notNull() ? gInventory.getCategory(fetched.mFolderID) : NULL);
+	if (cat)
+	{
+		cat->setVersion(fetched.mVersion);
+		cat->setDescendentCount(fetched.mDescendents);
+		cat->determineFolderType();
+	}
+	fetched.mCategories.clear();
+	fetched.mItems.clear();
 }
 
 //If we get back an error (not found, etc...), handle it here
-void BGFolderHttpHandler::httpFailure(void)
+void BGFolderHttpHandler::handleFailure()
 {
 	LLInventoryModelBackgroundFetch *fetcher = LLInventoryModelBackgroundFetch::getInstance();
 
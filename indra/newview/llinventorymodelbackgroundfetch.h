@@ -27,9 +27,15 @@
 #ifndef LL_LLINVENTORYMODELBACKGROUNDFETCH_H
 #define LL_LLINVENTORYMODELBACKGROUNDFETCH_H
 
+#include <deque>
+
 #include "llsingleton.h"
+#include "llthread.h"
 #include "lluuid.h"
 #include "aicurlperservice.h"
+#include "llhttpclient.h"
+
+class BGFolderHttpHandler;
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Class LLInventoryModelBackgroundFetch
@@ -67,12 +73,23 @@ public:
 	void addRequestAtFront(const LLUUID & id, BOOL recursive, bool is_category);
 	void addRequestAtBack(const LLUUID & id, BOOL recursive, bool is_category);
 
+	// Folder replies are parsed by the parse thread, then added to the
+	// inventory from idle() under the InventoryFetchApplyBudget.
+	void queueFolderResponse(BGFolderHttpHandler* handler);
+
+	// Called by the parse thread.
+	bool hasResponsesToParse();
+	bool parseNextResponse();
+
 protected:
 	void bulkFetch();
 
 	void backgroundFetch();
 	static void backgroundFetchCB(void*); // background fetch idle function
 
+	void applyFolderResponses();
+	static void applyFolderResponsesCB(void*);
+
 	bool fetchQueueContainsNoDescendentsOf(const LLUUID& cat_id) const;
 
 private:
@@ -105,6 +122,14 @@ private:
 	};
 	typedef std::deque<FetchQueueInfo> fetch_queue_t;
 	fetch_queue_t mFetchQueue;
+
+	class ParseThread;
+	ParseThread* mParseThread;
+	// Folder replies in the order they arrived, until they were added to the
+	// inventory. Holds the references, so only the main thread touches it.
+	std::deque<LLHTTPClient::ResponderPtr> mFolderResponses;
+	LLMutex mParseMutex;					// Protects mParseQueue.
+	std::deque<BGFolderHttpHandler*> mParseQueue;
 };
 
 #endif // LL_LLINVENTORYMODELBACKGROUNDFETCH_H
@@ -0,0 +1,216 @@
+/**
+ * @file llinventorysearchindex.cpp
+ * @brief Trigram index of inventory names and descriptions.
+ *
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearchindex.h"
+
+#include <algorithm>
+
+#include "llstring.h"
+
+// Rebuild the lists when stale entries outnumber current ones, and there are
+// at least this many of them.
+static const U32 MIN_STALE_TO_REBUILD = 65536;
+
+// The sequences of one, two and three bytes of text, without duplicates, the
+// length in the top byte so that they don't collide. Those spanning the line
+// feed between name and description never match a query and are left out.
+static void get_trigrams(const std::string& text, std::vector<U32>& trigrams)
+{
+	trigrams.clear();
+	const U8* bytes = (const U8*)text.data();
+	for (size_t i = 0, count = text.size(); i < count; ++i)
+	{
+		if (bytes[i] == '\n')
+		{
+			continue;
+		}
+		trigrams.push_back((1 << 24) | bytes[i]);
+		if (i + 1 < count && bytes[i + 1] != '\n')
+		{
+			trigrams.push_back((2 << 24) | (bytes[i] << 8) | bytes[i + 1]);
+			if (i + 2 < count && bytes[i + 2] != '\n')
+			{
+				trigrams.push_back((3 << 24) | (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2]);
+			}
+		}
+	}
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+LLInventorySearchIndex::LLInventorySearchIndex()
+:	mLiveCount(0),
+	mStaleCount(0),
+	mVersion(0)
+{
+}
+
+void LLInventorySearchIndex::update(const LLUUID& id, const std::string& name, const std::string& desc)
+{
+	std::string text(name);
+	if (!desc.empty())
+	{
+		text += '\n';
+		text += desc;
+	}
+	LLStringUtil::toUpper(text);
+
+	U32 entry;
+	boost::unordered_map<LLUUID, U32>::iterator iter = mSlots.find(id);
+	if (iter != mSlots.end())
+	{
+		entry = iter->second;
+		if (mEntries[entry].mText == text)
+		{
+			return;
+		}
+		mLiveCount -= mEntries[entry].mTrigrams;
+		mStaleCount += mEntries[entry].mTrigrams;
+	}
+	else
+	{
+		if (mFreeEntries.empty())
+		{
+			entry = (U32)mEntries.size();
+			mEntries.push_back(Entry());
+		}
+		else
+		{
+			entry = mFreeEntries.back();
+			mFreeEntries.pop_back();
+		}
+		mSlots[id] = entry;
+		mEntries[entry].mID = id;
+	}
+	mEntries[entry].mText.swap(text);
+	addTrigrams(entry);
+	++mVersion;
+
+	if (mStaleCount > mLiveCount && mStaleCount >= MIN_STALE_TO_REBUILD)
+	{
+		rebuild();
+	}
+}
+
+void LLInventorySearchIndex::remove(const LLUUID& id)
+{
+	boost::unordered_map<LLUUID, U32>::iterator iter = mSlots.find(id);
+	if (iter == mSlots.end())
+	{
+		return;
+	}
+	Entry& entry = mEntries[iter->second];
+	entry.mID.setNull();
+	entry.mText.clear();
+	mLiveCount -= entry.mTrigrams;
+	mStaleCount += entry.mTrigrams;
+	entry.mTrigrams = 0;
+	mFreeEntries.push_back(iter->second);
+	mSlots.erase(iter);
+	++mVersion;
+
+	if (mStaleCount > mLiveCount && mStaleCount >= MIN_STALE_TO_REBUILD)
+	{
+		rebuild();
+	}
+}
+
+void LLInventorySearchIndex::clear()
+{
+	mEntries.clear();
+	mFreeEntries.clear();
+	mSlots.clear();
+	mTrigramLists.clear();
+	mLiveCount = mStaleCount = 0;
+	++mVersion;
+}
+
+void LLInventorySearchIndex::addTrigrams(U32 entry)
+{
+	static std::vector<U32> trigrams;
+	get_trigrams(mEntries[entry].mText, trigrams);
+	for (std::vector<U32>::const_iterator iter = trigrams.begin(); iter != trigrams.end(); ++iter)
+	{
+		mTrigramLists[*iter].push_back(entry);
+	}
+	mEntries[entry].mTrigrams = (U32)trigrams.size();
+	mLiveCount += mEntries[entry].mTrigrams;
+}
+
+void LLInventorySearchIndex::rebuild()
+{
+	mTrigramLists.clear();
+	mLiveCount = mStaleCount = 0;
+	for (U32 entry = 0; entry < (U32)mEntries.size(); ++entry)
+	{
+		if (mEntries[entry].mID.notNull())
+		{
+			addTrigrams(entry);
+		}
+	}
+}
+
+void LLInventorySearchIndex::find(const std::string& sub_string, uuid_vec_t& matches) const
+{
+	static std::vector<U32> trigrams;
+	get_trigrams(sub_string, trigrams);
+	if (trigrams.empty())
+	{
+		return;
+	}
+
+	// Every match is in the list of each sequence: take the shortest.
+	const std::vector<U32>* shortest = NULL;
+	for (std::vector<U32>::const_iterator iter = trigrams.begin(); iter != trigrams.end(); ++iter)
+	{
+		trigram_map_t::const_iterator list = mTrigramLists.find(*iter);
+		if (list == mTrigramLists.end())
+		{
+			return;
+		}
+		if (!shortest || list->second.size() < shortest->size())
+		{
+			shortest = &list->second;
+		}
+	}
+
+	// An entry reused or updated since the last rebuild can be listed twice.
+	static std::vector<U32> candidates;
+	candidates.assign(shortest->begin(), shortest->end());
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	for (std::vector<U32>::const_iterator iter = candidates.begin(); iter != candidates.end(); ++iter)
+	{
+		const Entry& entry = mEntries[*iter];
+		if (entry.mID.notNull() && entry.mText.find(sub_string) != std::string::npos)
+		{
+			matches.push_back(entry.mID);
+		}
+	}
+}
@@ -0,0 +1,87 @@
+/**
+ * @file llinventorysearchindex.h
+ * @brief Trigram index of inventory names and descriptions.
+ *
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYSEARCHINDEX_H
+#define LL_LLINVENTORYSEARCHINDEX_H
+
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include "lluuid.h"
+
+// Substring index over the names and descriptions of inventory objects, so
+// that a search does not have to look at every object. Each object's text is
+// split into its sequences of up to three bytes (trigrams, and the shorter
+// ones so that one and two letter queries have lists too); a query is
+// answered from the shortest list of objects sharing one of its sequences,
+// checking each of those against the query.
+//
+// Text is kept in upper case, as the inventory filter compares it. Lists are
+// only appended to: renamed and removed objects leave stale entries behind,
+// which the check against the current text ignores, until there are enough
+// of them to rebuild the lists.
+class LLInventorySearchIndex
+{
+public:
+	LLInventorySearchIndex();
+
+	// Adds the object, or replaces its text.
+	void update(const LLUUID& id, const std::string& name, const std::string& desc);
+	void remove(const LLUUID& id);
+	void clear();
+
+	// Appends the objects whose name or description contains sub_string,
+	// which must be upper case and not empty.
+	void find(const std::string& sub_string, uuid_vec_t& matches) const;
+
+	S32 getCount() const						{ return (S32)mSlots.size(); }
+	// Changes every time the indexed text does.
+	U32 getVersion() const						{ return mVersion; }
+
+private:
+	void addTrigrams(U32 entry);
+	void rebuild();
+
+	struct Entry
+	{
+		LLUUID mID;					// null when the entry is free
+		std::string mText;			// name, and description after a line feed
+		U32 mTrigrams;				// number of lists the entry was added to
+	};
+	std::vector<Entry> mEntries;
+	std::vector<U32> mFreeEntries;
+	boost::unordered_map<LLUUID, U32> mSlots;
+
+	typedef boost::unordered_map<U32, std::vector<U32> > trigram_map_t;
+	trigram_map_t mTrigramLists;
+	U32 mLiveCount;					// list entries that belong to current text
+	U32 mStaleCount;				// and those that do not
+	U32 mVersion;
+};
+
+#endif // LL_LLINVENTORYSEARCHINDEX_H
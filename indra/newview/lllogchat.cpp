@@ -35,7 +35,36 @@
 #include <ctime>
 #include "lllogchat.h"
 #include "llappviewer.h"
+#include "llcallbacklist.h"
 #include "llfloaterchat.h"
+#include "lllogchatwriter.h"
+
+// Saved lines are written out by this thread, LogChatFlushInterval seconds after the first of a batch.
+static LLLogChatWriter* sLogWriter = NULL;
+static LLFrameTimer sLogFlushTimer;
+
+static LLLogChatWriter* get_log_writer()
+{
+	if (!sLogWriter)
+	{
+		sLogWriter = new LLLogChatWriter;
+		sLogWriter->start();
+	}
+	return sLogWriter;
+}
+
+static void flush_log_writer_cb(void*)
+{
+	static const LLCachedControl<F32> flush_interval("LogChatFlushInterval", 2.f);
+	if (sLogFlushTimer.getElapsedTimeF32() >= flush_interval)
+	{
+		gIdleCallbacks.deleteFunction(&flush_log_writer_cb, NULL);
+		if (sLogWriter)
+		{
+			sLogWriter->requestFlush();
+		}
+	}
+}
 
 
 //static
@@ -114,94 +143,54 @@ void LLLogChat::saveHistory(std::string const& filename, std::string line)
 		return;
 	}
 
-	LLFILE* fp = LLFile::fopen(LLLogChat::makeLogFileName(filename), "a"); 		/*Flawfinder: ignore*/
-	if (!fp)
+	get_log_writer()->append(LLLogChat::makeLogFileName(filename), line);
+	if (!gIdleCallbacks.containsFunction(&flush_log_writer_cb, NULL))
 	{
-		LL_INFOS() << "Couldn't open chat history log!" << LL_ENDL;
+		sLogFlushTimer.reset();
+		gIdleCallbacks.addFunction(&flush_log_writer_cb, NULL);
 	}
-	else
+}
+
+//static
+void LLLogChat::flushHistory()
+{
+	if (sLogWriter)
 	{
-		fprintf(fp, "%s\n", line.c_str());
-		
-		fclose (fp);
+		sLogWriter->flush();
 	}
 }
 
-static long const LOG_RECALL_BUFSIZ = 2048;
+//static
+void LLLogChat::cleanupClass()
+{
+	gIdleCallbacks.deleteFunction(&flush_log_writer_cb, NULL);
+	delete sLogWriter;
+	sLogWriter = NULL;
+}
 
 void LLLogChat::loadHistory(std::string const& filename , void (*callback)(ELogLineType, std::string, void*), void* userdata)
 {
-	bool filename_empty = filename.empty();
-	if (filename_empty)
+	if (filename.empty())
 	{
 		LL_WARNS() << "filename is empty!" << LL_ENDL;
 	}
-	else while(1)	// So we can use break.
+	else
 	{
 		// The number of lines to return.
 		static const LLCachedControl<U32> lines("LogShowHistoryLines", 32);
-		if (lines == 0) break;
-
-		// Open the log file.
-		LLFILE* fptr = LLFile::fopen(makeLogFileName(filename), "rb");
-		if (!fptr) break;
-
-		// Set pos to point to the last character of the file, if any.
-		if (fseek(fptr, 0, SEEK_END)) break;
-		long pos = ftell(fptr) - 1;
-		if (pos < 0) break;
-
-		char buffer[LOG_RECALL_BUFSIZ];
-		bool error = false;
-		U32 nlines = 0;
-		while (pos > 0 && nlines < lines)
+		if (lines)
 		{
-			// Read the LOG_RECALL_BUFSIZ characters before pos.
-			size_t size = llmin(LOG_RECALL_BUFSIZ, pos);
-			pos -= size;
-			fseek(fptr, pos, SEEK_SET);
-			size_t len = fread(buffer, 1, size, fptr);
-			error = len != size;
-			if (error) break;
-			// Count the number of newlines in it and set pos to the beginning of the first line to return when we found enough.
-			for (char const* p = buffer + size - 1; p >= buffer; --p)
+			std::vector<std::string> history;
+			if (get_log_writer()->readTail(makeLogFileName(filename), lines, history))
 			{
-				if (*p == '\n')
+				for (std::vector<std::string>::const_iterator iter = history.begin(); iter != history.end(); ++iter)
 				{
-					if (++nlines == lines)
-					{
-						pos += p - buffer + 1;
-						break;
-					}
+					callback(LOG_LINE, *iter, userdata);
 				}
+				callback(LOG_END, LLStringUtil::null, userdata);
+				return;
 			}
 		}
-		if (error)
-		{
-			fclose(fptr);
-			break;
-		}
-
-		// Set the file pointer at the first line to return.
-		fseek(fptr, pos, SEEK_SET);
-
-		// Read lines from the file one by one until we reach the end of the file.
-		while (fgets(buffer, LOG_RECALL_BUFSIZ, fptr))
-		{
-		  size_t len = strlen(buffer);
-		  int i = len - 1;
-		  while (i >= 0 && (buffer[i] == '\r' || buffer[i] == '\n')) // strip newline chars from the end of the string
-		  {
-			  buffer[i] = '\0';
-			  i--;
-		  }
-		  callback(LOG_LINE, buffer, userdata);
-		}
-
-		fclose(fptr);
-		callback(LOG_END, LLStringUtil::null, userdata);
-		return;
 	}
 	callback(LOG_EMPTY, LLStringUtil::null, userdata);
 }
-
@@ -51,6 +51,10 @@ public:
 	static void loadHistory(std::string const& filename, 
 		                    void (*callback)(ELogLineType,std::string,void*), 
 							void* userdata);
+	// Writes out the lines saveHistory() queued, e.g. before a log is opened elsewhere.
+	static void flushHistory();
+	// Writes out the queued lines and closes the log files, at shutdown.
+	static void cleanupClass();
 private:
 	static std::string cleanFileName(std::string filename);
 };
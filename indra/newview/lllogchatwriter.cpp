@@ -0,0 +1,487 @@
+/**
+ * @file lllogchatwriter.cpp
+ * @brief Background writer and line index for chat and IM transcripts.
+ *
+ * $LicenseInfo:firstyear=2002&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lllogchatwriter.h"
+
+#include <ctime>
+
+// Transcripts are written in binary mode so that the index offsets are byte
+// offsets; keep the line endings text mode used to produce.
+#if LL_WINDOWS
+static const char* LOG_EOL = "\r\n";
+#else
+static const char* LOG_EOL = "\n";
+#endif
+
+// Files not written to for this long are closed.
+static const U32 LOG_IDLE_CLOSE_SECONDS = 60;
+// Beyond this many open transcripts, the least recently used one is closed.
+static const size_t MAX_OPEN_LOGS = 32;
+
+static const long LOG_RECALL_BUFSIZ = 2048;
+
+namespace
+{
+	struct index_header_t
+	{
+		U32 mMagic;
+		U32 mVersion;
+		U64 mLogSize;		// size of the transcript the index describes
+		U32 mLineCount;		// number of complete lines in it
+		U32 mReserved;
+	};
+	// One per INDEX_INTERVAL-th line.
+	struct index_entry_t
+	{
+		U64 mOffset;
+		U32 mLine;
+		U32 mDate;			// when the line was written, 0 if not known
+	};
+	const U32 INDEX_MAGIC = 0x58444943;	// "CIDX"
+	const U32 INDEX_VERSION = 1;
+
+	index_entry_t make_entry(U64 offset, U32 line, U32 date)
+	{
+		index_entry_t entry;
+		entry.mOffset = offset;
+		entry.mLine = line;
+		entry.mDate = date;
+		return entry;
+	}
+
+	// Entries of an index describing line_count complete lines.
+	U32 entry_count(U32 line_count)
+	{
+		return (line_count + LLLogChatWriter::INDEX_INTERVAL - 1) / LLLogChatWriter::INDEX_INTERVAL;
+	}
+
+	bool write_header(LLFILE* index, U64 log_size, U32 line_count)
+	{
+		index_header_t header;
+		header.mMagic = INDEX_MAGIC;
+		header.mVersion = INDEX_VERSION;
+		header.mLogSize = log_size;
+		header.mLineCount = line_count;
+		header.mReserved = 0;
+		return !fseek(index, 0, SEEK_SET) && fwrite(&header, sizeof(header), 1, index) == 1;
+	}
+
+	bool read_header(LLFILE* index, index_header_t& header)
+	{
+		return !fseek(index, 0, SEEK_SET) && fread(&header, sizeof(header), 1, index) == 1 &&
+			   header.mMagic == INDEX_MAGIC && header.mVersion == INDEX_VERSION;
+	}
+
+	// Returns the offset of the first of the last count lines of log, by
+	// scanning backwards from its end, or -1 on a read error.
+	long find_tail_start(LLFILE* log, long size, U32 count)
+	{
+		// Start before the last character, so that a final newline does not count.
+		long pos = size - 1;
+		char buffer[LOG_RECALL_BUFSIZ];
+		U32 nlines = 0;
+		while (pos > 0 && nlines < count)
+		{
+			// Read the LOG_RECALL_BUFSIZ characters before pos.
+			long chunk = llmin(LOG_RECALL_BUFSIZ, pos);
+			pos -= chunk;
+			if (fseek(log, pos, SEEK_SET) || fread(buffer, 1, chunk, log) != (size_t)chunk)
+			{
+				return -1;
+			}
+			for (char const* p = buffer + chunk - 1; p >= buffer; --p)
+			{
+				if (*p == '\n' && ++nlines == count)
+				{
+					pos += p - buffer + 1;
+					break;
+				}
+			}
+		}
+		return pos;
+	}
+}
+
+LLLogChatWriter::LLLogChatWriter()
+:	LLThread("Chat log writer"),
+	mFlushRequested(false)
+{
+}
+
+LLLogChatWriter::~LLLogChatWriter()
+{
+	shutdown();
+	flush();
+	closeFiles();
+}
+
+void LLLogChatWriter::run(void)
+{
+	while (true)
+	{
+		// Sleeps until a flush is requested or we are asked to quit.
+		checkPause();
+		if (isQuitting())
+		{
+			break;
+		}
+		flush();
+	}
+}
+
+bool LLLogChatWriter::runCondition(void)
+{
+	LLMutexLock lock(&mQueueMutex);
+	return mFlushRequested;
+}
+
+void LLLogChatWriter::append(const std::string& path, const std::string& line)
+{
+	QueuedLine queued;
+	queued.mPath = path;
+	queued.mText = line;
+	queued.mDate = (U32)time(NULL);
+	LLMutexLock lock(&mQueueMutex);
+	mQueue.push_back(queued);
+}
+
+void LLLogChatWriter::requestFlush()
+{
+	{
+		LLMutexLock lock(&mQueueMutex);
+		if (mQueue.empty())
+		{
+			return;
+		}
+		mFlushRequested = true;
+	}
+	wake();
+}
+
+void LLLogChatWriter::flush()
+{
+	LLMutexLock file_lock(&mFileMutex);
+	line_list_t queue;
+	{
+		LLMutexLock lock(&mQueueMutex);
+		queue.swap(mQueue);
+		mFlushRequested = false;
+	}
+	U32 now = (U32)time(NULL);
+	if (!queue.empty())
+	{
+		// One write per file, keeping the order of the lines within each.
+		std::map<std::string, std::vector<const QueuedLine*> > by_file;
+		for (line_list_t::const_iterator iter = queue.begin(); iter != queue.end(); ++iter)
+		{
+			by_file[iter->mPath].push_back(&*iter);
+		}
+		for (std::map<std::string, std::vector<const QueuedLine*> >::const_iterator iter = by_file.begin();
+			 iter != by_file.end(); ++iter)
+		{
+			writeLines(iter->first, iter->second, now);
+		}
+	}
+	closeIdleFiles(now);
+}
+
+void LLLogChatWriter::closeFiles()
+{
+	LLMutexLock lock(&mFileMutex);
+	while (!mFiles.empty())
+	{
+		closeFile(mFiles.begin());
+	}
+}
+
+LLLogChatWriter::LogFile* LLLogChatWriter::getFile(const std::string& path, U32 now)
+{
+	file_map_t::iterator iter = mFiles.find(path);
+	if (iter != mFiles.end())
+	{
+		iter->second.mLastUsed = now;
+		return &iter->second;
+	}
+
+	if (mFiles.size() >= MAX_OPEN_LOGS)
+	{
+		file_map_t::iterator oldest = mFiles.begin();
+		for (iter = mFiles.begin(); iter != mFiles.end(); ++iter)
+		{
+			if (iter->second.mLastUsed < oldest->second.mLastUsed)
+			{
+				oldest = iter;
+			}
+		}
+		closeFile(oldest);
+	}
+
+	LogFile file;
+	file.mLog = LLFile::fopen(path, "ab");		/*Flawfinder: ignore*/
+	if (!file.mLog)
+	{
+		LL_INFOS() << "Couldn't open chat history log!" << LL_ENDL;
+		return NULL;
+	}
+	fseek(file.mLog, 0, SEEK_END);
+	file.mLogSize = (U64)llmax(ftell(file.mLog), 0L);
+	file.mLineCount = 0;
+	file.mLastUsed = now;
+
+	file.mIndex = LLFile::fopen(getIndexFileName(path), "r+b");		/*Flawfinder: ignore*/
+	index_header_t header;
+	bool valid = false;
+	if (file.mIndex && read_header(file.mIndex, header) && header.mLogSize == file.mLogSize &&
+		!fseek(file.mIndex, 0, SEEK_END))
+	{
+		valid = ftell(file.mIndex) == (long)(sizeof(header) + entry_count(header.mLineCount) * sizeof(index_entry_t));
+	}
+	if (valid)
+	{
+		file.mLineCount = header.mLineCount;
+	}
+	else if (!rebuildIndex(path, file))
+	{
+		LL_WARNS() << "Couldn't index chat history log " << path << LL_ENDL;
+		if (file.mIndex)
+		{
+			LLFile::close(file.mIndex);
+			file.mIndex = NULL;
+		}
+	}
+	LogFile& stored = mFiles[path];
+	stored = file;
+	return &stored;
+}
+
+bool LLLogChatWriter::rebuildIndex(const std::string& path, LogFile& file)
+{
+	if (file.mIndex)
+	{
+		LLFile::close(file.mIndex);
+	}
+	file.mIndex = LLFile::fopen(getIndexFileName(path), "w+b");		/*Flawfinder: ignore*/
+	if (!file.mIndex)
+	{
+		return false;
+	}
+
+	std::vector<index_entry_t> entries;
+	U64 offset = 0;
+	U64 line_start = 0;
+	U32 line = 0;
+	LLFILE* log = LLFile::fopen(path, "rb");		/*Flawfinder: ignore*/
+	if (log)
+	{
+		char buffer[LOG_RECALL_BUFSIZ];
+		size_t len;
+		while ((len = fread(buffer, 1, sizeof(buffer), log)) > 0)
+		{
+			for (size_t i = 0; i < len; ++i)
+			{
+				if (buffer[i] == '\n')
+				{
+					if (line % INDEX_INTERVAL == 0)
+					{
+						entries.push_back(make_entry(line_start, line, 0));
+					}
+					++line;
+					line_start = offset + i + 1;
+				}
+			}
+			offset += len;
+		}
+		LLFile::close(log);
+	}
+	// Appends go after what was scanned, whatever ftell() said before.
+	file.mLogSize = offset;
+	file.mLineCount = line;
+	bool success = write_header(file.mIndex, offset, line) &&
+				   (entries.empty() || fwrite(&entries[0], sizeof(index_entry_t), entries.size(), file.mIndex) == entries.size());
+	fflush(file.mIndex);
+	return success;
+}
+
+void LLLogChatWriter::writeLines(const std::string& path, const std::vector<const QueuedLine*>& lines, U32 now)
+{
+	LogFile* file = getFile(path, now);
+	if (!file)
+	{
+		return;
+	}
+
+	// A line may contain newlines itself; the index counts lines as they are in the file.
+	std::string buffer;
+	std::vector<index_entry_t> entries;
+	U32 line = file->mLineCount;
+	for (std::vector<const QueuedLine*>::const_iterator iter = lines.begin(); iter != lines.end(); ++iter)
+	{
+		const std::string& text = (*iter)->mText;
+		U64 start = file->mLogSize + buffer.size();
+		if (line % INDEX_INTERVAL == 0)
+		{
+			entries.push_back(make_entry(start, line, (*iter)->mDate));
+		}
+		for (size_t i = 0; i < text.size(); ++i)
+		{
+			if (text[i] == '\n' && ++line % INDEX_INTERVAL == 0)
+			{
+				entries.push_back(make_entry(start + i + 1, line, (*iter)->mDate));
+			}
+		}
+		buffer += text;
+		buffer += LOG_EOL;
+		++line;
+	}
+
+	if (fwrite(buffer.data(), 1, buffer.size(), file->mLog) != buffer.size() || fflush(file->mLog))
+	{
+		// The index no longer matches and gets rebuilt on the next open.
+		LL_WARNS() << "Couldn't write to chat history log " << path << LL_ENDL;
+		closeFile(mFiles.find(path));
+		return;
+	}
+	file->mLogSize += buffer.size();
+	file->mLineCount = line;
+
+	if (file->mIndex)
+	{
+		bool success = !fseek(file->mIndex, 0, SEEK_END) &&
+					   (entries.empty() || fwrite(&entries[0], sizeof(index_entry_t), entries.size(), file->mIndex) == entries.size()) &&
+					   write_header(file->mIndex, file->mLogSize, file->mLineCount);
+		if (fflush(file->mIndex) || !success)
+		{
+			LLFile::close(file->mIndex);
+			file->mIndex = NULL;
+		}
+	}
+}
+
+void LLLogChatWriter::closeFile(file_map_t::iterator iter)
+{
+	LLFile::close(iter->second.mLog);
+	if (iter->second.mIndex)
+	{
+		LLFile::close(iter->second.mIndex);
+	}
+	mFiles.erase(iter);
+}
+
+void LLLogChatWriter::closeIdleFiles(U32 now)
+{
+	file_map_t::iterator iter = mFiles.begin();
+	while (iter != mFiles.end())
+	{
+		file_map_t::iterator cur = iter++;
+		if (now - cur->second.mLastUsed > LOG_IDLE_CLOSE_SECONDS)
+		{
+			closeFile(cur);
+		}
+	}
+}
+
+bool LLLogChatWriter::readTail(const std::string& path, U32 count, std::vector<std::string>& lines)
+{
+	flush();
+	LLMutexLock lock(&mFileMutex);
+	lines.clear();
+
+	LLFILE* log = LLFile::fopen(path, "rb");		/*Flawfinder: ignore*/
+	if (!log)
+	{
+		return false;
+	}
+	long size = -1;
+	if (!fseek(log, 0, SEEK_END))
+	{
+		size = ftell(log);
+	}
+	if (size <= 0)
+	{
+		LLFile::close(log);
+		return false;
+	}
+
+	// Where the lines to return start, and how many lines to skip from there.
+	long start = -1;
+	U32 skip = 0;
+	LLFILE* index = count ? LLFile::fopen(getIndexFileName(path), "rb") : NULL;		/*Flawfinder: ignore*/
+	if (index)
+	{
+		index_header_t header;
+		index_entry_t entry;
+		if (read_header(index, header) && header.mLogSize == (U64)size && header.mLineCount)
+		{
+			U32 first = header.mLineCount > count ? header.mLineCount - count : 0;
+			if (!fseek(index, sizeof(header) + (first / INDEX_INTERVAL) * sizeof(entry), SEEK_SET) &&
+				fread(&entry, sizeof(entry), 1, index) == 1 &&
+				entry.mLine == first - first % INDEX_INTERVAL && entry.mOffset < (U64)size)
+			{
+				start = (long)entry.mOffset;
+				skip = first - entry.mLine;
+			}
+		}
+		LLFile::close(index);
+	}
+	if (start < 0)
+	{
+		start = count ? find_tail_start(log, size, count) : size;
+	}
+
+	bool success = start >= 0;
+	if (success && start < size)
+	{
+		std::string data(size - start, '\0');
+		success = !fseek(log, start, SEEK_SET) && fread(&data[0], 1, data.size(), log) == data.size();
+		size_t pos = 0;
+		while (success && pos < data.size())
+		{
+			size_t end = data.find('\n', pos);
+			if (end == std::string::npos)
+			{
+				end = data.size();
+			}
+			if (skip)
+			{
+				--skip;
+			}
+			else
+			{
+				size_t len = end - pos;
+				while (len && data[pos + len - 1] == '\r')
+				{
+					--len;
+				}
+				lines.push_back(data.substr(pos, len));
+			}
+			pos = end + 1;
+		}
+	}
+	LLFile::close(log);
+	return success;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file lllogchatwriter.h
+ * @brief Background writer and line index for chat and IM transcripts.
+ *
+ * $LicenseInfo:firstyear=2002&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLLOGCHATWRITER_H
+#define LL_LLLOGCHATWRITER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llfile.h"
+#include "llthread.h"
+
+// Appends lines to transcript files from its own thread. Files are kept open
+// between writes and the lines queued since the last flush are written with
+// one write per file.
+//
+// Next to each transcript, <name>.idx holds the offset and date of every
+// INDEX_INTERVAL-th line, so the end of a long transcript is found with two
+// seeks instead of a backward scan. An index that does not match the size of
+// its transcript (written by an older viewer, edited, cut short by a crash)
+// is rebuilt the next time the transcript is appended to, and ignored until
+// then.
+class LLLogChatWriter : public LLThread
+{
+public:
+	LLLogChatWriter();
+	// Stops the thread, then writes out what is still queued.
+	~LLLogChatWriter();
+
+	// Queues line for appending to the transcript at path. Thread safe.
+	void append(const std::string& path, const std::string& line);
+	// Asks the thread to write out the queued lines.
+	void requestFlush();
+	// Writes out the queued lines on the calling thread.
+	void flush();
+	// Closes all open files; they are reopened when needed.
+	void closeFiles();
+
+	// Returns the last count lines of the transcript at path, oldest first,
+	// after writing out what is queued. Returns false if the transcript is
+	// missing or empty.
+	bool readTail(const std::string& path, U32 count, std::vector<std::string>& lines);
+
+	static std::string getIndexFileName(const std::string& path) { return path + ".idx"; }
+
+	static const U32 INDEX_INTERVAL = 16;
+
+protected:
+	/*virtual*/ void run(void);
+	/*virtual*/ bool runCondition(void);
+
+private:
+	struct QueuedLine
+	{
+		std::string mPath;
+		std::string mText;
+		U32 mDate;
+	};
+	typedef std::vector<QueuedLine> line_list_t;
+
+	struct LogFile
+	{
+		LLFILE* mLog;
+		LLFILE* mIndex;
+		U64 mLogSize;		// covered by the index
+		U32 mLineCount;
+		U32 mLastUsed;
+	};
+	typedef std::map<std::string, LogFile> file_map_t;
+
+	// Called with mFileMutex locked.
+	LogFile* getFile(const std::string& path, U32 now);
+	void writeLines(const std::string& path, const std::vector<const QueuedLine*>& lines, U32 now);
+	bool rebuildIndex(const std::string& path, LogFile& file);
+	void closeFile(file_map_t::iterator iter);
+	void closeIdleFiles(U32 now);
+
+private:
+	LLMutex mQueueMutex;
+	line_list_t mQueue;
+	bool mFlushRequested;
+
+	LLMutex mFileMutex;
+	file_map_t mFiles;
+};
+
+#endif // LL_LLLOGCHATWRITER_H
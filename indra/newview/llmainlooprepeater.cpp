@@ -47,8 +47,8 @@ void LLMainLoopRepeater::start(void)
 	if(mQueue != 0) return;
 
 	mQueue = new LLThreadSafeQueue<LLSD>(1024);
-	mMainLoopConnection = LLEventPumps::instance().
-		obtain("mainloop").listen(LLEventPump::inventName(), boost::bind(&LLMainLoopRepeater::onMainLoop, this, _1));
+	mMainLoopConnection = LLMainloopEvent::channel().
+		listen("LLMainLoopRepeater", boost::bind(&LLMainLoopRepeater::onMainLoop, this, _1));
 	mRepeaterConnection = LLEventPumps::instance().
 		obtain("mainlooprepeater").listen(LLEventPump::inventName(), boost::bind(&LLMainLoopRepeater::onMessage, this, _1));
 }
@@ -56,7 +56,7 @@ void LLMainLoopRepeater::start(void)
 
 void LLMainLoopRepeater::stop(void)
 {
-	mMainLoopConnection.release();
+	mMainLoopConnection.disconnect();
 	mRepeaterConnection.release();
 
 	delete mQueue;
@@ -64,7 +64,7 @@ void LLMainLoopRepeater::stop(void)
 }
 
 
-bool LLMainLoopRepeater::onMainLoop(LLSD const &)
+bool LLMainLoopRepeater::onMainLoop(LLMainloopEvent const &)
 {
 	LLSD message;
 	while(mQueue->tryPopBack(message)) {
@@ -28,6 +28,7 @@
 #define LL_LLMAINLOOPREPEATER_H
 
 
+#include "lleventchannel.h"
 #include "llsd.h"
 #include "llthreadsafequeue.h"
 
@@ -53,11 +54,11 @@ public:
 	void stop(void);
 	
 private:
-	LLTempBoundListener mMainLoopConnection;
+	LLEventChannel<LLMainloopEvent>::ScopedConnection mMainLoopConnection;
 	LLTempBoundListener mRepeaterConnection;
 	LLThreadSafeQueue<LLSD> * mQueue;
 	
-	bool onMainLoop(LLSD const &);
+	bool onMainLoop(LLMainloopEvent const &);
 	bool onMessage(LLSD const & event);
 };
 
@@ -1067,26 +1067,23 @@ bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* dat
 	U32 header_size = 0;
 	if (data_size > 0)
 	{
-		std::string res_str((char*) data, data_size);
-
-		std::string deprecated_header("<? LLSD/Binary ?>");
+		const std::string deprecated_header("<? LLSD/Binary ?>");
 
-		if (res_str.substr(0, deprecated_header.size()) == deprecated_header)
+		if ((size_t)data_size > deprecated_header.size() &&
+			!memcmp(data, deprecated_header.data(), deprecated_header.size()))
 		{
-			res_str = res_str.substr(deprecated_header.size()+1, data_size);
 			header_size = deprecated_header.size()+1;
 		}
-		data_size = res_str.size();
-
-		std::istringstream stream(res_str);
 
-		if (!LLSDSerialize::fromBinary(header, stream, data_size))
+		// Parse in place; the header is followed by the (large) LOD blocks.
+		size_t consumed = 0;
+		if (LLSDSerialize::fromBinary(header, data + header_size, data_size - header_size, &consumed) <= 0)
 		{
 			LL_WARNS() << "Mesh header parse error.  Not a valid mesh asset!" << LL_ENDL;
 			return false;
 		}
 
-		header_size += stream.tellg();
+		header_size += consumed;
 	}
 	else
 	{
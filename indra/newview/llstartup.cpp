@@ -777,6 +777,12 @@ bool idle_startup()
 				msg->mPacketRing->setUseOutThrottle(TRUE);
 				msg->mPacketRing->setOutBandwidth(outBandwidth);
 			}
+
+			std::string capture_file = gSavedSettings.getString("PacketCaptureFile");
+			if (!capture_file.empty())
+			{
+				msg->mPacketRing->startCapture(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, capture_file));
+			}
 		}
 
 		LL_INFOS("AppInit") << "Message System Initialized." << LL_ENDL;
@@ -863,6 +869,19 @@ bool idle_startup()
 		//set_startup_status(0.03f, msg.c_str(), gAgent.mMOTD);
 		display_startup();
 		// LLViewerMedia::initBrowser();
+
+		// Replay a packet capture through the message handlers instead of
+		// logging in, before there is any circuit the replay could disturb.
+		std::string replay_file = gSavedSettings.getString("PacketReplayFile");
+		if (!replay_file.empty())
+		{
+			register_viewer_callbacks(gMessageSystem);
+			F64 seconds;
+			gMessageSystem->replayPacketCapture(gDirUtilp->getExpandedFilename(LL_PATH_LOGS, replay_file), seconds);
+			LLAppViewer::instance()->forceQuit();
+			return FALSE;
+		}
+
 		LLStartUp::setStartupState( STATE_LOGIN_SHOW );
 		return FALSE;
 	}
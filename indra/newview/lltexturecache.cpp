@@ -748,6 +748,12 @@ LLTextureCache::LLTextureCache(bool threaded)
 
 LLTextureCache::~LLTextureCache()
 {
+	if (mDecodedCache.isEnabled())
+	{
+		LL_INFOS("TextureCache") << "Decoded texture cache: " << mDecodedCache.getHits() << " hits, "
+								 << mDecodedCache.getMisses() << " misses, "
+								 << mDecodedCache.getBytesSaved() / 1024 << " KB of J2C not decoded" << LL_ENDL;
+	}
 	clearDeleteList();
 	writeUpdatedEntries();
 }
@@ -883,6 +889,7 @@ const char* cache_filename = "texture.cache";
 const char* old_textures_dirname = "textures";
 //change the location of the texture cache to prevent from being deleted by old version viewers.
 const char* textures_dirname = "texturecache";
+const char* decoded_dirname = "decoded";
 
 void LLTextureCache::setDirNames(ELLPath location)
 {
@@ -982,6 +989,59 @@ U64 LLTextureCache::initCache(ELLPath location, U64 max_size, BOOL texture_cache
 	return max_size; // unused cache space
 }
 
+void LLTextureCache::initDecodedCache(U64 max_size)
+{
+	std::string dirname = mTexturesDirName + gDirUtilp->getDirDelimiter() + decoded_dirname;
+	mDecodedCache.initCache(dirname, max_size, mReadOnly);
+}
+
+// Compressing a large texture takes tens of milliseconds, too long for the fetch thread.
+class LLDecodedCacheWriteRequest : public LLQueuedThread::QueuedRequest
+{
+protected:
+	/*virtual*/ ~LLDecodedCacheWriteRequest() { }
+
+public:
+	LLDecodedCacheWriteRequest(LLQueuedThread::handle_t handle, LLDecodedTextureCache* cache,
+							   const LLUUID& id, LLImageRaw* raw, S32 discard, S32 codestream_size)
+		: LLQueuedThread::QueuedRequest(handle, LLQueuedThread::PRIORITY_LOW, LLQueuedThread::FLAG_AUTO_COMPLETE),
+		  mCache(cache),
+		  mID(id),
+		  mRawImage(raw),
+		  mDiscard(discard),
+		  mCodestreamSize(codestream_size)
+	{
+	}
+
+	/*virtual*/ bool processRequest()
+	{
+		// A better level may have been written since this one was queued.
+		if (mCache->wantsWrite(mID, mDiscard, mRawImage))
+		{
+			mCache->write(mID, mRawImage, mDiscard, mCodestreamSize);
+		}
+		return true;
+	}
+
+private:
+	LLDecodedTextureCache* mCache;
+	LLUUID mID;
+	LLPointer<LLImageRaw> mRawImage;
+	S32 mDiscard;
+	S32 mCodestreamSize;
+};
+
+void LLTextureCache::writeToDecodedCache(const LLUUID& id, LLImageRaw* raw, S32 discard, S32 codestream_size)
+{
+	if (!mDecodedCache.wantsWrite(id, discard, raw))
+	{
+		return;
+	}
+	// The main thread gets raw as soon as the fetch is done, and may change it.
+	LLPointer<LLImageRaw> copy = new LLImageRaw(raw->getData(), raw->getWidth(), raw->getHeight(), raw->getComponents());
+	addRequest(new LLDecodedCacheWriteRequest(generateHandle(), &mDecodedCache, id, copy, discard, codestream_size));
+}
+
 //----------------------------------------------------------------------------
 // mHeaderMutex must be locked for the following functions!
 
@@ -1505,11 +1565,18 @@ void LLTextureCache::clearCorruptedCache()
 
 void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
+	mDecodedCache.purge();
 	if (!mReadOnly)
 	{
 		const char* subdirs = "0123456789abcdef";
 		std::string delem = gDirUtilp->getDirDelimiter();
 		std::string mask = "*";
+		std::string decoded_dir = mTexturesDirName + delem + decoded_dirname;
+		gDirUtilp->deleteFilesInDir(decoded_dir, mask);
+		if (purge_directories)
+		{
+			LLFile::rmdir(decoded_dir);
+		}
 		for (S32 i=0; i<16; i++)
 		{
 			std::string dirname = mTexturesDirName + delem + subdirs[i];
@@ -1936,6 +2003,7 @@ bool LLTextureCache::removeFromCache(const LLUUID& id)
 
 		unlockHeaders();
 	}
+	mDecodedCache.remove(id);
 	return ret;
 }
 
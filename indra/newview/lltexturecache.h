@@ -33,8 +33,10 @@
 #include "lluuid.h"
 
 #include "llworkerthread.h"
+#include "lldecodedtexturecache.h"
 
 class LLImageFormatted;
+class LLImageRaw;
 class LLTextureCacheWorker;
 
 class LLTextureCache : public LLWorkerThread
@@ -120,6 +122,12 @@ public:
 
 	bool removeFromCache(const LLUUID& id);
 
+	// Called after initCache(); a max_size of 0 leaves the decoded cache off.
+	void initDecodedCache(U64 max_size);
+	LLDecodedTextureCache& getDecodedCache() { return mDecodedCache; }
+	// Compresses a copy of raw into the decoded cache on the cache thread.
+	void writeToDecodedCache(const LLUUID& id, LLImageRaw* raw, S32 discard, S32 codestream_size);
+
 	// For LLTextureCacheWorker::Responder
 	LLTextureCacheWorker* getReader(handle_t handle);
 	LLTextureCacheWorker* getWriter(handle_t handle);
@@ -207,6 +215,9 @@ private:
 	typedef std::map<S32, Entry> idx_entry_map_t;
 	idx_entry_map_t mUpdatedEntryMap;
 
+	// Second tier: decoded textures
+	LLDecodedTextureCache mDecodedCache;
+
 	// Statics
 	static F32 sHeaderCacheVersion;
 	static U32 sCacheMaxEntries;
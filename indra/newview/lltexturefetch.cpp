@@ -73,6 +73,9 @@ extern AIHTTPTimeoutPolicy assetReportHandler_timeout;
 
 LLStat LLTextureFetch::sCacheHitRate("texture_cache_hits", 128);
 LLStat LLTextureFetch::sCacheReadLatency("texture_cache_read_latency", 128);
+LLStat LLTextureFetch::sDecodedCacheHitRate("texture_decoded_cache_hits", 128);
+LLStat LLTextureFetch::sDecodedCacheLatency("texture_decoded_cache_latency", 128);
+LLStat LLTextureFetch::sDecodedCacheSaved("texture_decoded_cache_saved", 128);
 
 //////////////////////////////////////////////////////////////////////////////
 // Log scope
@@ -213,6 +216,21 @@ private:
 	void removeFromCache();
 	bool processSimulatorPackets();
 	bool writeToCacheComplete();
+
+	// Threads:  Ttf
+	// Trades the estimated mDesiredSize for the exact one once the J2C header is in.
+	void updateDesiredSizeFromHeader();
+
+	// Threads:  Ttf
+	// Takes the texture from the decoded texture cache, skipping the J2C read
+	// and decode. Returns false when it is not there at mDesiredDiscard.
+	bool loadFromDecodedCache();
+
+	// Threads:  Ttf
+	// Queues the full texture for the decoded texture cache.
+	void writeToDecodedCache();
+
+	bool canUseDecodedCache() const;
 	
 	// Threads:  Ttf
 	void recordTextureStart(bool is_http);
@@ -1111,6 +1129,10 @@ bool LLTextureFetchWorker::doWork(S32 param)
 	{
 		if (mCacheReadHandle == LLTextureCache::nullHandle())
 		{
+			if (mFormattedImage.isNull() && loadFromDecodedCache())
+			{
+				return true;
+			}
 			U32 cache_priority = mWorkPriority;
 			S32 offset = mFormattedImage.notNull() ? mFormattedImage->getDataSize() : 0;
 			S32 size = mDesiredSize - offset;
@@ -1188,6 +1210,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 	if (mState == CACHE_POST)
 	{
 		mCachedSize = mFormattedImage.notNull() ? mFormattedImage->getDataSize() : 0;
+		updateDesiredSizeFromHeader();
 		// Successfully loaded
 		if ((mCachedSize >= mDesiredSize) || mHaveAllData)
 		{
@@ -1426,6 +1449,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 
 		mFetcher->removeFromNetworkQueue(this, false);
 
+		updateDesiredSizeFromHeader();
 		mRequestedSize = mDesiredSize;
 		mRequestedDiscard = mDesiredDiscard;
 		mRequestedSize -= cur_size;
@@ -1743,6 +1767,17 @@ bool LLTextureFetchWorker::doWork(S32 param)
 			}
 			// NOTE: setData releases current data and owns new data (buffer)
 			mFormattedImage->setData(buffer, total_size);
+			if (mFormattedImage->getCodec() == IMG_CODEC_J2C)
+			{
+				// The codestream knows its own size: record that, so the cache
+				// entry tells exactly how much of the image it holds.
+				S32 codestream_size = static_cast<LLImageJ2C*>(mFormattedImage.get())->getIndex().getCodestreamSize();
+				if (!mHaveAllData && codestream_size >= total_size)
+				{
+					mFileSize = codestream_size;
+					mHaveAllData = (total_size == codestream_size);
+				}
+			}
 			// delete temp data
 			std::vector<U8>().swap(mHttpBuffer);
 			mHttpReplySize = 0;
@@ -1851,6 +1886,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 				llassert_always(mRawImage.notNull());
 				LL_DEBUGS(LOG_TXT) << mID << ": Decoded. Discard: " << mDecodedDiscard
 						<< " Raw Image: " << llformat("%dx%d",mRawImage->getWidth(),mRawImage->getHeight()) << LL_ENDL;
+				writeToDecodedCache();
 				setPriority(LLWorkerThread::PRIORITY_HIGH | mWorkPriority);
 				setState(WRITE_TO_CACHE);
 			}
@@ -2263,6 +2299,78 @@ void LLTextureFetchWorker::callbackDecoded(bool success, LLImageRaw* raw, LLImag
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Only plain textures by id: bakes and map tiles change under the same id,
+// and sculpt maps need the aux channel that is not kept.
+bool LLTextureFetchWorker::canUseDecodedCache() const
+{
+	return mFTType == FTT_DEFAULT && mUrl.empty() && !mNeedsAux &&
+		   mFetcher->mTextureCache->getDecodedCache().isEnabled();
+}
+
+// Threads:  Ttf
+// Locks:  Mw
+bool LLTextureFetchWorker::loadFromDecodedCache()
+{
+	if (!canUseDecodedCache() || mDesiredDiscard < 0)
+	{
+		return false;
+	}
+	LLTimer timer;
+	LLPointer<LLImageRaw> raw;
+	S32 codestream_size = 0;
+	bool hit = mFetcher->mTextureCache->getDecodedCache().read(mID, mDesiredDiscard, raw, codestream_size);
+	LLTextureFetch::sDecodedCacheHitRate.addValue(hit ? 100.f : 0.f);
+	if (!hit)
+	{
+		return false;
+	}
+	mRawImage = raw;
+	mAuxImage = NULL;
+	mLoadedDiscard = mDesiredDiscard;
+	mDecodedDiscard = mDesiredDiscard;
+	mDecoded = TRUE;
+	mFileSize = codestream_size;
+	mCacheReadTime = 0.f;
+	mWriteToCacheState = NOT_WRITE;
+	LLTextureFetch::sCacheHitRate.addValue(100.f);
+	LLTextureFetch::sDecodedCacheLatency.addValue(timer.getElapsedTimeF32() * 1000.f);
+	LLTextureFetch::sDecodedCacheSaved.addValue(codestream_size / 1024.f);
+	LL_DEBUGS(LOG_TXT) << mID << ": Decoded cache hit. Discard: " << mDecodedDiscard
+					   << " Raw Image: " << llformat("%dx%d", mRawImage->getWidth(), mRawImage->getHeight()) << LL_ENDL;
+	setState(DONE);
+	return true;
+}
+
+// Threads:  Ttf
+// Locks:  Mw
+void LLTextureFetchWorker::writeToDecodedCache()
+{
+	// Only the full texture: the lower levels are read from its entry, and
+	// each level on the way would cost a compress of its own.
+	if (!canUseDecodedCache() || mFormattedImage.isNull() || !mHaveAllData)
+	{
+		return;
+	}
+	mFetcher->mTextureCache->writeToDecodedCache(mID, mRawImage, mDecodedDiscard, mFormattedImage->getDataSize());
+}
+
+// Threads:  Ttf
+// Locks:  Mw
+void LLTextureFetchWorker::updateDesiredSizeFromHeader()
+{
+	if (mFormattedImage.isNull() || mFormattedImage->getCodec() != IMG_CODEC_J2C)
+	{
+		return;
+	}
+	S32 exact_size = static_cast<LLImageJ2C*>(mFormattedImage.get())->getIndex().getDataSize(mDesiredDiscard);
+	if (exact_size > 0 && exact_size != mDesiredSize)
+	{
+		LL_DEBUGS(LOG_TXT) << mID << ": Discard " << mDesiredDiscard << " needs " << exact_size
+							 << " bytes, estimated " << mDesiredSize << LL_ENDL;
+		mDesiredSize = exact_size;
+	}
+}
+
 bool LLTextureFetchWorker::writeToCacheComplete()
 {
 	// Complete write to cache
@@ -2668,6 +2776,31 @@ bool LLTextureFetch::updateRequestPriority(const LLUUID& id, F32 priority)
 	return res;
 }
 
+void LLTextureFetch::updateRequestPriorities(const request_priority_list_t& priorities)
+{
+	typedef std::vector<std::pair<LLTextureFetchWorker*, F32> > worker_priority_list_t;
+	worker_priority_list_t workers;
+	workers.reserve(priorities.size());
+	{
+		LLMutexLock lock(&mQueueMutex);
+		for (request_priority_list_t::const_iterator iter = priorities.begin(); iter != priorities.end(); ++iter)
+		{
+			LLTextureFetchWorker* worker = getWorkerAfterLock(iter->first);
+			if (worker)
+			{
+				workers.push_back(std::make_pair(worker, iter->second));
+			}
+		}
+	}
+	for (worker_priority_list_t::iterator iter = workers.begin(); iter != workers.end(); ++iter)
+	{
+		LLTextureFetchWorker* worker = iter->first;
+		worker->lockWorkMutex();
+		worker->setImagePriority(iter->second);
+		worker->unlockWorkMutex();
+	}
+}
+
 //
 // May be called from any thread
 
@@ -77,6 +77,11 @@ public:
 							LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux);
 	bool updateRequestPriority(const LLUUID& id, F32 priority);
 
+	// Same as calling updateRequestPriority() for each entry, but looks all
+	// the workers up under a single lock of the request queue.
+	typedef std::vector<std::pair<LLUUID, F32> > request_priority_list_t;
+	void updateRequestPriorities(const request_priority_list_t& priorities);
+
 	bool receiveImageHeader(const LLHost& host, const LLUUID& id, U8 codec, U16 packets, U32 totalbytes, U16 data_size, U8* data);
 	bool receiveImagePacket(const LLHost& host, const LLUUID& id, U16 packet_num, U16 data_size, U8* data);
 
@@ -153,6 +158,9 @@ private:
 public:
 	static LLStat sCacheHitRate;
 	static LLStat sCacheReadLatency;
+	static LLStat sDecodedCacheHitRate;
+	static LLStat sDecodedCacheLatency;
+	static LLStat sDecodedCacheSaved;	// KB of J2C not read and decoded, per hit
 private:
 
 	LLTextureCache* mTextureCache;
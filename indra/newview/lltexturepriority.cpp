@@ -0,0 +1,215 @@
+/**
+ * @file lltexturepriority.cpp
+ * @brief Decode priority calculation for fetched textures, over flat arrays.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturepriority.h"
+
+#include "llgltexture.h"
+#include "llimage.h"
+
+const F32 MAX_PRIORITY_PIXEL                         = 999.f;     //pixel area
+const F32 PRIORITY_BOOST_LEVEL_FACTOR                = 1000.f;    //boost level
+const F32 PRIORITY_DELTA_DISCARD_LEVEL_FACTOR        = 100000.f;  //delta discard
+const S32 MAX_DELTA_DISCARD_LEVEL_FOR_PRIORITY       = 4;
+const F32 PRIORITY_ADDITIONAL_FACTOR                 = 1000000.f; //additional
+const S32 MAX_ADDITIONAL_LEVEL_FOR_PRIORITY          = 8;
+const F32 PRIORITY_BOOST_HIGH_FACTOR                 = 10000000.f;//boost high
+
+//static
+F32 LLTexturePriority::calcPriority(const LLTexturePriorityInput& input, S32 min_large_image_size, F32& additional_priority)
+{
+	additional_priority = input.mAdditionalPriority;
+
+	if (input.mFlags & LLTexturePriorityInput::NEEDS_CREATE)
+	{
+		return input.mDecodePriority; // no change while waiting to create
+	}
+	if ((input.mFlags & LLTexturePriorityInput::FULLY_LOADED) && !(input.mFlags & LLTexturePriorityInput::FORCE_SAVE_RAW))//already loaded for static texture
+	{
+		return -1.0f; //alreay fetched
+	}
+
+	const S32 cur_discard = input.mCurDiscard;
+	const S32 boost_level = input.mBoostLevel;
+	const bool cached_raw_ready = (input.mFlags & LLTexturePriorityInput::CACHED_RAW_READY) != 0;
+	bool have_all_data = (cur_discard >= 0 && (cur_discard <= input.mDesiredDiscard));
+	F32 pixel_priority = (F32) sqrt(input.mMaxVirtualSize);
+
+	F32 priority = 0.f;
+
+	if (input.mFlags & LLTexturePriorityInput::MISSING_ASSET)
+	{
+		priority = 0.0f;
+	}
+	else if(input.mDesiredDiscard >= cur_discard && cur_discard > -1)
+	{
+		priority = -2.0f;
+	}
+	else if(input.mCachedRawDiscard > -1 && input.mDesiredDiscard >= input.mCachedRawDiscard)
+	{
+		priority = -3.0f;
+	}
+	else if (input.mDesiredDiscard > input.mMaxDiscard)
+	{
+		// Don't decode anything we don't need
+		priority = -4.0f;
+	}
+	else if ((boost_level == LLGLTexture::BOOST_UI || boost_level == LLGLTexture::BOOST_ICON) && !have_all_data)
+	{
+		priority = 1.f;
+	}
+	else if (pixel_priority < 0.001f && !have_all_data)
+	{
+		// Not on screen but we might want some data
+		if (boost_level > LLGLTexture::BOOST_HIGH)
+		{
+			// Always want high boosted images
+			priority = 1.f;
+		}
+		else
+		{
+			priority = -5.f; //stop fetching
+		}
+	}
+	else if (cur_discard < 0)
+	{
+		//texture does not have any data, so we don't know the size of the image, treat it like 32 * 32.
+		// priority range = 100,000 - 500,000
+		static const F64 log_2 = log(2.0);
+		F32 desired = (F32)(log(32.0/pixel_priority) / log_2);
+		S32 ddiscard = MAX_DISCARD_LEVEL - (S32)desired;
+		ddiscard = llclamp(ddiscard, 0, MAX_DELTA_DISCARD_LEVEL_FOR_PRIORITY);
+		priority = (ddiscard + 1) * PRIORITY_DELTA_DISCARD_LEVEL_FACTOR;
+		additional_priority = 1.0f;//boost the textures without any data so far.
+	}
+	else if ((input.mMinDiscard > 0) && (cur_discard <= input.mMinDiscard))
+	{
+		// larger mips are corrupted
+		priority = -6.0f;
+	}
+	else
+	{
+		// priority range = 100,000 - 500,000
+		S32 desired_discard = input.mDesiredDiscard;
+		if (!(input.mFlags & LLTexturePriorityInput::JUST_BOUND) && cached_raw_ready)
+		{
+			if(boost_level < LLGLTexture::BOOST_HIGH)
+			{
+				// We haven't rendered this in a while, de-prioritize it
+				desired_discard += 2;
+			}
+			else
+			{
+				// We haven't rendered this in the last half second, and we have a cached raw image, leave the desired discard as-is
+				desired_discard = cur_discard;
+			}
+		}
+
+		S32 ddiscard = cur_discard - desired_discard;
+		ddiscard = llclamp(ddiscard, -1, MAX_DELTA_DISCARD_LEVEL_FOR_PRIORITY);
+		priority = (ddiscard + 1) * PRIORITY_DELTA_DISCARD_LEVEL_FACTOR;
+	}
+
+	if (priority > 0.0f)
+	{
+		bool large_enough = cached_raw_ready && ((S32)input.mTexelsPerImage > min_large_image_size);
+		if(large_enough)
+		{
+			//Note:
+			//to give small, low-priority textures some chance to be fetched,
+			//cut the priority in half if the texture size is larger than 256 * 256 and has a 64*64 ready.
+			priority *= 0.5f;
+		}
+
+		pixel_priority = llclamp(pixel_priority, 0.0f, MAX_PRIORITY_PIXEL);
+
+		priority += pixel_priority + PRIORITY_BOOST_LEVEL_FACTOR * boost_level;
+
+		if (boost_level > LLGLTexture::BOOST_HIGH)
+		{
+			if(boost_level > LLGLTexture::BOOST_SUPER_HIGH)
+			{
+				//for very important textures, always grant the highest priority.
+				priority += PRIORITY_BOOST_HIGH_FACTOR;
+			}
+			else if(cached_raw_ready)
+			{
+				//Note:
+				//to give small, low-priority textures some chance to be fetched,
+				//if high priority texture has a 64*64 ready, lower its fetching priority.
+				additional_priority = llmax(additional_priority, 0.5f);
+			}
+			else
+			{
+				priority += PRIORITY_BOOST_HIGH_FACTOR;
+			}
+		}
+
+		if(additional_priority > 0.0f)
+		{
+			// priority range += 1,000,000.f-9,000,000.f
+			F32 additional = PRIORITY_ADDITIONAL_FACTOR * (1.0 + additional_priority * MAX_ADDITIONAL_LEVEL_FOR_PRIORITY);
+			if(large_enough)
+			{
+				//Note:
+				//to give small, low-priority textures some chance to be fetched,
+				//cut the additional priority to a quarter if the texture size is larger than 256 * 256 and has a 64*64 ready.
+				additional *= 0.25f;
+			}
+			priority += additional;
+		}
+	}
+	return priority;
+}
+
+//static
+void LLTexturePriority::calcPriorities(const LLTexturePriorityInput* inputs, LLTexturePriorityOutput* outputs,
+									   S32 count, S32 min_large_image_size)
+{
+	// This stays scalar on purpose. The formula is a chain of branches on
+	// per texture state that mostly go the same way from one texture to the
+	// next, and the only arithmetic worth vectorizing is one square root per
+	// texture; taking those four at a time with SSE measured no faster. What
+	// the flat array saves is the cache miss on every LLViewerFetchedTexture,
+	// which is where the time of the old per texture pass went.
+	for (S32 i = 0; i < count; ++i)
+	{
+		outputs[i].mDecodePriority = calcPriority(inputs[i], min_large_image_size, outputs[i].mAdditionalPriority);
+	}
+}
+
+//static
+F32 LLTexturePriority::maxPriority()
+{
+	static const F32 max_priority = PRIORITY_BOOST_HIGH_FACTOR +                           //boost_high
+		PRIORITY_ADDITIONAL_FACTOR * (MAX_ADDITIONAL_LEVEL_FOR_PRIORITY + 1) +             //additional (view dependent factors)
+		PRIORITY_DELTA_DISCARD_LEVEL_FACTOR * (MAX_DELTA_DISCARD_LEVEL_FOR_PRIORITY + 1) + //delta discard
+		PRIORITY_BOOST_LEVEL_FACTOR * (LLGLTexture::BOOST_MAX_LEVEL - 1) +                 //boost level
+		MAX_PRIORITY_PIXEL + 1.0f;                                                        //pixel area.
+
+	return max_priority;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file lltexturepriority.h
+ * @brief Decode priority calculation for fetched textures, over flat arrays.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTUREPRIORITY_H
+#define LL_LLTEXTUREPRIORITY_H
+
+#include "stdtypes.h"
+
+// Everything LLViewerFetchedTexture::calcDecodePriority() needs, packed so that
+// LLViewerTextureList can keep one entry per texture in a contiguous array and
+// run the priority math for all textures in a single tight loop.
+struct LLTexturePriorityInput
+{
+	enum
+	{
+		NEEDS_CREATE		= 1 << 0,	// waiting for GL creation, keep the old priority
+		FULLY_LOADED		= 1 << 1,
+		FORCE_SAVE_RAW		= 1 << 2,
+		MISSING_ASSET		= 1 << 3,
+		CACHED_RAW_READY	= 1 << 4,
+		JUST_BOUND			= 1 << 5
+	};
+
+	F32 mMaxVirtualSize;			// pixel area
+	F32 mTexelsPerImage;
+	F32 mAdditionalPriority;		// [0, 1]
+	F32 mDecodePriority;			// current priority
+	S8  mBoostLevel;
+	S8  mCurDiscard;				// getCurrentDiscardLevelForFetching()
+	S8  mDesiredDiscard;
+	S8  mMaxDiscard;
+	S8  mMinDiscard;				// larger mips are corrupted
+	S8  mCachedRawDiscard;
+	U8  mFlags;
+	U8  mPad;
+};
+
+struct LLTexturePriorityOutput
+{
+	F32 mDecodePriority;
+	F32 mAdditionalPriority;		// raised version of the input, never lower
+};
+
+class LLTexturePriority
+{
+public:
+	// Priority Formula:
+	// BOOST_HIGH  +  ADDITIONAL PRI + DELTA DISCARD + BOOST LEVEL + PIXELS
+	// [10,000,000] + [1,000,000-9,000,000]  + [100,000-500,000]   + [1-20,000]  + [0-999]
+	static F32 calcPriority(const LLTexturePriorityInput& input, S32 min_large_image_size, F32& additional_priority);
+
+	// Runs calcPriority() over 'count' entries. Inputs and outputs are plain
+	// arrays so the loop stays in cache and has no virtual calls.
+	static void calcPriorities(const LLTexturePriorityInput* inputs, LLTexturePriorityOutput* outputs,
+							   S32 count, S32 min_large_image_size);
+
+	static F32 maxPriority();
+};
+
+#endif // LL_LLTEXTUREPRIORITY_H
@@ -223,7 +223,9 @@ void display_stats()
 		gRecentFrameCount = 0;
 		gRecentFPSTime.reset();
 	}
-	F32 fps_log_freq = gSavedSettings.getF32("FPSLogFrequency");
+	static LLControlHandle<F32> sFPSLogFrequency(gSavedSettings, "FPSLogFrequency");
+	static LLControlHandle<F32> sMemoryLogFrequency(gSavedSettings, "MemoryLogFrequency");
+	F32 fps_log_freq = sFPSLogFrequency;
 	if (fps_log_freq > 0.f && gRecentFPSTime.getElapsedTimeF32() >= fps_log_freq)
 	{
 		F32 fps = gRecentFrameCount / fps_log_freq;
@@ -235,7 +237,7 @@ void display_stats()
 		gRecentFrameCount = 0;
 		gRecentFPSTime.reset();
 	}
-	F32 mem_log_freq = gSavedSettings.getF32("MemoryLogFrequency");
+	F32 mem_log_freq = sMemoryLogFrequency;
 	if (mem_log_freq > 0.f && gRecentMemoryTime.getElapsedTimeF32() >= mem_log_freq)
 	{
 		gMemoryAllocated = (U64Bytes)LLMemory::getCurrentRSS();
@@ -403,8 +405,10 @@ void display(BOOL rebuild, F32 zoom_factor, int subfield, BOOL for_snapshot, boo
 
 	LLImageGL::updateStats(gFrameTimeSeconds);
 	
-	LLVOAvatar::sRenderName = gSavedSettings.getS32("RenderName");
-	LLVOAvatar::sRenderGroupTitles = !gSavedSettings.getBOOL("RenderHideGroupTitleAll");
+	static LLControlHandle<S32> sRenderName(gSavedSettings, "RenderName");
+	static LLControlHandle<bool> sRenderHideGroupTitleAll(gSavedSettings, "RenderHideGroupTitleAll");
+	LLVOAvatar::sRenderName = sRenderName;
+	LLVOAvatar::sRenderGroupTitles = !sRenderHideGroupTitleAll;
 	
 	gPipeline.mBackfaceCull = TRUE;
 	gFrameCount++;
@@ -2187,33 +2187,65 @@ void LLViewerObject::idleUpdate(LLAgent &agent, LLWorld &world, const F64 &time)
 
 	if (!mDead)
 	{
-		if (!mStatic && sVelocityInterpolate && !isSelected())
-		{
-			// calculate dt from last update
-			F32 time_dilation = mRegionp ? mRegionp->getTimeDilation() : 1.0f;
-			F32 dt_raw = ((F64Seconds)time - mLastInterpUpdateSecs).value();
-			F32 dt = time_dilation * dt_raw;
+		LLIdleMotion motion;
+		predictIdleMotion(time, motion);
+		applyIdleMotion(time, motion);
+	}
+}
 
-			applyAngularVelocity(dt);
+// Only reads this object, so the object list may run it for many objects in parallel.
+void LLViewerObject::predictIdleMotion(const F64 &time, LLIdleMotion& motion) const
+{
+	motion.mInterpolate = !mDead && !mStatic && sVelocityInterpolate && !isSelected();
+	motion.mRotate = false;
+	motion.mLinear = LLIdleMotion::LINEAR_SKIP;
+	if (!motion.mInterpolate)
+	{
+		return;
+	}
 
-			if (isAttachment())
-			{
-				mLastInterpUpdateSecs = (F64Seconds)time;
-				return;
-			}
-			else
-			{	// Move object based on it's velocity and rotation
-				interpolateLinearMotion(time, dt);
-			}
-		}
+	// calculate dt from last update
+	F32 time_dilation = mRegionp ? mRegionp->getTimeDilation() : 1.0f;
+	F32 dt_raw = ((F64Seconds)time - mLastInterpUpdateSecs).value();
+	motion.mDt = time_dilation * dt_raw;
+
+	motion.mRotate = predictAngularMotion(motion.mDt, motion.mDeltaRot);
+
+	if (!isAttachment())
+	{
+		motion.mLinear = predictLinearMotion(time, motion.mDt, motion.mDeltaPos, motion.mDeltaVel);
+	}
+}
 
-		updateDrawable(FALSE);
+void LLViewerObject::applyIdleMotion(const F64 &time, const LLIdleMotion& motion)
+{
+	if (mDead)
+	{
+		return;
 	}
+
+	if (motion.mInterpolate)
+	{
+		applyAngularMotion(motion.mDt, motion.mRotate, motion.mDeltaRot);
+
+		if (isAttachment())
+		{
+			mLastInterpUpdateSecs = (F64Seconds)time;
+			return;
+		}
+		else
+		{	// Move object based on it's velocity and rotation
+			applyLinearMotion(time, motion.mLinear, motion.mDeltaPos, motion.mDeltaVel);
+		}
+	}
+
+	updateDrawable(FALSE);
 }
 
 
-// Move an object due to idle-time viewer side updates by interpolating motion
-void LLViewerObject::interpolateLinearMotion(const F64SecondsImplicit& time, const F32SecondsImplicit& dt_seconds)
+// Predict how far an object moves due to idle-time viewer side updates by interpolating motion
+U8 LLViewerObject::predictLinearMotion(const F64SecondsImplicit& time, const F32SecondsImplicit& dt_seconds,
+									   LLVector3& delta_pos, LLVector3& delta_vel) const
 {
 	// linear motion
 	// PHYSICS_TIMESTEP is used below to correct for the fact that the velocity in object
@@ -2228,32 +2260,51 @@ void LLViewerObject::interpolateLinearMotion(const F64SecondsImplicit& time, con
 	F64Seconds time_since_last_update = time - mLastMessageUpdateSecs;
 	if (time_since_last_update <= (F64Seconds)0.0 || dt <= 0.f)
 	{
-		return;
+		return LLIdleMotion::LINEAR_SKIP;
 	}
 
 	LLVector3 accel = getAcceleration();
 	LLVector3 vel 	= getVelocity();
-	
+
+	if (accel.isExactlyZero() && vel.isExactlyZero())
+	{
+		return LLIdleMotion::LINEAR_NONE;
+	}
+
+	// Calculate predicted position and velocity change
+	delta_pos = (vel + (0.5f * (dt-PHYSICS_TIMESTEP)) * accel) * dt;
+	delta_vel = accel * dt;
+
 	if (sMaxUpdateInterpolationTime <= (F64Seconds)0.0)
 	{	// Old code path ... unbounded, simple interpolation
-		if (!(accel.isExactlyZero() && vel.isExactlyZero()))
-		{
-			LLVector3 pos   = (vel + (0.5f * (dt-PHYSICS_TIMESTEP)) * accel) * dt;  
-		
-			// region local  
-			setPositionRegion(pos + getPositionRegion());
-			setVelocity(vel + accel*dt);	
-			
-			// for objects that are spinning but not translating, make sure to flag them as having moved
-			setChanged(MOVED | SILHOUETTE);
-		}
+		return LLIdleMotion::LINEAR_UNBOUNDED;
+	}
+	return LLIdleMotion::LINEAR_BOUNDED;
+}
+
+// Move an object by the motion predicted by predictLinearMotion()
+void LLViewerObject::applyLinearMotion(const F64SecondsImplicit& time, U8 mode,
+									   const LLVector3& delta_pos, const LLVector3& delta_vel)
+{
+	if (mode == LLIdleMotion::LINEAR_SKIP)
+	{
+		return;
 	}
-	else if (!accel.isExactlyZero() || !vel.isExactlyZero())		// object is moving
+
+	if (mode == LLIdleMotion::LINEAR_UNBOUNDED)
+	{
+		// region local  
+		setPositionRegion(delta_pos + getPositionRegion());
+		setVelocity(getVelocity() + delta_vel);	
+
+		// for objects that are spinning but not translating, make sure to flag them as having moved
+		setChanged(MOVED | SILHOUETTE);
+	}
+	else if (mode == LLIdleMotion::LINEAR_BOUNDED)		// object is moving
 	{	// Object is moving, and hasn't been too long since we got an update from the server
-		
-		// Calculate predicted position and velocity
-		LLVector3 new_pos = (vel + (0.5f * (dt-PHYSICS_TIMESTEP)) * accel) * dt;	
-		LLVector3 new_v = accel * dt;
+		LLVector3 new_pos = delta_pos;
+		LLVector3 new_v = delta_vel;
+		F64Seconds time_since_last_update = time - mLastMessageUpdateSecs;
 
 		if (time_since_last_update > sPhaseOutUpdateInterpolationTime &&
 			sPhaseOutUpdateInterpolationTime > (F64Seconds)0.0)
@@ -2306,7 +2357,7 @@ void LLViewerObject::interpolateLinearMotion(const F64SecondsImplicit& time, con
 		}
 
 		new_pos = new_pos + getPositionRegion();
-		new_v = new_v + vel;
+		new_v = new_v + getVelocity();
 
 
 		// Clamp interpolated position to minimum underground and maximum region height
@@ -5690,24 +5741,31 @@ U8 LLViewerObject::getPhysicsShapeType() const
 	return mPhysicsShapeType; 
 }
 
-void LLViewerObject::applyAngularVelocity(F32 dt)
+// Rotation by the angular velocity over dt, false when the object isn't spinning
+bool LLViewerObject::predictAngularMotion(F32 dt, LLQuaternion& dQ) const
 {
-	//do target omega here
-	mRotTime += dt;
 	LLVector3 ang_vel = getAngularVelocity();
 	F32 omega = ang_vel.magVecSquared();
-	F32 angle = 0.0f;
-	LLQuaternion dQ;
 	if (omega > 0.00001f)
 	{
 		omega = sqrt(omega);
-		angle = omega * dt;
+		F32 angle = omega * dt;
 
 		ang_vel *= 1.f/omega;
 		
 		// calculate the delta increment based on the object's angular velocity
 		dQ.setQuat(angle, ang_vel);
+		return true;
+	}
+	return false;
+}
 
+void LLViewerObject::applyAngularMotion(F32 dt, bool rotate, const LLQuaternion& dQ)
+{
+	//do target omega here
+	mRotTime += dt;
+	if (rotate)
+	{
 		static const LLCachedControl<bool> use_new_target_omega ("UseNewTargetOmegaCode", true);
 		if (use_new_target_omega)
 		{
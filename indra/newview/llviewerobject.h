@@ -110,6 +110,27 @@ struct PotentialReturnableObject
 	LLViewerRegion* pRegion;
 };
 
+// Dead reckoning for one idle update. Filled in by LLViewerObject::predictIdleMotion(),
+// which may run on a worker thread, and committed by applyIdleMotion() on the main thread.
+struct LLIdleMotion
+{
+	enum ELinear
+	{
+		LINEAR_SKIP,		// no time has passed, leave position and interpolation time alone
+		LINEAR_NONE,		// not moving, only the interpolation time advances
+		LINEAR_UNBOUNDED,	// InterpolationTime <= 0, plain integration
+		LINEAR_BOUNDED		// phased out when the sim goes quiet and clamped to the known regions
+	};
+
+	F32				mDt;
+	bool			mInterpolate;	// false when the object doesn't interpolate at all this frame
+	bool			mRotate;		// mDeltaRot is valid
+	U8				mLinear;		// ELinear
+	LLQuaternion	mDeltaRot;
+	LLVector3		mDeltaPos;		// region local
+	LLVector3		mDeltaVel;
+};
+
 //============================================================================
 
 class LLViewerObject: public LLPrimitive, public LLRefCount, public LLGLUpdate
@@ -153,6 +174,12 @@ public:
 	// Object create and update functions
 	virtual void	idleUpdate(LLAgent &agent, LLWorld &world, const F64 &time);
 
+	// True when idleUpdate() is exactly predictIdleMotion() followed by applyIdleMotion(),
+	// so that LLViewerObjectList can run the prediction for many objects in parallel.
+	virtual bool	hasSplitIdleUpdate() const			{ return false; }
+	void			predictIdleMotion(const F64 &time, LLIdleMotion& motion) const;
+	void			applyIdleMotion(const F64 &time, const LLIdleMotion& motion);
+
 	// Types of media we can associate
 	enum { MEDIA_NONE = 0, MEDIA_SET = 1 };
 
@@ -208,7 +235,8 @@ public:
 	virtual BOOL		setDrawableParent(LLDrawable* parentp);
 	F32					getRotTime() { return mRotTime; }
 	void				resetRot();
-	void				applyAngularVelocity(F32 dt);
+	bool				predictAngularMotion(F32 dt, LLQuaternion& dQ) const;
+	void				applyAngularMotion(F32 dt, bool rotate, const LLQuaternion& dQ);
 
 	void setLineWidthForWindowSize(S32 window_width);
 
@@ -593,7 +621,10 @@ private:
     U32 checkMediaURL(const std::string &media_url);
 	
 	// Motion prediction between updates
-	void interpolateLinearMotion(const F64SecondsImplicit & time, const F32SecondsImplicit & dt);
+	U8 predictLinearMotion(const F64SecondsImplicit & time, const F32SecondsImplicit & dt,
+						   LLVector3& delta_pos, LLVector3& delta_vel) const;
+	void applyLinearMotion(const F64SecondsImplicit & time, U8 mode,
+						   const LLVector3& delta_pos, const LLVector3& delta_vel);
 
 	// forms task inventory request if none are pending
 	void fetchInventoryFromServer();
@@ -58,6 +58,7 @@
 #include "lldrawable.h"
 #include "llflexibleobject.h"
 #include "llviewertextureanim.h"
+#include "llthreadpool.h"
 #include "xform.h"
 #include "llsky.h"
 #include "llviewercamera.h"
@@ -122,8 +123,143 @@ extern LLPipeline	gPipeline;
 // Statics for object lookup tables.
 U32						LLViewerObjectList::sSimulatorMachineIndex = 1; // Not zero deliberately, to speed up index check.
 std::map<U64, U32>			LLViewerObjectList::sIPAndPortToIndex;
-std::map<U64, LLUUID>	LLViewerObjectList::sIndexAndLocalIDToUUID;
+LLLocalIDTable			LLViewerObjectList::sIndexAndLocalIDToUUID;
 LLStat					LLViewerObjectList::sCacheHitRate("object_cache_hits", 128);
+LLStat					LLViewerObjectList::sObjectUpdateRate("object_updates", 32);
+LLStat					LLViewerObjectList::sDeferredDrawableRate("deferred_drawables", 32);
+
+//-----------------------------------------------------------------------------
+// LLLocalIDTable
+//-----------------------------------------------------------------------------
+
+const U32 LOCAL_ID_TABLE_MIN_SIZE = 1024;
+
+LLLocalIDTable::LLLocalIDTable()
+:	mMask(0),
+	mCount(0)
+{
+}
+
+U32 LLLocalIDTable::slotFor(U64 key) const
+{
+	// Local ids are mostly sequential, mix the bits before masking.
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return (U32)key & mMask;
+}
+
+const LLUUID& LLLocalIDTable::find(U64 key) const
+{
+	if (!mCount || !key)
+	{
+		return LLUUID::null;
+	}
+	for (U32 slot = slotFor(key); mEntries[slot].mKey; slot = (slot + 1) & mMask)
+	{
+		if (mEntries[slot].mKey == key)
+		{
+			return mEntries[slot].mID;
+		}
+	}
+	return LLUUID::null;
+}
+
+void LLLocalIDTable::set(U64 key, const LLUUID& id)
+{
+	if (!key)
+	{
+		return;
+	}
+	// Keep the load below 1/2 so that probe sequences stay short.
+	if ((mCount + 1) * 2 > mEntries.size())
+	{
+		rehash(llmax(LOCAL_ID_TABLE_MIN_SIZE, (U32)mEntries.size() * 2));
+	}
+	U32 slot = slotFor(key);
+	while (mEntries[slot].mKey && mEntries[slot].mKey != key)
+	{
+		slot = (slot + 1) & mMask;
+	}
+	if (!mEntries[slot].mKey)
+	{
+		mEntries[slot].mKey = key;
+		++mCount;
+	}
+	mEntries[slot].mID = id;
+}
+
+bool LLLocalIDTable::erase(U64 key, const LLUUID& id)
+{
+	if (!mCount || !key)
+	{
+		return false;
+	}
+	U32 slot = slotFor(key);
+	while (mEntries[slot].mKey != key)
+	{
+		if (!mEntries[slot].mKey)
+		{
+			return false;
+		}
+		slot = (slot + 1) & mMask;
+	}
+	if (mEntries[slot].mID != id)
+	{
+		return false;
+	}
+
+	// Shift the following entries of the probe sequence back, so that lookups
+	// never need tombstones.
+	U32 hole = slot;
+	for (U32 next = (hole + 1) & mMask; mEntries[next].mKey; next = (next + 1) & mMask)
+	{
+		U32 home = slotFor(mEntries[next].mKey);
+		if (((next - home) & mMask) >= ((next - hole) & mMask))
+		{
+			mEntries[hole] = mEntries[next];
+			hole = next;
+		}
+	}
+	mEntries[hole].mKey = 0;
+	mEntries[hole].mID.setNull();
+	--mCount;
+	return true;
+}
+
+void LLLocalIDTable::clear()
+{
+	mEntries.clear();
+	mMask = 0;
+	mCount = 0;
+}
+
+void LLLocalIDTable::rehash(U32 capacity)
+{
+	std::vector<Entry> old_entries(capacity);
+	old_entries.swap(mEntries);
+	for (U32 i = 0; i < capacity; ++i)
+	{
+		mEntries[i].mKey = 0;
+	}
+	mMask = capacity - 1;
+	for (std::vector<Entry>::const_iterator iter = old_entries.begin(); iter != old_entries.end(); ++iter)
+	{
+		if (iter->mKey)
+		{
+			U32 slot = slotFor(iter->mKey);
+			while (mEntries[slot].mKey)
+			{
+				slot = (slot + 1) & mMask;
+			}
+			mEntries[slot] = *iter;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// LLViewerObjectList
+//-----------------------------------------------------------------------------
 
 LLViewerObjectList::LLViewerObjectList()
 {
@@ -135,10 +271,16 @@ LLViewerObjectList::LLViewerObjectList()
 	mMinNumDeadObjects = 20;
 	mNumOrphans = 0;
 	mNumNewObjects = 0;
+	mNumObjectUpdates = 0;
+	mNumDeferredDrawables = 0;
+	mObjectUpdateTime = 0.f;
+	mDeferDrawables = false;
 	mWasPaused = FALSE;
 	mNumDeadObjectUpdates = 0;
 	mNumUnknownKills = 0;
 	mNumUnknownUpdates = 0;
+	mIdleThreadPool = NULL;
+	mIdleThreadCount = 0;
 }
 
 LLViewerObjectList::~LLViewerObjectList()
@@ -148,6 +290,7 @@ LLViewerObjectList::~LLViewerObjectList()
 
 void LLViewerObjectList::destroy()
 {
+	mUpdateRecords.clear();
 	killAllObjects();
 
 	resetObjectBeacons();
@@ -156,6 +299,10 @@ void LLViewerObjectList::destroy()
 	mMapObjects.clear();
 	mUUIDObjectMap.clear();
 	mUUIDAvatarMap.clear();
+
+	delete mIdleThreadPool;
+	mIdleThreadPool = NULL;
+	mIdleThreadCount = 0;
 }
 
 
@@ -176,7 +323,7 @@ void LLViewerObjectList::getUUIDFromLocal(LLUUID &id,
 
 	U64	indexid = (((U64)index) << 32) | (U64)local_id;
 
-	id = get_if_there(sIndexAndLocalIDToUUID, indexid, LLUUID::null);
+	id = sIndexAndLocalIDToUUID.find(indexid);
 }
 
 U64 LLViewerObjectList::getIndex(const U32 local_id,
@@ -209,21 +356,12 @@ BOOL LLViewerObjectList::removeFromLocalIDTable(const LLViewerObject* objectp)
 		
 		U64	indexid = (((U64)index) << 32) | (U64)local_id;
 		
-		std::map<U64, LLUUID>::iterator iter = sIndexAndLocalIDToUUID.find(indexid);
-		if (iter == sIndexAndLocalIDToUUID.end())
+		// Only remove the entry if the full UUIDs match, otherwise this would
+		// zap a valid entry.
+		if (sIndexAndLocalIDToUUID.erase(indexid, objectp->getID()))
 		{
-			return FALSE;
-		}
-		
-		// Found existing entry
-		if (iter->second == objectp->getID())
-		{   // Full UUIDs match, so remove the entry
-			sIndexAndLocalIDToUUID.erase(iter);
 			return TRUE;
 		}
-		// UUIDs did not match - this would zap a valid entry, so don't erase it
-		//LL_INFOS() << "Tried to erase entry where id in table (" 
-		//		<< iter->second	<< ") did not match object " << object.getID() << LL_ENDL;
 	}
 	
 	return FALSE ;
@@ -246,7 +384,7 @@ void LLViewerObjectList::setUUIDAndLocal(const LLUUID &id,
 
 	U64	indexid = (((U64)index) << 32) | (U64)local_id;
 
-	sIndexAndLocalIDToUUID[indexid] = id;
+	sIndexAndLocalIDToUUID.set(indexid, id);
 	
 	//LL_INFOS() << "Adding object to table, full ID " << id
 	//	<< ", local ID " << local_id << ", ip " << ip << ":" << port << LL_ENDL;
@@ -277,7 +415,15 @@ void LLViewerObjectList::processUpdateCore(LLViewerObject* objectp,
 
 	if (just_created) 
 	{
-		gPipeline.addObject(objectp);
+		// Avatars and attachments always get their drawable right away, the
+		// avatar code expects it.
+		bool defer = mDeferDrawables && !objectp->mCreateSelected &&
+					 !objectp->isAvatar() && !objectp->getAvatar();
+		if (defer)
+		{
+			mNumDeferredDrawables++;
+		}
+		gPipeline.addObject(objectp, defer);
 	}
 	else
 	{
@@ -324,6 +470,7 @@ void LLViewerObjectList::processUpdateCore(LLViewerObject* objectp,
 }
 
 static LLTrace::BlockTimerStatHandle FTM_PROCESS_OBJECTS("Process Objects");
+static LLTrace::BlockTimerStatHandle FTM_DECODE_OBJECT_UPDATES("Decode Object Updates");
 
 void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 											 void **user_data,
@@ -331,53 +478,23 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 											 bool cached, bool compressed)
 {
 	LL_RECORD_BLOCK_TIME(FTM_PROCESS_OBJECTS);	
-	
-	LLViewerObject *objectp;
-	S32			num_objects;
-	U32			local_id;
-	LLPCode		pcode = 0;
-	LLUUID		fullid;
-	S32			i;
+
+	LLTimer update_timer;
 
 	// figure out which simulator these are from and get it's index
 	// Coordinates in simulators are region-local
 	// Until we get region-locality working on viewer we
 	// have to transform to absolute coordinates.
-	num_objects = mesgsys->getNumberOfBlocksFast(_PREHASH_ObjectData);
+	S32 num_objects = mesgsys->getNumberOfBlocksFast(_PREHASH_ObjectData);
 
 	// I don't think this case is ever hit.  TODO* Test this.
 	if (!cached && !compressed && update_type != OUT_FULL)
 	{
 		//LL_INFOS() << "TEST: !cached && !compressed && update_type != OUT_FULL" << LL_ENDL;
 		gTerseObjectUpdates += num_objects;
-		/*
-		S32 size;
-		if (mesgsys->getReceiveCompressedSize())
-		{
-			size = mesgsys->getReceiveCompressedSize();
-		}
-		else
-		{
-			size = mesgsys->getReceiveSize();
-		}
-		LL_INFOS() << "Received terse " << num_objects << " in " << size << " byte (" << size/num_objects << ")" << LL_ENDL;
-		*/
 	}
 	else
 	{
-		/*
-		S32 size;
-		if (mesgsys->getReceiveCompressedSize())
-		{
-			size = mesgsys->getReceiveCompressedSize();
-		}
-		else
-		{
-			size = mesgsys->getReceiveSize();
-		}
-
-		LL_INFOS() << "Received " << num_objects << " in " << size << " byte (" << size/num_objects << ")" << LL_ENDL;
-		*/
 		gFullObjectUpdates += num_objects;
 	}
 
@@ -391,104 +508,173 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		return;
 	}
 
-	U8 compressed_dpbuffer[2048];
-	LLDataPackerBinaryBuffer compressed_dp(compressed_dpbuffer, 2048);
-	LLDataPacker *cached_dpp = NULL;
 	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
-	
-	for (i = 0; i < num_objects; i++)
+	const U32 sender_ip = mesgsys->getSenderIP();
+	const U32 sender_port = mesgsys->getSenderPort();
+
+	// Terse updates only carry the local id.
+	const bool by_local_id = compressed ? (update_type == OUT_TERSE_IMPROVED) : (!cached && update_type != OUT_FULL);
+
+	// First pass: decode all blocks into compact records. Compressed data is
+	// copied into one contiguous buffer so nothing has to be read from the
+	// message out of order later on.
+	mUpdateRecords.clear();
+	mUpdateData.clear();
 	{
-		// timer is unused?
-		LLTimer update_timer;
-		BOOL justCreated = FALSE;
-		S32	msg_size = 0;
+		LL_RECORD_BLOCK_TIME(FTM_DECODE_OBJECT_UPDATES);
 
-		if (cached)
+		mUpdateRecords.reserve(num_objects);
+		for (S32 i = 0; i < num_objects; i++)
 		{
-			U32 id;
-			U32 crc;
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, id, i);
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_CRC, crc, i);
-			msg_size += sizeof(U32) * 2;
-		
-			// Lookup data packer and add this id to cache miss lists if necessary.
-			U8 cache_miss_type = LLViewerRegion::CACHE_MISS_TYPE_NONE;
-			cached_dpp = regionp->getDP(id, crc, cache_miss_type);
-			if (cached_dpp)
+			LLObjectUpdateRecord record;
+			record.mCachedDP = NULL;
+			record.mLocalID = 0;
+			record.mBlock = i;
+			record.mMsgSize = 0;
+			record.mDataOffset = 0;
+			record.mDataSize = 0;
+			record.mPCode = 0;
+
+			if (cached)
 			{
+				U32 id;
+				U32 crc;
+				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, id, i);
+				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_CRC, crc, i);
+				record.mMsgSize += sizeof(U32) * 2;
+
+				// Lookup data packer and add this id to cache miss lists if necessary.
+				U8 cache_miss_type = LLViewerRegion::CACHE_MISS_TYPE_NONE;
+				record.mCachedDP = regionp->getDP(id, crc, cache_miss_type);
+				if (!record.mCachedDP)
+				{
+					// Cache Miss.
+					recorder.cacheMissEvent(id, update_type, cache_miss_type, record.mMsgSize);
+					continue; // no data packer, skip this object
+				}
+
 				// Cache Hit.
-				cached_dpp->reset();
-				cached_dpp->unpackUUID(fullid, "ID");
-				cached_dpp->unpackU32(local_id, "LocalID");
-				cached_dpp->unpackU8(pcode, "PCode");
+				record.mCachedDP->reset();
+				record.mCachedDP->unpackUUID(record.mFullID, "ID");
+				record.mCachedDP->unpackU32(record.mLocalID, "LocalID");
+				record.mCachedDP->unpackU8(record.mPCode, "PCode");
 			}
-			else
+			else if (compressed)
 			{
-				// Cache Miss.
-				recorder.cacheMissEvent(id, update_type, cache_miss_type, msg_size);
+				S32 data_size = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
+				if (data_size <= 0)
+				{
+					LL_WARNS() << "Compressed object update without data, block " << i << LL_ENDL;
+					continue;
+				}
 
-				continue; // no data packer, skip this object
-			}
-		}
-		else if (compressed)
-		{
-			S32							uncompressed_length = 2048;
-			compressed_dp.reset();
+				record.mDataOffset = (S32)mUpdateData.size();
+				record.mDataSize = data_size;
+				mUpdateData.resize(record.mDataOffset + data_size);
+				mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, &mUpdateData[record.mDataOffset], 0, i, data_size);
 
-			U32 flags = 0;
-			if (update_type != OUT_TERSE_IMPROVED)
+				LLDataPackerBinaryBuffer dp(&mUpdateData[record.mDataOffset], data_size);
+				if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
+				{
+					dp.unpackUUID(record.mFullID, "ID");
+					dp.unpackU32(record.mLocalID, "LocalID");
+					dp.unpackU8(record.mPCode, "PCode");
+				}
+				else //OUT_TERSE_IMPROVED
+				{
+					dp.unpackU32(record.mLocalID, "LocalID");
+				}
+			}
+			else if (update_type != OUT_FULL) // !compressed, !OUT_FULL ==> OUT_FULL_CACHED only?
 			{
-				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, record.mLocalID, i);
+				record.mMsgSize += sizeof(U32);
 			}
-			
-			uncompressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
-			mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compressed_dpbuffer, 0, i);
-			compressed_dp.assignBuffer(compressed_dpbuffer, uncompressed_length);
+			else // OUT_FULL only?
+			{
+				mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, record.mFullID, i);
+				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, record.mLocalID, i);
+				record.mMsgSize += sizeof(LLUUID);
+				record.mMsgSize += sizeof(U32);
+				// LL_INFOS() << "Full Update, obj " << local_id << ", global ID" << fullid << "from " << mesgsys->getSender() << LL_ENDL;
+			}
+			mUpdateRecords.push_back(record);
+		}
 
-			if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
+		// Second pass: resolve local ids and find the existing objects.
+		U64 sim_index = 0;
+		if (by_local_id)
+		{
+			U64 ipport = (((U64)sender_ip) << 32) | (U64)sender_port;
+			U32& index = sIPAndPortToIndex[ipport];
+			if (!index)
 			{
-				compressed_dp.unpackUUID(fullid, "ID");
-				compressed_dp.unpackU32(local_id, "LocalID");
-				compressed_dp.unpackU8(pcode, "PCode");
+				index = sSimulatorMachineIndex++;
 			}
-			else //OUT_TERSE_IMPROVED
+			sim_index = ((U64)index) << 32;
+		}
+
+		for (std::vector<LLObjectUpdateRecord>::iterator iter = mUpdateRecords.begin(); iter != mUpdateRecords.end(); ++iter)
+		{
+			LLObjectUpdateRecord& record = *iter;
+			if (by_local_id)
 			{
-				compressed_dp.unpackU32(local_id, "LocalID");
-				getUUIDFromLocal(fullid,
-								 local_id,
-								 gMessageSystem->getSenderIP(),
-								 gMessageSystem->getSenderPort());
-				if (fullid.isNull())
+				record.mFullID = sIndexAndLocalIDToUUID.find(sim_index | (U64)record.mLocalID);
+				if (record.mFullID.isNull())
 				{
-					LL_DEBUGS() << "update for unknown localid " << local_id << " host " << gMessageSystem->getSender() << ":" << gMessageSystem->getSenderPort() << LL_ENDL;
+					LL_DEBUGS() << "update for unknown localid " << record.mLocalID << " host " << mesgsys->getSender() << LL_ENDL;
 					mNumUnknownUpdates++;
+					continue;
 				}
 			}
+			record.mObject = findObject(record.mFullID);
 		}
-		else if (update_type != OUT_FULL) // !compressed, !OUT_FULL ==> OUT_FULL_CACHED only?
+	}
+
+	// Third pass: apply. New objects past this frame's time budget get their
+	// drawable from LLPipeline::createObjects() instead of right away.
+	static const LLCachedControl<F32> drawable_budget("ObjectUpdateDrawableBudget", 0.01f);
+	LLDataPackerBinaryBuffer compressed_dp;
+	S32 num_created = 0;
+	S32 num_applied = 0;
+
+	for (std::vector<LLObjectUpdateRecord>::iterator iter = mUpdateRecords.begin(); iter != mUpdateRecords.end(); ++iter)
+	{
+		const LLObjectUpdateRecord& record = *iter;
+		const U32 local_id = record.mLocalID;
+		const LLUUID& fullid = record.mFullID;
+		S32 msg_size = record.mMsgSize;
+		LLPCode pcode = record.mPCode;
+		BOOL justCreated = FALSE;
+
+		mDeferDrawables = drawable_budget > 0.f && mObjectUpdateTime + update_timer.getElapsedTimeF32() > drawable_budget;
+
+		LLViewerObject* objectp = record.mObject;
+		if (!objectp && num_created && fullid.notNull())
 		{
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
-			msg_size += sizeof(U32);
+			// Several blocks of one message may refer to the same new object.
+			objectp = findObject(fullid);
+		}
 
-			getUUIDFromLocal(fullid,
-							local_id,
-							gMessageSystem->getSenderIP(),
-							gMessageSystem->getSenderPort());
-			if (fullid.isNull())
+		if (compressed)
+		{
+			// Position the data packer after the header decoded above.
+			compressed_dp.assignBuffer(&mUpdateData[record.mDataOffset], record.mDataSize);
+			if (update_type != OUT_TERSE_IMPROVED)
 			{
-				// LL_WARNS() << "update for unknown localid " << local_id << " host " << gMessageSystem->getSender() << LL_ENDL;
-				mNumUnknownUpdates++;
+				LLUUID id;
+				compressed_dp.unpackUUID(id, "ID");
+				U32 id32;
+				compressed_dp.unpackU32(id32, "LocalID");
+				U8 code;
+				compressed_dp.unpackU8(code, "PCode");
+			}
+			else
+			{
+				U32 id32;
+				compressed_dp.unpackU32(id32, "LocalID");
 			}
 		}
-		else // OUT_FULL only?
-		{
-			mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, fullid, i);
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
-			msg_size += sizeof(LLUUID);
-			msg_size += sizeof(U32);
-			// LL_INFOS() << "Full Update, obj " << local_id << ", global ID" << fullid << "from " << mesgsys->getSender() << LL_ENDL;
-		}
-		objectp = findObject(fullid);
 
 		// This looks like it will break if the local_id of the object doesn't change
 		// upon boundary crossing, but we check for region id matching later...
@@ -497,21 +683,11 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			((objectp->mLocalID != local_id) ||
 			 (objectp->getRegion() != regionp)))
 		{
-			//if (objectp->getRegion())
-			//{
-			//	LL_INFOS() << "Local ID change: Removing object from table, local ID " << objectp->mLocalID 
-			//			<< ", id from message " << local_id << ", from " 
-			//			<< LLHost(objectp->getRegion()->getHost().getAddress(), objectp->getRegion()->getHost().getPort())
-			//			<< ", full id " << fullid 
-			//			<< ", objects id " << objectp->getID()
-			//			<< ", regionp " << (U32) regionp << ", object region " << (U32) objectp->getRegion()
-			//			<< LL_ENDL;
-			//}
 			removeFromLocalIDTable(objectp);
 			setUUIDAndLocal(fullid,
 							local_id,
-							gMessageSystem->getSenderIP(),
-							gMessageSystem->getSenderPort());
+							sender_ip,
+							sender_port);
 			
 			if (objectp->mLocalID != local_id)
 			{    // Update local ID in object with the one sent from the region
@@ -547,7 +723,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 					continue;
 				}
 
-				mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+				mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, pcode, record.mBlock);
 				msg_size += sizeof(U8);
 
 			}
@@ -570,7 +746,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			}
 
 
-			objectp = createObject(pcode, regionp, fullid, local_id, gMessageSystem->getSender());
+			objectp = createObject(pcode, regionp, fullid, local_id, mesgsys->getSender());
 			if (!objectp)
 			{
 				LL_INFOS() << "createObject failure for object: " << fullid << LL_ENDL;
@@ -578,6 +754,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 				continue;
 			}
 			justCreated = TRUE;
+			num_created++;
 			mNumNewObjects++;
 			sCacheHitRate.addValue(cached ? 100.f : 0.f);
 
@@ -596,7 +773,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			{
 				objectp->mLocalID = local_id;
 			}
-			processUpdateCore(objectp, user_data, i, update_type, &compressed_dp, justCreated);
+			processUpdateCore(objectp, user_data, record.mBlock, update_type, &compressed_dp, justCreated);
 			if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
 			{
 				bCached = true;
@@ -607,7 +784,7 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		else if (cached)
 		{
 			objectp->mLocalID = local_id;
-			processUpdateCore(objectp, user_data, i, update_type, cached_dpp, justCreated);
+			processUpdateCore(objectp, user_data, record.mBlock, update_type, record.mCachedDP, justCreated);
 		}
 		else
 		{
@@ -615,18 +792,34 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			{
 				objectp->mLocalID = local_id;
 			}
-			processUpdateCore(objectp, user_data, i, update_type, NULL, justCreated);
+			processUpdateCore(objectp, user_data, record.mBlock, update_type, NULL, justCreated);
 		}
 		recorder.objectUpdateEvent(local_id, update_type, objectp, msg_size);
 		objectp->setLastUpdateType(update_type);
 		objectp->setLastUpdateCached(bCached);
+		num_applied++;
 	}
+	// The records hold references; don't keep killed objects around until the next message.
+	mUpdateRecords.clear();
+
+	mNumObjectUpdates += num_applied;
+	mObjectUpdateTime += update_timer.getElapsedTimeF32();
+	mDeferDrawables = false;
 
 	recorder.log(0.2f);
 
 	LLVOAvatar::cullAvatarsByPixelArea();
 }
 
+void LLViewerObjectList::updateObjectUpdateStats()
+{
+	sObjectUpdateRate.addValue((F32)mNumObjectUpdates);
+	sDeferredDrawableRate.addValue((F32)mNumDeferredDrawables);
+	mNumObjectUpdates = 0;
+	mNumDeferredDrawables = 0;
+	mObjectUpdateTime = 0.f;
+}
+
 void LLViewerObjectList::processCompressedObjectUpdate(LLMessageSystem *mesgsys,
 											 void **user_data,
 											 const EObjectUpdateType update_type)
@@ -914,6 +1107,51 @@ private:
 	LLSD mObjectIDs;
 };
 
+namespace
+{
+	class IdleMotionJob : public LLThreadPool::Job
+	{
+	public:
+		IdleMotionJob(std::vector<LLViewerObject*> const& objects, std::vector<LLIdleMotion>& motions, F64 time) :
+			mObjects(objects), mMotions(motions), mTime(time) { }
+
+		/*virtual*/ void run(S32 begin, S32 end)
+		{
+			for (S32 i = begin; i < end; ++i)
+			{
+				LLViewerObject* objectp = mObjects[i];
+				if (objectp->hasSplitIdleUpdate())
+				{
+					objectp->predictIdleMotion(mTime, mMotions[i]);
+				}
+			}
+		}
+
+	private:
+		std::vector<LLViewerObject*> const& mObjects;
+		std::vector<LLIdleMotion>& mMotions;
+		F64 mTime;
+	};
+}
+
+LLThreadPool* LLViewerObjectList::getIdleThreadPool()
+{
+	static const LLCachedControl<S32> idle_update_threads("IdleUpdateThreads", -1);
+	S32 count = idle_update_threads;
+	if (count < 0)
+	{
+		count = LLThreadPool::getDefaultThreadCount(8);
+	}
+	count = llmin(count, 16);
+	if (count != mIdleThreadCount)
+	{
+		delete mIdleThreadPool;
+		mIdleThreadPool = count > 0 ? new LLThreadPool("Idle Update", count) : NULL;
+		mIdleThreadCount = count;
+	}
+	return mIdleThreadPool;
+}
+
 void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 {
 	// Update globals
@@ -1020,20 +1258,45 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 	}
 	else
 	{
-		for (std::vector<LLViewerObject*>::iterator idle_iter = idle_list.begin();
-			idle_iter != idle_end; idle_iter++)
+		LLThreadPool* pool = getIdleThreadPool();
+		if (pool)
 		{
-			objectp = *idle_iter;
-			llassert(objectp->isActive());
-			objectp->idleUpdate(agent, world, frame_time);
+			// Dead reckoning only reads the object itself, predict it for all objects at once...
+			mIdleMotions.resize(idle_count);
+			IdleMotionJob job(idle_list, mIdleMotions, frame_time);
+			pool->parallelFor(job, idle_count, 128);
 
+			// ...then move them and request rebuilds in the original order.
+			for (U32 i = 0; i < idle_count; ++i)
+			{
+				objectp = idle_list[i];
+				llassert(objectp->isActive());
+				if (objectp->hasSplitIdleUpdate())
+				{
+					objectp->applyIdleMotion(frame_time, mIdleMotions[i]);
+				}
+				else
+				{
+					objectp->idleUpdate(agent, world, frame_time);
+				}
+			}
+		}
+		else
+		{
+			for (std::vector<LLViewerObject*>::iterator idle_iter = idle_list.begin();
+				idle_iter != idle_end; idle_iter++)
+			{
+				objectp = *idle_iter;
+				llassert(objectp->isActive());
+				objectp->idleUpdate(agent, world, frame_time);
+			}
 		}
 
 		//update flexible objects
 		LLVolumeImplFlexible::updateClass();
 
 		//update animated textures
-		LLViewerTextureAnim::updateClass();
+		LLViewerTextureAnim::updateClass(pool);
 	}
 
 
@@ -1059,7 +1322,7 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 	LLUUID id;
 	for (i = 0; i < mOrphanParents.count(); i++)
 	{
-		id = sIndexAndLocalIDToUUID[mOrphanParents[i]];
+		id = sIndexAndLocalIDToUUID.find(mOrphanParents[i]);
 		LLViewerObject *objectp = findObject(id);
 		if (objectp)
 		{
@@ -1093,7 +1356,7 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 				tmpstr = std::string("ChNoP:    ") + id_str;
 				text_color = LLColor4(1.f, 0.f, 0.f, 1.f);
 			}
-			id = sIndexAndLocalIDToUUID[oi.mParentInfo];
+			id = sIndexAndLocalIDToUUID.find(oi.mParentInfo);
 			addDebugBeacon(objectp->getPositionAgent() + LLVector3(0.f, 0.f, -0.25f),
 							tmpstr,
 							LLColor4(0.25f,0.25f,0.25f,1.f),
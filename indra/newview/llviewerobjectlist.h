@@ -35,10 +35,12 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 // common includes
 #include "llstat.h"
 #include "llstring.h"
+#include "lluuidflatmap.h"
 
 // project includes
 #include "llviewerobject.h"
@@ -46,6 +48,7 @@
 
 class LLCamera;
 class LLNetMap;
+class LLThreadPool;
 class LLDebugBeacon;
 
 constexpr U32 CLOSE_BIN_SIZE = 10;
@@ -58,6 +61,51 @@ constexpr U32 GL_NAME_PARCEL_WALL = 1;
 
 constexpr U32 GL_NAME_INDEX_OFFSET = 10;
 
+// Open addressing map from (simulator index, local id) to full object id.
+// This is looked up for every terse update and every parent id, so keep it
+// flat instead of a node based map.
+class LLLocalIDTable
+{
+public:
+	LLLocalIDTable();
+
+	// Returns LLUUID::null when the key is unknown.
+	const LLUUID& find(U64 key) const;
+	void set(U64 key, const LLUUID& id);
+	// Only removes the entry if it still maps to 'id'.
+	bool erase(U64 key, const LLUUID& id);
+	void clear();
+	U32 size() const							{ return mCount; }
+
+private:
+	struct Entry
+	{
+		U64 mKey;		// 0 marks an empty slot
+		LLUUID mID;
+	};
+
+	U32 slotFor(U64 key) const;
+	void rehash(U32 capacity);
+
+	std::vector<Entry> mEntries;
+	U32 mMask;
+	U32 mCount;
+};
+
+// One decoded ObjectData block of an object update message.
+struct LLObjectUpdateRecord
+{
+	LLPointer<LLViewerObject> mObject;
+	LLDataPacker* mCachedDP;	// cache hit, owned by the region cache
+	LLUUID mFullID;
+	U32 mLocalID;
+	S32 mBlock;
+	S32 mMsgSize;
+	S32 mDataOffset;			// compressed data, in mUpdateData
+	S32 mDataSize;
+	LLPCode mPCode;
+};
+
 class LLViewerObjectList
 {
 public:
@@ -92,6 +140,8 @@ public:
 	void processObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type, bool cached=false, bool compressed=false);
 	void processCompressedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
 	void processCachedObjectUpdate(LLMessageSystem *mesgsys, void **user_data, EObjectUpdateType update_type);
+	// Resets the per frame update counters and feeds the statistics.
+	void updateObjectUpdateStats();
 	void updateApparentAngles(LLAgent &agent);
 	void update(LLAgent &agent, LLWorld &world);
 
@@ -176,6 +226,9 @@ public:
 	U32	mCurBin; // Current bin we're working on...
 
 	S32 mNumNewObjects;
+	S32 mNumObjectUpdates;			// blocks applied this frame
+	S32 mNumDeferredDrawables;		// new objects left to LLPipeline::createObjects() this frame
+	F32 mObjectUpdateTime;			// seconds spent in processObjectUpdate() this frame
 
 	S32 mNumSizeCulled;
 	S32 mNumVisCulled;
@@ -208,6 +261,8 @@ public:
 	S32 mNumOrphans;
 
 	static LLStat sCacheHitRate;
+	static LLStat sObjectUpdateRate;
+	static LLStat sDeferredDrawableRate;
 
 	typedef std::vector<LLPointer<LLViewerObject> > vobj_list_t;
 
@@ -218,8 +273,8 @@ public:
 
 	std::set<LLUUID> mDeadObjects;	
 
-	boost::unordered_map<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
-	boost::unordered_map<LLUUID, LLPointer<LLVOAvatar> > mUUIDAvatarMap;
+	LLUUIDFlatMap<LLPointer<LLViewerObject> > mUUIDObjectMap;
+	LLUUIDFlatMap<LLPointer<LLVOAvatar> > mUUIDAvatarMap;
 
 	//set of objects that need to update their cost
 	std::set<LLUUID> mStaleObjectCost;
@@ -231,12 +286,24 @@ public:
 
 	std::vector<LLDebugBeacon> mDebugBeacons;
 
+	// Threads for the parallel phases of update(), see IdleUpdateThreads.
+	LLThreadPool* getIdleThreadPool();
+	LLThreadPool* mIdleThreadPool;
+	S32 mIdleThreadCount;
+	std::vector<LLIdleMotion> mIdleMotions;
+
+	// Scratch space for processObjectUpdate(), kept to avoid reallocating per message.
+	// mUpdateRecords is emptied once a message is applied, since its records hold references.
+	std::vector<LLObjectUpdateRecord> mUpdateRecords;
+	std::vector<U8> mUpdateData;
+	bool mDeferDrawables;
+
 	S32 mCurLazyUpdateIndex;
 
 	static U32 sSimulatorMachineIndex;
 	static std::map<U64, U32> sIPAndPortToIndex;
 
-	static std::map<U64, LLUUID> sIndexAndLocalIDToUUID;
+	static LLLocalIDTable sIndexAndLocalIDToUUID;
 
 	std::set<LLViewerObject *> mSelectPickList;
 
@@ -271,7 +338,7 @@ extern LLViewerObjectList gObjectList;
 // Inlines
 inline LLViewerObject *LLViewerObjectList::findObject(const LLUUID &id) const
 {
-	boost::unordered_map<LLUUID, LLPointer<LLViewerObject> >::const_iterator iter = mUUIDObjectMap.find(id);
+	LLUUIDFlatMap<LLPointer<LLViewerObject> >::const_iterator iter = mUUIDObjectMap.find(id);
 	if(iter != mUUIDObjectMap.end())
 	{
 		return iter->second;
@@ -284,7 +351,7 @@ inline LLViewerObject *LLViewerObjectList::findObject(const LLUUID &id) const
 
 inline LLVOAvatar *LLViewerObjectList::findAvatar(const LLUUID &id) const
 {
-	boost::unordered_map<LLUUID, LLPointer<LLVOAvatar> >::const_iterator iter = mUUIDAvatarMap.find(id);
+	LLUUIDFlatMap<LLPointer<LLVOAvatar> >::const_iterator iter = mUUIDAvatarMap.find(id);
 	return (iter != mUUIDAvatarMap.end()) ? iter->second.get() : NULL;
 }
 
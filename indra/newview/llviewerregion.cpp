@@ -153,7 +153,7 @@ public:
 	// Misc
 	LLVLComposition *mCompositionp;		// Composition layer for the surface
 
-	LLVOCacheEntry::vocache_entry_map_t		mCacheMap;
+	LLVOCacheEntryList						mCacheMap;
 	// time?
 	// LRU info?
 
@@ -610,10 +610,6 @@ void LLViewerRegion::saveObjectCache()
 		mCacheDirty = FALSE;
 	}
 
-	for(LLVOCacheEntry::vocache_entry_map_t::iterator iter = mImpl->mCacheMap.begin(); iter != mImpl->mCacheMap.end(); ++iter)
-	{
-		delete iter->second;
-	}
 	mImpl->mCacheMap.clear();
 }
 
@@ -1515,23 +1511,20 @@ LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLViewerObjec
 	U32 local_id = objectp->getLocalID();
 	U32 crc = objectp->getCRC();
 
-	LLVOCacheEntry* entry = get_if_there(mImpl->mCacheMap, local_id, (LLVOCacheEntry*)NULL);
+	LLVOCacheObjectIndex::Record* record = mImpl->mCacheMap.find(local_id);
 
-	if (entry)
+	if (record)
 	{
 		// we've seen this object before
-		if (entry->getCRC() == crc)
+		if (record->mCRC == crc)
 		{
 			// Record a hit
-			entry->recordDupe();
+			mImpl->mCacheMap.recordDupe(*record);
 			return CACHE_UPDATE_DUPE;
 		}
 
 		// Update the cache entry
-		mImpl->mCacheMap.erase(local_id);
-		delete entry;
-		entry = new LLVOCacheEntry(local_id, crc, dp);
-		mImpl->mCacheMap[local_id] = entry;
+		mImpl->mCacheMap.setEntry(new LLVOCacheEntry(local_id, crc, dp));
 		return CACHE_UPDATE_CHANGED;
 	}
 
@@ -1539,16 +1532,11 @@ LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLViewerObjec
 
 	// Create new entry and add to map
 	eCacheUpdateResult result = CACHE_UPDATE_ADDED;
-	if (mImpl->mCacheMap.size() > MAX_OBJECT_CACHE_ENTRIES)
+	if (mImpl->mCacheMap.evict(MAX_OBJECT_CACHE_ENTRIES))
 	{
-		delete mImpl->mCacheMap.begin()->second ;
-		mImpl->mCacheMap.erase(mImpl->mCacheMap.begin());
 		result = CACHE_UPDATE_REPLACED;
-		
 	}
-	entry = new LLVOCacheEntry(local_id, crc, dp);
-
-	mImpl->mCacheMap[local_id] = entry;
+	mImpl->mCacheMap.setEntry(new LLVOCacheEntry(local_id, crc, dp));
 	return result;
 }
 
@@ -1558,13 +1546,15 @@ LLDataPacker *LLViewerRegion::getDP(U32 local_id, U32 crc, U8 &cache_miss_type)
 {
 	//llassert(mCacheLoaded);  This assert failes often, changing to early-out -- davep, 2010/10/18
 
-	LLVOCacheEntry* entry = get_if_there(mImpl->mCacheMap, local_id, (LLVOCacheEntry*)NULL);
+	LLVOCacheObjectIndex::Record* record = mImpl->mCacheMap.find(local_id);
 
-	if (entry)
+	if (record)
 	{
 		// we've seen this object before
-		if (entry->getCRC() == crc)
+		if (record->mCRC == crc)
 		{
+			// Only objects that are actually used get their data copied out of the cache file.
+			LLVOCacheEntry* entry = mImpl->mCacheMap.getEntry(*record);
 			// Record a hit
 			entry->recordHit();
 		cache_miss_type = CACHE_MISS_TYPE_NONE;
@@ -1682,13 +1672,13 @@ void LLViewerRegion::dumpCache()
 		change_bin[i] = 0;
 	}
 
-	LLVOCacheEntry *entry;
-	for(LLVOCacheEntry::vocache_entry_map_t::iterator iter = mImpl->mCacheMap.begin(); iter != mImpl->mCacheMap.end(); ++iter)
+	const LLVOCacheObjectIndex& index = mImpl->mCacheMap.getIndex();
+	for(LLVOCacheObjectIndex::record_list_t::const_iterator iter = index.begin(); iter != index.end(); ++iter)
 	{
-		entry = iter->second ;
+		const LLVOCacheEntry* entry = iter->mEntry;
 
-		S32 hits = entry->getHitCount();
-		S32 changes = entry->getCRCChangeCount();
+		S32 hits = entry ? entry->getHitCount() : iter->mHitCount;
+		S32 changes = entry ? entry->getCRCChangeCount() : iter->mCRCChangeCount;
 
 		hits = llclamp(hits, 0, BINS-1);
 		changes = llclamp(changes, 0, BINS-1);
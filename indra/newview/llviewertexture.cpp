@@ -49,6 +49,7 @@
 #include "llimagegl.h"
 #include "lldrawpool.h"
 #include "lltexturefetch.h"
+#include "lltexturepriority.h"
 #include "llviewertexturelist.h"
 #include "llviewercontrol.h"
 #include "pipeline.h"
@@ -1044,6 +1045,7 @@ void LLViewerFetchedTexture::init(bool firstinit)
 	{
 		mDecodePriority = 0.f;
 		mInImageList = 0;
+		mTextureListIndex = -1;
 	}
 
 	// Only set mIsMissingAsset true when we know for certain that the database
@@ -1567,13 +1569,28 @@ void LLViewerFetchedTexture::processTextureStats()
 	}
 }
 
-const F32 MAX_PRIORITY_PIXEL                         = 999.f;     //pixel area
-const F32 PRIORITY_BOOST_LEVEL_FACTOR                = 1000.f;    //boost level
-const F32 PRIORITY_DELTA_DISCARD_LEVEL_FACTOR        = 100000.f;  //delta discard
-const S32 MAX_DELTA_DISCARD_LEVEL_FOR_PRIORITY       = 4;
-const F32 PRIORITY_ADDITIONAL_FACTOR                 = 1000000.f; //additional 
-const S32 MAX_ADDITIONAL_LEVEL_FOR_PRIORITY          = 8;
-const F32 PRIORITY_BOOST_HIGH_FACTOR                 = 10000000.f;//boost high
+void LLViewerFetchedTexture::getPriorityInput(LLTexturePriorityInput& input)
+{
+	input.mMaxVirtualSize = mMaxVirtualSize;
+	input.mTexelsPerImage = mTexelsPerImage;
+	input.mAdditionalPriority = mAdditionalDecodePriority;
+	input.mDecodePriority = mDecodePriority;
+	input.mBoostLevel = (S8)mBoostLevel;
+	input.mCurDiscard = (S8)getCurrentDiscardLevelForFetching();
+	input.mDesiredDiscard = mDesiredDiscardLevel;
+	input.mMaxDiscard = (S8)getMaxDiscardLevel();
+	input.mMinDiscard = (S8)mMinDiscardLevel;
+	input.mCachedRawDiscard = (S8)mCachedRawDiscardLevel;
+	input.mFlags = 0;
+	if (mNeedsCreateTexture)	input.mFlags |= LLTexturePriorityInput::NEEDS_CREATE;
+	if (mFullyLoaded)			input.mFlags |= LLTexturePriorityInput::FULLY_LOADED;
+	if (mForceToSaveRawImage)	input.mFlags |= LLTexturePriorityInput::FORCE_SAVE_RAW;
+	if (mIsMissingAsset)		input.mFlags |= LLTexturePriorityInput::MISSING_ASSET;
+	if (mCachedRawImageReady)	input.mFlags |= LLTexturePriorityInput::CACHED_RAW_READY;
+	if (isJustBound())			input.mFlags |= LLTexturePriorityInput::JUST_BOUND;
+	input.mPad = 0;
+}
+
 F32 LLViewerFetchedTexture::calcDecodePriority()
 {
 #ifndef LL_RELEASE_FOR_DOWNLOAD
@@ -1582,160 +1599,19 @@ F32 LLViewerFetchedTexture::calcDecodePriority()
 		LLAppViewer::getTextureFetch()->mDebugCount++; // for setting breakpoints
 	}
 #endif
-	
-	if (mNeedsCreateTexture)
-	{
-		return mDecodePriority; // no change while waiting to create
-	}
-	if(mFullyLoaded && !mForceToSaveRawImage)//already loaded for static texture
-	{
-		return -1.0f; //alreay fetched
-	}
 
-	S32 cur_discard = getCurrentDiscardLevelForFetching();
-	bool have_all_data = (cur_discard >= 0 && (cur_discard <= mDesiredDiscardLevel));
-	F32 pixel_priority = (F32) sqrt(mMaxVirtualSize);
-
-	F32 priority = 0.f;
-
-	if (mIsMissingAsset)
-	{
-		priority = 0.0f;
-	}
-	else if(mDesiredDiscardLevel >= cur_discard && cur_discard > -1)
-	{
-		priority = -2.0f;
-	}
-	else if(mCachedRawDiscardLevel > -1 && mDesiredDiscardLevel >= mCachedRawDiscardLevel)
-	{
-		priority = -3.0f;
-	}
-	else if (mDesiredDiscardLevel > getMaxDiscardLevel())
-	{
-		// Don't decode anything we don't need
-		priority = -4.0f;
-	}
-	else if ((mBoostLevel == LLGLTexture::BOOST_UI || mBoostLevel == LLGLTexture::BOOST_ICON) && !have_all_data)
-	{
-		priority = 1.f;
-	}
-	else if (pixel_priority < 0.001f && !have_all_data)
-	{
-		// Not on screen but we might want some data
-		if (mBoostLevel > BOOST_HIGH)
-		{
-			// Always want high boosted images
-			priority = 1.f;
-		}
-		else
-		{
-			priority = -5.f; //stop fetching
-		}
-	}
-	else if (cur_discard < 0)
-	{
-		//texture does not have any data, so we don't know the size of the image, treat it like 32 * 32.
-		// priority range = 100,000 - 500,000
-		static const F64 log_2 = log(2.0);
-		F32 desired = (F32)(log(32.0/pixel_priority) / log_2);
-		S32 ddiscard = MAX_DISCARD_LEVEL - (S32)desired;
-		ddiscard = llclamp(ddiscard, 0, MAX_DELTA_DISCARD_LEVEL_FOR_PRIORITY);
-		priority = (ddiscard + 1) * PRIORITY_DELTA_DISCARD_LEVEL_FACTOR;
-		setAdditionalDecodePriority(1.0f);//boost the textures without any data so far.
-	}
-	else if ((mMinDiscardLevel > 0) && (cur_discard <= mMinDiscardLevel))
-	{
-		// larger mips are corrupted
-		priority = -6.0f;
-	}
-	else
-	{
-		// priority range = 100,000 - 500,000
-		S32 desired_discard = mDesiredDiscardLevel;
-		if (!isJustBound() && mCachedRawImageReady)
-		{
-			if(mBoostLevel < BOOST_HIGH)
-			{
-				// We haven't rendered this in a while, de-prioritize it
-				desired_discard += 2;
-			}
-			else
-			{
-				// We haven't rendered this in the last half second, and we have a cached raw image, leave the desired discard as-is
-				desired_discard = cur_discard;
-			}
-		}
-
-		S32 ddiscard = cur_discard - desired_discard;
-		ddiscard = llclamp(ddiscard, -1, MAX_DELTA_DISCARD_LEVEL_FOR_PRIORITY);
-		priority = (ddiscard + 1) * PRIORITY_DELTA_DISCARD_LEVEL_FACTOR;		
-	}
-
-	// Priority Formula:
-	// BOOST_HIGH  +  ADDITIONAL PRI + DELTA DISCARD + BOOST LEVEL + PIXELS
-	// [10,000,000] + [1,000,000-9,000,000]  + [100,000-500,000]   + [1-20,000]  + [0-999]
-	if (priority > 0.0f)
-	{
-		bool large_enough = mCachedRawImageReady && ((S32)mTexelsPerImage > sMinLargeImageSize);
-		if(large_enough)
-		{
-			//Note: 
-			//to give small, low-priority textures some chance to be fetched, 
-			//cut the priority in half if the texture size is larger than 256 * 256 and has a 64*64 ready.
-			priority *= 0.5f; 
-		}
-
-		pixel_priority = llclamp(pixel_priority, 0.0f, MAX_PRIORITY_PIXEL); 
-
-		priority += pixel_priority + PRIORITY_BOOST_LEVEL_FACTOR * mBoostLevel;
-
-		if ( mBoostLevel > BOOST_HIGH)
-		{
-			if(mBoostLevel > BOOST_SUPER_HIGH)
-			{
-				//for very important textures, always grant the highest priority.
-				priority += PRIORITY_BOOST_HIGH_FACTOR;
-			}
-			else if(mCachedRawImageReady)
-			{
-				//Note: 
-				//to give small, low-priority textures some chance to be fetched, 
-				//if high priority texture has a 64*64 ready, lower its fetching priority.
-				setAdditionalDecodePriority(0.5f);
-			}
-			else
-			{
-				priority += PRIORITY_BOOST_HIGH_FACTOR;
-			}
-		}		
-
-		if(mAdditionalDecodePriority > 0.0f)
-		{
-			// priority range += 1,000,000.f-9,000,000.f
-			F32 additional = PRIORITY_ADDITIONAL_FACTOR * (1.0 + mAdditionalDecodePriority * MAX_ADDITIONAL_LEVEL_FOR_PRIORITY);
-			if(large_enough)
-			{
-				//Note: 
-				//to give small, low-priority textures some chance to be fetched, 
-				//cut the additional priority to a quarter if the texture size is larger than 256 * 256 and has a 64*64 ready.
-				additional *= 0.25f;
-			}
-			priority += additional;
-		}
-	}
+	LLTexturePriorityInput input;
+	getPriorityInput(input);
+	F32 additional_priority;
+	F32 priority = LLTexturePriority::calcPriority(input, sMinLargeImageSize, additional_priority);
+	setAdditionalDecodePriority(additional_priority);
 	return priority;
 }
 
 //static
 F32 LLViewerFetchedTexture::maxDecodePriority()
 {
-	static const F32 max_priority = PRIORITY_BOOST_HIGH_FACTOR +                           //boost_high
-		PRIORITY_ADDITIONAL_FACTOR * (MAX_ADDITIONAL_LEVEL_FOR_PRIORITY + 1) +             //additional (view dependent factors)
-		PRIORITY_DELTA_DISCARD_LEVEL_FACTOR * (MAX_DELTA_DISCARD_LEVEL_FOR_PRIORITY + 1) + //delta discard
-		PRIORITY_BOOST_LEVEL_FACTOR * (BOOST_MAX_LEVEL - 1) +                              //boost level
-		MAX_PRIORITY_PIXEL + 1.0f;                                                        //pixel area.
-	
-	return max_priority;
+	return LLTexturePriority::maxPriority();
 }
 
 //============================================================================
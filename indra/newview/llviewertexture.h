@@ -52,6 +52,7 @@ class LLViewerTexture;
 class LLViewerFetchedTexture ;
 class LLViewerMediaTexture ;
 class LLTexturePipelineTester ;
+struct LLTexturePriorityInput;
 
 
 typedef	void	(*loaded_callback_func)( BOOL success, LLViewerFetchedTexture *src_vi, LLImageRaw* src, LLImageRaw* src_aux, S32 discard_level, BOOL final, void* userdata );
@@ -324,6 +325,8 @@ public:
 	
 	virtual void processTextureStats() ;
 	F32  calcDecodePriority() ;
+	// Gathers everything calcDecodePriority() looks at, see lltexturepriority.h
+	void getPriorityInput(LLTexturePriorityInput& input);
 
 	BOOL needsAux() const { return mNeedsAux; }
 
@@ -367,6 +370,10 @@ public:
 	BOOL isInImageList() const {return mInImageList ;}
 	void setInImageList(BOOL flag) {mInImageList = flag ;}
 
+	// Slot in LLViewerTextureList's flat priority update array, -1 when not listed.
+	S32 getTextureListIndex() const {return mTextureListIndex ;}
+	void setTextureListIndex(S32 index) {mTextureListIndex = index ;}
+
 	LLFrameTimer* getLastPacketTimer() {return &mLastPacketTimer;}
 
 	U32 getFetchPriority() const { return mFetchPriority ;}
@@ -511,6 +518,7 @@ protected:
 	LLFrameTimer mStopFetchingTimer;	// Time since mDecodePriority == 0.f.
 
 	BOOL  mInImageList;				// TRUE if image is in list (in which case don't reset priority!)
+	S32   mTextureListIndex;		// Index into LLViewerTextureList::mPriorityImages
 	BOOL  mNeedsCreateTexture;	
 
 	BOOL   mForSculpt ; //a flag if the texture is used as sculpt data.
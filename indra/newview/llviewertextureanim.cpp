@@ -31,6 +31,7 @@
 
 #include "llmath.h"
 #include "llerror.h"
+#include "llthreadpool.h"
 
 std::vector<LLViewerTextureAnim*> LLViewerTextureAnim::sInstanceList;
 
@@ -61,12 +62,54 @@ void LLViewerTextureAnim::reset()
 	mTimer.reset();
 }
 
+namespace
+{
+	class LLTextureAnimJob : public LLThreadPool::Job
+	{
+	public:
+		LLTextureAnimJob(std::vector<LLViewerTextureAnim*> const& anims, std::vector<U8>& states) :
+			mAnims(anims), mStates(states) { }
+
+		/*virtual*/ void run(S32 begin, S32 end)
+		{
+			for (S32 i = begin; i < end; ++i)
+			{
+				mStates[i] = mAnims[i]->getVObj()->animateTexturesPrepare();
+			}
+		}
+
+	private:
+		std::vector<LLViewerTextureAnim*> const& mAnims;
+		std::vector<U8>& mStates;
+	};
+}
+
 //static 
-void LLViewerTextureAnim::updateClass()
+void LLViewerTextureAnim::updateClass(LLThreadPool* pool)
 {
-	for (std::vector<LLViewerTextureAnim*>::iterator iter = sInstanceList.begin(); iter != sInstanceList.end(); ++iter)
+	if (!pool)
 	{
-		(*iter)->mVObj->animateTextures();
+		for (std::vector<LLViewerTextureAnim*>::iterator iter = sInstanceList.begin(); iter != sInstanceList.end(); ++iter)
+		{
+			(*iter)->mVObj->animateTextures();
+		}
+		return;
+	}
+
+	static std::vector<U8> states;
+	S32 count = (S32)sInstanceList.size();
+	states.resize(count);
+
+	LLTextureAnimJob job(sInstanceList, states);
+	pool->parallelFor(job, count, 64);
+
+	// Pipeline updates and texture entry changes stay on the main thread.
+	for (S32 i = 0; i < count; ++i)
+	{
+		if (states[i] != LLVOVolume::TEX_ANIM_NONE)
+		{
+			sInstanceList[i]->mVObj->animateTexturesFinish(states[i]);
+		}
 	}
 }
 
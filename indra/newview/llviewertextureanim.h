@@ -30,6 +30,7 @@
 #include "lltextureanim.h"
 #include "llframetimer.h"
 
+class LLThreadPool;
 class LLVOVolume;
 
 class LLViewerTextureAnim : public LLTextureAnim
@@ -39,13 +40,16 @@ private:
 	S32 mInstanceIndex;
 
 public:
-	static void updateClass();
+	// Texture matrices are computed on the pool threads when a pool is given.
+	static void updateClass(LLThreadPool* pool = NULL);
 
 	LLViewerTextureAnim(LLVOVolume* vobj);
 	virtual ~LLViewerTextureAnim();
 
 	/*virtual*/ void reset();
 
+	LLVOVolume* getVObj() const { return mVObj; }
+
 	S32 animateTextures(F32 &off_s, F32 &off_t, F32 &scale_s, F32 &scale_t, F32 &rotate);
 	enum
 	{
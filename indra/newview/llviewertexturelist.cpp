@@ -325,6 +325,13 @@ void LLViewerTextureList::shutdown()
 	mLoadingStreamList.clear();
 	mCreateTextureList.clear();
 	
+	// mUUIDMap holds the references, so forget the images before they go away.
+	for (std::vector<LLViewerFetchedTexture*>::iterator iter = mPriorityImages.begin(); iter != mPriorityImages.end(); ++iter)
+	{
+		(*iter)->setTextureListIndex(-1);
+	}
+	mPriorityImages.clear();
+	mPriorityFlushImages.clear();
 	mUUIDMap.clear();
 	
 	mImageList.clear();
@@ -686,11 +693,14 @@ void LLViewerTextureList::addImage(LLViewerFetchedTexture *new_image)
 	if (image)
 	{
 		LL_INFOS() << "Image with ID " << image_id << " already in list" << LL_ENDL;
+		// mUUIDMap is about to forget about it, so should mPriorityImages.
+		removeFromPriorityImages(image);
 	}
 	sNumImages++;
 	
 	addImageToList(new_image);
 	mUUIDMap[image_id] = new_image;
+	addToPriorityImages(new_image);
 }
 
 
@@ -704,11 +714,35 @@ void LLViewerTextureList::deleteImage(LLViewerFetchedTexture *image)
 		}
 
 		llverify(mUUIDMap.erase(image->getID()) == 1);
+		removeFromPriorityImages(image);
 		sNumImages--;
 		removeImageFromList(image);
 	}
 }
 
+void LLViewerTextureList::addToPriorityImages(LLViewerFetchedTexture *image)
+{
+	llassert(image->getTextureListIndex() < 0);
+	image->setTextureListIndex((S32)mPriorityImages.size());
+	mPriorityImages.push_back(image);
+}
+
+void LLViewerTextureList::removeFromPriorityImages(LLViewerFetchedTexture *image)
+{
+	S32 index = image->getTextureListIndex();
+	if (index < 0)
+	{
+		return;
+	}
+	llassert(index < (S32)mPriorityImages.size() && mPriorityImages[index] == image);
+	// Swap with the last entry; order does not matter.
+	LLViewerFetchedTexture* last = mPriorityImages.back();
+	mPriorityImages[index] = last;
+	last->setTextureListIndex(index);
+	mPriorityImages.pop_back();
+	image->setTextureListIndex(-1);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 
@@ -838,106 +872,144 @@ void LLViewerTextureList::clearFetchingRequests()
 
 void LLViewerTextureList::updateImagesDecodePriorities()
 {
-	// Update the decode priority for N images each frame
-	{
-		F32 lazy_flush_timeout = 30.f; // stop decoding
-		F32 max_inactive_time  = 20.f; // actually delete
-		S32 min_refs = 3; // 1 for mImageList, 1 for mUUIDMap, 1 for local reference
-
-		//reset imagep->getLastReferencedTimer() when screen is showing the progress view to avoid removing pre-fetched textures too soon.
-		bool reset_timer = gViewerWindow->getProgressView()->getVisible();
-        
-        static const S32 MAX_PRIO_UPDATES = gSavedSettings.getS32("TextureFetchUpdatePriorities");         // default: 32
-		const size_t max_update_count = llmin((S32) (MAX_PRIO_UPDATES*MAX_PRIO_UPDATES*gFrameIntervalSeconds) + 1, MAX_PRIO_UPDATES);
-		S32 update_counter = llmin(max_update_count, mUUIDMap.size());
-		uuid_map_t::iterator iter = mUUIDMap.upper_bound(mLastUpdateUUID);
-		while ((update_counter-- > 0) && !mUUIDMap.empty())
+	// Update the decode priority of every image, every frame.
+	F32 lazy_flush_timeout = 30.f; // stop decoding
+	F32 max_inactive_time  = 20.f; // actually delete
+	S32 min_refs = 2; // 1 for mImageList, 1 for mUUIDMap
+
+	//reset imagep->getLastReferencedTimer() when screen is showing the progress view to avoid removing pre-fetched textures too soon.
+	bool reset_timer = gViewerWindow->getProgressView()->getVisible();
+
+	//
+	// Pass 1: lazy flush and (in)activity bookkeeping, which needs the texture itself,
+	// then gather the priority inputs of the remaining images into a flat array.
+	//
+	const S32 image_count = (S32)mPriorityImages.size();
+	mPriorityInputs.resize(image_count);
+	mPriorityInputImages.resize(image_count);
+	mPriorityFlushImages.clear();
+	S32 input_count = 0;
+	for (S32 i = 0; i < image_count; ++i)
+	{
+		LLViewerFetchedTexture* imagep = mPriorityImages[i];
+
+		//
+		// Flush formatted images using a lazy flush
+		//
+		S32 num_refs = imagep->getNumRefs();
+		if (num_refs == min_refs)
 		{
-			if (iter == mUUIDMap.end())
+			if(reset_timer)
 			{
-				iter = mUUIDMap.begin();
+				imagep->getLastReferencedTimer()->reset();
 			}
-			mLastUpdateUUID = iter->first;
-			LLPointer<LLViewerFetchedTexture> imagep = iter->second;
-			++iter; // safe to incrament now
-
-			//
-			// Flush formatted images using a lazy flush
-			//
-			S32 num_refs = imagep->getNumRefs();
-			if (num_refs == min_refs)
+			else if (imagep->getLastReferencedTimer()->getElapsedTimeF32() > lazy_flush_timeout)
 			{
-				if(reset_timer)
-				{
-					imagep->getLastReferencedTimer()->reset();
-				}
-				else if (imagep->getLastReferencedTimer()->getElapsedTimeF32() > lazy_flush_timeout)
-				{
-					// Remove the unused image from the image list
-					deleteImage(imagep);
-					imagep = NULL; // should destroy the image								
-				}
-				continue;
+				// Remove the unused image from the image list once we are done with the arrays
+				mPriorityFlushImages.push_back(imagep);
 			}
-			else
+			continue;
+		}
+		else
+		{
+			if(imagep->hasSavedRawImage())
 			{
-				if(imagep->hasSavedRawImage())
+				if(imagep->getElapsedLastReferencedSavedRawImageTime() > max_inactive_time)
 				{
-					if(imagep->getElapsedLastReferencedSavedRawImageTime() > max_inactive_time)
-					{
-						imagep->destroySavedRawImage() ;
-					}
+					imagep->destroySavedRawImage() ;
 				}
+			}
 
-				if(imagep->isDeleted())
-				{
-					continue ;
-				}
-				else if(imagep->isDeletionCandidate())
-				{
-					imagep->destroyTexture() ;																
-					continue ;
-				}
-				else if(imagep->isInactive())
+			if(imagep->isDeleted())
+			{
+				continue ;
+			}
+			else if(imagep->isDeletionCandidate())
+			{
+				imagep->destroyTexture() ;
+				continue ;
+			}
+			else if(imagep->isInactive())
+			{
+				if(reset_timer)
 				{
-					if(reset_timer)
-					{
-						imagep->getLastReferencedTimer()->reset();
-					}
-					else if (imagep->getLastReferencedTimer()->getElapsedTimeF32() > max_inactive_time)
-					{
-						imagep->setDeletionCandidate() ;
-					}
-					continue ;
+					imagep->getLastReferencedTimer()->reset();
 				}
-				else
+				else if (imagep->getLastReferencedTimer()->getElapsedTimeF32() > max_inactive_time)
 				{
-					imagep->getLastReferencedTimer()->reset();
-
-					//reset texture state.
-					imagep->setInactive() ;										
+					imagep->setDeletionCandidate() ;
 				}
+				continue ;
 			}
-			
-			if (!imagep->isInImageList())
+			else
 			{
-				continue;
+				imagep->getLastReferencedTimer()->reset();
+
+				//reset texture state.
+				imagep->setInactive() ;
 			}
-			imagep->processTextureStats();
-			F32 old_priority = imagep->getDecodePriority();
-			F32 old_priority_test = llmax(old_priority, 0.0f);
-			F32 decode_priority = imagep->calcDecodePriority();
-			F32 decode_priority_test = llmax(decode_priority, 0.0f);
-			// Ignore < 20% difference
-			if ((decode_priority_test < old_priority_test * .8f) ||
-				(decode_priority_test > old_priority_test * 1.25f))
+		}
+
+		if (!imagep->isInImageList())
+		{
+			continue;
+		}
+		imagep->processTextureStats();
+		imagep->getPriorityInput(mPriorityInputs[input_count]);
+		mPriorityInputImages[input_count] = i;
+		++input_count;
+	}
+
+	//
+	// Pass 2: the priority math, straight over the arrays.
+	//
+	mPriorityOutputs.resize(input_count);
+	if (input_count > 0)
+	{
+		LLTexturePriority::calcPriorities(&mPriorityInputs[0], &mPriorityOutputs[0], input_count,
+										  LLViewerTexture::sMinLargeImageSize);
+	}
+
+	//
+	// Pass 3: re-sort the images whose priority changed enough, and hand those that
+	// have a fetch request to the fetcher in one go.
+	//
+	mPriorityFetchUpdates.clear();
+	for (S32 i = 0; i < input_count; ++i)
+	{
+		LLViewerFetchedTexture* imagep = mPriorityImages[mPriorityInputImages[i]];
+		const LLTexturePriorityOutput& output = mPriorityOutputs[i];
+		imagep->setAdditionalDecodePriority(output.mAdditionalPriority);
+
+		F32 old_priority_test = llmax(imagep->getDecodePriority(), 0.0f);
+		F32 decode_priority = output.mDecodePriority;
+		F32 decode_priority_test = llmax(decode_priority, 0.0f);
+		// Ignore < 20% difference
+		if ((decode_priority_test < old_priority_test * .8f) ||
+			(decode_priority_test > old_priority_test * 1.25f))
+		{
+			removeImageFromList(imagep);
+			imagep->setDecodePriority(decode_priority);
+			addImageToList(imagep);
+			if (imagep->hasFetcher() && decode_priority > 0.0f)
 			{
-				removeImageFromList(imagep);
-				imagep->setDecodePriority(decode_priority);
-				addImageToList(imagep);
+				mPriorityFetchUpdates.push_back(std::make_pair(imagep->getID(), decode_priority));
 			}
 		}
 	}
+	if (!mPriorityFetchUpdates.empty())
+	{
+		LLAppViewer::getTextureFetch()->updateRequestPriorities(mPriorityFetchUpdates);
+	}
+
+	// Now that nothing indexes into mPriorityImages anymore, drop the flushed images.
+	// The references held here keep them alive until the lists are done with them.
+	for (std::vector<LLPointer<LLViewerFetchedTexture> >::iterator iter = mPriorityFlushImages.begin();
+		 iter != mPriorityFlushImages.end(); ++iter)
+	{
+		deleteImage(*iter);
+	}
+	mPriorityFlushImages.clear(); // should destroy the images
 }
 
 /*
@@ -32,6 +32,8 @@
 #include "llgl.h"
 #include "llstat.h"
 #include "llviewertexture.h"
+#include "lltexturefetch.h"
+#include "lltexturepriority.h"
 #include "llui.h"
 #include <list>
 #include <set>
@@ -128,6 +130,9 @@ private:
 	void addImageToList(LLViewerFetchedTexture *image);
 	void removeImageFromList(LLViewerFetchedTexture *image);
 
+	void addToPriorityImages(LLViewerFetchedTexture *image);
+	void removeFromPriorityImages(LLViewerFetchedTexture *image);
+
 	LLViewerFetchedTexture * getImage(const LLUUID &image_id,									 
 									 FTType f_type = FTT_DEFAULT,
 									 BOOL usemipmap = TRUE,
@@ -187,8 +192,17 @@ public:
 private:
 	typedef std::map< LLUUID, LLPointer<LLViewerFetchedTexture> > uuid_map_t;
 	uuid_map_t mUUIDMap;
-	LLUUID mLastUpdateUUID;
 	LLUUID mLastFetchUUID;
+
+	// Flat mirror of mUUIDMap, walked in full by updateImagesDecodePriorities() every frame.
+	// Raw pointers: mUUIDMap holds the reference.
+	std::vector<LLViewerFetchedTexture*> mPriorityImages;
+	// Per frame scratch arrays, kept around so their capacity is reused.
+	std::vector<LLTexturePriorityInput> mPriorityInputs;
+	std::vector<LLTexturePriorityOutput> mPriorityOutputs;
+	std::vector<S32> mPriorityInputImages;		// mPriorityImages index of each input
+	std::vector<LLPointer<LLViewerFetchedTexture> > mPriorityFlushImages;
+	LLTextureFetch::request_priority_list_t mPriorityFetchUpdates;
 	
 	typedef std::set<LLPointer<LLViewerFetchedTexture>, LLViewerFetchedTexture::Compare> image_priority_list_t;	
 	image_priority_list_t mImageList;
@@ -64,6 +64,19 @@ LLVOCacheEntry::LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &
 	mDP = dp; //memcpy
 }
 
+LLVOCacheEntry::LLVOCacheEntry(const LLVOCacheObjectIndex::Record& record, const U8* data)
+	:
+	mLocalID(record.mLocalID),
+	mCRC(record.mCRC),
+	mHitCount(record.mHitCount),
+	mDupeCount(record.mDupeCount),
+	mCRCChangeCount(record.mCRCChangeCount)
+{
+	mBuffer = new U8[record.mSize];
+	memcpy(mBuffer, data, record.mSize);
+	mDP.assignBuffer(mBuffer, record.mSize);
+}
+
 LLVOCacheEntry::LLVOCacheEntry()
 	:
 	mLocalID(0),
@@ -227,13 +240,179 @@ BOOL LLVOCacheEntry::writeToFile(LLAPRFile* apr_file) const
 	return success ;
 }
 
+//---------------------------------------------------------------------------
+// LLVOCacheEntryList
+//---------------------------------------------------------------------------
+
+// Corruption in the cache entries
+const S32 MAX_CACHE_ENTRY_SIZE = 10000;
+
+template<typename T>
+static bool read_data(const std::vector<U8>& data, S32& pos, T& value)
+{
+	if (pos + (S32)sizeof(T) > (S32)data.size())
+	{
+		return false;
+	}
+	memcpy(&value, &data[pos], sizeof(T));
+	pos += sizeof(T);
+	return true;
+}
+
+void LLVOCacheEntryList::clear()
+{
+	for (LLVOCacheObjectIndex::record_list_t::iterator iter = mIndex.begin(); iter != mIndex.end(); ++iter)
+	{
+		delete iter->mEntry;
+	}
+	mIndex.clear();
+	std::vector<U8>().swap(mFileData);
+}
+
+LLVOCacheEntry* LLVOCacheEntryList::getEntry(LLVOCacheObjectIndex::Record& record)
+{
+	if (!record.mEntry)
+	{
+		record.mEntry = new LLVOCacheEntry(record, &mFileData[record.mOffset]);
+	}
+	return record.mEntry;
+}
+
+void LLVOCacheEntryList::recordDupe(LLVOCacheObjectIndex::Record& record)
+{
+	if (record.mEntry)
+	{
+		record.mEntry->recordDupe();
+	}
+	else
+	{
+		record.mDupeCount++;
+	}
+}
+
+void LLVOCacheEntryList::setEntry(LLVOCacheEntry* entry)
+{
+	LLVOCacheObjectIndex::Record& record = mIndex.insert(entry->getLocalID());
+	delete record.mEntry;
+	record.mEntry = entry;
+	record.mCRC = entry->getCRC();
+	record.mOffset = -1;
+	record.mSize = 0;
+}
+
+S32 LLVOCacheEntryList::evict(S32 max_entries)
+{
+	std::vector<LLVOCacheEntry*> evicted;
+	S32 removed = mIndex.evict(max_entries, evicted);
+	for (std::vector<LLVOCacheEntry*>::iterator iter = evicted.begin(); iter != evicted.end(); ++iter)
+	{
+		delete *iter;
+	}
+	return removed;
+}
+
+BOOL LLVOCacheEntryList::readFromFile(LLAPRFile* apr_file, S32 size, const LLUUID& id)
+{
+	clear();
+	if (size < UUID_BYTES + (S32)sizeof(S32))
+	{
+		return FALSE;
+	}
+
+	// Read the whole file at once; the object blobs stay in there until looked up.
+	mFileData.resize(size);
+	if (!check_read(apr_file, &mFileData[0], size))
+	{
+		clear();
+		return FALSE;
+	}
+
+	S32 pos = 0;
+	LLUUID cache_id;
+	memcpy(cache_id.mData, &mFileData[0], UUID_BYTES);
+	pos += UUID_BYTES;
+	if (cache_id != id)
+	{
+		LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
+		clear();
+		return FALSE;
+	}
+
+	S32 num_entries = 0;
+	if (!read_data(mFileData, pos, num_entries))
+	{
+		clear();
+		return FALSE;
+	}
+	// Every entry takes at least six words and one byte of data.
+	mIndex.reserve(llclamp(num_entries, 0, size / (S32)(6 * sizeof(S32) + 1)));
+	for (S32 i = 0; i < num_entries; i++)
+	{
+		U32 local_id = 0;
+		U32 crc = 0;
+		S32 hits = 0, dupes = 0, changes = 0, entry_size = 0;
+		bool success = read_data(mFileData, pos, local_id) &&
+					   read_data(mFileData, pos, crc) &&
+					   read_data(mFileData, pos, hits) &&
+					   read_data(mFileData, pos, dupes) &&
+					   read_data(mFileData, pos, changes) &&
+					   read_data(mFileData, pos, entry_size);
+		if (!success || !local_id || entry_size < 1 || entry_size > MAX_CACHE_ENTRY_SIZE ||
+			pos + entry_size > (S32)mFileData.size())
+		{
+			// We won't bother going on, the rest of this file is likely bogus.
+			return FALSE;
+		}
+
+		LLVOCacheObjectIndex::Record& record = mIndex.insert(local_id);
+		record.mCRC = crc;
+		record.mOffset = pos;
+		record.mSize = entry_size;
+		record.mHitCount = hits;
+		record.mDupeCount = dupes;
+		record.mCRCChangeCount = changes;
+		pos += entry_size;
+	}
+	return TRUE;
+}
+
+BOOL LLVOCacheEntryList::writeToFile(LLAPRFile* apr_file, const LLUUID& id) const
+{
+	BOOL success = check_write(apr_file, (void*)id.mData, UUID_BYTES);
+	if (success)
+	{
+		S32 num_entries = mIndex.size();
+		success = check_write(apr_file, &num_entries, sizeof(S32));
+	}
+
+	for (LLVOCacheObjectIndex::record_list_t::const_iterator iter = mIndex.begin(); success && iter != mIndex.end(); ++iter)
+	{
+		const LLVOCacheObjectIndex::Record& record = *iter;
+		if (record.mEntry)
+		{
+			success = record.mEntry->writeToFile(apr_file);
+			continue;
+		}
+
+		// Never looked up, write it back straight from the file data.
+		success = check_write(apr_file, (void*)&record.mLocalID, sizeof(U32)) &&
+				  check_write(apr_file, (void*)&record.mCRC, sizeof(U32)) &&
+				  check_write(apr_file, (void*)&record.mHitCount, sizeof(S32)) &&
+				  check_write(apr_file, (void*)&record.mDupeCount, sizeof(S32)) &&
+				  check_write(apr_file, (void*)&record.mCRCChangeCount, sizeof(S32)) &&
+				  check_write(apr_file, (void*)&record.mSize, sizeof(S32)) &&
+				  check_write(apr_file, (void*)&mFileData[record.mOffset], record.mSize);
+	}
+	return success;
+}
+
 //-------------------------------------------------------------------
 //LLVOCache
 //-------------------------------------------------------------------
 // Format string used to construct filename for the object cache
 static const char OBJECT_CACHE_FILENAME[] = "objects_%d_%d.slc";
 
-const U32 MAX_NUM_OBJECT_ENTRIES = 128 ;
+const U32 MAX_NUM_OBJECT_ENTRIES = 256 ;
 const U32 MIN_ENTRIES_TO_PURGE = 16 ;
 const U32 INVALID_TIME = 0 ;
 const char* object_cache_dirname = "objectcache";
@@ -271,9 +450,12 @@ LLVOCache::LLVOCache():
 	mInitialized(FALSE),
 	mReadOnly(TRUE),
 	mNumEntries(0),
-	mCacheSize(1)
+	mCacheSize(1),
+	mHeaderEntries(MAX_NUM_OBJECT_ENTRIES),
+	mRegionLRU(MAX_NUM_OBJECT_ENTRIES)
 {
 	mEnabled = gSavedSettings.getBOOL("ObjectCacheEnabled");
+	clearCacheInMemory();
 }
 
 LLVOCache::~LLVOCache()
@@ -312,6 +494,7 @@ void LLVOCache::initCache(ELLPath location, U32 size, U32 cache_version)
 		LLFile::mkdir(mObjectCacheDirName);
 	}
 	mCacheSize = llclamp(size, MIN_ENTRIES_TO_PURGE, MAX_NUM_OBJECT_ENTRIES);
+	mRegionLRU.setBudget(mCacheSize);
 	mMetaInfo.mVersion = cache_version;
 	readCacheHeader();	
 
@@ -368,54 +551,40 @@ void LLVOCache::removeCache()
 	writeCacheHeader();
 }
 
-void LLVOCache::removeEntry(HeaderEntryInfo* entry) 
+void LLVOCache::removeEntry(S32 slot) 
 {
 	llassert_always(mInitialized) ;
 	if(mReadOnly)
 	{
 		return ;
 	}
-	if(!entry)
+	if(slot < 0 || !mRegionLRU.isUsed(slot))
 	{
 		return ;
 	}
 
-	header_entry_queue_t::iterator iter = mHeaderEntryQueue.find(entry) ;
-	if(iter != mHeaderEntryQueue.end())
-	{		
-		mHandleEntryMap.erase(entry->mHandle) ;		
-		mHeaderEntryQueue.erase(iter) ;
-		removeFromCache(entry) ;
-		delete entry ;
+	mRegionLRU.remove(slot) ;
+	removeFromCache(slot) ;
 
-		mNumEntries = mHandleEntryMap.size() ;
-	}
+	mNumEntries = mRegionLRU.getCount() ;
 }
 
 void LLVOCache::removeEntry(U64 handle) 
 {
-	handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
-	if(iter == mHandleEntryMap.end()) //no cache
-	{
-		return ;
-	}
-	HeaderEntryInfo* entry = iter->second ;
-	removeEntry(entry) ;
+	removeEntry(mRegionLRU.find(handle)) ;
 }
 
 void LLVOCache::clearCacheInMemory()
 {
-	if(!mHeaderEntryQueue.empty()) 
+	mRegionLRU.clear();
+	for(S32 i = 0; i < (S32)mHeaderEntries.size(); i++)
 	{
-		for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin(); iter != mHeaderEntryQueue.end(); ++iter)
-		{
-			delete *iter ;
-		}
-		mHeaderEntryQueue.clear();
-		mHandleEntryMap.clear();
-		mNumEntries = 0 ;
+		HeaderEntryInfo& entry = mHeaderEntries[i];
+		entry.mIndex = i;
+		entry.mHandle = 0;
+		entry.mTime = INVALID_TIME;
 	}
-
+	mNumEntries = 0 ;
 }
 
 void LLVOCache::getObjectCacheFilename(U64 handle, std::string& filename) 
@@ -429,21 +598,31 @@ void LLVOCache::getObjectCacheFilename(U64 handle, std::string& filename)
 	return ;
 }
 
-void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
+void LLVOCache::removeFromCache(S32 slot)
 {
+	HeaderEntryInfo& entry = mHeaderEntries[slot];
 	if(mReadOnly)
 	{
-		LL_WARNS() << "Not removing cache for handle " << entry->mHandle << ": Cache is currently in read-only mode." << LL_ENDL;
+		LL_WARNS() << "Not removing cache for handle " << entry.mHandle << ": Cache is currently in read-only mode." << LL_ENDL;
 		return ;
 	}
 
 	std::string filename;
-	getObjectCacheFilename(entry->mHandle, filename);
+	getObjectCacheFilename(entry.mHandle, filename);
 	LLAPRFile::remove(filename);
-	entry->mTime = INVALID_TIME ;
-	updateEntry(entry) ; //update the head file.
+	entry.mHandle = 0 ;
+	entry.mTime = INVALID_TIME ;
+	updateEntry(slot) ; //update the head file.
 }
 
+struct LLHeaderEntryOlder
+{
+	bool operator()(const std::pair<U32, S32>& lhs, const std::pair<U32, S32>& rhs) const
+	{
+		return lhs.first < rhs.first;
+	}
+};
+
 void LLVOCache::readCacheHeader()
 {
 	if(!mEnabled)
@@ -458,44 +637,49 @@ void LLVOCache::readCacheHeader()
 	bool success = true ;
 	if (LLAPRFile::isExist(mHeaderFileName))
 	{
-		LLAPRFile apr_file(mHeaderFileName, APR_READ|APR_BINARY);		
+		S32 num_slots = 0 ;
+		{
+			LLAPRFile apr_file(mHeaderFileName, APR_READ|APR_BINARY|APR_BUFFERED);		
 		
-		//read the meta element
-		success = check_read(&apr_file, &mMetaInfo, sizeof(HeaderMetaInfo)) ;
+			//read the meta element
+			success = check_read(&apr_file, &mMetaInfo, sizeof(HeaderMetaInfo)) ;
 		
+			// A header cut short is repaired below, stop at the end of the file.
+			while(success && num_slots < (S32)MAX_NUM_OBJECT_ENTRIES &&
+				  check_read(&apr_file, &mHeaderEntries[num_slots], sizeof(HeaderEntryInfo)))
+			{
+				mHeaderEntries[num_slots].mIndex = num_slots ;
+				num_slots++ ;
+			}
+		}
+
 		if(success)
 		{
-			HeaderEntryInfo* entry = NULL ;
-			mNumEntries = 0 ;
-			U32 num_read = 0 ;
-			while(num_read++ < MAX_NUM_OBJECT_ENTRIES)
+			// Link the regions from the oldest to the most recently used one.
+			std::vector<std::pair<U32, S32> > by_time ;
+			for(S32 i = 0; i < num_slots; i++)
 			{
-				if(!entry)
+				if(mHeaderEntries[i].mTime != INVALID_TIME)
 				{
-					entry = new HeaderEntryInfo() ;
+					by_time.push_back(std::make_pair(mHeaderEntries[i].mTime, i)) ;
 				}
-				success = check_read(&apr_file, entry, sizeof(HeaderEntryInfo));
-								
-				if(!success) //failed
-				{
-					LL_WARNS() << "Error reading cache header entry. (entry_index=" << mNumEntries << ")" << LL_ENDL;
-					delete entry ;
-					entry = NULL ;
-					break ;
-				}
-				else if(entry->mTime == INVALID_TIME)
+			}
+			std::stable_sort(by_time.begin(), by_time.end(), LLHeaderEntryOlder()) ;
+			for(std::vector<std::pair<U32, S32> >::iterator iter = by_time.begin(); iter != by_time.end(); ++iter)
+			{
+				HeaderEntryInfo& entry = mHeaderEntries[iter->second] ;
+				if(!mRegionLRU.insertAt(iter->second, entry.mHandle))
 				{
-					continue ; //an empty entry
+					LL_WARNS() << "Duplicate cache header entry. (entry_index=" << iter->second << ")" << LL_ENDL;
+					entry.mHandle = 0 ;
+					entry.mTime = INVALID_TIME ;
 				}
-
-				entry->mIndex = mNumEntries++ ;
-				mHeaderEntryQueue.insert(entry) ;
-				mHandleEntryMap[entry->mHandle] = entry ;
-				entry = NULL ;
 			}
-			if(entry)
+			mNumEntries = mRegionLRU.getCount() ;
+
+			if(num_slots < (S32)MAX_NUM_OBJECT_ENTRIES && !mReadOnly)
 			{
-				delete entry ;
+				writeCacheHeader() ; //pad the header to the full number of records.
 			}
 		}
 
@@ -503,9 +687,9 @@ void LLVOCache::readCacheHeader()
 		//debug code
 		//----------
 		//std::string name ;
-		//for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin() ; success && iter != mHeaderEntryQueue.end(); ++iter)
+		//for(S32 slot = mRegionLRU.getLeastRecent() ; success && slot >= 0; slot = mRegionLRU.getMoreRecent(slot))
 		//{
-		//	getObjectCacheFilename((*iter)->mHandle, name) ;
+		//	getObjectCacheFilename(mRegionLRU.getHandle(slot), name) ;
 		//	LL_INFOS() << name << LL_ENDL ;
 		//}
 		//-----------
@@ -543,32 +727,18 @@ void LLVOCache::writeCacheHeader()
 
 	bool success = true ;
 	{
-		LLAPRFile apr_file(mHeaderFileName, APR_CREATE|APR_WRITE|APR_BINARY);
+		LLAPRFile apr_file(mHeaderFileName, APR_CREATE|APR_WRITE|APR_BINARY|APR_BUFFERED);
 
 		//write the meta element
 		success = check_write(&apr_file, &mMetaInfo, sizeof(HeaderMetaInfo)) ;
 
-
-		mNumEntries = 0 ;	
-		for(header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin() ; success && iter != mHeaderEntryQueue.end(); ++iter)
+		// Every region keeps its record, unused ones are written as empty entries.
+		for(S32 i = 0 ; success && i < (S32)mHeaderEntries.size(); i++)
 		{
-			(*iter)->mIndex = mNumEntries++ ;
-			success = check_write(&apr_file, (void*)*iter, sizeof(HeaderEntryInfo));
+			success = check_write(&apr_file, (void*)&mHeaderEntries[i], sizeof(HeaderEntryInfo));
 		}
 	
-		mNumEntries = mHeaderEntryQueue.size() ;
-		if(success && mNumEntries < MAX_NUM_OBJECT_ENTRIES)
-		{
-			HeaderEntryInfo* entry = new HeaderEntryInfo() ;
-			entry->mTime = INVALID_TIME ;
-			for(S32 i = mNumEntries ; success && i < MAX_NUM_OBJECT_ENTRIES ; i++)
-			{
-				//fill the cache with the default entry.
-				success = check_write(&apr_file, entry, sizeof(HeaderEntryInfo)) ;			
-
-			}
-			delete entry ;
-		}
+		mNumEntries = mRegionLRU.getCount() ;
 	}
 
 	if(!success)
@@ -579,15 +749,15 @@ void LLVOCache::writeCacheHeader()
 	return ;
 }
 
-BOOL LLVOCache::updateEntry(const HeaderEntryInfo* entry)
+BOOL LLVOCache::updateEntry(S32 slot)
 {
 	LLAPRFile apr_file(mHeaderFileName, APR_WRITE|APR_BINARY);
-	apr_file.seek(APR_SET, entry->mIndex * sizeof(HeaderEntryInfo) + sizeof(HeaderMetaInfo)) ;
+	apr_file.seek(APR_SET, slot * sizeof(HeaderEntryInfo) + sizeof(HeaderMetaInfo)) ;
 
-	return check_write(&apr_file, (void*)entry, sizeof(HeaderEntryInfo)) ;
+	return check_write(&apr_file, (void*)&mHeaderEntries[slot], sizeof(HeaderEntryInfo)) ;
 }
 
-void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) 
+void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntryList& cache_entries) 
 {
 	if(!mEnabled)
 	{
@@ -596,8 +766,8 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 	}
 	llassert_always(mInitialized);
 
-	handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
-	if(iter == mHandleEntryMap.end()) //no cache
+	S32 slot = mRegionLRU.find(handle) ;
+	if(slot < 0) //no cache
 	{
 		LL_WARNS() << "No handle map entry for " << handle << LL_ENDL;
 		return ;
@@ -607,48 +777,21 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 	{
 		std::string filename;
 		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_READ|APR_BINARY);
-	
-		LLUUID cache_id ;
-		success = check_read(&apr_file, cache_id.mData, UUID_BYTES) ;
-	
-		if(success)
-		{		
-			if(cache_id != id)
-			{
-				LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
-				success = false ;
-			}
-
-			if(success)
-			{
-				S32 num_entries;
-				success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
+		S32 file_size = 0 ;
+		LLAPRFile apr_file(filename, APR_READ|APR_BINARY, &file_size);
 	
-				if(success)
-				{
-					for (S32 i = 0; i < num_entries; i++)
-					{
-						LLVOCacheEntry* entry = new LLVOCacheEntry(&apr_file);
-						if (!entry->getLocalID())
-						{
-							LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-							delete entry ;
-							success = false ;
-							break ;
-						}
-						cache_entry_map[entry->getLocalID()] = entry;
-					}
-				}
-			}
-		}		
+		success = cache_entries.readFromFile(&apr_file, file_size, id) ;
+		if(!success && !cache_entries.empty())
+		{
+			LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+		}
 	}
 	
 	if(!success)
 	{
-		if(cache_entry_map.empty())
+		if(cache_entries.empty())
 		{
-			removeEntry(iter->second) ;
+			removeEntry(slot) ;
 		}
 	}
 
@@ -657,19 +800,16 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 	
 void LLVOCache::purgeEntries(U32 size)
 {
-	while(mHeaderEntryQueue.size() > size)
+	while((U32)mRegionLRU.getCount() > size)
 	{
-		header_entry_queue_t::iterator iter = mHeaderEntryQueue.begin() ;
-		HeaderEntryInfo* entry = *iter ;			
-		mHandleEntryMap.erase(entry->mHandle);
-		mHeaderEntryQueue.erase(iter) ;
-		removeFromCache(entry) ;
-		delete entry;
+		S32 slot = mRegionLRU.getLeastRecent() ;
+		mRegionLRU.remove(slot) ;
+		removeFromCache(slot) ;
 	}
-	mNumEntries = mHandleEntryMap.size() ;
+	mNumEntries = mRegionLRU.getCount() ;
 }
 
-void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, BOOL dirty_cache) 
+void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntryList& cache_entries, BOOL dirty_cache) 
 {
 	if(!mEnabled)
 	{
@@ -684,38 +824,37 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 		return ;
 	}	
 
-	HeaderEntryInfo* entry;
-	handle_entry_map_t::iterator iter = mHandleEntryMap.find(handle) ;
-	if(iter == mHandleEntryMap.end()) //new entry
+	S32 slot = mRegionLRU.find(handle) ;
+	if(slot < 0) //new entry
 	{				
 		if(mNumEntries >= mCacheSize - 1)
 		{
 			purgeEntries(mCacheSize - 1) ;
 		}
 
-		entry = new HeaderEntryInfo();
-		entry->mHandle = handle ;
-		entry->mTime = time(NULL) ;
-		entry->mIndex = mNumEntries++;
-		mHeaderEntryQueue.insert(entry) ;
-		mHandleEntryMap[handle] = entry ;
+		slot = mRegionLRU.insert(handle) ;
+		if(slot < 0)
+		{
+			LL_WARNS() << "No free cache header entry for handle " << handle << LL_ENDL;
+			return ;
+		}
+		mNumEntries = mRegionLRU.getCount() ;
 	}
 	else
 	{
 		// Update access time.
-		entry = iter->second ;		
-
-		//resort
-		mHeaderEntryQueue.erase(entry) ;
-		
-		entry->mTime = time(NULL) ;
-		mHeaderEntryQueue.insert(entry) ;
+		mRegionLRU.touch(slot) ;
 	}
 
+	HeaderEntryInfo& entry = mHeaderEntries[slot] ;
+	entry.mIndex = slot ;
+	entry.mHandle = handle ;
+	entry.mTime = time(NULL) ;
+
 	//update cache header
-	if(!updateEntry(entry))
+	if(!updateEntry(slot))
 	{
-		LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". handle = " << handle << LL_ENDL;
+		LL_WARNS() << "Failed to update cache header index " << slot << ". handle = " << handle << LL_ENDL;
 		return ; //update failed.
 	}
 
@@ -730,29 +869,16 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 	{
 		std::string filename;
 		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY);
-	
-		success = check_write(&apr_file, (void*)id.mData, UUID_BYTES) ;
-
+		LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_TRUNCATE|APR_BINARY|APR_BUFFERED);
 	
-		if(success)
-		{
-			S32 num_entries = cache_entry_map.size() ;
-			success = check_write(&apr_file, &num_entries, sizeof(S32));
-	
-			for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
-			{
-				success = iter->second->writeToFile(&apr_file) ;
-			}
-		}
+		success = cache_entries.writeToFile(&apr_file, id) ;
 	}
 
 	if(!success)
 	{
-		removeEntry(entry) ;
+		removeEntry(slot) ;
 
 	}
 
 	return ;
 }
-
@@ -36,6 +36,7 @@
 #include "lluuid.h"
 #include "lldatapacker.h"
 #include "lldir.h"
+#include "llvocacheindex.h"
 
 
 //---------------------------------------------------------------------------
@@ -47,6 +48,8 @@ class LLVOCacheEntry
 public:
 	LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
 	LLVOCacheEntry(LLAPRFile* apr_file);
+	// Copies the blob of an object read from a region cache file.
+	LLVOCacheEntry(const LLVOCacheObjectIndex::Record& record, const U8* data);
 	LLVOCacheEntry();
 	~LLVOCacheEntry();
 
@@ -62,9 +65,6 @@ public:
 	void recordHit();
 	void recordDupe() { mDupeCount++; }
 
-public:
-	typedef std::map<U32, LLVOCacheEntry*>	vocache_entry_map_t;
-
 protected:
 	U32							mLocalID;
 	U32							mCRC;
@@ -75,6 +75,41 @@ protected:
 	U8							*mBuffer;
 };
 
+// The cached objects of one region. The region cache file is read in one go
+// and kept as is; LLVOCacheEntry objects are only created for the objects
+// that are actually looked up, the others are written back from that data.
+class LLVOCacheEntryList
+{
+public:
+	LLVOCacheEntryList() {}
+	~LLVOCacheEntryList()					{ clear(); }
+
+	void clear();
+	bool empty() const						{ return mIndex.empty(); }
+	S32 size() const						{ return mIndex.size(); }
+
+	LLVOCacheObjectIndex::Record* find(U32 local_id)	{ return mIndex.find(local_id); }
+	// Returns the entry of 'record', creating it from the file data on first use.
+	LLVOCacheEntry* getEntry(LLVOCacheObjectIndex::Record& record);
+	void recordDupe(LLVOCacheObjectIndex::Record& record);
+	// Takes ownership of 'entry', replacing any entry with the same local id.
+	void setEntry(LLVOCacheEntry* entry);
+	// Drops the least hit objects when there are more than 'max_entries'.
+	S32 evict(S32 max_entries);
+
+	const LLVOCacheObjectIndex& getIndex() const	{ return mIndex; }
+
+	BOOL readFromFile(LLAPRFile* apr_file, S32 size, const LLUUID& id);
+	BOOL writeToFile(LLAPRFile* apr_file, const LLUUID& id) const;
+
+private:
+	LLVOCacheObjectIndex	mIndex;
+	std::vector<U8>			mFileData;
+
+	LLVOCacheEntryList(const LLVOCacheEntryList&);
+	LLVOCacheEntryList& operator=(const LLVOCacheEntryList&);
+};
+
 //
 //Note: LLVOCache is not thread-safe
 //
@@ -96,20 +131,6 @@ private:
 		U32 mVersion;
 	};
 
-	struct header_entry_less
-	{
-		bool operator()(const HeaderEntryInfo* lhs, const HeaderEntryInfo* rhs) const
-		{
-			if(lhs->mTime == rhs->mTime) 
-			{
-				return lhs < rhs ;
-			}
-			
-			return lhs->mTime < rhs->mTime ; // older entry in front of queue (set)
-		}
-	};
-	typedef std::set<HeaderEntryInfo*, header_entry_less> header_entry_queue_t;
-	typedef std::map<U64, HeaderEntryInfo*> handle_entry_map_t;
 private:
 	LLVOCache() ;
 
@@ -119,8 +140,8 @@ public:
 	void initCache(ELLPath location, U32 size, U32 cache_version) ;
 	void removeCache(ELLPath location) ;
 
-	void readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) ;
-	void writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, BOOL dirty_cache) ;
+	void readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntryList& cache_entries) ;
+	void writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntryList& cache_entries, BOOL dirty_cache) ;
 	void removeEntry(U64 handle) ;
 
 	void setReadOnly(BOOL read_only) {mReadOnly = read_only;} 
@@ -129,14 +150,14 @@ private:
 	void setDirNames(ELLPath location);	
 	// determine the cache filename for the region from the region handle	
 	void getObjectCacheFilename(U64 handle, std::string& filename);
-	void removeFromCache(HeaderEntryInfo* entry);
+	void removeFromCache(S32 slot);
 	void readCacheHeader();
 	void writeCacheHeader();
 	void clearCacheInMemory();
 	void removeCache() ;
-	void removeEntry(HeaderEntryInfo* entry) ;
+	void removeEntry(S32 slot) ;
 	void purgeEntries(U32 size);
-	BOOL updateEntry(const HeaderEntryInfo* entry);
+	BOOL updateEntry(S32 slot);
 	
 private:
 	BOOL                 mEnabled;
@@ -147,8 +168,8 @@ private:
 	U32                  mNumEntries;
 	std::string          mHeaderFileName ;
 	std::string          mObjectCacheDirName;
-	header_entry_queue_t mHeaderEntryQueue;
-	handle_entry_map_t   mHandleEntryMap;	
+	std::vector<HeaderEntryInfo> mHeaderEntries;	// one per header file record
+	LLVOCacheRegionLRU   mRegionLRU;
 
 	static LLVOCache* sInstance ;
 public:
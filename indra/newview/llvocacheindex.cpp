@@ -0,0 +1,294 @@
+/**
+ * @file llvocacheindex.cpp
+ * @brief Flat indexes used by the object cache.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llvocacheindex.h"
+
+#include "llvocache.h"
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// LLVOCacheRegionLRU
+//-----------------------------------------------------------------------------
+
+LLVOCacheRegionLRU::LLVOCacheRegionLRU(S32 num_slots)
+:	mNodes(num_slots),
+	mBudget(num_slots)
+{
+	clear();
+}
+
+void LLVOCacheRegionLRU::clear()
+{
+	for (std::vector<Node>::iterator iter = mNodes.begin(); iter != mNodes.end(); ++iter)
+	{
+		iter->mHandle = 0;
+		iter->mPrev = iter->mNext = -1;
+		iter->mUsed = false;
+	}
+	mSlots.clear();
+	mHead = mTail = -1;
+	mCount = 0;
+}
+
+void LLVOCacheRegionLRU::setBudget(S32 budget)
+{
+	mBudget = llclamp(budget, 1, (S32)mNodes.size());
+}
+
+S32 LLVOCacheRegionLRU::find(U64 handle) const
+{
+	boost::unordered_map<U64, S32>::const_iterator iter = mSlots.find(handle);
+	return iter == mSlots.end() ? -1 : iter->second;
+}
+
+S32 LLVOCacheRegionLRU::insert(U64 handle)
+{
+	S32 slot = find(handle);
+	if (slot >= 0)
+	{
+		touch(slot);
+		return slot;
+	}
+	if (mCount >= mBudget)
+	{
+		return -1;
+	}
+	for (slot = 0; slot < (S32)mNodes.size(); ++slot)
+	{
+		if (!mNodes[slot].mUsed)
+		{
+			insertAt(slot, handle);
+			return slot;
+		}
+	}
+	return -1;
+}
+
+bool LLVOCacheRegionLRU::insertAt(S32 slot, U64 handle)
+{
+	if (slot < 0 || slot >= (S32)mNodes.size() || mNodes[slot].mUsed || mSlots.count(handle))
+	{
+		return false;
+	}
+	Node& node = mNodes[slot];
+	node.mHandle = handle;
+	node.mUsed = true;
+	link(slot);
+	mSlots[handle] = slot;
+	++mCount;
+	return true;
+}
+
+void LLVOCacheRegionLRU::touch(S32 slot)
+{
+	if (slot != mHead)
+	{
+		unlink(slot);
+		link(slot);
+	}
+}
+
+void LLVOCacheRegionLRU::remove(S32 slot)
+{
+	Node& node = mNodes[slot];
+	if (!node.mUsed)
+	{
+		return;
+	}
+	unlink(slot);
+	mSlots.erase(node.mHandle);
+	node.mHandle = 0;
+	node.mUsed = false;
+	--mCount;
+}
+
+void LLVOCacheRegionLRU::link(S32 slot)
+{
+	Node& node = mNodes[slot];
+	node.mPrev = -1;
+	node.mNext = mHead;
+	if (mHead >= 0)
+	{
+		mNodes[mHead].mPrev = slot;
+	}
+	mHead = slot;
+	if (mTail < 0)
+	{
+		mTail = slot;
+	}
+}
+
+void LLVOCacheRegionLRU::unlink(S32 slot)
+{
+	Node& node = mNodes[slot];
+	if (node.mPrev >= 0)
+	{
+		mNodes[node.mPrev].mNext = node.mNext;
+	}
+	else
+	{
+		mHead = node.mNext;
+	}
+	if (node.mNext >= 0)
+	{
+		mNodes[node.mNext].mPrev = node.mPrev;
+	}
+	else
+	{
+		mTail = node.mPrev;
+	}
+	node.mPrev = node.mNext = -1;
+}
+
+//-----------------------------------------------------------------------------
+// LLVOCacheObjectIndex
+//-----------------------------------------------------------------------------
+
+// Longest unsorted tail before it is merged into the sorted records.
+const S32 MAX_UNSORTED_RECORDS = 64;
+
+struct LLVOCacheRecordLess
+{
+	bool operator()(const LLVOCacheObjectIndex::Record& lhs, const LLVOCacheObjectIndex::Record& rhs) const
+	{
+		return lhs.mLocalID < rhs.mLocalID;
+	}
+	bool operator()(const LLVOCacheObjectIndex::Record& lhs, U32 local_id) const
+	{
+		return lhs.mLocalID < local_id;
+	}
+};
+
+// Hits of a loaded object are counted by its entry, mHitCount is what the file had.
+inline S32 get_hit_count(const LLVOCacheObjectIndex::Record& record)
+{
+	return record.mEntry ? record.mEntry->getHitCount() : record.mHitCount;
+}
+
+struct LLVOCacheRecordMoreHits
+{
+	bool operator()(const LLVOCacheObjectIndex::Record& lhs, const LLVOCacheObjectIndex::Record& rhs) const
+	{
+		return get_hit_count(lhs) > get_hit_count(rhs);
+	}
+};
+
+LLVOCacheObjectIndex::LLVOCacheObjectIndex()
+:	mSortedCount(0)
+{
+}
+
+void LLVOCacheObjectIndex::clear()
+{
+	mRecords.clear();
+	mSortedCount = 0;
+}
+
+LLVOCacheObjectIndex::Record* LLVOCacheObjectIndex::find(U32 local_id)
+{
+	record_list_t::iterator sorted_end = mRecords.begin() + mSortedCount;
+	record_list_t::iterator iter = std::lower_bound(mRecords.begin(), sorted_end, local_id, LLVOCacheRecordLess());
+	if (iter != sorted_end && iter->mLocalID == local_id)
+	{
+		return &*iter;
+	}
+	for (iter = sorted_end; iter != mRecords.end(); ++iter)
+	{
+		if (iter->mLocalID == local_id)
+		{
+			return &*iter;
+		}
+	}
+	return NULL;
+}
+
+LLVOCacheObjectIndex::Record& LLVOCacheObjectIndex::insert(U32 local_id)
+{
+	Record* found = find(local_id);
+	if (found)
+	{
+		return *found;
+	}
+
+	if ((S32)mRecords.size() - mSortedCount >= MAX_UNSORTED_RECORDS)
+	{
+		mergeTail();
+	}
+
+	Record record;
+	record.mLocalID = local_id;
+	record.mCRC = 0;
+	record.mOffset = -1;
+	record.mSize = 0;
+	record.mHitCount = 0;
+	record.mDupeCount = 0;
+	record.mCRCChangeCount = 0;
+	record.mEntry = NULL;
+
+	// Records usually arrive in ascending order when reading a cache file.
+	if (mSortedCount == (S32)mRecords.size() &&
+		(mRecords.empty() || mRecords.back().mLocalID < local_id))
+	{
+		++mSortedCount;
+	}
+	mRecords.push_back(record);
+	return mRecords.back();
+}
+
+void LLVOCacheObjectIndex::mergeTail()
+{
+	record_list_t::iterator sorted_end = mRecords.begin() + mSortedCount;
+	std::sort(sorted_end, mRecords.end(), LLVOCacheRecordLess());
+	std::inplace_merge(mRecords.begin(), sorted_end, mRecords.end(), LLVOCacheRecordLess());
+	mSortedCount = (S32)mRecords.size();
+}
+
+S32 LLVOCacheObjectIndex::evict(S32 max_records, std::vector<LLVOCacheEntry*>& evicted)
+{
+	if ((S32)mRecords.size() <= max_records)
+	{
+		return 0;
+	}
+
+	// Keep 15/16 of the budget, the most hit records first.
+	S32 keep = max_records - max_records / 16;
+	std::nth_element(mRecords.begin(), mRecords.begin() + keep, mRecords.end(), LLVOCacheRecordMoreHits());
+	for (record_list_t::iterator iter = mRecords.begin() + keep; iter != mRecords.end(); ++iter)
+	{
+		if (iter->mEntry)
+		{
+			evicted.push_back(iter->mEntry);
+		}
+	}
+	S32 removed = (S32)mRecords.size() - keep;
+	mRecords.resize(keep);
+	std::sort(mRecords.begin(), mRecords.end(), LLVOCacheRecordLess());
+	mSortedCount = keep;
+	return removed;
+}
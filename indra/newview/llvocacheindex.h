@@ -0,0 +1,139 @@
+/**
+ * @file llvocacheindex.h
+ * @brief Flat indexes used by the object cache.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVOCACHEINDEX_H
+#define LL_LLVOCACHEINDEX_H
+
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include "stdtypes.h"
+
+class LLVOCacheEntry;
+
+// Least recently used list of the regions in the object cache. Every region
+// owns a fixed slot, which is also its record in the cache header file, so
+// touching or evicting a region never moves the others.
+class LLVOCacheRegionLRU
+{
+public:
+	LLVOCacheRegionLRU(S32 num_slots);
+
+	void clear();
+
+	// Maximum number of regions kept, at most the number of slots.
+	void setBudget(S32 budget);
+	S32 getBudget() const						{ return mBudget; }
+	S32 getNumSlots() const						{ return (S32)mNodes.size(); }
+	S32 getCount() const						{ return mCount; }
+
+	// Returns the slot of 'handle', or -1.
+	S32 find(U64 handle) const;
+	U64 getHandle(S32 slot) const				{ return mNodes[slot].mHandle; }
+	bool isUsed(S32 slot) const					{ return mNodes[slot].mUsed; }
+
+	// Least recently used region first, -1 when empty.
+	S32 getLeastRecent() const					{ return mTail; }
+	S32 getMoreRecent(S32 slot) const			{ return mNodes[slot].mPrev; }
+
+	// Adds 'handle' as the most recently used region. Returns its slot, or
+	// -1 if all slots are in use; the caller evicts first with getLeastRecent().
+	S32 insert(U64 handle);
+	// Adds 'handle' at a given slot as the most recently used one, used when
+	// reading the header file in access time order.
+	bool insertAt(S32 slot, U64 handle);
+	void touch(S32 slot);
+	void remove(S32 slot);
+
+private:
+	void link(S32 slot);
+	void unlink(S32 slot);
+
+	struct Node
+	{
+		U64 mHandle;
+		S32 mPrev;		// more recently used
+		S32 mNext;		// less recently used
+		bool mUsed;
+	};
+
+	std::vector<Node> mNodes;
+	boost::unordered_map<U64, S32> mSlots;
+	S32 mHead;
+	S32 mTail;
+	S32 mCount;
+	S32 mBudget;
+};
+
+// Objects of one region, as a flat array of records sorted by local id.
+// New records are appended to a short unsorted tail that is merged back in
+// bulk, so region entry doesn't pay a memmove for every new object.
+class LLVOCacheObjectIndex
+{
+public:
+	struct Record
+	{
+		U32 mLocalID;
+		U32 mCRC;
+		S32 mOffset;			// blob in the region cache file data, -1 if none
+		S32 mSize;
+		S32 mHitCount;			// as read from the file, mEntry counts the hits after that
+		S32 mDupeCount;
+		S32 mCRCChangeCount;
+		LLVOCacheEntry* mEntry;	// created on the first lookup, not owned
+	};
+	typedef std::vector<Record> record_list_t;
+
+	LLVOCacheObjectIndex();
+
+	void clear();
+	void reserve(S32 count)						{ mRecords.reserve(count); }
+	S32 size() const							{ return (S32)mRecords.size(); }
+	bool empty() const							{ return mRecords.empty(); }
+
+	// Pointers stay valid until the next insert() or evict().
+	Record* find(U32 local_id);
+	// Returns the record of 'local_id', adding an empty one if needed.
+	Record& insert(U32 local_id);
+
+	// Removes the least hit records when there are more than 'max_records',
+	// leaving some headroom so this doesn't run for every new object.
+	// Entries of the removed records are appended to 'evicted'.
+	S32 evict(S32 max_records, std::vector<LLVOCacheEntry*>& evicted);
+
+	record_list_t::iterator begin()				{ return mRecords.begin(); }
+	record_list_t::iterator end()				{ return mRecords.end(); }
+	record_list_t::const_iterator begin() const	{ return mRecords.begin(); }
+	record_list_t::const_iterator end() const	{ return mRecords.end(); }
+
+private:
+	void mergeTail();
+
+	record_list_t mRecords;
+	S32 mSortedCount;
+};
+
+#endif // LL_LLVOCACHEINDEX_H
@@ -520,6 +520,12 @@ U32 LLVOVolume::processUpdateMessage(LLMessageSystem *mesgsys,
 
 void LLVOVolume::animateTextures()
 {
+	animateTexturesFinish(animateTexturesPrepare());
+}
+
+U8 LLVOVolume::animateTexturesPrepare()
+{
+	U8 state = TEX_ANIM_NONE;
 	if (!mDead)
 	{
 		F32 off_s = 0.f, off_t = 0.f, scale_s = 1.f, scale_t = 1.f, rot = 0.f;
@@ -529,8 +535,7 @@ void LLVOVolume::animateTextures()
 		{
 			if (!mTexAnimMode)
 			{
-				mFaceMappingChanged = TRUE;
-				gPipeline.markTextured(mDrawable);
+				state = TEX_ANIM_STARTED;
 			}
 			mTexAnimMode = result | mTextureAnimp->mMode;
 				
@@ -591,44 +596,55 @@ void LLVOVolume::animateTextures()
 				tex_mat.translate_affine(trans);		
 			}	
 		}
-		else
+		else if (mTexAnimMode && mTextureAnimp->mRate == 0)
 		{
-			if (mTexAnimMode && mTextureAnimp->mRate == 0)
-			{
-				U8 start, count;
+			state = TEX_ANIM_STOPPED;
+		}
+	}
+	return state;
+}
 
-				if (mTextureAnimp->mFace == -1)
-				{
-					start = 0;
-					count = getNumTEs();
-				}
-				else
-				{
-					start = (U8) mTextureAnimp->mFace;
-					count = 1;
-				}
+void LLVOVolume::animateTexturesFinish(U8 state)
+{
+	if (state == TEX_ANIM_STARTED)
+	{
+		mFaceMappingChanged = TRUE;
+		gPipeline.markTextured(mDrawable);
+	}
+	else if (state == TEX_ANIM_STOPPED)
+	{
+		U8 start, count;
 
-				for (S32 i = start; i < start + count; i++)
-				{
-					if (mTexAnimMode & LLViewerTextureAnim::TRANSLATE)
-					{
-						setTEOffset(i, mTextureAnimp->mOffS, mTextureAnimp->mOffT);				
-					}
-					if (mTexAnimMode & LLViewerTextureAnim::SCALE)
-					{
-						setTEScale(i, mTextureAnimp->mScaleS, mTextureAnimp->mScaleT);	
-					}
-					if (mTexAnimMode & LLViewerTextureAnim::ROTATE)
-					{
-						setTERotation(i, mTextureAnimp->mRot);
-					}
-				}
+		if (mTextureAnimp->mFace == -1)
+		{
+			start = 0;
+			count = getNumTEs();
+		}
+		else
+		{
+			start = (U8) mTextureAnimp->mFace;
+			count = 1;
+		}
 
-				gPipeline.markTextured(mDrawable);
-				mFaceMappingChanged = TRUE;
-				mTexAnimMode = 0;
+		for (S32 i = start; i < start + count; i++)
+		{
+			if (mTexAnimMode & LLViewerTextureAnim::TRANSLATE)
+			{
+				setTEOffset(i, mTextureAnimp->mOffS, mTextureAnimp->mOffT);				
+			}
+			if (mTexAnimMode & LLViewerTextureAnim::SCALE)
+			{
+				setTEScale(i, mTextureAnimp->mScaleS, mTextureAnimp->mScaleT);	
+			}
+			if (mTexAnimMode & LLViewerTextureAnim::ROTATE)
+			{
+				setTERotation(i, mTextureAnimp->mRot);
 			}
 		}
+
+		gPipeline.markTextured(mDrawable);
+		mFaceMappingChanged = TRUE;
+		mTexAnimMode = 0;
 	}
 }
 
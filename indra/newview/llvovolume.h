@@ -132,6 +132,15 @@ public:
 				void	deleteFaces();
 
 				void	animateTextures();
+
+	// animateTextures() in two halves for LLViewerTextureAnim::updateClass(): the first
+	// only touches this object's faces and may run on a worker thread, its result is
+	// handed to the second on the main thread, which talks to the pipeline.
+	enum { TEX_ANIM_NONE = 0, TEX_ANIM_STARTED, TEX_ANIM_STOPPED };
+				U8		animateTexturesPrepare();
+				void	animateTexturesFinish(U8 state);
+
+	/*virtual*/ bool	hasSplitIdleUpdate() const			{ return true; }
 	
 	            BOOL    isVisible() const ;
 	/*virtual*/ BOOL	isActive() const;
@@ -324,6 +324,10 @@ public:
 	// World Mipmap delegation: currently used when drawing the mipmap
 	void	equalizeBoostLevels();
 	LLPointer<LLViewerFetchedTexture> getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load = true) { return mWorldMipmap.getObjectsTile(grid_x, grid_y, level, load); }
+	LLViewerTexture* getObjectsTileThumbnail(U32 grid_x, U32 grid_y, S32 level) { return mWorldMipmap.getObjectsTileThumbnail(grid_x, grid_y, level); }
+	void	prefetchTiles(F64 min_x, F64 min_y, F64 max_x, F64 max_y, S32 level, F64 pan_x, F64 pan_y) { mWorldMipmap.prefetchTiles(min_x, min_y, max_x, max_y, level, pan_x, pan_y); }
+	bool	isObjectsTileDownloading(U32 grid_x, U32 grid_y, S32 level) { return mWorldMipmap.isObjectsTileDownloading(grid_x, grid_y, level); }
+	LLWorldMipmap& getWorldMipmap() { return mWorldMipmap; }
 
 	static void processMapLayerReply(LLMessageSystem*, void**);
 private:
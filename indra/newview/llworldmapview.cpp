@@ -973,6 +973,14 @@ void LLWorldMapView::drawMipmap(S32 width, S32 height)
 	// Render the current level
 	sVisibleTilesLoaded = drawMipmapLevel(width, height, level);
 
+	// Get the tiles we're panning or zooming towards in flight before they're on screen
+	LLVector3d pos_SW = viewPosToGlobal(0, 0);
+	LLVector3d pos_NE = viewPosToGlobal(width, height);
+	LLVector3d center = (pos_SW + pos_NE) * 0.5;
+	LLVector3d pan = center - mLastTileCenter;
+	mLastTileCenter = center;
+	LLWorldMap::getInstance()->prefetchTiles(pos_SW[VX], pos_SW[VY], pos_NE[VX], pos_NE[VY], level, pan[VX], pan[VY]);
+
 	return;
 }
 
@@ -1011,12 +1019,21 @@ bool LLWorldMapView::drawMipmapLevel(S32 width, S32 height, S32 level, bool load
 			LLPointer<LLViewerFetchedTexture> simimage = LLWorldMap::getInstance()->getObjectsTile(grid_x, grid_y, level, load);
 			if (simimage)
 			{
+				LLViewerTexture* draw_image = NULL;
 				// Check the texture state
 				if (simimage->hasGLTexture())
 				{
 					// Increment the number of completly fetched tiles
 					completed_tiles++;
-
+					draw_image = simimage.get();
+				}
+				else
+				{
+					// Draw the cached thumbnail while the full tile loads
+					draw_image = LLWorldMap::getInstance()->getObjectsTileThumbnail(grid_x, grid_y, level);
+				}
+				if (draw_image)
+				{
 					// Convert those coordinates (SW corner of the mipmap tile) into world (meters) coordinates
 					pos_global[VX] = grid_x * REGION_WIDTH_METERS;
 					pos_global[VY] = grid_y * REGION_WIDTH_METERS;
@@ -1042,8 +1059,8 @@ bool LLWorldMapView::drawMipmapLevel(S32 width, S32 height, S32 level, bool load
 
 					// Draw the tile
 					LLGLSUIDefault gls_ui;
-					gGL.getTexUnit(0)->bind(simimage.get());
-					simimage->setAddressMode(LLTexUnit::TAM_CLAMP);
+					gGL.getTexUnit(0)->bind(draw_image);
+					draw_image->setAddressMode(LLTexUnit::TAM_CLAMP);
 					gGL.color4f(1.f, 1.0f, 1.0f, 1.0f);
 					gGL.begin(LLRender::TRIANGLE_STRIP);
 						gGL.texCoord2f(0.f, 1.f);
@@ -1059,9 +1076,8 @@ bool LLWorldMapView::drawMipmapLevel(S32 width, S32 height, S32 level, bool load
 					drawTileOutline(level, top, left, bottom, right);
 #endif // DEBUG_DRAW_TILE
 				}
-				//else
 			}
-			else
+			else if (!LLWorldMap::getInstance()->isObjectsTileDownloading(grid_x, grid_y, level))
 			{
 				// Unexistent tiles are counted as "completed"
 				completed_tiles++;
@@ -200,6 +200,8 @@ public:
 	typedef std::vector<U64> handle_list_t;
 	handle_list_t mVisibleRegions; // set every frame
 
+	LLVector3d		mLastTileCenter;	// center of the view at the last drawMipmap(), to tell the pan direction
+
 	static std::map<std::string,std::string> sStringsMap;
 
 private:
@@ -34,16 +34,93 @@
 
 #include "llworldmipmap.h"
 
+#include "llapr.h"
+#include "llbufferstream.h"
+#include "lldiriterator.h"
+#include "llhttpclient.h"
 #include "llviewercontrol.h"
 #include "llviewertexturelist.h"
+#include "llworldmap.h"
 #include "math.h"	// log()
 #include "lfsimfeaturehandler.h"
 
+class AIHTTPTimeoutPolicy;
+extern AIHTTPTimeoutPolicy mapTileResponder_timeout;
+
 // Turn this on to output tile stats in the standard output
 #define DEBUG_TILES_STAT 0
 
+const S32 THUMBNAIL_DISCARD = 2;			// Discard level the thumbnail is made from (64x64 for a 256x256 tile)
+const S32 THUMBNAIL_SIZE = 64;				// Width in pixels of the thumbnails
+const S32 MAX_PREFETCH_REQUESTS = 4;		// New tile requests made by one prefetchTiles() call
+const time_t MISSING_TILE_EXPIRY = 60 * 60;	// Seconds before a tile the map server didn't have is asked for again
+
+LLStat LLWorldMipmap::sTileHitRate("map_tile_cache_hits", 128);
+
+// Identifies the tile a loaded callback is for, the tile may be gone by the time it fires
+struct LLTileCallbackData
+{
+	LLTileCallbackData(LLWorldMipmap* mipmap, S32 level, U64 handle) : mMipmap(mipmap), mLevel(level), mHandle(handle) { }
+
+	LLWorldMipmap* mMipmap;
+	S32 mLevel;
+	U64 mHandle;
+};
+
+// Downloads a tile for the disk cache
+class LLMapTileResponder : public LLHTTPClient::ResponderWithCompleted
+{
+	LOG_CLASS(LLMapTileResponder);
+public:
+	LLMapTileResponder(S32 level, U64 handle, std::string const& filename) :
+		mLevel(level), mHandle(handle), mFilename(filename) { }
+
+	/*virtual*/ void completedRaw(LLChannelDescriptors const& channels, buffer_ptr_t const& buffer)
+	{
+		if (!LLWorldMap::instanceExists())
+		{
+			return;
+		}
+		LLWorldMipmap& mipmap = LLWorldMap::getInstance()->getWorldMipmap();
+		S32 size = isGoodStatus(mStatus) ? buffer->countAfter(channels.in(), NULL) : 0;
+		if (size <= 0)
+		{
+			mipmap.onTileDownloaded(mLevel, mHandle, mFilename, NULL, 0, mStatus == HTTP_NOT_FOUND);
+			return;
+		}
+		std::vector<U8> data(size);
+		buffer->readAfter(channels.in(), NULL, &data[0], size);
+		mipmap.onTileDownloaded(mLevel, mHandle, mFilename, &data[0], size, false);
+	}
+
+	/*virtual*/ AIHTTPTimeoutPolicy const& getHTTPTimeoutPolicy(void) const { return mapTileResponder_timeout; }
+	/*virtual*/ char const* getName(void) const { return "LLMapTileResponder"; }
+
+private:
+	S32 mLevel;
+	U64 mHandle;
+	std::string mFilename;
+};
+
+// A tile trimCache() may evict
+struct LLEvictCandidate
+{
+	U32 mLastUsed;
+	S32 mLevel;
+	U64 mHandle;
+	bool operator<(const LLEvictCandidate& rhs) const { return mLastUsed < rhs.mLastUsed; }
+};
+
 LLWorldMipmap::LLWorldMipmap() :
-	mCurrentLevel(0)
+	mCurrentLevel(0),
+	mPrefetchLevel(0),
+	mFrame(0),
+	mTileCount(0),
+	mHits(0),
+	mMisses(0),
+	mPrefetchHits(0),
+	mDiskCacheBytes(0),
+	mDiskCacheScanned(false)
 {
 }
 
@@ -59,6 +136,7 @@ void LLWorldMipmap::reset()
 	{
 		mWorldObjectsMipMap[level].clear();
 	}
+	mTileCount = 0;
 }
 
 // This method should be called before each use of the mipmap (typically, before each draw), so that to let
@@ -67,6 +145,7 @@ void LLWorldMipmap::reset()
 // The result of this strategy is that if a tile is not used during 2 consecutive loops, its boost level drops to 0.
 void LLWorldMipmap::equalizeBoostLevels()
 {
+	++mFrame;
 #if DEBUG_TILES_STAT
 	S32 nb_missing = 0;
 	S32 nb_tiles = 0;
@@ -79,13 +158,23 @@ void LLWorldMipmap::equalizeBoostLevels()
 		// For each tile
 		for (sublevel_tiles_t::iterator iter = level_mipmap.begin(); iter != level_mipmap.end(); iter++)
 		{
-			LLPointer<LLViewerFetchedTexture> img = iter->second;
+			LLPointer<LLViewerFetchedTexture> img = iter->second.mImage;
+			if (img.isNull())
+			{
+				// Still downloading, or missing
+				continue;
+			}
 			S32 current_boost_level = img->getBoostLevel();
 			if (current_boost_level == LLGLTexture::BOOST_MAP_VISIBLE)
 			{
 				// If level was BOOST_MAP_VISIBLE, the tile has been used in the last draw so keep it high
 				img->setBoostLevel(LLGLTexture::BOOST_MAP);
 			}
+			else if (iter->second.mPrefetched && !img->hasGLTexture())
+			{
+				// Prefetched tiles are off screen, keep them boosted or they never get fetched
+				img->setBoostLevel(LLGLTexture::BOOST_MAP);
+			}
 			else
 			{
 				// If level was BOOST_MAP only (or anything else...), the tile wasn't used in the last draw 
@@ -109,6 +198,8 @@ void LLWorldMipmap::equalizeBoostLevels()
 #if DEBUG_TILES_STAT
 	LL_INFOS("World Map") << "LLWorldMipmap tile stats : total requested = " << nb_tiles << ", visible = " << nb_visible << ", missing = " << nb_missing << LL_ENDL;
 #endif // DEBUG_TILES_STAT
+
+	trimCache();
 }
 
 // This method should be used when the mipmap is not actively used for a while, e.g., the map UI is hidden
@@ -121,10 +212,23 @@ void LLWorldMipmap::dropBoostLevels()
 		// For each tile
 		for (sublevel_tiles_t::iterator iter = level_mipmap.begin(); iter != level_mipmap.end(); iter++)
 		{
-			LLPointer<LLViewerFetchedTexture> img = iter->second;
-			img->setBoostLevel(LLGLTexture::BOOST_NONE);
+			LLPointer<LLViewerFetchedTexture> img = iter->second.mImage;
+			if (img.notNull())
+			{
+				img->setBoostLevel(LLGLTexture::BOOST_NONE);
+			}
+			// Don't keep fetching tiles we guessed we'd need
+			iter->second.mPrefetched = false;
 		}
 	}
+
+	U32 total = mHits + mMisses;
+	if (total)
+	{
+		LL_DEBUGS("World Map") << "Tile cache: " << mTileCount << " tiles, " << mHits << " hits ("
+							   << mPrefetchHits << " prefetched), " << mMisses << " misses, hit rate "
+							   << (F32)mHits * 100.f / (F32)total << "%" << LL_ENDL;
+	}
 }
 
 LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load)
@@ -147,16 +251,18 @@ LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32
 	// Check if the image is around already
 	sublevel_tiles_t& level_mipmap = mWorldObjectsMipMap[level-1];
 	sublevel_tiles_t::iterator found = level_mipmap.find(handle);
+	bool cached = (found != level_mipmap.end());
 
 	// If not there and load on, go load it
-	if (found == level_mipmap.end())
+	if (!cached)
 	{
 		if (load)
 		{
-			// Load it 
-			LLPointer<LLViewerFetchedTexture> img = loadObjectsTile(grid_x, grid_y, level);
-			// Insert the image in the map
-			level_mipmap.insert(sublevel_tiles_t::value_type( handle, img ));
+			// Load it and insert the tile in the map
+			LLTile& tile = level_mipmap[handle];
+			tile.mImage = loadObjectsTile(grid_x, grid_y, level, tile.mMissing);
+			tile.mDownloading = tile.mImage.isNull() && !tile.mMissing;
+			++mTileCount;
 			// Find the element again in the map (it's there now...)
 			found = level_mipmap.find(handle);
 		}
@@ -167,11 +273,36 @@ LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32
 		}
 	}
 
+	LLTile& tile = found->second;
+	if (load && (!cached || tile.mPrefetched || tile.mLastUsed + 1 < mFrame))
+	{
+		// The tile just came into view: count whether we could draw it right away
+		bool ready = cached && ((tile.mImage.notNull() && tile.mImage->hasGLTexture()) || tile.mThumbnail.notNull());
+		if (ready)
+		{
+			++mHits;
+			if (tile.mPrefetched)
+			{
+				++mPrefetchHits;
+			}
+		}
+		else
+		{
+			++mMisses;
+		}
+		sTileHitRate.addValue(ready ? 100.f : 0.f);
+	}
+	tile.mLastUsed = mFrame;
+	if (load)
+	{
+		tile.mPrefetched = false;
+	}
+
 	// Get the image pointer and check if this asset is missing
-	LLPointer<LLViewerFetchedTexture> img = found->second;
-	if (img->isMissingAsset())
+	LLPointer<LLViewerFetchedTexture> img = tile.mImage;
+	if (img.isNull() || img->isMissingAsset())
 	{
-		// Return NULL if asset missing
+		// Return NULL if asset missing (or still on its way to the disk cache)
 		return NULL;
 	}
 	else
@@ -185,12 +316,185 @@ LLPointer<LLViewerFetchedTexture> LLWorldMipmap::getObjectsTile(U32 grid_x, U32
 	}
 }
 
-LLPointer<LLViewerFetchedTexture> LLWorldMipmap::loadObjectsTile(U32 grid_x, U32 grid_y, S32 level)
+LLViewerTexture* LLWorldMipmap::getObjectsTileThumbnail(U32 grid_x, U32 grid_y, S32 level)
+{
+	llassert(level <= MAP_LEVELS);
+	llassert(level >= 1);
+
+	sublevel_tiles_t& level_mipmap = mWorldObjectsMipMap[level-1];
+	sublevel_tiles_t::iterator found = level_mipmap.find(convertGridToHandle(grid_x, grid_y));
+	if (found == level_mipmap.end() || found->second.mThumbnail.isNull() || !found->second.mThumbnail->hasGLTexture())
+	{
+		return NULL;
+	}
+	return found->second.mThumbnail;
+}
+
+void LLWorldMipmap::prefetchTiles(F64 min_x, F64 min_y, F64 max_x, F64 max_y, S32 level, F64 pan_x, F64 pan_y)
+{
+	llassert(level <= MAP_LEVELS);
+	llassert(level >= 1);
+
+	S32 zoom = level - mPrefetchLevel;
+	mPrefetchLevel = level;
+
+	// Extend the view by one tile in the direction we're panning
+	F64 tile_width = (F64)(MAP_TILE_SIZE * (1 << (level - 1)));
+	if (pan_x > 0.0)
+	{
+		max_x += tile_width;
+	}
+	else if (pan_x < 0.0)
+	{
+		min_x -= tile_width;
+	}
+	if (pan_y > 0.0)
+	{
+		max_y += tile_width;
+	}
+	else if (pan_y < 0.0)
+	{
+		min_y -= tile_width;
+	}
+	min_x = llmax(min_x, 0.0);
+	min_y = llmax(min_y, 0.0);
+
+	// Tiles in view are requested by the draw, so this only requests the ones ahead of it,
+	// then the coarser level that is drawn as a background while those load,
+	// and when zooming in, the middle of the view at the next finer level.
+	S32 budget = MAX_PREFETCH_REQUESTS;
+	S32 levels[2] = { level, level + 1 };
+	for (S32 i = 0; i < 2 && budget > 0; ++i)
+	{
+		S32 l = levels[i];
+		if (l > MAP_LEVELS)
+		{
+			continue;
+		}
+		F64 width = (F64)(MAP_TILE_SIZE * (1 << (l - 1)));
+		for (F64 y = min_y; y < max_y + width && budget > 0; y += width)
+		{
+			for (F64 x = min_x; x < max_x + width && budget > 0; x += width)
+			{
+				U32 grid_x, grid_y;
+				globalToMipmap(x, y, l, &grid_x, &grid_y);
+				if (prefetchTile(grid_x, grid_y, l))
+				{
+					--budget;
+				}
+			}
+		}
+	}
+	if (zoom < 0 && level > 1 && budget > 0)
+	{
+		U32 grid_x, grid_y;
+		globalToMipmap((min_x + max_x) * 0.5, (min_y + max_y) * 0.5, level - 1, &grid_x, &grid_y);
+		prefetchTile(grid_x, grid_y, level - 1);
+	}
+}
+
+bool LLWorldMipmap::prefetchTile(U32 grid_x, U32 grid_y, S32 level)
+{
+	U64 handle = convertGridToHandle(grid_x, grid_y);
+	sublevel_tiles_t& level_mipmap = mWorldObjectsMipMap[level-1];
+	if (level_mipmap.find(handle) != level_mipmap.end())
+	{
+		return false;
+	}
+
+	LLTile& tile = level_mipmap[handle];
+	tile.mImage = loadObjectsTile(grid_x, grid_y, level, tile.mMissing);
+	tile.mDownloading = tile.mImage.isNull() && !tile.mMissing;
+	tile.mLastUsed = mFrame;
+	tile.mPrefetched = true;
+	++mTileCount;
+	return true;
+}
+
+// Evicts the least recently drawn tiles, never the ones drawn in the last frame.
+void LLWorldMipmap::trimCache()
+{
+	static const LLCachedControl<U32> cache_size("WorldMapTileCacheSize", 512);
+	S32 max_tiles = llmax((S32)cache_size, 16);
+	if (mTileCount <= max_tiles)
+	{
+		return;
+	}
+
+	std::vector<LLEvictCandidate> candidates;
+	candidates.reserve(mTileCount);
+	for (S32 level = 0; level < MAP_LEVELS; level++)
+	{
+		sublevel_tiles_t& level_mipmap = mWorldObjectsMipMap[level];
+		for (sublevel_tiles_t::iterator iter = level_mipmap.begin(); iter != level_mipmap.end(); ++iter)
+		{
+			if (iter->second.mLastUsed + 1 < mFrame)
+			{
+				LLEvictCandidate candidate = { iter->second.mLastUsed, level, iter->first };
+				candidates.push_back(candidate);
+			}
+		}
+	}
+
+	// Go a bit below the limit so that we don't end up here again next frame
+	S32 evict = llmin(mTileCount - max_tiles * 9 / 10, (S32)candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + evict, candidates.end());
+	for (S32 i = 0; i < evict; ++i)
+	{
+		sublevel_tiles_t& level_mipmap = mWorldObjectsMipMap[candidates[i].mLevel];
+		sublevel_tiles_t::iterator iter = level_mipmap.find(candidates[i].mHandle);
+		// Let the texture list reclaim it
+		if (iter->second.mImage.notNull())
+		{
+			iter->second.mImage->setBoostLevel(LLGLTexture::BOOST_NONE);
+		}
+		level_mipmap.erase(iter);
+		--mTileCount;
+	}
+}
+
+//static
+void LLWorldMipmap::onTileLoaded(BOOL success, LLViewerFetchedTexture* src_vi, LLImageRaw* src, LLImageRaw* aux_src,
+								 S32 discard_level, BOOL final, void* userdata)
+{
+	LLTileCallbackData* data = (LLTileCallbackData*)userdata;
+	if (success && src && src->getData())
+	{
+		data->mMipmap->setTileThumbnail(data->mLevel, data->mHandle, src_vi, src);
+	}
+	if (final || !success)
+	{
+		delete data;
+	}
+}
+
+void LLWorldMipmap::setTileThumbnail(S32 level, U64 handle, LLViewerFetchedTexture* image, LLImageRaw* raw)
+{
+	sublevel_tiles_t& level_mipmap = mWorldObjectsMipMap[level-1];
+	sublevel_tiles_t::iterator found = level_mipmap.find(handle);
+	// The tile may have been evicted, or evicted and loaded again, since the callback was set
+	if (found == level_mipmap.end() || found->second.mImage != image || found->second.mThumbnail.notNull())
+	{
+		return;
+	}
+
+	LLPointer<LLImageRaw> thumbnail = new LLImageRaw(raw->getData(), raw->getWidth(), raw->getHeight(), raw->getComponents());
+	thumbnail->scale(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+	found->second.mThumbnail = LLViewerTextureManager::getLocalTexture(thumbnail.get(), FALSE);
+	found->second.mThumbnail->setAddressMode(LLTexUnit::TAM_CLAMP);
+}
+
+// Returns NULL when the tile isn't in the disk cache yet, it is loaded by onTileDownloaded() then.
+// Also returns NULL, with missing set, when the map server recently answered that it doesn't have the tile.
+LLPointer<LLViewerFetchedTexture> LLWorldMipmap::loadObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool& missing)
 {
+	missing = false;
+
 	// Get the grid coordinates
 	std::string simOverrideMap = LFSimFeatureHandler::instance().mapServerURL();
-	std::string imageurl = (simOverrideMap.empty() ? gSavedSettings.getString("MapServerURL") : simOverrideMap) 
-		+ llformat("map-%d-%d-%d-objects.jpg", level, grid_x, grid_y);
+	std::string server = simOverrideMap.empty() ? gSavedSettings.getString("MapServerURL") : simOverrideMap;
+	std::string tile_name = llformat("map-%d-%d-%d-objects.jpg", level, grid_x, grid_y);
+	std::string imageurl = server + tile_name;
 
 	// DO NOT COMMIT!! DEBUG ONLY!!!
 	// Use a local jpeg for every tile to test map speed without S3 access
@@ -198,13 +502,181 @@ LLPointer<LLViewerFetchedTexture> LLWorldMipmap::loadObjectsTile(U32 grid_x, U32
 	// END DEBUG
 	//LL_INFOS("World Map") << "LLWorldMipmap::loadObjectsTile(), URL = " << imageurl << LL_ENDL;
 
+	static const LLCachedControl<U32> disk_cache_size("WorldMapDiskCacheSize", 64);
+	if (disk_cache_size > 0)
+	{
+		// Tiles of different grids go in the same directory, tell them apart by the map server
+		std::string filename = LLUUID::generateNewID(server).asString().substr(0, 8) + "-" + tile_name;
+		if (isMissingTile(filename))
+		{
+			missing = true;
+			return NULL;
+		}
+		if (!hasDiskTile(filename))
+		{
+			LLHTTPClient::get(imageurl, new LLMapTileResponder(level, convertGridToHandle(grid_x, grid_y), filename));
+			return NULL;
+		}
+		imageurl = "file://" + mDiskCacheDir + gDirUtilp->getDirDelimiter() + filename;
+	}
+
 	LLPointer<LLViewerFetchedTexture> img = LLViewerTextureManager::getFetchedTextureFromUrl(imageurl, FTT_MAP_TILE, TRUE, LLGLTexture::BOOST_NONE, LLViewerTexture::LOD_TEXTURE);
 	img->setBoostLevel(LLGLTexture::BOOST_MAP);
+	// Keep a decoded thumbnail around once the low resolution data is in
+	img->setLoadedCallback(onTileLoaded, THUMBNAIL_DISCARD, TRUE, FALSE,
+						   new LLTileCallbackData(this, level, convertGridToHandle(grid_x, grid_y)), NULL);
 
 	// Return the smart pointer
 	return img;
 }
 
+bool LLWorldMipmap::isObjectsTileDownloading(U32 grid_x, U32 grid_y, S32 level)
+{
+	sublevel_tiles_t& level_mipmap = mWorldObjectsMipMap[level-1];
+	sublevel_tiles_t::iterator found = level_mipmap.find(convertGridToHandle(grid_x, grid_y));
+	return found != level_mipmap.end() && found->second.mDownloading;
+}
+
+void LLWorldMipmap::onTileDownloaded(S32 level, U64 handle, std::string const& filename, U8* data, S32 size, bool not_found)
+{
+	if (not_found)
+	{
+		mMissingTiles[filename] = time(NULL) + MISSING_TILE_EXPIRY;
+	}
+	bool stored = false;
+	if (data)
+	{
+		std::string path = mDiskCacheDir + gDirUtilp->getDirDelimiter() + filename;
+		stored = (LLAPRFile::writeEx(path, data, 0, size) == size);
+		if (stored)
+		{
+			LLDiskTile& disk_tile = mDiskTiles[filename];
+			mDiskCacheBytes += size - (disk_tile.mModified ? disk_tile.mSize : 0);
+			disk_tile.mSize = size;
+			disk_tile.mModified = disk_tile.mLastUsed = time(NULL);
+			trimDiskCache();
+		}
+	}
+
+	// The tile may have been evicted, or the whole mipmap reset, in the meantime
+	sublevel_tiles_t& level_mipmap = mWorldObjectsMipMap[level-1];
+	sublevel_tiles_t::iterator found = level_mipmap.find(handle);
+	if (found == level_mipmap.end() || !found->second.mDownloading)
+	{
+		return;
+	}
+	LLTile& tile = found->second;
+	tile.mDownloading = false;
+	if (!stored)
+	{
+		// Missing tiles are normal on empty regions, failures get retried by cleanMissedTilesFromLevel()
+		tile.mMissing = true;
+		return;
+	}
+	U32 grid_x, grid_y;
+	from_region_handle(handle, &grid_x, &grid_y);
+	tile.mImage = loadObjectsTile(grid_x / REGION_WIDTH_UNITS, grid_y / REGION_WIDTH_UNITS, level, tile.mMissing);
+	tile.mDownloading = tile.mImage.isNull() && !tile.mMissing;
+}
+
+bool LLWorldMipmap::isMissingTile(std::string const& filename)
+{
+	missing_tiles_t::iterator found = mMissingTiles.find(filename);
+	if (found == mMissingTiles.end())
+	{
+		return false;
+	}
+	if (time(NULL) >= found->second)
+	{
+		mMissingTiles.erase(found);
+		return false;
+	}
+	return true;
+}
+
+bool LLWorldMipmap::hasDiskTile(std::string const& filename)
+{
+	// Map tiles are regenerated by the map server about once a day
+	const time_t MAX_TILE_AGE = 24 * 60 * 60;
+
+	if (!mDiskCacheScanned)
+	{
+		scanDiskCache();
+	}
+	disk_tiles_t::iterator found = mDiskTiles.find(filename);
+	if (found == mDiskTiles.end())
+	{
+		return false;
+	}
+	time_t now = time(NULL);
+	if (now - found->second.mModified > MAX_TILE_AGE)
+	{
+		LLFile::remove(mDiskCacheDir + gDirUtilp->getDirDelimiter() + filename);
+		mDiskCacheBytes -= found->second.mSize;
+		mDiskTiles.erase(found);
+		return false;
+	}
+	found->second.mLastUsed = now;
+	return true;
+}
+
+void LLWorldMipmap::scanDiskCache()
+{
+	mDiskCacheScanned = true;
+	mDiskCacheDir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "maptiles");
+	LLFile::mkdir(mDiskCacheDir);
+
+	LLDirIterator iter(mDiskCacheDir, "*.jpg");
+	std::string filename;
+	while (iter.next(filename))
+	{
+		llstat file_status;
+		if (LLFile::stat(mDiskCacheDir + gDirUtilp->getDirDelimiter() + filename, &file_status) == 0)
+		{
+			LLDiskTile& disk_tile = mDiskTiles[filename];
+			disk_tile.mSize = (S32)file_status.st_size;
+			disk_tile.mModified = disk_tile.mLastUsed = file_status.st_mtime;
+			mDiskCacheBytes += disk_tile.mSize;
+		}
+	}
+	trimDiskCache();
+	LL_INFOS("World Map") << "Map tile disk cache: " << mDiskTiles.size() << " tiles, " << mDiskCacheBytes / 1024 << " KB" << LL_ENDL;
+}
+
+// Orders disk tiles by last use, oldest first
+struct LLDiskTileOlder
+{
+	template<class T>
+	bool operator()(const T& lhs, const T& rhs) const { return lhs.first < rhs.first; }
+};
+
+// Removes the least recently used tile files once the disk cache is over WorldMapDiskCacheSize.
+// It trims to 90% of the size, so the downloads right after don't have to sort the tiles again.
+void LLWorldMipmap::trimDiskCache()
+{
+	static const LLCachedControl<U32> disk_cache_size("WorldMapDiskCacheSize", 64);
+	S64 max_bytes = (S64)disk_cache_size * 1024 * 1024;
+	if (mDiskCacheBytes <= max_bytes)
+	{
+		return;
+	}
+	std::vector<std::pair<time_t, disk_tiles_t::iterator> > tiles;
+	tiles.reserve(mDiskTiles.size());
+	for (disk_tiles_t::iterator iter = mDiskTiles.begin(); iter != mDiskTiles.end(); ++iter)
+	{
+		tiles.push_back(std::make_pair(iter->second.mLastUsed, iter));
+	}
+	std::sort(tiles.begin(), tiles.end(), LLDiskTileOlder());
+	S64 target_bytes = max_bytes - max_bytes / 10;
+	for (size_t i = 0; i < tiles.size() && mDiskCacheBytes > target_bytes; ++i)
+	{
+		disk_tiles_t::iterator oldest = tiles[i].second;
+		LLFile::remove(mDiskCacheDir + gDirUtilp->getDirDelimiter() + oldest->first);
+		mDiskCacheBytes -= oldest->second.mSize;
+		mDiskTiles.erase(oldest);
+	}
+}
+
 // This method is used to clean up a level from tiles marked as "missing".
 // The idea is to allow tiles that have been improperly marked missing to be reloaded when retraversing the level again.
 // When zooming in and out rapidly, some tiles are never properly loaded and, eventually marked missing.
@@ -227,10 +699,11 @@ void LLWorldMipmap::cleanMissedTilesFromLevel(S32 level)
 	sublevel_tiles_t::iterator it = level_mipmap.begin();
 	while (it != level_mipmap.end())
 	{
-		LLPointer<LLViewerFetchedTexture> img = it->second;
-		if (img->isMissingAsset())
+		LLPointer<LLViewerFetchedTexture> img = it->second.mImage;
+		if (it->second.mMissing || (img.notNull() && img->isMissingAsset()))
 		{
 			level_mipmap.erase(it++);
+			--mTileCount;
 		}
 		else
 		{
@@ -38,7 +38,9 @@
 #include "llmemory.h"			// LLPointer
 #include "indra_constants.h"	// REGION_WIDTH_UNITS
 #include "llregionhandle.h"		// to_region_handle()
+#include "llstat.h"
 
+class LLImageRaw;
 class LLViewerTexture;
 class LLViewerFetchedTexture;
 
@@ -56,6 +58,13 @@ class LLViewerFetchedTexture;
 // Implementation notes:
 // - On the S3 servers, the tiles are rendered in 2 flavors: Objects and Terrain.
 // - For the moment, LLWorldMipmap implements access only to the Objects tiles.
+// - The mipmap is a bounded tile cache (WorldMapTileCacheSize tiles) with its own LRU eviction,
+//   so tiles no longer depend on the general texture list to stay around. Each cached tile also
+//   keeps a small decoded thumbnail that is drawn while the full tile is (re)loading.
+// - Tiles are downloaded into their own directory in the cache (WorldMapDiskCacheSize MB, LRU)
+//   and loaded from there, the texture cache can't hold them as they are jpegs.
+// - prefetchTiles() requests the tiles just outside the view in the pan direction, as well as
+//   the adjacent levels, before they are needed.
 class LLWorldMipmap
 {
 public:
@@ -74,6 +83,18 @@ public:
 	void	dropBoostLevels();
 	// Get the tile smart pointer, does the loading if necessary
 	LLPointer<LLViewerFetchedTexture> getObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool load = true);
+	// Get the decoded thumbnail of a cached tile, NULL if there is none yet
+	LLViewerTexture* getObjectsTileThumbnail(U32 grid_x, U32 grid_y, S32 level);
+	// True while the tile is being downloaded to the disk cache (getObjectsTile() returns NULL meanwhile)
+	bool	isObjectsTileDownloading(U32 grid_x, U32 grid_y, S32 level);
+	// Called when a tile download finished, data is NULL on failure, not_found is true when the server answered 404
+	void	onTileDownloaded(S32 level, U64 handle, std::string const& filename, U8* data, S32 size, bool not_found);
+	// Request the tiles around the visible area [min, max] (global meters) ahead of time.
+	// pan_x/pan_y is the direction the view moved in since the last call.
+	void	prefetchTiles(F64 min_x, F64 min_y, F64 max_x, F64 max_y, S32 level, F64 pan_x, F64 pan_y);
+
+	// Percentage of tiles that could be drawn right away when they came into view
+	static LLStat sTileHitRate;
 
 	// Helper functions: those are here as they depend solely on the topology of the mipmap though they don't access it
 	// Convert sim scale (given in sim width in display pixels) into a mipmap level
@@ -84,18 +105,71 @@ public:
 private:
 	// Get a handle (key) from grid coordinates
 	U64		convertGridToHandle(U32 grid_x, U32 grid_y) { return to_region_handle(grid_x * REGION_WIDTH_UNITS, grid_y * REGION_WIDTH_UNITS); }
-	// Load the relevant tile from S3
-	LLPointer<LLViewerFetchedTexture> loadObjectsTile(U32 grid_x, U32 grid_y, S32 level);
+	// Load the relevant tile from S3, missing is set when the tile is known not to exist
+	LLPointer<LLViewerFetchedTexture> loadObjectsTile(U32 grid_x, U32 grid_y, S32 level, bool& missing);
 	// Clear a level from its "missing" tiles
 	void cleanMissedTilesFromLevel(S32 level);
+	// Load a tile that isn't visible yet, returns true if a new request was made
+	bool prefetchTile(U32 grid_x, U32 grid_y, S32 level);
+	// Evict least recently used tiles until the cache is within its size limit
+	void trimCache();
+	// Disk cache: true if there is a recent enough copy of the tile file
+	bool hasDiskTile(std::string const& filename);
+	// True if the map server answered 404 for the tile file less than MISSING_TILE_EXPIRY ago
+	bool isMissingTile(std::string const& filename);
+	void scanDiskCache();
+	void trimDiskCache();
+	// Texture loaded callback, makes the thumbnail
+	static void onTileLoaded(BOOL success, LLViewerFetchedTexture* src_vi, LLImageRaw* src, LLImageRaw* aux_src,
+							 S32 discard_level, BOOL final, void* userdata);
+	void setTileThumbnail(S32 level, U64 handle, LLViewerFetchedTexture* image, LLImageRaw* raw);
+
+	// One cached tile: the fetched texture and a small decoded copy of it
+	struct LLTile
+	{
+		LLTile() : mLastUsed(0), mPrefetched(false), mDownloading(false), mMissing(false) { }
+
+		LLPointer<LLViewerFetchedTexture> mImage;	// NULL while downloading or when missing
+		LLPointer<LLViewerTexture> mThumbnail;
+		U32 mLastUsed;		// mFrame when the tile was last drawn or requested
+		bool mPrefetched;	// requested by prefetchTiles() and not drawn since
+		bool mDownloading;	// being downloaded to the disk cache
+		bool mMissing;		// the map server doesn't have it
+	};
 
 	// The mipmap is organized by resolution level (MAP_LEVELS of them). Each resolution level is an std::map
-	// using a region_handle as a key and storing a smart pointer to the image as a value.
-	typedef std::map<U64, LLPointer<LLViewerFetchedTexture> > sublevel_tiles_t;
+	// using a region_handle as a key and storing the tile as a value.
+	typedef std::map<U64, LLTile> sublevel_tiles_t;
 	sublevel_tiles_t mWorldObjectsMipMap[MAP_LEVELS];
 //	sublevel_tiles_t mWorldTerrainMipMap[MAP_LEVELS];
 
 	S32 mCurrentLevel;		// The level last accessed by a getObjectsTile()
+	S32 mPrefetchLevel;		// The level of the last prefetchTiles() call, to tell zooming in from out
+	U32 mFrame;				// Incremented by each equalizeBoostLevels()
+	S32 mTileCount;			// Tiles in all the levels
+
+	// Cache stats, also fed into sTileHitRate
+	U32 mHits;
+	U32 mMisses;
+	U32 mPrefetchHits;
+
+	// One tile file in the disk cache
+	struct LLDiskTile
+	{
+		S32 mSize;
+		time_t mModified;	// when it was downloaded
+		time_t mLastUsed;
+	};
+	typedef std::map<std::string, LLDiskTile> disk_tiles_t;
+	disk_tiles_t mDiskTiles;	// file name (without path) -> tile file
+	S64 mDiskCacheBytes;
+	bool mDiskCacheScanned;
+	std::string mDiskCacheDir;
+
+	// Tiles the map server doesn't have (empty regions): file name -> time to ask again.
+	// Kept across reset(), the file name already tells grids apart.
+	typedef std::map<std::string, time_t> missing_tiles_t;
+	missing_tiles_t mMissingTiles;
 };
 
 #endif // LL_LLWORLDMIPMAP_H
@@ -1680,7 +1680,7 @@ void LLPipeline::removeMutedAVsLights(LLVOAvatar* muted_avatar)
 	}
 }
 
-U32 LLPipeline::addObject(LLViewerObject *vobj)
+U32 LLPipeline::addObject(LLViewerObject *vobj, bool defer)
 {
 	llassert_always(vobj);
 	if (gNoRender)
@@ -1689,7 +1689,7 @@ U32 LLPipeline::addObject(LLViewerObject *vobj)
 	}
 
 	static const LLCachedControl<bool> render_delay_creation("RenderDelayCreation",false);
-	if (!vobj->isAvatar() && render_delay_creation)
+	if (!vobj->isAvatar() && (render_delay_creation || defer))
 	{
 		mCreateQ.push_back(vobj);
 	}
@@ -1710,7 +1710,7 @@ void LLPipeline::createObjects(F32 max_dtime)
 	while (!mCreateQ.empty() && update_timer.getElapsedTimeF32() < max_dtime)
 	{
 		LLViewerObject* vobj = mCreateQ.front();
-		if (!vobj->isDead())
+		if (!vobj->isDead() && vobj->mDrawable.isNull())
 		{
 			createObject(vobj);
 		}
@@ -1749,6 +1749,18 @@ void LLPipeline::createObject(LLViewerObject* vobj)
 		vobj->setDrawableParent(NULL); // LLPipeline::addObject 2
 	}
 
+	// Children that got their drawable before this one were left without a
+	// drawable parent, see createObjects().
+	LLViewerObject::const_child_list_t& children = vobj->getChildren();
+	for (LLViewerObject::child_list_t::const_iterator iter = children.begin(); iter != children.end(); ++iter)
+	{
+		LLViewerObject* childp = *iter;
+		if (childp->mDrawable.notNull() && childp->mDrawable->getParent() != drawablep)
+		{
+			childp->setDrawableParent(drawablep);
+		}
+	}
+
 	markRebuild(drawablep, LLDrawable::REBUILD_ALL, TRUE);
 
 	static const LLCachedControl<bool> render_animate_res("RenderAnimateRes",false);
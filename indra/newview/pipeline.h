@@ -224,7 +224,8 @@ public:
 
 	void        resetDrawOrders();
 
-	U32         addObject(LLViewerObject *obj);
+	// With 'defer' the drawable is created later by createObjects(), as with RenderDelayCreation.
+	U32         addObject(LLViewerObject *obj, bool defer = false);
 
 	void		enableShadows(const BOOL enable_shadows);
 
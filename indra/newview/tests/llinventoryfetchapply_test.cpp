@@ -0,0 +1,146 @@
+/**
+ * @file llinventoryfetchapply_test.cpp
+ * @brief Tests for adding fetched inventory folders over several frames.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to test
+#include "../llinventoryfetchapply.h"
+// Dependencies
+#include "llformat.h"
+#include "lltimer.h"
+
+// Tut header
+#include "../test/lltut.h"
+
+namespace
+{
+	// Records what it is asked to do, as "s<folder>", "i<folder>.<item>" and "e<folder>".
+	class TestFetchApply : public LLInventoryFetchApply
+	{
+	public:
+		std::vector<S32> mItemCounts;
+		std::vector<bool> mSkipped;
+		std::vector<std::string> mCalls;
+
+	protected:
+		/*virtual*/ size_t getFolderCount() const { return mItemCounts.size(); }
+		/*virtual*/ size_t getItemCount(size_t folder) const { return mItemCounts[folder]; }
+		/*virtual*/ bool startFolder(size_t folder)
+		{
+			mCalls.push_back(llformat("s%d", (S32)folder));
+			return !mSkipped[folder];
+		}
+		/*virtual*/ void applyItem(size_t folder, size_t item)
+		{
+			mCalls.push_back(llformat("i%d.%d", (S32)folder, (S32)item));
+		}
+		/*virtual*/ void endFolder(size_t folder)
+		{
+			mCalls.push_back(llformat("e%d", (S32)folder));
+		}
+	};
+}
+
+namespace tut
+{
+	struct inventoryfetchapply_test
+	{
+		// Folders with no items, a skipped one, and ones that take several batches of items.
+		void setup(TestFetchApply& apply)
+		{
+			const S32 counts[] = { 3, 0, 40, 5, 16, 17 };
+			for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+			{
+				apply.mItemCounts.push_back(counts[i]);
+				apply.mSkipped.push_back(i == 3);
+			}
+		}
+	};
+
+	typedef test_group<inventoryfetchapply_test> inventoryfetchapply_t;
+	typedef inventoryfetchapply_t::object inventoryfetchapply_object_t;
+	tut::inventoryfetchapply_t tut_inventoryfetchapply("LLInventoryFetchApply");
+
+	// With time to spare everything is handled in one call, folder by folder.
+	template<> template<>
+	void inventoryfetchapply_object_t::test<1>()
+	{
+		TestFetchApply apply;
+		setup(apply);
+		LLTimer frame_timer;
+		ensure("done in one call", apply.apply(frame_timer, 1000.f));
+		std::vector<std::string> expected;
+		for (size_t folder = 0; folder < apply.mItemCounts.size(); ++folder)
+		{
+			expected.push_back(llformat("s%d", (S32)folder));
+			if (apply.mSkipped[folder])
+			{
+				continue;
+			}
+			for (S32 item = 0; item < apply.mItemCounts[folder]; ++item)
+			{
+				expected.push_back(llformat("i%d.%d", (S32)folder, item));
+			}
+			expected.push_back(llformat("e%d", (S32)folder));
+		}
+		ensure_equals("calls", apply.mCalls.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			ensure_equals("call", apply.mCalls[i], expected[i]);
+		}
+		ensure("nothing left", apply.apply(frame_timer, 1000.f));
+		ensure_equals("no more calls", apply.mCalls.size(), expected.size());
+	}
+
+	// Without any time each call still makes progress, resuming where the last
+	// one stopped, also at the first item of a folder, and the result is the same.
+	template<> template<>
+	void inventoryfetchapply_object_t::test<2>()
+	{
+		TestFetchApply all;
+		setup(all);
+		LLTimer frame_timer;
+		all.apply(frame_timer, 1000.f);
+
+		TestFetchApply apply;
+		setup(apply);
+		S32 frames = 0;
+		size_t handled = 0;
+		while (!apply.apply(frame_timer, -1.f))
+		{
+			ensure("progress", apply.mCalls.size() > handled);
+			ensure("one batch at a time", apply.mCalls.size() - handled <= 17);
+			handled = apply.mCalls.size();
+			ensure("finishes", ++frames < 100);
+		}
+		ensure("took several frames", frames > 5);
+		ensure_equals("calls", apply.mCalls.size(), all.mCalls.size());
+		for (size_t i = 0; i < all.mCalls.size(); ++i)
+		{
+			ensure_equals("call", apply.mCalls[i], all.mCalls[i]);
+		}
+	}
+}
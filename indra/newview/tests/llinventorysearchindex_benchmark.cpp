@@ -0,0 +1,135 @@
+/**
+ * @file llinventorysearchindex_benchmark.cpp
+ * @brief A 200,000 item benchmark for the inventory search index.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to benchmark
+#include "../llinventorysearchindex.h"
+// Dependencies
+#include "llrand.h"
+#include "llstring.h"
+#include "lltimer.h"
+
+// Tut header
+#include "../test/lltut.h"
+
+namespace
+{
+	struct test_object_t
+	{
+		LLUUID mID;
+		std::string mName;
+		std::string mDesc;
+	};
+
+	// What the filter would find by looking at every object.
+	void find_all(const std::vector<test_object_t>& objects, const std::string& sub_string, uuid_vec_t& matches)
+	{
+		for (std::vector<test_object_t>::const_iterator iter = objects.begin(); iter != objects.end(); ++iter)
+		{
+			std::string name(iter->mName);
+			std::string desc(iter->mDesc);
+			LLStringUtil::toUpper(name);
+			LLStringUtil::toUpper(desc);
+			if (name.find(sub_string) != std::string::npos || desc.find(sub_string) != std::string::npos)
+			{
+				matches.push_back(iter->mID);
+			}
+		}
+	}
+
+	std::string random_name()
+	{
+		static const char* words[] = { "Shirt", "Pants", "Hair", "Skin", "Shape", "Eyes", "Jacket", "Boots",
+									   "Chair", "Table", "Lamp", "Tree", "Rock", "House", "Texture", "Script",
+									   "Red", "Blue", "Black", "Copy", "Mod", "v2", "Sale", "Gift" };
+		std::string name;
+		S32 count = 1 + ll_rand(3);
+		for (S32 i = 0; i < count; ++i)
+		{
+			if (i)
+			{
+				name += ' ';
+			}
+			name += words[ll_rand(LL_ARRAY_SIZE(words))];
+		}
+		return name + llformat(" %d", ll_rand(1000));
+	}
+}
+
+namespace tut
+{
+	struct inventorysearchindex_benchmark
+	{
+	};
+
+	typedef test_group<inventorysearchindex_benchmark> inventorysearchindex_benchmark_t;
+	typedef inventorysearchindex_benchmark_t::object inventorysearchindex_benchmark_object_t;
+	tut::inventorysearchindex_benchmark_t tut_inventorysearchindex_benchmark("inventorysearchindex_benchmark");
+
+	// Searching a 200,000 item inventory, against upper casing and searching
+	// every name as the folder views do.
+	template<> template<>
+	void inventorysearchindex_benchmark_object_t::test<1>()
+	{
+		const S32 NUM_ITEMS = 200000;
+
+		std::vector<test_object_t> objects(NUM_ITEMS);
+		for (S32 i = 0; i < NUM_ITEMS; ++i)
+		{
+			objects[i].mID.generate();
+			objects[i].mName = random_name();
+			if (!ll_rand(4))
+			{
+				objects[i].mDesc = random_name();
+			}
+		}
+
+		LLTimer timer;
+		LLInventorySearchIndex index;
+		for (S32 i = 0; i < NUM_ITEMS; ++i)
+		{
+			index.update(objects[i].mID, objects[i].mName, objects[i].mDesc);
+		}
+		F32 build_time = timer.getElapsedTimeF32();
+
+		const char* queries[] = { "RED SHIRT 12", "JACKET", "HOUSE 5", "GIFT", "TEXTURE 999", "SH", "V" };
+		for (U32 i = 0; i < LL_ARRAY_SIZE(queries); ++i)
+		{
+			uuid_vec_t found, expected;
+			timer.reset();
+			index.find(queries[i], found);
+			F32 index_time = timer.getElapsedTimeF32();
+			timer.reset();
+			find_all(objects, queries[i], expected);
+			F32 scan_time = timer.getElapsedTimeF32();
+			ensure_equals(queries[i], found.size(), expected.size());
+			LL_INFOS() << "\"" << queries[i] << "\": " << found.size() << " of " << NUM_ITEMS << " items, index "
+					   << index_time * 1000.f << " ms, scan " << scan_time * 1000.f << " ms" << LL_ENDL;
+		}
+		LL_INFOS() << "Index built in " << build_time * 1000.f << " ms" << LL_ENDL;
+	}
+}
@@ -0,0 +1,218 @@
+/**
+ * @file llinventorysearchindex_test.cpp
+ * @brief Tests for the inventory search index.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to test
+#include "../llinventorysearchindex.h"
+// Dependencies
+#include <algorithm>
+#include "llrand.h"
+#include "llstring.h"
+
+// Tut header
+#include "../test/lltut.h"
+
+namespace
+{
+	struct test_object_t
+	{
+		LLUUID mID;
+		std::string mName;
+		std::string mDesc;
+	};
+
+	// What the filter would find by looking at every object.
+	void find_all(const std::vector<test_object_t>& objects, const std::string& sub_string, uuid_vec_t& matches)
+	{
+		for (std::vector<test_object_t>::const_iterator iter = objects.begin(); iter != objects.end(); ++iter)
+		{
+			std::string name(iter->mName);
+			std::string desc(iter->mDesc);
+			LLStringUtil::toUpper(name);
+			LLStringUtil::toUpper(desc);
+			if (name.find(sub_string) != std::string::npos || desc.find(sub_string) != std::string::npos)
+			{
+				matches.push_back(iter->mID);
+			}
+		}
+	}
+
+	std::string random_name()
+	{
+		static const char* words[] = { "Shirt", "Pants", "Hair", "Skin", "Shape", "Eyes", "Jacket", "Boots",
+									   "Chair", "Table", "Lamp", "Tree", "Rock", "House", "Texture", "Script",
+									   "Red", "Blue", "Black", "Copy", "Mod", "v2", "Sale", "Gift" };
+		std::string name;
+		S32 count = 1 + ll_rand(3);
+		for (S32 i = 0; i < count; ++i)
+		{
+			if (i)
+			{
+				name += ' ';
+			}
+			name += words[ll_rand(LL_ARRAY_SIZE(words))];
+		}
+		return name + llformat(" %d", ll_rand(1000));
+	}
+}
+
+namespace tut
+{
+	struct inventorysearchindex_test
+	{
+		// Compares the index with looking at every object.
+		void check(const LLInventorySearchIndex& index, const std::vector<test_object_t>& objects, const std::string& sub_string)
+		{
+			uuid_vec_t expected, found;
+			find_all(objects, sub_string, expected);
+			index.find(sub_string, found);
+			std::sort(expected.begin(), expected.end());
+			std::sort(found.begin(), found.end());
+			ensure("matches for " + sub_string, expected == found);
+		}
+	};
+
+	typedef test_group<inventorysearchindex_test> inventorysearchindex_t;
+	typedef inventorysearchindex_t::object inventorysearchindex_object_t;
+	tut::inventorysearchindex_t tut_inventorysearchindex("inventorysearchindex");
+
+	// Names, descriptions, renames and removals.
+	template<> template<>
+	void inventorysearchindex_object_t::test<1>()
+	{
+		LLInventorySearchIndex index;
+		std::vector<test_object_t> objects(4);
+		const char* names[] = { "Red Shirt", "Blue shirt", "Hair base", "Boots" };
+		const char* descs[] = { "", "Copy of Red Shirt", "", "shiny" };
+		for (S32 i = 0; i < 4; ++i)
+		{
+			objects[i].mID.generate();
+			objects[i].mName = names[i];
+			objects[i].mDesc = descs[i];
+			index.update(objects[i].mID, objects[i].mName, objects[i].mDesc);
+		}
+		ensure_equals("count", index.getCount(), 4);
+		check(index, objects, "SHIRT");
+		check(index, objects, "RED SHIRT");
+		check(index, objects, "SHI");
+		check(index, objects, "SH");
+		check(index, objects, "B");
+		check(index, objects, "BOOTSX");
+		// Name and description are matched separately.
+		check(index, objects, "BOOTSSHINY");
+
+		U32 version = index.getVersion();
+		objects[2].mName = "Shirt too";
+		index.update(objects[2].mID, objects[2].mName, objects[2].mDesc);
+		ensure("version changes", index.getVersion() != version);
+		check(index, objects, "SHIRT");
+		check(index, objects, "HAIR");
+
+		index.remove(objects[0].mID);
+		objects.erase(objects.begin());
+		ensure_equals("removed", index.getCount(), 3);
+		check(index, objects, "RED");
+
+		// The free entry is reused without bringing back the old text.
+		test_object_t added;
+		added.mID.generate();
+		added.mName = "Lamp";
+		objects.push_back(added);
+		index.update(added.mID, added.mName, added.mDesc);
+		check(index, objects, "RED SHIRT");
+		check(index, objects, "LAMP");
+
+		index.clear();
+		objects.clear();
+		ensure_equals("cleared", index.getCount(), 0);
+		check(index, objects, "LAMP");
+	}
+
+	// Many changes: the lists get rebuilt and still agree with a full scan.
+	template<> template<>
+	void inventorysearchindex_object_t::test<2>()
+	{
+		LLInventorySearchIndex index;
+		std::vector<test_object_t> objects(5000);
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			objects[i].mID.generate();
+			objects[i].mName = random_name();
+			index.update(objects[i].mID, objects[i].mName, objects[i].mDesc);
+		}
+		for (S32 i = 0; i < 100000; ++i)
+		{
+			test_object_t& object = objects[ll_rand(objects.size())];
+			if (ll_rand(4))
+			{
+				object.mName = random_name();
+				object.mDesc = ll_rand(2) ? random_name() : std::string();
+				index.update(object.mID, object.mName, object.mDesc);
+			}
+			else
+			{
+				index.remove(object.mID);
+				object.mID.generate();
+				index.update(object.mID, object.mName, object.mDesc);
+			}
+		}
+		ensure_equals("count", index.getCount(), (S32)objects.size());
+		const char* queries[] = { "S", "RE", "SHIRT", "RED SH", "TREE 1", " 99", "SALE", "GIFT V2", "XYZ" };
+		for (U32 i = 0; i < LL_ARRAY_SIZE(queries); ++i)
+		{
+			check(index, objects, queries[i]);
+		}
+	}
+
+	// One and two letter queries, also against names and descriptions shorter
+	// than three letters.
+	template<> template<>
+	void inventorysearchindex_object_t::test<3>()
+	{
+		LLInventorySearchIndex index;
+		std::vector<test_object_t> objects(5);
+		const char* names[] = { "A", "Ab", "x", "Cab", "" };
+		const char* descs[] = { "", "c", "ab", "", "Bc" };
+		for (S32 i = 0; i < 5; ++i)
+		{
+			objects[i].mID.generate();
+			objects[i].mName = names[i];
+			objects[i].mDesc = descs[i];
+			index.update(objects[i].mID, objects[i].mName, objects[i].mDesc);
+		}
+		const char* queries[] = { "A", "B", "C", "X", "AB", "CA", "BC", "XA", "Z", "ZZ" };
+		for (U32 i = 0; i < LL_ARRAY_SIZE(queries); ++i)
+		{
+			check(index, objects, queries[i]);
+		}
+
+		objects[1].mName = "Z";
+		index.update(objects[1].mID, objects[1].mName, objects[1].mDesc);
+		check(index, objects, "AB");
+		check(index, objects, "Z");
+	}
+}
@@ -0,0 +1,124 @@
+/**
+ * @file lllogchatwriter_benchmark.cpp
+ * @brief Saving and recalling a long chat transcript, per line against batched.
+ *
+ * $LicenseInfo:firstyear=2002&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to benchmark
+#include "../lllogchatwriter.h"
+// Dependencies
+#include "lltimer.h"
+
+#include <iostream>
+
+// Tut header
+#include "../test/lltut.h"
+
+namespace
+{
+	std::string test_line(S32 i)
+	{
+		return llformat("[12:%02d]  Resident %d: line number %d", i % 60, i % 7, i);
+	}
+}
+
+namespace tut
+{
+	struct logchatwriter_benchmark
+	{
+		logchatwriter_benchmark()
+		:	mPath(std::string(LLFile::tmpdir()) + "lllogchatwriter_benchmark.txt")
+		{
+			cleanup();
+		}
+		~logchatwriter_benchmark()
+		{
+			cleanup();
+		}
+		void cleanup()
+		{
+			LLFile::remove(mPath);
+			LLFile::remove(LLLogChatWriter::getIndexFileName(mPath));
+		}
+		std::string mPath;
+	};
+
+	typedef test_group<logchatwriter_benchmark> logchatwriter_benchmark_t;
+	typedef logchatwriter_benchmark_t::object logchatwriter_benchmark_object_t;
+	tut::logchatwriter_benchmark_t tut_logchatwriter_benchmark("LLLogChatWriter_benchmark");
+
+	template<> template<>
+	void logchatwriter_benchmark_object_t::test<1>()
+	{
+		// Cost of saving a busy chat: opening, appending and closing the file
+		// per line as LLLogChat used to, against batching. Then the cost of
+		// recalling the end of a long transcript.
+		const S32 lines = 20000;
+		LLTimer timer;
+		for (S32 i = 0; i < lines; ++i)
+		{
+			LLFILE* file = LLFile::fopen(mPath, "a");
+			fprintf(file, "%s\n", test_line(i).c_str());
+			LLFile::close(file);
+		}
+		F64 per_line_ms = timer.getElapsedTimeF64() * 1000.0;
+		cleanup();
+
+		LLLogChatWriter writer;
+		timer.reset();
+		for (S32 i = 0; i < lines; ++i)
+		{
+			writer.append(mPath, test_line(i));
+			if (i % 100 == 99)
+			{
+				writer.flush();
+			}
+		}
+		writer.flush();
+		F64 batched_ms = timer.getElapsedTimeF64() * 1000.0;
+
+		std::vector<std::string> tail;
+		const S32 runs = 100;
+		timer.reset();
+		for (S32 i = 0; i < runs; ++i)
+		{
+			writer.readTail(mPath, 32, tail);
+		}
+		F64 indexed_ms = timer.getElapsedTimeF64() * 1000.0 / runs;
+		ensure_equals("tail", tail.back(), test_line(lines - 1));
+		LLFile::remove(LLLogChatWriter::getIndexFileName(mPath));
+		timer.reset();
+		for (S32 i = 0; i < runs; ++i)
+		{
+			writer.readTail(mPath, 32, tail);
+		}
+		F64 scanned_ms = timer.getElapsedTimeF64() * 1000.0 / runs;
+		ensure_equals("scanned tail", tail.back(), test_line(lines - 1));
+
+		std::cout << "\nSaving " << lines << " lines: " << per_line_ms << " ms opening the file per line, "
+				  << batched_ms << " ms batched" << std::endl;
+		std::cout << "Recalling 32 lines: " << indexed_ms << " ms indexed, " << scanned_ms << " ms scanning" << std::endl;
+	}
+}
@@ -0,0 +1,185 @@
+/**
+ * @file lllogchatwriter_test.cpp
+ * @brief Tests of the chat transcript writer and its line index.
+ *
+ * $LicenseInfo:firstyear=2002&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to test
+#include "../lllogchatwriter.h"
+// Dependencies
+#include "lltimer.h"
+
+// Tut header
+#include "../test/lltut.h"
+
+namespace
+{
+	std::string test_line(S32 i)
+	{
+		return llformat("[12:%02d]  Resident %d: line number %d", i % 60, i % 7, i);
+	}
+
+	// Reads the whole file as lines, the way the index must see it.
+	std::vector<std::string> read_all(const std::string& path)
+	{
+		std::vector<std::string> lines;
+		LLFILE* file = LLFile::fopen(path, "rb");
+		char buffer[4096];
+		while (file && fgets(buffer, sizeof(buffer), file))
+		{
+			std::string line(buffer);
+			while (!line.empty() && (line[line.size() - 1] == '\n' || line[line.size() - 1] == '\r'))
+			{
+				line.erase(line.size() - 1);
+			}
+			lines.push_back(line);
+		}
+		if (file)
+		{
+			LLFile::close(file);
+		}
+		return lines;
+	}
+
+	void check_tail(LLLogChatWriter& writer, const std::string& path, U32 count)
+	{
+		writer.flush();
+		std::vector<std::string> all = read_all(path);
+		std::vector<std::string> tail;
+		tut::ensure("read", writer.readTail(path, count, tail));
+		size_t expected = llmin((size_t)count, all.size());
+		tut::ensure_equals(llformat("tail size %d", count), tail.size(), expected);
+		for (size_t i = 0; i < tail.size(); ++i)
+		{
+			tut::ensure_equals(llformat("tail line %d of %d", i, count), tail[i], all[all.size() - expected + i]);
+		}
+	}
+}
+
+namespace tut
+{
+	struct logchatwriter_test
+	{
+		logchatwriter_test()
+		:	mPath(std::string(LLFile::tmpdir()) + "lllogchatwriter_test.txt")
+		{
+			cleanup();
+		}
+		~logchatwriter_test()
+		{
+			cleanup();
+		}
+		void cleanup()
+		{
+			LLFile::remove(mPath);
+			LLFile::remove(LLLogChatWriter::getIndexFileName(mPath));
+		}
+		std::string mPath;
+	};
+
+	typedef test_group<logchatwriter_test> logchatwriter_t;
+	typedef logchatwriter_t::object logchatwriter_object_t;
+	tut::logchatwriter_t tut_logchatwriter("LLLogChatWriter");
+
+	template<> template<>
+	void logchatwriter_object_t::test<1>()
+	{
+		// Lines written in several batches, some of them spanning two lines
+		// of the file, read back through the index.
+		LLLogChatWriter writer;
+		std::vector<std::string> tail;
+		ensure("missing", !writer.readTail(mPath, 10, tail));
+		for (S32 i = 0; i < 100; ++i)
+		{
+			writer.append(mPath, i % 13 ? test_line(i) : test_line(i) + "\nsecond half");
+			if (i % 9 == 0)
+			{
+				writer.flush();
+			}
+		}
+		static const U32 counts[] = { 1, 2, 15, 16, 17, 32, 99, 107, 108, 500 };
+		for (U32 i = 0; i < LL_ARRAY_SIZE(counts); ++i)
+		{
+			check_tail(writer, mPath, counts[i]);
+		}
+		ensure_equals("file lines", read_all(mPath).size(), (size_t)108);
+		llstat stat_data;
+		ensure("index written", !LLFile::stat(LLLogChatWriter::getIndexFileName(mPath), &stat_data));
+
+		// A second writer picks up the existing index.
+		writer.closeFiles();
+		LLLogChatWriter other;
+		other.append(mPath, "last");
+		check_tail(other, mPath, 20);
+		other.readTail(mPath, 1, tail);
+		ensure_equals("last", tail[0], std::string("last"));
+	}
+
+	template<> template<>
+	void logchatwriter_object_t::test<2>()
+	{
+		// A transcript written by something else: read by scanning, then
+		// indexed on the next append.
+		LLFILE* file = LLFile::fopen(mPath, "wb");
+		for (S32 i = 0; i < 40; ++i)
+		{
+			fprintf(file, "%s\n", test_line(i).c_str());
+		}
+		LLFile::close(file);
+
+		LLLogChatWriter writer;
+		check_tail(writer, mPath, 5);
+		check_tail(writer, mPath, 40);
+		writer.append(mPath, "appended");
+		check_tail(writer, mPath, 30);
+
+		// Appending behind the writer's back makes the index stale.
+		writer.closeFiles();
+		file = LLFile::fopen(mPath, "ab");
+		fprintf(file, "outside 1\noutside 2\n");
+		LLFile::close(file);
+		check_tail(writer, mPath, 3);
+		writer.append(mPath, "after");
+		check_tail(writer, mPath, 25);
+	}
+
+	template<> template<>
+	void logchatwriter_object_t::test<3>()
+	{
+		// The writer thread writes when asked to.
+		LLLogChatWriter writer;
+		writer.start();
+		for (S32 i = 0; i < 10; ++i)
+		{
+			writer.append(mPath, test_line(i));
+		}
+		writer.requestFlush();
+		for (S32 i = 0; i < 500 && read_all(mPath).size() < 10; ++i)
+		{
+			ms_sleep(10);
+		}
+		ensure_equals("written by the thread", read_all(mPath).size(), (size_t)10);
+	}
+}
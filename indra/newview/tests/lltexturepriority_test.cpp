@@ -0,0 +1,140 @@
+/**
+ * @file lltexturepriority_test.cpp
+ * @brief Tests for LLTexturePriority.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to test
+#include "../lltexturepriority.h"
+// Dependencies
+#include "llgltexture.h"
+#include "llrand.h"
+
+// Tut header
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct texturepriority_test
+	{
+		static LLTexturePriorityInput makeInput()
+		{
+			LLTexturePriorityInput input;
+			input.mMaxVirtualSize = 256.f * 256.f;
+			input.mTexelsPerImage = 512.f * 512.f;
+			input.mAdditionalPriority = 0.f;
+			input.mDecodePriority = 0.f;
+			input.mBoostLevel = LLGLTexture::BOOST_NONE;
+			input.mCurDiscard = 3;
+			input.mDesiredDiscard = 0;
+			input.mMaxDiscard = 5;
+			input.mMinDiscard = 0;
+			input.mCachedRawDiscard = -1;
+			input.mFlags = 0;
+			input.mPad = 0;
+			return input;
+		}
+	};
+
+	typedef test_group<texturepriority_test> texturepriority_t;
+	typedef texturepriority_t::object texturepriority_object_t;
+	tut::texturepriority_t tut_texturepriority("texturepriority");
+
+	const S32 MIN_LARGE_IMAGE_SIZE = 65536;
+
+	// Special states
+	template<> template<>
+	void texturepriority_object_t::test<1>()
+	{
+		F32 additional;
+		LLTexturePriorityInput input = makeInput();
+
+		input.mFlags = LLTexturePriorityInput::FULLY_LOADED;
+		ensure_equals("fully loaded", LLTexturePriority::calcPriority(input, MIN_LARGE_IMAGE_SIZE, additional), -1.f);
+
+		input.mFlags = LLTexturePriorityInput::NEEDS_CREATE;
+		input.mDecodePriority = 1234.f;
+		ensure_equals("waiting for create keeps priority", LLTexturePriority::calcPriority(input, MIN_LARGE_IMAGE_SIZE, additional), 1234.f);
+
+		input = makeInput();
+		input.mCurDiscard = 0;
+		ensure_equals("have all data", LLTexturePriority::calcPriority(input, MIN_LARGE_IMAGE_SIZE, additional), -2.f);
+
+		input = makeInput();
+		input.mMaxVirtualSize = 0.f;
+		ensure_equals("off screen", LLTexturePriority::calcPriority(input, MIN_LARGE_IMAGE_SIZE, additional), -5.f);
+	}
+
+	// Textures without data get boosted, and more pixels means more priority
+	template<> template<>
+	void texturepriority_object_t::test<2>()
+	{
+		F32 additional;
+		LLTexturePriorityInput input = makeInput();
+		input.mCurDiscard = -1;
+		F32 no_data = LLTexturePriority::calcPriority(input, MIN_LARGE_IMAGE_SIZE, additional);
+		ensure_equals("no data raises additional priority", additional, 1.f);
+
+		input = makeInput();
+		F32 some_data = LLTexturePriority::calcPriority(input, MIN_LARGE_IMAGE_SIZE, additional);
+		ensure("no data beats partial data", no_data > some_data);
+
+		input.mMaxVirtualSize = 16.f * 16.f;
+		ensure("larger on screen wins", some_data > LLTexturePriority::calcPriority(input, MIN_LARGE_IMAGE_SIZE, additional));
+
+		ensure("within max", no_data <= LLTexturePriority::maxPriority());
+	}
+
+	// A full pass over many textures: the batched loop must match the per texture calls.
+	template<> template<>
+	void texturepriority_object_t::test<3>()
+	{
+		const S32 TEXTURE_COUNT = 20000;
+
+		std::vector<LLTexturePriorityInput> inputs(TEXTURE_COUNT);
+		std::vector<LLTexturePriorityOutput> outputs(TEXTURE_COUNT);
+		for (S32 i = 0; i < TEXTURE_COUNT; ++i)
+		{
+			LLTexturePriorityInput& input = inputs[i];
+			input = makeInput();
+			input.mMaxVirtualSize = ll_frand(1024.f * 1024.f);
+			input.mBoostLevel = (S8)ll_rand(LLGLTexture::BOOST_MAX_LEVEL);
+			input.mCurDiscard = (S8)(ll_rand(7) - 1);
+			input.mDesiredDiscard = (S8)ll_rand(6);
+			input.mAdditionalPriority = ll_frand() < 0.1f ? ll_frand() : 0.f;
+			input.mFlags = (U8)(ll_rand(64) & ~LLTexturePriorityInput::NEEDS_CREATE);
+		}
+
+		LLTexturePriority::calcPriorities(&inputs[0], &outputs[0], TEXTURE_COUNT, MIN_LARGE_IMAGE_SIZE);
+
+		for (S32 i = 0; i < TEXTURE_COUNT; ++i)
+		{
+			F32 additional;
+			F32 priority = LLTexturePriority::calcPriority(inputs[i], MIN_LARGE_IMAGE_SIZE, additional);
+			ensure_equals("batched priority", outputs[i].mDecodePriority, priority);
+			ensure_equals("batched additional priority", outputs[i].mAdditionalPriority, additional);
+		}
+	}
+}
@@ -0,0 +1,154 @@
+/**
+ * @file llvocacheindex_test.cpp
+ * @brief Tests for the object cache indexes.
+ *
+ * $LicenseInfo:firstyear=2000&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to test
+#include "../llvocacheindex.h"
+// Dependencies
+#include "llrand.h"
+
+#include <set>
+
+// Tut header
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct vocacheindex_test
+	{
+	};
+
+	typedef test_group<vocacheindex_test> vocacheindex_t;
+	typedef vocacheindex_t::object vocacheindex_object_t;
+	tut::vocacheindex_t tut_vocacheindex("vocacheindex");
+
+	// Region LRU: fixed slots, least recently used region first.
+	template<> template<>
+	void vocacheindex_object_t::test<1>()
+	{
+		LLVOCacheRegionLRU lru(4);
+		lru.setBudget(3);
+
+		S32 a = lru.insert(100);
+		S32 b = lru.insert(200);
+		S32 c = lru.insert(300);
+		ensure("three regions", a >= 0 && b >= 0 && c >= 0 && lru.getCount() == 3);
+		ensure_equals("over budget", lru.insert(400), -1);
+		ensure_equals("oldest first", lru.getLeastRecent(), a);
+
+		lru.touch(a);
+		ensure_equals("touched region moves up", lru.getLeastRecent(), b);
+		ensure_equals("then the next one", lru.getMoreRecent(b), c);
+
+		lru.remove(b);
+		ensure_equals("removed", lru.find(200), -1);
+		S32 d = lru.insert(400);
+		ensure_equals("free slot reused", d, b);
+		ensure_equals("slot stays put", lru.find(100), a);
+		ensure_equals("handle", lru.getHandle(d), (U64)400);
+
+		ensure("slot taken", !lru.insertAt(a, 500));
+		ensure("duplicate handle", !lru.insertAt(3, 100));
+	}
+
+	// Object index: lookups across the sorted records and the unsorted tail.
+	template<> template<>
+	void vocacheindex_object_t::test<2>()
+	{
+		LLVOCacheObjectIndex index;
+		for (U32 id = 1; id <= 1000; ++id)
+		{
+			index.insert(id * 2).mCRC = id;
+		}
+		for (U32 id = 1; id <= 1000; ++id)
+		{
+			index.insert(id * 2 + 1).mCRC = id;
+		}
+		ensure_equals("size", index.size(), 2000);
+		ensure("unknown id", index.find(5000) == NULL);
+		for (U32 id = 1; id <= 1000; ++id)
+		{
+			LLVOCacheObjectIndex::Record* record = index.find(id * 2 + 1);
+			ensure("found", record && record->mCRC == id);
+		}
+		ensure_equals("insert returns the existing record", index.insert(4).mCRC, (U32)2);
+		ensure_equals("no duplicate", index.size(), 2000);
+
+		for (LLVOCacheObjectIndex::record_list_t::iterator iter = index.begin(); iter != index.end(); ++iter)
+		{
+			iter->mHitCount = iter->mLocalID < 1000 ? 10 : 0;
+		}
+		std::vector<LLVOCacheEntry*> evicted;
+		S32 removed = index.evict(1600, evicted);
+		ensure_equals("evicted down to 15/16 of the budget", index.size(), 1500);
+		ensure_equals("removed count", removed, 500);
+		ensure("hit records kept", index.find(10) != NULL);
+		for (LLVOCacheObjectIndex::record_list_t::iterator iter = index.begin(); iter != index.end(); ++iter)
+		{
+			ensure("every kept record can be found", index.find(iter->mLocalID) == &*iter);
+		}
+	}
+
+	// Many cached regions with objects arriving in random order, visited at random.
+	template<> template<>
+	void vocacheindex_object_t::test<3>()
+	{
+		const S32 NUM_REGIONS = 64;
+		const S32 OBJECTS_PER_REGION = 500;
+		const S32 LOOKUPS = 20000;
+
+		LLVOCacheRegionLRU lru(NUM_REGIONS);
+		std::vector<LLVOCacheObjectIndex> regions(NUM_REGIONS);
+		std::vector<std::set<U32> > expected(NUM_REGIONS);
+		for (S32 i = 0; i < NUM_REGIONS; ++i)
+		{
+			S32 slot = lru.insert((U64)(i + 1) << 32);
+			ensure("slot", slot >= 0);
+			LLVOCacheObjectIndex& index = regions[slot];
+			// Objects arrive in no particular order when entering a region.
+			for (S32 j = 0; j < OBJECTS_PER_REGION; ++j)
+			{
+				U32 id = (U32)ll_rand(1 << 16) + 1;
+				index.insert(id).mCRC = id;
+				expected[slot].insert(id);
+			}
+			ensure_equals("no duplicates", index.size(), (S32)expected[slot].size());
+		}
+		ensure_equals("all regions cached", lru.getCount(), NUM_REGIONS);
+
+		for (S32 i = 0; i < LOOKUPS; ++i)
+		{
+			S32 slot = lru.find((U64)(ll_rand(NUM_REGIONS) + 1) << 32);
+			ensure("region found", slot >= 0);
+			lru.touch(slot);
+			U32 id = (U32)ll_rand(1 << 16) + 1;
+			LLVOCacheObjectIndex::Record* record = regions[slot].find(id);
+			ensure_equals("found if cached", record != NULL, expected[slot].count(id) != 0);
+			ensure("right record", !record || record->mCRC == id);
+		}
+	}
+}
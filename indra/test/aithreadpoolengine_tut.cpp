@@ -0,0 +1,237 @@
+/**
+ * @file aithreadpoolengine_tut.cpp
+ * @brief Tests for AIThreadPoolEngine.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "aistatemachine.h"
+#include "lltimer.h"
+
+#include <atomic>
+
+namespace tut
+{
+	const S32 SERIAL_MACHINES = 5;
+	const S32 PARALLEL_MACHINES = 8;
+	const S32 PARALLEL_STEPS = 100;
+	const S32 MAX_HOG_STEPS = 1000000;
+
+	std::atomic<S32> sRunningSerial(0);			// Serial state machines inside multiplex_impl right now.
+	std::atomic<bool> sSerialOverlap(false);	// Two serial state machines ran at the same time.
+	std::atomic<S32> sSerialDone(0);
+	std::atomic<S32> sParallelDone(0);
+	std::atomic<bool> sHogSawParallel(false);	// The hog finished because the parallel state machines did.
+	std::vector<S32> sSerialOrder;				// Only written by serial state machines.
+
+	// The first state runs in the thread that calls run(); the others on the engine.
+	class TestMachine : public AIStateMachine
+	{
+	  protected:
+		typedef AIStateMachine direct_base_type;
+
+		enum test_state_type {
+		  TestMachine_start = direct_base_type::max_state,
+		  TestMachine_step
+		};
+
+	  public:
+		static state_type const max_state = TestMachine_step + 1;
+
+		TestMachine(S32 index, bool thread_safe) :
+#ifdef CWDEBUG
+			AIStateMachine(false),
+#endif
+			mIndex(index), mThreadSafe(thread_safe), mSteps(0) { }
+
+		/*virtual*/ const char* getName() const { return "TestMachine"; }
+		/*virtual*/ bool thread_safe(void) const { return mThreadSafe; }
+
+	  protected:
+		/*virtual*/ void initialize_impl(void)
+		{
+			set_state(TestMachine_start);
+		}
+
+		/*virtual*/ void multiplex_impl(state_type run_state)
+		{
+			switch (run_state)
+			{
+				case TestMachine_start:
+					set_state(TestMachine_step);
+					yield();
+					break;
+				case TestMachine_step:
+					if (mThreadSafe)
+					{
+						parallel_step();
+					}
+					else
+					{
+						if (++sRunningSerial > 1)
+						{
+							sSerialOverlap = true;
+						}
+						serial_step();
+						--sRunningSerial;
+					}
+					break;
+			}
+		}
+
+		/*virtual*/ char const* state_str_impl(state_type run_state) const
+		{
+			switch(run_state)
+			{
+				AI_CASE_RETURN(TestMachine_start);
+				AI_CASE_RETURN(TestMachine_step);
+			}
+			return "UNKNOWN STATE";
+		}
+
+	  private:
+		// Index -1 is the hog: it keeps yielding until the parallel state machines are done.
+		void serial_step()
+		{
+			if (mSteps++ == 0)
+			{
+				sSerialOrder.push_back(mIndex);
+			}
+			if (mIndex < 0 && sParallelDone < PARALLEL_MACHINES && mSteps < MAX_HOG_STEPS)
+			{
+				yield();
+				return;
+			}
+			if (mIndex < 0)
+			{
+				sHogSawParallel = sParallelDone == PARALLEL_MACHINES;
+			}
+			++sSerialDone;
+			finish();
+		}
+
+		void parallel_step()
+		{
+			if (++mSteps < PARALLEL_STEPS)
+			{
+				yield();
+				return;
+			}
+			++sParallelDone;
+			finish();
+		}
+
+		S32 mIndex;
+		bool mThreadSafe;
+		S32 mSteps;
+	};
+
+	struct threadpoolengine_test
+	{
+		AIThreadPoolEngine mEngine;
+
+		threadpoolengine_test() : mEngine("threadpoolengine_tut")
+		{
+			sRunningSerial = 0;
+			sSerialOverlap = false;
+			sSerialDone = 0;
+			sParallelDone = 0;
+			sHogSawParallel = false;
+			sSerialOrder.clear();
+		}
+
+		~threadpoolengine_test()
+		{
+			mEngine.stop();
+		}
+
+		void add(S32 index, bool thread_safe)
+		{
+			(new TestMachine(index, thread_safe))->run(NULL, 0, false, true, &mEngine);
+		}
+
+		bool wait(S32 serial, S32 parallel)
+		{
+			for (S32 waited = 0; waited < 5000; ++waited)
+			{
+				if (sSerialDone == serial && sParallelDone == parallel)
+				{
+					return true;
+				}
+				ms_sleep(1);
+			}
+			return false;
+		}
+	};
+	typedef test_group<threadpoolengine_test> threadpoolengine_t;
+	typedef threadpoolengine_t::object threadpoolengine_object_t;
+	tut::threadpoolengine_t tut_threadpoolengine("threadpoolengine");
+
+	// With one worker, a serial state machine that keeps yielding doesn't starve the thread-safe ones,
+	// and serial state machines run one at a time in the order they were added.
+	template<> template<>
+	void threadpoolengine_object_t::test<1>()
+	{
+		mEngine.start(1);
+		add(-1, false);
+		for (S32 i = 0; i < SERIAL_MACHINES; ++i)
+		{
+			add(i, false);
+		}
+		for (S32 i = 0; i < PARALLEL_MACHINES; ++i)
+		{
+			add(i, true);
+		}
+		ensure("all finished", wait(SERIAL_MACHINES + 1, PARALLEL_MACHINES));
+		ensure("parallel work progressed", sHogSawParallel);
+		ensure("serial never concurrent", !sSerialOverlap);
+		ensure_equals("serial count", sSerialOrder.size(), (size_t)(SERIAL_MACHINES + 1));
+		for (S32 i = 0; i <= SERIAL_MACHINES; ++i)
+		{
+			ensure_equals("serial order", sSerialOrder[i], i - 1);
+		}
+	}
+
+	// The same with several workers, which share the thread-safe state machines between them.
+	template<> template<>
+	void threadpoolengine_object_t::test<2>()
+	{
+		mEngine.start(4);
+		for (S32 i = 0; i < SERIAL_MACHINES; ++i)
+		{
+			add(i, false);
+		}
+		for (S32 i = 0; i < PARALLEL_MACHINES; ++i)
+		{
+			add(i, true);
+		}
+		ensure("all finished", wait(SERIAL_MACHINES, PARALLEL_MACHINES));
+		ensure("serial never concurrent", !sSerialOverlap);
+		ensure_equals("serial count", sSerialOrder.size(), (size_t)SERIAL_MACHINES);
+		for (S32 i = 0; i < SERIAL_MACHINES; ++i)
+		{
+			ensure_equals("serial order", sSerialOrder[i], i);
+		}
+	}
+}
@@ -50,7 +50,7 @@ namespace tut
 		static bool mListenerFired;
 		control_group()
 		{
-			mCG = new LLControlGroup;
+			mCG = new LLControlGroup("control_group_test");
 			LLUUID random;
 			random.generate();
 			// generate temp dir
@@ -109,7 +109,7 @@ namespace tut
 		int results = mCG->loadFromFile(mTestConfigFile.c_str());
 		mCG->setU32("TestSetting", 13);
 		ensure_equals("value of changed setting", mCG->getU32("TestSetting"), 13);
-		LLControlGroup test_cg;
+		LLControlGroup test_cg("control_group_test_copy");
 		std::string temp_test_file = (mTestConfigDir + "setting_llsd_temp.xml");
 		mCG->saveToFile(temp_test_file.c_str(), TRUE);
 		results = test_cg.loadFromFile(temp_test_file.c_str());
@@ -126,7 +126,7 @@ namespace tut
 		LLSD new_value = 13;
 		control->setValue(new_value, FALSE);
 		ensure_equals("value of changed setting", mCG->getU32("TestSetting"), 13);
-		LLControlGroup test_cg;
+		LLControlGroup test_cg("control_group_test_copy");
 		std::string temp_test_file = (mTestConfigDir + "setting_llsd_persist_temp.xml");
 		mCG->saveToFile(temp_test_file.c_str(), TRUE);
 		results = test_cg.loadFromFile(temp_test_file.c_str());
@@ -140,9 +140,95 @@ namespace tut
 	{
 		int results = mCG->loadFromFile(mTestConfigFile.c_str());
 		ensure("number of settings", (results == 1));
-		mCG->getControl("TestSetting")->getSignal()->connect(boost::bind(&this->handleListenerTest, _2));
+		mCG->getControl("TestSetting")->getSignal()->connect(boost::bind(&control_group::handleListenerTest, _2));
 		mCG->setU32("TestSetting", 13);
 		ensure("listener fired on changed setting", mListenerFired);	   
 	}
 
+	//handles read the current value and follow changes made by name
+	template<> template<>
+	void control_group_t::test<5>()
+	{
+		mCG->declareF32("TestF32", 1.5f, "test", FALSE);
+		mCG->declareS32("TestS32", -3, "test", FALSE);
+		mCG->declareU32("TestU32", 7, "test", FALSE);
+		mCG->declareBOOL("TestBOOL", TRUE, "test", FALSE);
+		LLControlHandle<F32> f32(*mCG, "TestF32");
+		LLControlHandle<S32> s32 = mCG->getHandle<S32>("TestS32");
+		LLControlHandle<U32> u32(*mCG, "TestU32");
+		LLControlHandle<bool> boolean(*mCG, "TestBOOL");
+		ensure("valid", f32.isValid() && s32.isValid() && u32.isValid() && boolean.isValid());
+		ensure_equals("F32", f32.get(), 1.5f);
+		ensure_equals("S32", s32.get(), -3);
+		ensure_equals("U32", u32.get(), 7U);
+		ensure("bool", boolean.get());
+
+		mCG->setF32("TestF32", -0.25f);
+		mCG->setS32("TestS32", 12);
+		mCG->setU32("TestU32", 0xfffffff0U);
+		mCG->setBOOL("TestBOOL", FALSE);
+		ensure_equals("F32 set", f32.get(), -0.25f);
+		ensure_equals("S32 set", s32.get(), 12);
+		ensure_equals("U32 set", u32.get(), 0xfffffff0U);
+		ensure("bool set", !boolean.get());
+
+		mCG->resetToDefaults();
+		ensure_equals("F32 reset", f32.get(), 1.5f);
+		ensure("bool reset", boolean.get());
+	}
+
+	//setting through a handle fires the listeners; names of the wrong type give no handle
+	template<> template<>
+	void control_group_t::test<6>()
+	{
+		int results = mCG->loadFromFile(mTestConfigFile.c_str());
+		ensure("number of settings", (results == 1));
+		mListenerFired = false;
+		mCG->getControl("TestSetting")->getSignal()->connect(boost::bind(&control_group::handleListenerTest, _2));
+		LLControlHandle<U32> handle(*mCG, "TestSetting");
+		handle.set(42);
+		ensure("listener fired on handle set", mListenerFired);
+		ensure_equals("value by name", mCG->getU32("TestSetting"), 42U);
+
+		ensure("wrong type", !LLControlHandle<F32>(*mCG, "TestSetting").isValid());
+		ensure("missing", !LLControlHandle<F32>(*mCG, "NoSuchSetting").isValid());
+		ensure_equals("invalid reads default", LLControlHandle<F32>().get(), 0.f);
+	}
+
+	//the registry finds every declared control by name
+	template<> template<>
+	void control_group_t::test<7>()
+	{
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			mCG->declareS32(llformat("TestSetting%d", i), i, "test", FALSE);
+		}
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			ensure_equals("value by name", mCG->getS32(llformat("TestSetting%d", i)), i);
+		}
+		ensure("missing", mCG->getControl("TestSetting1000") == NULL);
+	}
+
+#ifdef PROF_CTRL_CALLS
+	//lookups by name are counted, handle reads are not
+	template<> template<>
+	void control_group_t::test<8>()
+	{
+		mCG->declareF32("TestF32", 1.5f, "test", FALSE);
+		mCG->resetLookupCounts();
+		LLControlHandle<F32> f32(*mCG, "TestF32");
+		for (S32 i = 0; i < 10; ++i)
+		{
+			ensure_equals("by name", mCG->getF32("TestF32"), 1.5f);
+			ensure_equals("by handle", f32.get(), 1.5f);
+		}
+		LLControlGroup::lookup_counts_t counts;
+		mCG->getLookupCounts(counts);
+		ensure_equals("one control looked up", counts.size(), (size_t)1);
+		ensure_equals("name", counts[0].first, std::string("TestF32"));
+		ensure_equals("count", counts[0].second, 10U);
+	}
+#endif //PROF_CTRL_CALLS
+
 }
@@ -0,0 +1,322 @@
+/** 
+ * @file llerrorasync_tut.cpp
+ * @brief Tests for asynchronous logging.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llerror.h"
+#include "llerrorcontrol.h"
+#include "llfile.h"
+#include "lltimer.h"
+
+#include <atomic>
+
+namespace tut
+{
+	class CollectingRecorder : public LLError::Recorder
+	{
+	public:
+		CollectingRecorder() : mFlushes(0) { }
+
+		/*virtual*/ void recordMessage(LLError::ELevel level, const std::string& message)
+		{
+			mMessages.push_back(message);
+		}
+
+		/*virtual*/ void flush()
+		{
+			++mFlushes;
+		}
+
+		std::vector<std::string> mMessages;
+		S32 mFlushes;
+	};
+
+	// Stands in for the log file: one line per message, flushed when asked.
+	class FileRecorder : public LLError::Recorder
+	{
+	public:
+		FileRecorder(std::string const& filename) : mFile(filename.c_str()) { }
+
+		/*virtual*/ void recordMessage(LLError::ELevel level, const std::string& message)
+		{
+			mFile << message << '\n';
+		}
+
+		/*virtual*/ void flush()
+		{
+			mFile.flush();
+		}
+
+	private:
+		llofstream mFile;
+	};
+
+	// Blocks the logger thread on the first message until released.
+	class BlockingRecorder : public LLError::Recorder
+	{
+	public:
+		BlockingRecorder() : mBlocked(false), mRelease(false) { }
+
+		/*virtual*/ void recordMessage(LLError::ELevel level, const std::string& message)
+		{
+			if (!mBlocked)
+			{
+				mBlocked = true;
+				while (!mRelease)
+				{
+					ms_sleep(1);
+				}
+			}
+			mMessages.push_back(message);
+		}
+
+		std::vector<std::string> mMessages;
+		std::atomic<bool> mBlocked;
+		std::atomic<bool> mRelease;
+	};
+
+	// Holds the logger thread in its first message until released, with time stamps.
+	class TimedRecorder : public BlockingRecorder
+	{
+	public:
+		TimedRecorder() { mWantsTime = true; }
+	};
+
+	std::string sTimeStamp;
+
+	std::string testTime()
+	{
+		return sTimeStamp;
+	}
+
+	void logTimed(char const* text)
+	{
+		LL_INFOS("AsyncTest") << text << LL_ENDL;
+	}
+
+	void logFromRecorder()
+	{
+		LL_INFOS("AsyncTest") << "from recorder" << LL_ENDL;
+	}
+
+	// Queues a message and flushes the log while handling an error, which
+	// is done with the Settings lock held.
+	class FlushingRecorder : public LLError::Recorder
+	{
+	public:
+		FlushingRecorder() : mFlushed(false) { }
+
+		/*virtual*/ void recordMessage(LLError::ELevel level, const std::string& message)
+		{
+			if (level == LLError::LEVEL_ERROR && !mFlushed && message.find("trigger") != std::string::npos)
+			{
+				logFromRecorder();
+				LLError::flushLog();
+				mFlushed = true;
+			}
+			mMessages.push_back(message);
+		}
+
+		std::vector<std::string> mMessages;
+		bool mFlushed;
+	};
+
+	void ignoreFatal(const std::string&)
+	{
+	}
+
+	struct errorasync_test
+	{
+		LLError::SettingsStoragePtr mPriorSettings;
+
+		errorasync_test()
+		{
+			mPriorSettings = LLError::saveAndResetSettings();
+			LLError::setDefaultLevel(LLError::LEVEL_DEBUG);
+		}
+
+		~errorasync_test()
+		{
+			LLError::setAsyncLogging(false);
+			LLError::restoreSettings(mPriorSettings);
+		}
+	};
+	typedef test_group<errorasync_test> errorasync_t;
+	typedef errorasync_t::object errorasync_object_t;
+	tut::errorasync_t tut_errorasync("errorasync");
+
+	// Queued messages arrive complete and in order, also the ones that don't fit a queue record.
+	template<> template<>
+	void errorasync_object_t::test<1>()
+	{
+		boost::shared_ptr<CollectingRecorder> recorder(new CollectingRecorder);
+		LLError::addRecorder(recorder);
+		LLError::setAsyncLogging(true);
+		ensure("async", LLError::getAsyncLogging());
+
+		std::string long_text(1000, 'x');
+		for (S32 i = 0; i < 5000; ++i)
+		{
+			LL_INFOS("AsyncTest") << "message " << i << (i % 100 ? "" : long_text) << LL_ENDL;
+		}
+		LLError::flushLog();
+
+		ensure_equals("all messages", recorder->mMessages.size(), (size_t)5000);
+		for (S32 i = 0; i < 5000; ++i)
+		{
+			std::ostringstream expected;
+			expected << "message " << i << (i % 100 ? "" : long_text);
+			std::string const& message = recorder->mMessages[i];
+			ensure_equals("in order", message.substr(message.size() - expected.str().size()), expected.str());
+		}
+		ensure("batched", recorder->mFlushes < 5000);
+
+		LLError::setAsyncLogging(false);
+		LL_INFOS("AsyncTest") << "synchronous" << LL_ENDL;
+		ensure_equals("synchronous after stop", recorder->mMessages.size(), (size_t)5001);
+		LLError::removeRecorder(recorder);
+	}
+
+	// With a file recorder, as in the viewer: everything gets written, synchronous or queued.
+	template<> template<>
+	void errorasync_object_t::test<2>()
+	{
+		const S32 MESSAGES = 2000;
+		std::string filename("llerrorasync_tut.log");
+		LLError::RecorderPtr recorder(new FileRecorder(filename));
+		LLError::addRecorder(recorder);
+
+		for (S32 i = 0; i < MESSAGES; ++i)
+		{
+			LL_DEBUGS("AsyncTest") << "object " << i << " at " << i * 0.5f << ", " << i * 0.25f << LL_ENDL;
+		}
+		LLError::setAsyncLogging(true);
+		for (S32 i = 0; i < MESSAGES; ++i)
+		{
+			LL_DEBUGS("AsyncTest") << "object " << i << " at " << i * 0.5f << ", " << i * 0.25f << LL_ENDL;
+		}
+		LLError::flushLog();
+		LLError::setAsyncLogging(false);
+		LLError::removeRecorder(recorder);
+		recorder.reset();
+
+		llifstream file(filename.c_str());
+		S32 lines = 0;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			++lines;
+		}
+		file.close();
+		LLFile::remove(filename);
+		ensure_equals("every message written", lines, 2 * MESSAGES);
+	}
+
+	// A logger thread stuck in a recorder is not started again until it stopped.
+	template<> template<>
+	void errorasync_object_t::test<3>()
+	{
+		boost::shared_ptr<BlockingRecorder> recorder(new BlockingRecorder);
+		LLError::addRecorder(recorder);
+		LLError::setAsyncLogging(true);
+		LL_INFOS("AsyncTest") << "block" << LL_ENDL;
+		while (!recorder->mBlocked)
+		{
+			ms_sleep(1);
+		}
+
+		LLError::setAsyncLogging(false);
+		ensure("stopped waiting", !LLError::getAsyncLogging());
+		LLError::setAsyncLogging(true);
+		ensure("not restarted while stuck", !LLError::getAsyncLogging());
+
+		recorder->mRelease = true;
+		for (S32 waited = 0; !LLError::getAsyncLogging() && waited < 2000; ++waited)
+		{
+			ms_sleep(1);
+			LLError::setAsyncLogging(true);
+		}
+		ensure("restarted once stopped", LLError::getAsyncLogging());
+		LL_INFOS("AsyncTest") << "after" << LL_ENDL;
+		LLError::flushLog();
+		LLError::setAsyncLogging(false);
+		LLError::removeRecorder(recorder);
+
+		ensure_equals("both messages", recorder->mMessages.size(), (size_t)2);
+		ensure("in order", recorder->mMessages[1].find("after") != std::string::npos);
+	}
+
+	// Queued messages carry the time they were logged at, not the time they were written.
+	template<> template<>
+	void errorasync_object_t::test<4>()
+	{
+		// The blocked logger thread holds the Settings lock that looking up
+		// the level of a new call site takes.
+		logTimed("not recorded");
+		boost::shared_ptr<TimedRecorder> recorder(new TimedRecorder);
+		LLError::addRecorder(recorder);
+		LLError::setTimeFunction(testTime);
+		LLError::setAsyncLogging(true);
+		sTimeStamp = "first";
+		logTimed("block");
+		while (!recorder->mBlocked)
+		{
+			ms_sleep(1);
+		}
+		sTimeStamp = "second";
+		logTimed("queued");
+		sTimeStamp = "written";
+		recorder->mRelease = true;
+		LLError::flushLog();
+		LLError::setAsyncLogging(false);
+		LLError::removeRecorder(recorder);
+
+		ensure_equals("both messages", recorder->mMessages.size(), (size_t)2);
+		ensure("first stamp", recorder->mMessages[0].find("first ") == 0);
+		ensure("stamped when queued", recorder->mMessages[1].find("second ") == 0);
+	}
+
+	// Flushing the log with the Settings lock held doesn't wait for the
+	// logger thread, which needs that lock.
+	template<> template<>
+	void errorasync_object_t::test<5>()
+	{
+		boost::shared_ptr<FlushingRecorder> recorder(new FlushingRecorder);
+		LLError::addRecorder(recorder);
+		LLError::setFatalFunction(ignoreFatal);
+		// Looks up the level of the call site before there is a lock to deadlock on.
+		logFromRecorder();
+		LLError::setAsyncLogging(true);
+		LL_ERRS("AsyncTest") << "trigger" << LL_ENDL;
+		ensure("flushed from the recorder", recorder->mFlushed);
+		LLError::flushLog();
+		LLError::setAsyncLogging(false);
+		LLError::removeRecorder(recorder);
+
+		ensure_equals("all messages", recorder->mMessages.size(), (size_t)4);
+		ensure("queued from the recorder", recorder->mMessages[3].find("from recorder") != std::string::npos);
+	}
+}
@@ -0,0 +1,111 @@
+/**
+ * @file lleventchannel_benchmark.cpp
+ * @brief Posting benchmark for LLEventChannel against LLEventStream.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lleventchannel.h"
+#include "llevents.h"
+#include "lltimer.h"
+
+#include <boost/bind.hpp>
+#include <iostream>
+
+namespace tut
+{
+	struct BenchEvent
+	{
+		S32 mValue;
+	};
+
+	typedef LLEventChannel<BenchEvent> bench_channel_t;
+
+	static bool count_typed(const BenchEvent& event, S32* sum)
+	{
+		*sum += event.mValue;
+		return false;
+	}
+
+	static bool count_llsd(const LLSD& event, S32* sum)
+	{
+		*sum += event["value"].asInteger();
+		return false;
+	}
+
+	struct eventchannel_benchmark
+	{
+	};
+
+	typedef test_group<eventchannel_benchmark> eventchannel_benchmark_t;
+	typedef eventchannel_benchmark_t::object eventchannel_benchmark_object_t;
+	tut::eventchannel_benchmark_t tut_eventchannel_benchmark("eventchannel_benchmark");
+
+	template<> template<>
+	void eventchannel_benchmark_object_t::test<1>()
+	{
+		// Posts per second with 1, 10 and 100 listeners, against an
+		// LLEventStream that gets a fresh LLSD map for every post like most
+		// producers build one.
+		const S32 listener_counts[] = { 1, 10, 100 };
+		for (S32 n = 0; n < 3; ++n)
+		{
+			S32 listeners = listener_counts[n];
+			S32 posts = 2000000 / listeners;
+
+			S32 typed_sum = 0;
+			bench_channel_t channel;
+			for (S32 i = 0; i < listeners; ++i)
+			{
+				channel.listen("bench", boost::bind(&count_typed, _1, &typed_sum));
+			}
+			LLTimer timer;
+			for (S32 i = 0; i < posts; ++i)
+			{
+				BenchEvent event = { 1 };
+				channel.post(event);
+			}
+			F64 typed_time = timer.getElapsedTimeF64();
+
+			S32 llsd_sum = 0;
+			LLEventStream stream("eventchannel_bench", true);
+			for (S32 i = 0; i < listeners; ++i)
+			{
+				stream.listen(LLEventPump::inventName("bench"), boost::bind(&count_llsd, _1, &llsd_sum));
+			}
+			timer.reset();
+			for (S32 i = 0; i < posts; ++i)
+			{
+				LLSD event;
+				event["value"] = 1;
+				stream.post(event);
+			}
+			F64 llsd_time = timer.getElapsedTimeF64();
+
+			ensure_equals("same work", typed_sum, llsd_sum);
+			std::cout << "\n" << listeners << " listeners: LLEventChannel " << (S32)(posts / typed_time)
+					  << " posts/s, LLEventStream " << (S32)(posts / llsd_time) << " posts/s" << std::endl;
+		}
+	}
+}
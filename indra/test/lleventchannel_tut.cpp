@@ -0,0 +1,240 @@
+/**
+ * @file lleventchannel_tut.cpp
+ * @brief Tests for LLEventChannel.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lleventchannel.h"
+#include "llevents.h"
+
+#include <atomic>
+#include <boost/bind.hpp>
+#include <thread>
+
+namespace tut
+{
+	struct TestEvent
+	{
+		S32 mValue;
+	};
+
+	typedef LLEventChannel<TestEvent> test_channel_t;
+
+	struct eventchannel_test
+	{
+		eventchannel_test() : mSum(0) { }
+
+		bool add(const TestEvent& event, S32 factor)
+		{
+			mSum += event.mValue * factor;
+			mCalls.push_back(factor);
+			return false;
+		}
+
+		static bool stop(const TestEvent&)
+		{
+			return true;
+		}
+
+		S32 mSum;
+		std::vector<S32> mCalls;
+	};
+
+	typedef test_group<eventchannel_test> eventchannel_t;
+	typedef eventchannel_t::object eventchannel_object_t;
+	tut::eventchannel_t tut_eventchannel("eventchannel");
+
+	template<> template<>
+	void eventchannel_object_t::test<1>()
+	{
+		// Order, stopping propagation and disconnecting.
+		test_channel_t channel;
+		TestEvent event = { 2 };
+		ensure("no listeners", !channel.post(event));
+
+		test_channel_t::Connection one = channel.listen("one", boost::bind(&eventchannel_test::add, this, _1, 1));
+		channel.listen("ten", boost::bind(&eventchannel_test::add, this, _1, 10));
+		ensure("not handled", !channel.post(event));
+		ensure_equals("sum", mSum, 22);
+		ensure_equals("calls", mCalls.size(), 2);
+		ensure_equals("order", mCalls[0], 1);
+
+		test_channel_t::Connection stopper = channel.listen("stop", &eventchannel_test::stop);
+		channel.listen("hundred", boost::bind(&eventchannel_test::add, this, _1, 100));
+		ensure("handled", channel.post(event));
+		ensure_equals("stopped before hundred", mSum, 44);
+
+		stopper.disconnect();
+		ensure("disconnected", !stopper.connected());
+		ensure("still connected", one.connected());
+		ensure("stopListening", channel.stopListening("ten"));
+		ensure("stopListening unknown", !channel.stopListening("ten"));
+		ensure_equals("count", channel.getListenerCount(), 2);
+		mSum = 0;
+		channel.post(event);
+		ensure_equals("one and hundred", mSum, 202);
+
+		{
+			test_channel_t::ScopedConnection scoped(channel.listen("scoped", boost::bind(&eventchannel_test::add, this, _1, 1000)));
+			ensure_equals("scoped connected", channel.getListenerCount(), 3);
+		}
+		ensure_equals("scoped disconnected", channel.getListenerCount(), 2);
+	}
+
+	struct SelfRemover
+	{
+		SelfRemover() : mCalls(0) { }
+		bool tick(const TestEvent&)
+		{
+			++mCalls;
+			mConnection.disconnect();
+			mOther.disconnect();
+			return false;
+		}
+		S32 mCalls;
+		test_channel_t::Connection mConnection;
+		test_channel_t::Connection mOther;
+	};
+
+	template<> template<>
+	void eventchannel_object_t::test<2>()
+	{
+		// Listeners that disconnect themselves or a later listener during a post,
+		// and connections that outlive the channel.
+		test_channel_t::Connection orphan;
+		{
+			test_channel_t channel;
+			SelfRemover remover;
+			remover.mConnection = channel.listen("remover", boost::bind(&SelfRemover::tick, &remover, _1));
+			remover.mOther = channel.listen("other", boost::bind(&eventchannel_test::add, this, _1, 1));
+			TestEvent event = { 5 };
+			channel.post(event);
+			channel.post(event);
+			ensure_equals("remover called once", remover.mCalls, 1);
+			ensure_equals("other never called", mSum, 0);
+			ensure_equals("empty", channel.getListenerCount(), 0);
+			orphan = channel.listen("orphan", boost::bind(&eventchannel_test::add, this, _1, 1));
+		}
+		ensure("channel gone", !orphan.connected());
+		orphan.disconnect();
+	}
+
+	template<> template<>
+	void eventchannel_object_t::test<3>()
+	{
+		// Posting from several threads while listeners come and go.
+		test_channel_t channel;
+		std::atomic<S32> calls(0);
+		std::atomic<bool> done(false);
+		struct Counter
+		{
+			static bool count(const TestEvent& event, std::atomic<S32>* calls)
+			{
+				*calls += event.mValue;
+				return false;
+			}
+		};
+		test_channel_t::ScopedConnection permanent(channel.listen("permanent", boost::bind(&Counter::count, _1, &calls)));
+
+		std::vector<std::thread> posters;
+		for (S32 i = 0; i < 4; ++i)
+		{
+			posters.push_back(std::thread([&channel, &done]() {
+				TestEvent event = { 0 };
+				while (!done)
+				{
+					channel.post(event);
+				}
+			}));
+		}
+		for (S32 i = 0; i < 2000; ++i)
+		{
+			test_channel_t::Connection c = channel.listen("temporary", boost::bind(&Counter::count, _1, &calls));
+			c.disconnect();
+		}
+		done = true;
+		for (size_t i = 0; i < posters.size(); ++i)
+		{
+			posters[i].join();
+		}
+		ensure_equals("only the permanent listener is left", channel.getListenerCount(), 1);
+		TestEvent event = { 1 };
+		channel.post(event);
+		ensure_equals("permanent listener still works", (S32)calls, 1);
+	}
+
+	static bool count_typed(const TestEvent& event, S32* sum)
+	{
+		*sum += event.mValue;
+		return false;
+	}
+
+	static bool count_llsd(const LLSD& event, S32* sum)
+	{
+		*sum += event["value"].asInteger();
+		return false;
+	}
+
+	template<> template<>
+	void eventchannel_object_t::test<4>()
+	{
+		// With 1, 10 and 100 listeners every listener sees every post, like on an
+		// LLEventStream that gets an LLSD map for every post.
+		const S32 listener_counts[] = { 1, 10, 100 };
+		for (S32 n = 0; n < 3; ++n)
+		{
+			S32 listeners = listener_counts[n];
+			S32 posts = 1000;
+
+			S32 typed_sum = 0;
+			test_channel_t channel;
+			for (S32 i = 0; i < listeners; ++i)
+			{
+				channel.listen("compare", boost::bind(&count_typed, _1, &typed_sum));
+			}
+			for (S32 i = 0; i < posts; ++i)
+			{
+				TestEvent event = { 1 };
+				channel.post(event);
+			}
+
+			S32 llsd_sum = 0;
+			LLEventStream stream("eventchannel_compare", true);
+			for (S32 i = 0; i < listeners; ++i)
+			{
+				stream.listen(LLEventPump::inventName("compare"), boost::bind(&count_llsd, _1, &llsd_sum));
+			}
+			for (S32 i = 0; i < posts; ++i)
+			{
+				LLSD event;
+				event["value"] = 1;
+				stream.post(event);
+			}
+
+			ensure_equals("every listener saw every post", typed_sum, listeners * posts);
+			ensure_equals("same as LLEventStream", typed_sum, llsd_sum);
+		}
+	}
+}
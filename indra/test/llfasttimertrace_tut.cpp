@@ -0,0 +1,117 @@
+/** 
+ * @file llfasttimertrace_tut.cpp
+ * @brief Tests for LLFastTimerTrace recording and Chrome trace output.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llfasttimer.h"
+#include "llfasttimertrace.h"
+#include "llfile.h"
+#include "llthread.h"
+
+namespace tut
+{
+	class TraceTestThread : public LLThread
+	{
+	public:
+		TraceTestThread() : LLThread("Trace Test Thread") { }
+
+		/*virtual*/ void run()
+		{
+			for (S32 i = 0; i < 100; ++i)
+			{
+				LL_TRACE_SCOPE("worker scope");
+			}
+		}
+	};
+
+	struct fasttimertrace_test
+	{
+		std::string mFilename;
+
+		fasttimertrace_test() : mFilename("fasttimertrace_tut.json") { }
+		~fasttimertrace_test()
+		{
+			LLFastTimerTrace::stop();
+			LLFile::remove(mFilename);
+		}
+
+		std::string readTrace()
+		{
+			llifstream file(mFilename.c_str());
+			std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			return contents;
+		}
+	};
+	typedef test_group<fasttimertrace_test> fasttimertrace_t;
+	typedef fasttimertrace_t::object fasttimertrace_object_t;
+	tut::fasttimertrace_t tut_fasttimertrace("fasttimertrace");
+
+	// Scopes of the main thread and of an LLThread end up in one well formed trace.
+	template<> template<>
+	void fasttimertrace_object_t::test<1>()
+	{
+		ensure("started", LLFastTimerTrace::start(mFilename));
+		ensure("tracing", LLFastTimerTrace::isTracing());
+		{
+			LL_TRACE_SCOPE("main scope");
+			TraceTestThread thread;
+			thread.start();
+			while (!thread.isStopped())
+			{
+				ms_sleep(1);
+			}
+		}
+		LLFastTimerTrace::stop();
+		ensure("stopped", !LLFastTimerTrace::isTracing());
+
+		std::string trace = readTrace();
+		ensure_equals("header", trace.substr(0, 16), std::string("{\"traceEvents\":["));
+		ensure("footer", trace.find("]}") != std::string::npos);
+		ensure("main thread events", trace.find("\"name\":\"main scope\",\"ph\":\"X\"") != std::string::npos);
+		ensure("worker thread events", trace.find("\"name\":\"worker scope\",\"ph\":\"X\"") != std::string::npos);
+		ensure("worker thread named", trace.find("\"args\":{\"name\":\"Trace Test Thread\"}") != std::string::npos);
+		ensure_equals("nothing dropped", LLFastTimerTrace::getDroppedEvents(), 0U);
+	}
+
+	// Nothing is recorded while not tracing, and a second trace starts clean.
+	template<> template<>
+	void fasttimertrace_object_t::test<2>()
+	{
+		LLFastTimerTrace::stop();
+		{
+			LL_TRACE_SCOPE("untraced scope");
+		}
+		ensure("started", LLFastTimerTrace::start(mFilename));
+		{
+			LL_TRACE_SCOPE("traced scope");
+		}
+		LLFastTimerTrace::stop();
+
+		std::string trace = readTrace();
+		ensure("traced", trace.find("traced scope") != std::string::npos);
+		ensure("not traced", trace.find("untraced scope") == std::string::npos);
+	}
+}
@@ -0,0 +1,182 @@
+/**
+ * @file llpluginmessagepipe_benchmark.cpp
+ * @brief Round trip benchmark for the xml and binary plugin message encodings.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llpluginmessage.h"
+#include "llpluginmessagepipe.h"
+#include "llhost.h"
+#include "lltimer.h"
+
+#include <iostream>
+
+#if LL_LINUX || LL_DARWIN
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace tut
+{
+	// Parses everything it receives and, if mEcho is set, sends it back in the same encoding.
+	class EchoPipeOwner : public LLPluginMessagePipeOwner
+	{
+	public:
+		EchoPipeOwner(bool echo) : mEcho(echo), mReceived(0), mQuit(false) { }
+
+		/*virtual*/ void receiveMessageRaw(const std::string &message)
+		{
+			++mReceived;
+			mLast.parse(message);
+			if (mLast.getName() == "quit")
+			{
+				mQuit = true;
+			}
+			else if (mEcho)
+			{
+				setBinaryMessages(LLPluginMessage::isBinary(message));
+				writeMessageRaw(generateMessage(mLast));
+			}
+		}
+
+		using LLPluginMessagePipeOwner::setBinaryMessages;
+		using LLPluginMessagePipeOwner::generateMessage;
+		using LLPluginMessagePipeOwner::writeMessageRaw;
+		using LLPluginMessagePipeOwner::flushMessages;
+		using LLPluginMessagePipeOwner::canSendMessage;
+		using LLPluginMessagePipeOwner::mMessagePipe;
+		using LLPluginMessagePipeOwner::mSocketError;
+
+		bool mEcho;
+		S32 mReceived;
+		bool mQuit;
+		LLPluginMessage mLast;
+	};
+
+	// Something like what a media plugin sends for every frame.
+	static LLPluginMessage make_frame_message(S32 i)
+	{
+		LLPluginMessage message("media", "updated");
+		message.setValueS32("left", 0);
+		message.setValueS32("top", i);
+		message.setValueS32("right", 1024);
+		message.setValueS32("bottom", 768);
+		message.setValueReal("current_time", i * 0.04);
+		message.setValueU32("flags", 0xdeadbeef);
+		message.setValueBoolean("dirty", true);
+		message.setValue("name", "some shared memory segment name");
+		return message;
+	}
+
+	struct pluginmessagepipe_benchmark
+	{
+	};
+
+	typedef test_group<pluginmessagepipe_benchmark> pluginmessagepipe_benchmark_t;
+	typedef pluginmessagepipe_benchmark_t::object pluginmessagepipe_benchmark_object_t;
+	tut::pluginmessagepipe_benchmark_t tut_pluginmessagepipe_benchmark("pluginmessagepipe_benchmark");
+
+#if LL_LINUX || LL_DARWIN
+	template<> template<>
+	void pluginmessagepipe_benchmark_object_t::test<1>()
+	{
+		// This process sends messages to a child process that echoes them back, once per encoding.
+		LLSocket::ptr_t listen_socket;
+		U16 port;
+		for (port = 41000; port < 41100 && !listen_socket; ++port)
+		{
+			listen_socket = LLSocket::create(LLSocket::STREAM_TCP, port);
+		}
+		ensure("listening", (bool)listen_socket);
+		port = listen_socket->getPort();
+
+		pid_t pid = fork();
+		ensure("fork", pid != -1);
+		if (pid == 0)
+		{
+			// The echoing child process.
+			int exit_code = 1;
+			LLSocket::ptr_t socket = LLSocket::create(LLSocket::STREAM_TCP);
+			if (socket && socket->blockingConnect(LLHost("127.0.0.1", port)))
+			{
+				EchoPipeOwner owner(true);
+				new LLPluginMessagePipe(&owner, socket);
+				while (!owner.mQuit && owner.mSocketError == APR_SUCCESS && owner.canSendMessage())
+				{
+					owner.mMessagePipe->pump(0.01);
+				}
+				exit_code = owner.mQuit ? 0 : 1;
+			}
+			_exit(exit_code);
+		}
+
+		LLSocket::ptr_t socket;
+		apr_status_t status;
+		for (int count = 0; !socket && count < 500; ++count)
+		{
+			socket = LLSocket::create(status, listen_socket);
+			if (!socket)
+			{
+				ms_sleep(10);
+			}
+		}
+		ensure("accepted", (bool)socket);
+
+		EchoPipeOwner owner(false);
+		LLPluginMessagePipe* pipe = new LLPluginMessagePipe(&owner, socket);
+		S32 const messages = 5000;
+		F64 elapsed[2];
+		for (int binary = 0; binary < 2; ++binary)
+		{
+			owner.setBinaryMessages(binary);
+			owner.mReceived = 0;
+			LLTimer timer;
+			for (S32 i = 0; i < messages; ++i)
+			{
+				owner.writeMessageRaw(owner.generateMessage(make_frame_message(i)));
+				if (i % 64 == 63)
+				{
+					pipe->pump();
+				}
+			}
+			while (owner.mReceived < messages && owner.mSocketError == APR_SUCCESS && timer.getElapsedTimeF64() < 30.0)
+			{
+				pipe->pump(0.001);
+			}
+			elapsed[binary] = timer.getElapsedTimeF64();
+			ensure_equals("all messages came back", owner.mReceived, messages);
+		}
+
+		owner.writeMessageRaw(owner.generateMessage(LLPluginMessage("test", "quit")));
+		owner.flushMessages();
+		int child_status = 0;
+		waitpid(pid, &child_status, 0);
+
+		std::cout << "\nPlugin pipe round trip of " << messages << " messages: xml "
+				  << elapsed[0] * 1000 << " ms, binary " << elapsed[1] * 1000 << " ms." << std::endl;
+	}
+#endif
+}
@@ -0,0 +1,122 @@
+/**
+ * @file llsdserialize_benchmark.cpp
+ * @brief XML LLSD parsing benchmark, expat against the pull parser.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llsd.h"
+#include "llsdserialize.h"
+#include "lltut.h"
+#include "llformat.h"
+#include "lltimer.h"
+#include "lluri.h"
+
+#include <iostream>
+
+namespace tut
+{
+	struct sdserialize_benchmark
+	{
+	};
+
+	typedef test_group<sdserialize_benchmark> sdserialize_benchmark_t;
+	typedef sdserialize_benchmark_t::object sdserialize_benchmark_object_t;
+	tut::sdserialize_benchmark_t tut_sdserialize_benchmark("llsdserialize_benchmark");
+
+	template<> template<>
+	void sdserialize_benchmark_object_t::test<1>()
+	{
+		// An event queue reply with a busy group chat and some region traffic,
+		// expat vs. the pull parser.
+		LLSD events = LLSD::emptyArray();
+		for (S32 i = 0; i < 2000; ++i)
+		{
+			LLSD event;
+			LLSD& body = event["body"];
+			switch (i % 3)
+			{
+				case 0:
+				{
+					event["message"] = "ChatterBoxSessionAgentListUpdates";
+					LLSD& update = body["agent_updates"][LLUUID::generateNewID().asString()];
+					update["info"]["can_voice_chat"] = true;
+					update["info"]["is_moderator"] = false;
+					update["info"]["mutes"]["text"] = false;
+					update["transition"] = "ENTER";
+					body["session_id"] = LLUUID::generateNewID();
+					body["updates"] = LLSD::emptyMap();
+					break;
+				}
+				case 1:
+				{
+					event["message"] = "ChatterBoxInvitation";
+					LLSD& im = body["instantmessage"]["message_params"];
+					im["from_id"] = LLUUID::generateNewID();
+					im["from_name"] = llformat("Resident %d", i);
+					im["message"] = llformat("Message %d with <some> \"markup\" & an accent: caf\xc3\xa9", i);
+					im["timestamp"] = (S32)(1300000000 + i);
+					im["position"].append(128.5 + i);
+					im["position"].append(64.25);
+					im["position"].append(22.0);
+					im["region_id"] = LLUUID::generateNewID();
+					im["data"]["binary_bucket"] = LLSD::Binary(16, (U8)i);
+					body["session_id"] = LLUUID::generateNewID();
+					break;
+				}
+				default:
+				{
+					event["message"] = "EstablishAgentCommunication";
+					body["agent-id"] = LLUUID::generateNewID();
+					body["sim-ip-and-port"] = llformat("216.82.%d.%d:13005", i % 255, (i * 7) % 255);
+					body["seed-capability"] = LLURI(llformat("https://sim%d.agni.lindenlab.com:12043/cap/%s", i, LLUUID::generateNewID().asString().c_str()));
+					body["expires"] = LLDate(1300000000.0 + i);
+					break;
+				}
+			}
+			events.append(event);
+		}
+		LLSD doc;
+		doc["events"] = events;
+		doc["id"] = 4242;
+		std::ostringstream out;
+		LLSDSerialize::toXML(doc, out);
+		std::string data = out.str();
+
+		LLTimer timer;
+		LLSD from_stream;
+		std::istringstream in(data);
+		LLSDSerialize::fromXML(from_stream, in);
+		F64 stream_time = timer.getElapsedTimeF64();
+
+		timer.reset();
+		LLSD from_span;
+		LLSDSerialize::fromXML(from_span, (const U8*)data.data(), data.size());
+		F64 span_time = timer.getElapsedTimeF64();
+
+		ensure_equals("same document", from_span, from_stream);
+		std::cout << "\nXML LLSD event queue reply, " << data.size() << " bytes: expat " << stream_time * 1000.0
+				  << " ms, pull parser " << span_time * 1000.0 << " ms" << std::endl;
+	}
+}
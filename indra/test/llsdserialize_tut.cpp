@@ -1439,6 +1439,315 @@ namespace tut
 		ensureBinaryAndNotation("map", test);
 		ensureBinaryAndXML("map", test);
 	}
+
+	/**
+	 * @class TestLLSDSpanParsing
+	 * @brief Tests the in-memory binary, notation and XML parsers against the stream ones.
+	 */
+	struct TestLLSDSpanParsing
+	{
+		enum EFormat { BINARY, NOTATION, XML };
+
+		static S32 parseSegments(EFormat format, LLSD& parsed, const LLSDSerialize::segments_t& segments, size_t* consumed)
+		{
+			switch (format)
+			{
+				case BINARY:
+					return LLSDSerialize::fromBinary(parsed, segments, consumed);
+				case NOTATION:
+					return LLSDSerialize::fromNotation(parsed, segments, consumed);
+				default:
+					return LLSDSerialize::fromXML(parsed, segments, consumed);
+			}
+		}
+
+		LLSD makeDocument()
+		{
+			LLSD doc;
+			doc["int"] = -42;
+			doc["real"] = 1234.5;
+			doc["string"] = "quoted \"text\" with 'both' kinds and \\ \n escapes";
+			doc["uuid"] = LLUUID("e5f2d5e2-22c1-4f1b-9ef0-5e2b0dca7e1a");
+			doc["date"] = LLDate(1234567890.0);
+			doc["uri"] = LLURI("http://secondlife.com/");
+			doc["binary"] = LLSD::Binary(33, 0xa5);
+			doc["array"].append(true);
+			doc["array"].append(LLSD());
+			doc["array"].append(LLSD::emptyMap());
+			return doc;
+		}
+
+		// Parses data split into two segments at every offset.
+		void ensureSplitParse(const std::string& msg, const std::string& data, const LLSD& expected, EFormat format)
+		{
+			const U8* bytes = (const U8*)data.data();
+			for (size_t split = 0; split <= data.size(); ++split)
+			{
+				LLSDSerialize::segments_t segments;
+				segments.push_back(std::make_pair(bytes, split));
+				segments.push_back(std::make_pair(bytes + split, data.size() - split));
+				LLSD parsed;
+				size_t consumed = 0;
+				S32 count = parseSegments(format, parsed, segments, &consumed);
+				std::string what = msg + llformat(" split at %d", (S32)split);
+				ensure(what.c_str(), count > 0);
+				ensure_equals((what + " consumed").c_str(), consumed, data.size());
+				ensure_equals(what.c_str(), parsed, expected);
+			}
+		}
+
+		// The XML parser must agree with LLSDXMLParser, including on what it
+		// doesn't like.
+		void ensureSameAsStream(const std::string& msg, const std::string& data)
+		{
+			LLSD from_stream;
+			std::istringstream istr(data);
+			S32 stream_count = LLSDSerialize::fromXML(from_stream, istr, false);
+			LLSD parsed;
+			S32 count = LLSDSerialize::fromXML(parsed, (const U8*)data.data(), data.size(), NULL, false);
+			ensure_equals((msg + " count").c_str(), count, stream_count);
+			ensure_equals(msg.c_str(), parsed, from_stream);
+		}
+	};
+
+	typedef tut::test_group<TestLLSDSpanParsing> TestLLSDSpanParsingGroup;
+	typedef TestLLSDSpanParsingGroup::object TestLLSDSpanParsingObject;
+	TestLLSDSpanParsingGroup gTestLLSDSpanParsingGroup("llsd span parsing");
+
+	template<> template<> 
+	void TestLLSDSpanParsingObject::test<1>()
+	{
+		LLSD doc = makeDocument();
+		std::ostringstream binary;
+		LLSDSerialize::toBinary(doc, binary);
+		ensureSplitParse("binary", binary.str(), doc, BINARY);
+		std::ostringstream notation;
+		LLSDSerialize::toNotation(doc, notation);
+		ensureSplitParse("notation", notation.str(), doc, NOTATION);
+		std::ostringstream xml;
+		LLSDSerialize::toXML(doc, xml);
+		ensureSplitParse("xml", xml.str(), doc, XML);
+		std::ostringstream pretty_xml;
+		LLSDSerialize::toPrettyXML(doc, pretty_xml);
+		ensureSplitParse("pretty xml", pretty_xml.str(), doc, XML);
+	}
+
+	template<> template<> 
+	void TestLLSDSpanParsingObject::test<2>()
+	{
+		// Truncated input must fail, never return a partial document.
+		LLSD doc = makeDocument();
+		std::ostringstream binary;
+		LLSDSerialize::toBinary(doc, binary);
+		std::string data = binary.str();
+		for (size_t len = 1; len < data.size(); ++len)
+		{
+			LLSD parsed;
+			ensure(llformat("binary truncated to %d", (S32)len),
+				   LLSDSerialize::fromBinary(parsed, (const U8*)data.data(), len) <= 0);
+		}
+		std::ostringstream notation;
+		LLSDSerialize::toNotation(doc, notation);
+		data = notation.str();
+		for (size_t len = 1; len < data.size(); ++len)
+		{
+			LLSD parsed;
+			ensure(llformat("notation truncated to %d", (S32)len),
+				   LLSDSerialize::fromNotation(parsed, (const U8*)data.data(), len) <= 0);
+		}
+		std::ostringstream xml;
+		LLSDSerialize::toXML(doc, xml);
+		data = xml.str();
+		// Everything but the final line end.
+		for (size_t len = 1; len < data.size() - 1; ++len)
+		{
+			LLSD parsed;
+			ensure(llformat("xml truncated to %d", (S32)len),
+				   LLSDSerialize::fromXML(parsed, (const U8*)data.data(), len, NULL, false) <= 0);
+		}
+	}
+
+	template<> template<> 
+	void TestLLSDSpanParsingObject::test<3>()
+	{
+		// Hand written notation with the other spellings the stream parser accepts.
+		std::string data = "[ TRUE, f , i -5, r1e3, b64\"aGVsbG8=\", b16\"6869\", s(3)\"abc\", { 'x' : 1 , \"y\":t } ]";
+		LLSD parsed;
+		ensure("parse", LLSDSerialize::fromNotation(parsed, (const U8*)data.data(), data.size()) > 0);
+		ensure_equals("size", parsed.size(), 8);
+		ensure_equals("true", parsed[0].asBoolean(), true);
+		ensure_equals("false", parsed[1].asBoolean(), false);
+		ensure_equals("int", parsed[2].asInteger(), -5);
+		ensure_equals("real", parsed[3].asReal(), 1000.0);
+		LLSD::Binary hello = parsed[4].asBinary();
+		ensure_equals("b64", std::string(hello.begin(), hello.end()), "hello");
+		LLSD::Binary hi = parsed[5].asBinary();
+		ensure_equals("b16", std::string(hi.begin(), hi.end()), "hi");
+		ensure_equals("sized string", parsed[6].asString(), "abc");
+		ensure_equals("map", parsed[7]["y"].asBoolean(), true);
+	}
+
+	template<> template<> 
+	void TestLLSDSpanParsingObject::test<4>()
+	{
+		// A larger document, as a region capabilities or inventory reply: both parsers agree.
+		LLSD doc = LLSD::emptyArray();
+		for (S32 i = 0; i < 200; ++i)
+		{
+			LLSD item;
+			item["name"] = llformat("item number %d", i);
+			item["id"] = LLUUID::generateNewID();
+			item["count"] = i;
+			item["data"] = LLSD::Binary(128, (U8)i);
+			doc.append(item);
+		}
+		std::ostringstream out;
+		LLSDSerialize::toBinary(doc, out);
+		std::string data = out.str();
+
+		LLSD from_stream;
+		std::istringstream in(data);
+		LLSDSerialize::fromBinary(from_stream, in, data.size());
+		LLSD from_span;
+		size_t consumed = 0;
+		ensure("parsed", LLSDSerialize::fromBinary(from_span, (const U8*)data.data(), data.size(), &consumed) > 0);
+		ensure_equals("consumed", consumed, data.size());
+		ensure_equals("same document", from_span, from_stream);
+	}
+
+	template<> template<> 
+	void TestLLSDSpanParsingObject::test<5>()
+	{
+		// XML the way other writers spell it, and XML the pull parser leaves to expat.
+		ensureSameAsStream("prolog and entities",
+			"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<!DOCTYPE llsd SYSTEM \"llsd.dtd\">\n"
+			"<!-- comment -->\n"
+			"<llsd>\n<map>\n"
+			"  <key>a&amp;b</key><string>x &lt; y &#65;&#x42; caf\xc3\xa9\r\nline</string>\n"
+			"  <key>int</key><integer> -12 </integer>\n"
+			"  <key>big</key><integer>12345678901</integer>\n"
+			"  <key>odd int</key><integer>1.9</integer>\n"
+			"  <key>real</key><real>-1.5e3</real>\n"
+			"  <key>odd real</key><real>1.5 </real>\n"
+			"  <key>true</key><boolean>1</boolean>\n"
+			"  <key>false</key><boolean>TRUE</boolean>\n"
+			"  <key>uuid</key><uuid>E5F2D5E2-22C1-4F1B-9EF0-5E2B0DCA7E1A</uuid>\n"
+			"  <key>date</key><date>2010-04-16T21:32:26.142178Z</date>\n"
+			"  <key>offset date</key><date>2010-04-16T21:34:02+02:00</date>\n"
+			"  <key>binary</key><binary encoding=\"base64\">aGVs\n  bG8=</binary>\n"
+			"  <key>odd binary</key><binary>aGVsbG8</binary>\n"
+			"  <key>empty</key><binary/>\n"
+			"  <key>twice</key><integer>1</integer><key>twice</key><integer>2</integer>\n"
+			"  <key>array</key><array><undef/><array /><map></map><uri>http://x/?a=1&amp;b=2</uri></array>\n"
+			"</map>\n</llsd>\n");
+		ensureSameAsStream("cdata", "<llsd><map><key>x</key><string><![CDATA[a<b]]></string></map></llsd>");
+		ensureSameAsStream("unknown element", "<llsd><array><integer>1</integer><foo>1</foo></array></llsd>");
+		ensureSameAsStream("other encoding", "<llsd><binary encoding=\"base16\">6869</binary></llsd>");
+		ensureSameAsStream("empty key", "<llsd><map><key></key><integer>1</integer></map></llsd>");
+		ensureSameAsStream("mismatched", "<llsd><map><key>x</key><string>y</map></llsd>");
+		ensureSameAsStream("not llsd", "<notllsd><integer>1</integer></notllsd>");
+		ensureSameAsStream("late declaration", "  <?xml version=\"1.0\"?><llsd><integer>1</integer></llsd>");
+		ensureSameAsStream("bad utf-8", "<llsd><string>\xc3\x28</string></llsd>");
+		ensureSameAsStream("bad reference", "<llsd><string>&nbsp;</string></llsd>");
+		ensureSameAsStream("empty", "<llsd/>");
+	}
+
+	template<> template<> 
+	void TestLLSDSpanParsingObject::test<6>()
+	{
+		// Deep nesting, which the pull parser leaves to expat.
+		for (S32 depth = 127; depth <= 129; ++depth)
+		{
+			std::string data = "<llsd>";
+			for (S32 i = 0; i < depth; ++i)
+			{
+				data += i % 2 ? "<map><key>k</key>" : "<array>";
+			}
+			data += "<integer>1</integer>";
+			for (S32 i = depth - 1; i >= 0; --i)
+			{
+				data += i % 2 ? "</map>" : "</array>";
+			}
+			data += "</llsd>";
+			ensureSameAsStream(llformat("nested %d deep", depth), data);
+		}
+
+		// Reals are converted the same however they are spelled.
+		const char* reals[] = { "0", "-0", "1.5", "-0.25e3", "+2.", ".5", "1e-30", "1E22", "1e23", "0.1",
+								"123456789012345", "1234567890123456789", "0.000001234567890123456789",
+								"9007199254740993", "1.7976931348623157e308", "1e-400", "1e", "e1", ".", "-",
+								"1.2.3", "0x10", "nan", "inf" };
+		for (size_t i = 0; i < sizeof(reals) / sizeof(reals[0]); ++i)
+		{
+			ensureSameAsStream(llformat("real %s", reals[i]), llformat("<llsd><real>%s</real></llsd>", reals[i]));
+		}
+	}
+
+	template<> template<> 
+	void TestLLSDSpanParsingObject::test<7>()
+	{
+		// Notation reals convert to what the stream parser gets.
+		const char* reals[] = { "0", "-0", "1.5", "-0.25e3", "+2.", ".5", "1e-30", "1E22", "1e23", "0.1",
+								"123456789012345", "1234567890123456789", "0.000001234567890123456789",
+								"9007199254740993", "1.7976931348623157e308" };
+		for (size_t i = 0; i < sizeof(reals) / sizeof(reals[0]); ++i)
+		{
+			std::string data = llformat("[r%s]", reals[i]);
+			LLSD from_stream;
+			std::istringstream istr(data);
+			ensure(llformat("stream %s", reals[i]), LLSDSerialize::fromNotation(from_stream, istr, data.size()) > 0);
+			LLSD parsed;
+			ensure(llformat("span %s", reals[i]), LLSDSerialize::fromNotation(parsed, (const U8*)data.data(), data.size()) > 0);
+			ensure_equals(llformat("real %s", reals[i]).c_str(), parsed[0].asReal(), from_stream[0].asReal());
+		}
+		const char* bad[] = { "", "-", ".", "e1", "1e", "1e+" };
+		for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i)
+		{
+			std::string data = llformat("[r%s]", bad[i]);
+			LLSD parsed;
+			ensure(llformat("bad real %s", bad[i]), LLSDSerialize::fromNotation(parsed, (const U8*)data.data(), data.size()) <= 0);
+		}
+	}
+
+	template<> template<> 
+	void TestLLSDSpanParsingObject::test<8>()
+	{
+		// Binary and notation nested too deeply fail instead of recursing further.
+		for (S32 depth = 128; depth <= 129; ++depth)
+		{
+			LLSD doc = 1;
+			for (S32 i = 0; i < depth; ++i)
+			{
+				LLSD outer;
+				if (i % 2)
+				{
+					outer["k"] = doc;
+				}
+				else
+				{
+					outer.append(doc);
+				}
+				doc = outer;
+			}
+			bool fits = depth <= 128;
+			std::ostringstream binary;
+			LLSDSerialize::toBinary(doc, binary);
+			std::string data = binary.str();
+			LLSD parsed;
+			ensure_equals(llformat("binary %d deep", depth),
+						  LLSDSerialize::fromBinary(parsed, (const U8*)data.data(), data.size()) > 0, fits);
+			std::ostringstream notation;
+			LLSDSerialize::toNotation(doc, notation);
+			data = notation.str();
+			ensure_equals(llformat("notation %d deep", depth),
+						  LLSDSerialize::fromNotation(parsed, (const U8*)data.data(), data.size()) > 0, fits);
+			if (fits)
+			{
+				ensure_equals("same document", parsed, doc);
+			}
+		}
+	}
 }
 
 #endif
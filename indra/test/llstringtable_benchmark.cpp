@@ -0,0 +1,102 @@
+/**
+ * @file llstringtable_benchmark.cpp
+ * @brief Contention benchmark for LLStringTable.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llstringtable.h"
+#include "lltimer.h"
+
+#include <iostream>
+#include <thread>
+
+namespace tut
+{
+	struct stringtable_benchmark
+	{
+	};
+
+	typedef test_group<stringtable_benchmark> stringtable_benchmark_t;
+	typedef stringtable_benchmark_t::object stringtable_benchmark_object_t;
+	tut::stringtable_benchmark_t tut_stringtable_benchmark("stringtable_benchmark");
+
+	template<> template<>
+	void stringtable_benchmark_object_t::test<1>()
+	{
+		// Lookups and inserts from 1, 4 and 8 threads.
+		const S32 NAMES = 20000;
+		const S32 LOOKUPS = 1000000;
+		std::vector<std::string> names;
+		for (S32 i = 0; i < NAMES; ++i)
+		{
+			names.push_back(llformat("Benchmark_Name_%d", i));
+		}
+		const S32 thread_counts[] = { 1, 4, 8 };
+		for (S32 c = 0; c < 3; ++c)
+		{
+			S32 num_threads = thread_counts[c];
+			LLStringTable table(32768);
+			std::vector<std::thread> threads;
+
+			// Every thread inserts every name: the first one wins, the rest find it.
+			LLTimer timer;
+			for (S32 t = 0; t < num_threads; ++t)
+			{
+				threads.push_back(std::thread([&table, &names, t, NAMES]() {
+					for (S32 i = 0; i < NAMES; ++i)
+					{
+						table.addString(names[(i + t * 977) % NAMES]);
+					}
+				}));
+			}
+			for (S32 t = 0; t < num_threads; ++t)
+			{
+				threads[t].join();
+			}
+			F64 insert_time = timer.getElapsedTimeF64();
+			threads.clear();
+
+			timer.reset();
+			for (S32 t = 0; t < num_threads; ++t)
+			{
+				threads.push_back(std::thread([&table, &names, t, LOOKUPS, NAMES]() {
+					for (S32 i = 0; i < LOOKUPS; ++i)
+					{
+						table.checkString(names[(i * 31 + t) % NAMES]);
+					}
+				}));
+			}
+			for (S32 t = 0; t < num_threads; ++t)
+			{
+				threads[t].join();
+			}
+			F64 lookup_time = timer.getElapsedTimeF64();
+
+			ensure_equals("all names", table.getUniqueEntries(), NAMES);
+			std::cout << "\n" << num_threads << " threads: " << (S32)(num_threads * NAMES / insert_time) << " addString/s, "
+					  << (S32)(num_threads * LOOKUPS / lookup_time) << " checkString/s" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,167 @@
+/**
+ * @file llstringtable_tut.cpp
+ * @brief Tests for LLStringTable.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llstringtable.h"
+
+#include <atomic>
+#include <thread>
+
+namespace tut
+{
+	struct stringtable_test
+	{
+	};
+
+	typedef test_group<stringtable_test> stringtable_t;
+	typedef stringtable_t::object stringtable_object_t;
+	tut::stringtable_t tut_stringtable("stringtable");
+
+	template<> template<>
+	void stringtable_object_t::test<1>()
+	{
+		LLStringTable table(64);
+		ensure("NULL", table.addString((const char*)NULL) == NULL);
+		ensure("not there yet", table.checkString("foo") == NULL);
+
+		char* foo = table.addString("foo");
+		ensure_equals("contents", std::string(foo), std::string("foo"));
+		ensure("same pointer", table.addString(std::string("foo")) == foo);
+		ensure("check", table.checkString("foo") == foo);
+		ensure("entry", table.checkStringEntry("foo")->mString == foo);
+		ensure("different string", table.addString("fooo") != foo);
+		ensure("empty string", table.addString("") != NULL);
+		ensure_equals("unique", table.getUniqueEntries(), 3);
+
+		// Long strings are truncated, so they intern to the same entry.
+		std::string long_a(300, 'a');
+		std::string long_b = long_a + "b";
+		char* truncated = table.addString(long_a);
+		ensure_equals("truncated", strlen(truncated), (size_t)MAX_STRINGS_LENGTH - 1);
+		ensure("truncated equal", table.addString(long_b) == truncated);
+
+		// The entry is freed when the last reference is removed.
+		table.removeString("foo");
+		ensure_equals("still referenced", table.getUniqueEntries(), 4);
+		ensure("still there", table.checkString("foo") == foo);
+		table.removeString("foo");
+		ensure_equals("unreferenced", table.getUniqueEntries(), 3);
+		ensure("removed", table.checkString("foo") == NULL);
+		table.removeString("foo");
+		ensure_equals("extra remove ignored", table.getUniqueEntries(), 3);
+		foo = table.addString("foo");
+		ensure_equals("added again", std::string(foo), std::string("foo"));
+		ensure_equals("referenced again", table.getUniqueEntries(), 4);
+
+		// Many strings in a small table.
+		for (S32 i = 0; i < 10000; ++i)
+		{
+			table.addString(llformat("name %d", i));
+		}
+		for (S32 i = 0; i < 10000; ++i)
+		{
+			std::string name = llformat("name %d", i);
+			char* interned = table.checkString(name);
+			ensure("found", interned && name == interned);
+		}
+	}
+
+	template<> template<>
+	void stringtable_object_t::test<2>()
+	{
+		// Threads interning the same names must all get the same pointers.
+		LLStringTable table(1024);
+		const S32 NAMES = 5000;
+		const S32 THREADS = 8;
+		std::vector<std::vector<char*> > results(THREADS);
+		std::vector<std::thread> threads;
+		for (S32 t = 0; t < THREADS; ++t)
+		{
+			threads.push_back(std::thread([&table, &results, t, NAMES]() {
+				results[t].resize(NAMES);
+				for (S32 i = 0; i < NAMES; ++i)
+				{
+					// Each thread walks the names in a different order.
+					S32 n = (i * 7919 + t * 131) % NAMES;
+					results[t][n] = table.addString(llformat("concurrent %d", n));
+				}
+			}));
+		}
+		for (S32 t = 0; t < THREADS; ++t)
+		{
+			threads[t].join();
+		}
+		for (S32 i = 0; i < NAMES; ++i)
+		{
+			for (S32 t = 1; t < THREADS; ++t)
+			{
+				ensure("same entry", results[t][i] == results[0][i]);
+			}
+		}
+		ensure_equals("interned once", table.getUniqueEntries(), NAMES);
+	}
+
+	template<> template<>
+	void stringtable_object_t::test<3>()
+	{
+		// Threads adding, looking up and removing their own references to shared
+		// names: a name is there as long as somebody holds a reference, and the
+		// table is empty once all of them were removed.
+		LLStringTable table(256);
+		const S32 NAMES = 500;
+		const S32 THREADS = 8;
+		std::atomic<S32> mismatches(0);
+		std::vector<std::thread> threads;
+		for (S32 t = 0; t < THREADS; ++t)
+		{
+			threads.push_back(std::thread([&table, &mismatches, t, NAMES]() {
+				for (S32 pass = 0; pass < 10; ++pass)
+				{
+					for (S32 i = 0; i < NAMES; ++i)
+					{
+						std::string name = llformat("shared %d", (i + t * 37) % NAMES);
+						char* added = table.addString(name);
+						if (name != added || table.checkString(name) != added)
+						{
+							++mismatches;
+						}
+						table.removeString(name.c_str());
+					}
+				}
+			}));
+		}
+		for (S32 t = 0; t < THREADS; ++t)
+		{
+			threads[t].join();
+		}
+		ensure_equals("lookups found the right name", (S32)mismatches, 0);
+		ensure_equals("all removed", table.getUniqueEntries(), 0);
+		std::vector<const char*> strings;
+		table.getStrings(strings);
+		ensure("table empty", strings.empty());
+	}
+}
@@ -0,0 +1,226 @@
+/** 
+ * @file llthreadpool_tut.cpp
+ * @brief Tests for LLThreadPool.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "llthreadpool.h"
+#include "llatomic.h"
+#include "llmath.h"
+#include "llquaternion.h"
+#include "llrand.h"
+#include "v3math.h"
+
+namespace tut
+{
+	// Stand-in for the per object part of LLViewerObject::idleUpdate(): integrate
+	// rotation and position of a moving, spinning object.
+	struct SyntheticObject
+	{
+		LLVector3 mPosition;
+		LLVector3 mVelocity;
+		LLVector3 mAcceleration;
+		LLVector3 mAngularVelocity;
+		LLQuaternion mRotation;
+
+		void predict(F32 dt)
+		{
+			F32 omega = mAngularVelocity.magVec();
+			if (omega > 0.001f)
+			{
+				LLQuaternion dQ;
+				dQ.setQuat(omega * dt, mAngularVelocity * (1.f / omega));
+				mRotation = mRotation * dQ;
+			}
+			mPosition += (mVelocity + (0.5f * dt) * mAcceleration) * dt;
+			mVelocity += mAcceleration * dt;
+		}
+	};
+
+	class SyntheticIdleJob : public LLThreadPool::Job
+	{
+	public:
+		SyntheticIdleJob(std::vector<SyntheticObject>& objects, F32 dt) : mObjects(objects), mDt(dt) { }
+
+		/*virtual*/ void run(S32 begin, S32 end)
+		{
+			for (S32 i = begin; i < end; ++i)
+			{
+				mObjects[i].predict(mDt);
+			}
+		}
+
+	private:
+		std::vector<SyntheticObject>& mObjects;
+		F32 mDt;
+	};
+
+	// Runs the idle update of a frame as one phase and counts every chunk that
+	// starts before all objects finished the previous phase, or that finds an
+	// object already in a later phase.
+	class PhaseCheckJob : public SyntheticIdleJob
+	{
+	public:
+		PhaseCheckJob(std::vector<SyntheticObject>& objects, F32 dt, S32 phases)
+		:	SyntheticIdleJob(objects, dt),
+			mObjectPhases(objects.size(), -1),
+			mFinished(phases, 0),
+			mOutOfOrder(0),
+			mPhase(0)
+		{
+		}
+
+		// Between parallelFor() calls only.
+		void setPhase(S32 phase) { mPhase = phase; }
+		S32 getFinished(S32 phase) const { return mFinished[phase]; }
+		S32 getOutOfOrder() const { return mOutOfOrder; }
+
+		/*virtual*/ void run(S32 begin, S32 end)
+		{
+			if (mPhase > 0 && mFinished[mPhase - 1] != (S32)mObjectPhases.size())
+			{
+				mOutOfOrder++;
+			}
+			// Give the other threads a chance to get ahead, also on a single core.
+			LLThread::yield();
+			for (S32 i = begin; i < end; ++i)
+			{
+				if (mObjectPhases[i] != mPhase - 1)
+				{
+					mOutOfOrder++;
+				}
+				mObjectPhases[i] = mPhase;
+			}
+			SyntheticIdleJob::run(begin, end);
+			mFinished[mPhase] += end - begin;
+		}
+
+	private:
+		std::vector<S32> mObjectPhases;
+		std::vector<LLAtomicS32> mFinished;		// Objects done, per phase.
+		LLAtomicS32 mOutOfOrder;
+		S32 mPhase;
+	};
+
+	class CountJob : public LLThreadPool::Job
+	{
+	public:
+		CountJob(std::vector<S32>& hits) : mHits(hits) { }
+
+		/*virtual*/ void run(S32 begin, S32 end)
+		{
+			for (S32 i = begin; i < end; ++i)
+			{
+				++mHits[i];
+			}
+		}
+
+	private:
+		std::vector<S32>& mHits;
+	};
+
+	struct threadpool_test
+	{
+	};
+	typedef test_group<threadpool_test> threadpool_t;
+	typedef threadpool_t::object threadpool_object_t;
+	tut::threadpool_t tut_threadpool("threadpool");
+
+	// Every item is visited exactly once, for any chunk size, also when reusing the pool.
+	template<> template<>
+	void threadpool_object_t::test<1>()
+	{
+		LLThreadPool pool("Test Pool", 3);
+		ensure_equals("thread count", pool.getNumThreads(), 3);
+
+		const S32 chunk_sizes[] = { 1, 7, 64, 1000, 5000 };
+		for (U32 c = 0; c < LL_ARRAY_SIZE(chunk_sizes); ++c)
+		{
+			std::vector<S32> hits(1000, 0);
+			CountJob job(hits);
+			pool.parallelFor(job, (S32)hits.size(), chunk_sizes[c]);
+			for (U32 i = 0; i < hits.size(); ++i)
+			{
+				ensure_equals("visited once", hits[i], 1);
+			}
+		}
+	}
+
+	// A pool without threads runs the job on the caller.
+	template<> template<>
+	void threadpool_object_t::test<2>()
+	{
+		LLThreadPool pool("Test Pool", 0);
+		std::vector<S32> hits(100, 0);
+		CountJob job(hits);
+		pool.parallelFor(job, (S32)hits.size(), 10);
+		ensure_equals("first", hits[0], 1);
+		ensure_equals("last", hits[99], 1);
+	}
+
+	// Idle updates of many objects give the same results pooled as serial, and
+	// no object starts a frame before all objects finished the one before.
+	template<> template<>
+	void threadpool_object_t::test<3>()
+	{
+		const S32 OBJECT_COUNT = 2000;
+		const S32 FRAMES = 10;
+		const F32 DT = 1.f / 45.f;
+
+		std::vector<SyntheticObject> serial(OBJECT_COUNT);
+		for (S32 i = 0; i < OBJECT_COUNT; ++i)
+		{
+			SyntheticObject& object = serial[i];
+			object.mPosition.set(ll_frand(256.f), ll_frand(256.f), ll_frand(100.f));
+			object.mVelocity.set(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, 0.f);
+			object.mAcceleration.set(0.f, 0.f, -9.8f * (i & 1));
+			object.mAngularVelocity.set(0.f, 0.f, ll_frand(3.f));
+		}
+		std::vector<SyntheticObject> pooled(serial);
+
+		SyntheticIdleJob serial_job(serial, DT);
+		for (S32 frame = 0; frame < FRAMES; ++frame)
+		{
+			serial_job.run(0, OBJECT_COUNT);
+		}
+
+		// Threads even on a single core, so the chunks of a phase really interleave.
+		LLThreadPool pool("Test Pool", 3);
+		PhaseCheckJob pooled_job(pooled, DT, FRAMES);
+		for (S32 frame = 0; frame < FRAMES; ++frame)
+		{
+			pooled_job.setPhase(frame);
+			pool.parallelFor(pooled_job, OBJECT_COUNT, 16);
+			ensure_equals("phase finished on return", pooled_job.getFinished(frame), OBJECT_COUNT);
+		}
+		ensure_equals("phases in order", pooled_job.getOutOfOrder(), 0);
+
+		for (S32 i = 0; i < OBJECT_COUNT; ++i)
+		{
+			ensure("same position", serial[i].mPosition == pooled[i].mPosition);
+			ensure("same rotation", serial[i].mRotation == pooled[i].mRotation);
+		}
+	}
+}
@@ -0,0 +1,124 @@
+/**
+ * @file lluuidflatmap_benchmark.cpp
+ * @brief Benchmarks for LLUUID string conversion and LLUUIDFlatMap.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lluuidflatmap.h"
+#include "llrand.h"
+#include "lltimer.h"
+
+#include <boost/unordered_map.hpp>
+#include <iostream>
+
+namespace tut
+{
+	static LLUUID random_uuid()
+	{
+		LLUUID id;
+		for (S32 i = 0; i < UUID_BYTES; ++i)
+		{
+			id.mData[i] = (U8)ll_rand(256);
+		}
+		return id;
+	}
+
+	struct uuidflatmap_benchmark
+	{
+	};
+
+	typedef test_group<uuidflatmap_benchmark> uuidflatmap_benchmark_t;
+	typedef uuidflatmap_benchmark_t::object uuidflatmap_benchmark_object_t;
+	tut::uuidflatmap_benchmark_t tut_uuidflatmap_benchmark("uuidflatmap_benchmark");
+
+	template<> template<>
+	void uuidflatmap_benchmark_object_t::test<1>()
+	{
+		// Parsing and formatting, then inserts and finds against boost::unordered_map.
+		const S32 count = 200000;
+		std::vector<LLUUID> ids;
+		std::vector<std::string> strings;
+		for (S32 i = 0; i < count; ++i)
+		{
+			ids.push_back(random_uuid());
+			strings.push_back(ids.back().asString());
+		}
+
+		LLTimer timer;
+		LLUUID parsed;
+		for (S32 i = 0; i < count; ++i)
+		{
+			parsed.set(strings[i]);
+		}
+		F64 parse_time = timer.getElapsedTimeF64();
+		timer.reset();
+		std::string formatted;
+		for (S32 i = 0; i < count; ++i)
+		{
+			ids[i].toString(formatted);
+		}
+		F64 format_time = timer.getElapsedTimeF64();
+
+		boost::unordered_map<LLUUID, S32> boost_map;
+		LLUUIDFlatMap<S32> flat_map;
+		timer.reset();
+		for (S32 i = 0; i < count; ++i)
+		{
+			boost_map[ids[i]] = i;
+		}
+		F64 boost_insert = timer.getElapsedTimeF64();
+		timer.reset();
+		for (S32 i = 0; i < count; ++i)
+		{
+			flat_map[ids[i]] = i;
+		}
+		F64 flat_insert = timer.getElapsedTimeF64();
+
+		S64 boost_sum = 0, flat_sum = 0;
+		timer.reset();
+		for (S32 pass = 0; pass < 5; ++pass)
+		{
+			for (S32 i = 0; i < count; ++i)
+			{
+				boost_sum += boost_map.find(ids[i])->second;
+			}
+		}
+		F64 boost_find = timer.getElapsedTimeF64();
+		timer.reset();
+		for (S32 pass = 0; pass < 5; ++pass)
+		{
+			for (S32 i = 0; i < count; ++i)
+			{
+				flat_sum += flat_map.find(ids[i])->second;
+			}
+		}
+		F64 flat_find = timer.getElapsedTimeF64();
+		ensure_equals("same lookups", flat_sum, boost_sum);
+
+		std::cout << "\n" << count << " UUIDs: parse " << parse_time * 1000 << " ms, format " << format_time * 1000 << " ms."
+				  << "\nInsert: boost::unordered_map " << boost_insert * 1000 << " ms, LLUUIDFlatMap " << flat_insert * 1000 << " ms."
+				  << "\n" << count * 5 << " finds: boost::unordered_map " << boost_find * 1000 << " ms, LLUUIDFlatMap " << flat_find * 1000 << " ms." << std::endl;
+	}
+}
@@ -0,0 +1,160 @@
+/**
+ * @file lluuidflatmap_tut.cpp
+ * @brief Tests for LLUUID string conversion and LLUUIDFlatMap.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2010, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lluuidflatmap.h"
+#include "llrand.h"
+
+#include <boost/unordered_map.hpp>
+#include <map>
+
+namespace tut
+{
+	static LLUUID random_uuid()
+	{
+		LLUUID id;
+		for (S32 i = 0; i < UUID_BYTES; ++i)
+		{
+			id.mData[i] = (U8)ll_rand(256);
+		}
+		return id;
+	}
+
+	struct uuidflatmap_test
+	{
+	};
+
+	typedef test_group<uuidflatmap_test> uuidflatmap_t;
+	typedef uuidflatmap_t::object uuidflatmap_object_t;
+	tut::uuidflatmap_t tut_uuidflatmap("uuidflatmap");
+
+	template<> template<>
+	void uuidflatmap_object_t::test<1>()
+	{
+		// String conversion.
+		LLUUID id("0123abcd-EF45-6789-aBcD-ef0123456789");
+		ensure_equals("format", id.asString(), std::string("0123abcd-ef45-6789-abcd-ef0123456789"));
+		char buffer[UUID_STR_SIZE];
+		id.toString(buffer);
+		ensure_equals("format to buffer", std::string(buffer), id.asString());
+
+		ensure("validate", LLUUID::validate("0123abcd-EF45-6789-aBcD-ef0123456789"));
+		ensure("validate bad char", !LLUUID::validate("0123abcd-EF45-6789-aBcD-ef012345678g"));
+		ensure("validate bad length", !LLUUID::validate("0123abcd-EF45-6789-aBcD-ef012345678"));
+
+		LLUUID bad;
+		ensure("bad char", !bad.set("0123abcd-EF45-6789-aBcD-ef01234567:9", FALSE));
+		ensure("bad char gives null", bad.isNull());
+		ensure("non ascii", !bad.set("0123abcd-EF45-6789-aBcD-ef01234567\xe99", FALSE));
+
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			LLUUID original = random_uuid();
+			ensure_equals("round trip", LLUUID(original.asString()), original);
+		}
+	}
+
+	template<> template<>
+	void uuidflatmap_object_t::test<2>()
+	{
+		// Random inserts, erases and finds give the same results as std::map.
+		std::vector<LLUUID> keys;
+		for (S32 i = 0; i < 1000; ++i)
+		{
+			keys.push_back(random_uuid());
+		}
+		keys.push_back(LLUUID::null);
+
+		LLUUIDFlatMap<S32> map;
+		std::map<LLUUID, S32> reference;
+		for (S32 i = 0; i < 200000; ++i)
+		{
+			const LLUUID& key = keys[ll_rand(keys.size())];
+			switch (ll_rand(3))
+			{
+				case 0:
+					map[key] = i;
+					reference[key] = i;
+					break;
+				case 1:
+					ensure_equals("erase", map.erase(key), reference.erase(key));
+					break;
+				default:
+				{
+					LLUUIDFlatMap<S32>::const_iterator iter = map.find(key);
+					std::map<LLUUID, S32>::const_iterator ref_iter = reference.find(key);
+					ensure_equals("found", iter != map.end(), ref_iter != reference.end());
+					if (iter != map.end())
+					{
+						ensure_equals("value", iter->second, ref_iter->second);
+					}
+				}
+			}
+			ensure_equals("size", map.size(), reference.size());
+		}
+
+		size_t count = 0;
+		for (LLUUIDFlatMap<S32>::iterator iter = map.begin(); iter != map.end(); ++iter, ++count)
+		{
+			ensure_equals("iterated value", iter->second, reference[iter->first]);
+		}
+		ensure_equals("iterated count", count, reference.size());
+
+		map.clear();
+		ensure("cleared", map.empty() && map.find(keys[0]) == map.end());
+	}
+
+	template<> template<>
+	void uuidflatmap_object_t::test<3>()
+	{
+		// Many random UUIDs: string round trips, and the same lookups as boost::unordered_map.
+		const S32 count = 20000;
+		std::vector<LLUUID> ids;
+		boost::unordered_map<LLUUID, S32> boost_map;
+		LLUUIDFlatMap<S32> flat_map;
+		std::string formatted;
+		LLUUID parsed;
+		for (S32 i = 0; i < count; ++i)
+		{
+			ids.push_back(random_uuid());
+			ids.back().toString(formatted);
+			ensure("parses", parsed.set(formatted));
+			ensure_equals("round trip", parsed, ids.back());
+			boost_map[ids.back()] = i;
+			flat_map[ids.back()] = i;
+		}
+		ensure_equals("size", flat_map.size(), boost_map.size());
+
+		S64 boost_sum = 0, flat_sum = 0;
+		for (S32 i = 0; i < count; ++i)
+		{
+			boost_sum += boost_map.find(ids[i])->second;
+			flat_sum += flat_map.find(ids[i])->second;
+		}
+		ensure_equals("same lookups", flat_sum, boost_sum);
+	}
+}